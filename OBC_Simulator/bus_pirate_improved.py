@@ -19,6 +19,87 @@ def signal_handler_SIGINT(sig, frame):
 signal.signal(signal.SIGINT, signal_handler_SIGINT)
 
 
+def obc_crc(data):
+    # CRC-16/CCITT-FALSE
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if (crc & 0x8000) else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def obc_frame(payload):
+    # COBS encoding of the payload and its CRC (MSB first), then a 0x00
+    crc = obc_crc(payload)
+    data = bytes(payload) + bytes([crc >> 8, crc & 0xFF])
+    frame = bytearray()
+    block = bytearray()
+    for i, byte in enumerate(data):
+        if byte == 0:
+            frame += bytes([len(block) + 1]) + block
+            block = bytearray()
+            continue
+        block.append(byte)
+        if len(block) == 254 and i + 1 < len(data):
+            frame += bytes([255]) + block
+            block = bytearray()
+    frame += bytes([len(block) + 1]) + block
+    frame.append(0)
+    return bytes(frame)
+
+
+def obc_unframe(frame):
+    # COBS decoding of a frame up to its 0x00, None if the CRC is wrong
+    data = bytearray()
+    i = 0
+    while i < len(frame) and frame[i] != 0:
+        code = frame[i]
+        data += frame[i + 1:i + code]
+        i += code
+        if code < 255 and i < len(frame) and frame[i] != 0:
+            data.append(0)
+    if len(data) < 2 or obc_crc(data[:-2]) != (data[-2] << 8 | data[-1]):
+        return None
+    return bytes(data[:-2])
+
+
+class ObcUart():
+    # The OBC link through a plain serial port: a usb uart wired to the
+    # board, or the pseudo terminal of the native build
+    # (ADCS_OBC_PTY=/tmp/adcs_obc ./adcs_executable)
+
+    def __init__(self, chardev, baudrate = 9600, timeout = 1.0):
+        self.port = serial.Serial(chardev, baudrate = baudrate, timeout = timeout)
+        assert(self.port.isOpen())
+
+    def __del__(self):
+        if self.port.isOpen():
+            self.port.close()
+
+    def start_stream(self):
+        pass
+
+    def transmit(self, string):
+        print("[TX]: >>>" + string + "<<<")
+        self.port.write(obc_frame(bytes(string, 'ascii')))
+        self.receive()
+
+    def receive(self):
+        frame = self.port.read_until(b'\x00')
+        if frame == b'':
+            print("[RX]: >>>NONE<<<")
+            return None
+        payload = obc_unframe(frame)
+        if payload is None:
+            print("[RX]: BAD FRAME")
+        else:
+            print("[RX]: >>>" + payload.decode('ascii', 'replace') + "<<<")
+        print("")
+        return payload
+
+
 class ObcBusPirate():
 
     def __init__(self, chardev = "/dev/ttyUSB0", usb_baud = 115200):
@@ -114,36 +195,28 @@ class ObcBusPirateUart(ObcBusPirate):
         self.write("}")
 
 
-    def __transmit_string(self, string, delim):
+    def __transmit_string(self, string):
         pass
         print("[TX]: >>>" + string + "<<<")
-        delimited_string = str(string)
-        if delim not in delimited_string:
-            delimited_string = delimited_string + delim
-        
-        # bus pirate firmware does not deal with escaped double quotes
-        # so we have to bastardize our string
-        delimited_string = delimited_string.replace("\"", "\'")
-
-        # wrap payload in double quotes so bus pirate knows to flush entire str
-        payload_string = "\"" + delimited_string + "\""
 
-        # transmit string
-        self.write(payload_string)
+        # send the frame as bus pirate byte values so the quotes and any
+        # other byte go through as they are
+        frame = obc_frame(bytes(string, 'ascii'))
+        self.write(" ".join("0x%02x" % byte for byte in frame))
 
 
-    def __transmit_int(self, int, delim):
+    def __transmit_int(self, int):
         pass
         raise NotImplementedError
 
 
-    def transmit(self, data, delim = '!'):
+    def transmit(self, data):
         pass
         data_type = str(type(data))
         if data_type == "<class 'str'>":
-            self.__transmit_string(data, delim = delim)
+            self.__transmit_string(data)
         elif data_type == "<class 'int'>":
-            self.__transmit_int(data, delim = delim)
+            self.__transmit_int(data)
         else:
             raise NotImplementedError
         
@@ -169,7 +242,7 @@ class ObcBusPirateUart(ObcBusPirate):
             print("[RX]: >>>NONE<<<")
 
 
-def process_json_commands(filepath):
+def process_json_commands(filepath, chardev = None, baudrate = 9600):
     with open(filepath) as f:
         try:
             jsons = json.load(f)
@@ -188,7 +261,10 @@ def process_json_commands(filepath):
             return
         else:
 
-            uart = ObcBusPirateUart()
+            if chardev is None:
+                uart = ObcBusPirateUart()
+            else:
+                uart = ObcUart(chardev, baudrate)
             uart.start_stream()
             time.sleep(0.5)
 
@@ -198,10 +274,23 @@ def process_json_commands(filepath):
 
 
 if __name__ == "__main__":
-    argc = len(sys.argv)
-    if argc > 1:
-        for i in range(1, argc):
-            process_json_commands(sys.argv[i])
+    # --port DEV sends through a serial port instead of the bus pirate,
+    # --baud N sets its line rate
+    chardev = None
+    baudrate = 9600
+    filepaths = list()
+    args = iter(sys.argv[1:])
+    for arg in args:
+        if arg == "--port":
+            chardev = next(args)
+        elif arg == "--baud":
+            baudrate = int(next(args))
+        else:
+            filepaths.append(arg)
+
+    if filepaths != []:
+        for filepath in filepaths:
+            process_json_commands(filepath, chardev, baudrate)
     else:
         json_filepath = input("Enter the path to the json file with OBC commands: ")
-        process_json_commands(json_filepath)
\ No newline at end of file
+        process_json_commands(json_filepath, chardev, baudrate)
\ No newline at end of file
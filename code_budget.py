@@ -0,0 +1,350 @@
+#!/usr/bin/python3
+################################################################################
+# @brief Code size of each library of the ADCS firmware, from the map file
+# @author: Carl Mattatall (cmattatall2@gmail.com)
+#
+# Reads the map file the linker writes when the build is configured with
+# -DCODE_BUDGET=ON and attributes every input section it placed to the
+# library its object came from:
+#   libADCS_JSONS.static(jsons.c.obj)                  ADCS_JSONS
+#   CMakeFiles/adcs_executable.dir/main.c.obj          adcs_executable
+#   .../libc.a(lib_a-vfprintf.o)                       libc (groups of config)
+# The output section an input section went to decides whether it counts as
+# text (code and constants), data or bss. Flash holds text and data, RAM
+# data and bss.
+#
+# The budgets of the config are the most text, data and bss a module may
+# take. The pull-ins of the config are the library code worth knowing about,
+# float printf and the like: they are reported with the chain of references
+# that brought them in, from the "Archive member included" table of the map.
+#
+# The report is JSON with sorted keys so it can be diffed between builds. The
+# script exits with 1 when a module is over its budget, a memory region has
+# less than its minimum headroom left or a pull-in marked fail is linked.
+################################################################################
+import os
+import re
+import sys
+import json
+import fnmatch
+import argparse
+
+CATEGORIES = ["text", "data", "bss"]
+
+MEMBER_RE = re.compile(r"^(\S+\(\S+\))\s*$")
+REFERENCE_RE = re.compile(r"^\s+(\S+) \((\S+)\)\s*$")
+REGION_RE = re.compile(r"^(\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)")
+OUTPUT_RE = re.compile(r"^([._A-Za-z]\S*)(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)(?:\s+load address 0x([0-9a-fA-F]+))?)?\s*$")
+ADDRESS_RE = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)(?:\s+load address 0x([0-9a-fA-F]+))?\s*$")
+INPUT_RE = re.compile(r"^ (\S+)(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*?))?\s*$")
+INPUT_CONT_RE = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*?)\s*$")
+SYMBOL_RE = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+([A-Za-z_.$][\w.$]*)\s*$")
+ARCHIVE_RE = re.compile(r"^(.*)\((.+)\)$")
+CMAKE_TARGET_RE = re.compile(r"CMakeFiles/([^/]+)\.dir/")
+
+# What is left of an input section name once its kind is stripped is the
+# name of the function or variable (-ffunction-sections -fdata-sections)
+SECTION_PREFIX_RE = re.compile(
+    r"^\.(?:lower\.|upper\.|either\.)?(?:text|rodata|data|bss|noinit|persistent)"
+    r"(?:\.startup|\.unlikely|\.hot|\.rel\.ro|\.rel\.ro\.local)?\.")
+ANONYMOUS_RE = re.compile(r"^(?:str\d|cst\d)")
+
+
+class Section:
+    def __init__(self, name, output, category, addr, size, source):
+        self.name = name
+        self.output = output
+        self.category = category
+        self.addr = addr
+        self.size = size
+        self.source = source
+        self.symbol = None
+
+
+def checkPythonVersion():
+    if sys.version_info.major < 3:
+        raise Exception(os.path.basename(__file__) + " must be executed using Python 3")
+
+
+def matches(name, patterns):
+    return any(fnmatch.fnmatchcase(name, p) for p in patterns)
+
+
+def category_of(output, config):
+    for category in CATEGORIES:
+        if matches(output, config.get("sections", {}).get(category, [])):
+            return category
+    return None
+
+
+def raw_module(source):
+    # The library an object file came from, without lib and the suffix
+    m = ARCHIVE_RE.match(source)
+    if m:
+        name = os.path.splitext(os.path.basename(m.group(1)))[0]
+        return name[3:] if name.startswith("lib") else name, m.group(2)
+    m = CMAKE_TARGET_RE.search(source)
+    if m:
+        return m.group(1), os.path.basename(source)
+    return os.path.basename(source), os.path.basename(source)
+
+
+def module_of(source, config):
+    raw, obj = raw_module(source)
+    for group, patterns in sorted(config.get("groups", {}).items()):
+        if matches(raw, patterns):
+            return group, obj
+    return raw, obj
+
+
+def parse_map(path, config):
+    members = {}
+    regions = {}
+    sections = []
+    outputs = []
+    with open(path) as f:
+        lines = f.read().splitlines()
+
+    part = None
+    member = None
+    output = None
+    pending = None
+    for line in lines:
+        if line.startswith("Archive member included"):
+            part = "members"
+            continue
+        if line.startswith("Discarded input sections") or line.startswith("Allocating common symbols"):
+            part = None
+            continue
+        if line.startswith("Memory Configuration"):
+            part = "regions"
+            continue
+        if line.startswith("Linker script and memory map"):
+            part = "map"
+            continue
+
+        if part == "members":
+            m = MEMBER_RE.match(line)
+            if m:
+                member = m.group(1)
+                continue
+            m = REFERENCE_RE.match(line)
+            if m and member is not None:
+                members[member] = (m.group(1), m.group(2))
+                member = None
+        elif part == "regions":
+            m = REGION_RE.match(line)
+            if m and m.group(1) not in ("Name", "*default*"):
+                regions[m.group(1)] = (int(m.group(2), 16), int(m.group(3), 16))
+        elif part == "map":
+            if pending is not None:
+                # Long names go on a line of their own
+                kind, name = pending
+                pending = None
+                if kind == "output":
+                    m = ADDRESS_RE.match(line)
+                    if m:
+                        output = (name, int(m.group(1), 16), int(m.group(2), 16),
+                                  int(m.group(3), 16) if m.group(3) else None)
+                        outputs.append(output)
+                        continue
+                    output = (name, 0, 0, None)  # empty
+                else:
+                    m = INPUT_CONT_RE.match(line)
+                    if m:
+                        add_section(sections, name, output, m.group(1), m.group(2), m.group(3), config)
+                        continue
+            if not line.strip():
+                continue
+            if not line[0].isspace():
+                m = OUTPUT_RE.match(line)
+                if m:
+                    if m.group(2) is None:
+                        pending = ("output", m.group(1))
+                    else:
+                        output = (m.group(1), int(m.group(2), 16), int(m.group(3), 16),
+                                  int(m.group(4), 16) if m.group(4) else None)
+                        outputs.append(output)
+                continue
+            if line.startswith(" *") or line.startswith("  "):
+                m = SYMBOL_RE.match(line)
+                if m and sections and output is not None and sections[-1].output == output[0]:
+                    last = sections[-1]
+                    if last.symbol is None and int(m.group(1), 16) == last.addr:
+                        last.symbol = m.group(2)
+                continue
+            m = INPUT_RE.match(line)
+            if m:
+                if m.group(2) is None:
+                    pending = ("input", m.group(1))
+                else:
+                    add_section(sections, m.group(1), output, m.group(2), m.group(3), m.group(4), config)
+    return members, regions, sections, outputs
+
+
+def add_section(sections, name, output, addr, size, source, config):
+    size = int(size, 16)
+    if output is None or size == 0 or source.startswith("linker stubs"):
+        return
+    category = category_of(output[0], config)
+    if category is not None:
+        sections.append(Section(name, output[0], category, int(addr, 16), size, source))
+
+
+def symbol_name(section, module, obj):
+    if section.symbol is not None:
+        return section.symbol
+    name = SECTION_PREFIX_RE.sub("", section.name)
+    if name != section.name and not ANONYMOUS_RE.match(name):
+        return name
+    return "%s(%s)%s" % (module, obj, section.name)
+
+
+def region_use(regions, outputs, config):
+    use = dict((name, 0) for name in regions)
+    for name, addr, size, load in outputs:
+        if size == 0 or category_of(name, config) is None:
+            continue
+        for at in set([addr] + ([load] if load is not None else [])):
+            for region, (origin, length) in regions.items():
+                if origin <= at < origin + length:
+                    use[region] += size
+    report = {}
+    for region, (origin, length) in sorted(regions.items()):
+        report[region] = {
+            "origin": origin,
+            "length": length,
+            "used": use[region],
+            "headroom": length - use[region],
+        }
+    return report
+
+
+def reference_chain(members, member, config):
+    # Who brought the member in, and who brought that one in, up to an
+    # object that was linked on its own
+    chain = []
+    seen = set()
+    while member in members and member not in seen:
+        seen.add(member)
+        referrer, symbol = members[member]
+        module, obj = module_of(referrer, config)
+        chain.append("%s(%s) %s" % (module, obj, symbol))
+        member = referrer
+    return chain
+
+
+def main():
+    checkPythonVersion()
+
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--map", action="store", dest="map", required=True, help="Map file of the linked executable.")
+    parser.add_argument("--config", action="store", dest="config", required=True, help="Sections, library groups, module budgets and the pull-ins to flag.")
+    parser.add_argument("--output", action="store", dest="output", required=True, help="Where to write the JSON report.")
+    args = parser.parse_args()
+
+    with open(args.config) as f:
+        config = json.load(f)
+
+    members, regions, sections, outputs = parse_map(args.map, config)
+    if not sections:
+        print("No sections in %s, configure with -DCODE_BUDGET=ON" % (args.map))
+        exit(1)
+
+    modules = {}
+    symbols = []
+    for section in sections:
+        module, obj = module_of(section.source, config)
+        entry = modules.setdefault(module, dict((c, 0) for c in CATEGORIES))
+        entry[section.category] += section.size
+        symbols.append({
+            "name": symbol_name(section, module, obj),
+            "module": module,
+            "object": obj,
+            "section": section.category,
+            "size": section.size,
+        })
+    for entry in modules.values():
+        entry["flash"] = entry["text"] + entry["data"]
+        entry["ram"] = entry["data"] + entry["bss"]
+
+    errors = []
+    warnings = []
+    budgets = config.get("budgets", {})
+    for module, entry in sorted(modules.items()):
+        budget = budgets.get(module)
+        if budget is None:
+            if matches(module, config.get("require_budget", [])):
+                warnings.append("%s has no budget" % (module))
+            continue
+        entry["budget"] = budget
+        for category in CATEGORIES:
+            if category in budget and entry[category] > budget[category]:
+                errors.append("%s %s is %d B, over its budget of %d B"
+                              % (module, category, entry[category], budget[category]))
+
+    report_regions = region_use(regions, outputs, config)
+    for region, minimum in sorted(config.get("region_headroom_min", {}).items()):
+        if region in report_regions and report_regions[region]["headroom"] < minimum:
+            errors.append("%s headroom %d B is under %d B" % (region, report_regions[region]["headroom"], minimum))
+
+    pullins = {}
+    for name, pullin in sorted(config.get("pullins", {}).items()):
+        patterns = pullin.get("match", [])
+        hit = [s for s in symbols if matches(s["name"], patterns)
+               or matches("%s(%s)" % (s["module"], s["object"]), patterns)]
+        if not hit:
+            continue
+        objects = sorted(set((s["module"], s["object"]) for s in hit))
+        by = {}
+        for source in members:
+            module, obj = module_of(source, config)
+            if (module, obj) in objects:
+                by["%s(%s)" % (module, obj)] = reference_chain(members, source, config)
+        pullins[name] = {
+            "size": sum(s["size"] for s in hit),
+            "symbols": sorted(set(s["name"] for s in hit)),
+            "by": by,
+            "fail": pullin.get("fail", False),
+        }
+        if pullins[name]["fail"]:
+            errors.append("%s is linked in (%d B)" % (name, pullins[name]["size"]))
+
+    top = config.get("top", 20)
+    report = {
+        "map": os.path.basename(args.map),
+        "modules": modules,
+        "regions": report_regions,
+        "symbols": sorted(symbols, key=lambda s: (-s["size"], s["name"]))[:top],
+        "pullins": pullins,
+        "warnings": warnings,
+        "pass": not errors,
+        "errors": errors,
+    }
+    with open(args.output, "w") as f:
+        json.dump(report, f, indent=2, sort_keys=True)
+        f.write("\n")
+
+    print("%-28s %8s %8s %8s %8s" % ("module", "text", "data", "bss", "flash"))
+    for module, entry in sorted(modules.items(), key=lambda m: (-m[1]["flash"], m[0])):
+        print("%-28s %8d %8d %8d %8d" % (module, entry["text"], entry["data"], entry["bss"], entry["flash"]))
+    for region, use in sorted(report_regions.items()):
+        if use["used"]:
+            print("%s %d of %d B used, %d B headroom" % (region, use["used"], use["length"], use["headroom"]))
+    print("largest symbols:")
+    for s in report["symbols"]:
+        print("    %6d B %-4s %-36s %s" % (s["size"], s["section"], s["name"], s["module"]))
+    for name, pullin in sorted(pullins.items()):
+        print("warning: %s pulled in, %d B" % (name, pullin["size"]))
+        for member, chain in sorted(pullin["by"].items()):
+            print("    %s <- %s" % (member, " <- ".join(chain)))
+    for warning in warnings:
+        print("warning: " + warning)
+    for error in errors:
+        print("error: " + error)
+    print("report written to %s" % (args.output))
+    exit(1 if errors else 0)
+
+
+if __name__ == "__main__":
+    main()
@@ -27,7 +27,7 @@ def space_args(string):
     return " " + str(string) + " "
 
 
-def configure(source_dir=".", bdir="build", btype="Debug", cross_compile=False, build_tests=False, verbose=False, build_examples=False, analyze=False):
+def configure(source_dir=".", bdir="build", btype="Debug", cross_compile=False, build_tests=False, verbose=False, build_examples=False, analyze=False, profile=False, memory_budget=False, code_budget=False, iss_markers=False):
 
     configure_string = space_args("cmake")
 
@@ -69,6 +69,26 @@ def configure(source_dir=".", bdir="build", btype="Debug", cross_compile=False,
     else:
         configure_string += space_args("-DANALYZE:BOOL=OFF")
 
+    if profile:
+        configure_string += space_args("-DPROFILING:BOOL=ON")
+    else:
+        configure_string += space_args("-DPROFILING:BOOL=OFF")
+
+    if memory_budget:
+        configure_string += space_args("-DMEMORY_BUDGET:BOOL=ON")
+    else:
+        configure_string += space_args("-DMEMORY_BUDGET:BOOL=OFF")
+
+    if code_budget:
+        configure_string += space_args("-DCODE_BUDGET:BOOL=ON")
+    else:
+        configure_string += space_args("-DCODE_BUDGET:BOOL=OFF")
+
+    if iss_markers:
+        configure_string += space_args("-DISS_MARKERS:BOOL=ON")
+    else:
+        configure_string += space_args("-DISS_MARKERS:BOOL=OFF")
+
     return os.system(configure_string)
 
 def make(bdir):
@@ -105,6 +125,10 @@ def main():
     parser.add_argument("--verbose", action="store_true", default=False, dest="verbose", help="Option to emit verbose information during generation.")
     parser.add_argument("--build-examples", action="store_true", default=False, dest="build_examples", help="Build the usage and API examples.")
     parser.add_argument("--analyze", action="store_true", default=False, dest="analyze", help="Run static analysis after the generation step.")
+    parser.add_argument("--profile", action="store_true", default=False, dest="profile", help="Build the execution time probes in, read back with {\"prof\":\"read\"}.")
+    parser.add_argument("--memory-budget", action="store_true", default=False, dest="memory_budget", help="Report the worst case stack and RAM headroom, fail the build when over budget.")
+    parser.add_argument("--code-budget", action="store_true", default=False, dest="code_budget", help="Report the code size of each library from the map file of the cross compiled firmware, fail the build when over budget.")
+    parser.add_argument("--iss-markers", action="store_true", default=False, dest="iss_markers", help="Cross compile the marks iss_bench.py counts simulated cycles between, in place of the execution time probes.")
     args=parser.parse_args()
 
     if args.run_tests and not args.make_tests:
@@ -131,7 +155,7 @@ def main():
                         print("COULD NOT CREATE DIRECTORY %s" % (args.bdir))
                     exit(1)
 
-    if 0 != configure(source_dir=args.source_dir, bdir=args.bdir,cross_compile=args.cross, btype=args.btype, build_tests=args.make_tests, verbose=args.verbose, build_examples=args.build_examples, analyze=args.analyze):
+    if 0 != configure(source_dir=args.source_dir, bdir=args.bdir,cross_compile=args.cross, btype=args.btype, build_tests=args.make_tests, verbose=args.verbose, build_examples=args.build_examples, analyze=args.analyze, profile=args.profile, memory_budget=args.memory_budget, code_budget=args.code_budget, iss_markers=args.iss_markers):
         if args.verbose:
             print("\nError configuring project!\n")
         exit(-1)
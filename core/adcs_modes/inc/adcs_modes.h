@@ -0,0 +1,255 @@
+/**
+ * @file adcs_modes.h
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief ADCS operating mode manager
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ * @note Each mode has entry and exit actions and a scheduling profile that
+ * selects which sensors are sampled (and how often) and whether the attitude
+ * control loop runs. Transitions are either commanded by the OBC or taken
+ * autonomously when a guard on body rate, sun visibility or stored wheel
+ * momentum is satisfied.
+ *
+ *  IDLE, BURNWIRE : commanded transitions only
+ *
+ *  DETUMBLE -> POINTING : rate below exit threshold for a while, sunlit
+ *  DETUMBLE -> ECLIPSE  : rate below exit threshold for a while, dark
+ *  POINTING -> DETUMBLE : rate above entry threshold
+ *  POINTING -> ECLIPSE  : dark and wheel momentum below the low threshold
+ *  ECLIPSE  -> DETUMBLE : rate above entry threshold
+ *  ECLIPSE  -> POINTING : sunlit, or wheel momentum above the dump threshold
+ */
+#ifndef __ADCS_MODES_H__
+#define __ADCS_MODES_H__
+#ifdef __cplusplus
+/* clang-format off */
+extern "C"
+{
+/* clang-format on */
+#endif /* Start C linkage */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "attitude_types.h"
+#include "json_writer.h"
+
+typedef enum
+{
+    ADCS_MODE_idle,
+    ADCS_MODE_burnwire,
+    ADCS_MODE_detumble,
+    ADCS_MODE_pointing,
+    ADCS_MODE_eclipse,
+    ADCS_MODE_cnt, /* must be last */
+} ADCS_MODE_t;
+
+/* Mode entered by MODE_init */
+#define ADCS_MODE_BOOT (ADCS_MODE_idle)
+
+typedef struct
+{
+    uint16_t imu_period_ms;    /* 0 == IMU not sampled */
+    uint16_t magtom_period_ms; /* 0 == magnetometer not sampled. With the
+                                * control loop the magnetometer is sampled
+                                * in the quiet window of every period */
+    uint16_t sunsen_period_ms; /* 0 == sun sensors not sampled */
+    bool     control_loop;     /* attitude control loop runs */
+} ADCS_MODE_profile_t;
+
+typedef struct
+{
+    uint32_t cycles;         /* control periods with a torque window */
+    uint32_t captures;       /* magnetometer samples taken in quiet windows */
+    uint32_t missed;         /* quiet windows that closed without a sample */
+    uint32_t saturated;      /* periods where the compensation was clipped */
+    uint16_t period_ms;      /* control period, 0 == not duty cycling */
+    uint16_t quiet_ms;       /* torquers off at the end of every period */
+    uint16_t capture_ms_min; /* from torquers off to the sample */
+    uint16_t capture_ms_max;
+    float    duty_loss;     /* fraction of the period the torquers are off */
+    float    gain;          /* dipole gain that compensates the duty loss */
+    float    residual_loss; /* part of the last dipole command not delivered */
+} ADCS_MODE_mag_duty_stats_t;
+
+typedef struct
+{
+    float rate_radps;     /* magnitude of the body rate */
+    bool  sun_visible;    /* any sun sensor face illuminated */
+    float momentum_Nms;   /* magnitude of the stored wheel momentum */
+} ADCS_MODE_inputs_t;
+
+
+/**
+ * @brief Enter the boot mode and run its entry action
+ */
+void MODE_init(void);
+
+
+ADCS_MODE_t MODE_get(void);
+
+
+/**
+ * @brief Command a mode transition (from the OBC).
+ *
+ * @param mode requested mode
+ * @return 0 on success, 1 if the mode is not valid
+ *
+ * @note Commanded transitions bypass the guards. Exit action of the current
+ * mode and entry action of the new mode are executed even if the mode is
+ * unchanged (re-entering a mode resets it).
+ */
+int MODE_command(ADCS_MODE_t mode);
+
+
+/**
+ * @brief Evaluate the autonomous transition guards of the current mode and
+ * take the first transition whose guard holds.
+ *
+ * @return the mode after evaluation
+ */
+ADCS_MODE_t MODE_update(const ADCS_MODE_inputs_t *inputs);
+
+
+const ADCS_MODE_profile_t *MODE_get_profile(ADCS_MODE_t mode);
+
+
+const char *MODE_to_string(ADCS_MODE_t mode);
+
+
+/**
+ * @brief Convert a mode name to a mode
+ *
+ * @return the mode, or ADCS_MODE_cnt if name does not match any mode
+ */
+ADCS_MODE_t MODE_from_string(const char *name);
+
+
+/**
+ * @brief Serialize the current mode and its scheduling profile
+ *
+ * @return 0 on success, 1 if w is full
+ */
+int MODE_to_json(JW_t *w);
+
+
+/**
+ * @brief Run the sampling and control tasks of the current mode's profile
+ * that are due. Call from the main loop.
+ *
+ * @param now_us free running microsecond timestamp (wraps)
+ */
+void MODE_run(uint32_t now_us);
+
+
+/**
+ * @brief Start the tasks of MODE_run over, on its next call
+ *
+ * @note Called by MODE_init
+ */
+void MODE_run_init(void);
+
+
+/**
+ * @brief Time multiplex the magnetorquers and the magnetometer.
+ *
+ * Every control period is split into a torque window and a quiet window at
+ * its end. A timer turns the torquers off when the quiet window opens and a
+ * second timer flags the magnetometer sample once the coils have settled.
+ * The next control period re-opens the torque window.
+ *
+ * @param period_ms control period, 0 stops duty cycling
+ * @return 0 on success, 1 if the period is too short to hold a quiet window
+ * (duty cycling is stopped)
+ *
+ * @note Called by MODE_run when the mode changes.
+ */
+int MODE_mag_duty_start(uint16_t period_ms);
+
+
+/**
+ * @brief Scale a dipole command so its average over the period (torquers
+ * are off during the quiet window) is the commanded dipole. The direction is
+ * kept if the scaled command has to be clipped to the dipole limit.
+ */
+void MODE_mag_duty_compensate(vec3_t *dipole_Am2);
+
+
+/**
+ * @brief Restore the coil voltages that were turned off for the quiet window
+ * when the control loop holds its previous outputs.
+ */
+void MODE_mag_duty_resume(void);
+
+
+/**
+ * @brief Turn the torquers off once the quiet window has opened, and start
+ * the coil settle time from then.
+ *
+ * @note The quiet timer runs in the tick interrupt and only flags the
+ * window. Called by MODE_run from the main loop, which writes the coils
+ * everywhere else.
+ */
+void MODE_mag_duty_poll(void);
+
+
+/**
+ * @brief Open the torque window of a new control period, after the coil
+ * voltages have been applied (or resumed).
+ */
+void MODE_mag_duty_torque_window(void);
+
+
+/**
+ * @brief Check if the coils have settled in the current quiet window and the
+ * magnetometer sample has not been taken yet.
+ */
+bool MODE_mag_duty_capture_due(void);
+
+
+/**
+ * @brief Record that the magnetometer sample of the quiet window was taken
+ *
+ * @param field_T the calibrated field, NULL if the sample failed
+ */
+void MODE_mag_duty_captured(const vec3_t *field_T);
+
+
+/**
+ * @brief Check if the magnetometer is sampled in the quiet windows
+ */
+bool MODE_mag_duty_active(void);
+
+
+/**
+ * @brief Serialize the magnetometer field for the OBC, in microtesla.
+ *
+ * While duty cycling this is the sample of the last quiet window: a read of
+ * its own would turn the coils off and back on in the torque window.
+ * Otherwise it is a new measurement (MAGTOM_measurement_to_json).
+ *
+ * @return 0 on success, 1 if w is full or there is no valid sample
+ */
+int MODE_mag_field_to_json(JW_t *w);
+
+
+void MODE_mag_duty_get_stats(ADCS_MODE_mag_duty_stats_t *stats);
+
+
+/**
+ * @brief Serialize the duty cycle stats
+ *
+ * @return 0 on success, 1 if w is full
+ */
+int MODE_mag_duty_to_json(JW_t *w);
+
+
+#ifdef __cplusplus
+/* clang-format off */
+}
+/* clang-format on */
+#endif /* End C linkage */
+#endif /* __ADCS_MODES_H__ */
@@ -0,0 +1,334 @@
+/**
+ * @file adcs_modes.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief ADCS operating mode manager
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "targets.h"
+#include "adcs_modes.h"
+#include "attitude_control.h"
+
+/* Guard thresholds */
+#define MODE_DETUMBLE_EXIT_RADPS (0.0087f)  /* 0.5 deg/s */
+#define MODE_DETUMBLE_ENTRY_RADPS (0.0524f) /* 3.0 deg/s */
+#define MODE_DETUMBLE_EXIT_COUNT (50u)      /* consecutive updates */
+
+#define MODE_WHEEL_MOMENTUM_MAX_NMS                                            \
+    ((ATTCTRL_WHEEL_INERTIA_KGM2) * (ATTCTRL_WHEEL_SPEED_MAX_RADPS))
+#define MODE_MOMENTUM_DUMP_NMS ((MODE_WHEEL_MOMENTUM_MAX_NMS)*0.5f)
+#define MODE_MOMENTUM_LOW_NMS ((MODE_WHEEL_MOMENTUM_MAX_NMS)*0.2f)
+
+typedef bool (*mode_guard)(const ADCS_MODE_inputs_t *in);
+typedef void (*mode_action)(void);
+typedef void (*mode_during_action)(const ADCS_MODE_inputs_t *in);
+
+typedef struct
+{
+    char                name[10];
+    mode_action         entry;
+    mode_during_action  during; /* runs on every update before the guards */
+    mode_action         exit;
+    ADCS_MODE_profile_t profile;
+} mode_table_item;
+
+typedef struct
+{
+    ADCS_MODE_t from;
+    ADCS_MODE_t to;
+    mode_guard  guard;
+} mode_transition_item;
+
+
+static void MODE_entry_actuators_off(void);
+static void MODE_entry_detumble(void);
+static void MODE_entry_pointing(void);
+static void MODE_entry_eclipse(void);
+static void MODE_during_detumble(const ADCS_MODE_inputs_t *in);
+static void MODE_exit_detumble(void);
+
+static bool MODE_guard_detumbled_sunlit(const ADCS_MODE_inputs_t *in);
+static bool MODE_guard_detumbled_dark(const ADCS_MODE_inputs_t *in);
+static bool MODE_guard_tumbling(const ADCS_MODE_inputs_t *in);
+static bool MODE_guard_dark_desaturated(const ADCS_MODE_inputs_t *in);
+static bool MODE_guard_sunlit_or_saturated(const ADCS_MODE_inputs_t *in);
+
+static void MODE_transition(ADCS_MODE_t to);
+
+
+/* MODE TABLE */
+/* clang-format off */
+static const mode_table_item mode_table[] = {
+    [ADCS_MODE_idle] = {
+        .name    = "idle",
+        .entry   = MODE_entry_actuators_off,
+        .during  = NULL,
+        .exit    = NULL,
+        .profile = {.imu_period_ms    = 1000,
+                    .magtom_period_ms = 0,
+                    .sunsen_period_ms = 0,
+                    .control_loop     = false},
+    },
+    [ADCS_MODE_burnwire] = {
+        .name    = "burnwire",
+        .entry   = MODE_entry_actuators_off,
+        .during  = NULL,
+        .exit    = NULL,
+        .profile = {.imu_period_ms    = 0,
+                    .magtom_period_ms = 0,
+                    .sunsen_period_ms = 0,
+                    .control_loop     = false},
+    },
+    [ADCS_MODE_detumble] = {
+        .name    = "detumble",
+        .entry   = MODE_entry_detumble,
+        .during  = MODE_during_detumble,
+        .exit    = MODE_exit_detumble,
+        .profile = {.imu_period_ms    = ATTCTRL_LOOP_PERIOD_MS,
+                    .magtom_period_ms = ATTCTRL_LOOP_PERIOD_MS,
+                    .sunsen_period_ms = 1000,
+                    .control_loop     = true},
+    },
+    [ADCS_MODE_pointing] = {
+        .name    = "pointing",
+        .entry   = MODE_entry_pointing,
+        .during  = NULL,
+        .exit    = NULL,
+        .profile = {.imu_period_ms    = ATTCTRL_LOOP_PERIOD_MS,
+                    .magtom_period_ms = ATTCTRL_LOOP_PERIOD_MS,
+                    .sunsen_period_ms = 1000,
+                    .control_loop     = true},
+    },
+    [ADCS_MODE_eclipse] = {
+        .name    = "eclipse",
+        .entry   = MODE_entry_eclipse,
+        .during  = NULL,
+        .exit    = NULL,
+        .profile = {.imu_period_ms    = ATTCTRL_LOOP_PERIOD_MS,
+                    .magtom_period_ms = 0,
+                    .sunsen_period_ms = 1000,
+                    .control_loop     = true},
+    },
+};
+
+
+/* AUTONOMOUS TRANSITIONS (evaluated in order, first match wins) */
+static const mode_transition_item mode_transitions[] = {
+    {ADCS_MODE_detumble, ADCS_MODE_pointing, MODE_guard_detumbled_sunlit},
+    {ADCS_MODE_detumble, ADCS_MODE_eclipse,  MODE_guard_detumbled_dark},
+    {ADCS_MODE_pointing, ADCS_MODE_detumble, MODE_guard_tumbling},
+    {ADCS_MODE_pointing, ADCS_MODE_eclipse,  MODE_guard_dark_desaturated},
+    {ADCS_MODE_eclipse,  ADCS_MODE_detumble, MODE_guard_tumbling},
+    {ADCS_MODE_eclipse,  ADCS_MODE_pointing, MODE_guard_sunlit_or_saturated},
+};
+/* clang-format on */
+
+
+static ADCS_MODE_t  current_mode;
+static unsigned int detumble_exit_count;
+
+
+void MODE_init(void)
+{
+    ATTCTRL_init();
+    MODE_run_init();
+    current_mode        = ADCS_MODE_BOOT;
+    detumble_exit_count = 0;
+    if (NULL != mode_table[current_mode].entry)
+    {
+        mode_table[current_mode].entry();
+    }
+}
+
+
+ADCS_MODE_t MODE_get(void)
+{
+    return current_mode;
+}
+
+
+int MODE_command(ADCS_MODE_t mode)
+{
+    if (mode >= ADCS_MODE_cnt)
+    {
+        return 1;
+    }
+    MODE_transition(mode);
+    return 0;
+}
+
+
+ADCS_MODE_t MODE_update(const ADCS_MODE_inputs_t *inputs)
+{
+    CONFIG_ASSERT(NULL != inputs);
+    if (NULL != mode_table[current_mode].during)
+    {
+        mode_table[current_mode].during(inputs);
+    }
+
+    unsigned int t;
+    unsigned int t_max = sizeof(mode_transitions) / sizeof(*mode_transitions);
+    for (t = 0; t < t_max; t++)
+    {
+        if (mode_transitions[t].from == current_mode)
+        {
+            if (mode_transitions[t].guard(inputs))
+            {
+                MODE_transition(mode_transitions[t].to);
+                break;
+            }
+        }
+    }
+    return current_mode;
+}
+
+
+const ADCS_MODE_profile_t *MODE_get_profile(ADCS_MODE_t mode)
+{
+    CONFIG_ASSERT(mode < ADCS_MODE_cnt);
+    return &mode_table[mode].profile;
+}
+
+
+const char *MODE_to_string(ADCS_MODE_t mode)
+{
+    if (mode < ADCS_MODE_cnt)
+    {
+        return mode_table[mode].name;
+    }
+    return "unknown";
+}
+
+
+ADCS_MODE_t MODE_from_string(const char *name)
+{
+    CONFIG_ASSERT(NULL != name);
+    ADCS_MODE_t mode;
+    for (mode = ADCS_MODE_idle; mode < ADCS_MODE_cnt; mode++)
+    {
+        if (strcmp(name, mode_table[mode].name) == 0)
+        {
+            break;
+        }
+    }
+    return mode;
+}
+
+
+int MODE_to_json(JW_t *w)
+{
+    CONFIG_ASSERT(NULL != w);
+    const ADCS_MODE_profile_t *p = &mode_table[current_mode].profile;
+    JW_object_begin(w);
+    JW_key(w, "mode");
+    JW_str(w, mode_table[current_mode].name);
+    JW_key(w, "imu_ms");
+    JW_uint(w, p->imu_period_ms);
+    JW_key(w, "mag_ms");
+    JW_uint(w, p->magtom_period_ms);
+    JW_key(w, "sun_ms");
+    JW_uint(w, p->sunsen_period_ms);
+    JW_key(w, "ctrl");
+    JW_bool(w, p->control_loop);
+    JW_object_end(w);
+    return JW_error(w);
+}
+
+
+static void MODE_transition(ADCS_MODE_t to)
+{
+    if (NULL != mode_table[current_mode].exit)
+    {
+        mode_table[current_mode].exit();
+    }
+    current_mode = to;
+    if (NULL != mode_table[current_mode].entry)
+    {
+        mode_table[current_mode].entry();
+    }
+}
+
+
+static void MODE_entry_actuators_off(void)
+{
+    ATTCTRL_set_mode(ATTCTRL_MODE_off);
+    ATTCTRL_actuators_off();
+}
+
+
+static void MODE_entry_detumble(void)
+{
+    detumble_exit_count = 0;
+    ATTCTRL_set_mode(ATTCTRL_MODE_detumble);
+}
+
+
+static void MODE_entry_pointing(void)
+{
+    ATTCTRL_set_mode(ATTCTRL_MODE_pointing);
+}
+
+
+static void MODE_entry_eclipse(void)
+{
+    ATTCTRL_set_mode(ATTCTRL_MODE_eclipse);
+}
+
+
+static void MODE_during_detumble(const ADCS_MODE_inputs_t *in)
+{
+    /* Rate must stay below the exit threshold for consecutive updates */
+    if (in->rate_radps < MODE_DETUMBLE_EXIT_RADPS)
+    {
+        if (detumble_exit_count < MODE_DETUMBLE_EXIT_COUNT)
+        {
+            detumble_exit_count++;
+        }
+    }
+    else
+    {
+        detumble_exit_count = 0;
+    }
+}
+
+
+static void MODE_exit_detumble(void)
+{
+    detumble_exit_count = 0;
+}
+
+
+static bool MODE_guard_detumbled_sunlit(const ADCS_MODE_inputs_t *in)
+{
+    return detumble_exit_count >= MODE_DETUMBLE_EXIT_COUNT && in->sun_visible;
+}
+
+
+static bool MODE_guard_detumbled_dark(const ADCS_MODE_inputs_t *in)
+{
+    return detumble_exit_count >= MODE_DETUMBLE_EXIT_COUNT && !in->sun_visible;
+}
+
+
+static bool MODE_guard_tumbling(const ADCS_MODE_inputs_t *in)
+{
+    return in->rate_radps > MODE_DETUMBLE_ENTRY_RADPS;
+}
+
+
+static bool MODE_guard_dark_desaturated(const ADCS_MODE_inputs_t *in)
+{
+    return !in->sun_visible && in->momentum_Nms < MODE_MOMENTUM_LOW_NMS;
+}
+
+
+static bool MODE_guard_sunlit_or_saturated(const ADCS_MODE_inputs_t *in)
+{
+    return in->sun_visible || in->momentum_Nms > MODE_MOMENTUM_DUMP_NMS;
+}
@@ -0,0 +1,299 @@
+/**
+ * @file mode_mag_duty.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Time multiplexing of the magnetorquers and the magnetometer within
+ * each control period
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ * @note Timeline of one control period of length P:
+ *
+ *  0          control step applies the (compensated) coil voltages
+ *  P - Q      quiet timer : the main loop turns the torquers off
+ *  P - Q + S  settle timer : magnetometer sample is due
+ *  P          next control step uses the sample and re-opens the torque window
+ *
+ * Q is the quiet window and S the coil settle time. Both timer callbacks run
+ * in the time base tick interrupt on the target and only raise a flag. The
+ * coils are written from the main loop alone (MODE_mag_duty_poll), so the
+ * quiet window cannot land in the middle of ATTCTRL_apply or of the coil
+ * save and restore around a magnetometer read. The sample itself is taken
+ * from the main loop (SPI transfers do not belong in an interrupt) any time
+ * before the window closes.
+ */
+#include <string.h>
+#include <math.h>
+
+#include "targets.h"
+#include "adcs_modes.h"
+#include "attitude_control.h"
+
+#include "magnetorquers.h"
+#include "magnetometer.h"
+#include "timebase.h"
+
+/* Time allowed for the magnetometer sample after the coils have settled */
+#define MODE_MAG_CAPTURE_MARGIN_MS (5u)
+#define MODE_MAG_QUIET_MS ((MAGTOM_COIL_SETTLE_MS) + (MODE_MAG_CAPTURE_MARGIN_MS))
+
+#define MODE_MAG_UT_PER_T (1.0e6f)
+
+typedef struct
+{
+    uint16_t         period_ms;
+    float            on_fraction;
+    TIMEBASE_timer_t quiet_timer;
+    TIMEBASE_timer_t settle_timer;
+    volatile bool    quiet_due;
+    volatile bool    capture_due;
+    bool             quiet;
+    bool             sampled;
+    bool             field_valid;
+    uint32_t         quiet_start_ms;
+    int              coil_mv[3];
+    vec3_t           field_T; /* sample of the last quiet window */
+} mode_mag_duty;
+
+
+static const MQTR_t mode_mag_duty_coils[] = {MQTR_x, MQTR_y, MQTR_z};
+
+static mode_mag_duty              duty;
+static ADCS_MODE_mag_duty_stats_t duty_stats;
+
+
+static void MODE_mag_duty_quiet(void *ctx);
+static void MODE_mag_duty_settled(void *ctx);
+
+
+int MODE_mag_duty_start(uint16_t period_ms)
+{
+    TIMEBASE_timer_cancel(&duty.quiet_timer);
+    TIMEBASE_timer_cancel(&duty.settle_timer);
+    memset(&duty, 0, sizeof(duty));
+    memset(&duty_stats, 0, sizeof(duty_stats));
+    duty_stats.quiet_ms = MODE_MAG_QUIET_MS;
+
+    if (period_ms <= MODE_MAG_QUIET_MS)
+    {
+        return (period_ms == 0) ? 0 : 1;
+    }
+
+    duty.period_ms       = period_ms;
+    duty.on_fraction     = (float)(period_ms - MODE_MAG_QUIET_MS) / period_ms;
+    duty_stats.period_ms = period_ms;
+    duty_stats.duty_loss = 1.0f - duty.on_fraction;
+    duty_stats.gain      = 1.0f / duty.on_fraction;
+    duty_stats.capture_ms_min = UINT16_MAX;
+    return 0;
+}
+
+
+void MODE_mag_duty_compensate(vec3_t *dipole_Am2)
+{
+    CONFIG_ASSERT(NULL != dipole_Am2);
+    if (duty.period_ms == 0)
+    {
+        return;
+    }
+
+    float peak = fabsf(dipole_Am2->x);
+    if (fabsf(dipole_Am2->y) > peak)
+    {
+        peak = fabsf(dipole_Am2->y);
+    }
+    if (fabsf(dipole_Am2->z) > peak)
+    {
+        peak = fabsf(dipole_Am2->z);
+    }
+
+    float scale = duty_stats.gain;
+    if (peak * scale > ATTCTRL_DIPOLE_MAX_AM2)
+    {
+        scale = ATTCTRL_DIPOLE_MAX_AM2 / peak;
+        duty_stats.saturated++;
+    }
+
+    dipole_Am2->x *= scale;
+    dipole_Am2->y *= scale;
+    dipole_Am2->z *= scale;
+    duty_stats.residual_loss =
+        (peak > 0.0f) ? 1.0f - scale * duty.on_fraction : 0.0f;
+}
+
+
+void MODE_mag_duty_resume(void)
+{
+    if (duty.period_ms == 0 || !duty.quiet)
+    {
+        return;
+    }
+
+    unsigned int i;
+    for (i = 0; i < sizeof(mode_mag_duty_coils) / sizeof(*mode_mag_duty_coils);
+         i++)
+    {
+        MQTR_set_coil_voltage_mv(mode_mag_duty_coils[i], duty.coil_mv[i]);
+    }
+}
+
+
+void MODE_mag_duty_poll(void)
+{
+    if (!duty.quiet_due)
+    {
+        return;
+    }
+
+    unsigned int i;
+    duty.quiet_due = false;
+    for (i = 0; i < sizeof(mode_mag_duty_coils) / sizeof(*mode_mag_duty_coils);
+         i++)
+    {
+        duty.coil_mv[i] = MQTR_get_coil_voltage_mv(mode_mag_duty_coils[i]);
+        MQTR_set_coil_voltage_mv(mode_mag_duty_coils[i], 0);
+    }
+    duty.quiet          = true;
+    duty.quiet_start_ms = TIMEBASE_get_ms();
+    TIMEBASE_timer_start(&duty.settle_timer, MAGTOM_COIL_SETTLE_MS,
+                         MODE_mag_duty_settled, NULL);
+}
+
+
+void MODE_mag_duty_torque_window(void)
+{
+    if (duty.period_ms == 0)
+    {
+        return;
+    }
+
+    TIMEBASE_timer_cancel(&duty.quiet_timer);
+    TIMEBASE_timer_cancel(&duty.settle_timer);
+    if (duty_stats.cycles > 0 && !duty.sampled)
+    {
+        duty_stats.missed++;
+    }
+    duty.quiet_due   = false;
+    duty.quiet       = false;
+    duty.capture_due = false;
+    duty.sampled     = false;
+    duty_stats.cycles++;
+
+    TIMEBASE_timer_start(&duty.quiet_timer, duty.period_ms - MODE_MAG_QUIET_MS,
+                         MODE_mag_duty_quiet, NULL);
+}
+
+
+bool MODE_mag_duty_capture_due(void)
+{
+    return duty.capture_due;
+}
+
+
+void MODE_mag_duty_captured(const vec3_t *field_T)
+{
+    duty.capture_due = false;
+    duty.sampled     = true;
+    duty_stats.captures++;
+    if (NULL != field_T)
+    {
+        duty.field_T     = *field_T;
+        duty.field_valid = true;
+    }
+
+    uint32_t delay_ms = TIMEBASE_get_ms() - duty.quiet_start_ms;
+    if (delay_ms > UINT16_MAX)
+    {
+        delay_ms = UINT16_MAX;
+    }
+    if (delay_ms < duty_stats.capture_ms_min)
+    {
+        duty_stats.capture_ms_min = (uint16_t)delay_ms;
+    }
+    if (delay_ms > duty_stats.capture_ms_max)
+    {
+        duty_stats.capture_ms_max = (uint16_t)delay_ms;
+    }
+}
+
+
+bool MODE_mag_duty_active(void)
+{
+    return duty.period_ms != 0;
+}
+
+
+int MODE_mag_field_to_json(JW_t *w)
+{
+    CONFIG_ASSERT(NULL != w);
+    if (duty.period_ms == 0)
+    {
+        return MAGTOM_measurement_to_json(w);
+    }
+    if (!duty.field_valid)
+    {
+        return 1;
+    }
+
+    /* Calibrated field in microtesla, as MAGTOM_measurement_to_json */
+    JW_array_begin(w);
+    JW_float(w, duty.field_T.x * MODE_MAG_UT_PER_T, 3);
+    JW_float(w, duty.field_T.y * MODE_MAG_UT_PER_T, 3);
+    JW_float(w, duty.field_T.z * MODE_MAG_UT_PER_T, 3);
+    JW_array_end(w);
+    return JW_error(w);
+}
+
+
+void MODE_mag_duty_get_stats(ADCS_MODE_mag_duty_stats_t *stats)
+{
+    CONFIG_ASSERT(NULL != stats);
+    *stats = duty_stats;
+    if (stats->captures == 0)
+    {
+        stats->capture_ms_min = 0;
+    }
+}
+
+
+int MODE_mag_duty_to_json(JW_t *w)
+{
+    CONFIG_ASSERT(NULL != w);
+    ADCS_MODE_mag_duty_stats_t s;
+    MODE_mag_duty_get_stats(&s);
+    JW_object_begin(w);
+    JW_key(w, "cyc");
+    JW_uint(w, s.cycles);
+    JW_key(w, "cap");
+    JW_uint(w, s.captures);
+    JW_key(w, "miss");
+    JW_uint(w, s.missed);
+    JW_key(w, "sat");
+    JW_uint(w, s.saturated);
+    JW_key(w, "cap_ms");
+    JW_array_begin(w);
+    JW_uint(w, s.capture_ms_min);
+    JW_uint(w, s.capture_ms_max);
+    JW_array_end(w);
+    JW_key(w, "loss");
+    JW_float(w, s.duty_loss, 3);
+    JW_key(w, "res");
+    JW_float(w, s.residual_loss, 3);
+    JW_object_end(w);
+    return JW_error(w);
+}
+
+
+static void MODE_mag_duty_quiet(void *ctx)
+{
+    (void)ctx;
+    duty.quiet_due = true;
+}
+
+
+static void MODE_mag_duty_settled(void *ctx)
+{
+    (void)ctx;
+    duty.capture_due = true;
+}
@@ -0,0 +1,260 @@
+/**
+ * @file mode_scheduler.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Runs the sensor sampling and control tasks selected by the
+ * scheduling profile of the current ADCS mode
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "targets.h"
+#include "adcs_modes.h"
+#include "attitude_control.h"
+#include "quaternion.h"
+
+#include "imu.h"
+#include "magnetometer.h"
+#include "sun_sensors.h"
+#include "magnetorquers.h"
+#include "parameters.h"
+#include "telemetry.h"
+#include "tlm_stream.h"
+#include "timebase.h"
+#include "profiling.h"
+#include "isr_monitor.h"
+
+#define MODE_US_PER_MS (1000u)
+
+typedef struct
+{
+    bool     started;
+    uint32_t last_us;
+} task_timer;
+
+
+static ADCS_MODE_t     scheduled_mode = ADCS_MODE_cnt;
+static task_timer      magtom_timer;
+static task_timer      sunsen_timer;
+static task_timer      tlm_timer;
+static ATTCTRL_input_t sample;
+static vec3_t          wheel_cmd_radps;
+static uint32_t        tlm_overruns;
+static uint32_t        stream_overruns;
+static bool            mag_duty;
+static bool            imu_valid;
+static bool            magtom_valid;
+static bool            sunsen_valid;
+
+
+static bool MODE_task_due(task_timer *tmr, uint16_t period_ms, uint32_t now);
+static bool MODE_sensors_valid(const ADCS_MODE_profile_t *profile);
+static void MODE_control_task(const ADCS_MODE_profile_t *profile);
+static void MODE_log_task(void);
+static void MODE_fill_record(TLM_record_t *rec, uint32_t *overruns_seen);
+
+
+void MODE_run(uint32_t now_us)
+{
+    PROF_BEGIN(PROF_mode_run);
+    ADCS_MODE_t                mode    = MODE_get();
+    const ADCS_MODE_profile_t *profile = MODE_get_profile(mode);
+
+    if (mode != scheduled_mode)
+    {
+        /* New profile: drop samples that the new mode might not refresh and
+         * start every task on the next call */
+        scheduled_mode = mode;
+        IMU_set_sample_period_ms(profile->imu_period_ms);
+        mag_duty = profile->control_loop && profile->magtom_period_ms != 0;
+        MODE_mag_duty_start(mag_duty ? ATTCTRL_LOOP_PERIOD_MS : 0);
+        memset(&magtom_timer, 0, sizeof(magtom_timer));
+        memset(&sunsen_timer, 0, sizeof(sunsen_timer));
+        memset(&sample, 0, sizeof(sample));
+        imu_valid    = false;
+        magtom_valid = false;
+        sunsen_valid = false;
+    }
+
+    /* The IMU paces its own burst reads, use the newest sample */
+    PROF_BEGIN(PROF_imu_acquire);
+    IMU_acquire(now_us);
+    PROF_END(PROF_imu_acquire);
+    if (IMU_get_attitude(&sample.q_body, &sample.rate_radps) == 0)
+    {
+        imu_valid = true;
+    }
+
+    if (mag_duty)
+    {
+        /* Sample in the quiet window while the torquers are off */
+        MODE_mag_duty_poll();
+        if (MODE_mag_duty_capture_due())
+        {
+            magtom_valid = (MAGTOM_capture_field_T(&sample.bfield_T) == 0);
+            MODE_mag_duty_captured(magtom_valid ? &sample.bfield_T : NULL);
+        }
+    }
+    else if (MODE_task_due(&magtom_timer, profile->magtom_period_ms, now_us))
+    {
+        magtom_valid = (MAGTOM_get_field_T(&sample.bfield_T) == 0);
+    }
+
+    if (MODE_task_due(&sunsen_timer, profile->sunsen_period_ms, now_us))
+    {
+        sample.sun_visible = SUNSEN_sun_visible();
+        sunsen_valid       = true;
+    }
+
+    if (profile->control_loop)
+    {
+        if (ATTCTRL_loop_due(now_us))
+        {
+            PROF_BEGIN(PROF_control);
+            MODE_control_task(profile);
+            PROF_END(PROF_control);
+        }
+    }
+
+    /* Logged across mode changes so the transitions show up in the log */
+    if (MODE_task_due(&tlm_timer, (uint16_t)PARAM_get_int(PARAM_tlm_period_ms),
+                      now_us))
+    {
+        MODE_log_task();
+    }
+
+    if (TLM_stream_due(now_us))
+    {
+        TLM_record_t rec;
+        MODE_fill_record(&rec, &stream_overruns);
+        TLM_stream_sample(&rec, now_us);
+    }
+    PROF_END(PROF_mode_run);
+}
+
+
+void MODE_run_init(void)
+{
+    /* The loop statistics start over with ATTCTRL_init */
+    scheduled_mode  = ADCS_MODE_cnt;
+    tlm_overruns    = 0;
+    stream_overruns = 0;
+    memset(&tlm_timer, 0, sizeof(tlm_timer));
+}
+
+
+static bool MODE_task_due(task_timer *tmr, uint16_t period_ms, uint32_t now)
+{
+    if (period_ms == 0)
+    {
+        return false;
+    }
+
+    uint32_t period_us = (uint32_t)period_ms * MODE_US_PER_MS;
+    if (!tmr->started)
+    {
+        tmr->started = true;
+        tmr->last_us = now;
+        return true;
+    }
+
+    uint32_t elapsed_us = now - tmr->last_us;
+    if (elapsed_us < period_us)
+    {
+        return false;
+    }
+
+    if (elapsed_us >= 2 * period_us)
+    {
+        tmr->last_us = now; /* fell behind, re-phase */
+    }
+    else
+    {
+        tmr->last_us += period_us;
+    }
+    return true;
+}
+
+
+static bool MODE_sensors_valid(const ADCS_MODE_profile_t *profile)
+{
+    if (!imu_valid)
+    {
+        return false;
+    }
+    if (profile->magtom_period_ms != 0 && !magtom_valid)
+    {
+        return false;
+    }
+    if (profile->sunsen_period_ms != 0 && !sunsen_valid)
+    {
+        return false;
+    }
+    return true;
+}
+
+
+static void MODE_control_task(const ADCS_MODE_profile_t *profile)
+{
+    /* Hold the actuators at their previous setpoints until every sensor the
+     * profile samples has produced a valid measurement */
+    if (!MODE_sensors_valid(profile))
+    {
+        MODE_mag_duty_resume();
+        MODE_mag_duty_torque_window();
+        return;
+    }
+
+    ATTCTRL_output_t out;
+    ATTCTRL_read_wheels(&sample);
+    ATTCTRL_step(&sample, &out);
+    MODE_mag_duty_compensate(&out.dipole_Am2);
+    ATTCTRL_apply(&out);
+    MODE_mag_duty_torque_window();
+    wheel_cmd_radps = out.wheel_speed_radps;
+
+    ADCS_MODE_inputs_t inputs;
+    inputs.rate_radps   = VEC3_norm(sample.rate_radps);
+    inputs.sun_visible  = sample.sun_visible;
+    inputs.momentum_Nms = ATTCTRL_get_wheel_momentum_Nms();
+    MODE_update(&inputs);
+}
+
+
+static void MODE_log_task(void)
+{
+    TLM_record_t rec;
+    MODE_fill_record(&rec, &tlm_overruns);
+    TLM_log(&rec);
+}
+
+
+/* overruns_seen is the loop overrun count when the consumer last took a
+ * record, the record holds the overruns since then */
+static void MODE_fill_record(TLM_record_t *rec, uint32_t *overruns_seen)
+{
+    ATTCTRL_loop_stats_t stats;
+    ATTCTRL_get_loop_stats(&stats);
+
+    rec->t_ms        = TIMEBASE_get_ms();
+    rec->mode        = (uint8_t)scheduled_mode;
+    rec->q_body      = sample.q_body;
+    rec->rate_radps  = sample.rate_radps;
+    rec->wheel_radps = wheel_cmd_radps;
+    rec->coil_ma[0]  = (int16_t)MQTR_get_current_ma(MQTR_x);
+    rec->coil_ma[1]  = (int16_t)MQTR_get_current_ma(MQTR_y);
+    rec->coil_ma[2]  = (int16_t)MQTR_get_current_ma(MQTR_z);
+
+    const uint32_t overruns = stats.overruns - *overruns_seen;
+    *overruns_seen          = stats.overruns;
+    rec->jitter_us = (stats.jitter_max_us > UINT16_MAX)
+                         ? UINT16_MAX
+                         : (uint16_t)stats.jitter_max_us;
+    rec->overruns = (overruns > UINT16_MAX) ? UINT16_MAX : (uint16_t)overruns;
+    rec->isr_over = ISR_MON_over_budget_mask();
+    rec->isr_pct  = ISR_MON_worst_response_pct();
+}
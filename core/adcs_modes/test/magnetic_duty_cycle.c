@@ -0,0 +1,255 @@
+/**
+ * @file magnetic_duty_cycle.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Timing simulation of the magnetorquer / magnetometer time
+ * multiplexing on the simulated millisecond tick, also with an OBC read of
+ * the magnetometer around the quiet timer
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ */
+#if defined(TARGET_MCU)
+#error NATIVE TESTS CANNOT BE RUN ON A BARE METAL MICROCONTROLLER
+#endif /* #if defined(TARGET_MCU) */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "adcs_modes.h"
+#include "attitude_control.h"
+#include "magnetorquers.h"
+#include "magnetometer.h"
+#include "timebase.h"
+#include "imu.h"
+#include "i2c_emulator.h"
+#include "bno055_emulator.h"
+#include "pwm.h"
+#include "test_expect.h"
+
+#define PERIOD_MS (ATTCTRL_LOOP_PERIOD_MS)
+#define CYCLES (10)
+#define MV_PER_AM2 ((PWM_VMAX_MV_float) / (ATTCTRL_DIPOLE_MAX_AM2))
+#define SIM_S (10u)
+
+
+static void apply_dipole(vec3_t m)
+{
+    ATTCTRL_output_t out;
+    memset(&out, 0, sizeof(out));
+    out.dipole_Am2 = m;
+    ATTCTRL_apply(&out);
+}
+
+
+static int coil_mv(unsigned int axis)
+{
+    return MQTR_get_coil_voltage_mv((MQTR_t)axis);
+}
+
+
+int main(void)
+{
+    ADCS_MODE_mag_duty_stats_t stats;
+    unsigned int               cycle, ms, axis;
+    char                       buf[100];
+    JW_t                       w;
+
+    TIMEBASE_init();
+    MQTR_init();
+    EXPECT(MODE_mag_duty_start(10) == 1); /* no room for a quiet window */
+    MODE_mag_duty_get_stats(&stats);
+    EXPECT(stats.period_ms == 0);
+
+    EXPECT(MODE_mag_duty_start(PERIOD_MS) == 0);
+    MODE_mag_duty_get_stats(&stats);
+    const unsigned int quiet_ms = stats.quiet_ms;
+    const unsigned int on_ms    = PERIOD_MS - quiet_ms;
+    EXPECT(quiet_ms > MAGTOM_COIL_SETTLE_MS && quiet_ms < PERIOD_MS);
+    EXPECT(fabsf(stats.duty_loss - (float)quiet_ms / PERIOD_MS) < 1e-6f);
+    EXPECT(fabsf(stats.gain * on_ms - PERIOD_MS) < 1e-3f);
+    EXPECT(MODE_mag_duty_active());
+
+    /* No quiet window sample to give the OBC yet */
+    JW_init(&w, buf, sizeof(buf));
+    EXPECT(MODE_mag_field_to_json(&w) == 1);
+
+    /* Compensation keeps the average dipole */
+    const vec3_t cmd  = {0.1f, -0.05f, 0.02f};
+    vec3_t       comp = cmd;
+    MODE_mag_duty_compensate(&comp);
+    EXPECT(fabsf(comp.x * on_ms - cmd.x * PERIOD_MS) < 1e-4f);
+    EXPECT(fabsf(comp.y * on_ms - cmd.y * PERIOD_MS) < 1e-4f);
+    MODE_mag_duty_get_stats(&stats);
+    EXPECT(stats.saturated == 0 && stats.residual_loss < 1e-6f);
+
+    /* Torque window, coil turn off, settle and capture on the tick */
+    const float  cmd_mv[3] = {cmd.x * MV_PER_AM2, cmd.y * MV_PER_AM2,
+                             cmd.z * MV_PER_AM2};
+    const vec3_t field_T   = {20.0e-6f, -5.0e-6f, 40.0e-6f};
+    for (cycle = 0; cycle < CYCLES; cycle++)
+    {
+        float integral_mv_ms[3] = {0};
+        apply_dipole(comp);
+        MODE_mag_duty_torque_window();
+        for (ms = 0; ms < PERIOD_MS; ms++)
+        {
+            MODE_mag_duty_poll(); /* the main loop */
+            for (axis = 0; axis < 3; axis++)
+            {
+                integral_mv_ms[axis] += coil_mv(axis);
+                if (ms < on_ms)
+                {
+                    EXPECT(coil_mv(axis) != 0);
+                }
+                else
+                {
+                    EXPECT(coil_mv(axis) == 0);
+                }
+            }
+
+            bool due = MODE_mag_duty_capture_due();
+            EXPECT(due == (ms == on_ms + MAGTOM_COIL_SETTLE_MS));
+            if (due)
+            {
+                MODE_mag_duty_captured(&field_T);
+                EXPECT(!MODE_mag_duty_capture_due());
+            }
+            TIMEBASE_tick();
+        }
+
+        /* Average coil voltage over the period is the uncompensated command
+         * (within the 1 mV quantisation of the voltage setpoint) */
+        for (axis = 0; axis < 3; axis++)
+        {
+            EXPECT(fabsf(integral_mv_ms[axis] / PERIOD_MS - cmd_mv[axis]) <
+                   1.0f);
+        }
+    }
+
+    MODE_mag_duty_get_stats(&stats);
+    EXPECT(stats.cycles == CYCLES && stats.captures == CYCLES);
+    EXPECT(stats.missed == 0);
+    EXPECT(stats.capture_ms_min == MAGTOM_COIL_SETTLE_MS);
+    EXPECT(stats.capture_ms_max == MAGTOM_COIL_SETTLE_MS);
+
+    /* Held outputs: the coils come back on with the previous voltages and a
+     * window that closed without a sample is counted */
+    int held_mv[3];
+    for (axis = 0; axis < 3; axis++)
+    {
+        held_mv[axis] = coil_mv(axis);
+        EXPECT(held_mv[axis] == 0); /* still in the quiet window */
+    }
+    MODE_mag_duty_resume();
+    MODE_mag_duty_torque_window();
+    EXPECT(coil_mv(0) == (int)(comp.x * MV_PER_AM2));
+    EXPECT(coil_mv(1) == (int)(comp.y * MV_PER_AM2));
+    for (ms = 0; ms < PERIOD_MS; ms++)
+    {
+        MODE_mag_duty_poll();
+        TIMEBASE_tick();
+    }
+    MODE_mag_duty_torque_window();
+    MODE_mag_duty_get_stats(&stats);
+    EXPECT(stats.missed == 1);
+
+    /* The OBC reads the magnetometer in the torque window: it gets the
+     * quiet window sample, the coils stay on and no time passes */
+    apply_dipole(comp);
+    MODE_mag_duty_torque_window();
+    const uint32_t read_ms = TIMEBASE_get_ms();
+    JW_init(&w, buf, sizeof(buf));
+    EXPECT(MODE_mag_field_to_json(&w) == 0);
+    EXPECT(JW_finish(&w) == 0);
+    EXPECT(strcmp(buf, "[20.000,-5.000,40.000]") == 0);
+    EXPECT(TIMEBASE_get_ms() == read_ms);
+    EXPECT(coil_mv(0) == (int)(comp.x * MV_PER_AM2));
+
+    /* A read that turns the coils off itself (as MAGTOM_get_field_T does
+     * outside duty cycling) with the quiet timer expiring during its settle
+     * wait. The read puts back what it found, and the quiet window then
+     * keeps the commanded voltages, not the zeros of the read */
+    for (ms = 0; ms + 3u < on_ms; ms++)
+    {
+        MODE_mag_duty_poll();
+        TIMEBASE_tick();
+    }
+    vec3_t b;
+    (void)MAGTOM_get_field_T(&b);
+    EXPECT(TIMEBASE_get_ms() - read_ms > on_ms); /* the quiet timer ran */
+    EXPECT(coil_mv(0) == (int)(comp.x * MV_PER_AM2));
+    MODE_mag_duty_poll();
+    for (axis = 0; axis < 3; axis++)
+    {
+        EXPECT(coil_mv(axis) == 0);
+    }
+    MODE_mag_duty_resume();
+    EXPECT(coil_mv(0) == (int)(comp.x * MV_PER_AM2));
+    EXPECT(coil_mv(1) == (int)(comp.y * MV_PER_AM2));
+    EXPECT(coil_mv(2) == (int)(comp.z * MV_PER_AM2));
+
+    /* Commands that cannot be fully compensated are clipped, not bent */
+    vec3_t big = {0.19f, 0.095f, 0.0f};
+    MODE_mag_duty_compensate(&big);
+    MODE_mag_duty_get_stats(&stats);
+    EXPECT(stats.saturated == 1);
+    EXPECT(fabsf(big.x - ATTCTRL_DIPOLE_MAX_AM2) < 1e-6f);
+    EXPECT(fabsf(big.y - ATTCTRL_DIPOLE_MAX_AM2 / 2.0f) < 1e-6f);
+    float delivered = big.x * on_ms / PERIOD_MS;
+    EXPECT(fabsf(stats.residual_loss - (1.0f - delivered / 0.19f)) < 1e-5f);
+
+    JW_init(&w, buf, sizeof(buf));
+    EXPECT(MODE_mag_duty_to_json(&w) == 0);
+    EXPECT(JW_finish(&w) == 0);
+    printf("%s\n", buf);
+
+    /* Closed loop through the mode scheduler: one sample in the quiet window
+     * of every control period */
+    I2C_EMU_init();
+    EXPECT(BNO055_EMU_attach(IMU_I2C_ADDR) == 0);
+    IMU_init();
+    BNO055_EMU_set_quaternion(16384, 0, 0, 0);
+    BNO055_EMU_set_gyro(160, -80, 48); /* 10 dps, stays in detumble */
+    TIMEBASE_init();
+    MODE_init();
+    EXPECT(MODE_command(ADCS_MODE_detumble) == 0);
+
+    uint32_t now_us = 0;
+    for (ms = 0; ms < SIM_S * 1000u; ms++)
+    {
+        if (now_us > I2C_EMU_get_time_us())
+        {
+            I2C_EMU_set_time_us(now_us);
+        }
+        MODE_run(now_us);
+        TIMEBASE_tick();
+        now_us += 1000u;
+    }
+    EXPECT(MODE_get() == ADCS_MODE_detumble);
+
+    MODE_mag_duty_get_stats(&stats);
+    EXPECT(stats.period_ms == PERIOD_MS);
+    EXPECT(stats.cycles == SIM_S * 1000u / PERIOD_MS);
+    EXPECT(stats.captures == stats.cycles);
+    EXPECT(stats.missed == 0);
+    EXPECT(stats.capture_ms_min >= MAGTOM_COIL_SETTLE_MS);
+    EXPECT(stats.capture_ms_max < stats.quiet_ms);
+
+    /* Modes without the magnetometer do not duty cycle */
+    EXPECT(MODE_command(ADCS_MODE_eclipse) == 0);
+    MODE_run(now_us);
+    MODE_mag_duty_get_stats(&stats);
+    EXPECT(stats.period_ms == 0 && stats.cycles == 0);
+    EXPECT(!MODE_mag_duty_active());
+
+    JW_init(&w, buf, sizeof(buf));
+    EXPECT(MODE_mag_duty_to_json(&w) == 0);
+    EXPECT(JW_finish(&w) == 0);
+    printf("%s\n", buf);
+    return 0;
+}
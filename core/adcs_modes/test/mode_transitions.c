@@ -0,0 +1,144 @@
+/**
+ * @file mode_transitions.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Test the commanded and autonomous transitions of the ADCS modes
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "adcs_modes.h"
+#include "attitude_control.h"
+#include "test_expect.h"
+
+#define SLOW_RADPS (0.001f)
+#define FAST_RADPS (0.1f)
+#define MID_RADPS (0.02f) /* between detumble exit and entry thresholds */
+
+#define MOMENTUM_LOW_NMS (1.0e-4f)
+#define MOMENTUM_MID_NMS (2.0e-3f)
+#define MOMENTUM_HIGH_NMS (5.0e-3f)
+
+
+static ADCS_MODE_t update(float rate, bool sun, float momentum)
+{
+    ADCS_MODE_inputs_t in;
+    in.rate_radps   = rate;
+    in.sun_visible  = sun;
+    in.momentum_Nms = momentum;
+    return MODE_update(&in);
+}
+
+
+int main(void)
+{
+    int i;
+
+    MODE_init();
+    EXPECT(MODE_get() == ADCS_MODE_BOOT);
+    EXPECT(ATTCTRL_get_mode() == ATTCTRL_MODE_off);
+
+    /* Idle and burnwire only leave on command */
+    for (i = 0; i < 200; i++)
+    {
+        EXPECT(update(SLOW_RADPS, true, MOMENTUM_HIGH_NMS) == ADCS_MODE_idle);
+    }
+    EXPECT(MODE_command(ADCS_MODE_burnwire) == 0);
+    for (i = 0; i < 200; i++)
+    {
+        EXPECT(update(FAST_RADPS, false, 0.0f) == ADCS_MODE_burnwire);
+    }
+
+    /* Invalid commands are rejected */
+    EXPECT(MODE_command(ADCS_MODE_cnt) == 1);
+    EXPECT(MODE_get() == ADCS_MODE_burnwire);
+
+    /* Entry action selects the control law */
+    EXPECT(MODE_command(ADCS_MODE_detumble) == 0);
+    EXPECT(ATTCTRL_get_mode() == ATTCTRL_MODE_detumble);
+
+    /* Rate must stay low for consecutive updates, a spike restarts the
+     * count */
+    for (i = 0; i < 30; i++)
+    {
+        EXPECT(update(SLOW_RADPS, true, 0.0f) == ADCS_MODE_detumble);
+    }
+    EXPECT(update(MID_RADPS, true, 0.0f) == ADCS_MODE_detumble);
+    for (i = 0; i < 49; i++)
+    {
+        EXPECT(update(SLOW_RADPS, true, 0.0f) == ADCS_MODE_detumble);
+    }
+    EXPECT(update(SLOW_RADPS, true, 0.0f) == ADCS_MODE_pointing);
+    EXPECT(ATTCTRL_get_mode() == ATTCTRL_MODE_pointing);
+
+    /* Dark with stored momentum keeps dumping in pointing mode */
+    EXPECT(update(SLOW_RADPS, false, MOMENTUM_MID_NMS) == ADCS_MODE_pointing);
+    EXPECT(update(SLOW_RADPS, false, MOMENTUM_LOW_NMS) == ADCS_MODE_eclipse);
+    EXPECT(ATTCTRL_get_mode() == ATTCTRL_MODE_eclipse);
+
+    /* Momentum hysteresis in eclipse */
+    EXPECT(update(SLOW_RADPS, false, MOMENTUM_MID_NMS) == ADCS_MODE_eclipse);
+    EXPECT(update(SLOW_RADPS, false, MOMENTUM_HIGH_NMS) == ADCS_MODE_pointing);
+    EXPECT(update(SLOW_RADPS, false, MOMENTUM_LOW_NMS) == ADCS_MODE_eclipse);
+
+    /* Sunrise */
+    EXPECT(update(MID_RADPS, true, MOMENTUM_LOW_NMS) == ADCS_MODE_pointing);
+
+    /* Tumbling from pointing and eclipse */
+    EXPECT(update(FAST_RADPS, true, 0.0f) == ADCS_MODE_detumble);
+    EXPECT(ATTCTRL_get_mode() == ATTCTRL_MODE_detumble);
+    EXPECT(MODE_command(ADCS_MODE_eclipse) == 0);
+    EXPECT(update(FAST_RADPS, false, 0.0f) == ADCS_MODE_detumble);
+
+    /* Detumbled in the dark goes straight to eclipse */
+    for (i = 0; i < 49; i++)
+    {
+        EXPECT(update(SLOW_RADPS, false, 0.0f) == ADCS_MODE_detumble);
+    }
+    EXPECT(update(SLOW_RADPS, false, 0.0f) == ADCS_MODE_eclipse);
+
+    /* Re-entering detumble restarts the exit count */
+    EXPECT(MODE_command(ADCS_MODE_detumble) == 0);
+    for (i = 0; i < 49; i++)
+    {
+        EXPECT(update(SLOW_RADPS, true, 0.0f) == ADCS_MODE_detumble);
+    }
+    EXPECT(MODE_command(ADCS_MODE_detumble) == 0);
+    EXPECT(update(SLOW_RADPS, true, 0.0f) == ADCS_MODE_detumble);
+
+    /* Commanding idle turns the actuators off */
+    EXPECT(MODE_command(ADCS_MODE_idle) == 0);
+    EXPECT(ATTCTRL_get_mode() == ATTCTRL_MODE_off);
+    EXPECT(ATTCTRL_get_wheel_momentum_Nms() == 0.0f);
+
+    /* Profiles */
+    const ADCS_MODE_profile_t *p = MODE_get_profile(ADCS_MODE_burnwire);
+    EXPECT(p->imu_period_ms == 0 && p->magtom_period_ms == 0);
+    EXPECT(p->sunsen_period_ms == 0 && !p->control_loop);
+    p = MODE_get_profile(ADCS_MODE_eclipse);
+    EXPECT(p->magtom_period_ms == 0 && p->control_loop);
+    p = MODE_get_profile(ADCS_MODE_pointing);
+    EXPECT(p->imu_period_ms == ATTCTRL_LOOP_PERIOD_MS && p->control_loop);
+
+    /* Names */
+    for (i = 0; i < ADCS_MODE_cnt; i++)
+    {
+        EXPECT((int)MODE_from_string(MODE_to_string((ADCS_MODE_t)i)) == i);
+    }
+    EXPECT(MODE_from_string("sleeping") == ADCS_MODE_cnt);
+
+    char buf[100];
+    JW_t w;
+    JW_init(&w, buf, sizeof(buf));
+    EXPECT(MODE_to_json(&w) == 0);
+    EXPECT(JW_finish(&w) == 0);
+    EXPECT(strstr(buf, "\"idle\"") != NULL);
+    JW_init(&w, buf, 10);
+    EXPECT(MODE_to_json(&w) == 1);
+
+    return 0;
+}
@@ -0,0 +1,442 @@
+/**
+ * @file nadir_pointing_orbit.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Closed loop simulation of the mode manager and attitude controller
+ * over one orbit.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ * @note The plant is a rigid body with 3 orthogonal reaction wheels in a
+ * circular 400 km orbit with a dipole geomagnetic field, gravity gradient and
+ * residual dipole disturbances, and an eclipse when the sun is behind the
+ * earth. The satellite starts tumbling and is commanded to detumble. The test
+ * checks that the mode manager goes through detumble -> pointing -> eclipse
+ * on its own and that the nadir pointing error stays inside the LORIS
+ * requirement once the attitude is acquired.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "adcs_modes.h"
+#include "attitude_control.h"
+#include "quaternion.h"
+#include "test_expect.h"
+
+#define PI (3.14159265358979)
+#define DEG_PER_RAD (180.0 / PI)
+
+#define EARTH_RADIUS_M (6371.0e3)
+#define EARTH_MU (3.986004418e14)
+#define EARTH_B0_T (3.12e-5)
+#define EARTH_DIPOLE_TILT_RAD (11.0 * PI / 180.0)
+#define ORBIT_ALTITUDE_M (400.0e3)
+#define ORBIT_INCLINATION_RAD (51.6 * PI / 180.0)
+
+/* Plant properties, deliberately different from the controller's model */
+#define PLANT_INERTIA_X (0.0215)
+#define PLANT_INERTIA_Y (0.0198)
+#define PLANT_INERTIA_Z (0.0064)
+#define PLANT_RESIDUAL_DIPOLE_AM2 (2.0e-3)
+
+#define SIM_SUBSTEPS (10)
+#define SIM_JITTER_US (2000u)
+
+/* Sensor noise (1 sigma) */
+#define NOISE_ATTITUDE_RAD (0.1 * PI / 180.0)
+#define NOISE_RATE_RADPS (1.0e-4)
+#define NOISE_BFIELD_T (5.0e-8)
+
+/* Pass criteria */
+#define SETTLE_TIME_S (1500.0)
+#define POINTING_REQUIREMENT_DEG (5.0)
+
+
+typedef struct
+{
+    double x;
+    double y;
+    double z;
+} dvec3;
+
+
+static uint32_t rng_state = 0x1234ABCDu;
+
+
+static double rng_uniform(void)
+{
+    /* xorshift32, deterministic across platforms */
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return (rng_state + 1.0) / 4294967297.0;
+}
+
+
+static double rng_gauss(double sigma)
+{
+    double u1 = rng_uniform();
+    double u2 = rng_uniform();
+    return sigma * sqrt(-2.0 * log(u1)) * cos(2.0 * PI * u2);
+}
+
+
+static dvec3 dvec3_make(double x, double y, double z)
+{
+    dvec3 v = {x, y, z};
+    return v;
+}
+
+
+static dvec3 dvec3_add(dvec3 a, dvec3 b)
+{
+    return dvec3_make(a.x + b.x, a.y + b.y, a.z + b.z);
+}
+
+
+static dvec3 dvec3_scale(dvec3 a, double k)
+{
+    return dvec3_make(a.x * k, a.y * k, a.z * k);
+}
+
+
+static double dvec3_dot(dvec3 a, dvec3 b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+
+static dvec3 dvec3_cross(dvec3 a, dvec3 b)
+{
+    return dvec3_make(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z,
+                      a.x * b.y - a.y * b.x);
+}
+
+
+static dvec3 dvec3_unit(dvec3 a)
+{
+    return dvec3_scale(a, 1.0 / sqrt(dvec3_dot(a, a)));
+}
+
+
+static vec3_t to_vec3(dvec3 a)
+{
+    vec3_t v = {(float)a.x, (float)a.y, (float)a.z};
+    return v;
+}
+
+
+static dvec3 to_dvec3(vec3_t a)
+{
+    return dvec3_make(a.x, a.y, a.z);
+}
+
+
+/* Body attitude quaternion is propagated in double precision */
+typedef struct
+{
+    double w;
+    double x;
+    double y;
+    double z;
+} dquat;
+
+
+static dquat dquat_mul(dquat a, dquat b)
+{
+    dquat r = {
+        a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z,
+        a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+        a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+        a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+    };
+    return r;
+}
+
+
+static dvec3 dquat_rotate(dquat q, dvec3 v)
+{
+    dquat p  = {0.0, v.x, v.y, v.z};
+    dquat qc = {q.w, -q.x, -q.y, -q.z};
+    dquat r  = dquat_mul(dquat_mul(q, p), qc);
+    return dvec3_make(r.x, r.y, r.z);
+}
+
+
+static dvec3 dquat_rotate_inv(dquat q, dvec3 v)
+{
+    dquat qc = {q.w, -q.x, -q.y, -q.z};
+    return dquat_rotate(qc, v);
+}
+
+
+static dquat dquat_integrate(dquat q, dvec3 w, double dt)
+{
+    /* exact exponential map for constant rate over dt */
+    double n = sqrt(dvec3_dot(w, w));
+    dquat  dq;
+    if (n * dt < 1e-12)
+    {
+        dq.w = 1.0;
+        dq.x = 0.5 * w.x * dt;
+        dq.y = 0.5 * w.y * dt;
+        dq.z = 0.5 * w.z * dt;
+    }
+    else
+    {
+        double s = sin(0.5 * n * dt) / n;
+        dq.w     = cos(0.5 * n * dt);
+        dq.x     = w.x * s;
+        dq.y     = w.y * s;
+        dq.z     = w.z * s;
+    }
+    dquat  r   = dquat_mul(q, dq);
+    double mag = sqrt(r.w * r.w + r.x * r.x + r.y * r.y + r.z * r.z);
+    r.w /= mag;
+    r.x /= mag;
+    r.y /= mag;
+    r.z /= mag;
+    return r;
+}
+
+
+static void orbit_state(double t, double rate, dvec3 *r, dvec3 *v)
+{
+    /* Circular orbit, ascending node on the inertial x axis (towards the
+     * sun) so the eclipse is as long as it can be */
+    double radius = EARTH_RADIUS_M + ORBIT_ALTITUDE_M;
+    double u      = rate * t + 0.5 * PI;
+    double ci     = cos(ORBIT_INCLINATION_RAD);
+    double si     = sin(ORBIT_INCLINATION_RAD);
+    *r = dvec3_make(radius * cos(u), radius * sin(u) * ci, radius * sin(u) * si);
+    *v = dvec3_make(-radius * rate * sin(u), radius * rate * cos(u) * ci,
+                    radius * rate * cos(u) * si);
+}
+
+
+static dvec3 geomagnetic_field(dvec3 r)
+{
+    dvec3  m_hat = dvec3_make(sin(EARTH_DIPOLE_TILT_RAD), 0.0,
+                             -cos(EARTH_DIPOLE_TILT_RAD));
+    double rn    = sqrt(dvec3_dot(r, r));
+    dvec3  r_hat = dvec3_scale(r, 1.0 / rn);
+    double k     = EARTH_B0_T * pow(EARTH_RADIUS_M / rn, 3.0);
+    dvec3  b     = dvec3_add(dvec3_scale(r_hat, 3.0 * dvec3_dot(m_hat, r_hat)),
+                        dvec3_scale(m_hat, -1.0));
+    return dvec3_scale(b, k);
+}
+
+
+static int sun_visible(dvec3 r)
+{
+    dvec3 sun = dvec3_make(1.0, 0.0, 0.0);
+    if (dvec3_dot(r, sun) > 0.0)
+    {
+        return 1;
+    }
+    dvec3 perp = dvec3_add(r, dvec3_scale(sun, -dvec3_dot(r, sun)));
+    return dvec3_dot(perp, perp) > EARTH_RADIUS_M * EARTH_RADIUS_M;
+}
+
+
+/* Nadir frame: z towards earth, x along velocity, y opposite orbit normal */
+static quat_t nadir_frame(dvec3 r, dvec3 v, dvec3 *z_nadir)
+{
+    dvec3 z = dvec3_unit(dvec3_scale(r, -1.0));
+    dvec3 y = dvec3_unit(dvec3_cross(z, v));
+    dvec3 x = dvec3_cross(y, z);
+    *z_nadir = z;
+    return QUAT_from_axes(to_vec3(x), to_vec3(y), to_vec3(z));
+}
+
+
+int main(void)
+{
+    const double J[3]  = {PLANT_INERTIA_X, PLANT_INERTIA_Y, PLANT_INERTIA_Z};
+    const double dt    = ATTCTRL_LOOP_PERIOD_MS / 1000.0;
+    const double h     = dt / SIM_SUBSTEPS;
+    const double rn    = EARTH_RADIUS_M + ORBIT_ALTITUDE_M;
+    const double w0    = sqrt(EARTH_MU / (rn * rn * rn));
+    const double T     = 2.0 * PI / w0;
+    const long   steps = (long)(T / dt);
+
+    dquat q  = {0.8, 0.4, -0.3, 0.3387};
+    dvec3 w  = dvec3_make(0.035, -0.026, 0.017); /* ~2.5 deg/s tumble */
+    dvec3 hw = dvec3_make(0.0, 0.0, 0.0);
+    {
+        double n = sqrt(q.w * q.w + q.x * q.x + q.y * q.y + q.z * q.z);
+        q.w /= n;
+        q.x /= n;
+        q.y /= n;
+        q.z /= n;
+    }
+
+    MODE_init();
+    if (MODE_get() != ADCS_MODE_BOOT || MODE_command(ADCS_MODE_detumble))
+    {
+        printf("FAIL : could not command detumble\n");
+        return 1;
+    }
+
+    ATTCTRL_output_t out      = {0};
+    uint32_t         now_us   = 0;
+    int              visited[ADCS_MODE_cnt] = {0};
+    int              sequence_ok = 1;
+    ADCS_MODE_t      prev_mode   = ADCS_MODE_detumble;
+    double           acquire_s   = -1.0;
+    double           err_max_deg = 0.0;
+    double           err_sq_sum  = 0.0;
+    long             err_cnt     = 0;
+    long             executed    = 0;
+
+    for (long k = 0; k < steps; k++)
+    {
+        double t = k * dt;
+        dvec3  r, v;
+        orbit_state(t, w0, &r, &v);
+
+        dvec3  z_nadir;
+        quat_t q_ref = nadir_frame(r, v, &z_nadir);
+        vec3_t w_ref = {0.0f, (float)-w0, 0.0f};
+        ATTCTRL_set_reference(q_ref, w_ref);
+
+        dvec3 b_inertial = geomagnetic_field(r);
+        dvec3 b_body     = dquat_rotate_inv(q, b_inertial);
+
+        /* Loop timing with random scheduling jitter. The schedule starts
+         * from the first (unjittered) iteration so every call is due */
+        uint32_t jitter = (uint32_t)(rng_uniform() * SIM_JITTER_US);
+        now_us          = (uint32_t)(k * (uint64_t)ATTCTRL_LOOP_PERIOD_US);
+        if (k == 0)
+        {
+            jitter = 0;
+        }
+        if (!ATTCTRL_loop_due(now_us + jitter))
+        {
+            printf("FAIL : control iteration %ld was not due\n", k);
+            return 1;
+        }
+        executed++;
+
+        /* Noisy sensors */
+        ATTCTRL_input_t in;
+        dquat           dqn = {1.0, rng_gauss(NOISE_ATTITUDE_RAD) * 0.5,
+                     rng_gauss(NOISE_ATTITUDE_RAD) * 0.5,
+                     rng_gauss(NOISE_ATTITUDE_RAD) * 0.5};
+        dquat           qm  = dquat_mul(q, dqn);
+        in.q_body.w         = (float)qm.w;
+        in.q_body.x         = (float)qm.x;
+        in.q_body.y         = (float)qm.y;
+        in.q_body.z         = (float)qm.z;
+        in.q_body           = QUAT_normalize(in.q_body);
+        in.rate_radps.x     = (float)(w.x + rng_gauss(NOISE_RATE_RADPS));
+        in.rate_radps.y     = (float)(w.y + rng_gauss(NOISE_RATE_RADPS));
+        in.rate_radps.z     = (float)(w.z + rng_gauss(NOISE_RATE_RADPS));
+        in.bfield_T.x       = (float)(b_body.x + rng_gauss(NOISE_BFIELD_T));
+        in.bfield_T.y       = (float)(b_body.y + rng_gauss(NOISE_BFIELD_T));
+        in.bfield_T.z       = (float)(b_body.z + rng_gauss(NOISE_BFIELD_T));
+        in.sun_visible      = sun_visible(r);
+        in.wheel_radps.x    = (float)(hw.x / ATTCTRL_WHEEL_INERTIA_KGM2);
+        in.wheel_radps.y    = (float)(hw.y / ATTCTRL_WHEEL_INERTIA_KGM2);
+        in.wheel_radps.z    = (float)(hw.z / ATTCTRL_WHEEL_INERTIA_KGM2);
+        in.wheel_measured   = ATTCTRL_WHEEL_X_MSK | ATTCTRL_WHEEL_Y_MSK |
+                            ATTCTRL_WHEEL_Z_MSK;
+
+        ATTCTRL_step(&in, &out);
+
+        ADCS_MODE_inputs_t guards;
+        guards.rate_radps   = VEC3_norm(in.rate_radps);
+        guards.sun_visible  = in.sun_visible;
+        guards.momentum_Nms = ATTCTRL_get_wheel_momentum_Nms();
+        ADCS_MODE_t mode    = MODE_update(&guards);
+
+        if (mode != prev_mode)
+        {
+            printf("t = %7.1f s : %s -> %s\n", t, MODE_to_string(prev_mode),
+                   MODE_to_string(mode));
+            if (prev_mode == ADCS_MODE_detumble && acquire_s < 0.0)
+            {
+                acquire_s = t;
+            }
+            if (mode == ADCS_MODE_eclipse && !visited[ADCS_MODE_pointing])
+            {
+                sequence_ok = 0;
+            }
+            prev_mode = mode;
+        }
+        visited[mode] = 1;
+
+        /* Wheels ramp linearly to their new setpoint over the period */
+        dvec3 hw_cmd = dvec3_scale(to_dvec3(out.wheel_speed_radps),
+                                   ATTCTRL_WHEEL_INERTIA_KGM2);
+        if (out.mode == ATTCTRL_MODE_detumble)
+        {
+            hw_cmd = hw;
+        }
+        dvec3 hw_dot = dvec3_scale(dvec3_add(hw_cmd, dvec3_scale(hw, -1.0)),
+                                   1.0 / dt);
+        dvec3 dipole = dvec3_add(to_dvec3(out.dipole_Am2),
+                                 dvec3_make(PLANT_RESIDUAL_DIPOLE_AM2, 0.0, 0.0));
+
+        for (int s = 0; s < SIM_SUBSTEPS; s++)
+        {
+            dvec3 r_body = dquat_rotate_inv(q, dvec3_unit(r));
+            dvec3 Jr = dvec3_make(J[0] * r_body.x, J[1] * r_body.y,
+                                  J[2] * r_body.z);
+            dvec3 tau_gg = dvec3_scale(dvec3_cross(r_body, Jr), 3.0 * w0 * w0);
+            dvec3 tau_m  = dvec3_cross(dipole, b_body);
+            dvec3 Jw = dvec3_make(J[0] * w.x, J[1] * w.y, J[2] * w.z);
+            dvec3 H  = dvec3_add(Jw, hw);
+            dvec3 rhs = dvec3_add(dvec3_add(tau_gg, tau_m),
+                                  dvec3_scale(dvec3_add(dvec3_cross(w, H), hw_dot),
+                                              -1.0));
+            w  = dvec3_add(w, dvec3_make(rhs.x / J[0] * h, rhs.y / J[1] * h,
+                                        rhs.z / J[2] * h));
+            hw = dvec3_add(hw, dvec3_scale(hw_dot, h));
+            q  = dquat_integrate(q, w, h);
+        }
+
+        /* Nadir pointing error : angle between body +z and nadir */
+        if (acquire_s >= 0.0 && t > SETTLE_TIME_S)
+        {
+            dvec3  z_body = dquat_rotate(q, dvec3_make(0.0, 0.0, 1.0));
+            double c      = dvec3_dot(z_body, z_nadir);
+            c             = c > 1.0 ? 1.0 : (c < -1.0 ? -1.0 : c);
+            double err    = acos(c) * DEG_PER_RAD;
+            err_sq_sum += err * err;
+            err_cnt++;
+            if (err > err_max_deg)
+            {
+                err_max_deg = err;
+            }
+        }
+    }
+
+    ATTCTRL_loop_stats_t stats;
+    ATTCTRL_get_loop_stats(&stats);
+
+    double err_rms_deg = err_cnt ? sqrt(err_sq_sum / err_cnt) : 0.0;
+    double hw_norm     = sqrt(dvec3_dot(hw, hw));
+    printf("orbit period          : %.1f s (%ld loop iterations)\n", T, executed);
+    printf("attitude acquired at  : %.1f s\n", acquire_s);
+    printf("pointing error        : rms %.3f deg, max %.3f deg\n", err_rms_deg,
+           err_max_deg);
+    printf("final wheel momentum  : %.3e Nms\n", hw_norm);
+    printf("loop jitter           : mean %lu us, max %lu us, overruns %lu\n",
+           (unsigned long)stats.jitter_mean_us,
+           (unsigned long)stats.jitter_max_us, (unsigned long)stats.overruns);
+    printf("loop period           : min %lu us, max %lu us\n",
+           (unsigned long)stats.period_min_us,
+           (unsigned long)stats.period_max_us);
+
+    /* The figures the checks use are printed above */
+    EXPECT(visited[ADCS_MODE_detumble] && visited[ADCS_MODE_pointing] &&
+           visited[ADCS_MODE_eclipse] && sequence_ok);
+    EXPECT(acquire_s >= 0.0 && acquire_s <= SETTLE_TIME_S);
+    EXPECT(err_cnt != 0 && err_max_deg <= POINTING_REQUIREMENT_DEG);
+    EXPECT(stats.jitter_max_us < SIM_JITTER_US && stats.overruns == 0);
+    return 0;
+}
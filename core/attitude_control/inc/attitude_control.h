@@ -0,0 +1,188 @@
+/**
+ * @file attitude_control.h
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Nadir pointing attitude controller. Reaction wheels provide the
+ * pointing torque and the magnetorquers dump accumulated wheel momentum.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ * @note The controller is hardware independent. ATTCTRL_step consumes one
+ * set of sensor measurements and produces actuator commands in SI units so it
+ * can be closed around a simulated plant on the native build.
+ * ATTCTRL_apply writes the commands to the flight actuators and
+ * ATTCTRL_read_wheels reads the wheel tachometers into the measurements.
+ */
+#ifndef __ATTITUDE_CONTROL_H__
+#define __ATTITUDE_CONTROL_H__
+#ifdef __cplusplus
+/* clang-format off */
+extern "C"
+{
+/* clang-format on */
+#endif /* Start C linkage */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "attitude_types.h"
+#include "json_writer.h"
+
+/* Fixed control loop period */
+#define ATTCTRL_LOOP_PERIOD_MS (100u)
+#define ATTCTRL_LOOP_PERIOD_US ((ATTCTRL_LOOP_PERIOD_MS) * (1000u))
+
+/** @todo UPDATE WITH THE MEASURED MASS PROPERTIES OF THE FLIGHT UNIT */
+#define ATTCTRL_INERTIA_X_KGM2 (0.0200f)
+#define ATTCTRL_INERTIA_Y_KGM2 (0.0210f)
+#define ATTCTRL_INERTIA_Z_KGM2 (0.0060f)
+
+/** @todo UPDATE WITH THE REACTION WHEEL DATASHEET VALUES */
+#define ATTCTRL_WHEEL_INERTIA_KGM2 (1.0e-5f)
+#define ATTCTRL_WHEEL_SPEED_MAX_RADPS (628.0f) /* 6000 rpm */
+#define ATTCTRL_WHEEL_TORQUE_MAX_NM (1.0e-3f)
+
+/* Bits of ATTCTRL_input_t wheel_measured, in the order of REAC_WHEEL_t */
+#define ATTCTRL_WHEEL_X_MSK (1u << 0)
+#define ATTCTRL_WHEEL_Y_MSK (1u << 1)
+#define ATTCTRL_WHEEL_Z_MSK (1u << 2)
+
+/** @todo UPDATE WITH THE MEASURED MAGNETORQUER COIL CONSTANT */
+#define ATTCTRL_DIPOLE_MAX_AM2 (0.2f)
+
+typedef enum
+{
+    ATTCTRL_MODE_off,      /* wheels stopped, magnetorquers off */
+    ATTCTRL_MODE_detumble, /* B-dot on magnetorquers, wheels hold speed */
+    ATTCTRL_MODE_pointing, /* wheel pointing + magnetorquer momentum dump */
+    ATTCTRL_MODE_eclipse,  /* wheel pointing only */
+} ATTCTRL_MODE_t;
+
+typedef struct
+{
+    quat_t  q_body;         /* attitude of the body in the reference frame */
+    vec3_t  rate_radps;     /* body angular rate, body frame */
+    vec3_t  bfield_T;       /* geomagnetic field, body frame */
+    bool    sun_visible;    /* true when any sun sensor face is illuminated */
+    vec3_t  wheel_radps;    /* wheel speeds timed by the tachometers */
+    uint8_t wheel_measured; /* ATTCTRL_WHEEL_x_MSK of the timed wheels */
+} ATTCTRL_input_t;
+
+typedef struct
+{
+    ATTCTRL_MODE_t mode;
+    vec3_t         torque_Nm;         /* body torque requested from wheels */
+    vec3_t         wheel_speed_radps; /* wheel speed setpoints */
+    vec3_t         dipole_Am2;        /* magnetorquer dipole setpoint */
+    float          pointing_error_rad;
+} ATTCTRL_output_t;
+
+typedef struct
+{
+    uint32_t count;          /* number of loop iterations executed */
+    uint32_t overruns;       /* iterations that missed a whole period */
+    uint32_t jitter_max_us;  /* worst lateness with respect to schedule */
+    uint32_t jitter_mean_us; /* mean lateness with respect to schedule */
+    uint32_t period_min_us;  /* shortest measured period */
+    uint32_t period_max_us;  /* longest measured period */
+} ATTCTRL_loop_stats_t;
+
+
+/**
+ * @brief Reset the controller state. The control law is reset to off.
+ */
+void ATTCTRL_init(void);
+
+
+/**
+ * @brief Select the control law executed by ATTCTRL_step.
+ *
+ * @note Mode sequencing is owned by the ADCS mode manager (adcs_modes.h).
+ */
+void ATTCTRL_set_mode(ATTCTRL_MODE_t mode);
+
+
+/**
+ * @brief Set the attitude that the controller tracks.
+ *
+ * @param q_ref nadir (LVLH) frame attitude in the reference frame
+ * @param rate_ref_radps angular rate of the nadir frame, expressed in the
+ * nadir frame (0, -orbit_rate, 0 for a circular orbit)
+ */
+void ATTCTRL_set_reference(quat_t q_ref, vec3_t rate_ref_radps);
+
+
+/**
+ * @brief Execute one iteration of the control law.
+ *
+ * @note The wheel speeds integrated by the law start from the measured speed
+ * of every wheel in in->wheel_measured. The others keep the previous
+ * setpoint, the driver regulates to it when the wheel is too slow to time.
+ *
+ * @param in sensor measurements for this iteration
+ * @param out actuator commands for this iteration
+ */
+void ATTCTRL_step(const ATTCTRL_input_t *in, ATTCTRL_output_t *out);
+
+
+ATTCTRL_MODE_t ATTCTRL_get_mode(void);
+
+
+const char *ATTCTRL_mode_to_string(ATTCTRL_MODE_t mode);
+
+
+/**
+ * @brief Magnitude of the angular momentum stored in the reaction wheels
+ */
+float ATTCTRL_get_wheel_momentum_Nms(void);
+
+
+/**
+ * @brief Check if the next control iteration is due and update the loop
+ * timing statistics if it is.
+ *
+ * @param now_us free running microsecond timestamp (wraps)
+ * @return true if the caller should execute a control iteration
+ */
+bool ATTCTRL_loop_due(uint32_t now_us);
+
+
+void ATTCTRL_get_loop_stats(ATTCTRL_loop_stats_t *stats);
+
+
+/**
+ * @brief Serialize the controller mode and loop timing statistics
+ *
+ * @return 0 on success, 1 if w is full
+ */
+int ATTCTRL_status_to_json(JW_t *w);
+
+
+/**
+ * @brief Write the actuator setpoints of one control iteration to the
+ * reaction wheels and magnetorquers
+ */
+void ATTCTRL_apply(const ATTCTRL_output_t *out);
+
+
+/**
+ * @brief Stop the reaction wheels and de-energize the magnetorquers
+ */
+void ATTCTRL_actuators_off(void);
+
+
+/**
+ * @brief Fill the measured wheel speeds of in from the wheel tachometers.
+ * Call once per control iteration, a wheel is timed from the edges since
+ * the previous call
+ */
+void ATTCTRL_read_wheels(ATTCTRL_input_t *in);
+
+
+#ifdef __cplusplus
+/* clang-format off */
+}
+/* clang-format on */
+#endif /* End C linkage */
+#endif /* __ATTITUDE_CONTROL_H__ */
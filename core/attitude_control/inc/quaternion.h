@@ -0,0 +1,74 @@
+/**
+ * @file quaternion.h
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Single precision vector and quaternion math for the attitude control
+ * library
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ */
+#ifndef __QUATERNION_H__
+#define __QUATERNION_H__
+#ifdef __cplusplus
+/* clang-format off */
+extern "C"
+{
+/* clang-format on */
+#endif /* Start C linkage */
+
+#include "attitude_types.h"
+
+vec3_t VEC3_add(vec3_t a, vec3_t b);
+vec3_t VEC3_sub(vec3_t a, vec3_t b);
+vec3_t VEC3_scale(vec3_t v, float k);
+vec3_t VEC3_cross(vec3_t a, vec3_t b);
+float  VEC3_dot(vec3_t a, vec3_t b);
+float  VEC3_norm(vec3_t v);
+
+/**
+ * @brief Clamp each component of v to [-limit, +limit]
+ */
+vec3_t VEC3_clamp(vec3_t v, float limit);
+
+quat_t QUAT_identity(void);
+quat_t QUAT_conj(quat_t q);
+quat_t QUAT_mul(quat_t a, quat_t b);
+quat_t QUAT_normalize(quat_t q);
+
+/**
+ * @brief Rotate v from the frame described by q into the parent frame
+ * (q * v * q')
+ */
+vec3_t QUAT_rotate(quat_t q, vec3_t v);
+
+/**
+ * @brief Rotate v from the parent frame into the frame described by q
+ * (q' * v * q)
+ */
+vec3_t QUAT_rotate_inv(quat_t q, vec3_t v);
+
+/**
+ * @brief Build a quaternion from the columns of a direction cosine matrix.
+ * Each column is a frame axis expressed in the parent frame.
+ */
+quat_t QUAT_from_axes(vec3_t x_axis, vec3_t y_axis, vec3_t z_axis);
+
+/**
+ * @brief Propagate q by body rate w over dt seconds (first order)
+ */
+quat_t QUAT_integrate(quat_t q, vec3_t w, float dt);
+
+/**
+ * @brief Principal rotation angle between two attitudes
+ * @return angle in radians, in [0, pi]
+ */
+float QUAT_angle_between(quat_t a, quat_t b);
+
+#ifdef __cplusplus
+/* clang-format off */
+}
+/* clang-format on */
+#endif /* End C linkage */
+#endif /* __QUATERNION_H__ */
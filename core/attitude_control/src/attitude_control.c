@@ -0,0 +1,431 @@
+/**
+ * @file attitude_control.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Nadir pointing attitude controller. Reaction wheels provide the
+ * pointing torque and the magnetorquers dump accumulated wheel momentum.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ * @note Control laws:
+ *
+ *  OFF      : Wheels stopped, magnetorquers off.
+ *
+ *  DETUMBLE : B-dot. m = -K_bdot * dB/dt on the magnetorquers, wheels hold
+ *             their current speed.
+ *
+ *  POINTING : Quaternion feedback on the wheels,
+ *             u = -Kp * sign(qe0) * qe_vec - Kd * (w - w_ref),
+ *             written as u = -Kd * (w - w_ref - w_cmd) with
+ *             w_cmd = -(Kp/Kd) * sign(qe0) * qe_vec limited to the maximum
+ *             slew rate so large angle acquisitions do not spin the body up
+ *             past the detumble threshold.
+ *             h_wheel_dot = -(u + w x (J*w + h_wheel)).
+ *             Magnetorquers dump wheel momentum with
+ *             m = K_dump * (h_wheel x B) / |B|^2 which produces the external
+ *             torque m x B = -K_dump * h_wheel (perpendicular to B).
+ *
+ *  ECLIPSE  : Wheel pointing law only. Magnetorquers are switched off to
+ *             save power while the panels are dark.
+ *
+ *  The wheel speeds start every iteration from the tachometer measurements,
+ *  so the gyroscopic coupling and the momentum dump act on the momentum the
+ *  wheels really hold, not on the integral of past commands.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "targets.h"
+#include "attitude_control.h"
+#include "quaternion.h"
+
+#define ATTCTRL_DT_S ((float)(ATTCTRL_LOOP_PERIOD_MS) / 1000.0f)
+
+/* Closed loop bandwidth and damping of the pointing loop */
+#define ATTCTRL_NATURAL_FREQ_RADPS (0.1f)
+#define ATTCTRL_DAMPING_RATIO (0.9f)
+#define ATTCTRL_SLEW_RATE_MAX_RADPS (0.0262f) /* 1.5 deg/s */
+
+/* Gain of the B-dot detumble law [A.m^2 / (T/s)] */
+#define ATTCTRL_BDOT_GAIN (1.0e5f)
+
+/* Gain of the momentum dumping law [1/s] */
+#define ATTCTRL_DUMP_GAIN (1.0e-3f)
+
+/* Dipole is not computed when the field is weaker than this (bad reading) */
+#define ATTCTRL_BFIELD_MIN_T (1.0e-6f)
+
+
+static const vec3_t inertia = {
+    ATTCTRL_INERTIA_X_KGM2,
+    ATTCTRL_INERTIA_Y_KGM2,
+    ATTCTRL_INERTIA_Z_KGM2,
+};
+
+static ATTCTRL_MODE_t mode;
+static quat_t         q_ref;
+static vec3_t         w_ref;
+static vec3_t         wheel_speed;
+static vec3_t         b_prev;
+static bool           b_prev_valid;
+
+static struct
+{
+    bool     started;
+    uint32_t deadline_us;
+    uint32_t last_us;
+    uint64_t jitter_sum_us;
+    ATTCTRL_loop_stats_t stats;
+} loop;
+
+
+static vec3_t ATTCTRL_inertia_mul(vec3_t w);
+static vec3_t ATTCTRL_bdot(vec3_t b);
+static vec3_t ATTCTRL_pointing(const ATTCTRL_input_t *in, float *err_rad);
+static vec3_t ATTCTRL_momentum_dump(vec3_t b);
+static void   ATTCTRL_track_wheels(const ATTCTRL_input_t *in);
+
+
+void ATTCTRL_init(void)
+{
+    mode  = ATTCTRL_MODE_off;
+    q_ref = QUAT_identity();
+    memset(&w_ref, 0, sizeof(w_ref));
+    memset(&wheel_speed, 0, sizeof(wheel_speed));
+    memset(&b_prev, 0, sizeof(b_prev));
+    b_prev_valid = false;
+    memset(&loop, 0, sizeof(loop));
+}
+
+
+void ATTCTRL_set_mode(ATTCTRL_MODE_t new_mode)
+{
+    switch (new_mode)
+    {
+        case ATTCTRL_MODE_off:
+        {
+            memset(&wheel_speed, 0, sizeof(wheel_speed));
+        }
+        break;
+        case ATTCTRL_MODE_detumble:
+        case ATTCTRL_MODE_pointing:
+        case ATTCTRL_MODE_eclipse:
+        {
+            if (mode == ATTCTRL_MODE_off)
+            {
+                /* Loop was not scheduled while off. Restart the timing
+                 * statistics phase instead of counting an overrun */
+                loop.started = false;
+            }
+        }
+        break;
+        default:
+        {
+            CONFIG_ASSERT(0);
+        }
+        break;
+    }
+    b_prev_valid = false;
+    mode         = new_mode;
+}
+
+
+void ATTCTRL_set_reference(quat_t q, vec3_t rate_ref_radps)
+{
+    q_ref = QUAT_normalize(q);
+    w_ref = rate_ref_radps;
+}
+
+
+void ATTCTRL_step(const ATTCTRL_input_t *in, ATTCTRL_output_t *out)
+{
+    CONFIG_ASSERT(NULL != in);
+    CONFIG_ASSERT(NULL != out);
+
+    memset(out, 0, sizeof(*out));
+
+    vec3_t u      = {0};
+    vec3_t dipole = {0};
+    float  err    = 0.0f;
+    ATTCTRL_track_wheels(in);
+    switch (mode)
+    {
+        case ATTCTRL_MODE_off:
+        {
+            memset(&wheel_speed, 0, sizeof(wheel_speed));
+            err = QUAT_angle_between(q_ref, in->q_body);
+        }
+        break;
+        case ATTCTRL_MODE_detumble:
+        {
+            dipole = ATTCTRL_bdot(in->bfield_T);
+            err    = QUAT_angle_between(q_ref, in->q_body);
+        }
+        break;
+        case ATTCTRL_MODE_pointing:
+        {
+            u      = ATTCTRL_pointing(in, &err);
+            dipole = ATTCTRL_momentum_dump(in->bfield_T);
+        }
+        break;
+        case ATTCTRL_MODE_eclipse:
+        {
+            u = ATTCTRL_pointing(in, &err);
+        }
+        break;
+        default:
+        {
+            CONFIG_ASSERT(0);
+        }
+        break;
+    }
+
+    /* The B-dot derivative restarts whenever the law is (re)entered */
+    if (mode != ATTCTRL_MODE_detumble)
+    {
+        b_prev_valid = false;
+    }
+
+    out->mode               = mode;
+    out->torque_Nm          = u;
+    out->wheel_speed_radps  = wheel_speed;
+    out->dipole_Am2         = VEC3_clamp(dipole, ATTCTRL_DIPOLE_MAX_AM2);
+    out->pointing_error_rad = err;
+}
+
+
+ATTCTRL_MODE_t ATTCTRL_get_mode(void)
+{
+    return mode;
+}
+
+
+const char *ATTCTRL_mode_to_string(ATTCTRL_MODE_t m)
+{
+    switch (m)
+    {
+        case ATTCTRL_MODE_off:
+        {
+            return "off";
+        }
+        break;
+        case ATTCTRL_MODE_detumble:
+        {
+            return "detumble";
+        }
+        break;
+        case ATTCTRL_MODE_pointing:
+        {
+            return "pointing";
+        }
+        break;
+        case ATTCTRL_MODE_eclipse:
+        {
+            return "eclipse";
+        }
+        break;
+        default:
+        {
+            return "unknown";
+        }
+        break;
+    }
+}
+
+
+float ATTCTRL_get_wheel_momentum_Nms(void)
+{
+    return VEC3_norm(wheel_speed) * ATTCTRL_WHEEL_INERTIA_KGM2;
+}
+
+
+bool ATTCTRL_loop_due(uint32_t now_us)
+{
+    if (!loop.started)
+    {
+        loop.started             = true;
+        loop.deadline_us         = now_us + ATTCTRL_LOOP_PERIOD_US;
+        loop.last_us             = now_us;
+        if (loop.stats.count == 0)
+        {
+            loop.stats.period_min_us = UINT32_MAX;
+        }
+        return true;
+    }
+
+    /* Signed difference so the comparison survives timestamp wraparound */
+    int32_t late_us = (int32_t)(now_us - loop.deadline_us);
+    if (late_us < 0)
+    {
+        return false;
+    }
+
+    uint32_t period_us = now_us - loop.last_us;
+    loop.last_us       = now_us;
+
+    loop.stats.count++;
+    loop.jitter_sum_us += (uint32_t)late_us;
+    loop.stats.jitter_mean_us = loop.jitter_sum_us / loop.stats.count;
+    if ((uint32_t)late_us > loop.stats.jitter_max_us)
+    {
+        loop.stats.jitter_max_us = (uint32_t)late_us;
+    }
+    if (period_us < loop.stats.period_min_us)
+    {
+        loop.stats.period_min_us = period_us;
+    }
+    if (period_us > loop.stats.period_max_us)
+    {
+        loop.stats.period_max_us = period_us;
+    }
+
+    if ((uint32_t)late_us >= ATTCTRL_LOOP_PERIOD_US)
+    {
+        /* Missed at least one whole period. Re-phase instead of running a
+         * burst of back to back iterations to catch up */
+        loop.stats.overruns++;
+        loop.deadline_us = now_us + ATTCTRL_LOOP_PERIOD_US;
+    }
+    else
+    {
+        loop.deadline_us += ATTCTRL_LOOP_PERIOD_US;
+    }
+    return true;
+}
+
+
+void ATTCTRL_get_loop_stats(ATTCTRL_loop_stats_t *stats)
+{
+    CONFIG_ASSERT(NULL != stats);
+    *stats = loop.stats;
+    if (stats->count == 0)
+    {
+        stats->period_min_us = 0;
+    }
+}
+
+
+int ATTCTRL_status_to_json(JW_t *w)
+{
+    CONFIG_ASSERT(NULL != w);
+    ATTCTRL_loop_stats_t stats;
+    ATTCTRL_get_loop_stats(&stats);
+
+    JW_object_begin(w);
+    JW_key(w, "mode");
+    JW_str(w, ATTCTRL_mode_to_string(mode));
+    JW_key(w, "loops");
+    JW_uint(w, stats.count);
+    JW_key(w, "overruns");
+    JW_uint(w, stats.overruns);
+    JW_key(w, "jitter_us");
+    JW_array_begin(w);
+    JW_uint(w, stats.jitter_mean_us);
+    JW_uint(w, stats.jitter_max_us);
+    JW_array_end(w);
+    JW_key(w, "period_us");
+    JW_array_begin(w);
+    JW_uint(w, stats.period_min_us);
+    JW_uint(w, stats.period_max_us);
+    JW_array_end(w);
+    JW_object_end(w);
+    return JW_error(w);
+}
+
+
+static vec3_t ATTCTRL_inertia_mul(vec3_t w)
+{
+    vec3_t r = {inertia.x * w.x, inertia.y * w.y, inertia.z * w.z};
+    return r;
+}
+
+
+static vec3_t ATTCTRL_bdot(vec3_t b)
+{
+    vec3_t dipole = {0};
+    if (b_prev_valid)
+    {
+        vec3_t bdot = VEC3_scale(VEC3_sub(b, b_prev), 1.0f / ATTCTRL_DT_S);
+        dipole      = VEC3_scale(bdot, -ATTCTRL_BDOT_GAIN);
+    }
+    b_prev       = b;
+    b_prev_valid = true;
+    return dipole;
+}
+
+
+static vec3_t ATTCTRL_pointing(const ATTCTRL_input_t *in, float *err_rad)
+{
+    const float zeta = ATTCTRL_DAMPING_RATIO;
+    const float wn   = ATTCTRL_NATURAL_FREQ_RADPS;
+
+    /* Error quaternion: attitude of the body in the nadir frame */
+    quat_t qe = QUAT_mul(QUAT_conj(q_ref), QUAT_normalize(in->q_body));
+    if (qe.w < 0.0f)
+    {
+        /* Take the short way around */
+        qe.w = -qe.w;
+        qe.x = -qe.x;
+        qe.y = -qe.y;
+        qe.z = -qe.z;
+    }
+    *err_rad = 2.0f * acosf(qe.w > 1.0f ? 1.0f : qe.w);
+
+    /* Rate error with the nadir frame rate expressed in the body frame */
+    vec3_t we = VEC3_sub(in->rate_radps, QUAT_rotate_inv(qe, w_ref));
+
+    /* Gains scale with inertia so every axis has the same bandwidth.
+     * The vector part of qe is sin(theta/2), hence Kp = 2 * J * wn^2 and
+     * Kd = 2 * zeta * wn * J, giving Kp / Kd = wn / zeta */
+    vec3_t qv    = {qe.x, qe.y, qe.z};
+    vec3_t w_cmd = VEC3_clamp(VEC3_scale(qv, -wn / zeta),
+                              ATTCTRL_SLEW_RATE_MAX_RADPS);
+    vec3_t kd    = VEC3_scale(inertia, 2.0f * zeta * wn);
+    vec3_t dw    = VEC3_sub(we, w_cmd);
+    vec3_t u     = {-kd.x * dw.x, -kd.y * dw.y, -kd.z * dw.z};
+
+    /* Wheel momentum rate that produces u, including gyroscopic coupling */
+    vec3_t h_wheel = VEC3_scale(wheel_speed, ATTCTRL_WHEEL_INERTIA_KGM2);
+    vec3_t h_total = VEC3_add(ATTCTRL_inertia_mul(in->rate_radps), h_wheel);
+    vec3_t h_dot   = VEC3_scale(
+        VEC3_add(u, VEC3_cross(in->rate_radps, h_total)), -1.0f);
+    h_dot = VEC3_clamp(h_dot, ATTCTRL_WHEEL_TORQUE_MAX_NM);
+
+    wheel_speed = VEC3_add(wheel_speed,
+                           VEC3_scale(h_dot, ATTCTRL_DT_S /
+                                                 ATTCTRL_WHEEL_INERTIA_KGM2));
+    wheel_speed = VEC3_clamp(wheel_speed, ATTCTRL_WHEEL_SPEED_MAX_RADPS);
+    return u;
+}
+
+
+static vec3_t ATTCTRL_momentum_dump(vec3_t b)
+{
+    vec3_t dipole = {0};
+    float  b2     = VEC3_dot(b, b);
+    if (b2 > ATTCTRL_BFIELD_MIN_T * ATTCTRL_BFIELD_MIN_T)
+    {
+        vec3_t h_wheel = VEC3_scale(wheel_speed, ATTCTRL_WHEEL_INERTIA_KGM2);
+        dipole = VEC3_scale(VEC3_cross(h_wheel, b), ATTCTRL_DUMP_GAIN / b2);
+    }
+    return dipole;
+}
+
+
+static void ATTCTRL_track_wheels(const ATTCTRL_input_t *in)
+{
+    if (in->wheel_measured & ATTCTRL_WHEEL_X_MSK)
+    {
+        wheel_speed.x = in->wheel_radps.x;
+    }
+    if (in->wheel_measured & ATTCTRL_WHEEL_Y_MSK)
+    {
+        wheel_speed.y = in->wheel_radps.y;
+    }
+    if (in->wheel_measured & ATTCTRL_WHEEL_Z_MSK)
+    {
+        wheel_speed.z = in->wheel_radps.z;
+    }
+}
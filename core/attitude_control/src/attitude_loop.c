@@ -0,0 +1,103 @@
+/**
+ * @file attitude_loop.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Binds the attitude controller to the flight actuators and the wheel
+ * tachometers
+ * @version 0.2
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "targets.h"
+#include "attitude_control.h"
+
+#include "reaction_wheels.h"
+#include "magnetorquers.h"
+#include "pwm.h"
+
+#define ATTCTRL_RPH_PER_RADPS (3600.0f)
+
+/* Coil drive per unit dipole, the full supply gives ATTCTRL_DIPOLE_MAX_AM2.
+ * Follows the coil constant through ATTCTRL_DIPOLE_MAX_AM2 */
+#define ATTCTRL_MQTR_MV_PER_AM2 ((PWM_VMAX_MV_float) / (ATTCTRL_DIPOLE_MAX_AM2))
+
+
+static int32_t ATTCTRL_radps_to_rph(float radps);
+static int     ATTCTRL_am2_to_mv(float am2);
+static float   ATTCTRL_clampf(float v, float limit);
+
+
+void ATTCTRL_apply(const ATTCTRL_output_t *out)
+{
+    CONFIG_ASSERT(NULL != out);
+    const vec3_t *w = &out->wheel_speed_radps;
+    RW_set_speed_rph(REAC_WHEEL_x, ATTCTRL_radps_to_rph(w->x));
+    RW_set_speed_rph(REAC_WHEEL_y, ATTCTRL_radps_to_rph(w->y));
+    RW_set_speed_rph(REAC_WHEEL_z, ATTCTRL_radps_to_rph(w->z));
+
+    const vec3_t *m = &out->dipole_Am2;
+    MQTR_set_coil_voltage_mv(MQTR_x, ATTCTRL_am2_to_mv(m->x));
+    MQTR_set_coil_voltage_mv(MQTR_y, ATTCTRL_am2_to_mv(m->y));
+    MQTR_set_coil_voltage_mv(MQTR_z, ATTCTRL_am2_to_mv(m->z));
+}
+
+
+void ATTCTRL_actuators_off(void)
+{
+    ATTCTRL_output_t off;
+    memset(&off, 0, sizeof(off));
+    ATTCTRL_apply(&off);
+}
+
+
+void ATTCTRL_read_wheels(ATTCTRL_input_t *in)
+{
+    CONFIG_ASSERT(NULL != in);
+    int32_t rph[NUM_REACTION_WHEELS];
+
+    in->wheel_measured = 0;
+    REAC_WHEEL_t rw;
+    for (rw = REAC_WHEEL_x; rw <= REAC_WHEEL_z; rw++)
+    {
+        if (RW_get_speed_rph(rw, &rph[rw]) == 0)
+        {
+            in->wheel_measured |= (uint8_t)(1u << rw);
+        }
+    }
+    in->wheel_radps.x = (float)rph[REAC_WHEEL_x] / ATTCTRL_RPH_PER_RADPS;
+    in->wheel_radps.y = (float)rph[REAC_WHEEL_y] / ATTCTRL_RPH_PER_RADPS;
+    in->wheel_radps.z = (float)rph[REAC_WHEEL_z] / ATTCTRL_RPH_PER_RADPS;
+}
+
+
+/* Saturated first, the cast of an out of range float is undefined */
+static int32_t ATTCTRL_radps_to_rph(float radps)
+{
+    radps = ATTCTRL_clampf(radps, ATTCTRL_WHEEL_SPEED_MAX_RADPS);
+    return (int32_t)(radps * ATTCTRL_RPH_PER_RADPS);
+}
+
+
+static int ATTCTRL_am2_to_mv(float am2)
+{
+    am2 = ATTCTRL_clampf(am2, ATTCTRL_DIPOLE_MAX_AM2);
+    return (int)(am2 * ATTCTRL_MQTR_MV_PER_AM2);
+}
+
+
+static float ATTCTRL_clampf(float v, float limit)
+{
+    if (v > limit)
+    {
+        v = limit;
+    }
+    else if (v < -limit)
+    {
+        v = -limit;
+    }
+    return v;
+}
@@ -0,0 +1,204 @@
+/**
+ * @file quaternion.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Single precision vector and quaternion math for the attitude control
+ * library
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ */
+#include <math.h>
+
+#include "quaternion.h"
+
+
+vec3_t VEC3_add(vec3_t a, vec3_t b)
+{
+    vec3_t r = {a.x + b.x, a.y + b.y, a.z + b.z};
+    return r;
+}
+
+
+vec3_t VEC3_sub(vec3_t a, vec3_t b)
+{
+    vec3_t r = {a.x - b.x, a.y - b.y, a.z - b.z};
+    return r;
+}
+
+
+vec3_t VEC3_scale(vec3_t v, float k)
+{
+    vec3_t r = {v.x * k, v.y * k, v.z * k};
+    return r;
+}
+
+
+vec3_t VEC3_cross(vec3_t a, vec3_t b)
+{
+    vec3_t r = {
+        a.y * b.z - a.z * b.y,
+        a.z * b.x - a.x * b.z,
+        a.x * b.y - a.y * b.x,
+    };
+    return r;
+}
+
+
+float VEC3_dot(vec3_t a, vec3_t b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+
+float VEC3_norm(vec3_t v)
+{
+    return sqrtf(VEC3_dot(v, v));
+}
+
+
+static float clampf(float v, float limit)
+{
+    if (v > limit)
+    {
+        return limit;
+    }
+    else if (v < -limit)
+    {
+        return -limit;
+    }
+    return v;
+}
+
+
+vec3_t VEC3_clamp(vec3_t v, float limit)
+{
+    vec3_t r = {clampf(v.x, limit), clampf(v.y, limit), clampf(v.z, limit)};
+    return r;
+}
+
+
+quat_t QUAT_identity(void)
+{
+    quat_t q = {1.0f, 0.0f, 0.0f, 0.0f};
+    return q;
+}
+
+
+quat_t QUAT_conj(quat_t q)
+{
+    quat_t r = {q.w, -q.x, -q.y, -q.z};
+    return r;
+}
+
+
+quat_t QUAT_mul(quat_t a, quat_t b)
+{
+    quat_t r = {
+        a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z,
+        a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+        a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+        a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+    };
+    return r;
+}
+
+
+quat_t QUAT_normalize(quat_t q)
+{
+    float n = sqrtf(q.w * q.w + q.x * q.x + q.y * q.y + q.z * q.z);
+    if (n <= 0.0f)
+    {
+        return QUAT_identity();
+    }
+    quat_t r = {q.w / n, q.x / n, q.y / n, q.z / n};
+    return r;
+}
+
+
+vec3_t QUAT_rotate(quat_t q, vec3_t v)
+{
+    /* v' = v + 2w(u x v) + 2u x (u x v), u = vector part of q */
+    vec3_t u  = {q.x, q.y, q.z};
+    vec3_t t  = VEC3_scale(VEC3_cross(u, v), 2.0f);
+    vec3_t r  = VEC3_add(v, VEC3_scale(t, q.w));
+    return VEC3_add(r, VEC3_cross(u, t));
+}
+
+
+vec3_t QUAT_rotate_inv(quat_t q, vec3_t v)
+{
+    return QUAT_rotate(QUAT_conj(q), v);
+}
+
+
+quat_t QUAT_from_axes(vec3_t x_axis, vec3_t y_axis, vec3_t z_axis)
+{
+    /* Shepperd's method on the matrix whose columns are the frame axes */
+    float  m00 = x_axis.x, m01 = y_axis.x, m02 = z_axis.x;
+    float  m10 = x_axis.y, m11 = y_axis.y, m12 = z_axis.y;
+    float  m20 = x_axis.z, m21 = y_axis.z, m22 = z_axis.z;
+    float  tr  = m00 + m11 + m22;
+    quat_t q;
+    if (tr > 0.0f)
+    {
+        float s = sqrtf(tr + 1.0f) * 2.0f;
+        q.w     = 0.25f * s;
+        q.x     = (m21 - m12) / s;
+        q.y     = (m02 - m20) / s;
+        q.z     = (m10 - m01) / s;
+    }
+    else if (m00 > m11 && m00 > m22)
+    {
+        float s = sqrtf(1.0f + m00 - m11 - m22) * 2.0f;
+        q.w     = (m21 - m12) / s;
+        q.x     = 0.25f * s;
+        q.y     = (m01 + m10) / s;
+        q.z     = (m02 + m20) / s;
+    }
+    else if (m11 > m22)
+    {
+        float s = sqrtf(1.0f + m11 - m00 - m22) * 2.0f;
+        q.w     = (m02 - m20) / s;
+        q.x     = (m01 + m10) / s;
+        q.y     = 0.25f * s;
+        q.z     = (m12 + m21) / s;
+    }
+    else
+    {
+        float s = sqrtf(1.0f + m22 - m00 - m11) * 2.0f;
+        q.w     = (m10 - m01) / s;
+        q.x     = (m02 + m20) / s;
+        q.y     = (m12 + m21) / s;
+        q.z     = 0.25f * s;
+    }
+    return QUAT_normalize(q);
+}
+
+
+quat_t QUAT_integrate(quat_t q, vec3_t w, float dt)
+{
+    /* q_dot = 0.5 * q * [0, w] */
+    quat_t wq   = {0.0f, w.x, w.y, w.z};
+    quat_t qdot = QUAT_mul(q, wq);
+    quat_t r    = {
+        q.w + 0.5f * dt * qdot.w,
+        q.x + 0.5f * dt * qdot.x,
+        q.y + 0.5f * dt * qdot.y,
+        q.z + 0.5f * dt * qdot.z,
+    };
+    return QUAT_normalize(r);
+}
+
+
+float QUAT_angle_between(quat_t a, quat_t b)
+{
+    quat_t e = QUAT_mul(QUAT_conj(a), b);
+    float  w = fabsf(e.w);
+    if (w > 1.0f)
+    {
+        w = 1.0f;
+    }
+    return 2.0f * acosf(w);
+}
@@ -0,0 +1,188 @@
+/**
+ * @file bench_main.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Command line front end of the native micro benchmarks
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ * @note usage: adcs_bench [-o report] [-b baseline] [-t threshold_pct]
+ * [-m min_ms] [prefix]
+ * Runs the cases whose name starts with prefix (all by default) and writes
+ * the report to the file, bench.json by default. The firmware prints to
+ * stdout so the report never goes there. With a baseline, the cases slower
+ * than it by more than threshold_pct (25 by default) are run again, those
+ * still slower after BENCH_CONFIRM_RUNS runs are listed on stderr and the
+ * exit status is 1. Use a Release build: the Debug times mostly
+ * measure the missing optimisations.
+ */
+#if defined(TARGET_MCU)
+#error THE BENCHMARKS ARE INTENDED FOR NATIVE PLATFORMS
+#endif /* #if defined(TARGET_MCU) */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include "bench.h"
+
+#define BENCH_MAIN_ERR (2)
+#define BENCH_MAIN_REPORT_DEFAULT "bench.json"
+
+static BENCH_report_t bench_report;
+static BENCH_report_t bench_baseline;
+
+static uint16_t bench_case_index(const BENCH_case_t *cases, uint16_t cnt,
+                                 const char *name);
+
+
+int main(int argc, char **argv)
+{
+    const char *out_path      = BENCH_MAIN_REPORT_DEFAULT;
+    const char *baseline_path = NULL;
+    double      threshold_pct = BENCH_THRESHOLD_PCT_DEFAULT;
+    uint32_t    min_ms        = BENCH_MIN_MS_DEFAULT;
+    const char *prefix        = "";
+    int         opt;
+    while ((opt = getopt(argc, argv, "o:b:t:m:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'o':
+            {
+                out_path = optarg;
+            }
+            break;
+            case 'b':
+            {
+                baseline_path = optarg;
+            }
+            break;
+            case 't':
+            {
+                threshold_pct = strtod(optarg, NULL);
+            }
+            break;
+            case 'm':
+            {
+                min_ms = (uint32_t)strtoul(optarg, NULL, 0);
+            }
+            break;
+            default:
+            {
+                fprintf(stderr,
+                        "usage: %s [-o report] [-b baseline] "
+                        "[-t threshold_pct] [-m min_ms] [prefix]\n",
+                        argv[0]);
+                return BENCH_MAIN_ERR;
+            }
+            break;
+        }
+    }
+    if (optind < argc)
+    {
+        prefix = argv[optind];
+    }
+
+    /* Read first, a missing baseline should not cost a whole run */
+    if (NULL != baseline_path)
+    {
+        FILE *f = fopen(baseline_path, "r");
+        if (NULL == f || BENCH_read(f, &bench_baseline))
+        {
+            fprintf(stderr, "%s is not a benchmark report\n", baseline_path);
+            if (NULL != f)
+            {
+                fclose(f);
+            }
+            return BENCH_MAIN_ERR;
+        }
+        fclose(f);
+    }
+
+    if (BENCH_cases_init())
+    {
+        fprintf(stderr, "cannot boot the firmware\n");
+        return BENCH_MAIN_ERR;
+    }
+
+    uint16_t            cnt;
+    const BENCH_case_t *cases = BENCH_cases(&cnt);
+    uint16_t            i;
+    for (i = 0; i < cnt && bench_report.cnt < BENCH_RESULT_MAX; i++)
+    {
+        if (0 == strncmp(cases[i].name, prefix, strlen(prefix)))
+        {
+            BENCH_run(&cases[i], min_ms, &bench_report.r[bench_report.cnt++]);
+        }
+    }
+
+    uint8_t pass;
+    for (pass = 1; pass < BENCH_PASSES; pass++)
+    {
+        for (i = 0; i < bench_report.cnt; i++)
+        {
+            BENCH_result_t *r = &bench_report.r[i];
+            BENCH_result_t  again;
+            BENCH_run(&cases[bench_case_index(cases, cnt, r->name)], min_ms,
+                      &again);
+            r->ns = (again.ns < r->ns) ? again.ns : r->ns;
+        }
+    }
+    for (i = 0; i < bench_report.cnt; i++)
+    {
+        const BENCH_result_t *r = &bench_report.r[i];
+        fprintf(stderr, "%-32s %10.1f ns/%s\n", r->name, r->ns, r->per);
+    }
+
+    /* Before the report is written, it keeps the confirmed times */
+    if (NULL != baseline_path)
+    {
+        BENCH_confirm(&bench_baseline, &bench_report, cases, cnt,
+                      threshold_pct, min_ms);
+    }
+
+    FILE *out = fopen(out_path, "w");
+    if (NULL == out)
+    {
+        fprintf(stderr, "cannot write %s\n", out_path);
+        return BENCH_MAIN_ERR;
+    }
+    const int err = BENCH_write(out, &bench_report);
+    if (fclose(out) != 0 || err)
+    {
+        fprintf(stderr, "cannot write %s\n", out_path);
+        return BENCH_MAIN_ERR;
+    }
+
+    if (NULL != baseline_path)
+    {
+        BENCH_cmp_t cmp;
+        BENCH_compare(&bench_baseline, &bench_report, threshold_pct, stderr,
+                      &cmp);
+        fprintf(stderr,
+                "%u regressions, %u improvements over %.1f%%, %u missing, "
+                "%u new\n",
+                cmp.regressions, cmp.improvements, threshold_pct, cmp.missing,
+                cmp.added);
+        if (cmp.regressions > 0)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+
+static uint16_t bench_case_index(const BENCH_case_t *cases, uint16_t cnt,
+                                 const char *name)
+{
+    uint16_t i;
+    for (i = 0; i < cnt && 0 != strcmp(cases[i].name, name); i++)
+    {
+    }
+    return i;
+}
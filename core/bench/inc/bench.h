@@ -0,0 +1,170 @@
+/**
+ * @file bench.h
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Native micro benchmarks of the hot paths of the firmware, with a
+ * stable report format and a comparison against a stored baseline
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ * @note The times are host nanoseconds, they only mean something relative
+ * to a baseline taken on the same machine with the same build type. Each
+ * case is calibrated to run for at least the given time, then timed
+ * BENCH_REPS times and the fastest run is kept: the slower ones measure the
+ * host, not the code. A busy host slows everything down for a while now and
+ * then, longer than a case takes, so the case table is run BENCH_PASSES
+ * times over and each case keeps its fastest pass. Against a baseline, a
+ * case over the threshold gets up to BENCH_CONFIRM_RUNS more runs and is
+ * only a regression if it stays over it every time.
+ *
+ * The report lists one case per line, in the order of the case table:
+ *
+ * {
+ * "format":1,
+ * "results":{
+ * "json_parse.fwVersion":{"ns":1234.5,"per":"op","n":8192},
+ * ...
+ * }
+ * }
+ */
+#ifndef __BENCH_H__
+#define __BENCH_H__
+#ifdef __cplusplus
+/* clang-format off */
+extern "C"
+{
+/* clang-format on */
+#endif /* Start C linkage */
+#if !defined(TARGET_MCU)
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define BENCH_FORMAT (1u)
+
+/* Timed runs of each case once calibrated. Many short runs find a quiet
+ * moment on a busy host more often than a few long ones */
+#define BENCH_REPS (15u)
+
+#define BENCH_MIN_MS_DEFAULT (5u)
+#define BENCH_THRESHOLD_PCT_DEFAULT (25.0)
+
+/* Passes over the case table, a case keeps its fastest */
+#define BENCH_PASSES (3u)
+
+/* Runs a case over the threshold gets to come back under it */
+#define BENCH_CONFIRM_RUNS (5u)
+
+/* Differences under this are timer resolution, even if over the threshold */
+#define BENCH_NOISE_NS (1.0)
+
+#define BENCH_NAME_LEN (48u)
+#define BENCH_RESULT_MAX (64u)
+
+typedef struct
+{
+    const char *name; /* <group>.<case>, never renamed */
+    void (*setup)(const void *arg); /* before the timing, NULL for none */
+    const void *arg;
+    void (*op)(void); /* the operation timed */
+    uint32_t    units; /* units in one op, the result is per unit */
+    const char *per;   /* what a unit is */
+} BENCH_case_t;
+
+typedef struct
+{
+    char     name[BENCH_NAME_LEN];
+    double   ns; /* per unit */
+    char     per[8];
+    uint32_t n; /* ops in a timed run */
+} BENCH_result_t;
+
+typedef struct
+{
+    BENCH_result_t r[BENCH_RESULT_MAX];
+    uint16_t       cnt;
+} BENCH_report_t;
+
+typedef struct
+{
+    uint16_t regressions;  /* slower than the baseline beyond the threshold */
+    uint16_t improvements; /* faster than the baseline beyond the threshold */
+    uint16_t missing;      /* in the baseline only */
+    uint16_t added;        /* not in the baseline */
+} BENCH_cmp_t;
+
+
+/**
+ * @brief Boot the firmware modules the cases run against
+ *
+ * @return int 0 on success
+ */
+int BENCH_cases_init(void);
+
+/**
+ * @brief The case table
+ *
+ * @param cnt receives the number of cases
+ * @return const BENCH_case_t* the cases, in report order
+ */
+const BENCH_case_t *BENCH_cases(uint16_t *cnt);
+
+/**
+ * @brief Calibrate and time one case
+ *
+ * @param c the case
+ * @param min_ms shortest timed run
+ * @param result receives the fastest of BENCH_REPS runs
+ */
+void BENCH_run(const BENCH_case_t *c, uint32_t min_ms,
+               BENCH_result_t *result);
+
+/**
+ * @brief Write a report in the stable format
+ *
+ * @return int 0 on success, 1 on an io error
+ */
+int BENCH_write(FILE *f, const BENCH_report_t *report);
+
+/**
+ * @brief Read back a report written by BENCH_write
+ *
+ * @return int 0 on success, 1 if f holds no report of this format
+ */
+int BENCH_read(FILE *f, BENCH_report_t *report);
+
+/**
+ * @brief Compare a report to a baseline, case by case
+ *
+ * @param threshold_pct slowdown over which a case is a regression
+ * @param log receives a line per case out of the threshold, NULL for none
+ * @param cmp receives the counts
+ */
+void BENCH_compare(const BENCH_report_t *baseline,
+                   const BENCH_report_t *report, double threshold_pct,
+                   FILE *log, BENCH_cmp_t *cmp);
+
+/**
+ * @brief Run the cases of report that are over the threshold again, up to
+ * BENCH_CONFIRM_RUNS times each, and keep their fastest result
+ *
+ * @param cases the case table the report was run from
+ * @param cnt cases in the table
+ * @param min_ms shortest timed run
+ * @return uint16_t cases still over the threshold
+ */
+uint16_t BENCH_confirm(const BENCH_report_t *baseline, BENCH_report_t *report,
+                       const BENCH_case_t *cases, uint16_t cnt,
+                       double threshold_pct, uint32_t min_ms);
+
+#else
+#error THE BENCHMARKS ARE INTENDED FOR NATIVE PLATFORMS
+#endif /* !#if defined(TARGET_MCU) */
+
+#ifdef __cplusplus
+/* clang-format off */
+}
+/* clang-format on */
+#endif /* End C linkage */
+#endif /* __BENCH_H__ */
@@ -0,0 +1,284 @@
+/**
+ * @file iss_bench_main.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Micro benchmarks of the target build, counted in cycles by an
+ * instruction set simulator
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ * @note Built with cmake -DISS_MARKERS=ON when cross compiling and run by
+ * iss_bench.py. Every repetition of a kernel sits between PROF_mark_begin
+ * and PROF_mark_end of its ISS_BENCH_t, the harness reports the cycles of
+ * each kernel and stops at ISS_bench_done. Nothing here waits on a
+ * peripheral, except for the replies of json_parse which need the
+ * transmit flag of the uart set by the harness.
+ */
+#if !defined(TARGET_MCU)
+#error THE SIMULATOR BENCHMARKS RUN ON THE TARGET BUILD
+#endif /* !defined(TARGET_MCU) */
+
+#if !defined(ADCS_ISS_MARKERS)
+#error THE SIMULATOR BENCHMARKS NEED THE MARKS (cmake -DISS_MARKERS=ON)
+#endif /* !defined(ADCS_ISS_MARKERS) */
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include "watchdog.h"
+
+#include "profiling.h"
+#include "json_writer.h"
+#include "jsons.h"
+#include "obc_interface.h"
+#include "obc_frame.h"
+#include "attitude_control.h"
+
+/* Repetitions of each kernel, the harness keeps min / max / mean */
+#define ISS_BENCH_REPS (8u)
+
+/* Operands of the arithmetic kernels */
+#define ISS_BENCH_MAC_LEN (16u)
+
+#define ISS_BENCH_FRAME_PAYLOAD (64u)
+
+/* The harness numbers the kernels in this order */
+typedef enum
+{
+    ISS_BENCH_json_fwVersion, /* json_parse and the framed reply */
+    ISS_BENCH_json_mode,
+    ISS_BENCH_json_bad_key,
+    ISS_BENCH_jw_fixed,       /* 8 values with 3 decimals */
+    ISS_BENCH_jw_float,       /* the same values as float */
+    ISS_BENCH_jw_vsnprintf,   /* the same values through vsnprintf */
+    ISS_BENCH_f32_mac,        /* ISS_BENCH_MAC_LEN multiply accumulates */
+    ISS_BENCH_q15_mac,        /* the same in Q15 on the hardware multiplier */
+    ISS_BENCH_f32_sqrt,
+    ISS_BENCH_frame_encode,   /* ISS_BENCH_FRAME_PAYLOAD bytes */
+    ISS_BENCH_frame_crc,
+    ISS_BENCH_ctrl_detumble,  /* one ATTCTRL_step */
+    ISS_BENCH_ctrl_pointing,
+    ISS_BENCH_cnt,            /* must be last */
+} ISS_BENCH_t;
+
+static void iss_bench_json(ISS_BENCH_t id, const char *cmd);
+static void iss_bench_jw(ISS_BENCH_t id);
+static void iss_bench_arith(void);
+static int  iss_vsnprintf(char *buf, size_t size, const char *fmt, ...);
+static void iss_bench_frame(void);
+static void iss_bench_ctrl(ISS_BENCH_t id, ATTCTRL_MODE_t mode);
+void        ISS_bench_done(void);
+
+static uint8_t iss_cmd[JSON_CMD_LEN_MAX];
+static char    iss_out[OBC_TX_BUFFER_SIZE];
+static uint8_t iss_frame[OBC_FRAME_WIRE_LEN(ISS_BENCH_FRAME_PAYLOAD)];
+static float   iss_f32_a[ISS_BENCH_MAC_LEN];
+static float   iss_f32_b[ISS_BENCH_MAC_LEN];
+static int16_t iss_q15_a[ISS_BENCH_MAC_LEN];
+static int16_t iss_q15_b[ISS_BENCH_MAC_LEN];
+
+/* Results go here so the kernels are not optimised out */
+static volatile float    iss_f32_sink;
+static volatile int32_t  iss_i32_sink;
+static volatile uint16_t iss_u16_sink;
+
+
+int main(void)
+{
+    watchdog_stop();
+    OBC_IF_config(OBC_IF_PHY_CFG_UART);
+    PROF_init();
+
+    iss_bench_json(ISS_BENCH_json_fwVersion, "{\"fwVersion\":\"read\"}");
+    iss_bench_json(ISS_BENCH_json_mode, "{\"mode\":\"read\"}");
+    iss_bench_json(ISS_BENCH_json_bad_key, "{\"bogus\":\"read\"}");
+    iss_bench_jw(ISS_BENCH_jw_fixed);
+    iss_bench_jw(ISS_BENCH_jw_float);
+    iss_bench_jw(ISS_BENCH_jw_vsnprintf);
+    iss_bench_arith();
+    iss_bench_frame();
+    iss_bench_ctrl(ISS_BENCH_ctrl_detumble, ATTCTRL_MODE_detumble);
+    iss_bench_ctrl(ISS_BENCH_ctrl_pointing, ATTCTRL_MODE_pointing);
+
+    ISS_bench_done();
+    for (;;)
+    {
+    }
+}
+
+
+/* The harness stops here */
+__attribute__((noinline)) void ISS_bench_done(void)
+{
+    iss_u16_sink = ISS_BENCH_cnt;
+}
+
+
+static void iss_bench_json(ISS_BENCH_t id, const char *cmd)
+{
+    uint8_t i;
+    strncpy((char *)iss_cmd, cmd, sizeof(iss_cmd) - 1);
+    for (i = 0; i < ISS_BENCH_REPS; i++)
+    {
+        PROF_mark_begin(id);
+        json_parse(iss_cmd);
+        PROF_mark_end(id);
+    }
+}
+
+
+static void iss_bench_jw(ISS_BENCH_t id)
+{
+    static const int32_t milli[] = {
+        0, 1, -1, 12345, -98765, 500, 1000000, -32768,
+    };
+    uint8_t i, k;
+    for (i = 0; i < ISS_BENCH_REPS; i++)
+    {
+        JW_t w;
+        if (id == ISS_BENCH_jw_vsnprintf)
+        {
+            const int32_t *v = milli;
+            PROF_mark_begin(id);
+            iss_u16_sink = (uint16_t)iss_vsnprintf(
+                iss_out, sizeof(iss_out),
+                "[%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f]", v[0] / 1000.0,
+                v[1] / 1000.0, v[2] / 1000.0, v[3] / 1000.0, v[4] / 1000.0,
+                v[5] / 1000.0, v[6] / 1000.0, v[7] / 1000.0);
+            PROF_mark_end(id);
+            continue;
+        }
+
+        JW_init(&w, iss_out, sizeof(iss_out));
+        PROF_mark_begin(id);
+        JW_array_begin(&w);
+        for (k = 0; k < sizeof(milli) / sizeof(*milli); k++)
+        {
+            if (id == ISS_BENCH_jw_fixed)
+            {
+                JW_fixed(&w, milli[k], 3);
+            }
+            else
+            {
+                JW_float(&w, (float)milli[k] / 1000.0f, 3);
+            }
+        }
+        JW_array_end(&w);
+        PROF_mark_end(id);
+        iss_u16_sink = (uint16_t)JW_finish(&w);
+    }
+}
+
+
+/* The way the replies were formatted before the writer */
+static int iss_vsnprintf(char *buf, size_t size, const char *fmt, ...)
+{
+    va_list args;
+    int     len;
+    va_start(args, fmt);
+    len = vsnprintf(buf, size, fmt, args);
+    va_end(args);
+    return len;
+}
+
+
+static void iss_bench_arith(void)
+{
+    uint8_t i, k;
+    for (k = 0; k < ISS_BENCH_MAC_LEN; k++)
+    {
+        iss_f32_a[k] = 0.1f * (float)k - 0.7f;
+        iss_f32_b[k] = 0.9f - 0.05f * (float)k;
+        iss_q15_a[k] = (int16_t)(iss_f32_a[k] * 32767.0f);
+        iss_q15_b[k] = (int16_t)(iss_f32_b[k] * 32767.0f);
+    }
+
+    for (i = 0; i < ISS_BENCH_REPS; i++)
+    {
+        float acc = 0.0f;
+        PROF_mark_begin(ISS_BENCH_f32_mac);
+        for (k = 0; k < ISS_BENCH_MAC_LEN; k++)
+        {
+            acc += iss_f32_a[k] * iss_f32_b[k];
+        }
+        PROF_mark_end(ISS_BENCH_f32_mac);
+        iss_f32_sink = acc;
+    }
+
+    for (i = 0; i < ISS_BENCH_REPS; i++)
+    {
+        int32_t acc = 0;
+        PROF_mark_begin(ISS_BENCH_q15_mac);
+        for (k = 0; k < ISS_BENCH_MAC_LEN; k++)
+        {
+            acc += (int32_t)iss_q15_a[k] * iss_q15_b[k];
+        }
+        PROF_mark_end(ISS_BENCH_q15_mac);
+        iss_i32_sink = acc >> 15;
+    }
+
+    for (i = 0; i < ISS_BENCH_REPS; i++)
+    {
+        const float x = iss_f32_b[i] + 1.0f;
+        PROF_mark_begin(ISS_BENCH_f32_sqrt);
+        const float r = sqrtf(x);
+        PROF_mark_end(ISS_BENCH_f32_sqrt);
+        iss_f32_sink = r;
+    }
+}
+
+
+static void iss_bench_frame(void)
+{
+    const uint16_t head = OBC_FRAME_HEAD(ISS_BENCH_FRAME_PAYLOAD);
+    uint8_t        i;
+    for (i = 0; i < ISS_BENCH_REPS; i++)
+    {
+        memset(&iss_frame[head], 'a' + i, ISS_BENCH_FRAME_PAYLOAD);
+        PROF_mark_begin(ISS_BENCH_frame_encode);
+        iss_u16_sink =
+            OBC_FRAME_encode(iss_frame, head, ISS_BENCH_FRAME_PAYLOAD);
+        PROF_mark_end(ISS_BENCH_frame_encode);
+    }
+
+    for (i = 0; i < ISS_BENCH_REPS; i++)
+    {
+        memset(iss_frame, 'a' + i, ISS_BENCH_FRAME_PAYLOAD);
+        PROF_mark_begin(ISS_BENCH_frame_crc);
+        iss_u16_sink = OBC_FRAME_crc(iss_frame, ISS_BENCH_FRAME_PAYLOAD);
+        PROF_mark_end(ISS_BENCH_frame_crc);
+    }
+}
+
+
+static void iss_bench_ctrl(ISS_BENCH_t id, ATTCTRL_MODE_t mode)
+{
+    const quat_t q_ref    = {1.0f, 0.0f, 0.0f, 0.0f};
+    const vec3_t rate_ref = {0.0f, 0.0f, 0.0f};
+    uint8_t      i;
+
+    ATTCTRL_init();
+    ATTCTRL_set_mode(mode);
+    ATTCTRL_set_reference(q_ref, rate_ref);
+    for (i = 0; i < ISS_BENCH_REPS; i++)
+    {
+        /* Up to 45 degrees off the reference, about a changing axis */
+        const float     s  = 0.1f * (float)i;
+        const float     qn = sqrtf(1.0f + 0.3125f * s * s);
+        ATTCTRL_input_t in = {
+            .q_body      = {1.0f / qn, s / qn, -0.5f * s / qn, 0.25f * s / qn},
+            .rate_radps  = {0.01f * s, -0.02f, 0.015f * (1.0f - s)},
+            .bfield_T    = {2.0e-5f, -1.0e-5f * s, 3.0e-5f},
+            .sun_visible = (i & 1u) != 0,
+        };
+        ATTCTRL_output_t out;
+        PROF_mark_begin(id);
+        ATTCTRL_step(&in, &out);
+        PROF_mark_end(id);
+        iss_f32_sink = out.pointing_error_rad;
+    }
+}
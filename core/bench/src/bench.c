@@ -0,0 +1,258 @@
+/**
+ * @file bench.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Timing, report and comparison of the native micro benchmarks
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ */
+#if defined(TARGET_MCU)
+#error THE BENCHMARKS ARE INTENDED FOR NATIVE PLATFORMS
+#endif /* #if defined(TARGET_MCU) */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "config_assert.h"
+#include "bench.h"
+
+/* Calibration stops doubling here whatever the time */
+#define BENCH_N_MAX (1ul << 30)
+
+#define BENCH_LINE_LEN (160u)
+
+static double                BENCH_run_ns(const BENCH_case_t *c, uint32_t n);
+static const BENCH_result_t *BENCH_find(const BENCH_report_t *report,
+                                        const char *name);
+static bool BENCH_regressed(const BENCH_result_t *base, const BENCH_result_t *r,
+                            double threshold_pct);
+
+
+void BENCH_run(const BENCH_case_t *c, uint32_t min_ms, BENCH_result_t *result)
+{
+    CONFIG_ASSERT(NULL != c);
+    CONFIG_ASSERT(NULL != c->op);
+    CONFIG_ASSERT(NULL != result);
+    CONFIG_ASSERT(c->units > 0);
+
+    if (NULL != c->setup)
+    {
+        c->setup(c->arg);
+    }
+
+    /* Double until one run takes min_ms, it also warms the caches */
+    const double min_ns = min_ms * 1.0e6;
+    uint32_t     n      = 1;
+    while (BENCH_run_ns(c, n) < min_ns && n < BENCH_N_MAX)
+    {
+        n *= 2u;
+    }
+
+    double  best = BENCH_run_ns(c, n);
+    uint8_t rep;
+    for (rep = 1; rep < BENCH_REPS; rep++)
+    {
+        const double ns = BENCH_run_ns(c, n);
+        if (ns < best)
+        {
+            best = ns;
+        }
+    }
+
+    memset(result, 0, sizeof(*result));
+    strncpy(result->name, c->name, sizeof(result->name) - 1);
+    strncpy(result->per, c->per, sizeof(result->per) - 1);
+    result->ns = best / ((double)n * c->units);
+    result->n  = n;
+}
+
+
+int BENCH_write(FILE *f, const BENCH_report_t *report)
+{
+    CONFIG_ASSERT(NULL != f);
+    CONFIG_ASSERT(NULL != report);
+
+    fprintf(f, "{\n\"format\":%u,\n\"results\":{\n", BENCH_FORMAT);
+    uint16_t i;
+    for (i = 0; i < report->cnt; i++)
+    {
+        const BENCH_result_t *r = &report->r[i];
+        fprintf(f, "\"%s\":{\"ns\":%.1f,\"per\":\"%s\",\"n\":%lu}%s\n",
+                r->name, r->ns, r->per, (unsigned long)r->n,
+                (i + 1u < report->cnt) ? "," : "");
+    }
+    fprintf(f, "}\n}\n");
+    return ferror(f) ? 1 : 0;
+}
+
+
+/* Only the files BENCH_write writes, a case per line */
+int BENCH_read(FILE *f, BENCH_report_t *report)
+{
+    CONFIG_ASSERT(NULL != f);
+    CONFIG_ASSERT(NULL != report);
+
+    char     line[BENCH_LINE_LEN];
+    unsigned format = 0;
+    memset(report, 0, sizeof(*report));
+    while (NULL != fgets(line, sizeof(line), f))
+    {
+        BENCH_result_t r;
+        unsigned long  n;
+        memset(&r, 0, sizeof(r));
+        if (sscanf(line, " \"format\":%u", &format) == 1)
+        {
+            continue;
+        }
+        if (sscanf(line,
+                   " \"%47[^\"]\":{\"ns\":%lf,\"per\":\"%7[^\"]\",\"n\":%lu",
+                   r.name, &r.ns, r.per, &n) == 4)
+        {
+            if (report->cnt >= BENCH_RESULT_MAX)
+            {
+                return 1;
+            }
+            r.n                       = (uint32_t)n;
+            report->r[report->cnt++] = r;
+        }
+    }
+    return (format == BENCH_FORMAT) ? 0 : 1;
+}
+
+
+void BENCH_compare(const BENCH_report_t *baseline,
+                   const BENCH_report_t *report, double threshold_pct,
+                   FILE *log, BENCH_cmp_t *cmp)
+{
+    CONFIG_ASSERT(NULL != baseline);
+    CONFIG_ASSERT(NULL != report);
+    CONFIG_ASSERT(NULL != cmp);
+
+    memset(cmp, 0, sizeof(*cmp));
+    uint16_t i;
+    for (i = 0; i < report->cnt; i++)
+    {
+        const BENCH_result_t *r    = &report->r[i];
+        const BENCH_result_t *base = BENCH_find(baseline, r->name);
+        if (NULL == base)
+        {
+            cmp->added++;
+            continue;
+        }
+
+        const double delta = r->ns - base->ns;
+        const double pct   = (base->ns > 0.0) ? 100.0 * delta / base->ns : 0.0;
+        const char * what  = NULL;
+        if (BENCH_regressed(base, r, threshold_pct))
+        {
+            cmp->regressions++;
+            what = "REGRESSION";
+        }
+        else if (-delta > BENCH_NOISE_NS && -pct > threshold_pct)
+        {
+            cmp->improvements++;
+            what = "improved";
+        }
+        if (NULL != log && NULL != what)
+        {
+            fprintf(log, "%-10s %-32s %10.1f -> %10.1f ns/%s (%+.1f%%)\n",
+                    what, r->name, base->ns, r->ns, r->per, pct);
+        }
+    }
+
+    for (i = 0; i < baseline->cnt; i++)
+    {
+        if (NULL == BENCH_find(report, baseline->r[i].name))
+        {
+            cmp->missing++;
+            if (NULL != log)
+            {
+                fprintf(log, "%-10s %s\n", "missing", baseline->r[i].name);
+            }
+        }
+    }
+}
+
+
+/* In rounds over the cases, the runs of a case are spread over the time the
+ * others take rather than back to back in one slow spell of the host */
+uint16_t BENCH_confirm(const BENCH_report_t *baseline, BENCH_report_t *report,
+                       const BENCH_case_t *cases, uint16_t cnt,
+                       double threshold_pct, uint32_t min_ms)
+{
+    CONFIG_ASSERT(NULL != baseline);
+    CONFIG_ASSERT(NULL != report);
+    CONFIG_ASSERT(NULL != cases);
+
+    uint16_t regressions = 0;
+    uint8_t  round;
+    uint16_t i, k;
+    for (round = 0; round <= BENCH_CONFIRM_RUNS; round++)
+    {
+        regressions = 0;
+        for (i = 0; i < report->cnt; i++)
+        {
+            BENCH_result_t *      r    = &report->r[i];
+            const BENCH_result_t *base = BENCH_find(baseline, r->name);
+            if (NULL == base || !BENCH_regressed(base, r, threshold_pct))
+            {
+                continue;
+            }
+            regressions++;
+            for (k = 0; k < cnt && round < BENCH_CONFIRM_RUNS; k++)
+            {
+                if (0 == strcmp(cases[k].name, r->name))
+                {
+                    BENCH_result_t again;
+                    BENCH_run(&cases[k], min_ms, &again);
+                    r->ns = (again.ns < r->ns) ? again.ns : r->ns;
+                }
+            }
+        }
+    }
+    return regressions;
+}
+
+
+static bool BENCH_regressed(const BENCH_result_t *base, const BENCH_result_t *r,
+                            double threshold_pct)
+{
+    const double delta = r->ns - base->ns;
+    const double pct   = (base->ns > 0.0) ? 100.0 * delta / base->ns : 0.0;
+    return (delta > BENCH_NOISE_NS && pct > threshold_pct);
+}
+
+
+static double BENCH_run_ns(const BENCH_case_t *c, uint32_t n)
+{
+    struct timespec start, end;
+    uint32_t        i;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < n; i++)
+    {
+        c->op();
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (end.tv_sec - start.tv_sec) * 1.0e9 +
+           (double)(end.tv_nsec - start.tv_nsec);
+}
+
+
+static const BENCH_result_t *BENCH_find(const BENCH_report_t *report,
+                                        const char *name)
+{
+    uint16_t i;
+    for (i = 0; i < report->cnt; i++)
+    {
+        if (0 == strcmp(report->r[i].name, name))
+        {
+            return &report->r[i];
+        }
+    }
+    return NULL;
+}
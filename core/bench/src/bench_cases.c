@@ -0,0 +1,406 @@
+/**
+ * @file bench_cases.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief The benchmark cases: command parsing, reply formatting, the receive
+ * ring, the ADS7841 conversions and the control law
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ * @note The firmware is booted by the simulator, so the commands run on the
+ * state they would on a board just out of reset. The replies are framed and
+ * transmitted to nowhere, that cost is in the json_parse cases.
+ *
+ * The ADS7841 conversions go through the native HAL to the emulated chips,
+ * the per byte time includes the event the native backend records for each
+ * byte. The trace clock is a counter so it does not add a system call.
+ */
+#if defined(TARGET_MCU)
+#error THE BENCHMARKS ARE INTENDED FOR NATIVE PLATFORMS
+#endif /* #if defined(TARGET_MCU) */
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+
+#include "config_assert.h"
+#include "bench.h"
+#include "sil.h"
+
+#include "jsons.h"
+#include "json_writer.h"
+#include "obc_interface.h"
+#include "obc_frame.h"
+#include "adcs_modes.h"
+#include "attitude_control.h"
+#include "imu.h"
+#include "parameters.h"
+#include "telemetry.h"
+#include "tlm_stream.h"
+#include "isr_monitor.h"
+
+#include "hal.h"
+#include "hal_native.h"
+#include "hal_ads7841.h"
+#include "ads7841_emulator.h"
+
+/* A housekeeping poll in one frame, for the batch and the receive ring */
+#define BENCH_HK_BATCH                                                         \
+    "{\"fwVersion\":\"read\",\"rw_speed\":\"read\",\"magSen\":\"read\","       \
+    "\"imu\":\"read\",\"attCtrl\":\"read\",\"mode\":\"read\"}"
+
+/* Payload of the reply that is framed, a string of 256 characters */
+#define BENCH_REPLY_STR_LEN (256u)
+#define BENCH_REPLY_LEN (BENCH_REPLY_STR_LEN + 2u)
+
+#define BENCH_ADS7841_BYTES_PER_CONV (3u)
+
+/* The values of the number kernels, in thousandths */
+#define BENCH_VALUES_CNT (8u)
+
+/* Inputs the control law cycles through, a tumble about every axis */
+#define BENCH_CTRL_INPUT_CNT (16u)
+
+typedef struct
+{
+    int (*to_json)(JW_t *w);
+} bench_fmt_t;
+
+/* The same values through the writer or through the printf family */
+typedef enum
+{
+    BENCH_VALUES_jw_fixed,
+    BENCH_VALUES_jw_float,
+    BENCH_VALUES_vsnprintf,
+} BENCH_VALUES_t;
+
+static void     bench_json_setup(const void *arg);
+static void     bench_json_op(void);
+static void     bench_fmt_setup(const void *arg);
+static void     bench_fmt_op(void);
+static void     bench_values_setup(const void *arg);
+static void     bench_values_op(void);
+static void     bench_reply_setup(const void *arg);
+static void     bench_reply_op(void);
+static void     bench_ring_setup(const void *arg);
+static void     bench_ring_op(void);
+static void     bench_ads7841_setup(const void *arg);
+static void     bench_ads7841_op(void);
+static void     bench_ctrl_setup(const void *arg);
+static void     bench_ctrl_op(void);
+static int      bench_tx(uint8_t *buf, uint16_t len);
+static uint32_t bench_clock(void);
+static int      bench_param_to_json(JW_t *w);
+static int      bench_vsnprintf(char *buf, size_t size, const char *fmt, ...);
+
+static const bench_fmt_t bench_fmt_mode    = {MODE_to_json};
+static const bench_fmt_t bench_fmt_attctrl = {ATTCTRL_status_to_json};
+static const bench_fmt_t bench_fmt_imu     = {IMU_measurements_to_json};
+static const bench_fmt_t bench_fmt_param   = {bench_param_to_json};
+static const bench_fmt_t bench_fmt_tlm     = {TLM_stream_status_to_json};
+static const bench_fmt_t bench_fmt_isr     = {ISR_MON_to_json};
+
+static const BENCH_VALUES_t bench_values_fixed     = BENCH_VALUES_jw_fixed;
+static const BENCH_VALUES_t bench_values_float     = BENCH_VALUES_jw_float;
+static const BENCH_VALUES_t bench_values_vsnprintf = BENCH_VALUES_vsnprintf;
+
+static const int32_t bench_values_milli[BENCH_VALUES_CNT] = {
+    0, 1, -1, 12345, -98765, 500, 1000000, -32768,
+};
+
+static const ATTCTRL_MODE_t bench_ctrl_detumble = ATTCTRL_MODE_detumble;
+static const ATTCTRL_MODE_t bench_ctrl_pointing = ATTCTRL_MODE_pointing;
+
+static const uint8_t bench_ads7841_channels[HAL_ADS7841_CHANNEL_CNT] = {
+    0, 1, 2, 3, 4, 5, 6, 7,
+};
+static const HAL_GPIO_t bench_ads7841_cs = {HAL_PORT_4, HAL_PIN(1)};
+
+/* clang-format off */
+static const BENCH_case_t bench_cases[] = {
+    /* json_parse per command, the reply included */
+    {"json_parse.fwVersion",  bench_json_setup, "{\"fwVersion\":\"read\"}",  bench_json_op, 1, "op"},
+    {"json_parse.hwVersion",  bench_json_setup, "{\"hwVersion\":\"read\"}",  bench_json_op, 1, "op"},
+    {"json_parse.rw_speed",   bench_json_setup, "{\"rw_speed\":\"read\"}",   bench_json_op, 1, "op"},
+    {"json_parse.rw_current", bench_json_setup, "{\"rw_current\":\"read\"}", bench_json_op, 1, "op"},
+    {"json_parse.mqtr_volts", bench_json_setup, "{\"mqtr_volts\":\"read\"}", bench_json_op, 1, "op"},
+    {"json_parse.sunSen",     bench_json_setup, "{\"sunSen\":\"read\",\"face\":\"z+\"}", bench_json_op, 1, "op"},
+    {"json_parse.magSen",     bench_json_setup, "{\"magSen\":\"read\"}",     bench_json_op, 1, "op"},
+    {"json_parse.magCal",     bench_json_setup, "{\"magCal\":\"read\"}",     bench_json_op, 1, "op"},
+    {"json_parse.imu",        bench_json_setup, "{\"imu\":\"read\"}",        bench_json_op, 1, "op"},
+    {"json_parse.current",    bench_json_setup, "{\"current\":\"mqtr\"}",    bench_json_op, 1, "op"},
+    {"json_parse.attCtrl",    bench_json_setup, "{\"attCtrl\":\"read\"}",    bench_json_op, 1, "op"},
+    {"json_parse.mode",       bench_json_setup, "{\"mode\":\"read\"}",       bench_json_op, 1, "op"},
+    {"json_parse.param",      bench_json_setup, "{\"param\":\"get\",\"name\":\"rw_ma_mv\"}", bench_json_op, 1, "op"},
+    {"json_parse.tlm",        bench_json_setup, "{\"tlm\":\"read\"}",        bench_json_op, 1, "op"},
+    {"json_parse.prof",       bench_json_setup, "{\"prof\":\"read\"}",       bench_json_op, 1, "op"},
+    {"json_parse.isr",        bench_json_setup, "{\"isr\":\"read\"}",        bench_json_op, 1, "op"},
+    {"json_parse.hk_batch",   bench_json_setup, BENCH_HK_BATCH,              bench_json_op, 1, "op"},
+    {"json_parse.bad_key",    bench_json_setup, "{\"bogus\":\"read\"}",      bench_json_op, 1, "op"},
+
+    /* The reply formatting, into a buffer */
+    {"format.mode",           bench_fmt_setup,   &bench_fmt_mode,    bench_fmt_op,   1, "op"},
+    {"format.attCtrl",        bench_fmt_setup,   &bench_fmt_attctrl, bench_fmt_op,   1, "op"},
+    {"format.imu",            bench_fmt_setup,   &bench_fmt_imu,     bench_fmt_op,   1, "op"},
+    {"format.param",          bench_fmt_setup,   &bench_fmt_param,   bench_fmt_op,   1, "op"},
+    {"format.tlm_stream",     bench_fmt_setup,   &bench_fmt_tlm,     bench_fmt_op,   1, "op"},
+    {"format.isr",            bench_fmt_setup,   &bench_fmt_isr,     bench_fmt_op,   1, "op"},
+    {"format.jw_fixed",       bench_values_setup, &bench_values_fixed,     bench_values_op, BENCH_VALUES_CNT, "value"},
+    {"format.jw_float",       bench_values_setup, &bench_values_float,     bench_values_op, BENCH_VALUES_CNT, "value"},
+    {"format.vsnprintf",      bench_values_setup, &bench_values_vsnprintf, bench_values_op, BENCH_VALUES_CNT, "value"},
+    {"format.reply_frame",    bench_reply_setup, NULL,               bench_reply_op, BENCH_REPLY_LEN, "byte"},
+
+    /* Framed command bytes into the receive ring and out of the queue */
+    {"ring.rx_frame",         bench_ring_setup,  BENCH_HK_BATCH,     bench_ring_op,  OBC_FRAME_WIRE_LEN(sizeof(BENCH_HK_BATCH) - 1u), "byte"},
+
+    /* Every channel of a sun sensor face */
+    {"ads7841.spi_byte",      bench_ads7841_setup, NULL, bench_ads7841_op, HAL_ADS7841_CHANNEL_CNT * BENCH_ADS7841_BYTES_PER_CONV, "byte"},
+
+    /* One period of the control law */
+    {"control.detumble",      bench_ctrl_setup, &bench_ctrl_detumble, bench_ctrl_op, 1, "step"},
+    {"control.pointing",      bench_ctrl_setup, &bench_ctrl_pointing, bench_ctrl_op, 1, "step"},
+};
+/* clang-format on */
+
+#define BENCH_CASE_CNT (sizeof(bench_cases) / sizeof(*bench_cases))
+
+static uint8_t     bench_cmd[OBC_RX_FRAME_LEN + 1];
+static char        bench_out[OBC_TX_BUFFER_SIZE];
+static bench_fmt_t bench_fmt;
+
+static BENCH_VALUES_t bench_values;
+
+static char bench_reply_str[BENCH_REPLY_STR_LEN + 1];
+
+static uint8_t  bench_frame[OBC_FRAME_WIRE_LEN(OBC_RX_FRAME_LEN)];
+static uint16_t bench_frame_len;
+
+static uint32_t bench_ticks;
+
+static ATTCTRL_input_t bench_ctrl_in[BENCH_CTRL_INPUT_CNT];
+static uint8_t         bench_ctrl_idx;
+
+
+int BENCH_cases_init(void)
+{
+    SIL_config_t config = SIL_CONFIG_DEFAULT;
+    config.sensor_noise = false;
+    if (SIL_init(&config))
+    {
+        return 1;
+    }
+    OBC_IF_config_native(bench_tx);
+    HAL_NATIVE_set_clock(bench_clock);
+    return 0;
+}
+
+
+const BENCH_case_t *BENCH_cases(uint16_t *cnt)
+{
+    CONFIG_ASSERT(NULL != cnt);
+    *cnt = BENCH_CASE_CNT;
+    return bench_cases;
+}
+
+
+/* jtok does not write to the command, it is parsed again as it is */
+static void bench_json_setup(const void *arg)
+{
+    const char *cmd = arg;
+    CONFIG_ASSERT(strlen(cmd) < sizeof(bench_cmd));
+    strcpy((char *)bench_cmd, cmd);
+}
+
+
+static void bench_json_op(void)
+{
+    json_parse(bench_cmd);
+}
+
+
+static void bench_fmt_setup(const void *arg)
+{
+    bench_fmt = *(const bench_fmt_t *)arg;
+}
+
+
+static void bench_fmt_op(void)
+{
+    JW_t w;
+    JW_init(&w, bench_out, sizeof(bench_out));
+    JW_object_begin(&w);
+    JW_key(&w, "key");
+    bench_fmt.to_json(&w);
+    JW_object_end(&w);
+    JW_finish(&w);
+}
+
+
+static void bench_values_setup(const void *arg)
+{
+    bench_values = *(const BENCH_VALUES_t *)arg;
+}
+
+
+/* An array of 3 decimal numbers, as iss_bench_main.c times it on the target */
+static void bench_values_op(void)
+{
+    const int32_t *v = bench_values_milli;
+    JW_t           w;
+    uint8_t        k;
+    if (bench_values == BENCH_VALUES_vsnprintf)
+    {
+        bench_vsnprintf(bench_out, sizeof(bench_out),
+                        "[%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f]",
+                        v[0] / 1000.0, v[1] / 1000.0, v[2] / 1000.0,
+                        v[3] / 1000.0, v[4] / 1000.0, v[5] / 1000.0,
+                        v[6] / 1000.0, v[7] / 1000.0);
+        return;
+    }
+
+    JW_init(&w, bench_out, sizeof(bench_out));
+    JW_array_begin(&w);
+    for (k = 0; k < BENCH_VALUES_CNT; k++)
+    {
+        if (bench_values == BENCH_VALUES_jw_fixed)
+        {
+            JW_fixed(&w, v[k], 3);
+        }
+        else
+        {
+            JW_float(&w, (float)v[k] / 1000.0f, 3);
+        }
+    }
+    JW_array_end(&w);
+    JW_finish(&w);
+}
+
+
+static void bench_reply_setup(const void *arg)
+{
+    (void)arg;
+    memset(bench_reply_str, 'a', BENCH_REPLY_STR_LEN);
+    bench_reply_str[BENCH_REPLY_STR_LEN] = '\0';
+}
+
+
+/* The writer and the framing of a reply that has no escapes */
+static void bench_reply_op(void)
+{
+    JW_t *w = OBC_IF_reply_begin();
+    JW_str(w, bench_reply_str);
+    OBC_IF_reply_send(w);
+}
+
+
+static void bench_ring_setup(const void *arg)
+{
+    const char *   cmd  = arg;
+    const uint16_t len  = (uint16_t)strlen(cmd);
+    const uint16_t head = OBC_FRAME_HEAD(OBC_RX_FRAME_LEN);
+    CONFIG_ASSERT(len <= OBC_RX_FRAME_LEN);
+    memcpy(&bench_frame[head], cmd, len);
+    bench_frame_len = OBC_FRAME_encode(bench_frame, head, len);
+    CONFIG_ASSERT(bench_frame_len == OBC_FRAME_WIRE_LEN(len));
+}
+
+
+static void bench_ring_op(void)
+{
+    uint16_t i;
+    for (i = 0; i < bench_frame_len; i++)
+    {
+        OBC_IF_receive_byte(bench_frame[i]);
+    }
+    OCB_IF_get_command_string(bench_cmd, sizeof(bench_cmd));
+}
+
+
+static void bench_ads7841_setup(const void *arg)
+{
+    (void)arg;
+    uint8_t ch;
+    for (ch = 0; ch < HAL_ADS7841_CHANNEL_CNT; ch++)
+    {
+        ADS7841_EMU_set_channel(ADS7841_EMU_DEV_sun_z_pos, ch,
+                                (uint16_t)(0x555u * ch));
+    }
+    HAL_ADS7841_init_cs(&bench_ads7841_cs);
+}
+
+
+static void bench_ads7841_op(void)
+{
+    uint16_t counts[HAL_ADS7841_CHANNEL_CNT];
+    HAL_ADS7841_measure(&bench_ads7841_cs, bench_ads7841_channels, counts,
+                        HAL_ADS7841_CHANNEL_CNT);
+}
+
+
+static void bench_ctrl_setup(const void *arg)
+{
+    const quat_t q_ref    = {1.0f, 0.0f, 0.0f, 0.0f};
+    const vec3_t rate_ref = {0.0f, 0.0f, 0.0f};
+    uint8_t      i;
+
+    ATTCTRL_init();
+    ATTCTRL_set_mode(*(const ATTCTRL_MODE_t *)arg);
+    ATTCTRL_set_reference(q_ref, rate_ref);
+    for (i = 0; i < BENCH_CTRL_INPUT_CNT; i++)
+    {
+        /* Up to 80 degrees off the reference, about a changing axis */
+        const float     s  = 0.05f * (float)i;
+        const float     qn = sqrtf(1.0f + 0.3125f * s * s);
+        ATTCTRL_input_t in = {
+            .q_body      = {1.0f / qn, s / qn, -0.5f * s / qn, 0.25f * s / qn},
+            .rate_radps  = {0.01f * s, -0.02f, 0.015f * (1.0f - s)},
+            .bfield_T    = {2.0e-5f, -1.0e-5f * s, 3.0e-5f},
+            .sun_visible = (i & 1u) != 0,
+        };
+        bench_ctrl_in[i] = in;
+    }
+    bench_ctrl_idx = 0;
+}
+
+
+static void bench_ctrl_op(void)
+{
+    ATTCTRL_output_t out;
+    ATTCTRL_step(&bench_ctrl_in[bench_ctrl_idx], &out);
+    bench_ctrl_idx = (uint8_t)((bench_ctrl_idx + 1u) % BENCH_CTRL_INPUT_CNT);
+}
+
+
+static int bench_tx(uint8_t *buf, uint16_t len)
+{
+    (void)buf;
+    return len;
+}
+
+
+static uint32_t bench_clock(void)
+{
+    return bench_ticks++;
+}
+
+
+static int bench_param_to_json(JW_t *w)
+{
+    return PARAM_to_json(PARAM_rw_ma_mv, w);
+}
+
+
+/* The way the replies were formatted before the writer */
+static int bench_vsnprintf(char *buf, size_t size, const char *fmt, ...)
+{
+    va_list args;
+    int     len;
+    va_start(args, fmt);
+    len = vsnprintf(buf, size, fmt, args);
+    va_end(args);
+    return len;
+}
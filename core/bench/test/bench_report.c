@@ -0,0 +1,138 @@
+/**
+ * @file bench_report.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Test the benchmark report: it reads back as written, and the
+ * comparison flags only what is over the threshold and over the noise
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ */
+#if defined(TARGET_MCU)
+#error NATIVE TESTS CANNOT BE RUN ON A BARE METAL MICROCONTROLLER
+#endif /* #if defined(TARGET_MCU) */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "bench.h"
+#include "test_expect.h"
+
+static BENCH_report_t report;
+static BENCH_report_t again;
+static BENCH_report_t baseline;
+
+
+static void set(BENCH_report_t *rep, const char *name, double ns)
+{
+    BENCH_result_t *r = &rep->r[rep->cnt++];
+    memset(r, 0, sizeof(*r));
+    strncpy(r->name, name, sizeof(r->name) - 1);
+    strncpy(r->per, "op", sizeof(r->per) - 1);
+    r->ns = ns;
+    r->n  = 1;
+}
+
+
+int main(void)
+{
+    uint16_t            cnt;
+    const BENCH_case_t *cases = BENCH_cases(&cnt);
+    uint16_t            i, j;
+
+    /* The names are the keys of the baseline */
+    EXPECT(cnt > 0 && cnt <= BENCH_RESULT_MAX);
+    for (i = 0; i < cnt; i++)
+    {
+        EXPECT(strchr(cases[i].name, '.') != NULL);
+        EXPECT(strlen(cases[i].name) < BENCH_NAME_LEN);
+        EXPECT(strlen(cases[i].per) < sizeof(report.r[i].per));
+        EXPECT(cases[i].units > 0);
+        for (j = 0; j < i; j++)
+        {
+            EXPECT(strcmp(cases[i].name, cases[j].name) != 0);
+        }
+    }
+
+    /* Every case runs on the booted firmware, once per timed run */
+    EXPECT(BENCH_cases_init() == 0);
+    for (i = 0; i < cnt; i++)
+    {
+        BENCH_run(&cases[i], 0, &report.r[report.cnt++]);
+        EXPECT(report.r[i].n == 1);
+        EXPECT(report.r[i].ns > 0.0);
+    }
+
+    /* Reads back as written, to the precision of the report */
+    FILE *f = tmpfile();
+    EXPECT(f != NULL);
+    EXPECT(BENCH_write(f, &report) == 0);
+    rewind(f);
+    EXPECT(BENCH_read(f, &again) == 0);
+    fclose(f);
+    EXPECT(again.cnt == report.cnt);
+    for (i = 0; i < report.cnt; i++)
+    {
+        EXPECT(strcmp(again.r[i].name, report.r[i].name) == 0);
+        EXPECT(strcmp(again.r[i].per, report.r[i].per) == 0);
+        EXPECT(again.r[i].n == report.r[i].n);
+        EXPECT(again.r[i].ns > report.r[i].ns - 0.051);
+        EXPECT(again.r[i].ns < report.r[i].ns + 0.051);
+    }
+
+    /* A file of another format is not a baseline */
+    f = tmpfile();
+    EXPECT(f != NULL);
+    fprintf(f, "{\n\"format\":2,\n\"results\":{\n}\n}\n");
+    rewind(f);
+    EXPECT(BENCH_read(f, &again) == 1);
+    fclose(f);
+
+    /* Over the threshold both ways, under it, under the noise, new and
+     * missing cases */
+    BENCH_cmp_t cmp;
+    memset(&baseline, 0, sizeof(baseline));
+    memset(&report, 0, sizeof(report));
+    set(&baseline, "a.slower", 100.0);
+    set(&report, "a.slower", 115.0);
+    set(&baseline, "a.faster", 100.0);
+    set(&report, "a.faster", 80.0);
+    set(&baseline, "a.same", 100.0);
+    set(&report, "a.same", 109.0);
+    set(&baseline, "a.tiny", 2.0);
+    set(&report, "a.tiny", 2.9);
+    set(&baseline, "a.gone", 10.0);
+    set(&report, "a.new", 10.0);
+    BENCH_compare(&baseline, &report, 10.0, stdout, &cmp);
+    EXPECT(cmp.regressions == 1);
+    EXPECT(cmp.improvements == 1);
+    EXPECT(cmp.missing == 1);
+    EXPECT(cmp.added == 1);
+
+    BENCH_compare(&baseline, &report, 20.0, NULL, &cmp);
+    EXPECT(cmp.regressions == 0);
+    EXPECT(cmp.improvements == 0);
+
+    /* Against itself there is nothing to report */
+    BENCH_compare(&report, &report, 0.0, NULL, &cmp);
+    EXPECT(cmp.regressions == 0 && cmp.improvements == 0);
+    EXPECT(cmp.missing == 0 && cmp.added == 0);
+
+    /* Only the cases over the threshold run again, a case that cannot come
+     * back under it stays a regression */
+    memset(&baseline, 0, sizeof(baseline));
+    memset(&report, 0, sizeof(report));
+    set(&baseline, cases[0].name, 1.0e-3);
+    set(&report, cases[0].name, 1.0e9);
+    set(&baseline, cases[1].name, 1.0e9);
+    set(&report, cases[1].name, 1.0e3);
+    EXPECT(BENCH_confirm(&baseline, &report, cases, cnt, 25.0, 0) == 1);
+    EXPECT(report.r[0].ns < 1.0e9);
+    EXPECT(report.r[1].ns == 1.0e3);
+
+    printf("PASS\n");
+    return 0;
+}
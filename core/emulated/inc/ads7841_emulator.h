@@ -0,0 +1,93 @@
+/**
+ * @file ads7841_emulator.h
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Emulated ADS7841 converters for native builds
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ * @note Every chip select on the board has its own converter. The values on
+ * their inputs are set by a test or by the plant of the simulator and read
+ * back by the core modules over the native HAL spi, which clocks bytes into
+ * the converter whose chip select is low.
+ */
+#ifndef __ADS7841_EMULATOR_H__
+#define __ADS7841_EMULATOR_H__
+#ifdef __cplusplus
+/* clang-format off */
+extern "C"
+{
+/* clang-format on */
+#endif /* Start C linkage */
+#if !defined(TARGET_MCU)
+
+#include <stdint.h>
+
+/* Full scale of a 12 bit conversion */
+#define ADS7841_EMU_COUNTS_MAX (4095u)
+
+/* Single ended and differential inputs, same order as ADS7841_CHANNEL_t */
+#define ADS7841_EMU_CHANNEL_CNT (8u)
+
+typedef enum
+{
+    ADS7841_EMU_DEV_magtom,    /* magnetometer, P2.7 */
+    ADS7841_EMU_DEV_mqtr,      /* magnetorquer current sense */
+    ADS7841_EMU_DEV_rw,        /* reaction wheel current sense, P5.0 */
+    ADS7841_EMU_DEV_sun_x_pos, /* sun sensor faces, one chip each */
+    ADS7841_EMU_DEV_sun_x_neg,
+    ADS7841_EMU_DEV_sun_y_pos,
+    ADS7841_EMU_DEV_sun_y_neg,
+    ADS7841_EMU_DEV_sun_z_pos,
+    ADS7841_EMU_DEV_sun_z_neg,
+    ADS7841_EMU_DEV_cnt, /* must be last */
+} ADS7841_EMU_DEV_t;
+
+
+/**
+ * @brief Set every input of every converter to 0 counts
+ */
+void ADS7841_EMU_init(void);
+
+/**
+ * @brief Set what a conversion of ch on dev returns
+ *
+ * @param counts clipped to ADS7841_EMU_COUNTS_MAX
+ */
+void ADS7841_EMU_set_channel(ADS7841_EMU_DEV_t dev, uint8_t ch,
+                             uint16_t counts);
+
+/**
+ * @brief Convert ch on dev
+ *
+ * @return uint16_t the counts last set, 0 for a channel out of range
+ */
+uint16_t ADS7841_EMU_measure_channel(ADS7841_EMU_DEV_t dev, uint8_t ch);
+
+/**
+ * @brief Clock one byte on the spi of dev
+ *
+ * @note A control byte (start bit set) latches a conversion of its channel,
+ * the next two bytes shift the result out after the busy clock, the same as
+ * a 24 clock conversion in the datasheet
+ *
+ * @return uint8_t the byte on MISO
+ */
+uint8_t ADS7841_EMU_spi_transfer(ADS7841_EMU_DEV_t dev, uint8_t mosi);
+
+/**
+ * @brief Chip select of dev released, abort a conversion in progress
+ */
+void ADS7841_EMU_spi_deselect(ADS7841_EMU_DEV_t dev);
+
+#else
+#error EMULATION OF HARDWARE IS INTENDED FOR TESTING ON NATIVE PLATFORMS
+#endif /* !#if defined(TARGET_MCU) */
+
+#ifdef __cplusplus
+/* clang-format off */
+}
+/* clang-format on */
+#endif /* End C linkage */
+#endif /* __ADS7841_EMULATOR_H__ */
@@ -0,0 +1,75 @@
+#ifndef __BNO055_EMULATOR_H__
+#define __BNO055_EMULATOR_H__
+#ifdef __cplusplus
+/* clang-format off */
+extern "C"
+{
+/* clang-format on */
+#endif /* Start C linkage */
+#if !defined(TARGET_MCU)
+
+#include <stdint.h>
+
+/* Register addresses from section 4.2 of the BNO055 datasheet */
+#define BNO055_EMU_CHIP_ID_ADDR (0x00)
+#define BNO055_EMU_PAGE_ID_ADDR (0x07)
+#define BNO055_EMU_ACCEL_DATA_X_LSB_ADDR (0x08)
+#define BNO055_EMU_MAG_DATA_X_LSB_ADDR (0x0E)
+#define BNO055_EMU_GYRO_DATA_X_LSB_ADDR (0x14)
+#define BNO055_EMU_QUATERNION_DATA_W_LSB_ADDR (0x20)
+#define BNO055_EMU_SYS_STATUS_ADDR (0x39)
+#define BNO055_EMU_OPR_MODE_ADDR (0x3D)
+#define BNO055_EMU_PWR_MODE_ADDR (0x3E)
+#define BNO055_EMU_SYS_TRIGGER_ADDR (0x3F)
+
+#define BNO055_EMU_CHIP_ID (0xA0)
+#define BNO055_EMU_PAGE_SIZE (0x80)
+#define BNO055_EMU_PAGE_CNT (2)
+
+/**
+ * @brief Attach an emulated BNO055 to the emulated I2C bus.
+ *
+ * The model implements the page select, the read only and writable registers
+ * of page 0, the operating mode / system status handshake and the system
+ * reset trigger. Sensor data registers are driven by the setters below.
+ *
+ * @param dev_addr 7 bit address (0x28 or 0x29)
+ * @return 0 on success, 1 if the address could not be attached
+ */
+int BNO055_EMU_attach(uint8_t dev_addr);
+
+/**
+ * @brief Set the fused quaternion registers (1 unit == 16384 LSB)
+ */
+void BNO055_EMU_set_quaternion(int16_t w, int16_t x, int16_t y, int16_t z);
+
+/**
+ * @brief Set the gyroscope registers (1 dps == 16 LSB)
+ */
+void BNO055_EMU_set_gyro(int16_t x, int16_t y, int16_t z);
+
+/**
+ * @brief Set the accelerometer registers (1 m/s^2 == 100 LSB)
+ */
+void BNO055_EMU_set_accel(int16_t x, int16_t y, int16_t z);
+
+/**
+ * @brief Set the magnetometer registers (1 uT == 16 LSB)
+ */
+void BNO055_EMU_set_mag(int16_t x, int16_t y, int16_t z);
+
+/**
+ * @brief Direct access to a register for test assertions
+ */
+uint8_t BNO055_EMU_get_register(uint8_t page, uint8_t reg);
+
+#else
+#error EMULATION OF HARDWARE IS INTENDED FOR TESTING ON NATIVE PLATFORMS
+#endif /* !#if defined(TARGET_MCU) */
+
+#ifdef __cplusplus
+/* clang-format off */
+}
+/* clang-format on */
+#endif /* End C linkage */
+#endif /* __BNO055_EMULATOR_H__ */
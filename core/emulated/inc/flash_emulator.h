@@ -0,0 +1,133 @@
+/**
+ * @file flash_emulator.h
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Emulated msp430 information memory for native builds
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ * @note Same contract as the target flash driver (flash.h): erase sets a
+ * segment to 0xFF and programming can only clear bits. The memory can be
+ * backed by a file so its contents survive the process (an emulated power
+ * cycle), and a power loss can be injected part way through an erase or
+ * program operation.
+ */
+#ifndef __FLASH_EMULATOR_H__
+#define __FLASH_EMULATOR_H__
+#ifdef __cplusplus
+/* clang-format off */
+extern "C"
+{
+/* clang-format on */
+#endif /* Start C linkage */
+#if !defined(TARGET_MCU)
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "flash_types.h"
+
+/* Guaranteed erase/program cycles per segment (slas590n, flash memory) */
+#define FLASH_EMU_ENDURANCE_CYCLES (100000u)
+
+/**
+ * @brief Erase every segment, clear the erase counters and power loss
+ * injection. Detaches the backing files.
+ */
+void FLASH_EMU_init(void);
+
+const uint8_t *FLASH_EMU_info_segment(FLASH_INFO_t seg);
+
+/**
+ * @brief Erase a segment. Fails once the segment has been erased
+ * FLASH_EMU_ENDURANCE_CYCLES times.
+ */
+int FLASH_EMU_info_erase(FLASH_INFO_t seg);
+
+int FLASH_EMU_info_write(FLASH_INFO_t seg, uint16_t offset, const void *data,
+                         uint16_t len);
+
+/**
+ * @brief Number of times a segment has been erased since FLASH_EMU_init
+ */
+uint32_t FLASH_EMU_erase_count(FLASH_INFO_t seg);
+
+
+/**
+ * @brief Back the information memory with a file.
+ *
+ * An existing image is loaded, otherwise the file is created from the
+ * current memory contents. Every later erase and program is written through
+ * to the file.
+ *
+ * @return 0 on success, 1 if the file could not be opened or has the wrong
+ * size
+ */
+int FLASH_EMU_attach_file(const char *path);
+
+
+/**
+ * @brief Stop writing through to the backing file and close it
+ */
+void FLASH_EMU_detach_file(void);
+
+
+/**
+ * @brief Lose power after byte_ops more bytes have been erased or programmed.
+ *
+ * An erase is modelled as erasing the segment one byte at a time. The
+ * operation in progress when power is lost stops part way and returns an
+ * error, as do all operations after it until FLASH_EMU_power_restore.
+ */
+void FLASH_EMU_power_loss_after(uint32_t byte_ops);
+
+
+/**
+ * @brief Restore power and cancel a pending power loss
+ */
+void FLASH_EMU_power_restore(void);
+
+bool FLASH_EMU_power_lost(void);
+
+
+const uint8_t *FLASH_EMU_log_segment(uint16_t seg);
+
+/**
+ * @brief Erase a telemetry log segment. Same endurance limit and power loss
+ * behaviour as the information memory
+ */
+int FLASH_EMU_log_erase(uint16_t seg);
+
+int FLASH_EMU_log_write(uint16_t seg, uint16_t offset, const void *data,
+                        uint16_t len);
+
+uint32_t FLASH_EMU_log_erase_count(uint16_t seg);
+
+
+/**
+ * @brief Back the telemetry log region with a memory mapped file.
+ *
+ * A file of the right size is mapped as is, anything else is (re)created
+ * erased. Erases and writes then go straight to the mapping.
+ *
+ * @return 0 on success, 1 if the file could not be created or mapped
+ */
+int FLASH_EMU_log_map_file(const char *path);
+
+
+/**
+ * @brief Sync and unmap the backing file. The log region keeps its contents
+ */
+void FLASH_EMU_log_unmap_file(void);
+
+#else
+#error EMULATION OF HARDWARE IS INTENDED FOR TESTING ON NATIVE PLATFORMS
+#endif /* !#if defined(TARGET_MCU) */
+
+#ifdef __cplusplus
+/* clang-format off */
+}
+/* clang-format on */
+#endif /* End C linkage */
+#endif /* __FLASH_EMULATOR_H__ */
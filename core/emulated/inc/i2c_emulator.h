@@ -0,0 +1,157 @@
+#ifndef __I2C_EMULATOR_H__
+#define __I2C_EMULATOR_H__
+#ifdef __cplusplus
+/* clang-format off */
+extern "C"
+{
+/* clang-format on */
+#endif /* Start C linkage */
+#if !defined(TARGET_MCU)
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "i2c_types.h"
+
+/* Bus clock used to model the time spent on the wire */
+#define I2C_EMU_SCL_FREQ (100000u)
+
+/**
+ * @brief A device on the emulated bus. The callbacks follow the wire level
+ * protocol so any register protocol can be modelled on top of them.
+ */
+typedef struct
+{
+    void *ctx; /* passed to every callback */
+
+    /* (repeated) start addressed to this device. read is true for SLA+R */
+    void (*start)(void *ctx, bool read);
+
+    /* master wrote a byte. Return false to NACK it */
+    bool (*write)(void *ctx, uint8_t byte);
+
+    /* master reads a byte */
+    uint8_t (*read)(void *ctx);
+
+    /* stop condition. Optional */
+    void (*stop)(void *ctx);
+} I2C_EMU_device_t;
+
+
+/**
+ * @brief Generic register mapped device (BNO055, most sensors and EEPROMs).
+ *
+ * The first byte written after a start selects the register. Further
+ * written bytes are stored starting at that register and reads return
+ * registers starting at that register. The register pointer auto-increments
+ * after each access.
+ */
+typedef struct I2C_EMU_regmap
+{
+    uint8_t *      regs;
+    uint16_t       size;     /* number of addressable registers */
+    const uint8_t *writable; /* non zero entries are writable, NULL == all */
+
+    /* called after a register write. Optional */
+    void (*on_write)(struct I2C_EMU_regmap *map, uint8_t reg, uint8_t value);
+    void *ctx;
+
+    /* Owned by the emulator */
+    uint8_t ptr;
+    bool    ptr_pending; /* next written byte is the register address */
+} I2C_EMU_regmap_t;
+
+
+typedef enum
+{
+    I2C_EMU_FAULT_none = 0,
+    I2C_EMU_FAULT_nack,             /* slave NACKs the byte */
+    I2C_EMU_FAULT_arbitration_lost, /* another master wins the bus */
+    I2C_EMU_FAULT_stuck_bus,        /* slave holds SCL low until timeout */
+} I2C_EMU_FAULT_t;
+
+
+typedef struct
+{
+    uint32_t transactions;
+    uint32_t bytes; /* address and data bytes on the wire */
+    uint32_t nacks;
+    uint32_t arbitration_lost;
+    uint32_t timeouts;
+    uint64_t bus_time_us; /* modelled time the bus was busy */
+} I2C_EMU_stats_t;
+
+
+/**
+ * @brief Detach all devices and clear faults and statistics
+ */
+void I2C_EMU_init(void);
+
+/**
+ * @brief Attach a device to the emulated bus
+ *
+ * @param dev_addr 7 bit address
+ * @param dev device. Copied, but the ctx must outlive the attachment
+ * @return 0 on success, 1 if the address is invalid or already in use
+ */
+int I2C_EMU_attach(uint8_t dev_addr, const I2C_EMU_device_t *dev);
+
+void I2C_EMU_detach(uint8_t dev_addr);
+
+/**
+ * @brief Build a device from a register map
+ *
+ * @param map register map. Must outlive the device
+ * @param dev device to initialize
+ */
+void I2C_EMU_regmap_device(I2C_EMU_regmap_t *map, I2C_EMU_device_t *dev);
+
+/**
+ * @brief Inject a fault into the next transaction
+ *
+ * @param fault fault to inject. One shot
+ * @param wire_byte index of the byte on the wire (address bytes included)
+ * at which the fault occurs. 0 is the first address byte
+ */
+void I2C_EMU_inject_fault(I2C_EMU_FAULT_t fault, unsigned int wire_byte);
+
+/**
+ * @brief Perform a transaction on the emulated bus.
+ *
+ * @note The emulated bus completes transactions synchronously. The callback
+ * is invoked before this returns.
+ *
+ * @return 0 if the transaction was performed, 1 if it is invalid
+ */
+int I2C_EMU_submit(I2C_transaction_t *xfer);
+
+/**
+ * @brief Get the status of the most recent transaction
+ */
+I2C_STATUS_t I2C_EMU_poll(void);
+
+/**
+ * @brief Perform a transaction and return its status
+ */
+I2C_STATUS_t I2C_EMU_transfer(I2C_transaction_t *xfer);
+
+void I2C_EMU_get_stats(I2C_EMU_stats_t *stats);
+
+/**
+ * @brief Set the simulated bus clock. Every transaction advances the clock by
+ * the time it spends on the wire so completion times can be observed.
+ */
+void I2C_EMU_set_time_us(uint32_t now_us);
+
+uint32_t I2C_EMU_get_time_us(void);
+
+#else
+#error EMULATION OF HARDWARE IS INTENDED FOR TESTING ON NATIVE PLATFORMS
+#endif /* !#if defined(TARGET_MCU) */
+
+#ifdef __cplusplus
+/* clang-format off */
+}
+/* clang-format on */
+#endif /* End C linkage */
+#endif /* __I2C_EMULATOR_H__ */
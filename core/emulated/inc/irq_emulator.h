@@ -0,0 +1,99 @@
+/**
+ * @file irq_emulator.h
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Emulated msp430 interrupt controller on a virtual clock, to time
+ * interrupt service routines on native builds
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ * @note Time only moves when the code says how long it takes: IRQ_EMU_run
+ * in the main context, IRQ_EMU_busy in an ISR. As on the msp430:
+ *  - a request sets the pending flag of its line, a request while the line
+ *    is still pending is lost (a receive overrun)
+ *  - with interrupts enabled the highest pending line is taken, entering
+ *    costs IRQ_EMU_ENTRY_TICKS and clears interrupts enable
+ *  - an ISR may enable interrupts, then any pending line preempts it
+ *  - leaving costs IRQ_EMU_RETI_TICKS and restores interrupts enable
+ * Ticks are SMCLK cycles, MCLK runs from the same clock.
+ */
+#ifndef __IRQ_EMULATOR_H__
+#define __IRQ_EMULATOR_H__
+#ifdef __cplusplus
+/* clang-format off */
+extern "C"
+{
+/* clang-format on */
+#endif /* Start C linkage */
+#if !defined(TARGET_MCU)
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Lines, higher is higher priority as the vectors of the msp430 */
+#define IRQ_EMU_LINE_CNT (8u)
+
+/* Cycles to push PC and SR and fetch the vector, and to return (slau208) */
+#define IRQ_EMU_ENTRY_TICKS (6u)
+#define IRQ_EMU_RETI_TICKS (5u)
+
+typedef void (*IRQ_EMU_isr_func)(void);
+
+
+/**
+ * @brief Start at tick 0 with interrupts enabled, nothing attached
+ */
+void IRQ_EMU_init(void);
+
+void IRQ_EMU_attach(uint8_t line, IRQ_EMU_isr_func isr);
+
+/**
+ * @brief Request line now
+ */
+void IRQ_EMU_raise(uint8_t line);
+
+/**
+ * @brief Request line at tick first and then every period ticks, 0 for
+ * once. Replaces what was scheduled on line.
+ */
+void IRQ_EMU_schedule(uint8_t line, uint32_t first, uint32_t period);
+
+/**
+ * @brief Spend ticks in the main context, taking the interrupts that come
+ */
+void IRQ_EMU_run(uint32_t ticks);
+
+/**
+ * @brief Spend ticks in the running ISR, taking the interrupts that come if
+ * it enabled them
+ */
+void IRQ_EMU_busy(uint32_t ticks);
+
+/**
+ * @brief Set or clear interrupts enable (GIE) in the running context
+ */
+void IRQ_EMU_enable(bool enable);
+
+uint32_t IRQ_EMU_now(void);
+
+/**
+ * @brief Tick the line of the running ISR was requested on
+ */
+uint32_t IRQ_EMU_raised(uint8_t line);
+
+/**
+ * @brief Requests lost because the line was still pending
+ */
+uint32_t IRQ_EMU_lost(uint8_t line);
+
+#else
+#error EMULATION OF HARDWARE IS INTENDED FOR TESTING ON NATIVE PLATFORMS
+#endif /* !#if defined(TARGET_MCU) */
+
+#ifdef __cplusplus
+/* clang-format off */
+}
+/* clang-format on */
+#endif /* End C linkage */
+#endif /* __IRQ_EMULATOR_H__ */
@@ -8,9 +8,25 @@ extern "C"
 #endif /* Start C linkage */
 #if !defined(TARGET_MCU)
 
+/* Set to serve the link on a pseudo terminal instead of the controlling
+ * terminal. The value is a path to symlink to the slave, or empty */
+#define OBC_EMU_PTY_ENV "ADCS_OBC_PTY"
+
+/* Line rate of the pseudo terminal, UART_EMU_BAUD if unset, 0 for no byte
+ * timing */
+#define OBC_EMU_BAUD_ENV "ADCS_OBC_BAUD"
+
 /**
  * @brief start the UART emulator to the OBC as an emulated hardware interface
  *
+ * By default commands are typed into the controlling terminal and replies
+ * printed to stdout. With OBC_EMU_PTY_ENV set the link is the slave of a
+ * pseudo terminal carrying the frames as they are on the wire, so the OBC
+ * scripts talk to it like to the board's uart, e.g.
+ * ADCS_OBC_PTY=/tmp/adcs_obc ADCS_OBC_BAUD=115200 ./adcs_executable
+ *
+ * Messages of the emulator go to stderr.
+ *
  * @note THIS IS INTENDED TO BE USED WHEN TESTING APPLICATION LOGIC ON A
  *       HOST MACHINE (rather than the target MCU)
  */
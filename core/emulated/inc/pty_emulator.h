@@ -0,0 +1,71 @@
+#ifndef __PTY_EMULATOR_H__
+#define __PTY_EMULATOR_H__
+#ifdef __cplusplus
+/* clang-format off */
+extern "C"
+{
+/* clang-format on */
+#endif /* Start C linkage */
+#if !defined(TARGET_MCU)
+
+#include <stdint.h>
+
+/**
+ * @brief Receives the bytes the client sent, one at a time when the line
+ * model has shifted each in. Called from the receive thread.
+ */
+typedef void (*PTY_EMU_rx_func)(uint8_t byte);
+
+typedef struct
+{
+    uint64_t rx_bytes;
+    uint64_t tx_bytes;
+    uint64_t tx_lost; /* the client did not read and its buffer was full */
+} PTY_EMU_stats_t;
+
+
+/**
+ * @brief Open a pseudo terminal pair as a virtual uart. A client opens the
+ * slave like any serial port, the emulator holds the master.
+ *
+ * Bytes move at the rate of a line at baud, 8N1 (UART_EMU_BITS_PER_BYTE bits
+ * a byte), both ways. The baud the client sets on the slave is ignored.
+ *
+ * @param baud line rate of the byte timing, 0 moves bytes as fast as the host
+ * @param link symlink to create to the slave so clients find it at a fixed
+ * path, NULL for none. Replaces a symlink already there, not a file.
+ * @param rx receives the bytes sent by the client
+ * @return int 0 on success, 1 if the pair or the link cannot be made
+ */
+int PTY_EMU_open(uint32_t baud, const char *link, PTY_EMU_rx_func rx);
+
+/**
+ * @brief Path of the slave, e.g. /dev/pts/3. Empty until opened.
+ */
+const char *PTY_EMU_get_name(void);
+
+/**
+ * @brief Transmit to the client. Blocks until the line model has shifted
+ * every byte out, as the target uart_transmit does.
+ *
+ * @return int 0 on success, 1 if the pair is not open
+ */
+int PTY_EMU_tx(const uint8_t *buf, uint16_t buflen);
+
+/**
+ * @brief Stop receiving, close the pair and remove the link
+ */
+void PTY_EMU_close(void);
+
+void PTY_EMU_get_stats(PTY_EMU_stats_t *stats);
+
+#else
+#error EMULATION OF HARDWARE IS INTENDED FOR TESTING ON NATIVE PLATFORMS
+#endif /* !#if defined(TARGET_MCU) */
+
+#ifdef __cplusplus
+/* clang-format off */
+}
+/* clang-format on */
+#endif /* End C linkage */
+#endif /* __PTY_EMULATOR_H__ */
@@ -0,0 +1,62 @@
+#ifndef __UART_EMULATOR_H__
+#define __UART_EMULATOR_H__
+#ifdef __cplusplus
+/* clang-format off */
+extern "C"
+{
+/* clang-format on */
+#endif /* Start C linkage */
+#if !defined(TARGET_MCU)
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Line rate of the OBC uart on the target (uart.c) */
+#define UART_EMU_BAUD (9600u)
+
+/* 8N1: a start bit, 8 data bits and a stop bit per byte */
+#define UART_EMU_BITS_PER_BYTE (10u)
+
+
+typedef struct
+{
+    uint32_t messages; /* messages put on the wire */
+    uint32_t dropped;  /* messages refused because the line was busy */
+    uint64_t bytes;
+    uint64_t busy_us; /* modelled time the line was transmitting */
+} UART_EMU_stats_t;
+
+
+/**
+ * @brief Model a uart transmit line at baud bits per second. Clears the
+ * statistics and leaves the line idle.
+ */
+void UART_EMU_init(uint32_t baud);
+
+/**
+ * @brief Put a message on the line at now_us
+ *
+ * @note Same contract as the target driver: a message passed while the
+ * previous one is still being shifted out is dropped whole.
+ *
+ * @return 0 if the message was sent, 1 if it was dropped
+ */
+int UART_EMU_tx(uint32_t now_us, const uint8_t *buf, uint16_t buflen);
+
+/**
+ * @brief true while a message is being shifted out at now_us
+ */
+bool UART_EMU_busy(uint32_t now_us);
+
+void UART_EMU_get_stats(UART_EMU_stats_t *stats);
+
+#else
+#error EMULATION OF HARDWARE IS INTENDED FOR TESTING ON NATIVE PLATFORMS
+#endif /* !#if defined(TARGET_MCU) */
+
+#ifdef __cplusplus
+/* clang-format off */
+}
+/* clang-format on */
+#endif /* End C linkage */
+#endif /* __UART_EMULATOR_H__ */
@@ -0,0 +1,135 @@
+/**
+ * @file ads7841_emulator.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Emulated ADS7841 converters for native builds
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ */
+#include <string.h>
+#include <stdint.h>
+
+#include "targets.h"
+#include "ads7841_emulator.h"
+
+#define CTL_START (1u << 7)
+#define CTL_CHANNEL_POS (4u)
+#define CTL_CHANNEL_MSK (7u << (CTL_CHANNEL_POS))
+#define CTL_SGL (1u << 2)
+
+typedef enum
+{
+    ADS7841_EMU_SHIFT_idle,
+    ADS7841_EMU_SHIFT_hi, /* busy clock and bits 11..5 */
+    ADS7841_EMU_SHIFT_lo, /* bits 4..0 */
+} ADS7841_EMU_SHIFT_t;
+
+static uint16_t ADS7841_EMU_counts[ADS7841_EMU_DEV_cnt]
+                                  [ADS7841_EMU_CHANNEL_CNT];
+
+static struct
+{
+    ADS7841_EMU_SHIFT_t shift;
+    uint16_t            conv;
+} ADS7841_EMU_spi[ADS7841_EMU_DEV_cnt];
+
+static uint8_t ADS7841_EMU_ctrl_channel(uint8_t ctrl);
+
+
+void ADS7841_EMU_init(void)
+{
+    memset(ADS7841_EMU_counts, 0, sizeof(ADS7841_EMU_counts));
+    memset(ADS7841_EMU_spi, 0, sizeof(ADS7841_EMU_spi));
+}
+
+
+void ADS7841_EMU_set_channel(ADS7841_EMU_DEV_t dev, uint8_t ch,
+                             uint16_t counts)
+{
+    CONFIG_ASSERT(dev < ADS7841_EMU_DEV_cnt);
+    if (ch >= ADS7841_EMU_CHANNEL_CNT)
+    {
+        return;
+    }
+    if (counts > ADS7841_EMU_COUNTS_MAX)
+    {
+        counts = ADS7841_EMU_COUNTS_MAX;
+    }
+    ADS7841_EMU_counts[dev][ch] = counts;
+}
+
+
+uint16_t ADS7841_EMU_measure_channel(ADS7841_EMU_DEV_t dev, uint8_t ch)
+{
+    CONFIG_ASSERT(dev < ADS7841_EMU_DEV_cnt);
+    if (ch >= ADS7841_EMU_CHANNEL_CNT)
+    {
+        return 0;
+    }
+    return ADS7841_EMU_counts[dev][ch];
+}
+
+
+uint8_t ADS7841_EMU_spi_transfer(ADS7841_EMU_DEV_t dev, uint8_t mosi)
+{
+    CONFIG_ASSERT(dev < ADS7841_EMU_DEV_cnt);
+    uint8_t miso = 0;
+    switch (ADS7841_EMU_spi[dev].shift)
+    {
+        case ADS7841_EMU_SHIFT_hi:
+        {
+            miso = (uint8_t)((ADS7841_EMU_spi[dev].conv >> 5) & 0x7Fu);
+            ADS7841_EMU_spi[dev].shift = ADS7841_EMU_SHIFT_lo;
+        }
+        break;
+        case ADS7841_EMU_SHIFT_lo:
+        {
+            miso = (uint8_t)((ADS7841_EMU_spi[dev].conv << 3) & 0xF8u);
+            ADS7841_EMU_spi[dev].shift = ADS7841_EMU_SHIFT_idle;
+        }
+        break;
+        default:
+        {
+            /* DOUT is high impedance outside of a conversion */
+        }
+        break;
+    }
+
+    /* A start bit begins a new conversion, even over the last result */
+    if (mosi & CTL_START)
+    {
+        const uint8_t ch = ADS7841_EMU_ctrl_channel(mosi);
+        ADS7841_EMU_spi[dev].conv  = ADS7841_EMU_counts[dev][ch];
+        ADS7841_EMU_spi[dev].shift = ADS7841_EMU_SHIFT_hi;
+    }
+    return miso;
+}
+
+
+void ADS7841_EMU_spi_deselect(ADS7841_EMU_DEV_t dev)
+{
+    CONFIG_ASSERT(dev < ADS7841_EMU_DEV_cnt);
+    ADS7841_EMU_spi[dev].shift = ADS7841_EMU_SHIFT_idle;
+}
+
+
+static uint8_t ADS7841_EMU_ctrl_channel(uint8_t ctrl)
+{
+    /* Address bits of table 1 of the datasheet, back to ADS7841_CHANNEL_t */
+    static const uint8_t addr_to_ch[] = {
+        [1] = 0, [5] = 1, [2] = 2, [6] = 3,
+    };
+    const uint8_t addr = (ctrl & CTL_CHANNEL_MSK) >> CTL_CHANNEL_POS;
+    uint8_t       ch   = 0;
+    if (addr < sizeof(addr_to_ch))
+    {
+        ch = addr_to_ch[addr];
+    }
+    if (!(ctrl & CTL_SGL))
+    {
+        ch += ADS7841_EMU_CHANNEL_CNT / 2;
+    }
+    return ch;
+}
@@ -0,0 +1,250 @@
+/**
+ * @file bno055_emulator.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Register level model of the BNO055 for the emulated I2C bus
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ */
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "targets.h"
+#include "i2c_emulator.h"
+#include "bno055_emulator.h"
+
+#define BNO055_EMU_ST_RESULT_ADDR (0x36)
+#define BNO055_EMU_UNIT_SEL_ADDR (0x3B)
+#define BNO055_EMU_AXIS_MAP_CONFIG_ADDR (0x41)
+#define BNO055_EMU_AXIS_MAP_SIGN_ADDR (0x42)
+#define BNO055_EMU_OFFSET_FIRST_ADDR (0x55)
+#define BNO055_EMU_OFFSET_LAST_ADDR (0x6A)
+#define BNO055_EMU_PAGE1_CONFIG_FIRST_ADDR (0x08)
+#define BNO055_EMU_PAGE1_CONFIG_LAST_ADDR (0x1F)
+
+#define BNO055_EMU_OPR_MODE_CONFIG (0x00)
+#define BNO055_EMU_OPR_MODE_MASK (0x0F)
+#define BNO055_EMU_OPR_MODE_FUSION_FIRST (0x08)
+#define BNO055_EMU_SYS_TRIGGER_RST_SYS (0x20)
+
+/* SYS_STATUS values (section 4.3.58 of datasheet) */
+#define BNO055_EMU_SYS_STATUS_IDLE (0x00)
+#define BNO055_EMU_SYS_STATUS_RUNNING (0x04)
+#define BNO055_EMU_SYS_STATUS_FUSION (0x05)
+
+typedef enum
+{
+    BNO055_EMU_WRITABLE_CONFIG = 0, /* OPR_MODE == CONFIGMODE */
+    BNO055_EMU_WRITABLE_RUN,        /* any other operating mode */
+    BNO055_EMU_WRITABLE_CNT,
+} BNO055_EMU_WRITABLE_t;
+
+static uint8_t BNO055_EMU_regs[BNO055_EMU_PAGE_CNT][BNO055_EMU_PAGE_SIZE];
+static uint8_t BNO055_EMU_writable[BNO055_EMU_PAGE_CNT][BNO055_EMU_WRITABLE_CNT]
+                                  [BNO055_EMU_PAGE_SIZE];
+static uint8_t          BNO055_EMU_page;
+static I2C_EMU_regmap_t BNO055_EMU_map;
+
+static void BNO055_EMU_reset(void);
+static void BNO055_EMU_init_writable(void);
+static void BNO055_EMU_select_map(void);
+static void BNO055_EMU_on_write(I2C_EMU_regmap_t *map, uint8_t reg,
+                                uint8_t value);
+static void BNO055_EMU_set_s16(uint8_t reg, int16_t value);
+
+
+int BNO055_EMU_attach(uint8_t dev_addr)
+{
+    BNO055_EMU_init_writable();
+    BNO055_EMU_reset();
+
+    I2C_EMU_device_t dev;
+    memset(&BNO055_EMU_map, 0, sizeof(BNO055_EMU_map));
+    BNO055_EMU_map.size     = BNO055_EMU_PAGE_SIZE;
+    BNO055_EMU_map.on_write = BNO055_EMU_on_write;
+    BNO055_EMU_select_map();
+    I2C_EMU_regmap_device(&BNO055_EMU_map, &dev);
+    return I2C_EMU_attach(dev_addr, &dev);
+}
+
+
+void BNO055_EMU_set_quaternion(int16_t w, int16_t x, int16_t y, int16_t z)
+{
+    BNO055_EMU_set_s16(BNO055_EMU_QUATERNION_DATA_W_LSB_ADDR + 0, w);
+    BNO055_EMU_set_s16(BNO055_EMU_QUATERNION_DATA_W_LSB_ADDR + 2, x);
+    BNO055_EMU_set_s16(BNO055_EMU_QUATERNION_DATA_W_LSB_ADDR + 4, y);
+    BNO055_EMU_set_s16(BNO055_EMU_QUATERNION_DATA_W_LSB_ADDR + 6, z);
+}
+
+
+void BNO055_EMU_set_gyro(int16_t x, int16_t y, int16_t z)
+{
+    BNO055_EMU_set_s16(BNO055_EMU_GYRO_DATA_X_LSB_ADDR + 0, x);
+    BNO055_EMU_set_s16(BNO055_EMU_GYRO_DATA_X_LSB_ADDR + 2, y);
+    BNO055_EMU_set_s16(BNO055_EMU_GYRO_DATA_X_LSB_ADDR + 4, z);
+}
+
+
+void BNO055_EMU_set_accel(int16_t x, int16_t y, int16_t z)
+{
+    BNO055_EMU_set_s16(BNO055_EMU_ACCEL_DATA_X_LSB_ADDR + 0, x);
+    BNO055_EMU_set_s16(BNO055_EMU_ACCEL_DATA_X_LSB_ADDR + 2, y);
+    BNO055_EMU_set_s16(BNO055_EMU_ACCEL_DATA_X_LSB_ADDR + 4, z);
+}
+
+
+void BNO055_EMU_set_mag(int16_t x, int16_t y, int16_t z)
+{
+    BNO055_EMU_set_s16(BNO055_EMU_MAG_DATA_X_LSB_ADDR + 0, x);
+    BNO055_EMU_set_s16(BNO055_EMU_MAG_DATA_X_LSB_ADDR + 2, y);
+    BNO055_EMU_set_s16(BNO055_EMU_MAG_DATA_X_LSB_ADDR + 4, z);
+}
+
+
+uint8_t BNO055_EMU_get_register(uint8_t page, uint8_t reg)
+{
+    CONFIG_ASSERT(page < BNO055_EMU_PAGE_CNT);
+    CONFIG_ASSERT(reg < BNO055_EMU_PAGE_SIZE);
+    return BNO055_EMU_regs[page][reg];
+}
+
+
+/* Power on reset values (section 4.2 of datasheet) */
+static void BNO055_EMU_reset(void)
+{
+    memset(BNO055_EMU_regs, 0, sizeof(BNO055_EMU_regs));
+
+    uint8_t *p0 = BNO055_EMU_regs[0];
+    p0[0x00]    = BNO055_EMU_CHIP_ID;
+    p0[0x01]    = 0xFB; /* ACC_ID */
+    p0[0x02]    = 0x32; /* MAG_ID */
+    p0[0x03]    = 0x0F; /* GYR_ID */
+    p0[0x04]    = 0x11; /* SW_REV_ID_LSB */
+    p0[0x05]    = 0x03; /* SW_REV_ID_MSB */
+    p0[0x06]    = 0x15; /* BL_REV_ID */
+    p0[BNO055_EMU_ST_RESULT_ADDR]       = 0x0F;
+    p0[BNO055_EMU_UNIT_SEL_ADDR]        = 0x80;
+    p0[BNO055_EMU_OPR_MODE_ADDR]        = BNO055_EMU_OPR_MODE_CONFIG;
+    p0[BNO055_EMU_SYS_STATUS_ADDR]      = BNO055_EMU_SYS_STATUS_IDLE;
+    p0[BNO055_EMU_AXIS_MAP_CONFIG_ADDR] = 0x24;
+
+    uint8_t *p1 = BNO055_EMU_regs[1];
+    p1[BNO055_EMU_PAGE_ID_ADDR] = 1;
+    p1[0x08]                    = 0x0D; /* ACC_Config */
+    p1[0x09]                    = 0x6D; /* MAG_Config */
+    p1[0x0A]                    = 0x38; /* GYR_Config_0 */
+
+    BNO055_EMU_page = 0;
+}
+
+
+static void BNO055_EMU_init_writable(void)
+{
+    memset(BNO055_EMU_writable, 0, sizeof(BNO055_EMU_writable));
+
+    uint8_t *cfg = BNO055_EMU_writable[0][BNO055_EMU_WRITABLE_CONFIG];
+    uint8_t *run = BNO055_EMU_writable[0][BNO055_EMU_WRITABLE_RUN];
+    unsigned int reg;
+
+    /* Always writable on page 0 */
+    run[BNO055_EMU_PAGE_ID_ADDR] = cfg[BNO055_EMU_PAGE_ID_ADDR] = 1;
+    run[BNO055_EMU_OPR_MODE_ADDR] = cfg[BNO055_EMU_OPR_MODE_ADDR] = 1;
+    run[BNO055_EMU_PWR_MODE_ADDR] = cfg[BNO055_EMU_PWR_MODE_ADDR] = 1;
+    run[BNO055_EMU_SYS_TRIGGER_ADDR] = cfg[BNO055_EMU_SYS_TRIGGER_ADDR] = 1;
+
+    /* Configuration only writable in CONFIGMODE */
+    cfg[BNO055_EMU_UNIT_SEL_ADDR]        = 1;
+    cfg[0x40]                            = 1; /* TEMP_SOURCE */
+    cfg[BNO055_EMU_AXIS_MAP_CONFIG_ADDR] = 1;
+    cfg[BNO055_EMU_AXIS_MAP_SIGN_ADDR]   = 1;
+    for (reg = BNO055_EMU_OFFSET_FIRST_ADDR; reg <= BNO055_EMU_OFFSET_LAST_ADDR;
+         reg++)
+    {
+        cfg[reg] = 1;
+    }
+
+    cfg = BNO055_EMU_writable[1][BNO055_EMU_WRITABLE_CONFIG];
+    run = BNO055_EMU_writable[1][BNO055_EMU_WRITABLE_RUN];
+    run[BNO055_EMU_PAGE_ID_ADDR] = cfg[BNO055_EMU_PAGE_ID_ADDR] = 1;
+    for (reg = BNO055_EMU_PAGE1_CONFIG_FIRST_ADDR;
+         reg <= BNO055_EMU_PAGE1_CONFIG_LAST_ADDR; reg++)
+    {
+        cfg[reg] = 1;
+    }
+}
+
+
+static void BNO055_EMU_select_map(void)
+{
+    BNO055_EMU_WRITABLE_t access = BNO055_EMU_WRITABLE_RUN;
+    if ((BNO055_EMU_regs[0][BNO055_EMU_OPR_MODE_ADDR] &
+         BNO055_EMU_OPR_MODE_MASK) == BNO055_EMU_OPR_MODE_CONFIG)
+    {
+        access = BNO055_EMU_WRITABLE_CONFIG;
+    }
+    BNO055_EMU_map.regs     = BNO055_EMU_regs[BNO055_EMU_page];
+    BNO055_EMU_map.writable = BNO055_EMU_writable[BNO055_EMU_page][access];
+}
+
+
+static void BNO055_EMU_on_write(I2C_EMU_regmap_t *map, uint8_t reg,
+                                uint8_t value)
+{
+    CONFIG_ASSERT(map == &BNO055_EMU_map);
+    if (reg == BNO055_EMU_PAGE_ID_ADDR)
+    {
+        /* PAGE_ID always reads back the page it lives on */
+        BNO055_EMU_regs[BNO055_EMU_page][reg] = BNO055_EMU_page;
+        BNO055_EMU_page                       = value & 0x01;
+    }
+    else if (BNO055_EMU_page == 0)
+    {
+        switch (reg)
+        {
+            case BNO055_EMU_OPR_MODE_ADDR:
+            {
+                uint8_t mode = value & BNO055_EMU_OPR_MODE_MASK;
+                uint8_t status;
+                if (mode == BNO055_EMU_OPR_MODE_CONFIG)
+                {
+                    status = BNO055_EMU_SYS_STATUS_IDLE;
+                }
+                else if (mode >= BNO055_EMU_OPR_MODE_FUSION_FIRST)
+                {
+                    status = BNO055_EMU_SYS_STATUS_FUSION;
+                }
+                else
+                {
+                    status = BNO055_EMU_SYS_STATUS_RUNNING;
+                }
+                BNO055_EMU_regs[0][BNO055_EMU_SYS_STATUS_ADDR] = status;
+            }
+            break;
+            case BNO055_EMU_SYS_TRIGGER_ADDR:
+            {
+                if (value & BNO055_EMU_SYS_TRIGGER_RST_SYS)
+                {
+                    BNO055_EMU_reset();
+                }
+                BNO055_EMU_regs[0][BNO055_EMU_SYS_TRIGGER_ADDR] = 0;
+            }
+            break;
+            default:
+            {
+            }
+            break;
+        }
+    }
+    BNO055_EMU_select_map();
+}
+
+
+static void BNO055_EMU_set_s16(uint8_t reg, int16_t value)
+{
+    uint16_t raw             = (uint16_t)value;
+    BNO055_EMU_regs[0][reg]     = (uint8_t)(raw & 0xFF);
+    BNO055_EMU_regs[0][reg + 1] = (uint8_t)(raw >> 8);
+}
@@ -0,0 +1,377 @@
+/**
+ * @file flash_emulator.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief source module to emulate the msp430 information memory and the
+ * telemetry log region when building application on host system
+ * (independent of target hardware)
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "targets.h"
+#include "flash_emulator.h"
+
+typedef struct
+{
+    bool     armed;
+    bool     lost;
+    uint32_t byte_ops; /* left before the power is lost */
+} flash_power;
+
+static uint8_t     flash_info[FLASH_INFO_CNT][FLASH_INFO_SEGMENT_SIZE];
+static uint32_t    flash_erase_cnt[FLASH_INFO_CNT];
+static bool        flash_initialized = false;
+static FILE *      flash_file        = NULL;
+static flash_power flash_pwr;
+
+#define FLASH_LOG_SIZE ((FLASH_LOG_SEGMENT_CNT) * (FLASH_LOG_SEGMENT_SIZE))
+static uint8_t  flash_log_ram[FLASH_LOG_SIZE];
+static uint8_t *flash_log = flash_log_ram;
+static uint32_t flash_log_erase_cnt[FLASH_LOG_SEGMENT_CNT];
+
+
+static bool FLASH_EMU_check(FLASH_INFO_t seg);
+static bool FLASH_EMU_log_check(uint16_t seg);
+static bool FLASH_EMU_byte_op(void);
+static void FLASH_EMU_sync(FLASH_INFO_t seg);
+
+
+void FLASH_EMU_init(void)
+{
+    FLASH_EMU_detach_file();
+    FLASH_EMU_log_unmap_file();
+    memset(flash_info, FLASH_ERASED_BYTE, sizeof(flash_info));
+    memset(flash_erase_cnt, 0, sizeof(flash_erase_cnt));
+    memset(flash_log_ram, FLASH_ERASED_BYTE, sizeof(flash_log_ram));
+    memset(flash_log_erase_cnt, 0, sizeof(flash_log_erase_cnt));
+    memset(&flash_pwr, 0, sizeof(flash_pwr));
+    flash_initialized = true;
+}
+
+
+const uint8_t *FLASH_EMU_info_segment(FLASH_INFO_t seg)
+{
+    if (!flash_initialized)
+    {
+        FLASH_EMU_init();
+    }
+    if (seg >= FLASH_INFO_CNT)
+    {
+        return NULL;
+    }
+    return flash_info[seg];
+}
+
+
+int FLASH_EMU_info_erase(FLASH_INFO_t seg)
+{
+    if (!FLASH_EMU_check(seg) ||
+        flash_erase_cnt[seg] >= FLASH_EMU_ENDURANCE_CYCLES)
+    {
+        return 1;
+    }
+
+    flash_erase_cnt[seg]++;
+    int          status = 0;
+    unsigned int i;
+    for (i = 0; i < FLASH_INFO_SEGMENT_SIZE; i++)
+    {
+        if (!FLASH_EMU_byte_op())
+        {
+            status = 1;
+            break;
+        }
+        flash_info[seg][i] = FLASH_ERASED_BYTE;
+    }
+    FLASH_EMU_sync(seg);
+    return status;
+}
+
+
+int FLASH_EMU_info_write(FLASH_INFO_t seg, uint16_t offset, const void *data,
+                         uint16_t len)
+{
+    if (!FLASH_EMU_check(seg) || NULL == data ||
+        offset > FLASH_INFO_SEGMENT_SIZE ||
+        len > FLASH_INFO_SEGMENT_SIZE - offset)
+    {
+        return 1;
+    }
+
+    /* Programming can only clear bits */
+    const uint8_t *src    = (const uint8_t *)data;
+    int            status = 0;
+    uint16_t       i;
+    for (i = 0; i < len; i++)
+    {
+        if (!FLASH_EMU_byte_op())
+        {
+            status = 1;
+            break;
+        }
+        flash_info[seg][offset + i] &= src[i];
+    }
+    FLASH_EMU_sync(seg);
+    if (status == 0 && memcmp(&flash_info[seg][offset], src, len) != 0)
+    {
+        status = 1;
+    }
+    return status;
+}
+
+
+uint32_t FLASH_EMU_erase_count(FLASH_INFO_t seg)
+{
+    if (seg >= FLASH_INFO_CNT)
+    {
+        return 0;
+    }
+    return flash_erase_cnt[seg];
+}
+
+
+int FLASH_EMU_attach_file(const char *path)
+{
+    if (!flash_initialized)
+    {
+        FLASH_EMU_init();
+    }
+    FLASH_EMU_detach_file();
+
+    flash_file = fopen(path, "r+b");
+    if (NULL != flash_file)
+    {
+        if (fread(flash_info, 1, sizeof(flash_info), flash_file) !=
+            sizeof(flash_info))
+        {
+            FLASH_EMU_detach_file();
+            return 1;
+        }
+        return 0;
+    }
+
+    flash_file = fopen(path, "w+b");
+    if (NULL == flash_file)
+    {
+        return 1;
+    }
+    FLASH_INFO_t seg;
+    for (seg = FLASH_INFO_D; seg < FLASH_INFO_CNT; seg++)
+    {
+        FLASH_EMU_sync(seg);
+    }
+    return 0;
+}
+
+
+void FLASH_EMU_detach_file(void)
+{
+    if (NULL != flash_file)
+    {
+        fclose(flash_file);
+        flash_file = NULL;
+    }
+}
+
+
+void FLASH_EMU_power_loss_after(uint32_t byte_ops)
+{
+    flash_pwr.armed    = true;
+    flash_pwr.lost     = false;
+    flash_pwr.byte_ops = byte_ops;
+}
+
+
+void FLASH_EMU_power_restore(void)
+{
+    memset(&flash_pwr, 0, sizeof(flash_pwr));
+}
+
+
+bool FLASH_EMU_power_lost(void)
+{
+    return flash_pwr.lost;
+}
+
+
+const uint8_t *FLASH_EMU_log_segment(uint16_t seg)
+{
+    if (!flash_initialized)
+    {
+        FLASH_EMU_init();
+    }
+    if (seg >= FLASH_LOG_SEGMENT_CNT)
+    {
+        return NULL;
+    }
+    return &flash_log[seg * FLASH_LOG_SEGMENT_SIZE];
+}
+
+
+int FLASH_EMU_log_erase(uint16_t seg)
+{
+    if (!FLASH_EMU_log_check(seg) ||
+        flash_log_erase_cnt[seg] >= FLASH_EMU_ENDURANCE_CYCLES)
+    {
+        return 1;
+    }
+
+    flash_log_erase_cnt[seg]++;
+    uint8_t     *dst = &flash_log[seg * FLASH_LOG_SEGMENT_SIZE];
+    unsigned int i;
+    for (i = 0; i < FLASH_LOG_SEGMENT_SIZE; i++)
+    {
+        if (!FLASH_EMU_byte_op())
+        {
+            return 1;
+        }
+        dst[i] = FLASH_ERASED_BYTE;
+    }
+    return 0;
+}
+
+
+int FLASH_EMU_log_write(uint16_t seg, uint16_t offset, const void *data,
+                        uint16_t len)
+{
+    if (!FLASH_EMU_log_check(seg) || NULL == data ||
+        offset > FLASH_LOG_SEGMENT_SIZE ||
+        len > FLASH_LOG_SEGMENT_SIZE - offset)
+    {
+        return 1;
+    }
+
+    uint8_t       *dst = &flash_log[seg * FLASH_LOG_SEGMENT_SIZE + offset];
+    const uint8_t *src = (const uint8_t *)data;
+    uint16_t       i;
+    for (i = 0; i < len; i++)
+    {
+        if (!FLASH_EMU_byte_op())
+        {
+            return 1;
+        }
+        dst[i] &= src[i]; /* programming can only clear bits */
+    }
+    return (memcmp(dst, src, len) == 0) ? 0 : 1;
+}
+
+
+uint32_t FLASH_EMU_log_erase_count(uint16_t seg)
+{
+    if (seg >= FLASH_LOG_SEGMENT_CNT)
+    {
+        return 0;
+    }
+    return flash_log_erase_cnt[seg];
+}
+
+
+int FLASH_EMU_log_map_file(const char *path)
+{
+    if (!flash_initialized)
+    {
+        FLASH_EMU_init();
+    }
+    FLASH_EMU_log_unmap_file();
+
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0)
+    {
+        return 1;
+    }
+
+    struct stat st;
+    bool        fresh = (fstat(fd, &st) != 0 || st.st_size != FLASH_LOG_SIZE);
+    if (fresh && ftruncate(fd, FLASH_LOG_SIZE) != 0)
+    {
+        close(fd);
+        return 1;
+    }
+
+    void *map =
+        mmap(NULL, FLASH_LOG_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd); /* the mapping keeps the file open */
+    if (MAP_FAILED == map)
+    {
+        return 1;
+    }
+    flash_log = (uint8_t *)map;
+    if (fresh)
+    {
+        memset(flash_log, FLASH_ERASED_BYTE, FLASH_LOG_SIZE);
+    }
+    return 0;
+}
+
+
+void FLASH_EMU_log_unmap_file(void)
+{
+    if (flash_log != flash_log_ram)
+    {
+        memcpy(flash_log_ram, flash_log, FLASH_LOG_SIZE);
+        msync(flash_log, FLASH_LOG_SIZE, MS_SYNC);
+        munmap(flash_log, FLASH_LOG_SIZE);
+        flash_log = flash_log_ram;
+    }
+}
+
+
+static bool FLASH_EMU_check(FLASH_INFO_t seg)
+{
+    if (!flash_initialized)
+    {
+        FLASH_EMU_init();
+    }
+    return seg < FLASH_INFO_CNT && seg != FLASH_INFO_A && !flash_pwr.lost;
+}
+
+
+static bool FLASH_EMU_log_check(uint16_t seg)
+{
+    if (!flash_initialized)
+    {
+        FLASH_EMU_init();
+    }
+    return seg < FLASH_LOG_SEGMENT_CNT && !flash_pwr.lost;
+}
+
+
+/* Account for one byte erased or programmed. False once power is lost */
+static bool FLASH_EMU_byte_op(void)
+{
+    if (flash_pwr.armed)
+    {
+        if (flash_pwr.byte_ops == 0)
+        {
+            flash_pwr.armed = false;
+            flash_pwr.lost  = true;
+            return false;
+        }
+        flash_pwr.byte_ops--;
+    }
+    return true;
+}
+
+
+static void FLASH_EMU_sync(FLASH_INFO_t seg)
+{
+    if (NULL == flash_file)
+    {
+        return;
+    }
+    fseek(flash_file, (long)seg * FLASH_INFO_SEGMENT_SIZE, SEEK_SET);
+    fwrite(flash_info[seg], 1, FLASH_INFO_SEGMENT_SIZE, flash_file);
+    fflush(flash_file);
+}
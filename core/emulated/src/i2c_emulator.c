@@ -0,0 +1,390 @@
+/**
+ * @file i2c_emulator.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief source module to emulate an I2C bus with attachable devices when
+ * building application on host system (independent of target hardware)
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "targets.h"
+#include "i2c_emulator.h"
+
+#define I2C_EMU_ADDR_MAX (0x7F)
+
+/* A byte on the wire is 8 data bits and an ack bit */
+#define I2C_EMU_BITS_PER_BYTE (9u)
+#define I2C_EMU_BITS_PER_START (1u)
+#define I2C_EMU_BITS_PER_STOP (1u)
+
+typedef struct
+{
+    I2C_EMU_FAULT_t fault;
+    unsigned int    wire_byte;
+} I2C_EMU_fault_t;
+
+/* State of the transaction in progress */
+typedef struct
+{
+    I2C_transaction_t *     xfer;
+    const I2C_EMU_device_t *dev;
+    unsigned int            wire_byte;
+    uint32_t                bits;
+} I2C_EMU_wire_t;
+
+static I2C_EMU_device_t I2C_EMU_devices[I2C_EMU_ADDR_MAX + 1];
+static bool             I2C_EMU_attached[I2C_EMU_ADDR_MAX + 1];
+static I2C_EMU_fault_t  I2C_EMU_pending_fault;
+static I2C_EMU_stats_t  I2C_EMU_stats;
+static I2C_STATUS_t     I2C_EMU_status = I2C_STATUS_ok;
+static uint32_t         I2C_EMU_time_us;
+
+static bool         I2C_EMU_xfer_is_valid(const I2C_transaction_t *xfer);
+static I2C_STATUS_t I2C_EMU_run(I2C_transaction_t *xfer);
+static I2C_STATUS_t I2C_EMU_wire_fault(I2C_EMU_wire_t *wire);
+static I2C_STATUS_t I2C_EMU_wire_address(I2C_EMU_wire_t *wire, bool read);
+
+static void    I2C_EMU_regmap_start(void *ctx, bool read);
+static bool    I2C_EMU_regmap_write(void *ctx, uint8_t byte);
+static uint8_t I2C_EMU_regmap_read(void *ctx);
+
+
+void I2C_EMU_init(void)
+{
+    memset(I2C_EMU_devices, 0, sizeof(I2C_EMU_devices));
+    memset(I2C_EMU_attached, 0, sizeof(I2C_EMU_attached));
+    memset(&I2C_EMU_pending_fault, 0, sizeof(I2C_EMU_pending_fault));
+    memset(&I2C_EMU_stats, 0, sizeof(I2C_EMU_stats));
+    I2C_EMU_status  = I2C_STATUS_ok;
+    I2C_EMU_time_us = 0;
+}
+
+
+int I2C_EMU_attach(uint8_t dev_addr, const I2C_EMU_device_t *dev)
+{
+    CONFIG_ASSERT(NULL != dev);
+    if (dev_addr > I2C_EMU_ADDR_MAX || I2C_EMU_attached[dev_addr])
+    {
+        return 1;
+    }
+    I2C_EMU_devices[dev_addr]  = *dev;
+    I2C_EMU_attached[dev_addr] = true;
+    return 0;
+}
+
+
+void I2C_EMU_detach(uint8_t dev_addr)
+{
+    if (dev_addr <= I2C_EMU_ADDR_MAX)
+    {
+        I2C_EMU_attached[dev_addr] = false;
+    }
+}
+
+
+void I2C_EMU_regmap_device(I2C_EMU_regmap_t *map, I2C_EMU_device_t *dev)
+{
+    CONFIG_ASSERT(NULL != map);
+    CONFIG_ASSERT(NULL != map->regs);
+    CONFIG_ASSERT(NULL != dev);
+    map->ptr         = 0;
+    map->ptr_pending = false;
+    dev->ctx         = map;
+    dev->start       = I2C_EMU_regmap_start;
+    dev->write       = I2C_EMU_regmap_write;
+    dev->read        = I2C_EMU_regmap_read;
+    dev->stop        = NULL;
+}
+
+
+void I2C_EMU_inject_fault(I2C_EMU_FAULT_t fault, unsigned int wire_byte)
+{
+    I2C_EMU_pending_fault.fault     = fault;
+    I2C_EMU_pending_fault.wire_byte = wire_byte;
+}
+
+
+int I2C_EMU_submit(I2C_transaction_t *xfer)
+{
+    if (!I2C_EMU_xfer_is_valid(xfer))
+    {
+        return 1;
+    }
+    if (xfer->timeout_us == 0)
+    {
+        xfer->timeout_us = I2C_TIMEOUT_US_DEFAULT;
+    }
+
+    I2C_EMU_status = I2C_EMU_run(xfer);
+    switch (I2C_EMU_status)
+    {
+        case I2C_STATUS_nack:
+        {
+            I2C_EMU_stats.nacks++;
+        }
+        break;
+        case I2C_STATUS_arbitration_lost:
+        {
+            I2C_EMU_stats.arbitration_lost++;
+        }
+        break;
+        case I2C_STATUS_timeout:
+        {
+            I2C_EMU_stats.timeouts++;
+        }
+        break;
+        default:
+        {
+        }
+        break;
+    }
+
+    if (xfer->callback != NULL)
+    {
+        xfer->callback(I2C_EMU_status, xfer->ctx);
+    }
+    return 0;
+}
+
+
+I2C_STATUS_t I2C_EMU_poll(void)
+{
+    return I2C_EMU_status;
+}
+
+
+I2C_STATUS_t I2C_EMU_transfer(I2C_transaction_t *xfer)
+{
+    if (I2C_EMU_submit(xfer))
+    {
+        return I2C_STATUS_invalid;
+    }
+    return I2C_EMU_poll();
+}
+
+
+void I2C_EMU_get_stats(I2C_EMU_stats_t *stats)
+{
+    CONFIG_ASSERT(NULL != stats);
+    *stats = I2C_EMU_stats;
+}
+
+
+void I2C_EMU_set_time_us(uint32_t now_us)
+{
+    I2C_EMU_time_us = now_us;
+}
+
+
+uint32_t I2C_EMU_get_time_us(void)
+{
+    return I2C_EMU_time_us;
+}
+
+
+static bool I2C_EMU_xfer_is_valid(const I2C_transaction_t *xfer)
+{
+    if (xfer == NULL)
+    {
+        return false;
+    }
+    if (xfer->dev_addr > I2C_EMU_ADDR_MAX)
+    {
+        return false;
+    }
+    if (xfer->txlen == 0 && xfer->rxlen == 0)
+    {
+        return false;
+    }
+    if ((xfer->txlen > 0 && xfer->tx == NULL) ||
+        (xfer->rxlen > 0 && xfer->rx == NULL))
+    {
+        return false;
+    }
+    return true;
+}
+
+
+static I2C_STATUS_t I2C_EMU_run(I2C_transaction_t *xfer)
+{
+    I2C_EMU_wire_t wire;
+    wire.xfer      = xfer;
+    wire.dev       = NULL;
+    wire.wire_byte = 0;
+    wire.bits      = 0;
+    if (I2C_EMU_attached[xfer->dev_addr])
+    {
+        wire.dev = &I2C_EMU_devices[xfer->dev_addr];
+    }
+
+    I2C_STATUS_t status = I2C_STATUS_ok;
+    uint16_t     i;
+    if (xfer->txlen > 0)
+    {
+        status = I2C_EMU_wire_address(&wire, false);
+        for (i = 0; i < xfer->txlen && status == I2C_STATUS_ok; i++)
+        {
+            status = I2C_EMU_wire_fault(&wire);
+            if (status == I2C_STATUS_ok)
+            {
+                if (!wire.dev->write(wire.dev->ctx, xfer->tx[i]))
+                {
+                    status = I2C_STATUS_nack;
+                }
+            }
+        }
+    }
+
+    if (xfer->rxlen > 0 && status == I2C_STATUS_ok)
+    {
+        status = I2C_EMU_wire_address(&wire, true);
+        for (i = 0; i < xfer->rxlen && status == I2C_STATUS_ok; i++)
+        {
+            status = I2C_EMU_wire_fault(&wire);
+            if (status == I2C_STATUS_ok)
+            {
+                xfer->rx[i] = wire.dev->read(wire.dev->ctx);
+            }
+        }
+    }
+
+    /* Losing arbitration means another master generates the stop */
+    if (status != I2C_STATUS_arbitration_lost)
+    {
+        wire.bits += I2C_EMU_BITS_PER_STOP;
+        if (wire.dev != NULL && wire.dev->stop != NULL)
+        {
+            wire.dev->stop(wire.dev->ctx);
+        }
+    }
+
+    uint64_t wire_time_us =
+        ((uint64_t)wire.bits * 1000000u + I2C_EMU_SCL_FREQ - 1) /
+        I2C_EMU_SCL_FREQ;
+    if (status == I2C_STATUS_timeout)
+    {
+        wire_time_us = xfer->timeout_us;
+    }
+
+    I2C_EMU_stats.transactions++;
+    I2C_EMU_stats.bytes += wire.wire_byte;
+    I2C_EMU_stats.bus_time_us += wire_time_us;
+    I2C_EMU_time_us += (uint32_t)wire_time_us;
+    return status;
+}
+
+
+static I2C_STATUS_t I2C_EMU_wire_address(I2C_EMU_wire_t *wire, bool read)
+{
+    wire->bits += I2C_EMU_BITS_PER_START;
+    I2C_STATUS_t status = I2C_EMU_wire_fault(wire);
+    if (status == I2C_STATUS_ok)
+    {
+        if (wire->dev == NULL)
+        {
+            status = I2C_STATUS_nack; /* nobody home */
+        }
+        else if (wire->dev->start != NULL)
+        {
+            wire->dev->start(wire->dev->ctx, read);
+        }
+    }
+    return status;
+}
+
+
+/* Clock the next byte onto the wire and apply any pending fault to it */
+static I2C_STATUS_t I2C_EMU_wire_fault(I2C_EMU_wire_t *wire)
+{
+    I2C_STATUS_t status = I2C_STATUS_ok;
+    if (I2C_EMU_pending_fault.fault != I2C_EMU_FAULT_none &&
+        I2C_EMU_pending_fault.wire_byte == wire->wire_byte)
+    {
+        switch (I2C_EMU_pending_fault.fault)
+        {
+            case I2C_EMU_FAULT_nack:
+            {
+                status = I2C_STATUS_nack;
+            }
+            break;
+            case I2C_EMU_FAULT_arbitration_lost:
+            {
+                status = I2C_STATUS_arbitration_lost;
+            }
+            break;
+            case I2C_EMU_FAULT_stuck_bus:
+            {
+                status = I2C_STATUS_timeout;
+            }
+            break;
+            default:
+            {
+            }
+            break;
+        }
+        I2C_EMU_pending_fault.fault = I2C_EMU_FAULT_none;
+    }
+    wire->bits += I2C_EMU_BITS_PER_BYTE;
+    wire->wire_byte++;
+    return status;
+}
+
+
+static void I2C_EMU_regmap_start(void *ctx, bool read)
+{
+    I2C_EMU_regmap_t *map = (I2C_EMU_regmap_t *)ctx;
+    map->ptr_pending      = !read;
+}
+
+
+static bool I2C_EMU_regmap_write(void *ctx, uint8_t byte)
+{
+    I2C_EMU_regmap_t *map = (I2C_EMU_regmap_t *)ctx;
+    if (map->ptr_pending)
+    {
+        map->ptr_pending = false;
+        if (byte >= map->size)
+        {
+            return false;
+        }
+        map->ptr = byte;
+        return true;
+    }
+
+    if (map->ptr >= map->size)
+    {
+        return false;
+    }
+
+    uint8_t reg = map->ptr;
+    map->ptr++;
+    if (map->writable == NULL || map->writable[reg])
+    {
+        map->regs[reg] = byte;
+        if (map->on_write != NULL)
+        {
+            map->on_write(map, reg, byte);
+        }
+    }
+    return true; /* writes to read only registers are acked and ignored */
+}
+
+
+static uint8_t I2C_EMU_regmap_read(void *ctx)
+{
+    I2C_EMU_regmap_t *map = (I2C_EMU_regmap_t *)ctx;
+    if (map->ptr >= map->size)
+    {
+        return 0xFF; /* released bus */
+    }
+    uint8_t byte = map->regs[map->ptr];
+    map->ptr++;
+    return byte;
+}
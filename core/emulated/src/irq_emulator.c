@@ -0,0 +1,207 @@
+/**
+ * @file irq_emulator.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief source module to emulate the msp430 interrupt controller on a
+ * virtual clock when building application on host system (independent of
+ * target hardware)
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ */
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "targets.h"
+#include "config_assert.h"
+#include "irq_emulator.h"
+
+typedef struct
+{
+    IRQ_EMU_isr_func isr;
+    bool             pending;
+    uint32_t         raised; /* tick of the pending request */
+    uint32_t         taken;  /* tick of the request being serviced */
+    bool             scheduled;
+    uint32_t         next;
+    uint32_t         period;
+    uint32_t         lost;
+} IRQ_EMU_line_t;
+
+static IRQ_EMU_line_t IRQ_EMU_lines[IRQ_EMU_LINE_CNT];
+static uint32_t       IRQ_EMU_ticks;
+static bool           IRQ_EMU_gie;
+
+static void IRQ_EMU_request(uint8_t line, uint32_t at);
+static void IRQ_EMU_deliver(void);
+static int  IRQ_EMU_highest_pending(void);
+static void IRQ_EMU_dispatch(uint8_t line);
+static void IRQ_EMU_spend(uint32_t ticks);
+
+
+void IRQ_EMU_init(void)
+{
+    memset(IRQ_EMU_lines, 0, sizeof(IRQ_EMU_lines));
+    IRQ_EMU_ticks = 0;
+    IRQ_EMU_gie   = true;
+}
+
+
+void IRQ_EMU_attach(uint8_t line, IRQ_EMU_isr_func isr)
+{
+    CONFIG_ASSERT(line < IRQ_EMU_LINE_CNT);
+    IRQ_EMU_lines[line].isr = isr;
+}
+
+
+void IRQ_EMU_raise(uint8_t line)
+{
+    CONFIG_ASSERT(line < IRQ_EMU_LINE_CNT);
+    IRQ_EMU_request(line, IRQ_EMU_ticks);
+}
+
+
+void IRQ_EMU_schedule(uint8_t line, uint32_t first, uint32_t period)
+{
+    CONFIG_ASSERT(line < IRQ_EMU_LINE_CNT);
+    IRQ_EMU_lines[line].scheduled = true;
+    IRQ_EMU_lines[line].next      = first;
+    IRQ_EMU_lines[line].period    = period;
+}
+
+
+void IRQ_EMU_run(uint32_t ticks)
+{
+    IRQ_EMU_spend(ticks);
+}
+
+
+void IRQ_EMU_busy(uint32_t ticks)
+{
+    IRQ_EMU_spend(ticks);
+}
+
+
+void IRQ_EMU_enable(bool enable)
+{
+    IRQ_EMU_gie = enable;
+}
+
+
+uint32_t IRQ_EMU_now(void)
+{
+    return IRQ_EMU_ticks;
+}
+
+
+uint32_t IRQ_EMU_raised(uint8_t line)
+{
+    CONFIG_ASSERT(line < IRQ_EMU_LINE_CNT);
+    return IRQ_EMU_lines[line].taken;
+}
+
+
+uint32_t IRQ_EMU_lost(uint8_t line)
+{
+    CONFIG_ASSERT(line < IRQ_EMU_LINE_CNT);
+    return IRQ_EMU_lines[line].lost;
+}
+
+
+static void IRQ_EMU_request(uint8_t line, uint32_t at)
+{
+    IRQ_EMU_line_t *l = &IRQ_EMU_lines[line];
+    if (l->pending)
+    {
+        l->lost++;
+    }
+    else
+    {
+        l->pending = true;
+        l->raised  = at;
+    }
+}
+
+
+/* Scheduled requests due by now become pending */
+static void IRQ_EMU_deliver(void)
+{
+    uint8_t line;
+    for (line = 0; line < IRQ_EMU_LINE_CNT; line++)
+    {
+        IRQ_EMU_line_t *l = &IRQ_EMU_lines[line];
+        while (l->scheduled && (int32_t)(l->next - IRQ_EMU_ticks) <= 0)
+        {
+            IRQ_EMU_request(line, l->next);
+            l->next += l->period;
+            l->scheduled = (l->period != 0);
+        }
+    }
+}
+
+
+static int IRQ_EMU_highest_pending(void)
+{
+    int line;
+    for (line = IRQ_EMU_LINE_CNT - 1; line >= 0; line--)
+    {
+        if (IRQ_EMU_lines[line].pending && NULL != IRQ_EMU_lines[line].isr)
+        {
+            return line;
+        }
+    }
+    return -1;
+}
+
+
+static void IRQ_EMU_dispatch(uint8_t line)
+{
+    IRQ_EMU_line_t *l     = &IRQ_EMU_lines[line];
+    const uint32_t  taken = l->taken; /* of a run it preempts */
+    const bool      gie   = IRQ_EMU_gie;
+
+    l->pending  = false;
+    l->taken    = l->raised;
+    IRQ_EMU_gie = false;
+    IRQ_EMU_spend(IRQ_EMU_ENTRY_TICKS);
+    l->isr();
+    IRQ_EMU_gie = false;
+    IRQ_EMU_spend(IRQ_EMU_RETI_TICKS);
+    l->taken    = taken;
+    IRQ_EMU_gie = gie;
+}
+
+
+/* Interrupts taken while the context works do not count as its ticks */
+static void IRQ_EMU_spend(uint32_t ticks)
+{
+    for (;;)
+    {
+        IRQ_EMU_deliver();
+        const int line = IRQ_EMU_gie ? IRQ_EMU_highest_pending() : -1;
+        if (line >= 0)
+        {
+            IRQ_EMU_dispatch((uint8_t)line);
+            continue;
+        }
+        if (ticks == 0)
+        {
+            break;
+        }
+
+        uint32_t step = ticks;
+        uint8_t  i;
+        for (i = 0; i < IRQ_EMU_LINE_CNT; i++)
+        {
+            const IRQ_EMU_line_t *l = &IRQ_EMU_lines[i];
+            if (l->scheduled && l->next - IRQ_EMU_ticks < step)
+            {
+                step = l->next - IRQ_EMU_ticks;
+            }
+        }
+        IRQ_EMU_ticks += step;
+        ticks -= step;
+    }
+}
@@ -29,63 +29,192 @@
 #include "targets.h"
 #include "obc_emulator.h"
 #include "obc_interface.h"
+#include "obc_frame.h"
+#include "pty_emulator.h"
+#include "uart_emulator.h"
 
 
 #define SET_ATTR_NOW TCSANOW
 
-static pthread_t OBC_EMU_pthread;
+/* A typed line is sent as one frame when enter, or the '!' that delimited
+ * commands before framing, ends it. A line longer than a received frame is
+ * sent anyway, the interface drops it */
+#define OBC_EMU_LINE_END ('\n')
+#define OBC_EMU_LINE_END_ALT ('!')
+#define OBC_EMU_LINE_MAX (OBC_RX_FRAME_LEN + 1)
+
+/* Bytes taken from stdin per read, a pasted burst of commands is read in a
+ * few calls instead of one per byte */
+#define OBC_EMU_READ_CHUNK (256u)
+
+static pthread_t      OBC_EMU_pthread;
+static struct termios OBC_EMU_old_tio;
+static OBC_FRAME_rx_t OBC_EMU_reply;
+static uint8_t OBC_EMU_reply_buf[OBC_TX_BUFFER_SIZE + OBC_FRAME_CRC_SIZE];
+static bool    OBC_EMU_on_pty;
 
 static void *OBC_EMU(void *args);
+static void  OBC_EMU_send_line(uint8_t *frame, uint16_t len);
+static int   OBC_EMU_start_pty(const char *link);
 
 int OBC_EMU_tx(uint8_t *buf, uint_least16_t buflen)
 {
     CONFIG_ASSERT(buf != NULL);
-    char *tmp = malloc(buflen + 1);
-    snprintf(tmp, buflen + 1, "%s%c", buf, '\0');
-    int bytes_transmitted = printf("%s", tmp);
-    free(tmp);
-    return bytes_transmitted;
+    if (OBC_EMU_on_pty)
+    {
+        /* The frames go out as they are, the client decodes them */
+        PTY_EMU_tx(buf, (uint16_t)buflen);
+        return buflen;
+    }
+
+    uint_least16_t i;
+    for (i = 0; i < buflen; i++)
+    {
+        if (!OBC_EMU_reply.active && buf[i] != OBC_FRAME_DELIM)
+        {
+            OBC_FRAME_rx_init(&OBC_EMU_reply, OBC_EMU_reply_buf,
+                              sizeof(OBC_EMU_reply_buf));
+        }
+        switch (OBC_FRAME_rx_byte(&OBC_EMU_reply, buf[i]))
+        {
+            case OBC_FRAME_RX_done:
+            {
+                /* the terminal wants a newline to show the reply */
+                printf("%.*s\n", (int)OBC_EMU_reply.len,
+                       (const char *)OBC_EMU_reply_buf);
+                fflush(stdout);
+            }
+            break;
+            case OBC_FRAME_RX_bad:
+            case OBC_FRAME_RX_too_long:
+            {
+                fprintf(stderr, "OBC EMULATOR : BAD REPLY FRAME\n");
+            }
+            break;
+            default:
+            {
+            }
+            break;
+        }
+    }
+    return buflen;
 }
 
 void OBC_EMU_start(void)
 {
+    const char *link = getenv(OBC_EMU_PTY_ENV);
+    if (NULL != link)
+    {
+        int err = OBC_EMU_start_pty(('\0' != link[0]) ? link : NULL);
+        CONFIG_ASSERT(err == 0);
+        return;
+    }
+
 #if defined(linux) || defined(__unix__) || defined(__APPLE__)
     /* Configure terminal to read raw, unbuffered input */
     struct termios new_tio;
     tcgetattr(STDIN_FILENO, &new_tio);
-    struct termios old_tio = new_tio;
+    OBC_EMU_old_tio = new_tio;
     new_tio.c_lflag &= (~ICANON & ~ECHO);
     tcsetattr(STDIN_FILENO, SET_ATTR_NOW, &new_tio);
 #elif defined(_WIN32) || defined(WIN32)
 
 #endif /* defined(linux) || defined(__unix__) || defined(__APPLE__) */
-    char msg[250];
-    sprintf(msg,
+    fprintf(stderr,
             "OBC UART EMULATOR\n"
-            "TYPE INTO THE TERMINAL TO SEND RAW BYTES TO OBC INTERFACE\n"
-            "PRESS ^C (CTRL + C) TO QUIT\n"
-            "CURRENTLY, THE OBC RECEIVE DELIMITER IS >%c<\n",
-            OBC_MSG_DELIM);
-    OBC_EMU_tx((uint8_t *)msg, (uint_least16_t)sizeof(msg));
+            "TYPE A COMMAND INTO THE TERMINAL, ENTER OR >%c< SENDS IT TO THE "
+            "OBC INTERFACE AS ONE FRAME\n"
+            "PRESS ^C (CTRL + C) TO QUIT\n",
+            OBC_EMU_LINE_END_ALT);
 
     /* Start listener thread */
     int ret;
-    ret = pthread_create(&OBC_EMU_pthread, NULL, OBC_EMU, &old_tio);
+    ret = pthread_create(&OBC_EMU_pthread, NULL, OBC_EMU, NULL);
     CONFIG_ASSERT(ret == 0);
 }
 
 static void *OBC_EMU(void *args)
 {
-    struct termios old_tio = *(struct termios *)args;
-    char           tmp;
+    uint8_t  chunk[OBC_EMU_READ_CHUNK];
+    uint8_t  frame[OBC_FRAME_WIRE_LEN(OBC_EMU_LINE_MAX)];
+    uint8_t *line = &frame[OBC_FRAME_HEAD(OBC_EMU_LINE_MAX)];
+    uint16_t len  = 0;
+    ssize_t  got;
+    ssize_t  i;
+    (void)args;
     do
     {
-        tmp = getchar();
-        OBC_IF_receive_byte(tmp);
+        /* Blocks until input comes, the thread takes no CPU while idle */
+        got = read(STDIN_FILENO, chunk, sizeof(chunk));
+        if (got < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (got <= 0)
+        {
+            break;
+        }
+
+        for (i = 0; i < got; i++)
+        {
+            if (chunk[i] == OBC_EMU_LINE_END ||
+                chunk[i] == OBC_EMU_LINE_END_ALT)
+            {
+                if (len > 0)
+                {
+                    OBC_EMU_send_line(frame, len);
+                    len = 0;
+                }
+                continue;
+            }
+            line[len++] = chunk[i];
+            if (len == OBC_EMU_LINE_MAX)
+            {
+                OBC_EMU_send_line(frame, len);
+                len = 0;
+            }
+        }
     } while (true);
 
     /* restore old terminal settings */
-    fflush(stdin);
-    tcsetattr(STDIN_FILENO, SET_ATTR_NOW, &old_tio);
+    tcsetattr(STDIN_FILENO, SET_ATTR_NOW, &OBC_EMU_old_tio);
     return NULL;
-}
\ No newline at end of file
+}
+
+
+/* Frame the line at the head of frame and receive it a byte at a time, as
+ * the uart would */
+static void OBC_EMU_send_line(uint8_t *frame, uint16_t len)
+{
+    const uint16_t frame_len =
+        OBC_FRAME_encode(frame, OBC_FRAME_HEAD(OBC_EMU_LINE_MAX), len);
+    uint16_t i;
+    for (i = 0; i < frame_len; i++)
+    {
+        OBC_IF_receive_byte(frame[i]);
+    }
+}
+
+
+/* The link is the slave of a pseudo terminal, stdout is left to the debug
+ * output */
+static int OBC_EMU_start_pty(const char *link)
+{
+    uint32_t    baud = UART_EMU_BAUD;
+    const char *env  = getenv(OBC_EMU_BAUD_ENV);
+    if (NULL != env)
+    {
+        baud = (uint32_t)strtoul(env, NULL, 10);
+    }
+
+    if (PTY_EMU_open(baud, link, OBC_IF_receive_byte))
+    {
+        fprintf(stderr, "OBC EMULATOR : CANNOT OPEN A PSEUDO TERMINAL\n");
+        return 1;
+    }
+    OBC_EMU_on_pty = true;
+    fprintf(stderr, "OBC UART EMULATOR ON %s%s%s AT %lu BAUD\n",
+            PTY_EMU_get_name(), (NULL != link) ? " LINKED FROM " : "",
+            (NULL != link) ? link : "", (unsigned long)baud);
+    return 0;
+}
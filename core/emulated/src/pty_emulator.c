@@ -0,0 +1,260 @@
+/**
+ * @file pty_emulator.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief source module to emulate a uart on a pseudo terminal pair, with
+ * the byte timing of a real line, when building application on host system
+ * (independent of target hardware)
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ */
+#define _GNU_SOURCE /* posix_openpt, cfmakeraw */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <time.h>
+#include <pthread.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <termios.h>
+#include <sys/stat.h>
+
+#include "targets.h"
+#include "pty_emulator.h"
+#include "uart_emulator.h"
+
+#define PTY_EMU_NS_PER_S (1000000000ull)
+
+/* Bytes taken from the master per read */
+#define PTY_EMU_READ_CHUNK (64u)
+
+static int             PTY_EMU_master = -1;
+static int             PTY_EMU_slave  = -1;
+static char            PTY_EMU_name[64];
+static char            PTY_EMU_link[256];
+static uint64_t        PTY_EMU_byte_ns;
+static uint64_t        PTY_EMU_tx_idle_ns;
+static PTY_EMU_rx_func PTY_EMU_rx_cb;
+static pthread_t       PTY_EMU_pthread;
+static PTY_EMU_stats_t PTY_EMU_stats;
+
+static void *   PTY_EMU_receive(void *args);
+static uint64_t PTY_EMU_now_ns(void);
+static void     PTY_EMU_sleep_until(uint64_t ns);
+
+
+int PTY_EMU_open(uint32_t baud, const char *link, PTY_EMU_rx_func rx)
+{
+    CONFIG_ASSERT(NULL != rx);
+    CONFIG_ASSERT(PTY_EMU_master < 0);
+
+    PTY_EMU_master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (PTY_EMU_master < 0 || grantpt(PTY_EMU_master) != 0 ||
+        unlockpt(PTY_EMU_master) != 0 ||
+        ptsname_r(PTY_EMU_master, PTY_EMU_name, sizeof(PTY_EMU_name)) != 0)
+    {
+        PTY_EMU_close();
+        return 1;
+    }
+
+    /* Raw bytes both ways. The emulator keeps the slave open too so the
+     * master does not hang up while no client is connected */
+    struct termios tio;
+    PTY_EMU_slave = open(PTY_EMU_name, O_RDWR | O_NOCTTY);
+    if (PTY_EMU_slave < 0 || tcgetattr(PTY_EMU_slave, &tio) != 0)
+    {
+        PTY_EMU_close();
+        return 1;
+    }
+    cfmakeraw(&tio);
+    tcsetattr(PTY_EMU_slave, TCSANOW, &tio);
+
+    /* A transmit never blocks on a client that is not reading, the bytes
+     * are lost as they would be on a wire nobody listens to */
+    const int flags = fcntl(PTY_EMU_master, F_GETFL);
+    fcntl(PTY_EMU_master, F_SETFL, flags | O_NONBLOCK);
+
+    if (NULL != link)
+    {
+        struct stat st;
+        if (lstat(link, &st) == 0 && S_ISLNK(st.st_mode))
+        {
+            unlink(link);
+        }
+        if (strlen(link) >= sizeof(PTY_EMU_link) ||
+            symlink(PTY_EMU_name, link) != 0)
+        {
+            PTY_EMU_close();
+            return 1;
+        }
+        strcpy(PTY_EMU_link, link);
+    }
+
+    PTY_EMU_byte_ns    = (baud > 0) ? (UART_EMU_BITS_PER_BYTE *
+                                        PTY_EMU_NS_PER_S + baud - 1) /
+                                       baud
+                                    : 0;
+    PTY_EMU_tx_idle_ns = 0;
+    PTY_EMU_rx_cb      = rx;
+    memset(&PTY_EMU_stats, 0, sizeof(PTY_EMU_stats));
+
+    int ret = pthread_create(&PTY_EMU_pthread, NULL, PTY_EMU_receive, NULL);
+    CONFIG_ASSERT(ret == 0);
+    return 0;
+}
+
+
+const char *PTY_EMU_get_name(void)
+{
+    return PTY_EMU_name;
+}
+
+
+int PTY_EMU_tx(const uint8_t *buf, uint16_t buflen)
+{
+    CONFIG_ASSERT(NULL != buf);
+    if (PTY_EMU_master < 0)
+    {
+        return 1;
+    }
+
+    /* Byte i is on the wire once start + (i + 1) byte times have passed.
+     * Every byte due by the time the thread wakes goes in one write */
+    uint64_t start = PTY_EMU_now_ns();
+    if (PTY_EMU_tx_idle_ns > start)
+    {
+        start = PTY_EMU_tx_idle_ns;
+    }
+    uint16_t sent = 0;
+    while (sent < buflen)
+    {
+        uint16_t due = buflen;
+        if (PTY_EMU_byte_ns > 0)
+        {
+            PTY_EMU_sleep_until(start + (sent + 1u) * PTY_EMU_byte_ns);
+            const uint64_t shifted =
+                (PTY_EMU_now_ns() - start) / PTY_EMU_byte_ns;
+            due = (shifted < buflen) ? (uint16_t)shifted : buflen;
+        }
+
+        const ssize_t written =
+            write(PTY_EMU_master, &buf[sent], (size_t)(due - sent));
+        if (written > 0)
+        {
+            PTY_EMU_stats.tx_bytes += (uint64_t)written;
+            PTY_EMU_stats.tx_lost += (uint64_t)(due - sent) - written;
+        }
+        else
+        {
+            PTY_EMU_stats.tx_lost += (uint64_t)(due - sent);
+        }
+        sent = due;
+    }
+    PTY_EMU_tx_idle_ns = start + buflen * PTY_EMU_byte_ns;
+    return 0;
+}
+
+
+void PTY_EMU_close(void)
+{
+    if (NULL != PTY_EMU_rx_cb)
+    {
+        pthread_cancel(PTY_EMU_pthread);
+        pthread_join(PTY_EMU_pthread, NULL);
+        PTY_EMU_rx_cb = NULL;
+    }
+    if ('\0' != PTY_EMU_link[0])
+    {
+        unlink(PTY_EMU_link);
+        PTY_EMU_link[0] = '\0';
+    }
+    if (PTY_EMU_slave >= 0)
+    {
+        close(PTY_EMU_slave);
+        PTY_EMU_slave = -1;
+    }
+    if (PTY_EMU_master >= 0)
+    {
+        close(PTY_EMU_master);
+        PTY_EMU_master = -1;
+    }
+    PTY_EMU_name[0] = '\0';
+}
+
+
+void PTY_EMU_get_stats(PTY_EMU_stats_t *stats)
+{
+    CONFIG_ASSERT(NULL != stats);
+    *stats = PTY_EMU_stats;
+}
+
+
+/* The client writes a burst at once, the bytes are handed over one byte
+ * time apart as the uart receive interrupt would */
+static void *PTY_EMU_receive(void *args)
+{
+    uint8_t       chunk[PTY_EMU_READ_CHUNK];
+    uint64_t      line_ns = 0;
+    struct pollfd pfd     = {.fd = PTY_EMU_master, .events = POLLIN};
+    (void)args;
+    for (;;)
+    {
+        /* Blocks until the client sends, cancelled here by PTY_EMU_close */
+        if (poll(&pfd, 1, -1) < 0 && errno != EINTR)
+        {
+            break;
+        }
+        const ssize_t got = read(PTY_EMU_master, chunk, sizeof(chunk));
+        if (got <= 0)
+        {
+            continue;
+        }
+
+        const uint64_t now = PTY_EMU_now_ns();
+        if (line_ns < now)
+        {
+            line_ns = now;
+        }
+        ssize_t i;
+        for (i = 0; i < got; i++)
+        {
+            line_ns += PTY_EMU_byte_ns;
+            PTY_EMU_sleep_until(line_ns);
+            PTY_EMU_rx_cb(chunk[i]);
+            PTY_EMU_stats.rx_bytes++;
+        }
+    }
+    return NULL;
+}
+
+
+static uint64_t PTY_EMU_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * PTY_EMU_NS_PER_S + (uint64_t)ts.tv_nsec;
+}
+
+
+static void PTY_EMU_sleep_until(uint64_t ns)
+{
+    if (ns <= PTY_EMU_now_ns())
+    {
+        return;
+    }
+    const struct timespec ts = {
+        .tv_sec  = (time_t)(ns / PTY_EMU_NS_PER_S),
+        .tv_nsec = (long)(ns % PTY_EMU_NS_PER_S),
+    };
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) ==
+           EINTR)
+    {
+    }
+}
@@ -0,0 +1,73 @@
+/**
+ * @file uart_emulator.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief source module to model the timing of the OBC uart transmit line
+ * when building application on host system (independent of target hardware)
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "targets.h"
+#include "uart_emulator.h"
+
+static uint32_t         UART_EMU_baud = UART_EMU_BAUD;
+static uint32_t         UART_EMU_idle_at_us;
+static bool             UART_EMU_sending;
+static UART_EMU_stats_t UART_EMU_stats;
+
+
+void UART_EMU_init(uint32_t baud)
+{
+    CONFIG_ASSERT(baud > 0);
+    UART_EMU_baud       = baud;
+    UART_EMU_idle_at_us = 0;
+    UART_EMU_sending    = false;
+    memset(&UART_EMU_stats, 0, sizeof(UART_EMU_stats));
+}
+
+
+int UART_EMU_tx(uint32_t now_us, const uint8_t *buf, uint16_t buflen)
+{
+    CONFIG_ASSERT(NULL != buf);
+    if (UART_EMU_busy(now_us))
+    {
+        UART_EMU_stats.dropped++;
+        return 1;
+    }
+
+    const uint64_t wire_us = ((uint64_t)buflen * UART_EMU_BITS_PER_BYTE *
+                                  1000000u +
+                              UART_EMU_baud - 1) /
+                             UART_EMU_baud;
+    UART_EMU_idle_at_us = now_us + (uint32_t)wire_us;
+    UART_EMU_sending    = true;
+    UART_EMU_stats.messages++;
+    UART_EMU_stats.bytes += buflen;
+    UART_EMU_stats.busy_us += wire_us;
+    return 0;
+}
+
+
+bool UART_EMU_busy(uint32_t now_us)
+{
+    if (UART_EMU_sending && (int32_t)(UART_EMU_idle_at_us - now_us) > 0)
+    {
+        return true;
+    }
+    UART_EMU_sending = false;
+    return false;
+}
+
+
+void UART_EMU_get_stats(UART_EMU_stats_t *stats)
+{
+    CONFIG_ASSERT(NULL != stats);
+    *stats = UART_EMU_stats;
+}
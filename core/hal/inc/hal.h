@@ -0,0 +1,203 @@
+/**
+ * @file hal.h
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Hardware abstraction layer for the peripherals used by the core
+ * modules: gpio, timers (pwm and capture), spi, i2c and uart
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ * @note The core modules drive the hardware only through the operations of
+ * HAL. On the target the operations write the MSP430F5529 registers, on a
+ * native build they act on a simulated register file that records every
+ * effect with a timestamp (see hal_native.h), so the same code path runs in
+ * the tests, in the simulator and on the flight hardware.
+ */
+#ifndef __HAL_H__
+#define __HAL_H__
+#ifdef __cplusplus
+/* clang-format off */
+extern "C"
+{
+/* clang-format on */
+#endif /* Start C linkage */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "i2c_types.h"
+
+#define HAL_PIN(n) ((uint8_t)(1u << (n)))
+
+/* Capture compare registers of the largest timer (TB0) */
+#define HAL_TIMER_CCR_CNT (7u)
+
+typedef enum
+{
+    HAL_PORT_1,
+    HAL_PORT_2,
+    HAL_PORT_3,
+    HAL_PORT_4,
+    HAL_PORT_5,
+    HAL_PORT_6,
+    HAL_PORT_7,
+    HAL_PORT_8,
+    HAL_PORT_cnt, /* must be last */
+} HAL_PORT_t;
+
+/* One or more pins of a port, used for chip selects */
+typedef struct
+{
+    HAL_PORT_t port;
+    uint8_t    pins;
+} HAL_GPIO_t;
+
+typedef enum
+{
+    HAL_TIMER_A0,
+    HAL_TIMER_A1,
+    HAL_TIMER_A2,
+    HAL_TIMER_B0,
+    HAL_TIMER_cnt, /* must be last */
+} HAL_TIMER_t;
+
+typedef enum
+{
+    HAL_TIMER_MODE_stop,
+    HAL_TIMER_MODE_up,         /* counts to CCR0 */
+    HAL_TIMER_MODE_continuous, /* counts to UINT16_MAX */
+    HAL_TIMER_MODE_updown,     /* counts to CCR0 and back to 0 */
+} HAL_TIMER_MODE_t;
+
+/**
+ * @brief Called from the timer interrupt for every edge on a capture channel
+ *
+ * @param counts captured count, extended to 32 bits with the overflows of
+ * the timer so edge to edge differences survive the 16 bit counter wrapping
+ */
+typedef void (*HAL_TIMER_capture_func)(uint8_t ccr, uint32_t counts);
+
+typedef struct
+{
+    void (*output)(HAL_PORT_t port, uint8_t pins);
+    void (*input)(HAL_PORT_t port, uint8_t pins);
+    void (*peripheral)(HAL_PORT_t port, uint8_t pins); /* PxSEL */
+    void (*set)(HAL_PORT_t port, uint8_t pins);
+    void (*clear)(HAL_PORT_t port, uint8_t pins);
+    uint8_t (*read)(HAL_PORT_t port);
+} HAL_GPIO_ops_t;
+
+typedef struct
+{
+    /**
+     * @brief Run the timer in mode. A stopped timer is cleared and sourced
+     * from SMCLK first, a running one keeps its counter and clock. period is
+     * written to CCR0 and ignored in continuous mode
+     */
+    void (*start)(HAL_TIMER_t tmr, HAL_TIMER_MODE_t mode, uint16_t period);
+
+    /**
+     * @brief Configure ccr as a pwm output (toggle/set) with a 0 compare
+     */
+    void (*pwm_channel)(HAL_TIMER_t tmr, uint8_t ccr);
+
+    /**
+     * @brief Configure ccr to capture both edges of its input pin
+     */
+    void (*capture_channel)(HAL_TIMER_t tmr, uint8_t ccr);
+
+    /**
+     * @brief Interrupt on the edges of the capture channels of tmr and give
+     * them to handler. NULL masks the capture interrupts again
+     *
+     * @note Only TB0 has a capture interrupt on the target, it shares the
+     * vector with SYSTICK
+     */
+    void (*on_capture)(HAL_TIMER_t tmr, HAL_TIMER_capture_func handler);
+
+    void (*set_compare)(HAL_TIMER_t tmr, uint8_t ccr, uint16_t counts);
+
+    /**
+     * @brief Counts in one pwm period for the current mode, 0 if stopped
+     */
+    uint32_t (*period)(HAL_TIMER_t tmr);
+
+    /**
+     * @brief Frequency of the clock sourcing the timers (SMCLK)
+     */
+    uint32_t (*clock_hz)(void);
+} HAL_TIMER_ops_t;
+
+typedef struct
+{
+    bool     clk_idle_high;  /* clock polarity */
+    bool     change_on_edge2; /* false : data changed on the first edge */
+    bool     msb_first;
+    uint16_t prescaler;
+} HAL_SPI_cfg_t;
+
+/* 3 pin master on UCB0, chip selects are gpio driven by the caller */
+typedef struct
+{
+    void (*init)(const HAL_SPI_cfg_t *cfg);
+    void (*deinit)(void);
+
+    /**
+     * @brief Clock len bytes out of tx while receiving into rx
+     *
+     * @param rx may be NULL
+     * @return int 0 on success, 1 if the bytes were not all received
+     */
+    int (*transfer)(const uint8_t *tx, uint8_t *rx, uint16_t len);
+} HAL_SPI_ops_t;
+
+/* The IMU bus, I2C1 (UCB1) */
+typedef struct
+{
+    I2C_STATUS_t (*transfer)(I2C_transaction_t *xfer);
+    int (*submit)(I2C_transaction_t *xfer);
+    I2C_STATUS_t (*poll)(void);
+} HAL_I2C_ops_t;
+
+/* The OBC uart */
+typedef struct
+{
+    /**
+     * @return int 0 on success, 1 if the transmitter is busy
+     */
+    int (*transmit)(const uint8_t *buf, uint16_t len);
+} HAL_UART_ops_t;
+
+typedef struct
+{
+    const HAL_GPIO_ops_t * gpio;
+    const HAL_TIMER_ops_t *timer;
+    const HAL_SPI_ops_t *  spi;
+    const HAL_I2C_ops_t *  i2c;
+    const HAL_UART_ops_t * uart;
+} HAL_t;
+
+/* The backend of the build, hal_msp430.c or hal_native.c */
+extern const HAL_t *const HAL;
+
+
+/**
+ * @brief Set a pwm output to pct of the period of its timer
+ *
+ * @param pct clipped to [0, 100]
+ */
+void HAL_TIMER_set_duty(HAL_TIMER_t tmr, uint8_t ccr, float pct);
+
+/**
+ * @brief Timer period in counts of the clock_hz for a pwm frequency
+ */
+uint16_t HAL_TIMER_period_for_hz(uint32_t hz);
+
+
+#ifdef __cplusplus
+/* clang-format off */
+}
+/* clang-format on */
+#endif /* End C linkage */
+#endif /* __HAL_H__ */
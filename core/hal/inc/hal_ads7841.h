@@ -0,0 +1,62 @@
+/**
+ * @file hal_ads7841.h
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief ADS7841 conversions over the HAL spi and a gpio chip select
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ * @note Every ADS7841 on the board shares UCB0 and has its own active low
+ * chip select. The channel numbers are the ADS7841_CHANNEL_t order : 0 to 3
+ * single ended, 4 to 7 differential.
+ */
+#ifndef __HAL_ADS7841_H__
+#define __HAL_ADS7841_H__
+#ifdef __cplusplus
+/* clang-format off */
+extern "C"
+{
+/* clang-format on */
+#endif /* Start C linkage */
+
+#include <stdint.h>
+
+#include "hal.h"
+
+#define HAL_ADS7841_CHANNEL_CNT (8u)
+
+/* Returned in place of the counts of a conversion that did not complete,
+ * not a possible 12 bit value */
+#define HAL_ADS7841_CONV_FAILED (UINT16_MAX)
+
+
+/**
+ * @brief Configure cs as an output and deselect the converter
+ */
+void HAL_ADS7841_init_cs(const HAL_GPIO_t *cs);
+
+/**
+ * @brief Convert cnt channels in one chip select window (12 bit, single
+ * ended or differential depending on the channel, converter stays powered)
+ *
+ * @param counts HAL_ADS7841_CONV_FAILED for a channel that failed
+ * @return int 0 on success, 1 if any conversion failed
+ */
+int HAL_ADS7841_measure(const HAL_GPIO_t *cs, const uint8_t *channels,
+                        uint16_t *counts, uint8_t cnt);
+
+/**
+ * @brief Convert one channel
+ *
+ * @return uint16_t the counts or HAL_ADS7841_CONV_FAILED
+ */
+uint16_t HAL_ADS7841_measure_channel(const HAL_GPIO_t *cs, uint8_t channel);
+
+
+#ifdef __cplusplus
+/* clang-format off */
+}
+/* clang-format on */
+#endif /* End C linkage */
+#endif /* __HAL_ADS7841_H__ */
@@ -0,0 +1,135 @@
+/**
+ * @file hal_native.h
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Inspection interface of the native (simulated) backend of the HAL
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ * @note The native backend keeps the register state of the ports and timers
+ * and appends every register level effect to a trace with the time it
+ * happened. SPI transfers go to the emulated ADS7841 whose chip select is
+ * driven low (the wiring of the board is in hal_native.c), I2C goes to the
+ * emulated bus and the uart to the emulated line.
+ */
+#ifndef __HAL_NATIVE_H__
+#define __HAL_NATIVE_H__
+#ifdef __cplusplus
+/* clang-format off */
+extern "C"
+{
+/* clang-format on */
+#endif /* Start C linkage */
+#if !defined(TARGET_MCU)
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "hal.h"
+
+/* Events kept in the trace, older ones are overwritten */
+#define HAL_NATIVE_TRACE_LEN (512u)
+
+/* SMCLK of the simulated timers, same as the launchpad (clocks.h) */
+#define HAL_NATIVE_SMCLK_HZ (1100000u)
+
+typedef enum
+{
+    HAL_NATIVE_EVT_gpio_dir,    /* port, pins, value : 1 output 0 input */
+    HAL_NATIVE_EVT_gpio_sel,    /* port, pins */
+    HAL_NATIVE_EVT_gpio_out,    /* port, pins, value : level */
+    HAL_NATIVE_EVT_timer_start, /* timer, mode, value : CCR0 */
+    HAL_NATIVE_EVT_timer_pwm,   /* timer, ccr */
+    HAL_NATIVE_EVT_timer_cap,   /* timer, ccr */
+    HAL_NATIVE_EVT_timer_ccr,   /* timer, ccr, value : compare */
+    HAL_NATIVE_EVT_spi_init,    /* value : prescaler */
+    HAL_NATIVE_EVT_spi_deinit,
+    HAL_NATIVE_EVT_spi_byte,    /* a : mosi, b : miso */
+    HAL_NATIVE_EVT_i2c,         /* a : address, b : status, value : bytes */
+    HAL_NATIVE_EVT_uart,        /* b : 0 sent 1 dropped, value : bytes */
+} HAL_NATIVE_EVT_t;
+
+typedef struct
+{
+    uint32_t         t_us;
+    HAL_NATIVE_EVT_t evt;
+    uint8_t          a; /* port, timer or byte */
+    uint8_t          b; /* pins, mode, ccr or byte */
+    uint16_t         value;
+} HAL_NATIVE_event_t;
+
+typedef struct
+{
+    uint8_t dir;
+    uint8_t sel;
+    uint8_t out;
+} HAL_NATIVE_gpio_t;
+
+typedef struct
+{
+    HAL_TIMER_MODE_t mode;
+    uint16_t         ccr[HAL_TIMER_CCR_CNT];
+    uint16_t         pwm_msk; /* bit n : CCRn is a pwm output */
+    uint16_t         cap_msk; /* bit n : CCRn captures its input */
+} HAL_NATIVE_timer_t;
+
+
+/**
+ * @brief Power on state of the registers, empty trace
+ */
+void HAL_NATIVE_reset(void);
+
+/**
+ * @brief Time source of the trace timestamps. NULL restores the default,
+ * the host monotonic clock
+ */
+void HAL_NATIVE_set_clock(uint32_t (*now_us)(void));
+
+/**
+ * @brief Events recorded since the reset, including overwritten ones
+ */
+uint32_t HAL_NATIVE_trace_count(void);
+
+/**
+ * @brief Get an event of the trace
+ *
+ * @param idx 0 is the oldest event still held
+ * @return int 0 on success, 1 if idx is past the newest event
+ */
+int HAL_NATIVE_trace_get(uint32_t idx, HAL_NATIVE_event_t *evt);
+
+void HAL_NATIVE_get_gpio(HAL_PORT_t port, HAL_NATIVE_gpio_t *gpio);
+
+void HAL_NATIVE_get_timer(HAL_TIMER_t tmr, HAL_NATIVE_timer_t *timer);
+
+/**
+ * @brief Duty cycle in percent a pwm output would drive
+ *
+ * @return float 0 if ccr is not a pwm output or the timer is stopped
+ */
+float HAL_NATIVE_get_duty(HAL_TIMER_t tmr, uint8_t ccr);
+
+/**
+ * @brief Drive the input level of pins (PxIN)
+ */
+void HAL_NATIVE_set_input(HAL_PORT_t port, uint8_t pins, bool high);
+
+/**
+ * @brief Edge on the input of ccr. Latched if ccr captures and the timer
+ * runs, then given to the on_capture handler
+ *
+ * @param counts timer count of the edge, extended to 32 bits
+ */
+void HAL_NATIVE_capture_edge(HAL_TIMER_t tmr, uint8_t ccr, uint32_t counts);
+
+#else
+#error EMULATION OF HARDWARE IS INTENDED FOR TESTING ON NATIVE PLATFORMS
+#endif /* !#if defined(TARGET_MCU) */
+
+#ifdef __cplusplus
+/* clang-format off */
+}
+/* clang-format on */
+#endif /* End C linkage */
+#endif /* __HAL_NATIVE_H__ */
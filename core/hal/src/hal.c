@@ -0,0 +1,55 @@
+/**
+ * @file hal.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Helpers of the HAL shared by every backend
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ */
+#include <stdint.h>
+
+#include "targets.h"
+#include "hal.h"
+#include "replay.h"
+
+#define HAL_DUTY_MAX_PCT (100.0f)
+
+
+void HAL_TIMER_set_duty(HAL_TIMER_t tmr, uint8_t ccr, float pct)
+{
+    CONFIG_ASSERT(tmr < HAL_TIMER_cnt);
+    if (pct < 0.0f)
+    {
+        pct = 0.0f;
+    }
+    else if (pct > HAL_DUTY_MAX_PCT)
+    {
+        pct = HAL_DUTY_MAX_PCT;
+    }
+    const uint32_t period = HAL->timer->period(tmr);
+    uint32_t       counts = (uint32_t)((pct / HAL_DUTY_MAX_PCT) * period);
+    if (counts > UINT16_MAX)
+    {
+        counts = UINT16_MAX;
+    }
+    HAL->timer->set_compare(tmr, ccr, (uint16_t)counts);
+
+    /* Every actuator command comes through here */
+    const uint8_t out[] = {(uint8_t)tmr, ccr, (uint8_t)counts,
+                           (uint8_t)(counts >> 8)};
+    REPLAY_output(REPLAY_REC_pwm, out, sizeof(out));
+}
+
+
+uint16_t HAL_TIMER_period_for_hz(uint32_t hz)
+{
+    CONFIG_ASSERT(hz > 0);
+    uint32_t period = HAL->timer->clock_hz() / hz;
+    if (period > UINT16_MAX)
+    {
+        period = UINT16_MAX;
+    }
+    return (uint16_t)period;
+}
@@ -0,0 +1,129 @@
+/**
+ * @file hal_ads7841.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief ADS7841 conversions over the HAL spi and a gpio chip select
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ * @note A conversion is 24 clocks : the control byte, then the converter
+ * answers with one busy clock followed by the 12 bits MSB first, so the
+ * result sits in bits 6..0 of the second byte and 7..3 of the third
+ * (datasheet figure 5).
+ */
+#include <stddef.h>
+#include <stdint.h>
+
+#include "targets.h"
+#include "hal_ads7841.h"
+#include "replay.h"
+#include "profiling.h"
+
+#define CTL_START (1u << 7)
+#define CTL_CHANNEL_POS (4u)
+#define CTL_SGL (1u << 2)
+#define CTL_PWR_STAY_ON (3u)
+
+#define ADS7841_SPI_PRESCALER (0x0008u)
+#define ADS7841_CONV_BYTES (3u)
+#define ADS7841_COUNTS_MSK (0x0FFFu)
+
+/* Table 1 of the datasheet, indexed by channel. The differential inputs use
+ * the same address bits with SGL cleared */
+static const uint8_t ADS7841_addr_bits[HAL_ADS7841_CHANNEL_CNT] = {
+    1u, 5u, 2u, 6u, 1u, 5u, 2u, 6u,
+};
+
+/* ADS7841 shifts data on the falling edge and latches on the rising edge so
+ * the master changes data on the first edge of an idle high clock */
+static const HAL_SPI_cfg_t ADS7841_spi_cfg = {
+    .clk_idle_high   = true,
+    .change_on_edge2 = false,
+    .msb_first       = true,
+    .prescaler       = ADS7841_SPI_PRESCALER,
+};
+
+static uint8_t ADS7841_ctrl_byte(uint8_t channel);
+
+
+void HAL_ADS7841_init_cs(const HAL_GPIO_t *cs)
+{
+    CONFIG_ASSERT(NULL != cs);
+    HAL->gpio->set(cs->port, cs->pins); /* active low */
+    HAL->gpio->output(cs->port, cs->pins);
+}
+
+
+int HAL_ADS7841_measure(const HAL_GPIO_t *cs, const uint8_t *channels,
+                        uint16_t *counts, uint8_t cnt)
+{
+    CONFIG_ASSERT(NULL != cs);
+    CONFIG_ASSERT(NULL != channels);
+    CONFIG_ASSERT(NULL != counts);
+
+    PROF_BEGIN(PROF_ads7841);
+    int status = 0;
+    HAL->spi->init(&ADS7841_spi_cfg);
+    HAL->gpio->clear(cs->port, cs->pins);
+
+    uint8_t i;
+    for (i = 0; i < cnt; i++)
+    {
+        uint8_t tx[ADS7841_CONV_BYTES] = {0};
+        uint8_t rx[ADS7841_CONV_BYTES] = {0};
+        if (channels[i] >= HAL_ADS7841_CHANNEL_CNT)
+        {
+            counts[i] = HAL_ADS7841_CONV_FAILED;
+            status    = 1;
+            continue;
+        }
+
+        tx[0] = ADS7841_ctrl_byte(channels[i]);
+        if (HAL->spi->transfer(tx, rx, sizeof(tx)))
+        {
+            counts[i] = HAL_ADS7841_CONV_FAILED;
+            status    = 1;
+        }
+        else
+        {
+            counts[i] = ((rx[1] << 5) | (rx[2] >> 3)) & ADS7841_COUNTS_MSK;
+        }
+    }
+
+    HAL->gpio->set(cs->port, cs->pins);
+    HAL->spi->deinit();
+
+    /* A failed conversion is recorded as failed and played back as such */
+    REPLAY_input(REPLAY_REC_adc, counts, (uint16_t)(cnt * sizeof(*counts)));
+    if (REPLAY_get_mode() == REPLAY_MODE_play)
+    {
+        status = 0;
+        for (i = 0; i < cnt; i++)
+        {
+            status |= (counts[i] == HAL_ADS7841_CONV_FAILED);
+        }
+    }
+    PROF_END(PROF_ads7841);
+    return status;
+}
+
+
+uint16_t HAL_ADS7841_measure_channel(const HAL_GPIO_t *cs, uint8_t channel)
+{
+    uint16_t counts;
+    HAL_ADS7841_measure(cs, &channel, &counts, 1);
+    return counts;
+}
+
+
+static uint8_t ADS7841_ctrl_byte(uint8_t channel)
+{
+    uint8_t ctrl = CTL_START | CTL_PWR_STAY_ON; /* 12 bit mode is 0 */
+    ctrl |= (uint8_t)(ADS7841_addr_bits[channel] << CTL_CHANNEL_POS);
+    if (channel < HAL_ADS7841_CHANNEL_CNT / 2)
+    {
+        ctrl |= CTL_SGL;
+    }
+    return ctrl;
+}
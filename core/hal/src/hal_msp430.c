@@ -0,0 +1,400 @@
+/**
+ * @file hal_msp430.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief MSP430F5529 backend of the HAL
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ * @note The ports and timers are written directly, spi, i2c and uart go
+ * through the peripheral drivers.
+ */
+#if defined(TARGET_MCU)
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <msp430.h>
+
+#include "targets.h"
+#include "hal.h"
+#include "clocks.h"
+#include "systick.h"
+#include "timer_a.h"
+#include "spi.h"
+#include "i2c.h"
+#include "uart.h"
+
+/* Spins allowed for the last byte of a transfer to be received, same as the
+ * ADS7841 driver */
+#define HAL_SPI_RX_TIMEOUT (1000u)
+#define HAL_SPI_RX_MAX (16u)
+
+#define HAL_TIMER_MC_MSK (MC0 | MC1)
+#define HAL_TIMER_SSEL_MSK (TASSEL0 | TASSEL1) /* TBSSELx in the same bits */
+
+typedef struct
+{
+    volatile uint16_t *ctl;
+    volatile uint16_t *cctl[HAL_TIMER_CCR_CNT];
+    volatile uint16_t *ccr[HAL_TIMER_CCR_CNT];
+    uint8_t            ccr_cnt;
+} HAL_MSP430_timer_t;
+
+/* clang-format off */
+static volatile uint8_t *const HAL_gpio_dir[HAL_PORT_cnt] = {
+    &P1DIR, &P2DIR, &P3DIR, &P4DIR, &P5DIR, &P6DIR, &P7DIR, &P8DIR,
+};
+static volatile uint8_t *const HAL_gpio_sel[HAL_PORT_cnt] = {
+    &P1SEL, &P2SEL, &P3SEL, &P4SEL, &P5SEL, &P6SEL, &P7SEL, &P8SEL,
+};
+static volatile uint8_t *const HAL_gpio_out[HAL_PORT_cnt] = {
+    &P1OUT, &P2OUT, &P3OUT, &P4OUT, &P5OUT, &P6OUT, &P7OUT, &P8OUT,
+};
+static volatile uint8_t *const HAL_gpio_in[HAL_PORT_cnt] = {
+    &P1IN, &P2IN, &P3IN, &P4IN, &P5IN, &P6IN, &P7IN, &P8IN,
+};
+
+static const HAL_MSP430_timer_t HAL_timers[HAL_TIMER_cnt] = {
+    [HAL_TIMER_A0] = {
+        .ctl  = &TA0CTL,
+        .cctl = {&TA0CCTL0, &TA0CCTL1, &TA0CCTL2, &TA0CCTL3, &TA0CCTL4},
+        .ccr  = {&TA0CCR0, &TA0CCR1, &TA0CCR2, &TA0CCR3, &TA0CCR4},
+        .ccr_cnt = 5,
+    },
+    [HAL_TIMER_A1] = {
+        .ctl  = &TA1CTL,
+        .cctl = {&TA1CCTL0, &TA1CCTL1, &TA1CCTL2},
+        .ccr  = {&TA1CCR0, &TA1CCR1, &TA1CCR2},
+        .ccr_cnt = 3,
+    },
+    [HAL_TIMER_A2] = {
+        .ctl  = &TA2CTL,
+        .cctl = {&TA2CCTL0, &TA2CCTL1, &TA2CCTL2},
+        .ccr  = {&TA2CCR0, &TA2CCR1, &TA2CCR2},
+        .ccr_cnt = 3,
+    },
+    [HAL_TIMER_B0] = {
+        .ctl  = &TB0CTL,
+        .cctl = {&TB0CCTL0, &TB0CCTL1, &TB0CCTL2, &TB0CCTL3, &TB0CCTL4,
+                 &TB0CCTL5, &TB0CCTL6},
+        .ccr  = {&TB0CCR0, &TB0CCR1, &TB0CCR2, &TB0CCR3, &TB0CCR4,
+                 &TB0CCR5, &TB0CCR6},
+        .ccr_cnt = 7,
+    },
+};
+
+static const uint16_t HAL_timer_mc[] = {
+    [HAL_TIMER_MODE_stop]       = MC__STOP,
+    [HAL_TIMER_MODE_up]         = MC__UP,
+    [HAL_TIMER_MODE_continuous] = MC__CONTINOUS,
+    [HAL_TIMER_MODE_updown]     = MC__UPDOWN,
+};
+/* clang-format on */
+
+static volatile uint8_t  HAL_spi_rx[HAL_SPI_RX_MAX];
+static volatile uint16_t HAL_spi_rx_cnt;
+
+static void     HAL_MSP430_gpio_output(HAL_PORT_t port, uint8_t pins);
+static void     HAL_MSP430_gpio_input(HAL_PORT_t port, uint8_t pins);
+static void     HAL_MSP430_gpio_peripheral(HAL_PORT_t port, uint8_t pins);
+static void     HAL_MSP430_gpio_set(HAL_PORT_t port, uint8_t pins);
+static void     HAL_MSP430_gpio_clear(HAL_PORT_t port, uint8_t pins);
+static uint8_t  HAL_MSP430_gpio_read(HAL_PORT_t port);
+static void     HAL_MSP430_timer_start(HAL_TIMER_t tmr, HAL_TIMER_MODE_t mode,
+                                       uint16_t period);
+static void     HAL_MSP430_timer_pwm_channel(HAL_TIMER_t tmr, uint8_t ccr);
+static void     HAL_MSP430_timer_capture_channel(HAL_TIMER_t tmr, uint8_t ccr);
+static void     HAL_MSP430_timer_on_capture(HAL_TIMER_t            tmr,
+                                            HAL_TIMER_capture_func handler);
+static void     HAL_MSP430_timer_set_compare(HAL_TIMER_t tmr, uint8_t ccr,
+                                             uint16_t counts);
+static uint32_t HAL_MSP430_timer_period(HAL_TIMER_t tmr);
+static uint32_t HAL_MSP430_timer_clock_hz(void);
+static void     HAL_MSP430_spi_init(const HAL_SPI_cfg_t *cfg);
+static void     HAL_MSP430_spi_deinit(void);
+static int      HAL_MSP430_spi_transfer(const uint8_t *tx, uint8_t *rx,
+                                        uint16_t len);
+static void     HAL_MSP430_spi_receive(uint8_t byte);
+static int      HAL_MSP430_uart_transmit(const uint8_t *buf, uint16_t len);
+
+static const HAL_GPIO_ops_t HAL_MSP430_gpio = {
+    .output     = HAL_MSP430_gpio_output,
+    .input      = HAL_MSP430_gpio_input,
+    .peripheral = HAL_MSP430_gpio_peripheral,
+    .set        = HAL_MSP430_gpio_set,
+    .clear      = HAL_MSP430_gpio_clear,
+    .read       = HAL_MSP430_gpio_read,
+};
+
+static const HAL_TIMER_ops_t HAL_MSP430_timer = {
+    .start           = HAL_MSP430_timer_start,
+    .pwm_channel     = HAL_MSP430_timer_pwm_channel,
+    .capture_channel = HAL_MSP430_timer_capture_channel,
+    .on_capture      = HAL_MSP430_timer_on_capture,
+    .set_compare     = HAL_MSP430_timer_set_compare,
+    .period          = HAL_MSP430_timer_period,
+    .clock_hz        = HAL_MSP430_timer_clock_hz,
+};
+
+static const HAL_SPI_ops_t HAL_MSP430_spi = {
+    .init     = HAL_MSP430_spi_init,
+    .deinit   = HAL_MSP430_spi_deinit,
+    .transfer = HAL_MSP430_spi_transfer,
+};
+
+static const HAL_I2C_ops_t HAL_MSP430_i2c = {
+    .transfer = I2C1_transfer,
+    .submit   = I2C1_submit,
+    .poll     = I2C1_poll,
+};
+
+static const HAL_UART_ops_t HAL_MSP430_uart = {
+    .transmit = HAL_MSP430_uart_transmit,
+};
+
+static const HAL_t HAL_MSP430 = {
+    .gpio  = &HAL_MSP430_gpio,
+    .timer = &HAL_MSP430_timer,
+    .spi   = &HAL_MSP430_spi,
+    .i2c   = &HAL_MSP430_i2c,
+    .uart  = &HAL_MSP430_uart,
+};
+
+const HAL_t *const HAL = &HAL_MSP430;
+
+
+static void HAL_MSP430_gpio_output(HAL_PORT_t port, uint8_t pins)
+{
+    CONFIG_ASSERT(port < HAL_PORT_cnt);
+    *HAL_gpio_sel[port] &= ~pins;
+    *HAL_gpio_dir[port] |= pins;
+}
+
+
+static void HAL_MSP430_gpio_input(HAL_PORT_t port, uint8_t pins)
+{
+    CONFIG_ASSERT(port < HAL_PORT_cnt);
+    *HAL_gpio_dir[port] &= ~pins;
+}
+
+
+static void HAL_MSP430_gpio_peripheral(HAL_PORT_t port, uint8_t pins)
+{
+    CONFIG_ASSERT(port < HAL_PORT_cnt);
+    *HAL_gpio_sel[port] |= pins;
+}
+
+
+static void HAL_MSP430_gpio_set(HAL_PORT_t port, uint8_t pins)
+{
+    CONFIG_ASSERT(port < HAL_PORT_cnt);
+    *HAL_gpio_out[port] |= pins;
+}
+
+
+static void HAL_MSP430_gpio_clear(HAL_PORT_t port, uint8_t pins)
+{
+    CONFIG_ASSERT(port < HAL_PORT_cnt);
+    *HAL_gpio_out[port] &= ~pins;
+}
+
+
+static uint8_t HAL_MSP430_gpio_read(HAL_PORT_t port)
+{
+    CONFIG_ASSERT(port < HAL_PORT_cnt);
+    return *HAL_gpio_in[port];
+}
+
+
+static void HAL_MSP430_timer_start(HAL_TIMER_t tmr, HAL_TIMER_MODE_t mode,
+                                   uint16_t period)
+{
+    CONFIG_ASSERT(tmr < HAL_TIMER_cnt);
+    const HAL_MSP430_timer_t *t = &HAL_timers[tmr];
+
+    /* Same check as SYSTICK_init: a running timer keeps its counter and
+     * clock, TB0R going back to 0 would make SYSTICK jump backwards */
+    if ((*t->ctl & HAL_TIMER_MC_MSK) == MC__STOP)
+    {
+        *t->ctl &= ~HAL_TIMER_SSEL_MSK;
+        *t->ctl |= TASSEL__SMCLK | TACLR;
+    }
+    if (mode != HAL_TIMER_MODE_continuous)
+    {
+        *t->ccr[0] = period;
+    }
+    *t->ctl = (*t->ctl & ~HAL_TIMER_MC_MSK) | HAL_timer_mc[mode];
+}
+
+
+static void HAL_MSP430_timer_pwm_channel(HAL_TIMER_t tmr, uint8_t ccr)
+{
+    CONFIG_ASSERT(tmr < HAL_TIMER_cnt);
+    const HAL_MSP430_timer_t *t = &HAL_timers[tmr];
+    CONFIG_ASSERT(ccr > 0 && ccr < t->ccr_cnt);
+
+    *t->ccr[ccr] = 0;
+    *t->cctl[ccr] &= ~(OUTMOD_MSK | CAP);
+    *t->cctl[ccr] |= OUTMOD_TOG_SET;
+}
+
+
+static void HAL_MSP430_timer_capture_channel(HAL_TIMER_t tmr, uint8_t ccr)
+{
+    CONFIG_ASSERT(tmr < HAL_TIMER_cnt);
+    const HAL_MSP430_timer_t *t = &HAL_timers[tmr];
+    CONFIG_ASSERT(ccr < t->ccr_cnt);
+
+    /* Both edges of CCIxA, synchronized to the timer clock */
+    *t->cctl[ccr] &= ~(CM0 | CM1 | CCIS0 | CCIS1 | OUTMOD_MSK);
+    *t->cctl[ccr] |= CM_3 | CCIS_0 | SCS | CAP;
+}
+
+
+static void HAL_MSP430_timer_on_capture(HAL_TIMER_t            tmr,
+                                        HAL_TIMER_capture_func handler)
+{
+    /* TA0-TA2 have no interrupt handler, SYSTICK owns the TB0 vector */
+    CONFIG_ASSERT(tmr == HAL_TIMER_B0);
+    const HAL_MSP430_timer_t *t = &HAL_timers[tmr];
+
+    SYSTICK_on_capture(handler);
+    uint8_t ccr;
+    for (ccr = 0; ccr < t->ccr_cnt; ccr++)
+    {
+        if (*t->cctl[ccr] & CAP)
+        {
+            *t->cctl[ccr] &= ~(CCIFG | COV);
+            if (NULL != handler)
+            {
+                *t->cctl[ccr] |= CCIE;
+            }
+            else
+            {
+                *t->cctl[ccr] &= ~CCIE;
+            }
+        }
+    }
+}
+
+
+static void HAL_MSP430_timer_set_compare(HAL_TIMER_t tmr, uint8_t ccr,
+                                         uint16_t counts)
+{
+    CONFIG_ASSERT(tmr < HAL_TIMER_cnt);
+    const HAL_MSP430_timer_t *t = &HAL_timers[tmr];
+    CONFIG_ASSERT(ccr < t->ccr_cnt);
+    *t->ccr[ccr] = counts;
+}
+
+
+static uint32_t HAL_MSP430_timer_period(HAL_TIMER_t tmr)
+{
+    CONFIG_ASSERT(tmr < HAL_TIMER_cnt);
+    const HAL_MSP430_timer_t *t      = &HAL_timers[tmr];
+    uint32_t                  period = 0;
+    switch (*t->ctl & HAL_TIMER_MC_MSK)
+    {
+        case MC__CONTINOUS:
+        {
+            period = UINT16_MAX;
+        }
+        break;
+        case MC__UP:
+        {
+            period = *t->ccr[0];
+        }
+        break;
+        case MC__UPDOWN:
+        {
+            period = 2u * *t->ccr[0];
+        }
+        break;
+        default:
+        {
+            period = 0;
+        }
+        break;
+    }
+    return period;
+}
+
+
+static uint32_t HAL_MSP430_timer_clock_hz(void)
+{
+    return SMCLK_FREQ;
+}
+
+
+static void HAL_MSP430_spi_init(const HAL_SPI_cfg_t *cfg)
+{
+    CONFIG_ASSERT(NULL != cfg);
+    SPI_init_struct init;
+    init.role     = SPI_ROLE_master;
+    init.phy_cfg  = SPI_PHY_3;
+    init.data_dir = cfg->msb_first ? SPI_DATA_DIR_msb : SPI_DATA_DIR_lsb;
+    init.edge_phase =
+        cfg->change_on_edge2 ? SPI_DATA_CHANGE_edge2 : SPI_DATA_CHANGE_edge1;
+    init.polarity =
+        cfg->clk_idle_high ? SPI_CLK_POLARITY_high : SPI_CLK_POLARITY_low;
+    SPI0_init(HAL_MSP430_spi_receive, &init, cfg->prescaler);
+}
+
+
+static void HAL_MSP430_spi_deinit(void)
+{
+    SPI0_deinit();
+}
+
+
+static int HAL_MSP430_spi_transfer(const uint8_t *tx, uint8_t *rx,
+                                   uint16_t len)
+{
+    CONFIG_ASSERT(NULL != tx);
+    CONFIG_ASSERT(len > 0 && len <= HAL_SPI_RX_MAX);
+
+    HAL_spi_rx_cnt = 0;
+    SPI0_enable_rx_irq();
+    SPI0_transmit(tx, len);
+
+    volatile unsigned int timeout = 0;
+    while (HAL_spi_rx_cnt < len)
+    {
+        if (++timeout > HAL_SPI_RX_TIMEOUT)
+        {
+            break;
+        }
+    }
+    SPI0_disable_rx_irq();
+
+    if (NULL != rx)
+    {
+        uint16_t i;
+        for (i = 0; i < len; i++)
+        {
+            rx[i] = HAL_spi_rx[i];
+        }
+    }
+    return (HAL_spi_rx_cnt < len) ? 1 : 0;
+}
+
+
+static void HAL_MSP430_spi_receive(uint8_t byte)
+{
+    if (HAL_spi_rx_cnt < HAL_SPI_RX_MAX)
+    {
+        HAL_spi_rx[HAL_spi_rx_cnt++] = byte;
+    }
+}
+
+
+static int HAL_MSP430_uart_transmit(const uint8_t *buf, uint16_t len)
+{
+    /* The driver does not write to the buffer */
+    return uart_transmit((uint8_t *)buf, len);
+}
+
+#endif /* #if defined(TARGET_MCU) */
@@ -0,0 +1,517 @@
+/**
+ * @file hal_native.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Native backend of the HAL : a simulated register file that records
+ * every effect with a timestamp
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ */
+#if !defined(TARGET_MCU)
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "targets.h"
+#include "hal.h"
+#include "hal_native.h"
+#include "ads7841_emulator.h"
+#include "i2c_emulator.h"
+#include "uart_emulator.h"
+
+typedef struct
+{
+    HAL_GPIO_t        cs;
+    ADS7841_EMU_DEV_t dev;
+} HAL_NATIVE_spi_wire_t;
+
+/* Chip selects of the converters on UCB0, see the pinout of each module */
+static const HAL_NATIVE_spi_wire_t HAL_NATIVE_spi_wiring[] = {
+    {{HAL_PORT_2, HAL_PIN(7)}, ADS7841_EMU_DEV_magtom},
+    {{HAL_PORT_5, HAL_PIN(1)}, ADS7841_EMU_DEV_mqtr},
+    {{HAL_PORT_5, HAL_PIN(0)}, ADS7841_EMU_DEV_rw},
+    {{HAL_PORT_4, HAL_PIN(3)}, ADS7841_EMU_DEV_sun_x_pos},
+    {{HAL_PORT_8, HAL_PIN(0)}, ADS7841_EMU_DEV_sun_x_neg},
+    {{HAL_PORT_4, HAL_PIN(2)}, ADS7841_EMU_DEV_sun_y_pos},
+    {{HAL_PORT_8, HAL_PIN(1)}, ADS7841_EMU_DEV_sun_y_neg},
+    {{HAL_PORT_4, HAL_PIN(1)}, ADS7841_EMU_DEV_sun_z_pos},
+    {{HAL_PORT_8, HAL_PIN(2)}, ADS7841_EMU_DEV_sun_z_neg},
+};
+
+/* Capture compare registers of each timer on the MSP430F5529 */
+static const uint8_t HAL_NATIVE_ccr_cnt[HAL_TIMER_cnt] = {
+    [HAL_TIMER_A0] = 5,
+    [HAL_TIMER_A1] = 3,
+    [HAL_TIMER_A2] = 3,
+    [HAL_TIMER_B0] = 7,
+};
+
+static HAL_NATIVE_gpio_t  HAL_NATIVE_gpio_regs[HAL_PORT_cnt];
+static uint8_t            HAL_NATIVE_gpio_in[HAL_PORT_cnt];
+static HAL_NATIVE_timer_t HAL_NATIVE_timer_regs[HAL_TIMER_cnt];
+static HAL_TIMER_capture_func HAL_NATIVE_capture[HAL_TIMER_cnt];
+static bool               HAL_NATIVE_spi_enabled;
+
+static HAL_NATIVE_event_t HAL_NATIVE_trace[HAL_NATIVE_TRACE_LEN];
+static uint32_t           HAL_NATIVE_trace_total;
+
+static uint32_t (*HAL_NATIVE_now_us)(void);
+
+static uint32_t HAL_NATIVE_monotonic_us(void);
+static void     HAL_NATIVE_record(HAL_NATIVE_EVT_t evt, uint8_t a, uint8_t b,
+                                  uint16_t value);
+static bool     HAL_NATIVE_cs_selected(const HAL_GPIO_t *cs);
+
+static void     HAL_NATIVE_gpio_output(HAL_PORT_t port, uint8_t pins);
+static void     HAL_NATIVE_gpio_input(HAL_PORT_t port, uint8_t pins);
+static void     HAL_NATIVE_gpio_peripheral(HAL_PORT_t port, uint8_t pins);
+static void     HAL_NATIVE_gpio_set(HAL_PORT_t port, uint8_t pins);
+static void     HAL_NATIVE_gpio_clear(HAL_PORT_t port, uint8_t pins);
+static uint8_t  HAL_NATIVE_gpio_read(HAL_PORT_t port);
+static void     HAL_NATIVE_timer_start(HAL_TIMER_t tmr, HAL_TIMER_MODE_t mode,
+                                       uint16_t period);
+static void     HAL_NATIVE_timer_pwm_channel(HAL_TIMER_t tmr, uint8_t ccr);
+static void     HAL_NATIVE_timer_capture_channel(HAL_TIMER_t tmr, uint8_t ccr);
+static void     HAL_NATIVE_timer_on_capture(HAL_TIMER_t            tmr,
+                                            HAL_TIMER_capture_func handler);
+static void     HAL_NATIVE_timer_set_compare(HAL_TIMER_t tmr, uint8_t ccr,
+                                             uint16_t counts);
+static uint32_t HAL_NATIVE_timer_period(HAL_TIMER_t tmr);
+static uint32_t HAL_NATIVE_timer_clock_hz(void);
+static void     HAL_NATIVE_spi_init(const HAL_SPI_cfg_t *cfg);
+static void     HAL_NATIVE_spi_deinit(void);
+static int      HAL_NATIVE_spi_transfer(const uint8_t *tx, uint8_t *rx,
+                                        uint16_t len);
+static I2C_STATUS_t HAL_NATIVE_i2c_transfer(I2C_transaction_t *xfer);
+static int          HAL_NATIVE_i2c_submit(I2C_transaction_t *xfer);
+static int HAL_NATIVE_uart_transmit(const uint8_t *buf, uint16_t len);
+
+static const HAL_GPIO_ops_t HAL_NATIVE_gpio = {
+    .output     = HAL_NATIVE_gpio_output,
+    .input      = HAL_NATIVE_gpio_input,
+    .peripheral = HAL_NATIVE_gpio_peripheral,
+    .set        = HAL_NATIVE_gpio_set,
+    .clear      = HAL_NATIVE_gpio_clear,
+    .read       = HAL_NATIVE_gpio_read,
+};
+
+static const HAL_TIMER_ops_t HAL_NATIVE_timer = {
+    .start           = HAL_NATIVE_timer_start,
+    .pwm_channel     = HAL_NATIVE_timer_pwm_channel,
+    .capture_channel = HAL_NATIVE_timer_capture_channel,
+    .on_capture      = HAL_NATIVE_timer_on_capture,
+    .set_compare     = HAL_NATIVE_timer_set_compare,
+    .period          = HAL_NATIVE_timer_period,
+    .clock_hz        = HAL_NATIVE_timer_clock_hz,
+};
+
+static const HAL_SPI_ops_t HAL_NATIVE_spi = {
+    .init     = HAL_NATIVE_spi_init,
+    .deinit   = HAL_NATIVE_spi_deinit,
+    .transfer = HAL_NATIVE_spi_transfer,
+};
+
+static const HAL_I2C_ops_t HAL_NATIVE_i2c = {
+    .transfer = HAL_NATIVE_i2c_transfer,
+    .submit   = HAL_NATIVE_i2c_submit,
+    .poll     = I2C_EMU_poll,
+};
+
+static const HAL_UART_ops_t HAL_NATIVE_uart = {
+    .transmit = HAL_NATIVE_uart_transmit,
+};
+
+static const HAL_t HAL_NATIVE = {
+    .gpio  = &HAL_NATIVE_gpio,
+    .timer = &HAL_NATIVE_timer,
+    .spi   = &HAL_NATIVE_spi,
+    .i2c   = &HAL_NATIVE_i2c,
+    .uart  = &HAL_NATIVE_uart,
+};
+
+const HAL_t *const HAL = &HAL_NATIVE;
+
+
+void HAL_NATIVE_reset(void)
+{
+    memset(HAL_NATIVE_gpio_regs, 0, sizeof(HAL_NATIVE_gpio_regs));
+    memset(HAL_NATIVE_gpio_in, 0, sizeof(HAL_NATIVE_gpio_in));
+    memset(HAL_NATIVE_timer_regs, 0, sizeof(HAL_NATIVE_timer_regs));
+    memset(HAL_NATIVE_capture, 0, sizeof(HAL_NATIVE_capture));
+    memset(HAL_NATIVE_trace, 0, sizeof(HAL_NATIVE_trace));
+    HAL_NATIVE_trace_total = 0;
+    HAL_NATIVE_spi_enabled = false;
+}
+
+
+void HAL_NATIVE_set_clock(uint32_t (*now_us)(void))
+{
+    HAL_NATIVE_now_us = now_us;
+}
+
+
+uint32_t HAL_NATIVE_trace_count(void)
+{
+    return HAL_NATIVE_trace_total;
+}
+
+
+int HAL_NATIVE_trace_get(uint32_t idx, HAL_NATIVE_event_t *evt)
+{
+    CONFIG_ASSERT(NULL != evt);
+    uint32_t held   = HAL_NATIVE_trace_total;
+    uint32_t oldest = 0;
+    if (held > HAL_NATIVE_TRACE_LEN)
+    {
+        oldest = held - HAL_NATIVE_TRACE_LEN;
+        held   = HAL_NATIVE_TRACE_LEN;
+    }
+    if (idx >= held)
+    {
+        return 1;
+    }
+    *evt = HAL_NATIVE_trace[(oldest + idx) % HAL_NATIVE_TRACE_LEN];
+    return 0;
+}
+
+
+void HAL_NATIVE_get_gpio(HAL_PORT_t port, HAL_NATIVE_gpio_t *gpio)
+{
+    CONFIG_ASSERT(port < HAL_PORT_cnt);
+    CONFIG_ASSERT(NULL != gpio);
+    *gpio = HAL_NATIVE_gpio_regs[port];
+}
+
+
+void HAL_NATIVE_get_timer(HAL_TIMER_t tmr, HAL_NATIVE_timer_t *timer)
+{
+    CONFIG_ASSERT(tmr < HAL_TIMER_cnt);
+    CONFIG_ASSERT(NULL != timer);
+    *timer = HAL_NATIVE_timer_regs[tmr];
+}
+
+
+float HAL_NATIVE_get_duty(HAL_TIMER_t tmr, uint8_t ccr)
+{
+    CONFIG_ASSERT(tmr < HAL_TIMER_cnt);
+    CONFIG_ASSERT(ccr < HAL_NATIVE_ccr_cnt[tmr]);
+    const uint32_t period = HAL_NATIVE_timer_period(tmr);
+    if (!(HAL_NATIVE_timer_regs[tmr].pwm_msk & (1u << ccr)) || period == 0)
+    {
+        return 0.0f;
+    }
+
+    /* Toggle/set holds the output high from the compare to the end */
+    float duty = 100.0f * HAL_NATIVE_timer_regs[tmr].ccr[ccr] / period;
+    if (duty > 100.0f)
+    {
+        duty = 100.0f;
+    }
+    return duty;
+}
+
+
+void HAL_NATIVE_set_input(HAL_PORT_t port, uint8_t pins, bool high)
+{
+    CONFIG_ASSERT(port < HAL_PORT_cnt);
+    if (high)
+    {
+        HAL_NATIVE_gpio_in[port] |= pins;
+    }
+    else
+    {
+        HAL_NATIVE_gpio_in[port] &= ~pins;
+    }
+}
+
+
+void HAL_NATIVE_capture_edge(HAL_TIMER_t tmr, uint8_t ccr, uint32_t counts)
+{
+    CONFIG_ASSERT(tmr < HAL_TIMER_cnt);
+    CONFIG_ASSERT(ccr < HAL_NATIVE_ccr_cnt[tmr]);
+    HAL_NATIVE_timer_t *t = &HAL_NATIVE_timer_regs[tmr];
+    if ((t->cap_msk & (1u << ccr)) && t->mode != HAL_TIMER_MODE_stop)
+    {
+        t->ccr[ccr] = (uint16_t)counts;
+        if (NULL != HAL_NATIVE_capture[tmr])
+        {
+            HAL_NATIVE_capture[tmr](ccr, counts);
+        }
+    }
+}
+
+
+static uint32_t HAL_NATIVE_monotonic_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000u + ts.tv_nsec / 1000u);
+}
+
+
+static void HAL_NATIVE_record(HAL_NATIVE_EVT_t evt, uint8_t a, uint8_t b,
+                              uint16_t value)
+{
+    HAL_NATIVE_event_t *e =
+        &HAL_NATIVE_trace[HAL_NATIVE_trace_total % HAL_NATIVE_TRACE_LEN];
+    e->t_us  = HAL_NATIVE_now_us ? HAL_NATIVE_now_us()
+                                 : HAL_NATIVE_monotonic_us();
+    e->evt   = evt;
+    e->a     = a;
+    e->b     = b;
+    e->value = value;
+    HAL_NATIVE_trace_total++;
+}
+
+
+static bool HAL_NATIVE_cs_selected(const HAL_GPIO_t *cs)
+{
+    const HAL_NATIVE_gpio_t *regs = &HAL_NATIVE_gpio_regs[cs->port];
+    return (regs->dir & cs->pins) && !(regs->sel & cs->pins) &&
+           !(regs->out & cs->pins);
+}
+
+
+static void HAL_NATIVE_gpio_output(HAL_PORT_t port, uint8_t pins)
+{
+    CONFIG_ASSERT(port < HAL_PORT_cnt);
+    HAL_NATIVE_gpio_regs[port].sel &= ~pins;
+    HAL_NATIVE_gpio_regs[port].dir |= pins;
+    HAL_NATIVE_record(HAL_NATIVE_EVT_gpio_dir, port, pins, 1);
+}
+
+
+static void HAL_NATIVE_gpio_input(HAL_PORT_t port, uint8_t pins)
+{
+    CONFIG_ASSERT(port < HAL_PORT_cnt);
+    HAL_NATIVE_gpio_regs[port].dir &= ~pins;
+    HAL_NATIVE_record(HAL_NATIVE_EVT_gpio_dir, port, pins, 0);
+}
+
+
+static void HAL_NATIVE_gpio_peripheral(HAL_PORT_t port, uint8_t pins)
+{
+    CONFIG_ASSERT(port < HAL_PORT_cnt);
+    HAL_NATIVE_gpio_regs[port].sel |= pins;
+    HAL_NATIVE_record(HAL_NATIVE_EVT_gpio_sel, port, pins, 1);
+}
+
+
+static void HAL_NATIVE_gpio_set(HAL_PORT_t port, uint8_t pins)
+{
+    CONFIG_ASSERT(port < HAL_PORT_cnt);
+
+    /* A rising chip select ends the conversion of its converter */
+    unsigned int i;
+    for (i = 0; i < sizeof(HAL_NATIVE_spi_wiring) /
+                        sizeof(*HAL_NATIVE_spi_wiring);
+         i++)
+    {
+        const HAL_NATIVE_spi_wire_t *w = &HAL_NATIVE_spi_wiring[i];
+        if (w->cs.port == port && (w->cs.pins & pins) &&
+            HAL_NATIVE_cs_selected(&w->cs))
+        {
+            ADS7841_EMU_spi_deselect(w->dev);
+        }
+    }
+
+    HAL_NATIVE_gpio_regs[port].out |= pins;
+    HAL_NATIVE_record(HAL_NATIVE_EVT_gpio_out, port, pins, 1);
+}
+
+
+static void HAL_NATIVE_gpio_clear(HAL_PORT_t port, uint8_t pins)
+{
+    CONFIG_ASSERT(port < HAL_PORT_cnt);
+    HAL_NATIVE_gpio_regs[port].out &= ~pins;
+    HAL_NATIVE_record(HAL_NATIVE_EVT_gpio_out, port, pins, 0);
+}
+
+
+static uint8_t HAL_NATIVE_gpio_read(HAL_PORT_t port)
+{
+    CONFIG_ASSERT(port < HAL_PORT_cnt);
+
+    /* Outputs read back their own level */
+    const HAL_NATIVE_gpio_t *regs = &HAL_NATIVE_gpio_regs[port];
+    return (uint8_t)((regs->out & regs->dir) |
+                     (HAL_NATIVE_gpio_in[port] & ~regs->dir));
+}
+
+
+static void HAL_NATIVE_timer_start(HAL_TIMER_t tmr, HAL_TIMER_MODE_t mode,
+                                   uint16_t period)
+{
+    CONFIG_ASSERT(tmr < HAL_TIMER_cnt);
+    HAL_NATIVE_timer_regs[tmr].mode = mode;
+    if (mode != HAL_TIMER_MODE_continuous)
+    {
+        HAL_NATIVE_timer_regs[tmr].ccr[0] = period;
+    }
+    HAL_NATIVE_record(HAL_NATIVE_EVT_timer_start, tmr, mode, period);
+}
+
+
+static void HAL_NATIVE_timer_pwm_channel(HAL_TIMER_t tmr, uint8_t ccr)
+{
+    CONFIG_ASSERT(tmr < HAL_TIMER_cnt);
+    CONFIG_ASSERT(ccr > 0 && ccr < HAL_NATIVE_ccr_cnt[tmr]);
+    HAL_NATIVE_timer_regs[tmr].ccr[ccr] = 0;
+    HAL_NATIVE_timer_regs[tmr].pwm_msk |= (uint16_t)(1u << ccr);
+    HAL_NATIVE_timer_regs[tmr].cap_msk &= (uint16_t)~(1u << ccr);
+    HAL_NATIVE_record(HAL_NATIVE_EVT_timer_pwm, tmr, ccr, 0);
+}
+
+
+static void HAL_NATIVE_timer_capture_channel(HAL_TIMER_t tmr, uint8_t ccr)
+{
+    CONFIG_ASSERT(tmr < HAL_TIMER_cnt);
+    CONFIG_ASSERT(ccr < HAL_NATIVE_ccr_cnt[tmr]);
+    HAL_NATIVE_timer_regs[tmr].cap_msk |= (uint16_t)(1u << ccr);
+    HAL_NATIVE_timer_regs[tmr].pwm_msk &= (uint16_t)~(1u << ccr);
+    HAL_NATIVE_record(HAL_NATIVE_EVT_timer_cap, tmr, ccr, 0);
+}
+
+
+static void HAL_NATIVE_timer_on_capture(HAL_TIMER_t            tmr,
+                                        HAL_TIMER_capture_func handler)
+{
+    CONFIG_ASSERT(tmr == HAL_TIMER_B0); /* same as the target */
+    HAL_NATIVE_capture[tmr] = handler;
+}
+
+
+static void HAL_NATIVE_timer_set_compare(HAL_TIMER_t tmr, uint8_t ccr,
+                                         uint16_t counts)
+{
+    CONFIG_ASSERT(tmr < HAL_TIMER_cnt);
+    CONFIG_ASSERT(ccr < HAL_NATIVE_ccr_cnt[tmr]);
+    HAL_NATIVE_timer_regs[tmr].ccr[ccr] = counts;
+    HAL_NATIVE_record(HAL_NATIVE_EVT_timer_ccr, tmr, ccr, counts);
+}
+
+
+static uint32_t HAL_NATIVE_timer_period(HAL_TIMER_t tmr)
+{
+    CONFIG_ASSERT(tmr < HAL_TIMER_cnt);
+    const HAL_NATIVE_timer_t *t      = &HAL_NATIVE_timer_regs[tmr];
+    uint32_t                  period = 0;
+    switch (t->mode)
+    {
+        case HAL_TIMER_MODE_continuous:
+        {
+            period = UINT16_MAX;
+        }
+        break;
+        case HAL_TIMER_MODE_up:
+        {
+            period = t->ccr[0];
+        }
+        break;
+        case HAL_TIMER_MODE_updown:
+        {
+            period = 2u * t->ccr[0];
+        }
+        break;
+        default:
+        {
+            period = 0;
+        }
+        break;
+    }
+    return period;
+}
+
+
+static uint32_t HAL_NATIVE_timer_clock_hz(void)
+{
+    return HAL_NATIVE_SMCLK_HZ;
+}
+
+
+static void HAL_NATIVE_spi_init(const HAL_SPI_cfg_t *cfg)
+{
+    CONFIG_ASSERT(NULL != cfg);
+    HAL_NATIVE_spi_enabled = true;
+    HAL_NATIVE_record(HAL_NATIVE_EVT_spi_init, 0, 0, cfg->prescaler);
+}
+
+
+static void HAL_NATIVE_spi_deinit(void)
+{
+    HAL_NATIVE_spi_enabled = false;
+    HAL_NATIVE_record(HAL_NATIVE_EVT_spi_deinit, 0, 0, 0);
+}
+
+
+static int HAL_NATIVE_spi_transfer(const uint8_t *tx, uint8_t *rx,
+                                   uint16_t len)
+{
+    CONFIG_ASSERT(NULL != tx);
+    if (!HAL_NATIVE_spi_enabled)
+    {
+        return 1;
+    }
+
+    uint16_t i;
+    for (i = 0; i < len; i++)
+    {
+        /* MISO is pulled down when no converter is selected */
+        uint8_t      miso = 0;
+        unsigned int w;
+        for (w = 0; w < sizeof(HAL_NATIVE_spi_wiring) /
+                            sizeof(*HAL_NATIVE_spi_wiring);
+             w++)
+        {
+            if (HAL_NATIVE_cs_selected(&HAL_NATIVE_spi_wiring[w].cs))
+            {
+                miso |= ADS7841_EMU_spi_transfer(HAL_NATIVE_spi_wiring[w].dev,
+                                                 tx[i]);
+            }
+        }
+        if (NULL != rx)
+        {
+            rx[i] = miso;
+        }
+        HAL_NATIVE_record(HAL_NATIVE_EVT_spi_byte, tx[i], miso, 0);
+    }
+    return 0;
+}
+
+
+static I2C_STATUS_t HAL_NATIVE_i2c_transfer(I2C_transaction_t *xfer)
+{
+    CONFIG_ASSERT(NULL != xfer);
+    I2C_STATUS_t status = I2C_EMU_transfer(xfer);
+    HAL_NATIVE_record(HAL_NATIVE_EVT_i2c, xfer->dev_addr, (uint8_t)status,
+                      xfer->txlen + xfer->rxlen);
+    return status;
+}
+
+
+static int HAL_NATIVE_i2c_submit(I2C_transaction_t *xfer)
+{
+    CONFIG_ASSERT(NULL != xfer);
+    int err = I2C_EMU_submit(xfer);
+    HAL_NATIVE_record(HAL_NATIVE_EVT_i2c, xfer->dev_addr,
+                      err ? I2C_STATUS_busy : I2C_STATUS_ok,
+                      xfer->txlen + xfer->rxlen);
+    return err;
+}
+
+
+static int HAL_NATIVE_uart_transmit(const uint8_t *buf, uint16_t len)
+{
+    const uint32_t now =
+        HAL_NATIVE_now_us ? HAL_NATIVE_now_us() : HAL_NATIVE_monotonic_us();
+    int dropped = UART_EMU_tx(now, buf, len);
+    HAL_NATIVE_record(HAL_NATIVE_EVT_uart, 0, (uint8_t)dropped, len);
+    return dropped;
+}
+
+#endif /* #if !defined(TARGET_MCU) */
@@ -0,0 +1,263 @@
+/**
+ * @file hal_native_backend.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Test the native HAL backend: the modules program the same gpio and
+ * timer state they program on the target, conversions go through the spi of
+ * the emulated ADS7841 and every access lands in the trace
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ */
+#if defined(TARGET_MCU)
+#error NATIVE TESTS CANNOT BE RUN ON A BARE METAL MICROCONTROLLER
+#endif /* #if defined(TARGET_MCU) */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "hal.h"
+#include "hal_native.h"
+#include "hal_ads7841.h"
+#include "ads7841_emulator.h"
+#include "magnetorquers.h"
+#include "reaction_wheels.h"
+#include "parameters.h"
+#include "test_expect.h"
+
+#define DUTY_TOL_PCT (0.1f)
+
+static uint32_t fake_now_us;
+
+static uint32_t fake_clock(void);
+static int      test_magnetorquers(void);
+static int      test_reaction_wheels(void);
+static int      test_ads7841_spi(void);
+static int      test_trace(void);
+
+
+int main(void)
+{
+    ADS7841_EMU_init();
+    HAL_NATIVE_reset();
+    HAL_NATIVE_set_clock(fake_clock);
+
+    EXPECT(test_magnetorquers() == 0);
+    EXPECT(test_reaction_wheels() == 0);
+    EXPECT(test_ads7841_spi() == 0);
+    EXPECT(test_trace() == 0);
+
+    HAL_NATIVE_set_clock(NULL);
+    printf("hal native backend OK\n");
+    return 0;
+}
+
+
+static uint32_t fake_clock(void)
+{
+    return fake_now_us;
+}
+
+
+static int test_magnetorquers(void)
+{
+    HAL_NATIVE_gpio_t  gpio;
+    HAL_NATIVE_timer_t tmr;
+
+    MQTR_init();
+
+    /* PWM pins routed to the timers, current sense chip deselected */
+    HAL_NATIVE_get_gpio(HAL_PORT_1, &gpio);
+    EXPECT((gpio.dir & 0x3C) == 0x3C && (gpio.sel & 0x3C) == 0x3C);
+    HAL_NATIVE_get_gpio(HAL_PORT_2, &gpio);
+    EXPECT((gpio.dir & 0x03) == 0x03 && (gpio.sel & 0x03) == 0x03);
+    HAL_NATIVE_get_gpio(HAL_PORT_5, &gpio);
+    EXPECT((gpio.dir & HAL_PIN(1)) && !(gpio.sel & HAL_PIN(1)));
+    EXPECT(gpio.out & HAL_PIN(1));
+
+    const uint16_t period =
+        HAL_NATIVE_SMCLK_HZ / (uint32_t)PARAM_get_int(PARAM_mqtr_pwm_hz);
+    HAL_NATIVE_get_timer(HAL_TIMER_A0, &tmr);
+    EXPECT(tmr.mode == HAL_TIMER_MODE_up);
+    EXPECT(tmr.ccr[0] == period);
+    EXPECT(tmr.pwm_msk == (HAL_PIN(1) | HAL_PIN(2) | HAL_PIN(3) | HAL_PIN(4)));
+    HAL_NATIVE_get_timer(HAL_TIMER_A1, &tmr);
+    EXPECT(tmr.mode == HAL_TIMER_MODE_up);
+    EXPECT(tmr.pwm_msk == (HAL_PIN(1) | HAL_PIN(2)));
+
+    /* The sign of the voltage picks the side of the bridge */
+    MQTR_set_coil_voltage_mv(MQTR_y, 1650);
+    EXPECT(fabsf(HAL_NATIVE_get_duty(HAL_TIMER_A1, 1) - 50.0f) < DUTY_TOL_PCT);
+    EXPECT(HAL_NATIVE_get_duty(HAL_TIMER_A1, 2) == 0.0f);
+    MQTR_set_coil_voltage_mv(MQTR_y, -825);
+    EXPECT(HAL_NATIVE_get_duty(HAL_TIMER_A1, 1) == 0.0f);
+    EXPECT(fabsf(HAL_NATIVE_get_duty(HAL_TIMER_A1, 2) - 25.0f) < DUTY_TOL_PCT);
+
+    /* X and Z share timer A0 without touching each other */
+    MQTR_set_coil_voltage_mv(MQTR_x, 3300);
+    MQTR_set_coil_voltage_mv(MQTR_z, -3300);
+    EXPECT(fabsf(HAL_NATIVE_get_duty(HAL_TIMER_A0, 2) - 100.0f) < DUTY_TOL_PCT);
+    EXPECT(fabsf(HAL_NATIVE_get_duty(HAL_TIMER_A0, 4) - 100.0f) < DUTY_TOL_PCT);
+    EXPECT(HAL_NATIVE_get_duty(HAL_TIMER_A0, 1) == 0.0f);
+    EXPECT(HAL_NATIVE_get_duty(HAL_TIMER_A0, 3) == 0.0f);
+
+    /* Current sense through the spi of the emulated converter */
+    const uint8_t ch = (uint8_t)PARAM_get_int(PARAM_mqtr_ch_y);
+    ADS7841_EMU_set_channel(ADS7841_EMU_DEV_mqtr, ch, 1001);
+    EXPECT(MQTR_get_current_ma(MQTR_y) ==
+           (int)(1001 * PARAM_get_float(PARAM_mqtr_ma_mv)));
+    HAL_NATIVE_get_gpio(HAL_PORT_5, &gpio);
+    EXPECT(gpio.out & HAL_PIN(1)); /* released after the conversion */
+    return 0;
+}
+
+
+static int test_reaction_wheels(void)
+{
+    HAL_NATIVE_gpio_t  gpio;
+    HAL_NATIVE_timer_t tmr;
+
+    RW_init();
+
+    HAL_NATIVE_get_timer(HAL_TIMER_A2, &tmr);
+    EXPECT(tmr.mode == HAL_TIMER_MODE_continuous);
+    EXPECT(tmr.pwm_msk == (HAL_PIN(1) | HAL_PIN(2)));
+    HAL_NATIVE_get_timer(HAL_TIMER_B0, &tmr);
+    EXPECT(tmr.mode == HAL_TIMER_MODE_continuous);
+    EXPECT(tmr.pwm_msk == HAL_PIN(5));
+    EXPECT(tmr.cap_msk == (HAL_PIN(1) | HAL_PIN(2) | HAL_PIN(6)));
+
+    /* OUTFG pins are timer inputs */
+    HAL_NATIVE_get_gpio(HAL_PORT_3, &gpio);
+    EXPECT(!(gpio.dir & HAL_PIN(6)) && (gpio.sel & HAL_PIN(6)));
+    EXPECT((gpio.dir & HAL_PIN(5)) && (gpio.sel & HAL_PIN(5)));
+
+    const float rph_mv = PARAM_get_float(PARAM_rw_rph_mv);
+    RW_set_speed_rph(REAC_WHEEL_z, (int)(-1650 * rph_mv));
+    EXPECT(RW_get_direction(REAC_WHEEL_z) == ROT_DIR_clock);
+    EXPECT(fabsf(HAL_NATIVE_get_duty(HAL_TIMER_A2, 2) - 50.0f) < DUTY_TOL_PCT);
+    EXPECT(HAL_NATIVE_get_duty(HAL_TIMER_A2, 1) == 0.0f);
+
+    RW_set_speed_rph(REAC_WHEEL_z, (int)(330 * rph_mv));
+    EXPECT(RW_get_direction(REAC_WHEEL_z) == ROT_DIR_anticlock);
+    EXPECT(fabsf(HAL_NATIVE_get_duty(HAL_TIMER_A2, 2) - 10.0f) < DUTY_TOL_PCT);
+
+    /* OUTFG of z on TB0.2, 6 edges per revolution (reaction_wheels.c).
+     * 11000 counts apart at 1.1 MHz is 50/3 rev/s, across the 32 bit wrap */
+    const float rev_rph = 2.0f * 3.14159265f * 3600.0f;
+    int32_t     rph;
+    EXPECT(RW_get_speed_rph(REAC_WHEEL_z, &rph) == 1 && rph == 0);
+    HAL_NATIVE_capture_edge(HAL_TIMER_B0, 2, 0xFFFFF000u);
+    EXPECT(RW_get_speed_rph(REAC_WHEEL_z, &rph) == 1 && rph == 0);
+    HAL_NATIVE_capture_edge(HAL_TIMER_B0, 2, 0xFFFFF000u + 11000u);
+    HAL_NATIVE_capture_edge(HAL_TIMER_B0, 2, 0xFFFFF000u + 22000u);
+    EXPECT(RW_get_speed_rph(REAC_WHEEL_z, &rph) == 0);
+    EXPECT(fabsf(rph - rev_rph * 50.0f / 3.0f) < rev_rph * 0.01f);
+    EXPECT(RW_get_speed_rph(REAC_WHEEL_y, &rph) == 1);
+
+    /* Signed with the commanded direction */
+    RW_set_speed_rph(REAC_WHEEL_z, (int)(-330 * rph_mv));
+    HAL_NATIVE_capture_edge(HAL_TIMER_B0, 2, 0xFFFFF000u + 33000u);
+    HAL_NATIVE_capture_edge(HAL_TIMER_B0, 2, 0xFFFFF000u + 44000u);
+    EXPECT(RW_get_speed_rph(REAC_WHEEL_z, &rph) == 0);
+    EXPECT(fabsf(rph + rev_rph * 50.0f / 3.0f) < rev_rph * 0.01f);
+    return 0;
+}
+
+
+static int test_ads7841_spi(void)
+{
+    static const uint16_t counts[HAL_ADS7841_CHANNEL_CNT] = {
+        0, 1, 2048, 4095, 0x555, 0xAAA, 7, 4094,
+    };
+    static const uint8_t channels[HAL_ADS7841_CHANNEL_CNT] = {
+        0, 1, 2, 3, 4, 5, 6, 7,
+    };
+    const HAL_GPIO_t cs = {.port = HAL_PORT_4, .pins = HAL_PIN(1)};
+    uint16_t         measured[HAL_ADS7841_CHANNEL_CNT];
+    uint8_t          ch;
+
+    /* Every bit survives the trip, including the LSB */
+    for (ch = 0; ch < HAL_ADS7841_CHANNEL_CNT; ch++)
+    {
+        ADS7841_EMU_set_channel(ADS7841_EMU_DEV_sun_z_pos, ch, counts[ch]);
+    }
+    HAL_ADS7841_init_cs(&cs);
+    EXPECT(HAL_ADS7841_measure(&cs, channels, measured,
+                               HAL_ADS7841_CHANNEL_CNT) == 0);
+    for (ch = 0; ch < HAL_ADS7841_CHANNEL_CNT; ch++)
+    {
+        EXPECT(measured[ch] == counts[ch]);
+    }
+
+    /* Nothing drives MISO without a chip selected */
+    const HAL_GPIO_t unwired = {.port = HAL_PORT_6, .pins = HAL_PIN(0)};
+    HAL_ADS7841_init_cs(&unwired);
+    EXPECT(HAL_ADS7841_measure_channel(&unwired, 3) == 0);
+
+    /* A channel out of range is not converted */
+    EXPECT(HAL_ADS7841_measure_channel(&cs, HAL_ADS7841_CHANNEL_CNT) ==
+           HAL_ADS7841_CONV_FAILED);
+    return 0;
+}
+
+
+static int test_trace(void)
+{
+    static const uint8_t ch3 = 3;
+    const HAL_GPIO_t     cs  = {.port = HAL_PORT_8, .pins = HAL_PIN(2)};
+    HAL_NATIVE_event_t   evt;
+    uint16_t             counts;
+
+    HAL_NATIVE_reset();
+    EXPECT(HAL_NATIVE_trace_count() == 0);
+    EXPECT(HAL_NATIVE_trace_get(0, &evt) == 1);
+
+    fake_now_us = 1000;
+    HAL_ADS7841_init_cs(&cs);
+    fake_now_us = 2000;
+    ADS7841_EMU_set_channel(ADS7841_EMU_DEV_sun_z_neg, ch3, 0x9C3);
+    EXPECT(HAL_ADS7841_measure(&cs, &ch3, &counts, 1) == 0);
+    EXPECT(counts == 0x9C3);
+
+    /* set, output, spi init, select, 3 bytes, deselect, spi deinit */
+    EXPECT(HAL_NATIVE_trace_count() == 9);
+    EXPECT(HAL_NATIVE_trace_get(0, &evt) == 0);
+    EXPECT(evt.t_us == 1000 && evt.evt == HAL_NATIVE_EVT_gpio_out);
+    EXPECT(evt.a == HAL_PORT_8 && evt.b == HAL_PIN(2) && evt.value == 1);
+    EXPECT(HAL_NATIVE_trace_get(1, &evt) == 0);
+    EXPECT(evt.evt == HAL_NATIVE_EVT_gpio_dir && evt.value == 1);
+    EXPECT(HAL_NATIVE_trace_get(2, &evt) == 0);
+    EXPECT(evt.t_us == 2000 && evt.evt == HAL_NATIVE_EVT_spi_init);
+    EXPECT(HAL_NATIVE_trace_get(3, &evt) == 0);
+    EXPECT(evt.evt == HAL_NATIVE_EVT_gpio_out && evt.value == 0);
+
+    /* Start, channel 3 address, single ended, power stays on */
+    EXPECT(HAL_NATIVE_trace_get(4, &evt) == 0);
+    EXPECT(evt.evt == HAL_NATIVE_EVT_spi_byte && evt.a == 0xE7);
+    EXPECT(HAL_NATIVE_trace_get(5, &evt) == 0);
+    EXPECT(evt.b == ((0x9C3 >> 5) & 0x7F));
+    EXPECT(HAL_NATIVE_trace_get(6, &evt) == 0);
+    EXPECT(evt.b == ((0x9C3 << 3) & 0xF8));
+
+    EXPECT(HAL_NATIVE_trace_get(7, &evt) == 0);
+    EXPECT(evt.evt == HAL_NATIVE_EVT_gpio_out && evt.value == 1);
+    EXPECT(HAL_NATIVE_trace_get(8, &evt) == 0);
+    EXPECT(evt.evt == HAL_NATIVE_EVT_spi_deinit);
+    EXPECT(HAL_NATIVE_trace_get(9, &evt) == 1);
+
+    /* The oldest events are overwritten once the trace is full */
+    uint32_t i;
+    for (i = 0; i < HAL_NATIVE_TRACE_LEN; i++)
+    {
+        fake_now_us = 3000 + i;
+        HAL->gpio->set(HAL_PORT_7, HAL_PIN(0));
+    }
+    EXPECT(HAL_NATIVE_trace_count() == 9 + HAL_NATIVE_TRACE_LEN);
+    EXPECT(HAL_NATIVE_trace_get(0, &evt) == 0);
+    EXPECT(evt.t_us == 3000 && evt.a == HAL_PORT_7);
+    EXPECT(HAL_NATIVE_trace_get(HAL_NATIVE_TRACE_LEN, &evt) == 1);
+    return 0;
+}
@@ -7,10 +7,131 @@ extern "C"
 /* clang-format on */
 #endif /* Start C linkage */
 
+#include <stdint.h>
+
+#include "attitude_types.h"
+#include "json_writer.h"
+
+#define IMU_I2C_ADDR (0x28) /* BNO055 with COM3 pulled low */
+
+#define IMU_SAMPLE_PERIOD_MS_DEFAULT (100)
+#define IMU_SAMPLE_RING_LEN (8) /* must be a power of 2 */
+
+/**
+ * @brief One burst read of the BNO055 data registers, raw units
+ * (datasheet section 3.6.5)
+ */
+typedef struct
+{
+    uint32_t timestamp_us; /* completion of the burst read */
+    int16_t  accel[3];     /* 1 m/s^2 == 100 LSB */
+    int16_t  mag[3];       /* 1 uT == 16 LSB */
+    int16_t  gyro[3];      /* 1 dps == 16 LSB */
+    int16_t  quat[4];      /* w, x, y, z. 1 == 16384 LSB */
+} IMU_sample_t;
+
+typedef struct
+{
+    uint32_t samples; /* pushed into the ring */
+    uint32_t dropped; /* acquired while the ring was full */
+    uint32_t errors;  /* failed bus transactions */
+    uint32_t skipped; /* due while the previous read was still pending */
+    uint32_t latency_us_last; /* due time to sample available */
+    uint32_t latency_us_max;
+    uint32_t latency_us_mean;
+    float    bus_utilisation; /* fraction of time the bus was busy with IMU
+                                 reads since the stats were reset */
+} IMU_acq_stats_t;
+
 
 void IMU_init(void);
 
-int IMU_measurements_to_string(char *buf, unsigned int buflen);
+/**
+ * @brief Write the newest body rates in degrees per second as a json array
+ *
+ * @return 0 on success, 1 if no sample was acquired yet or w is full
+ */
+int IMU_measurements_to_json(JW_t *w);
+
+/**
+ * @brief Get the fused attitude and the body rate from the newest sample.
+ *
+ * @note Consumes every sample in the ring, the older ones are dropped. Use
+ * IMU_attitude_pop instead to process each sample.
+ *
+ * @param q attitude quaternion (body to reference frame)
+ * @param rate_radps body angular rate in radians per second
+ * @return 0 on success, 1 if no sample was acquired since the last call
+ */
+int IMU_get_attitude(quat_t *q, vec3_t *rate_radps);
+
+/**
+ * @brief Get the attitude and the body rate of the oldest sample and remove
+ * it from the ring
+ *
+ * @param q attitude quaternion (body to reference frame)
+ * @param rate_radps body angular rate in radians per second
+ * @param timestamp_us completion of the burst read of the sample
+ * @return 0 on success, 1 if the ring is empty
+ */
+int IMU_attitude_pop(quat_t *q, vec3_t *rate_radps, uint32_t *timestamp_us);
+
+/**
+ * @brief Convert a raw sample to attitude and body rate
+ */
+void IMU_sample_to_attitude(const IMU_sample_t *sample, quat_t *q,
+                            vec3_t *rate_radps);
+
+/**
+ * @brief Set the acquisition rate. 0 stops the acquisition.
+ */
+void IMU_set_sample_period_ms(uint16_t period_ms);
+
+/**
+ * @brief Start a burst read of the data registers when one is due.
+ *
+ * @note Call this from the main loop at least as often as the sample period.
+ * The read completes in the background and its sample is pushed into the
+ * sample ring.
+ *
+ * @param now_us current time in microseconds
+ */
+void IMU_acquire(uint32_t now_us);
+
+/**
+ * @brief Pop the oldest sample from the sample ring
+ *
+ * @return 0 on success, 1 if the ring is empty
+ */
+int IMU_sample_pop(IMU_sample_t *sample);
+
+/**
+ * @brief Number of samples waiting in the sample ring
+ */
+unsigned int IMU_sample_count(void);
+
+void IMU_get_acq_stats(IMU_acq_stats_t *stats);
+
+void IMU_reset_acq_stats(void);
+
+int IMU_acq_stats_to_json(JW_t *w);
+
+/**
+ * @brief Read consecutive registers from the IMU (write register address,
+ * repeated start, read cnt bytes)
+ *
+ * @return 0 on success, 1 on bus error
+ */
+int IMU_read_registers(uint8_t dev_addr, uint8_t reg_addr, uint8_t *data,
+                       uint8_t cnt);
+
+/**
+ * @brief Write consecutive registers of the IMU starting at reg_addr
+ *
+ * @return 0 on success, 1 on bus error or if cnt is too large
+ */
+int IMU_write_registers(uint8_t dev_addr, uint8_t reg_addr,
+                        const uint8_t *data, uint8_t cnt);
 
 #ifdef __cplusplus
 /* clang-format off */
@@ -16,6 +16,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdint.h>
+#include <stdbool.h>
 
 #include "targets.h"
 #include "imu.h"
@@ -26,15 +27,20 @@
  * DRIVER LEVEL API CALLS IN THE FUTURE */
 #include <msp430.h>
 
-#include "i2c.h"
 #include "bno055.h"
+#include "timebase.h"
 
 #endif /* #if defined(TARGET_MCU) */
 
+#include "imu_bus.h"
 
-#define I2C_BUFFER_LEN 8
-#define I2C0 5
-#define BNO055_I2C_BUS_WRITE_ARRAY_INDEX ((u8)1)
+/* Largest register burst written in one transaction */
+#define IMU_I2C_WRITE_MAX (32)
+
+/* BNO055 output scaling (datasheet section 3.6.5) */
+#define IMU_QUAT_LSB_PER_UNIT (16384.0f)
+#define IMU_GYRO_LSB_PER_DPS (16.0f)
+#define IMU_RAD_PER_DEG (0.01745329f)
 
 
 /*
@@ -57,18 +63,84 @@ static void IMU_init_i2c(void);
 #endif /* #if defined(TARGET_MCU) */
 
 
+static IMU_sample_t IMU_last_sample;
+static bool         IMU_last_sample_valid;
+
+
 /* format from interface document : {"imu" : [ +5, +2, -3] } */
-int IMU_measurements_to_string(char *buf, unsigned int buflen)
+int IMU_measurements_to_json(JW_t *w)
+{
+    CONFIG_ASSERT(w != NULL);
+    if (!IMU_last_sample_valid)
+    {
+        return 1;
+    }
+
+    /* body rates in degrees per second */
+    JW_array_begin(w);
+    JW_float(w, IMU_last_sample.gyro[0] / IMU_GYRO_LSB_PER_DPS, 2);
+    JW_float(w, IMU_last_sample.gyro[1] / IMU_GYRO_LSB_PER_DPS, 2);
+    JW_float(w, IMU_last_sample.gyro[2] / IMU_GYRO_LSB_PER_DPS, 2);
+    JW_array_end(w);
+    return JW_error(w);
+}
+
+
+int IMU_get_attitude(quat_t *q, vec3_t *rate_radps)
+{
+    CONFIG_ASSERT(NULL != q);
+    CONFIG_ASSERT(NULL != rate_radps);
+
+    uint32_t timestamp_us;
+    if (IMU_attitude_pop(q, rate_radps, &timestamp_us))
+    {
+        return 1;
+    }
+    while (IMU_attitude_pop(q, rate_radps, &timestamp_us) == 0)
+    {
+    }
+    return 0;
+}
+
+
+int IMU_attitude_pop(quat_t *q, vec3_t *rate_radps, uint32_t *timestamp_us)
 {
-    CONFIG_ASSERT(buf != NULL);
+    CONFIG_ASSERT(NULL != q);
+    CONFIG_ASSERT(NULL != rate_radps);
+    CONFIG_ASSERT(NULL != timestamp_us);
 
-    /** @todo IMLEMENT */
-#warning IMPLEMENT IMU_init_i2c IN TERMS OF THE I2C API DRIVER FUNCTIONS
+    IMU_sample_t sample;
+    if (IMU_sample_pop(&sample))
+    {
+        return 1;
+    }
 
+    IMU_last_sample       = sample;
+    IMU_last_sample_valid = true;
+    IMU_sample_to_attitude(&sample, q, rate_radps);
+    *timestamp_us = sample.timestamp_us;
     return 0;
 }
 
 
+void IMU_sample_to_attitude(const IMU_sample_t *sample, quat_t *q,
+                            vec3_t *rate_radps)
+{
+    CONFIG_ASSERT(NULL != sample);
+    CONFIG_ASSERT(NULL != q);
+    CONFIG_ASSERT(NULL != rate_radps);
+
+    q->w = sample->quat[0] / IMU_QUAT_LSB_PER_UNIT;
+    q->x = sample->quat[1] / IMU_QUAT_LSB_PER_UNIT;
+    q->y = sample->quat[2] / IMU_QUAT_LSB_PER_UNIT;
+    q->z = sample->quat[3] / IMU_QUAT_LSB_PER_UNIT;
+
+    rate_radps->x = (sample->gyro[0] / IMU_GYRO_LSB_PER_DPS) * IMU_RAD_PER_DEG;
+    rate_radps->y = (sample->gyro[1] / IMU_GYRO_LSB_PER_DPS) * IMU_RAD_PER_DEG;
+    rate_radps->z = (sample->gyro[2] / IMU_GYRO_LSB_PER_DPS) * IMU_RAD_PER_DEG;
+}
+
+
 void IMU_init(void)
 {
 #if defined(TARGET_MCU)
@@ -78,105 +150,100 @@ void IMU_init(void)
     bno055.bus_read   = BNO055_I2C_bus_read;
     bno055.bus_write  = BNO055_I2C_bus_write;
     bno055.delay_msec = BNO055_delay_msek;
-    bno055.bus_read   = bno055_init(&bno055);
+    bno055.dev_addr   = IMU_I2C_ADDR;
+    bno055_init(&bno055);
+    bno055_set_operation_mode(BNO055_OPERATION_MODE_NDOF);
 
 #else
 
     printf("Called %s\n", __func__);
 
 #endif /* #if defined(TARGET_MCU) */
+
+    IMU_last_sample_valid = false;
+    IMU_set_sample_period_ms(IMU_SAMPLE_PERIOD_MS_DEFAULT);
+    IMU_reset_acq_stats();
 }
 
 
-static void IMU_init_i2c(void)
+/* SEE SECTION 4.6 OF DATASHEET */
+int IMU_read_registers(uint8_t dev_addr, uint8_t reg_addr, uint8_t *data,
+                       uint8_t cnt)
 {
-#if defined(TARGET_MCU)
-
-    /* We use I2C1 (using UCB1) for i2c with IMU */
-    I2C1_init();
-
-#endif /* #if defined(TARGET_MCU) */
+    CONFIG_ASSERT(NULL != data);
+    I2C_transaction_t xfer;
+    memset(&xfer, 0, sizeof(xfer));
+    xfer.dev_addr = dev_addr;
+    xfer.tx       = &reg_addr;
+    xfer.txlen    = sizeof(reg_addr);
+    xfer.rx       = data;
+    xfer.rxlen    = cnt;
+    if (IMU_BUS_transfer(&xfer) != I2C_STATUS_ok)
+    {
+        return 1;
+    }
+    return 0;
 }
 
 
-#if defined(TARGET_MCU)
-
-
-static s8 BNO055_I2C_bus_read(u8 dev_addr, u8 reg_addr, u8 *reg_data, u8 cnt)
+int IMU_write_registers(uint8_t dev_addr, uint8_t reg_addr,
+                        const uint8_t *data, uint8_t cnt)
 {
-
-    /** @todo */
-#warning THIS NEEDS TO BE IMLPEMENTED
-
-    s32 BNO055_iERROR = BNO055_INIT_VALUE;
-#if 0
-    u8  array[I2C_BUFFER_LEN] = {BNO055_INIT_VALUE};
-    u8  stringpos             = BNO055_INIT_VALUE;
-
-
-    array[BNO055_INIT_VALUE] = reg_addr;
-
-    /* Please take the below API as your reference
-     * for read the data using I2C communication
-     * add your I2C read API here.
-     * "BNO055_iERROR = I2C_WRITE_READ_STRING(DEV_ADDR,
-     * ARRAY, ARRAY, 1, CNT)"
-     * BNO055_iERROR is an return value of SPI write API
-     * Please select your valid return value
-     * In the driver BNO055_SUCCESS defined as 0
-     * and FAILURE defined as -1
-     */
-    for (stringpos = BNO055_INIT_VALUE; stringpos < cnt; stringpos++)
+    CONFIG_ASSERT(NULL != data);
+    uint8_t txbuf[sizeof(reg_addr) + IMU_I2C_WRITE_MAX];
+    if (cnt > IMU_I2C_WRITE_MAX)
+    {
+        return 1;
+    }
+    txbuf[0] = reg_addr;
+    memcpy(&txbuf[sizeof(reg_addr)], data, cnt); /* register data is binary */
+
+    I2C_transaction_t xfer;
+    memset(&xfer, 0, sizeof(xfer));
+    xfer.dev_addr = dev_addr;
+    xfer.tx       = txbuf;
+    xfer.txlen    = sizeof(reg_addr) + cnt;
+    if (IMU_BUS_transfer(&xfer) != I2C_STATUS_ok)
     {
-        *(reg_data + stringpos) = array[stringpos];
+        return 1;
     }
-#endif
-    return (s8)BNO055_iERROR;
+    return 0;
 }
 
 
-s8 BNO055_I2C_bus_write(u8 dev_addr, u8 reg_addr, u8 *reg_data, u8 cnt)
-{
-    s32 BNO055_iERROR = BNO055_INIT_VALUE;
+#if defined(TARGET_MCU)
 
 
-    char txbuf[50]; /* just hard coding this for now */
-    txbuf[0] = reg_addr;
+static void IMU_init_i2c(void)
+{
+    /* We use I2C1 (using UCB1) for i2c with IMU */
+    I2C1_init();
+}
 
-    unsigned int bcnt = sizeof(reg_addr) + cnt;
-    if (bcnt > sizeof(txbuf))
-    {
-        bcnt = sizeof(txbuf);
-    }
-    strncpy(&txbuf[1], (char *)reg_data, bcnt);
 
-    int write_status = I2C1_write_bytes((uint8_t)dev_addr, txbuf, bcnt);
-    if (write_status != 0 && write_status != -1)
+static s8 BNO055_I2C_bus_read(u8 dev_addr, u8 reg_addr, u8 *reg_data, u8 cnt)
+{
+    if (IMU_read_registers(dev_addr, reg_addr, reg_data, cnt))
     {
-        BNO055_iERROR = BNO055_SUCCESS;
+        return (s8)BNO055_ERROR;
     }
+    return (s8)BNO055_SUCCESS;
+}
 
-    /* SEE SECTION 4.6 OF DATASHEET */
-#if 0
-    u8  array[I2C_BUFFER_LEN];
-    u8  stringpos = BNO055_INIT_VALUE;
 
-    array[BNO055_INIT_VALUE] = reg_addr;
-    for (stringpos = BNO055_INIT_VALUE; stringpos < cnt; stringpos++)
+static s8 BNO055_I2C_bus_write(u8 dev_addr, u8 reg_addr, u8 *reg_data, u8 cnt)
+{
+    if (IMU_write_registers(dev_addr, reg_addr, reg_data, cnt))
     {
-        array[stringpos + BNO055_I2C_BUS_WRITE_ARRAY_INDEX] =
-            *(reg_data + stringpos);
+        return (s8)BNO055_ERROR;
     }
-#endif
-    return (s8)BNO055_iERROR;
+    return (s8)BNO055_SUCCESS;
 }
 
 
 static void BNO055_delay_msek(u32 msek)
 {
-/** @todo */
-#warning THIS NEEDS TO BE IMLPEMENTED
-    /*Here you can write your own delay routine*/
+    TIMEBASE_delay_ms(msek);
 }
 
 
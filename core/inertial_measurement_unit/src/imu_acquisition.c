@@ -0,0 +1,292 @@
+/**
+ * @file imu_acquisition.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Periodic burst read of the BNO055 data registers into a ring of
+ * timestamped samples
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ * @note Accel, mag, gyro, euler and quaternion data are contiguous on page 0
+ * (0x08 - 0x27) so a single 32 byte transaction reads a coherent sample. The
+ * euler angles are read through but not kept.
+ *
+ * The completion callback runs from the I2C interrupt on the target. It is
+ * the only writer of the ring head and the main loop is the only writer of
+ * the ring tail.
+ */
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "targets.h"
+#include "imu.h"
+#include "imu_bus.h"
+#include "replay.h"
+
+#define IMU_BURST_START_ADDR (0x08) /* ACC_DATA_X_LSB */
+#define IMU_BURST_LEN (32)          /* through QUA_DATA_Z_MSB */
+#define IMU_BURST_ACCEL_OFFSET (0)
+#define IMU_BURST_MAG_OFFSET (6)
+#define IMU_BURST_GYRO_OFFSET (12)
+#define IMU_BURST_QUAT_OFFSET (24)
+
+#define IMU_SAMPLE_RING_MASK ((IMU_SAMPLE_RING_LEN)-1)
+#define IMU_US_PER_MS (1000u)
+
+#if ((IMU_SAMPLE_RING_LEN) & (IMU_SAMPLE_RING_MASK)) != 0
+#error IMU_SAMPLE_RING_LEN MUST BE A POWER OF 2
+#endif /* IMU_SAMPLE_RING_LEN is not a power of 2 */
+
+typedef struct
+{
+    uint32_t samples;
+    uint32_t dropped;
+    uint32_t errors;
+    uint32_t skipped;
+    uint32_t latency_us_last;
+    uint32_t latency_us_max;
+    uint64_t latency_us_sum;
+    uint32_t busy_us;
+    uint32_t window_start_us;
+} IMU_acq_counters_t;
+
+
+static IMU_sample_t     IMU_ring[IMU_SAMPLE_RING_LEN];
+static volatile uint8_t IMU_ring_head; /* written by completion only */
+static volatile uint8_t IMU_ring_tail; /* written by consumer only */
+
+static I2C_transaction_t IMU_acq_xfer;
+static const uint8_t     IMU_acq_reg = IMU_BURST_START_ADDR;
+static uint8_t           IMU_acq_buf[IMU_BURST_LEN];
+static volatile bool     IMU_acq_pending;
+static uint32_t          IMU_acq_due_us;
+static uint32_t          IMU_acq_submit_us;
+
+static uint32_t IMU_acq_period_us;
+static bool     IMU_acq_started;
+static uint32_t IMU_acq_next_us;
+
+static volatile IMU_acq_counters_t IMU_acq_counters;
+
+
+static void    IMU_acq_complete(I2C_STATUS_t status, void *ctx);
+static int16_t IMU_acq_s16(unsigned int offset);
+
+
+void IMU_set_sample_period_ms(uint16_t period_ms)
+{
+    IMU_acq_period_us = (uint32_t)period_ms * IMU_US_PER_MS;
+    IMU_acq_started   = false;
+}
+
+
+void IMU_acquire(uint32_t now_us)
+{
+    if (IMU_acq_pending)
+    {
+        IMU_BUS_poll(); /* enforce the transaction timeout */
+    }
+
+    if (IMU_acq_period_us == 0)
+    {
+        return;
+    }
+
+    if (!IMU_acq_started)
+    {
+        IMU_acq_started = true;
+        IMU_acq_next_us = now_us;
+    }
+
+    if ((int32_t)(now_us - IMU_acq_next_us) < 0)
+    {
+        return;
+    }
+
+    uint32_t due_us = IMU_acq_next_us;
+    IMU_acq_next_us += IMU_acq_period_us;
+    if ((int32_t)(now_us - IMU_acq_next_us) >= 0)
+    {
+        IMU_acq_next_us = now_us + IMU_acq_period_us; /* fell behind */
+    }
+
+    if (IMU_acq_pending)
+    {
+        IMU_acq_counters.skipped++;
+        return;
+    }
+
+    memset(&IMU_acq_xfer, 0, sizeof(IMU_acq_xfer));
+    IMU_acq_xfer.dev_addr = IMU_I2C_ADDR;
+    IMU_acq_xfer.tx       = &IMU_acq_reg;
+    IMU_acq_xfer.txlen    = sizeof(IMU_acq_reg);
+    IMU_acq_xfer.rx       = IMU_acq_buf;
+    IMU_acq_xfer.rxlen    = sizeof(IMU_acq_buf);
+    IMU_acq_xfer.callback = IMU_acq_complete;
+
+    IMU_acq_due_us    = due_us;
+    IMU_acq_submit_us = IMU_BUS_now_us();
+    IMU_acq_pending   = true;
+    if (IMU_BUS_submit(&IMU_acq_xfer))
+    {
+        /* bus is busy with a blocking transfer of the bno055 driver */
+        IMU_acq_pending = false;
+        IMU_acq_counters.skipped++;
+    }
+}
+
+
+int IMU_sample_pop(IMU_sample_t *sample)
+{
+    CONFIG_ASSERT(NULL != sample);
+    if (REPLAY_get_mode() == REPLAY_MODE_play)
+    {
+        /* The bus still runs, its samples are replaced by the recorded */
+        uint16_t len = sizeof(*sample);
+        IMU_ring_tail = IMU_ring_head;
+        return REPLAY_input_due(REPLAY_REC_imu, sample, &len) ||
+               len != sizeof(*sample);
+    }
+
+    uint8_t tail = IMU_ring_tail;
+    if (tail == IMU_ring_head)
+    {
+        return 1;
+    }
+    *sample       = IMU_ring[tail & IMU_SAMPLE_RING_MASK];
+    IMU_ring_tail = (uint8_t)(tail + 1);
+    REPLAY_record(REPLAY_REC_imu, sample, sizeof(*sample));
+    return 0;
+}
+
+
+unsigned int IMU_sample_count(void)
+{
+    return (uint8_t)(IMU_ring_head - IMU_ring_tail);
+}
+
+
+void IMU_get_acq_stats(IMU_acq_stats_t *stats)
+{
+    CONFIG_ASSERT(NULL != stats);
+    IMU_acq_counters_t c;
+
+    IMU_BUS_LOCK();
+    memcpy(&c, (const void *)&IMU_acq_counters, sizeof(c));
+    IMU_BUS_UNLOCK();
+
+    stats->samples         = c.samples;
+    stats->dropped         = c.dropped;
+    stats->errors          = c.errors;
+    stats->skipped         = c.skipped;
+    stats->latency_us_last = c.latency_us_last;
+    stats->latency_us_max  = c.latency_us_max;
+    stats->latency_us_mean = 0;
+    if (c.samples > 0)
+    {
+        stats->latency_us_mean = (uint32_t)(c.latency_us_sum / c.samples);
+    }
+
+    stats->bus_utilisation = 0.0f;
+    uint32_t window_us     = IMU_BUS_now_us() - c.window_start_us;
+    if (window_us > 0)
+    {
+        stats->bus_utilisation = (float)c.busy_us / (float)window_us;
+    }
+}
+
+
+void IMU_reset_acq_stats(void)
+{
+    IMU_BUS_LOCK();
+    memset((void *)&IMU_acq_counters, 0, sizeof(IMU_acq_counters));
+    IMU_acq_counters.window_start_us = IMU_BUS_now_us();
+    IMU_BUS_UNLOCK();
+}
+
+
+int IMU_acq_stats_to_json(JW_t *w)
+{
+    CONFIG_ASSERT(NULL != w);
+    IMU_acq_stats_t s;
+    IMU_get_acq_stats(&s);
+    JW_object_begin(w);
+    JW_key(w, "n");
+    JW_uint(w, s.samples);
+    JW_key(w, "drop");
+    JW_uint(w, s.dropped);
+    JW_key(w, "err");
+    JW_uint(w, s.errors);
+    JW_key(w, "skip");
+    JW_uint(w, s.skipped);
+    JW_key(w, "lat_us");
+    JW_uint(w, s.latency_us_last);
+    JW_key(w, "lat_max_us");
+    JW_uint(w, s.latency_us_max);
+    JW_key(w, "lat_avg_us");
+    JW_uint(w, s.latency_us_mean);
+    JW_key(w, "util");
+    JW_float(w, s.bus_utilisation, 3);
+    JW_object_end(w);
+    return JW_error(w);
+}
+
+
+static void IMU_acq_complete(I2C_STATUS_t status, void *ctx)
+{
+    (void)ctx;
+    uint32_t now_us = IMU_BUS_now_us();
+    IMU_acq_counters.busy_us += now_us - IMU_acq_submit_us;
+
+    if (status != I2C_STATUS_ok)
+    {
+        IMU_acq_counters.errors++;
+        IMU_acq_pending = false;
+        return;
+    }
+
+    uint8_t head = IMU_ring_head;
+    if ((uint8_t)(head - IMU_ring_tail) >= IMU_SAMPLE_RING_LEN)
+    {
+        /* keep the unread samples, they are older */
+        IMU_acq_counters.dropped++;
+        IMU_acq_pending = false;
+        return;
+    }
+
+    IMU_sample_t *s = &IMU_ring[head & IMU_SAMPLE_RING_MASK];
+    s->timestamp_us = now_us;
+    unsigned int i;
+    for (i = 0; i < 3; i++)
+    {
+        s->accel[i] = IMU_acq_s16(IMU_BURST_ACCEL_OFFSET + 2 * i);
+        s->mag[i]   = IMU_acq_s16(IMU_BURST_MAG_OFFSET + 2 * i);
+        s->gyro[i]  = IMU_acq_s16(IMU_BURST_GYRO_OFFSET + 2 * i);
+    }
+    for (i = 0; i < 4; i++)
+    {
+        s->quat[i] = IMU_acq_s16(IMU_BURST_QUAT_OFFSET + 2 * i);
+    }
+    IMU_ring_head = (uint8_t)(head + 1);
+
+    uint32_t latency_us = now_us - IMU_acq_due_us;
+    IMU_acq_counters.samples++;
+    IMU_acq_counters.latency_us_last = latency_us;
+    IMU_acq_counters.latency_us_sum += latency_us;
+    if (latency_us > IMU_acq_counters.latency_us_max)
+    {
+        IMU_acq_counters.latency_us_max = latency_us;
+    }
+    IMU_acq_pending = false;
+}
+
+
+/* BNO055 data registers are little endian */
+static int16_t IMU_acq_s16(unsigned int offset)
+{
+    uint16_t raw = (uint16_t)IMU_acq_buf[offset] |
+                   (uint16_t)((uint16_t)IMU_acq_buf[offset + 1] << 8);
+    return (int16_t)raw;
+}
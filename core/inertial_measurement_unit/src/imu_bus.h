@@ -0,0 +1,60 @@
+/**
+ * @file imu_bus.h
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Private header selecting the I2C bus and time source of the IMU
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ * @note The BNO055 is on I2C1 (UCB1) on the target and on the emulated bus
+ * when running natively.
+ */
+#ifndef __IMU_BUS_H__
+#define __IMU_BUS_H__
+#ifdef __cplusplus
+/* clang-format off */
+extern "C"
+{
+/* clang-format on */
+#endif /* Start C linkage */
+
+#if defined(TARGET_MCU)
+
+#include <msp430.h>
+
+#include "i2c.h"
+#include "systick.h"
+
+#define IMU_BUS_transfer(xfer) I2C1_transfer((xfer))
+#define IMU_BUS_submit(xfer) I2C1_submit((xfer))
+#define IMU_BUS_poll() I2C1_poll()
+#define IMU_BUS_now_us() SYSTICK_get_us()
+
+/* Completion callbacks run in the I2C interrupt */
+#define IMU_BUS_LOCK()                                                         \
+    uint16_t imu_bus_irq_state = __get_interrupt_state();                      \
+    __disable_interrupt()
+#define IMU_BUS_UNLOCK() __set_interrupt_state(imu_bus_irq_state)
+
+#else
+
+#include "i2c_emulator.h"
+
+#define IMU_BUS_transfer(xfer) I2C_EMU_transfer((xfer))
+#define IMU_BUS_submit(xfer) I2C_EMU_submit((xfer))
+#define IMU_BUS_poll() I2C_EMU_poll()
+#define IMU_BUS_now_us() I2C_EMU_get_time_us()
+
+/* Completion callbacks run synchronously on the emulated bus */
+#define IMU_BUS_LOCK()
+#define IMU_BUS_UNLOCK()
+
+#endif /* #if defined(TARGET_MCU) */
+
+#ifdef __cplusplus
+/* clang-format off */
+}
+/* clang-format on */
+#endif /* End C linkage */
+#endif /* __IMU_BUS_H__ */
@@ -0,0 +1,169 @@
+/**
+ * @file bno055_register_protocol.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Test the IMU register access against the emulated BNO055 on the
+ * emulated I2C bus
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ */
+#if defined(TARGET_MCU)
+#error NATIVE TESTS CANNOT BE RUN ON A BARE METAL MICROCONTROLLER
+#endif /* #if defined(TARGET_MCU) */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "imu.h"
+#include "i2c_emulator.h"
+#include "bno055_emulator.h"
+#include "test_expect.h"
+
+#define UNIT_SEL_ADDR (0x3B)
+#define ACC_CONFIG_ADDR (0x08) /* page 1 */
+#define OPR_MODE_NDOF (0x0C)
+
+static unsigned int callback_count;
+static I2C_STATUS_t callback_status;
+
+static void on_complete(I2C_STATUS_t status, void *ctx)
+{
+    *(unsigned int *)ctx += 1;
+    callback_status = status;
+}
+
+
+static uint8_t write_reg(uint8_t reg, uint8_t value)
+{
+    return IMU_write_registers(IMU_I2C_ADDR, reg, &value, 1);
+}
+
+
+static uint8_t read_reg(uint8_t reg)
+{
+    uint8_t value = 0;
+    IMU_read_registers(IMU_I2C_ADDR, reg, &value, 1);
+    return value;
+}
+
+
+int main(void)
+{
+    uint8_t         buf[8];
+    I2C_EMU_stats_t before;
+    I2C_EMU_stats_t after;
+
+    I2C_EMU_init();
+    EXPECT(BNO055_EMU_attach(IMU_I2C_ADDR) == 0);
+    EXPECT(BNO055_EMU_attach(IMU_I2C_ADDR) == 1);
+
+    /* Burst read of the id registers */
+    EXPECT(IMU_read_registers(IMU_I2C_ADDR, BNO055_EMU_CHIP_ID_ADDR, buf, 4) ==
+           0);
+    EXPECT(buf[0] == BNO055_EMU_CHIP_ID);
+    EXPECT(buf[1] == 0xFB && buf[2] == 0x32 && buf[3] == 0x0F);
+
+    /* Read only registers ignore writes */
+    EXPECT(write_reg(BNO055_EMU_CHIP_ID_ADDR, 0x55) == 0);
+    EXPECT(read_reg(BNO055_EMU_CHIP_ID_ADDR) == BNO055_EMU_CHIP_ID);
+
+    /* Configuration registers are only writable in CONFIGMODE */
+    EXPECT(write_reg(UNIT_SEL_ADDR, 0x81) == 0);
+    EXPECT(read_reg(UNIT_SEL_ADDR) == 0x81);
+    EXPECT(write_reg(BNO055_EMU_OPR_MODE_ADDR, OPR_MODE_NDOF) == 0);
+    EXPECT(read_reg(BNO055_EMU_SYS_STATUS_ADDR) == 0x05);
+    EXPECT(write_reg(UNIT_SEL_ADDR, 0x80) == 0);
+    EXPECT(read_reg(UNIT_SEL_ADDR) == 0x81);
+
+    /* Page select */
+    EXPECT(write_reg(BNO055_EMU_PAGE_ID_ADDR, 1) == 0);
+    EXPECT(read_reg(BNO055_EMU_PAGE_ID_ADDR) == 1);
+    EXPECT(read_reg(ACC_CONFIG_ADDR) == 0x0D);
+    EXPECT(write_reg(BNO055_EMU_PAGE_ID_ADDR, 0) == 0);
+    EXPECT(read_reg(BNO055_EMU_PAGE_ID_ADDR) == 0);
+
+    /* Quaternion burst read is little endian with auto increment */
+    BNO055_EMU_set_quaternion(16384, -8192, 0x1234, -1);
+    I2C_EMU_get_stats(&before);
+    EXPECT(IMU_read_registers(IMU_I2C_ADDR,
+                              BNO055_EMU_QUATERNION_DATA_W_LSB_ADDR, buf,
+                              sizeof(buf)) == 0);
+    I2C_EMU_get_stats(&after);
+    EXPECT((int16_t)(buf[0] | (buf[1] << 8)) == 16384);
+    EXPECT((int16_t)(buf[2] | (buf[3] << 8)) == -8192);
+    EXPECT((int16_t)(buf[4] | (buf[5] << 8)) == 0x1234);
+    EXPECT((int16_t)(buf[6] | (buf[7] << 8)) == -1);
+
+    /* S + SLA+W + reg + Sr + SLA+R + 8 bytes + P == 102 bits at 100 kHz */
+    EXPECT(after.transactions == before.transactions + 1);
+    EXPECT(after.bytes == before.bytes + 11);
+    EXPECT(after.bus_time_us == before.bus_time_us + 1020);
+
+    /* Nobody at the address */
+    EXPECT(IMU_read_registers(0x29, BNO055_EMU_CHIP_ID_ADDR, buf, 1) == 1);
+
+    /* NACK of a data byte */
+    I2C_EMU_inject_fault(I2C_EMU_FAULT_nack, 2);
+    EXPECT(IMU_write_registers(IMU_I2C_ADDR, UNIT_SEL_ADDR, buf, 2) == 1);
+
+    /* Arbitration lost part way through the read phase */
+    I2C_EMU_inject_fault(I2C_EMU_FAULT_arbitration_lost, 4);
+    EXPECT(IMU_read_registers(IMU_I2C_ADDR, BNO055_EMU_CHIP_ID_ADDR, buf, 4) ==
+           1);
+
+    /* Register address past the end of the map is NACKed */
+    EXPECT(IMU_read_registers(IMU_I2C_ADDR, 0x80, buf, 1) == 1);
+
+    /* Writes larger than the IMU write buffer are rejected */
+    uint8_t big[64];
+    memset(big, 0, sizeof(big));
+    EXPECT(IMU_write_registers(IMU_I2C_ADDR, 0x55, big, sizeof(big)) == 1);
+
+    /* Stuck bus times out and the callback fires exactly once */
+    I2C_transaction_t xfer;
+    uint8_t           reg = BNO055_EMU_CHIP_ID_ADDR;
+    memset(&xfer, 0, sizeof(xfer));
+    xfer.dev_addr   = IMU_I2C_ADDR;
+    xfer.tx         = &reg;
+    xfer.txlen      = 1;
+    xfer.rx         = buf;
+    xfer.rxlen      = 1;
+    xfer.timeout_us = 5000;
+    xfer.callback   = on_complete;
+    xfer.ctx        = &callback_count;
+    I2C_EMU_get_stats(&before);
+    I2C_EMU_inject_fault(I2C_EMU_FAULT_stuck_bus, 1);
+    EXPECT(I2C_EMU_submit(&xfer) == 0);
+    EXPECT(I2C_EMU_poll() == I2C_STATUS_timeout);
+    EXPECT(callback_count == 1 && callback_status == I2C_STATUS_timeout);
+    I2C_EMU_get_stats(&after);
+    EXPECT(after.timeouts == before.timeouts + 1);
+    EXPECT(after.bus_time_us == before.bus_time_us + 5000);
+
+    /* The bus recovers */
+    EXPECT(I2C_EMU_submit(&xfer) == 0);
+    EXPECT(callback_count == 2 && callback_status == I2C_STATUS_ok);
+    EXPECT(buf[0] == BNO055_EMU_CHIP_ID);
+
+    /* Invalid transactions */
+    xfer.txlen = 0;
+    xfer.rxlen = 0;
+    EXPECT(I2C_EMU_transfer(&xfer) == I2C_STATUS_invalid);
+    EXPECT(callback_count == 2);
+
+    /* System reset restores the power on configuration */
+    EXPECT(write_reg(BNO055_EMU_SYS_TRIGGER_ADDR, 0x20) == 0);
+    EXPECT(read_reg(BNO055_EMU_OPR_MODE_ADDR) == 0x00);
+    EXPECT(read_reg(UNIT_SEL_ADDR) == 0x80);
+
+    I2C_EMU_get_stats(&after);
+    printf("transactions %u, bytes %u, nacks %u, arbitration lost %u, "
+           "timeouts %u, bus time %llu us\n",
+           after.transactions, after.bytes, after.nacks,
+           after.arbitration_lost, after.timeouts,
+           (unsigned long long)after.bus_time_us);
+    return 0;
+}
@@ -0,0 +1,176 @@
+/**
+ * @file imu_burst_acquisition.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Test the periodic burst read of the IMU into the sample ring
+ * against the emulated BNO055
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ */
+#if defined(TARGET_MCU)
+#error NATIVE TESTS CANNOT BE RUN ON A BARE METAL MICROCONTROLLER
+#endif /* #if defined(TARGET_MCU) */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "imu.h"
+#include "i2c_emulator.h"
+#include "bno055_emulator.h"
+#include "test_expect.h"
+
+#define PERIOD_MS (10)
+#define LOOP_STEP_US (1000u)
+
+/* S + SLA+W + reg + Sr + SLA+R + 32 data bytes + P == 318 bits at 100 kHz */
+#define BURST_BUS_TIME_US (3180u)
+
+static uint32_t tick_us;
+static uint32_t now_us;
+
+
+/* Main loop iteration on a 1 ms tick. Time only moves forward: the emulated
+ * bus clock has already advanced by the wire time of the last transaction */
+static void loop_step(void)
+{
+    tick_us += LOOP_STEP_US;
+    now_us = I2C_EMU_get_time_us();
+    if (tick_us > now_us)
+    {
+        now_us = tick_us;
+        I2C_EMU_set_time_us(now_us);
+    }
+
+    /* The sensor data encodes the time it was produced */
+    int16_t stamp = (int16_t)(now_us / 1000u);
+    BNO055_EMU_set_gyro(stamp, -stamp, 16);
+    BNO055_EMU_set_accel(981, 0, -981);
+    BNO055_EMU_set_mag(-320, 160, 480);
+    BNO055_EMU_set_quaternion(16384, 0, 0, 0);
+    IMU_acquire(now_us);
+}
+
+
+int main(void)
+{
+    IMU_sample_t    s;
+    IMU_acq_stats_t stats;
+    unsigned int    i;
+
+    I2C_EMU_init();
+    EXPECT(BNO055_EMU_attach(IMU_I2C_ADDR) == 0);
+    IMU_init();
+    IMU_set_sample_period_ms(PERIOD_MS);
+    EXPECT(IMU_sample_count() == 0);
+    EXPECT(IMU_sample_pop(&s) == 1);
+
+    /* Consumer keeps up: every sample arrives in order */
+    unsigned int popped       = 0;
+    uint32_t     last_stamp   = 0;
+    int16_t      last_gyro_x  = -1;
+    for (i = 0; i < 1000; i++)
+    {
+        loop_step();
+        if (i % 50 == 49)
+        {
+            while (IMU_sample_pop(&s) == 0)
+            {
+                EXPECT(popped == 0 || s.timestamp_us > last_stamp);
+                EXPECT(s.gyro[0] > last_gyro_x);
+                EXPECT(s.gyro[1] == -s.gyro[0] && s.gyro[2] == 16);
+                EXPECT(s.accel[0] == 981 && s.accel[2] == -981);
+                EXPECT(s.mag[0] == -320 && s.mag[1] == 160 && s.mag[2] == 480);
+                EXPECT(s.quat[0] == 16384 && s.quat[3] == 0);
+                last_stamp  = s.timestamp_us;
+                last_gyro_x = s.gyro[0];
+                popped++;
+            }
+        }
+    }
+
+    IMU_get_acq_stats(&stats);
+    EXPECT(stats.samples == popped);
+    EXPECT(stats.dropped == 0 && stats.errors == 0);
+
+    /* Burst period is kept even though each read occupies the bus */
+    double expected = (double)now_us / (PERIOD_MS * 1000.0);
+    EXPECT(fabs((double)popped - expected) <= 1.0);
+
+    /* Latency is the wire time of the 32 byte burst */
+    EXPECT(stats.latency_us_last == BURST_BUS_TIME_US);
+    EXPECT(stats.latency_us_max == BURST_BUS_TIME_US);
+    EXPECT(stats.latency_us_mean == BURST_BUS_TIME_US);
+
+    double util = (double)BURST_BUS_TIME_US / (PERIOD_MS * 1000.0);
+    EXPECT(fabs(stats.bus_utilisation - util) < 0.01);
+    printf("%u samples, latency %lu us, bus utilisation %.3f\n", popped,
+           (unsigned long)stats.latency_us_mean, stats.bus_utilisation);
+
+    /* Consumer stalls: the ring keeps the oldest samples */
+    uint32_t stall_start = now_us;
+    for (i = 0; i < 200; i++)
+    {
+        loop_step();
+    }
+    EXPECT(IMU_sample_count() == IMU_SAMPLE_RING_LEN);
+    IMU_get_acq_stats(&stats);
+    EXPECT(stats.dropped > 0);
+    EXPECT(IMU_sample_pop(&s) == 0);
+    EXPECT(s.timestamp_us > stall_start);
+    EXPECT(s.timestamp_us < stall_start + 2 * PERIOD_MS * 1000u);
+
+    /* Each sample in turn, oldest first */
+    quat_t   q;
+    vec3_t   w;
+    uint32_t t_us;
+    unsigned left = IMU_sample_count();
+    EXPECT(IMU_attitude_pop(&q, &w, &t_us) == 0);
+    EXPECT(t_us > s.timestamp_us);
+    EXPECT(IMU_sample_count() == left - 1);
+
+    /* The newest attitude drains the ring */
+    EXPECT(IMU_get_attitude(&q, &w) == 0);
+    EXPECT(IMU_sample_count() == 0);
+    EXPECT(IMU_get_attitude(&q, &w) == 1);
+    EXPECT(q.w == 1.0f && q.x == 0.0f);
+    EXPECT(w.z > 0.0174f && w.z < 0.0175f); /* 16 LSB == 1 dps */
+
+    char buf[100];
+    JW_t jw;
+    JW_init(&jw, buf, sizeof(buf));
+    EXPECT(IMU_measurements_to_json(&jw) == 0);
+    EXPECT(JW_finish(&jw) == 0);
+    EXPECT(strstr(buf, ",1.00]") != NULL);
+
+    /* Bus errors are counted and produce no samples */
+    IMU_reset_acq_stats();
+    I2C_EMU_detach(IMU_I2C_ADDR);
+    for (i = 0; i < 100; i++)
+    {
+        loop_step();
+    }
+    IMU_get_acq_stats(&stats);
+    EXPECT(stats.samples == 0 && stats.errors >= 9);
+    EXPECT(IMU_sample_count() == 0);
+
+    /* Stopping the acquisition */
+    EXPECT(BNO055_EMU_attach(IMU_I2C_ADDR) == 0);
+    IMU_set_sample_period_ms(0);
+    IMU_reset_acq_stats();
+    for (i = 0; i < 100; i++)
+    {
+        loop_step();
+    }
+    IMU_get_acq_stats(&stats);
+    EXPECT(stats.samples == 0 && stats.errors == 0);
+
+    JW_init(&jw, buf, sizeof(buf));
+    EXPECT(IMU_acq_stats_to_json(&jw) == 0);
+    EXPECT(JW_finish(&jw) == 0);
+    printf("%s\n", buf);
+    return 0;
+}
@@ -0,0 +1,154 @@
+/**
+ * @file isr_monitor.h
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Worst case latency, duration and nesting of the interrupt service
+ * routines, checked against a time budget per vector
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ * @note Each ISR calls ISR_MON_enter first and ISR_MON_exit last with the
+ * free running counter (ISR_MON_NOW on the target, the SYSTICK counter at
+ * SMCLK). Times are 16 bit ticks of that counter, an ISR must not be held
+ * off or run for 2^16 ticks (60 ms).
+ *
+ * The latency of a run is from the request to the entry of the ISR. Only
+ * the sources that can tell when they requested it (the systick timer) have
+ * one, the others enter with ISR_MON_enter_unknown_latency and report it as
+ * unknown (null in the JSON).
+ *
+ * The response of a run is latency plus duration, nested ISRs included.
+ * Without a latency it is bounded by the duration plus the worst duration of
+ * the vectors that can hold it off: every vector of higher priority, and the
+ * longest one of lower priority that may already be running, with the cycles
+ * to enter and leave each. A receive ISR
+ * whose response is longer than a byte time at the line rate loses the next
+ * byte, so the budgets are one byte time on the serial buses and one period
+ * on the tick. A run over its budget sets the vector in the over budget mask
+ * until ISR_MON_reset.
+ */
+#ifndef __ISR_MONITOR_H__
+#define __ISR_MONITOR_H__
+#ifdef __cplusplus
+/* clang-format off */
+extern "C"
+{
+/* clang-format on */
+#endif /* Start C linkage */
+
+#include <stdint.h>
+
+#include "json_writer.h"
+
+#if defined(TARGET_MCU)
+#include <msp430.h>
+
+#define ISR_MON_NOW() ((uint16_t)TB0R)
+#endif /* #if defined(TARGET_MCU) */
+
+/* SMCLK (clocks.h) */
+#define ISR_MON_TICK_HZ (1100000ul)
+
+/* Ticks to shift bits at rate bits per second */
+#define ISR_MON_BIT_TICKS(bits, rate)                                          \
+    ((uint16_t)(((bits)*ISR_MON_TICK_HZ + (rate)-1u) / (rate)))
+
+/* Cycles to enter an ISR and to return from it, MCLK runs at SMCLK
+ * (slau208q 1.3.4.1) */
+#define ISR_MON_ENTRY_TICKS (6u)
+#define ISR_MON_RETI_TICKS (5u)
+
+/* Deepest nesting recorded, deeper runs are not timed */
+#define ISR_MON_NEST_MAX (4u)
+
+typedef enum
+{
+    ISR_MON_obc_uart, /* USCI_A0 : OBC link receive */
+    ISR_MON_usci_b0,  /* USCI_B0 : ADS7841 SPI receive or I2C0 */
+    ISR_MON_imu_i2c,  /* USCI_B1 : IMU bus */
+    ISR_MON_systick,  /* TIMER0_B1 : millisecond tick and its timers */
+    ISR_MON_cnt,      /* must be last */
+} ISR_MON_VECTOR_t;
+
+typedef struct
+{
+    uint32_t runs;
+    uint32_t over_budget;  /* runs whose response exceeded the budget */
+    uint16_t latency_max;   /* ticks, of the runs that knew it */
+    uint16_t duration_max;  /* ticks */
+    uint16_t response_max;  /* ticks, the worst latency + duration of a run */
+    uint16_t budget;        /* ticks, 0 for none */
+    uint8_t  nesting_max;   /* ISRs already running when it was entered */
+    uint8_t  latency_known; /* a run had a request time */
+} ISR_MON_stats_t;
+
+
+/**
+ * @brief Set the default budgets and clear the statistics
+ */
+void ISR_MON_init(void);
+
+/**
+ * @brief Clear the statistics and the over budget mask, budgets are kept
+ */
+void ISR_MON_reset(void);
+
+/**
+ * @brief Budget of vector in ticks, 0 to never flag it
+ */
+void ISR_MON_set_budget(ISR_MON_VECTOR_t vector, uint16_t ticks);
+
+/**
+ * @brief First thing in the ISR of vector
+ *
+ * @param now the counter on entry
+ * @param raised the counter when the source requested the interrupt, now if
+ * it cannot tell
+ */
+void ISR_MON_enter(ISR_MON_VECTOR_t vector, uint16_t now, uint16_t raised);
+
+/**
+ * @brief First thing in the ISR of vector when the source cannot tell when
+ * it requested the interrupt
+ *
+ * @param now the counter on entry
+ */
+void ISR_MON_enter_unknown_latency(ISR_MON_VECTOR_t vector, uint16_t now);
+
+/**
+ * @brief Last thing in the ISR of vector
+ *
+ * @param now the counter on exit
+ */
+void ISR_MON_exit(ISR_MON_VECTOR_t vector, uint16_t now);
+
+void ISR_MON_get_stats(ISR_MON_VECTOR_t vector, ISR_MON_stats_t *stats);
+
+/**
+ * @brief Vectors that went over their budget since the reset, bit n for
+ * ISR_MON_VECTOR_t n
+ */
+uint16_t ISR_MON_over_budget_mask(void);
+
+/**
+ * @brief Worst response of any vector with a budget, in percent of its
+ * budget (saturated)
+ */
+uint16_t ISR_MON_worst_response_pct(void);
+
+/**
+ * @brief Write the statistics as
+ * {"hz":1100000,"over":mask,"vec":{"obc_uart":[runs,lat,dur,resp,budget,
+ * over,nest],...}}, lat is null for a vector without a known latency
+ *
+ * @return int 0 on success, 1 if the writer overflowed
+ */
+int ISR_MON_to_json(JW_t *w);
+
+#ifdef __cplusplus
+/* clang-format off */
+}
+/* clang-format on */
+#endif /* End C linkage */
+#endif /* __ISR_MONITOR_H__ */
@@ -0,0 +1,355 @@
+/**
+ * @file isr_monitor.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Worst case latency, duration and nesting of the interrupt service
+ * routines
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ * @note The ISRs that are running form a stack, an ISR that re-enables
+ * interrupts can be preempted by any other but the preempting one returns
+ * first.
+ *
+ * A vector without a known latency gets its response bound again on every
+ * read, the durations of the vectors that hold it off keep growing after
+ * its own runs.
+ */
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "targets.h"
+#include "config_assert.h"
+#include "json_writer.h"
+#include "isr_monitor.h"
+
+#if defined(TARGET_MCU)
+
+/* An ISR that re-enabled interrupts can be preempted in the middle */
+#define ISR_MON_LOCK()                                                         \
+    uint16_t isr_mon_irq_state = __get_interrupt_state();                      \
+    __disable_interrupt()
+#define ISR_MON_UNLOCK() __set_interrupt_state(isr_mon_irq_state)
+#else
+#define ISR_MON_LOCK()
+#define ISR_MON_UNLOCK()
+#endif /* #if defined(TARGET_MCU) */
+
+#define ISR_MON_PCT_MAX (UINT16_MAX)
+
+/* A byte on each bus, the line rates are set in uart.c, hal_ads7841.c
+ * (SMCLK / 8) and i2c1.c */
+#define ISR_MON_OBC_BAUD (9600ul)
+#define ISR_MON_ADS7841_SPI_HZ (ISR_MON_TICK_HZ / 8u)
+#define ISR_MON_IMU_I2C_HZ (100000ul)
+
+/* clang-format off */
+static const uint16_t isr_mon_default_budget[ISR_MON_cnt] = {
+    [ISR_MON_obc_uart] = ISR_MON_BIT_TICKS(10u, ISR_MON_OBC_BAUD), /* 8N1 */
+    [ISR_MON_usci_b0]  = ISR_MON_BIT_TICKS(8u, ISR_MON_ADS7841_SPI_HZ),
+    [ISR_MON_imu_i2c]  = ISR_MON_BIT_TICKS(9u, ISR_MON_IMU_I2C_HZ), /* ack */
+    [ISR_MON_systick]  = ISR_MON_BIT_TICKS(1u, 1000u), /* the tick period */
+};
+
+/* Vector numbers on the F5529, the pending one with the highest is served
+ * first (slas590 table 6-1) */
+static const uint8_t isr_mon_priority[ISR_MON_cnt] = {
+    [ISR_MON_obc_uart] = 56u, /* USCI_A0 */
+    [ISR_MON_usci_b0]  = 55u, /* USCI_B0 */
+    [ISR_MON_imu_i2c]  = 45u, /* USCI_B1 */
+    [ISR_MON_systick]  = 58u, /* TIMER0_B1 */
+};
+
+static const char *const isr_mon_names[ISR_MON_cnt] = {
+    [ISR_MON_obc_uart] = "obc_uart",
+    [ISR_MON_usci_b0]  = "usci_b0",
+    [ISR_MON_imu_i2c]  = "imu_i2c",
+    [ISR_MON_systick]  = "systick",
+};
+/* clang-format on */
+
+typedef struct
+{
+    ISR_MON_VECTOR_t vector;
+    uint16_t         entry;
+    uint16_t         latency;
+    bool             latency_known;
+} isr_mon_run_t;
+
+static ISR_MON_stats_t isr_mon_stats[ISR_MON_cnt];
+static uint16_t        isr_mon_over_mask;
+static uint16_t        isr_mon_unknown_mask; /* vectors with an unknown run */
+
+static isr_mon_run_t isr_mon_running[ISR_MON_NEST_MAX];
+static uint8_t       isr_mon_depth; /* may exceed ISR_MON_NEST_MAX */
+
+
+static void isr_mon_enter(ISR_MON_VECTOR_t vector, uint16_t now,
+                          uint16_t raised, bool latency_known);
+
+static uint32_t isr_mon_blocking(ISR_MON_VECTOR_t vector);
+static uint16_t isr_mon_response_max(ISR_MON_VECTOR_t vector);
+
+
+void ISR_MON_init(void)
+{
+    ISR_MON_VECTOR_t v;
+    ISR_MON_reset();
+    for (v = 0; v < ISR_MON_cnt; v++)
+    {
+        ISR_MON_set_budget(v, isr_mon_default_budget[v]);
+    }
+}
+
+
+void ISR_MON_reset(void)
+{
+    ISR_MON_VECTOR_t v;
+    ISR_MON_LOCK();
+    for (v = 0; v < ISR_MON_cnt; v++)
+    {
+        const uint16_t budget = isr_mon_stats[v].budget;
+        memset(&isr_mon_stats[v], 0, sizeof(isr_mon_stats[v]));
+        isr_mon_stats[v].budget = budget;
+    }
+    isr_mon_over_mask    = 0;
+    isr_mon_unknown_mask = 0;
+    ISR_MON_UNLOCK();
+}
+
+
+void ISR_MON_set_budget(ISR_MON_VECTOR_t vector, uint16_t ticks)
+{
+    CONFIG_ASSERT(vector < ISR_MON_cnt);
+    ISR_MON_LOCK();
+    isr_mon_stats[vector].budget = ticks;
+    ISR_MON_UNLOCK();
+}
+
+
+void ISR_MON_enter(ISR_MON_VECTOR_t vector, uint16_t now, uint16_t raised)
+{
+    isr_mon_enter(vector, now, raised, true);
+}
+
+
+void ISR_MON_enter_unknown_latency(ISR_MON_VECTOR_t vector, uint16_t now)
+{
+    isr_mon_enter(vector, now, now, false);
+}
+
+
+void ISR_MON_exit(ISR_MON_VECTOR_t vector, uint16_t now)
+{
+    CONFIG_ASSERT(vector < ISR_MON_cnt);
+    ISR_MON_LOCK();
+    if (isr_mon_depth > 0)
+    {
+        isr_mon_depth--;
+    }
+    if (isr_mon_depth < ISR_MON_NEST_MAX &&
+        isr_mon_running[isr_mon_depth].vector == vector)
+    {
+        const isr_mon_run_t *run      = &isr_mon_running[isr_mon_depth];
+        ISR_MON_stats_t *    s        = &isr_mon_stats[vector];
+        const uint16_t       duration = (uint16_t)(now - run->entry);
+        uint32_t             response;
+
+        s->runs++;
+        if (duration > s->duration_max)
+        {
+            s->duration_max = duration;
+        }
+        if (run->latency_known)
+        {
+            response         = (uint32_t)run->latency + duration;
+            s->latency_known = 1;
+            if (run->latency > s->latency_max)
+            {
+                s->latency_max = run->latency;
+            }
+        }
+        else
+        {
+            response = duration + isr_mon_blocking(vector);
+            isr_mon_unknown_mask |= (uint16_t)(1u << vector);
+        }
+        if (response > s->response_max)
+        {
+            s->response_max =
+                (response > UINT16_MAX) ? UINT16_MAX : (uint16_t)response;
+        }
+        if (s->budget != 0 && response > s->budget)
+        {
+            s->over_budget++;
+            isr_mon_over_mask |= (uint16_t)(1u << vector);
+        }
+    }
+    ISR_MON_UNLOCK();
+}
+
+
+void ISR_MON_get_stats(ISR_MON_VECTOR_t vector, ISR_MON_stats_t *stats)
+{
+    CONFIG_ASSERT(vector < ISR_MON_cnt);
+    CONFIG_ASSERT(NULL != stats);
+    ISR_MON_LOCK();
+    *stats              = isr_mon_stats[vector];
+    stats->response_max = isr_mon_response_max(vector);
+    ISR_MON_UNLOCK();
+}
+
+
+uint16_t ISR_MON_over_budget_mask(void)
+{
+    uint16_t         mask;
+    ISR_MON_VECTOR_t v;
+    ISR_MON_LOCK();
+    mask = isr_mon_over_mask;
+    for (v = 0; v < ISR_MON_cnt; v++)
+    {
+        const uint16_t budget = isr_mon_stats[v].budget;
+        if (budget != 0 && isr_mon_response_max(v) > budget)
+        {
+            mask |= (uint16_t)(1u << v);
+        }
+    }
+    ISR_MON_UNLOCK();
+    return mask;
+}
+
+
+uint16_t ISR_MON_worst_response_pct(void)
+{
+    uint32_t         worst = 0;
+    ISR_MON_VECTOR_t v;
+    for (v = 0; v < ISR_MON_cnt; v++)
+    {
+        ISR_MON_stats_t s;
+        ISR_MON_get_stats(v, &s);
+        if (s.budget != 0)
+        {
+            const uint32_t pct = (uint32_t)s.response_max * 100u / s.budget;
+            if (pct > worst)
+            {
+                worst = pct;
+            }
+        }
+    }
+    return (worst > ISR_MON_PCT_MAX) ? ISR_MON_PCT_MAX : (uint16_t)worst;
+}
+
+
+int ISR_MON_to_json(JW_t *w)
+{
+    CONFIG_ASSERT(NULL != w);
+    JW_object_begin(w);
+    JW_key(w, "hz");
+    JW_uint(w, ISR_MON_TICK_HZ);
+    JW_key(w, "over");
+    JW_uint(w, ISR_MON_over_budget_mask());
+    JW_key(w, "vec");
+    JW_object_begin(w);
+
+    ISR_MON_VECTOR_t v;
+    for (v = 0; v < ISR_MON_cnt; v++)
+    {
+        ISR_MON_stats_t s;
+        ISR_MON_get_stats(v, &s);
+        JW_key(w, isr_mon_names[v]);
+        JW_array_begin(w);
+        JW_uint(w, s.runs);
+        if (s.latency_known)
+        {
+            JW_uint(w, s.latency_max);
+        }
+        else
+        {
+            JW_null(w);
+        }
+        JW_uint(w, s.duration_max);
+        JW_uint(w, s.response_max);
+        JW_uint(w, s.budget);
+        JW_uint(w, s.over_budget);
+        JW_uint(w, s.nesting_max);
+        JW_array_end(w);
+    }
+
+    JW_object_end(w);
+    JW_object_end(w);
+    return JW_error(w);
+}
+
+
+static void isr_mon_enter(ISR_MON_VECTOR_t vector, uint16_t now,
+                          uint16_t raised, bool latency_known)
+{
+    CONFIG_ASSERT(vector < ISR_MON_cnt);
+    ISR_MON_LOCK();
+    ISR_MON_stats_t *s = &isr_mon_stats[vector];
+    if (isr_mon_depth > s->nesting_max)
+    {
+        s->nesting_max = isr_mon_depth;
+    }
+    if (isr_mon_depth < ISR_MON_NEST_MAX)
+    {
+        isr_mon_run_t *run = &isr_mon_running[isr_mon_depth];
+        run->vector        = vector;
+        run->entry         = now;
+        run->latency       = (uint16_t)(now - raised);
+        run->latency_known = latency_known;
+    }
+    isr_mon_depth++;
+    ISR_MON_UNLOCK();
+}
+
+
+/* Worst latency of a request of vector: one run of every vector of higher
+ * priority, served first, and the rest of the longest of the lower ones,
+ * which may have just been entered. Vectors that never ran are left out.
+ * Call with interrupts masked */
+static uint32_t isr_mon_blocking(ISR_MON_VECTOR_t vector)
+{
+    uint32_t         higher = 0;
+    uint32_t         lower  = 0;
+    ISR_MON_VECTOR_t v;
+    for (v = 0; v < ISR_MON_cnt; v++)
+    {
+        const ISR_MON_stats_t *s = &isr_mon_stats[v];
+        if (v == vector || s->runs == 0)
+        {
+            continue;
+        }
+        if (isr_mon_priority[v] > isr_mon_priority[vector])
+        {
+            higher +=
+                ISR_MON_ENTRY_TICKS + (uint32_t)s->duration_max +
+                ISR_MON_RETI_TICKS;
+        }
+        else if ((uint32_t)s->duration_max + ISR_MON_RETI_TICKS > lower)
+        {
+            lower = (uint32_t)s->duration_max + ISR_MON_RETI_TICKS;
+        }
+    }
+    return lower + higher + ISR_MON_ENTRY_TICKS;
+}
+
+
+/* The recorded worst response, or the bound of the runs without a latency
+ * if it is worse. Call with interrupts masked */
+static uint16_t isr_mon_response_max(ISR_MON_VECTOR_t vector)
+{
+    const ISR_MON_stats_t *s     = &isr_mon_stats[vector];
+    uint32_t               worst = s->response_max;
+    if (isr_mon_unknown_mask & (1u << vector))
+    {
+        const uint32_t bound = s->duration_max + isr_mon_blocking(vector);
+        if (bound > worst)
+        {
+            worst = bound;
+        }
+    }
+    return (worst > UINT16_MAX) ? UINT16_MAX : (uint16_t)worst;
+}
@@ -0,0 +1,241 @@
+/**
+ * @file isr_budget.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Test the ISR monitor against the emulated interrupt controller:
+ * latency, duration and nesting come out as the controller ran them, and a
+ * receive ISR is flagged over budget whenever the line loses bytes
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ */
+#if defined(TARGET_MCU)
+#error NATIVE TESTS CANNOT BE RUN ON A BARE METAL MICROCONTROLLER
+#endif /* #if defined(TARGET_MCU) */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "isr_monitor.h"
+#include "irq_emulator.h"
+#include "json_writer.h"
+#include "test_expect.h"
+
+/* Priorities of the vectors on the F5529: TIMER0_B1 > USCI_A0 > USCI_B0 */
+#define LINE_UART (1u)
+#define LINE_TICK (2u)
+
+#define TICK_PERIOD (1100u)
+#define SESSION_TICKS (200000u) /* the 16 bit counter wraps a few times */
+
+static uint32_t uart_work;
+static uint32_t tick_work;
+static bool     tick_nests;
+static bool     uart_knows; /* when the byte was requested */
+
+
+static uint16_t now16(void)
+{
+    return (uint16_t)IRQ_EMU_now();
+}
+
+
+/* The emulated sources know when they requested, on the target only the
+ * tick does */
+static void uart_isr(void)
+{
+    if (uart_knows)
+    {
+        ISR_MON_enter(ISR_MON_obc_uart, now16(),
+                      (uint16_t)IRQ_EMU_raised(LINE_UART));
+    }
+    else
+    {
+        ISR_MON_enter_unknown_latency(ISR_MON_obc_uart, now16());
+    }
+    IRQ_EMU_busy(uart_work);
+    ISR_MON_exit(ISR_MON_obc_uart, now16());
+}
+
+
+static void tick_isr(void)
+{
+    ISR_MON_enter(ISR_MON_systick, now16(),
+                  (uint16_t)IRQ_EMU_raised(LINE_TICK));
+    IRQ_EMU_enable(tick_nests);
+    IRQ_EMU_busy(tick_work);
+    IRQ_EMU_enable(false);
+    ISR_MON_exit(ISR_MON_systick, now16());
+}
+
+
+static void session(uint32_t baud, uint32_t uart_ticks, uint32_t tick_ticks,
+                    bool nests)
+{
+    IRQ_EMU_init();
+    ISR_MON_init();
+    ISR_MON_set_budget(ISR_MON_obc_uart, ISR_MON_BIT_TICKS(10u, baud));
+    IRQ_EMU_attach(LINE_UART, uart_isr);
+    IRQ_EMU_attach(LINE_TICK, tick_isr);
+    uart_work  = uart_ticks;
+    tick_work  = tick_ticks;
+    tick_nests = nests;
+    uart_knows = true;
+
+    /* A byte every byte time, the bytes start off the tick */
+    IRQ_EMU_schedule(LINE_UART, 37u, ISR_MON_BIT_TICKS(10u, baud));
+    IRQ_EMU_schedule(LINE_TICK, TICK_PERIOD, TICK_PERIOD);
+    IRQ_EMU_run(SESSION_TICKS);
+}
+
+
+int main(void)
+{
+    ISR_MON_stats_t uart, tick;
+
+    /* One run of each, timed by hand. The byte comes while the main loop
+     * runs, the tick while the byte is serviced */
+    IRQ_EMU_init();
+    ISR_MON_init();
+    IRQ_EMU_attach(LINE_UART, uart_isr);
+    IRQ_EMU_attach(LINE_TICK, tick_isr);
+    uart_work  = 100u;
+    tick_work  = 40u;
+    tick_nests = false;
+    uart_knows = true;
+    IRQ_EMU_schedule(LINE_UART, 1000u, 0);
+    IRQ_EMU_schedule(LINE_TICK, 1050u, 0);
+    IRQ_EMU_run(5000u);
+    ISR_MON_get_stats(ISR_MON_obc_uart, &uart);
+    ISR_MON_get_stats(ISR_MON_systick, &tick);
+    EXPECT(uart.runs == 1);
+    EXPECT(uart.latency_max == IRQ_EMU_ENTRY_TICKS);
+    EXPECT(uart.duration_max == 100u);
+    EXPECT(uart.response_max == IRQ_EMU_ENTRY_TICKS + 100u);
+    EXPECT(uart.nesting_max == 0);
+    EXPECT(tick.runs == 1);
+    /* Requested at 1050, the byte ISR is left at 1106, returns at 1111 */
+    EXPECT(tick.latency_max == 1111u - 1050u + IRQ_EMU_ENTRY_TICKS);
+    EXPECT(tick.duration_max == 40u);
+    EXPECT(ISR_MON_over_budget_mask() == 0);
+
+    /* The OBC link at 9600 baud, with room to spare */
+    session(9600u, 150u, 200u, false);
+    ISR_MON_get_stats(ISR_MON_obc_uart, &uart);
+    ISR_MON_get_stats(ISR_MON_systick, &tick);
+    EXPECT(uart.runs >= SESSION_TICKS / ISR_MON_BIT_TICKS(10u, 9600u));
+    EXPECT(tick.runs >= SESSION_TICKS / TICK_PERIOD);
+    EXPECT(IRQ_EMU_lost(LINE_UART) == 0);
+    EXPECT(IRQ_EMU_lost(LINE_TICK) == 0);
+    EXPECT(uart.over_budget == 0);
+    EXPECT(ISR_MON_over_budget_mask() == 0);
+    /* A byte can wait for a whole tick ISR */
+    EXPECT(uart.latency_max > 200u);
+    EXPECT(uart.latency_max <= 200u + 2u * IRQ_EMU_ENTRY_TICKS +
+                                   IRQ_EMU_RETI_TICKS);
+    const uint16_t pct = ISR_MON_worst_response_pct();
+    EXPECT(pct > 0 && pct < 100);
+
+    /* Same firmware at 115200 baud: the byte ISR alone fits a byte time but
+     * not when it waits for the tick. The monitor flags it, and the line
+     * does lose bytes */
+    EXPECT(ISR_MON_BIT_TICKS(10u, 115200u) == 96u);
+    session(115200u, 60u, 200u, false);
+    ISR_MON_get_stats(ISR_MON_obc_uart, &uart);
+    EXPECT(uart.duration_max == 60u);
+    EXPECT(uart.over_budget > 0);
+    EXPECT(ISR_MON_over_budget_mask() == (1u << ISR_MON_obc_uart));
+    EXPECT(ISR_MON_worst_response_pct() > 100u);
+    EXPECT(IRQ_EMU_lost(LINE_UART) > 0);
+
+    /* Letting the bytes interrupt the tick fixes it */
+    session(115200u, 60u, 200u, true);
+    ISR_MON_get_stats(ISR_MON_obc_uart, &uart);
+    ISR_MON_get_stats(ISR_MON_systick, &tick);
+    EXPECT(IRQ_EMU_lost(LINE_UART) == 0);
+    EXPECT(uart.over_budget == 0);
+    EXPECT(uart.nesting_max == 1);
+    EXPECT(tick.nesting_max == 0);
+    /* The bytes that came in count in the tick duration */
+    EXPECT(tick.duration_max > 200u + 60u);
+    EXPECT(tick.over_budget == 0);
+
+    /* {"hz":..,"over":..,"vec":{"obc_uart":[runs,lat,dur,resp,budget,over,
+     * nest],...}} */
+    char buf[300];
+    JW_t w;
+    JW_init(&w, buf, sizeof(buf));
+    EXPECT(ISR_MON_to_json(&w) == 0);
+    EXPECT(JW_finish(&w) == 0);
+    printf("%s\n", buf);
+    EXPECT(strncmp(buf, "{\"hz\":1100000,\"over\":0,\"vec\":{", 30) == 0);
+    EXPECT(strstr(buf, "\"usci_b0\":[0,null,0,0,64,0,0]") != NULL);
+    EXPECT(strstr(buf, "\"imu_i2c\":[0,null,0,0,99,0,0]") != NULL);
+    EXPECT(strstr(buf, ",96,0,1]") != NULL);
+
+    /* As on the target, the byte ISR cannot tell its latency. Its response
+     * is bounded by its duration and the tick it may wait for, which is over
+     * a byte time at 115200 baud as in the run that knew */
+    session(115200u, 60u, 200u, false);
+    ISR_MON_reset();
+    uart_knows = true;
+    IRQ_EMU_run(SESSION_TICKS);
+    ISR_MON_get_stats(ISR_MON_obc_uart, &uart);
+    const uint16_t known = uart.response_max;
+    ISR_MON_reset();
+    uart_knows = false;
+    IRQ_EMU_run(SESSION_TICKS);
+    ISR_MON_get_stats(ISR_MON_obc_uart, &uart);
+    ISR_MON_get_stats(ISR_MON_systick, &tick);
+    EXPECT(uart.runs > 0);
+    EXPECT(uart.latency_known == 0);
+    EXPECT(uart.latency_max == 0);
+    EXPECT(uart.duration_max == 60u);
+    EXPECT(uart.response_max == ISR_MON_ENTRY_TICKS + tick.duration_max +
+                                    ISR_MON_RETI_TICKS + ISR_MON_ENTRY_TICKS +
+                                    uart.duration_max);
+    EXPECT(uart.response_max >= known);
+    EXPECT(uart.over_budget > 0);
+    EXPECT(ISR_MON_over_budget_mask() == (1u << ISR_MON_obc_uart));
+    JW_init(&w, buf, sizeof(buf));
+    EXPECT(ISR_MON_to_json(&w) == 0);
+    EXPECT(JW_finish(&w) == 0);
+    printf("%s\n", buf);
+    char vec[40];
+    snprintf(vec, sizeof(vec), "\"obc_uart\":[%lu,null,60,%u,96,",
+             (unsigned long)uart.runs, uart.response_max);
+    EXPECT(strstr(buf, vec) != NULL);
+
+    /* A vector waits for each one above it and the longest one below it,
+     * the tick is left out as it has not run */
+    ISR_MON_reset();
+    ISR_MON_enter_unknown_latency(ISR_MON_imu_i2c, 0u);
+    ISR_MON_exit(ISR_MON_imu_i2c, 30u);
+    ISR_MON_enter_unknown_latency(ISR_MON_obc_uart, 100u);
+    ISR_MON_exit(ISR_MON_obc_uart, 150u);
+    ISR_MON_enter_unknown_latency(ISR_MON_usci_b0, 200u);
+    ISR_MON_exit(ISR_MON_usci_b0, 220u);
+    ISR_MON_get_stats(ISR_MON_imu_i2c, &uart);
+    EXPECT(uart.response_max == (6u + 50u + 5u) + (6u + 20u + 5u) + 6u + 30u);
+    ISR_MON_get_stats(ISR_MON_usci_b0, &uart);
+    EXPECT(uart.response_max == (6u + 50u + 5u) + (30u + 5u) + 6u + 20u);
+    ISR_MON_get_stats(ISR_MON_obc_uart, &uart);
+    EXPECT(uart.response_max == (30u + 5u) + 6u + 50u);
+    EXPECT(ISR_MON_over_budget_mask() ==
+           ((1u << ISR_MON_usci_b0) | (1u << ISR_MON_imu_i2c)));
+
+    /* Reset keeps the budgets */
+    ISR_MON_reset();
+    ISR_MON_get_stats(ISR_MON_obc_uart, &uart);
+    EXPECT(uart.runs == 0);
+    EXPECT(uart.nesting_max == 0);
+    EXPECT(uart.budget == 96u);
+    EXPECT(ISR_MON_worst_response_pct() == 0);
+
+    printf("PASS\n");
+    return 0;
+}
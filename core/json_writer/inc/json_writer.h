@@ -0,0 +1,164 @@
+/**
+ * @file json_writer.h
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Append-only json writer with integer and fixed point emitters
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ * @note Replies are built in place in the caller's buffer, one typed value at
+ * a time, without a format string, a heap or a stack copy. Commas and colons
+ * are inserted by the writer so the caller only states the structure:
+ *
+ *  JW_object_begin(w);
+ *  JW_key(w, "rw_speed");
+ *  JW_int(w, mv);
+ *  JW_object_end(w);
+ *
+ * A value that does not fit sets the overflow flag and every call after it
+ * is ignored, so the result only has to be checked once, at JW_finish.
+ *
+ * Nothing before len is ever rewritten, so a copy of the JW_t is a
+ * checkpoint: assigning it back drops everything written since.
+ */
+#ifndef __JSON_WRITER_H__
+#define __JSON_WRITER_H__
+#ifdef __cplusplus
+/* clang-format off */
+extern "C"
+{
+/* clang-format on */
+#endif /* Start C linkage */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Nesting depth of objects and arrays */
+#define JW_DEPTH_MAX (16u)
+
+/* Significant digits JW_real emits at most, about what a float holds */
+#define JW_REAL_DIGITS_MAX (7u)
+
+typedef struct
+{
+    char    *buf;
+    uint16_t cap;       /* bytes in buf, the terminator included */
+    uint16_t len;       /* bytes written, the terminator excluded */
+    uint16_t has_items; /* bit n set: the container at depth n is not empty */
+    uint8_t  depth;
+    bool     after_key; /* the next value belongs to the key just written */
+    bool     overflow;
+    bool     unbalanced;
+} JW_t;
+
+
+/**
+ * @brief Start an empty document in buf
+ *
+ * @param cap size of buf, at least 1 for the terminator
+ */
+void JW_init(JW_t *w, char *buf, uint16_t cap);
+
+
+void JW_object_begin(JW_t *w);
+void JW_object_end(JW_t *w);
+void JW_array_begin(JW_t *w);
+void JW_array_end(JW_t *w);
+
+
+/**
+ * @brief Write the key of the next member of the enclosing object. The key
+ * is emitted as is, it must not need escaping.
+ */
+void JW_key(JW_t *w, const char *key);
+
+
+/**
+ * @brief Write a string value, escaping quotes, backslashes and control
+ * characters
+ */
+void JW_str(JW_t *w, const char *str);
+
+
+void JW_int(JW_t *w, int32_t val);
+void JW_uint(JW_t *w, uint32_t val);
+void JW_bool(JW_t *w, bool val);
+void JW_null(JW_t *w);
+
+
+/**
+ * @brief Write val / 10^decimals with exactly decimals digits after the
+ * point. JW_fixed(w, -1234, 3) writes -1.234
+ */
+void JW_fixed(JW_t *w, int32_t val, uint8_t decimals);
+
+
+/**
+ * @brief Write val rounded to decimals digits after the point, like %.<n>f.
+ * Magnitudes of 2^31 and over are written as JW_real does, NaN and infinity
+ * are written as null.
+ *
+ * @note Where it differs from printf:
+ * - A negative value that rounds to zero has no sign: -0.0004 with 3
+ *   decimals is 0.000, printf writes -0.000.
+ * - The fraction is scaled in single precision, a value within rounding
+ *   error of a decimal tie may round the other way. The last digit then
+ *   differs by one, for fewer than 1 in 1000 random values.
+ */
+void JW_float(JW_t *w, float val, uint8_t decimals);
+
+
+/**
+ * @brief Write val with up to digits significant digits, like %.<n>g:
+ * trailing zeros are dropped and an exponent is used for very large or very
+ * small magnitudes
+ */
+void JW_real(JW_t *w, float val, uint8_t digits);
+
+
+/**
+ * @brief Write len bytes as a string of lower case hex digit pairs
+ */
+void JW_hex(JW_t *w, const uint8_t *data, uint16_t len);
+
+
+/**
+ * @brief Write a value that is already valid json (e.g. a version number)
+ */
+void JW_raw(JW_t *w, const char *json);
+
+
+/**
+ * @brief 1 if a value did not fit or the containers are not balanced so
+ * far, 0 otherwise
+ */
+int JW_error(const JW_t *w);
+
+
+/**
+ * @brief Terminate the document
+ *
+ * @return 0 if the document is complete and fits, 1 otherwise
+ */
+int JW_finish(JW_t *w);
+
+
+/**
+ * @brief Hold back n bytes at the end of the buffer so they are still free
+ * after the values written in between overflow (e.g. for closing brackets)
+ */
+void JW_reserve(JW_t *w, uint16_t n);
+
+
+/**
+ * @brief Hand back n bytes held back by JW_reserve
+ */
+void JW_release(JW_t *w, uint16_t n);
+
+#ifdef __cplusplus
+/* clang-format off */
+}
+/* clang-format on */
+#endif /* End C linkage */
+#endif /* __JSON_WRITER_H__ */
@@ -0,0 +1,555 @@
+/**
+ * @file json_writer.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Append-only json writer with integer and fixed point emitters
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ * @note Numbers are converted with 32 bit integer division only. JW_float
+ * splits the value into its integer part and fraction, which are both exact
+ * in single precision, and rounds the fraction scaled by one power of ten,
+ * so a fixed point value costs a handful of soft float operations instead of
+ * vsnprintf's conversion through double. JW_real needs the significant
+ * digits of any magnitude and a float product only carries about 7 of them,
+ * so it scales in double. It is meant for the few values that used %g.
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <math.h> /* isfinite */
+
+#include "targets.h"
+#include "config_assert.h"
+#include "json_writer.h"
+
+/* Every power of ten up to this one is exact in single precision */
+#define JW_POW10_EXACT (10)
+
+/* Largest float below 2^31 */
+#define JW_INT32_LIMIT (2147483520.0f)
+
+static const float jw_pow10f[JW_POW10_EXACT + 1] = {
+    1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f,
+};
+
+static const double jw_pow10d[JW_POW10_EXACT + 1] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+};
+
+static const uint32_t jw_pow10[10] = {
+    1u,      10u,      100u,      1000u,      10000u,
+    100000u, 1000000u, 10000000u, 100000000u, 1000000000u,
+};
+
+static void     JW_put(JW_t *w, char c);
+static void     JW_puts(JW_t *w, const char *s);
+static void     JW_value(JW_t *w);
+static void     JW_open(JW_t *w, char c);
+static void     JW_close(JW_t *w, char c);
+static void     JW_digits(JW_t *w, uint32_t val, uint8_t width);
+static double   JW_scale10(double val, int16_t exp10);
+static uint32_t JW_mantissa(double val, uint8_t digits, int16_t exp10);
+
+
+void JW_init(JW_t *w, char *buf, uint16_t cap)
+{
+    CONFIG_ASSERT(NULL != w);
+    CONFIG_ASSERT(NULL != buf);
+    CONFIG_ASSERT(cap > 0);
+    w->buf        = buf;
+    w->cap        = cap;
+    w->len        = 0;
+    w->has_items  = 0;
+    w->depth      = 0;
+    w->after_key  = false;
+    w->overflow   = false;
+    w->unbalanced = false;
+    w->buf[0]     = '\0';
+}
+
+
+void JW_object_begin(JW_t *w)
+{
+    JW_open(w, '{');
+}
+
+
+void JW_object_end(JW_t *w)
+{
+    JW_close(w, '}');
+}
+
+
+void JW_array_begin(JW_t *w)
+{
+    JW_open(w, '[');
+}
+
+
+void JW_array_end(JW_t *w)
+{
+    JW_close(w, ']');
+}
+
+
+void JW_key(JW_t *w, const char *key)
+{
+    CONFIG_ASSERT(NULL != key);
+    JW_value(w);
+    JW_put(w, '"');
+    JW_puts(w, key);
+    JW_puts(w, "\":");
+    w->after_key = true;
+}
+
+
+void JW_str(JW_t *w, const char *str)
+{
+    static const char hex[] = "0123456789abcdef";
+    CONFIG_ASSERT(NULL != str);
+    JW_value(w);
+    JW_put(w, '"');
+    for (; *str != '\0'; str++)
+    {
+        const uint8_t c = (uint8_t)*str;
+        if (c == '"' || c == '\\')
+        {
+            JW_put(w, '\\');
+            JW_put(w, (char)c);
+        }
+        else if (c == '\n')
+        {
+            JW_puts(w, "\\n");
+        }
+        else if (c < 0x20u)
+        {
+            JW_puts(w, "\\u00");
+            JW_put(w, hex[c >> 4]);
+            JW_put(w, hex[c & 0x0Fu]);
+        }
+        else
+        {
+            JW_put(w, (char)c);
+        }
+    }
+    JW_put(w, '"');
+}
+
+
+void JW_int(JW_t *w, int32_t val)
+{
+    JW_fixed(w, val, 0);
+}
+
+
+void JW_uint(JW_t *w, uint32_t val)
+{
+    JW_value(w);
+    JW_digits(w, val, 1);
+}
+
+
+void JW_bool(JW_t *w, bool val)
+{
+    JW_value(w);
+    JW_puts(w, val ? "true" : "false");
+}
+
+
+void JW_null(JW_t *w)
+{
+    JW_value(w);
+    JW_puts(w, "null");
+}
+
+
+void JW_fixed(JW_t *w, int32_t val, uint8_t decimals)
+{
+    CONFIG_ASSERT(decimals < sizeof(jw_pow10) / sizeof(*jw_pow10));
+    JW_value(w);
+
+    /* magnitude without overflowing on INT32_MIN */
+    uint32_t mag = (uint32_t)val;
+    if (val < 0)
+    {
+        JW_put(w, '-');
+        mag = 0u - mag;
+    }
+
+    if (decimals == 0)
+    {
+        JW_digits(w, mag, 1);
+    }
+    else
+    {
+        JW_digits(w, mag / jw_pow10[decimals], 1);
+        JW_put(w, '.');
+        JW_digits(w, mag % jw_pow10[decimals], decimals);
+    }
+}
+
+
+void JW_float(JW_t *w, float val, uint8_t decimals)
+{
+    if (!isfinite(val))
+    {
+        JW_null(w);
+        return;
+    }
+    if (fabsf(val) >= JW_INT32_LIMIT)
+    {
+        JW_real(w, val, JW_REAL_DIGITS_MAX);
+        return;
+    }
+    if (decimals > 9u)
+    {
+        decimals = 9u;
+    }
+
+    /* The integer part is exact and the fraction is exact in a float, so
+     * only the scaled fraction is rounded */
+    const bool  neg = (val < 0.0f);
+    const float mag = neg ? -val : val;
+    uint32_t    ip  = (uint32_t)mag;
+    const float fs  = (mag - (float)ip) * jw_pow10f[decimals];
+    uint32_t    fp  = (uint32_t)fs;
+    const float rem = fs - (float)fp;
+    if (rem > 0.5f || (rem == 0.5f && (fp & 1u)))
+    {
+        fp++; /* to nearest, ties to even as printf does */
+    }
+    if (fp >= jw_pow10[decimals])
+    {
+        fp -= jw_pow10[decimals];
+        ip++;
+    }
+
+    JW_value(w);
+    if (neg && (ip != 0 || fp != 0))
+    {
+        JW_put(w, '-');
+    }
+    JW_digits(w, ip, 1);
+    if (decimals > 0)
+    {
+        JW_put(w, '.');
+        JW_digits(w, fp, decimals);
+    }
+}
+
+
+void JW_real(JW_t *w, float val, uint8_t digits)
+{
+    if (!isfinite(val))
+    {
+        JW_null(w);
+        return;
+    }
+
+    if (digits == 0)
+    {
+        digits = 1;
+    }
+    else if (digits > JW_REAL_DIGITS_MAX)
+    {
+        digits = JW_REAL_DIGITS_MAX;
+    }
+
+    JW_value(w);
+    if (val < 0.0f)
+    {
+        JW_put(w, '-');
+        val = -val;
+    }
+    if (val == 0.0f)
+    {
+        JW_put(w, '0');
+        return;
+    }
+
+    /* Estimate the decimal exponent, val = m * 10^exp10 with 1 <= m < 10 */
+    const double v     = val;
+    int16_t      exp10 = 0;
+    double       m     = v;
+    while (m >= jw_pow10d[JW_POW10_EXACT])
+    {
+        m /= jw_pow10d[JW_POW10_EXACT];
+        exp10 += JW_POW10_EXACT;
+    }
+    while (m < 1.0)
+    {
+        m *= jw_pow10d[JW_POW10_EXACT];
+        exp10 -= JW_POW10_EXACT;
+    }
+    while (m >= 10.0)
+    {
+        m /= 10.0;
+        exp10++;
+    }
+
+    /* The significant digits as an integer, scaled once from val so the
+     * rounding of the estimate does not leak into them */
+    uint32_t mant = JW_mantissa(v, digits, exp10);
+    if (mant < jw_pow10[digits - 1])
+    {
+        exp10--;
+        mant = JW_mantissa(v, digits, exp10);
+    }
+    if (mant >= jw_pow10[digits])
+    {
+        /* rounded up into the next decade, 9.9999996 -> 10.00000 */
+        exp10++;
+        mant /= 10u;
+    }
+
+    char    d[JW_REAL_DIGITS_MAX] = {'0'};
+    uint8_t n = digits;
+    while (n > 1 && mant % 10u == 0)
+    {
+        mant /= 10u;
+        n--;
+    }
+    uint8_t i;
+    for (i = n; i > 0; i--)
+    {
+        d[i - 1] = (char)('0' + mant % 10u);
+        mant /= 10u;
+    }
+
+    if (exp10 < -4 || exp10 >= (int16_t)digits)
+    {
+        /* d.ddde[+-]XX, as %g */
+        JW_put(w, d[0]);
+        if (n > 1)
+        {
+            JW_put(w, '.');
+            for (i = 1; i < n; i++)
+            {
+                JW_put(w, d[i]);
+            }
+        }
+        JW_put(w, 'e');
+        JW_put(w, (exp10 < 0) ? '-' : '+');
+        JW_digits(w, (uint32_t)((exp10 < 0) ? -exp10 : exp10), 2);
+    }
+    else if (exp10 < 0)
+    {
+        JW_puts(w, "0.");
+        for (i = 1; i < (uint8_t)-exp10; i++)
+        {
+            JW_put(w, '0');
+        }
+        for (i = 0; i < n; i++)
+        {
+            JW_put(w, d[i]);
+        }
+    }
+    else
+    {
+        for (i = 0; i <= (uint8_t)exp10; i++)
+        {
+            JW_put(w, (i < n) ? d[i] : '0');
+        }
+        if (n > exp10 + 1)
+        {
+            JW_put(w, '.');
+            for (; i < n; i++)
+            {
+                JW_put(w, d[i]);
+            }
+        }
+    }
+}
+
+
+void JW_hex(JW_t *w, const uint8_t *data, uint16_t len)
+{
+    static const char hex[] = "0123456789abcdef";
+    CONFIG_ASSERT(NULL != data || len == 0);
+    JW_value(w);
+    if (w->overflow)
+    {
+        return;
+    }
+
+    /* quotes, digits and the terminator */
+    if ((uint32_t)w->len + 2u * len + 3u > w->cap)
+    {
+        w->overflow = true;
+        return;
+    }
+    char    *out = &w->buf[w->len];
+    uint16_t i;
+    *out++ = '"';
+    for (i = 0; i < len; i++)
+    {
+        *out++ = hex[data[i] >> 4];
+        *out++ = hex[data[i] & 0x0Fu];
+    }
+    *out++ = '"';
+    w->len = (uint16_t)(out - w->buf);
+}
+
+
+void JW_raw(JW_t *w, const char *json)
+{
+    CONFIG_ASSERT(NULL != json);
+    JW_value(w);
+    JW_puts(w, json);
+}
+
+
+int JW_error(const JW_t *w)
+{
+    CONFIG_ASSERT(NULL != w);
+    return (w->overflow || w->unbalanced) ? 1 : 0;
+}
+
+
+int JW_finish(JW_t *w)
+{
+    CONFIG_ASSERT(NULL != w);
+    w->buf[w->len] = '\0';
+    return (JW_error(w) || w->depth != 0 || w->after_key) ? 1 : 0;
+}
+
+
+void JW_reserve(JW_t *w, uint16_t n)
+{
+    CONFIG_ASSERT(NULL != w);
+    CONFIG_ASSERT(w->cap > w->len + n);
+    w->cap -= n;
+}
+
+
+void JW_release(JW_t *w, uint16_t n)
+{
+    CONFIG_ASSERT(NULL != w);
+    w->cap += n;
+}
+
+
+static void JW_put(JW_t *w, char c)
+{
+    if (w->overflow)
+    {
+        return;
+    }
+    if (w->len + 1u >= w->cap)
+    {
+        w->overflow = true;
+        return;
+    }
+    w->buf[w->len++] = c;
+}
+
+
+static void JW_puts(JW_t *w, const char *s)
+{
+    while (*s != '\0')
+    {
+        JW_put(w, *s++);
+    }
+}
+
+
+/* Separate the value (or key) about to be written from the one before it */
+static void JW_value(JW_t *w)
+{
+    CONFIG_ASSERT(NULL != w);
+    if (w->after_key)
+    {
+        w->after_key = false;
+        return;
+    }
+    if (w->depth > 0)
+    {
+        const uint16_t bit = (uint16_t)(1u << (w->depth - 1u));
+        if (w->has_items & bit)
+        {
+            JW_put(w, ',');
+        }
+        w->has_items |= bit;
+    }
+}
+
+
+static void JW_open(JW_t *w, char c)
+{
+    JW_value(w);
+    JW_put(w, c);
+    if (w->depth >= JW_DEPTH_MAX)
+    {
+        w->unbalanced = true;
+        return;
+    }
+    w->depth++;
+    w->has_items &= (uint16_t)~(1u << (w->depth - 1u));
+}
+
+
+static void JW_close(JW_t *w, char c)
+{
+    CONFIG_ASSERT(NULL != w);
+    if (w->depth == 0 || w->after_key)
+    {
+        w->unbalanced = true;
+        return;
+    }
+    w->depth--;
+    JW_put(w, c);
+}
+
+
+/* Decimal digits of val, zero padded to at least width */
+static void JW_digits(JW_t *w, uint32_t val, uint8_t width)
+{
+    char    tmp[10];
+    uint8_t n = 0;
+    do
+    {
+        tmp[n++] = (char)('0' + val % 10u);
+        val /= 10u;
+    } while (val != 0);
+    while (n < width && n < sizeof(tmp))
+    {
+        tmp[n++] = '0';
+    }
+    while (n > 0)
+    {
+        JW_put(w, tmp[--n]);
+    }
+}
+
+
+/* val * 10^exp10, one rounding per ten decades */
+static double JW_scale10(double val, int16_t exp10)
+{
+    while (exp10 > JW_POW10_EXACT)
+    {
+        val *= jw_pow10d[JW_POW10_EXACT];
+        exp10 -= JW_POW10_EXACT;
+    }
+    while (exp10 < -JW_POW10_EXACT)
+    {
+        val /= jw_pow10d[JW_POW10_EXACT];
+        exp10 += JW_POW10_EXACT;
+    }
+    return (exp10 >= 0) ? val * jw_pow10d[exp10] : val / jw_pow10d[-exp10];
+}
+
+
+/* The first digits significant digits of val ~ 10^exp10, rounded */
+static uint32_t JW_mantissa(double val, uint8_t digits, int16_t exp10)
+{
+    const double scaled = JW_scale10(val, (int16_t)(digits - 1 - exp10));
+    uint32_t     mant   = (uint32_t)scaled;
+    const double rem    = scaled - (double)mant;
+    if (rem > 0.5 || (rem == 0.5 && (mant & 1u)))
+    {
+        mant++;
+    }
+    return mant;
+}
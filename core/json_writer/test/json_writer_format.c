@@ -0,0 +1,235 @@
+/**
+ * @file json_writer_format.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Json writer tests: structure, escaping, overflow and number
+ * formatting against the printf conversions it replaces
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ */
+#if defined(TARGET_MCU)
+#error NATIVE TESTS CANNOT BE RUN ON A BARE METAL MICROCONTROLLER
+#endif /* #if defined(TARGET_MCU) */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "json_writer.h"
+#include "test_expect.h"
+
+#define RANDOM_VALUES (200000u)
+
+
+static uint32_t lcg_state = 12345u;
+
+
+static uint32_t lcg(void)
+{
+    lcg_state = lcg_state * 1664525u + 1013904223u;
+    return lcg_state;
+}
+
+
+/* Any finite float, magnitudes spread evenly over the decades */
+static float random_float(void)
+{
+    const float mant = (float)(lcg() >> 8) / (float)(1u << 24);
+    const int   exp  = (int)(lcg() % 61u) - 30;
+    const float val  = (1.0f + 9.0f * mant) * powf(10.0f, (float)exp);
+    return (lcg() & 1u) ? -val : val;
+}
+
+
+static const char *write_float(char *buf, float val, uint8_t decimals)
+{
+    static JW_t w;
+    JW_init(&w, buf, 64);
+    JW_float(&w, val, decimals);
+    return (JW_finish(&w) == 0) ? buf : "finish failed";
+}
+
+
+static const char *write_real(char *buf, float val, uint8_t digits)
+{
+    static JW_t w;
+    JW_init(&w, buf, 64);
+    JW_real(&w, val, digits);
+    return (JW_finish(&w) == 0) ? buf : "finish failed";
+}
+
+
+int main(void)
+{
+    JW_t         w;
+    char         buf[128];
+    char         ref[64];
+    unsigned int i;
+
+    /* Structure: separators are the writer's job */
+    JW_init(&w, buf, sizeof(buf));
+    JW_object_begin(&w);
+    JW_key(&w, "a");
+    JW_int(&w, -12);
+    JW_key(&w, "b");
+    JW_array_begin(&w);
+    JW_uint(&w, 4000000000u);
+    JW_bool(&w, true);
+    JW_null(&w);
+    JW_array_begin(&w);
+    JW_array_end(&w);
+    JW_object_begin(&w);
+    JW_object_end(&w);
+    JW_array_end(&w);
+    JW_key(&w, "c");
+    JW_str(&w, "q\"\\\n\t");
+    JW_key(&w, "v");
+    JW_raw(&w, "00.02");
+    JW_object_end(&w);
+    EXPECT(JW_finish(&w) == 0);
+    EXPECT(strcmp(buf, "{\"a\":-12,\"b\":[4000000000,true,null,[],{}],"
+                       "\"c\":\"q\\\"\\\\\\n\\u0009\",\"v\":00.02}") == 0);
+    EXPECT(w.len == strlen(buf));
+
+    /* Integers and fixed point */
+    JW_init(&w, buf, sizeof(buf));
+    JW_array_begin(&w);
+    JW_int(&w, INT32_MIN);
+    JW_int(&w, 0);
+    JW_fixed(&w, -1234, 3);
+    JW_fixed(&w, 5, 3);
+    JW_fixed(&w, -5, 1);
+    JW_fixed(&w, INT32_MAX, 9);
+    JW_array_end(&w);
+    EXPECT(JW_finish(&w) == 0);
+    EXPECT(strcmp(buf, "[-2147483648,0,-1.234,0.005,-0.5,2.147483647]") == 0);
+
+    /* Unbalanced documents are reported */
+    JW_init(&w, buf, sizeof(buf));
+    JW_object_begin(&w);
+    EXPECT(JW_error(&w) == 0);
+    EXPECT(JW_finish(&w) == 1);
+    JW_init(&w, buf, sizeof(buf));
+    JW_array_end(&w);
+    EXPECT(JW_error(&w) == 1);
+    JW_init(&w, buf, sizeof(buf));
+    JW_object_begin(&w);
+    JW_key(&w, "k");
+    JW_object_end(&w);
+    EXPECT(JW_finish(&w) == 1);
+    JW_init(&w, buf, sizeof(buf));
+    for (i = 0; i <= JW_DEPTH_MAX; i++)
+    {
+        JW_array_begin(&w);
+    }
+    EXPECT(JW_error(&w) == 1);
+
+    /* Overflow stops the writer inside the buffer, terminator included */
+    memset(buf, 'x', sizeof(buf));
+    JW_init(&w, buf, 8);
+    JW_object_begin(&w);
+    JW_key(&w, "key");
+    JW_str(&w, "value");
+    JW_object_end(&w);
+    EXPECT(JW_error(&w) == 1);
+    EXPECT(JW_finish(&w) == 1);
+    EXPECT(strlen(buf) == 7 && buf[8] == 'x');
+    JW_init(&w, buf, 8);
+    JW_int(&w, 1234567);
+    EXPECT(JW_finish(&w) == 0);
+    JW_init(&w, buf, 8);
+    JW_int(&w, 12345678);
+    EXPECT(JW_finish(&w) == 1);
+    const uint8_t bytes[] = {0x00, 0x7f, 0x80, 0xff};
+    JW_init(&w, buf, 11);
+    JW_hex(&w, bytes, sizeof(bytes));
+    EXPECT(JW_finish(&w) == 0);
+    EXPECT(strcmp(buf, "\"007f80ff\"") == 0);
+    JW_init(&w, buf, 10);
+    JW_hex(&w, bytes, sizeof(bytes));
+    EXPECT(JW_finish(&w) == 1);
+
+    /* Reserved bytes survive an overflow, a copy of the writer rewinds it */
+    JW_init(&w, buf, 12);
+    JW_reserve(&w, 1);
+    JW_array_begin(&w);
+    JW_int(&w, 1);
+    JW_t mark = w;
+    JW_str(&w, "too long");
+    EXPECT(JW_error(&w) == 1);
+    w = mark;
+    JW_int(&w, 2);
+    JW_release(&w, 1);
+    JW_array_end(&w);
+    EXPECT(JW_finish(&w) == 0);
+    EXPECT(strcmp(buf, "[1,2]") == 0);
+
+    /* Fixed decimals, as %.<n>f */
+    EXPECT(strcmp(write_float(buf, 12.345678f, 3), "12.346") == 0);
+    EXPECT(strcmp(write_float(buf, -0.126f, 2), "-0.13") == 0);
+    EXPECT(strcmp(write_float(buf, 3.0f, 0), "3") == 0);
+    EXPECT(strcmp(write_float(buf, 1.0e12f, 3), "1e+12") == 0);
+    EXPECT(strcmp(write_float(buf, 3.0e7f, 3), "30000000.000") == 0);
+    EXPECT(strcmp(write_float(buf, 5014.97021f, 4), "5014.9702") == 0);
+    EXPECT(strcmp(write_float(buf, 9.9996f, 3), "10.000") == 0);
+    EXPECT(strcmp(write_float(buf, -0.0004f, 3), "0.000") == 0);
+    EXPECT(strcmp(write_float(buf, NAN, 3), "null") == 0);
+    EXPECT(strcmp(write_float(buf, -INFINITY, 3), "null") == 0);
+
+    /* Significant digits, as %.<n>g */
+    EXPECT(strcmp(write_real(buf, 0.0f, 7), "0") == 0);
+    EXPECT(strcmp(write_real(buf, 1.2345678e-10f, 7), "1.234568e-10") == 0);
+    EXPECT(strcmp(write_real(buf, 0.0001f, 7), "0.0001") == 0);
+    EXPECT(strcmp(write_real(buf, 123456.0f, 7), "123456") == 0);
+    EXPECT(strcmp(write_real(buf, 12345678.0f, 7), "1.234568e+07") == 0);
+    EXPECT(strcmp(write_real(buf, 9.9999999f, 3), "10") == 0);
+    EXPECT(strcmp(write_real(buf, -2.5f, 7), "-2.5") == 0);
+    EXPECT(strcmp(write_real(buf, 5.605194e-45f, 7), "5.605194e-45") == 0);
+    EXPECT(strcmp(write_real(buf, 3.4e38f, 7), "3.4e+38") == 0);
+
+    /* Against printf over random values. %g scales in double and matches
+     * exactly. %f rounds a single precision product of the fraction, so a
+     * float within rounding error of a decimal tie may land on the other
+     * side of it. printf's "-0.00" is 0 here. */
+    unsigned int fixed_cnt = 0, fixed_off = 0, real_off = 0;
+    for (i = 0; i < RANDOM_VALUES; i++)
+    {
+        const float   val      = random_float();
+        const uint8_t decimals = (uint8_t)(lcg() % 5u);
+        const uint8_t digits   = (uint8_t)(1u + lcg() % JW_REAL_DIGITS_MAX);
+
+        snprintf(ref, sizeof(ref), "%.*g", digits, val);
+        write_real(buf, val, digits);
+        if (strtod(buf, NULL) != strtod(ref, NULL))
+        {
+            printf("%s != %s\n", buf, ref);
+            real_off++;
+        }
+
+        if (fabsf(val) < 1.0e9f)
+        {
+            fixed_cnt++;
+            snprintf(ref, sizeof(ref), "%.*f", decimals, val);
+            write_float(buf, val, decimals);
+            if (strtod(buf, NULL) != strtod(ref, NULL))
+            {
+                EXPECT(fabs(strtod(buf, NULL) - strtod(ref, NULL)) <=
+                       1.01 * pow(10.0, -decimals));
+                fixed_off++;
+            }
+        }
+    }
+    printf("%%g : %u of %u differ from printf in the last digit\n", real_off,
+           RANDOM_VALUES);
+    printf("%%f : %u of %u differ from printf in the last digit\n", fixed_off,
+           fixed_cnt);
+    EXPECT(real_off == 0);
+    EXPECT(fixed_off < fixed_cnt / 1000u);
+
+    printf("PASS\n");
+    return 0;
+}
@@ -9,6 +9,22 @@ extern "C"
 
 #include <stdint.h>
 
+/* Bytes of one command frame, the terminator included */
+#ifndef JSON_CMD_LEN_MAX
+#define JSON_CMD_LEN_MAX (256)
+#endif /* ifndef JSON_CMD_LEN_MAX */
+
+/* Tokens of one command frame: one per object or array plus two per key
+ * with a plain value. A full housekeeping batch takes about 40 */
+#ifndef JSON_TKN_CNT
+#define JSON_TKN_CNT (48)
+#endif /* ifndef JSON_TKN_CNT */
+
+/* Longest argument value of a command (mode, parameter or channel names) */
+#ifndef JSON_ARG_LEN_MAX
+#define JSON_ARG_LEN_MAX (40)
+#endif /* ifndef JSON_ARG_LEN_MAX */
+
 typedef enum
 {
     JSON_PARSE_ok,
@@ -22,9 +38,27 @@ typedef enum
  * @param json nul-terminated string in json format
  * @param json_strlen
  * @return one of JSON_PARSE_t
+ *
+ * @note A frame with more than one command, {"imu":"read","mode":"read"},
+ * or an array of command objects is a batch. Its commands run in order and
+ * the frame gets one reply: an array with each command's own reply, or
+ * {"error":"command","cmd":"<key>"} for a command that could not be parsed.
+ * Keys that are not commands are arguments of the command before them. If a
+ * reply does not fit, it is replaced by {"error":"reply"} and the commands
+ * after it are not run, so the array always ends at the last command run.
  */
 JSON_PARSE_t json_parse(uint8_t *json);
 
+/**
+ * @brief One pass of the main loop over the OBC link: run the oldest
+ * received command and send one telemetry frame
+ * @note A command that does not parse is answered with
+ * {"error":"json format"|"json unsupported","received":"<command>"}. One
+ * frame goes out per call as the uart drops a message while busy, subscribed
+ * stream frames first and the bulk download in the gaps.
+ */
+void json_service(void);
+
 #ifdef __cplusplus
 /* clang-format off */
 }
@@ -14,7 +14,6 @@
 #include <limits.h>
 #include <stdlib.h>
 #include <string.h>
-#include <stdio.h>
 
 #include "jtok.h"
 #include "obc_interface.h"
@@ -26,12 +25,26 @@
 #include "sun_sensors.h"
 #include "magnetometer.h"
 #include "imu.h"
+#include "attitude_control.h"
+#include "adcs_modes.h"
+#include "parameters.h"
+#include "telemetry.h"
+#include "tlm_stream.h"
+#include "profiling.h"
+#include "isr_monitor.h"
 
 #define BASE_10 10
-#define JSON_TKN_CNT 20
 #define JSON_HANDLER_RETVAL_ERROR NULL
 #define NO_SIBLING_IDX 0xFFFF
 
+/* Kept free in a batch reply for the reply that replaces one that does not
+ * fit, and the closing bracket */
+#define JSON_BATCH_FULL_REPLY ",{\"error\":\"reply\"}"
+#define JSON_BATCH_RESERVE (sizeof(JSON_BATCH_FULL_REPLY "]") - 1)
+
+_Static_assert(OBC_RX_FRAME_LEN < JSON_CMD_LEN_MAX,
+               "a received frame and its terminator fit in a command");
+
 typedef int token_index_t;
 
 typedef void          *json_handler_retval;
@@ -44,11 +57,32 @@ typedef struct
     json_handler handler;
 } json_parse_table_item;
 
+typedef struct
+{
+    char          name[3];
+    SUNSEN_FACE_t face;
+} sunsen_face_item;
+
 
 static jtok_tkn_t tkns[JSON_TKN_CNT];
-static char       tmp_chrbuf[100];
+static char       tmp_chrbuf[JSON_ARG_LEN_MAX];
+static uint8_t    json_cmd[JSON_CMD_LEN_MAX];
+
+/* The batch reply while a batch runs, NULL otherwise */
+static JW_t *batch;
+/* The batch reply before the running command wrote its reply */
+static JW_t  batch_mark;
+static bool  batch_full;
 
 
+static void         json_reply_parse_error(const char *err);
+static int          json_command(token_index_t t);
+static unsigned int json_walk_commands(void (*run)(token_index_t t, int k));
+static void         json_run_batched(token_index_t t, int k);
+static JW_t        *reply_begin(void);
+static void         reply_send(JW_t *w);
+static void         reply_error(const char *what);
+
 /* JSON HANDLER DECLARATIONS */
 static json_handler_retval parse_hardware_json(json_handler_args args);
 static json_handler_retval parse_firmware_json(json_handler_args args);
@@ -57,8 +91,24 @@ static json_handler_retval parse_rw_current(json_handler_args args);
 static json_handler_retval parse_mqtr_volts(json_handler_args args);
 static json_handler_retval parse_sunSen(json_handler_args args);
 static json_handler_retval parse_magSen(json_handler_args args);
+static json_handler_retval parse_magCal(json_handler_args args);
 static json_handler_retval parse_imu(json_handler_args args);
 static json_handler_retval parse_current(json_handler_args args);
+static json_handler_retval parse_attCtrl(json_handler_args args);
+static json_handler_retval parse_mode(json_handler_args args);
+static json_handler_retval parse_param(json_handler_args args);
+static PARAM_t             parse_param_name(token_index_t *t);
+static json_handler_retval parse_tlm(json_handler_args args);
+static json_handler_retval parse_tlm_stream(token_index_t *t);
+static json_handler_retval parse_prof(json_handler_args args);
+static json_handler_retval parse_isr(json_handler_args args);
+static int parse_uint(token_index_t *t, const char *key, unsigned long max,
+                      unsigned long *val);
+static void reply_member(const char *key, int (*to_json)(JW_t *w),
+                         const char *err);
+static void reply_str(const char *key, const char *val);
+static void reply_current(const char *what, int x, int y, int z);
+static void reply_param(PARAM_t p);
 
 
 /* JSON PARSE TABLE */
@@ -71,8 +121,24 @@ static const json_parse_table_item json_parse_table[] = {
     {.key = "mqtr_volts", .handler = parse_mqtr_volts},
     {.key = "sunSen",     .handler = parse_sunSen},
     {.key = "magSen",     .handler = parse_magSen},
+    {.key = "magCal",     .handler = parse_magCal},
     {.key = "imu",        .handler = parse_imu},
     {.key = "current",    .handler = parse_current},
+    {.key = "attCtrl",    .handler = parse_attCtrl},
+    {.key = "mode",       .handler = parse_mode},
+    {.key = "param",      .handler = parse_param},
+    {.key = "tlm",        .handler = parse_tlm},
+    {.key = "prof",       .handler = parse_prof},
+    {.key = "isr",        .handler = parse_isr},
+};
+
+static const sunsen_face_item sunsen_faces[] = {
+    {.name = "x+", .face = SUNSEN_FACE_x_pos},
+    {.name = "x-", .face = SUNSEN_FACE_x_neg},
+    {.name = "y+", .face = SUNSEN_FACE_y_pos},
+    {.name = "y-", .face = SUNSEN_FACE_y_neg},
+    {.name = "z+", .face = SUNSEN_FACE_z_pos},
+    {.name = "z-", .face = SUNSEN_FACE_z_neg},
 };
 /* clang-format on */
 
@@ -81,6 +147,7 @@ JSON_PARSE_t json_parse(uint8_t *json)
 {
     CONFIG_ASSERT(json != NULL);
 
+    PROF_BEGIN(PROF_json_parse);
     JSON_PARSE_t json_parse_status = JSON_PARSE_ok;
 
     int jtok_retval;
@@ -102,19 +169,35 @@ JSON_PARSE_t json_parse(uint8_t *json)
         if (isValidJson)
         // if (isValidJson(tkns, JSON_TKN_CNT))
         {
-            /* Go through command table and check if we have a registered
-             * command for the key */
-            t++;
-
-            int k_max = sizeof(json_parse_table) / sizeof(*json_parse_table);
-            for (k = 0; k < k_max; k++)
+            /* A frame with a single command replies exactly as it always
+             * did, anything after its arguments is ignored */
+            const unsigned int cmd_cnt = json_walk_commands(NULL);
+            if (cmd_cnt > 1 || (cmd_cnt == 1 && tkns[0].type == JTOK_ARRAY))
+            {
+                JW_t *w = OBC_IF_reply_begin();
+                JW_reserve(w, JSON_BATCH_RESERVE);
+                JW_array_begin(w);
+                batch      = w;
+                batch_full = false;
+                json_walk_commands(json_run_batched);
+                batch = NULL;
+                JW_release(w, batch_full ? 1 : JSON_BATCH_RESERVE);
+                JW_array_end(w);
+                OBC_IF_reply_send(w);
+            }
+            else
             {
-                /*
-                 * If we have a command for the current key,
-                 * execute the command handler
-                 */
-                if (jtok_tokcmp(json_parse_table[k].key, &tkns[t]))
+                /* Go through command table and check if we have a
+                 * registered command for the key */
+                t++;
+
+                k = json_command(t);
+                if (k >= 0)
                 {
+                    /*
+                     * If we have a command for the current key,
+                     * execute the command handler
+                     */
                     if (NULL != json_parse_table[k].handler)
                     {
                         json_handler_retval retval;
@@ -124,14 +207,12 @@ JSON_PARSE_t json_parse(uint8_t *json)
                             json_parse_status = -1;
                         }
                     }
-                    break;
                 }
-            }
-
-            /* No match with supported json keys */
-            if (k >= k_max)
-            {
-                json_parse_status = JSON_PARSE_unsupported;
+                else
+                {
+                    /* No match with supported json keys */
+                    json_parse_status = JSON_PARSE_unsupported;
+                }
             }
         }
         else
@@ -140,17 +221,228 @@ JSON_PARSE_t json_parse(uint8_t *json)
         }
     }
 
+    PROF_END(PROF_json_parse);
     return json_parse_status;
 }
 
 
+void json_service(void)
+{
+    /* One received frame per call, the others wait in the queue */
+    if (OBC_IF_rx_frame_cnt() > 0 &&
+        OCB_IF_get_command_string(json_cmd, sizeof(json_cmd)) == 0)
+    {
+        switch (json_parse(json_cmd))
+        {
+            case JSON_PARSE_format_err:
+            {
+                json_reply_parse_error("json format");
+            }
+            break;
+            case JSON_PARSE_unsupported:
+            {
+                json_reply_parse_error("json unsupported");
+            }
+            break;
+            default:
+            {
+            }
+            break;
+        }
+    }
+
+    /* Subscribed frames go first, the download fills the gaps */
+    JW_t *w = OBC_IF_reply_begin();
+    if (TLM_stream_next(w) == 0)
+    {
+        OBC_IF_reply_send(w);
+    }
+    else if (TLM_download_active())
+    {
+        w = OBC_IF_reply_begin();
+        if (TLM_download_next(w) == 0)
+        {
+            OBC_IF_reply_send(w);
+        }
+    }
+}
+
+
+/* The received command is echoed back as a string so it is escaped */
+static void json_reply_parse_error(const char *err)
+{
+    JW_t *w = OBC_IF_reply_begin();
+    JW_object_begin(w);
+    JW_key(w, "error");
+    JW_str(w, err);
+    JW_key(w, "received");
+    JW_str(w, (const char *)json_cmd);
+    JW_object_end(w);
+    OBC_IF_reply_send(w);
+}
+
+
+/* Index in the parse table of the command named by the key at t, or -1 */
+static int json_command(token_index_t t)
+{
+    const int k_max = sizeof(json_parse_table) / sizeof(*json_parse_table);
+    int       k;
+    for (k = 0; k < k_max; k++)
+    {
+        if (jtok_tokcmp(json_parse_table[k].key, &tkns[t]))
+        {
+            return k;
+        }
+    }
+    return -1;
+}
+
+
+/*
+ * Call run for every command key of the frame in order, the keys of the
+ * root object or of each object in the root array. Returns the number of
+ * commands. The walk follows the sibling links between keys so it does
+ * not depend on how many tokens a handler consumed.
+ */
+static unsigned int json_walk_commands(void (*run)(token_index_t t, int k))
+{
+    unsigned int  cnt = 0;
+    token_index_t obj;
+    if (tkns[0].type == JTOK_OBJECT)
+    {
+        obj = 0;
+    }
+    else if (tkns[0].type == JTOK_ARRAY && tkns[0].size > 0)
+    {
+        obj = 1;
+    }
+    else
+    {
+        return 0;
+    }
+
+    while (obj < JSON_TKN_CNT)
+    {
+        if (tkns[obj].type == JTOK_OBJECT && tkns[obj].size > 0)
+        {
+            token_index_t t;
+            for (t = obj + 1; t > obj && t < JSON_TKN_CNT; t = tkns[t].sibling)
+            {
+                const int k = json_command(t);
+                if (k < 0)
+                {
+                    continue; /* an argument of the command before it */
+                }
+                cnt++;
+                if (run != NULL)
+                {
+                    if (batch_full)
+                    {
+                        return cnt;
+                    }
+                    run(t, k);
+                }
+            }
+        }
+
+        if (obj == 0 || tkns[obj].sibling <= obj)
+        {
+            break;
+        }
+        obj = tkns[obj].sibling;
+    }
+    return cnt;
+}
+
+
+/* Run one command of a batch and append its reply */
+static void json_run_batched(token_index_t t, int k)
+{
+    JW_t *w    = batch;
+    batch_mark = *w;
+
+    json_handler_retval retval = JSON_HANDLER_RETVAL_ERROR;
+    if (NULL != json_parse_table[k].handler)
+    {
+        retval = json_parse_table[k].handler(&t);
+    }
+    if (retval == JSON_HANDLER_RETVAL_ERROR && w->len == batch_mark.len &&
+        !w->overflow)
+    {
+        /* Alone it would have gone unanswered, here it needs a place */
+        JW_object_begin(w);
+        JW_key(w, "error");
+        JW_str(w, "command");
+        JW_key(w, "cmd");
+        JW_str(w, json_parse_table[k].key);
+        JW_object_end(w);
+    }
+
+    if (batch_full || JW_error(w) || w->depth != 1 || w->after_key)
+    {
+        /* Only the closing bracket stays held back */
+        *w = batch_mark;
+        JW_release(w, JSON_BATCH_RESERVE - 1);
+        JW_object_begin(w);
+        JW_key(w, "error");
+        JW_str(w, "reply");
+        JW_object_end(w);
+        batch_full = true;
+    }
+}
+
+
+/* The reply to the command being run: a reply of its own, or its place in
+ * the batch reply */
+static JW_t *reply_begin(void)
+{
+    if (batch == NULL)
+    {
+        return OBC_IF_reply_begin();
+    }
+    if (batch->overflow)
+    {
+        /* Starting over with an error reply would hide that the reply did
+         * not fit */
+        batch_full = true;
+    }
+    *batch = batch_mark;
+    return batch;
+}
+
+
+static void reply_send(JW_t *w)
+{
+    if (batch == NULL)
+    {
+        OBC_IF_reply_send(w);
+    }
+}
+
+
+static void reply_error(const char *what)
+{
+    JW_t *w = reply_begin();
+    JW_object_begin(w);
+    JW_key(w, "error");
+    JW_str(w, what);
+    JW_object_end(w);
+    reply_send(w);
+}
+
+
 static json_handler_retval parse_firmware_json(json_handler_args args)
 {
     token_index_t *t = (token_index_t *)args;
     *t += 1;
     if (jtok_tokcmp("read", &tkns[*t]))
     {
-        OBC_IF_printf("{\"fwVersion\" : %s}", FW_VERSION);
+        JW_t *w = reply_begin();
+        JW_object_begin(w);
+        JW_key(w, "fwVersion");
+        JW_raw(w, FW_VERSION);
+        JW_object_end(w);
+        reply_send(w);
         return (void *)t;
     }
     else
@@ -166,7 +458,12 @@ static json_handler_retval parse_hardware_json(json_handler_args args)
     *t += 1;
     if (jtok_tokcmp("read", &tkns[*t]))
     {
-        OBC_IF_printf("{\"hwVersion\" : %s}", HW_VERSION);
+        JW_t *w = reply_begin();
+        JW_object_begin(w);
+        JW_key(w, "hwVersion");
+        JW_raw(w, HW_VERSION);
+        JW_object_end(w);
+        reply_send(w);
         return (void *)t;
     }
     else
@@ -185,10 +482,7 @@ static json_handler_retval parse_rw_speed(json_handler_args args)
 
     if (jtok_tokcmp("read", &tkns[*t]))
     {
-        memset(tmp_chrbuf, 0, sizeof(tmp_chrbuf));
-
-        RW_config_to_string(tmp_chrbuf, sizeof(tmp_chrbuf));
-        OBC_IF_printf("{\"rw_speed\": %s}", tmp_chrbuf);
+        reply_member("rw_speed", RW_config_to_json, "rw_speed");
     }
     else if (jtok_tokcmp("write", &tkns[*t]))
     {
@@ -253,12 +547,12 @@ static json_handler_retval parse_rw_speed(json_handler_args args)
                 {
                     /* Array didn't contain speed values for all the params
                      * eg : [ 12, 34] <-- missing third value for rw_z */
-                    OBC_IF_printf("{\"rw_speed\": \"write error\"}");
+                    reply_str("rw_speed", "write error");
                     return JSON_HANDLER_RETVAL_ERROR;
                 }
                 else
                 {
-                    OBC_IF_printf("{\"rw_speed\": \"set\"}");
+                    reply_str("rw_speed", "set");
                     t = arr_tkn_idx;
                     /*
                      * After we walk past last element of
@@ -299,11 +593,16 @@ static json_handler_retval parse_rw_current(json_handler_args args)
 
     if (jtok_tokcmp("read", &tkns[*t]))
     {
-        int current_ma_x = RW_measure_current_ma(REAC_WHEEL_x);
-        int current_ma_y = RW_measure_current_ma(REAC_WHEEL_y);
-        int current_ma_z = RW_measure_current_ma(REAC_WHEEL_z);
-        OBC_IF_printf("{\"rw_current\": [ %d, %d, %d]}", current_ma_x,
-                      current_ma_y, current_ma_z);
+        JW_t *w = reply_begin();
+        JW_object_begin(w);
+        JW_key(w, "rw_current");
+        JW_array_begin(w);
+        JW_int(w, RW_measure_current_ma(REAC_WHEEL_x));
+        JW_int(w, RW_measure_current_ma(REAC_WHEEL_y));
+        JW_int(w, RW_measure_current_ma(REAC_WHEEL_z));
+        JW_array_end(w);
+        JW_object_end(w);
+        reply_send(w);
     }
     else
     {
@@ -321,9 +620,7 @@ static json_handler_retval parse_mqtr_volts(json_handler_args args)
 
     if (jtok_tokcmp("read", &tkns[*t]))
     {
-        memset(tmp_chrbuf, 0, sizeof(tmp_chrbuf));
-        MQTR_config_to_str(tmp_chrbuf, sizeof(tmp_chrbuf));
-        OBC_IF_printf("{\"mqtr_volts\": %s}", tmp_chrbuf);
+        reply_member("mqtr_volts", MQTR_config_to_json, "mqtr_volts");
     }
     else if (jtok_tokcmp("write", &tkns[*t]))
     {
@@ -393,12 +690,12 @@ static json_handler_retval parse_mqtr_volts(json_handler_args args)
                 {
                     /* Array didn't contain speed values for all the params
                      * eg : [ 12, 34] <-- missing third value for rw_z */
-                    OBC_IF_printf("{\"mqtr_volts\": \"write error\"}");
+                    reply_str("mqtr_volts", "write error");
                     return JSON_HANDLER_RETVAL_ERROR;
                 }
                 else
                 {
-                    OBC_IF_printf("{\"mqtr_volts\": \"set\"}");
+                    reply_str("mqtr_volts", "set");
                     t = arr_tkn_idx;
                     /*
                      * After we walk past last element of
@@ -443,106 +740,50 @@ static json_handler_retval parse_sunSen(json_handler_args args)
         {
             *t += 1; /* Advance to value for "face" key */
 
-            int err = 0;
-            /** @note admittedly this could be refactored to use a table
-             * of some sort */
-            memset(tmp_chrbuf, 0, sizeof(tmp_chrbuf));
-            if (jtok_tokcmp("x+", &tkns[*t]))
-            {
-                err = SUNSEN_face_lux_to_string(tmp_chrbuf, sizeof(tmp_chrbuf),
-                                                SUNSEN_FACE_x_pos);
-                if (err)
-                {
-                    OBC_IF_printf("{\"error\" : \"sunsen %s measurement\"}",
-                                  "x+");
-                }
-                else
-                {
-                    OBC_IF_printf("{ \"sunSen\" : \"x+\", \"lux\" : %s}",
-                                  tmp_chrbuf);
-                }
-            }
-            else if (jtok_tokcmp("x-", &tkns[*t]))
-            {
-                err = SUNSEN_face_lux_to_string(tmp_chrbuf, sizeof(tmp_chrbuf),
-                                                SUNSEN_FACE_x_neg);
-                if (err)
-                {
-                    OBC_IF_printf("{\"error\" : \"sunsen %s measurement\"}",
-                                  "x-");
-                }
-                else
-                {
-                    OBC_IF_printf("{ \"sunSen\" : \"x-\", \"lux\" : %s}",
-                                  tmp_chrbuf);
-                }
-            }
-            else if (jtok_tokcmp("y+", &tkns[*t]))
+            const unsigned int f_max =
+                sizeof(sunsen_faces) / sizeof(*sunsen_faces);
+            unsigned int f;
+            for (f = 0; f < f_max; f++)
             {
-                err = SUNSEN_face_lux_to_string(tmp_chrbuf, sizeof(tmp_chrbuf),
-                                                SUNSEN_FACE_y_pos);
-                if (err)
-                {
-                    OBC_IF_printf("{\"error\" : \"sunsen %s measurement\"}",
-                                  "y+");
-                }
-                else
+                if (jtok_tokcmp(sunsen_faces[f].name, &tkns[*t]))
                 {
-                    OBC_IF_printf("{ \"sunSen\" : \"y+\", \"lux\" : %s}",
-                                  tmp_chrbuf);
+                    break;
                 }
             }
-            else if (jtok_tokcmp("y-", &tkns[*t]))
+            if (f >= f_max)
             {
-                err = SUNSEN_face_lux_to_string(tmp_chrbuf, sizeof(tmp_chrbuf),
-                                                SUNSEN_FACE_y_neg);
-                if (err)
-                {
-                    OBC_IF_printf("{\"error\" : \"sunsen %s measurement\"}",
-                                  "y-");
-                }
-                else
-                {
-                    OBC_IF_printf("{ \"sunSen\" : \"y-\", \"lux\" : %s}",
-                                  tmp_chrbuf);
-                }
+                return JSON_HANDLER_RETVAL_ERROR;
             }
-            else if (jtok_tokcmp("z+", &tkns[*t]))
+
+            JW_t *w = reply_begin();
+            JW_object_begin(w);
+            JW_key(w, "sunSen");
+            JW_str(w, sunsen_faces[f].name);
+            JW_key(w, "lux");
+            if (SUNSEN_face_lux_to_json(w, sunsen_faces[f].face))
             {
-                err = SUNSEN_face_lux_to_string(tmp_chrbuf, sizeof(tmp_chrbuf),
-                                                SUNSEN_FACE_z_pos);
-                if (err)
-                {
-                    OBC_IF_printf("{\"error\" : \"sunsen %s measurement\"}",
-                                  "z+");
-                }
-                else
-                {
-                    OBC_IF_printf(
-                        "{ \"sunSen\" : \"z+\", \"lux\" : %s , \"temp\" : %d}",
-                        tmp_chrbuf, SUNSEN_get_z_pos_temp());
-                }
+                w = reply_begin();
+                JW_object_begin(w);
+                JW_key(w, "error");
+                JW_str(w, "sunsen measurement");
+                JW_key(w, "face");
+                JW_str(w, sunsen_faces[f].name);
+                JW_object_end(w);
+                reply_send(w);
+                return t;
             }
-            else if (jtok_tokcmp("z-", &tkns[*t]))
+            if (sunsen_faces[f].face == SUNSEN_FACE_z_pos)
             {
-                err = SUNSEN_face_lux_to_string(tmp_chrbuf, sizeof(tmp_chrbuf),
-                                                SUNSEN_FACE_z_neg);
-                if (err)
-                {
-                    OBC_IF_printf("{\"error\" : \"sunsen %s measurement\"}",
-                                  "z-");
-                }
-                else
-                {
-                    OBC_IF_printf(
-                        "{ \"sunSen\" : \"z-\", \"lux\" : %s, \"temp\" :%d}",
-                        tmp_chrbuf, SUNSEN_get_z_neg_temp());
-                }
+                JW_key(w, "temp");
+                JW_int(w, SUNSEN_get_z_pos_temp());
             }
-            else
+            else if (sunsen_faces[f].face == SUNSEN_FACE_z_neg)
             {
-                return JSON_HANDLER_RETVAL_ERROR;
+                JW_key(w, "temp");
+                JW_int(w, SUNSEN_get_z_neg_temp());
             }
+            JW_object_end(w);
+            reply_send(w);
         }
         else
         {
@@ -564,21 +805,17 @@ static json_handler_retval parse_magSen(json_handler_args args)
     *t += 1; /* Advance to first key of json */
     if (jtok_tokcmp("read", &tkns[*t]))
     {
-        memset(tmp_chrbuf, 0, sizeof(tmp_chrbuf));
-        int err = MAGTOM_measurement_to_string(tmp_chrbuf, sizeof(tmp_chrbuf));
-        if (err)
-        {
-            OBC_IF_printf("{ \"error\" : \"mqtr measurement\"}", tmp_chrbuf);
-        }
-        else
-        {
-            OBC_IF_printf("{ \"magSen\" : %s}", tmp_chrbuf);
-        }
+        /* Taken in the quiet window when the mode duty cycles the coils */
+        reply_member("magSen", MODE_mag_field_to_json, "mqtr measurement");
     }
     else if (jtok_tokcmp("reset", &tkns[*t]))
     {
         MAGTOM_reset();
-        OBC_IF_printf("{\"magSen\" : \"restarted\"}");
+        reply_str("magSen", "restarted");
+    }
+    else if (jtok_tokcmp("duty", &tkns[*t]))
+    {
+        reply_member("magSen", MODE_mag_duty_to_json, "magSen duty");
     }
     else
     {
@@ -589,24 +826,60 @@ static json_handler_retval parse_magSen(json_handler_args args)
 }
 
 
-static json_handler_retval parse_imu(json_handler_args args)
+static json_handler_retval parse_magCal(json_handler_args args)
 {
     token_index_t *t = (token_index_t *)args;
     CONFIG_ASSERT(*t < JSON_TKN_CNT);
     *t += 1; /* Advance to first key of json */
-    if (jtok_tokcmp("read", &tkns[*t]))
+    if (jtok_tokcmp("start", &tkns[*t]))
     {
-        memset(tmp_chrbuf, 0, sizeof(tmp_chrbuf));
-        int error = IMU_measurements_to_string(tmp_chrbuf, sizeof(tmp_chrbuf));
-        if (error)
-        {
-            OBC_IF_printf("{\"error\" : \"imu measurement\"}", tmp_chrbuf);
-        }
-        else
+        MAGTOM_cal_start();
+    }
+    else if (jtok_tokcmp("solve", &tkns[*t]))
+    {
+        MAGTOM_cal_solve();
+    }
+    else if (jtok_tokcmp("abort", &tkns[*t]))
+    {
+        MAGTOM_cal_abort();
+    }
+    else if (jtok_tokcmp("reset", &tkns[*t]))
+    {
+        if (MAGTOM_cal_reset())
         {
-            OBC_IF_printf("{\"imu\" : %s}", tmp_chrbuf);
+            reply_error("magCal reset");
+            return t;
         }
     }
+    else if (jtok_tokcmp("matrix", &tkns[*t]))
+    {
+        reply_member("magCal", MAGTOM_cal_matrix_to_json, "magCal matrix");
+        return t;
+    }
+    else if (!jtok_tokcmp("read", &tkns[*t]))
+    {
+        return JSON_HANDLER_RETVAL_ERROR;
+    }
+
+    /* Every other command replies with the calibration state */
+    reply_member("magCal", MAGTOM_cal_to_json, "magCal");
+    return t;
+}
+
+
+static json_handler_retval parse_imu(json_handler_args args)
+{
+    token_index_t *t = (token_index_t *)args;
+    CONFIG_ASSERT(*t < JSON_TKN_CNT);
+    *t += 1; /* Advance to first key of json */
+    if (jtok_tokcmp("read", &tkns[*t]))
+    {
+        reply_member("imu", IMU_measurements_to_json, "imu measurement");
+    }
+    else if (jtok_tokcmp("stats", &tkns[*t]))
+    {
+        reply_member("imu", IMU_acq_stats_to_json, "imu stats");
+    }
     else
     {
         return JSON_HANDLER_RETVAL_ERROR;
@@ -621,31 +894,372 @@ static json_handler_retval parse_current(json_handler_args args)
     CONFIG_ASSERT(*t < JSON_TKN_CNT);
     *t += 1; /* Advance to first key of json */
 
-    int current_ma_x;
-    int current_ma_y;
-    int current_ma_z;
     if (jtok_tokcmp("rw", &tkns[*t]))
     {
         /** @note not sure why this is here because {"rw_current":"read"}
          * does the same thing... - Carl
          */
-        current_ma_x = RW_measure_current_ma(REAC_WHEEL_x);
-        current_ma_y = RW_measure_current_ma(REAC_WHEEL_y);
-        current_ma_z = RW_measure_current_ma(REAC_WHEEL_z);
-        OBC_IF_printf("{\"current\": \"rw\", \"measured\": [ %d, %d, %d]}",
-                      current_ma_x, current_ma_y, current_ma_z);
+        reply_current("rw", RW_measure_current_ma(REAC_WHEEL_x),
+                      RW_measure_current_ma(REAC_WHEEL_y),
+                      RW_measure_current_ma(REAC_WHEEL_z));
     }
     else if (jtok_tokcmp("mqtr", &tkns[*t]))
     {
-        current_ma_x = MQTR_get_current_ma(MQTR_x);
-        current_ma_y = MQTR_get_current_ma(MQTR_y);
-        current_ma_z = MQTR_get_current_ma(MQTR_z);
-        OBC_IF_printf("{\"current\": \"mqtr\", \"measured\": [ %d, %d, %d]}",
-                      current_ma_x, current_ma_y, current_ma_z);
+        reply_current("mqtr", MQTR_get_current_ma(MQTR_x),
+                      MQTR_get_current_ma(MQTR_y), MQTR_get_current_ma(MQTR_z));
+    }
+    else
+    {
+        return JSON_HANDLER_RETVAL_ERROR;
+    }
+    return t;
+}
+
+
+static json_handler_retval parse_attCtrl(json_handler_args args)
+{
+    token_index_t *t = (token_index_t *)args;
+    CONFIG_ASSERT(*t < JSON_TKN_CNT);
+    *t += 1; /* Advance to first key of json */
+    if (jtok_tokcmp("read", &tkns[*t]))
+    {
+        reply_member("attCtrl", ATTCTRL_status_to_json, "attCtrl status");
+    }
+    else
+    {
+        return JSON_HANDLER_RETVAL_ERROR;
+    }
+    return t;
+}
+
+
+static json_handler_retval parse_mode(json_handler_args args)
+{
+    token_index_t *t = (token_index_t *)args;
+    CONFIG_ASSERT(*t < JSON_TKN_CNT);
+    *t += 1; /* Advance to first key of json */
+    if (!jtok_tokcmp("read", &tkns[*t]))
+    {
+        /* {"mode" : "<mode name>"} commands a mode transition */
+        memset(tmp_chrbuf, 0, sizeof(tmp_chrbuf));
+        jtok_tokcpy(tmp_chrbuf, sizeof(tmp_chrbuf), &tkns[*t]);
+        if (MODE_command(MODE_from_string(tmp_chrbuf)))
+        {
+            reply_error("unknown mode");
+            return t;
+        }
+    }
+
+    JW_t *w = reply_begin();
+    if (MODE_to_json(w))
+    {
+        reply_error("mode status");
     }
     else
+    {
+        reply_send(w);
+    }
+    return t;
+}
+
+
+/* Parameter named by the "name" (or "idx") key that follows the command */
+static PARAM_t parse_param_name(token_index_t *t)
+{
+    *t += 1;
+    if (jtok_tokcmp("name", &tkns[*t]))
+    {
+        *t += 1;
+        memset(tmp_chrbuf, 0, sizeof(tmp_chrbuf));
+        jtok_tokcpy(tmp_chrbuf, sizeof(tmp_chrbuf), &tkns[*t]);
+        return PARAM_from_string(tmp_chrbuf);
+    }
+    else if (jtok_tokcmp("idx", &tkns[*t]))
+    {
+        *t += 1;
+        memset(tmp_chrbuf, 0, sizeof(tmp_chrbuf));
+        jtok_tokcpy(tmp_chrbuf, sizeof(tmp_chrbuf), &tkns[*t]);
+        char         *endptr = tmp_chrbuf;
+        unsigned long idx    = strtoul(tmp_chrbuf, &endptr, BASE_10);
+        if (*endptr == '\0' && endptr != tmp_chrbuf && idx < PARAM_CNT)
+        {
+            return (PARAM_t)idx;
+        }
+    }
+    return PARAM_CNT;
+}
+
+
+static json_handler_retval parse_param(json_handler_args args)
+{
+    token_index_t *t = (token_index_t *)args;
+    CONFIG_ASSERT(*t < JSON_TKN_CNT);
+    *t += 1; /* Advance to first key of json */
+    if (jtok_tokcmp("get", &tkns[*t]))
+    {
+        /* {"param":"get","name":"rw_ma_mv"} or {"param":"get","idx":6} */
+        reply_param(parse_param_name(t));
+        return t;
+    }
+    else if (jtok_tokcmp("set", &tkns[*t]))
+    {
+        /* {"param":"set","name":"rw_ma_mv","value":"0.25"}. The new value
+         * only reaches flash on the next commit */
+        PARAM_t p = parse_param_name(t);
+        if (p >= PARAM_CNT)
+        {
+            reply_error("unknown param");
+            return t;
+        }
+        *t += 1;
+        if (!jtok_tokcmp("value", &tkns[*t]))
+        {
+            return JSON_HANDLER_RETVAL_ERROR;
+        }
+        *t += 1;
+        memset(tmp_chrbuf, 0, sizeof(tmp_chrbuf));
+        jtok_tokcpy(tmp_chrbuf, sizeof(tmp_chrbuf), &tkns[*t]);
+        if (PARAM_set_from_string(p, tmp_chrbuf))
+        {
+            reply_error("param value");
+            return t;
+        }
+        reply_param(p);
+        return t;
+    }
+    else if (jtok_tokcmp("commit", &tkns[*t]))
+    {
+        if (PARAM_commit())
+        {
+            reply_error("param commit");
+            return t;
+        }
+    }
+    else if (jtok_tokcmp("defaults", &tkns[*t]))
+    {
+        PARAM_defaults();
+    }
+    else if (!jtok_tokcmp("status", &tkns[*t]))
+    {
+        return JSON_HANDLER_RETVAL_ERROR;
+    }
+
+    reply_member("param", PARAM_status_to_json, "param status");
+    return t;
+}
+
+
+static json_handler_retval parse_tlm(json_handler_args args)
+{
+    token_index_t *t = (token_index_t *)args;
+    CONFIG_ASSERT(*t < JSON_TKN_CNT);
+    *t += 1; /* Advance to first key of json */
+    if (jtok_tokcmp("sub", &tkns[*t]) || jtok_tokcmp("unsub", &tkns[*t]) ||
+        jtok_tokcmp("stream", &tkns[*t]))
+    {
+        return parse_tlm_stream(t);
+    }
+    else if (jtok_tokcmp("dump", &tkns[*t]))
+    {
+        /* The frames are sent from the main loop, one per iteration, so
+         * the download does not hold up the control loop */
+        TLM_download_start();
+        reply_str("tlm", "dump");
+        return t;
+    }
+    else if (jtok_tokcmp("flush", &tkns[*t]))
+    {
+        if (TLM_flush())
+        {
+            reply_error("tlm flush");
+            return t;
+        }
+    }
+    else if (jtok_tokcmp("erase", &tkns[*t]))
+    {
+        if (TLM_erase())
+        {
+            reply_error("tlm erase");
+            return t;
+        }
+    }
+    else if (!jtok_tokcmp("read", &tkns[*t]))
+    {
+        return JSON_HANDLER_RETVAL_ERROR;
+    }
+
+    reply_member("tlm", TLM_status_to_json, "tlm status");
+    return t;
+}
+
+
+static json_handler_retval parse_tlm_stream(token_index_t *t)
+{
+    unsigned long id, period_ms;
+    uint16_t      channels;
+    if (jtok_tokcmp("sub", &tkns[*t]))
+    {
+        /* {"tlm":"sub","id":0,"ch":"q,rate","ms":200} */
+        if (parse_uint(t, "id", TLM_STREAM_SUB_CNT - 1, &id))
+        {
+            return JSON_HANDLER_RETVAL_ERROR;
+        }
+        *t += 1;
+        if (!jtok_tokcmp("ch", &tkns[*t]))
+        {
+            return JSON_HANDLER_RETVAL_ERROR;
+        }
+        *t += 1;
+        memset(tmp_chrbuf, 0, sizeof(tmp_chrbuf));
+        jtok_tokcpy(tmp_chrbuf, sizeof(tmp_chrbuf), &tkns[*t]);
+        if (TLM_stream_channels_from_string(tmp_chrbuf, &channels) ||
+            channels == 0)
+        {
+            reply_error("tlm channel");
+            return t;
+        }
+        if (parse_uint(t, "ms", UINT16_MAX, &period_ms) ||
+            period_ms < TLM_STREAM_PERIOD_MIN_MS)
+        {
+            reply_error("tlm period");
+            return t;
+        }
+        if (TLM_stream_subscribe((uint8_t)id, channels, (uint16_t)period_ms))
+        {
+            reply_error("tlm bandwidth");
+            return t;
+        }
+    }
+    else if (jtok_tokcmp("unsub", &tkns[*t]))
+    {
+        /* {"tlm":"unsub","id":0} */
+        if (parse_uint(t, "id", TLM_STREAM_SUB_CNT - 1, &id))
+        {
+            return JSON_HANDLER_RETVAL_ERROR;
+        }
+        TLM_stream_subscribe((uint8_t)id, 0, 0);
+    }
+
+    reply_member("tlm", TLM_stream_status_to_json, "tlm stream");
+    return t;
+}
+
+
+static json_handler_retval parse_prof(json_handler_args args)
+{
+    token_index_t *t = (token_index_t *)args;
+    CONFIG_ASSERT(*t < JSON_TKN_CNT);
+    *t += 1; /* Advance to first key of json */
+    if (jtok_tokcmp("reset", &tkns[*t]))
+    {
+        /* Replies with the cleared table like a read */
+        PROF_reset();
+    }
+    else if (!jtok_tokcmp("read", &tkns[*t]))
+    {
+        return JSON_HANDLER_RETVAL_ERROR;
+    }
+    reply_member("prof", PROF_to_json, "prof");
+    return t;
+}
+
+
+static json_handler_retval parse_isr(json_handler_args args)
+{
+    token_index_t *t = (token_index_t *)args;
+    CONFIG_ASSERT(*t < JSON_TKN_CNT);
+    *t += 1; /* Advance to first key of json */
+    if (jtok_tokcmp("reset", &tkns[*t]))
+    {
+        /* Replies with the cleared statistics like a read */
+        ISR_MON_reset();
+    }
+    else if (!jtok_tokcmp("read", &tkns[*t]))
     {
         return JSON_HANDLER_RETVAL_ERROR;
     }
+    reply_member("isr", ISR_MON_to_json, "isr");
     return t;
 }
+
+
+/* Advance to key and parse the unsigned integer after it */
+static int parse_uint(token_index_t *t, const char *key, unsigned long max,
+                      unsigned long *val)
+{
+    *t += 1;
+    if (!jtok_tokcmp(key, &tkns[*t]))
+    {
+        return 1;
+    }
+    *t += 1;
+    memset(tmp_chrbuf, 0, sizeof(tmp_chrbuf));
+    jtok_tokcpy(tmp_chrbuf, sizeof(tmp_chrbuf), &tkns[*t]);
+    char *endptr = tmp_chrbuf;
+    *val         = strtoul(tmp_chrbuf, &endptr, BASE_10);
+    if (*endptr != '\0' || endptr == tmp_chrbuf || *val > max)
+    {
+        return 1;
+    }
+    return 0;
+}
+
+
+/* {"<key>" : <to_json>}, or {"error" : "<err>"} if to_json fails */
+static void reply_member(const char *key, int (*to_json)(JW_t *w),
+                         const char *err)
+{
+    JW_t *w = reply_begin();
+    JW_object_begin(w);
+    JW_key(w, key);
+    if (to_json(w))
+    {
+        reply_error(err);
+        return;
+    }
+    JW_object_end(w);
+    reply_send(w);
+}
+
+
+static void reply_str(const char *key, const char *val)
+{
+    JW_t *w = reply_begin();
+    JW_object_begin(w);
+    JW_key(w, key);
+    JW_str(w, val);
+    JW_object_end(w);
+    reply_send(w);
+}
+
+
+static void reply_current(const char *what, int x, int y, int z)
+{
+    JW_t *w = reply_begin();
+    JW_object_begin(w);
+    JW_key(w, "current");
+    JW_str(w, what);
+    JW_key(w, "measured");
+    JW_array_begin(w);
+    JW_int(w, x);
+    JW_int(w, y);
+    JW_int(w, z);
+    JW_array_end(w);
+    JW_object_end(w);
+    reply_send(w);
+}
+
+
+static void reply_param(PARAM_t p)
+{
+    JW_t *w = reply_begin();
+    JW_object_begin(w);
+    JW_key(w, "param");
+    if (PARAM_to_json(p, w))
+    {
+        reply_error("unknown param");
+        return;
+    }
+    JW_object_end(w);
+    reply_send(w);
+}
@@ -0,0 +1,203 @@
+/**
+ * @file housekeeping_batch.test.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Command batching: a batch replies with exactly the replies of its
+ * commands sent one by one, and a full housekeeping poll over the 9600 baud
+ * link with one command per frame versus batched frames
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ */
+#if defined(TARGET_MCU)
+#error NATIVE TESTS CANNOT BE RUN ON A BARE METAL MICROCONTROLLER
+#endif /* #if defined(TARGET_MCU) */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "jsons.h"
+#include "obc_interface.h"
+#include "obc_frame.h"
+#include "test_expect.h"
+
+#define LINK_BAUD (9600u)
+#define LINK_BITS_PER_BYTE (10u) /* 8N1 */
+
+/* The OBC end of the link */
+typedef struct
+{
+    unsigned int round_trips;
+    unsigned int bytes_up;   /* framed commands */
+    unsigned int bytes_down; /* framed replies */
+} link_stats;
+
+
+static char reply[OBC_TX_BUFFER_SIZE + 1];
+
+/* clang-format off */
+static const char *const housekeeping[] = {
+    "\"fwVersion\":\"read\"",
+    "\"hwVersion\":\"read\"",
+    "\"rw_speed\":\"read\"",
+    "\"rw_current\":\"read\"",
+    "\"mqtr_volts\":\"read\"",
+    "\"current\":\"mqtr\"",
+    "\"sunSen\":\"read\",\"face\":\"x+\"",
+    "\"sunSen\":\"read\",\"face\":\"x-\"",
+    "\"sunSen\":\"read\",\"face\":\"y+\"",
+    "\"sunSen\":\"read\",\"face\":\"y-\"",
+    "\"sunSen\":\"read\",\"face\":\"z+\"",
+    "\"sunSen\":\"read\",\"face\":\"z-\"",
+    "\"magSen\":\"read\"",
+    "\"magCal\":\"read\"",
+    "\"imu\":\"read\"",
+    "\"attCtrl\":\"read\"",
+    "\"mode\":\"read\"",
+    "\"param\":\"status\"",
+    "\"tlm\":\"read\"",
+};
+/* clang-format on */
+
+#define HK_CNT (sizeof(housekeeping) / sizeof(*housekeeping))
+
+/* Replies to the commands sent one per frame */
+static char single[HK_CNT][OBC_TX_BUFFER_SIZE + 1];
+
+
+int OBC_IF_tx(uint8_t *buf, uint_least16_t buflen)
+{
+    memcpy(reply, buf, buflen);
+    reply[buflen] = '\0';
+    return buflen;
+}
+
+
+/* Send the commands first to last - 1 in one frame, return the frame's
+ * reply length (0 if there was none) */
+static size_t exchange(unsigned int first, unsigned int last, link_stats *s)
+{
+    char         frame[JSON_CMD_LEN_MAX];
+    size_t       len = 0;
+    unsigned int i;
+
+    frame[len++] = '{';
+    for (i = first; i < last; i++)
+    {
+        const size_t cmd_len = strlen(housekeeping[i]);
+        if (len + cmd_len + 2 >= sizeof(frame))
+        {
+            return 0;
+        }
+        if (i > first)
+        {
+            frame[len++] = ',';
+        }
+        memcpy(&frame[len], housekeeping[i], cmd_len);
+        len += cmd_len;
+    }
+    frame[len++] = '}';
+    frame[len]   = '\0';
+
+    reply[0] = '\0';
+    json_parse((uint8_t *)frame);
+    s->round_trips++;
+    s->bytes_up += OBC_FRAME_WIRE_LEN(len);
+    s->bytes_down += OBC_FRAME_WIRE_LEN(strlen(reply));
+    return strlen(reply);
+}
+
+
+static double link_seconds(const link_stats *s)
+{
+    return (double)(s->bytes_up + s->bytes_down) * LINK_BITS_PER_BYTE /
+           LINK_BAUD;
+}
+
+
+int main(void)
+{
+    link_stats   one  = {0};
+    link_stats   many = {0};
+    unsigned int i;
+
+    /* One command per frame, as the OBC had to poll until now */
+    for (i = 0; i < HK_CNT; i++)
+    {
+        EXPECT(exchange(i, i + 1, &one) > 0);
+        EXPECT(reply[0] == '{');
+        strcpy(single[i], reply);
+    }
+
+    /* As many commands per frame as the command and reply buffers take.
+     * The reply array holds the single replies, in order, byte for byte */
+    unsigned int first = 0;
+    while (first < HK_CNT)
+    {
+        unsigned int last = HK_CNT;
+        link_stats   tries;
+        for (;;)
+        {
+            memset(&tries, 0, sizeof(tries));
+            EXPECT(last > first);
+            if (exchange(first, last, &tries) > 0 &&
+                strstr(reply, "{\"error\":\"reply\"}]") == NULL)
+            {
+                break;
+            }
+            last--;
+        }
+        many.round_trips += tries.round_trips;
+        many.bytes_up += tries.bytes_up;
+        many.bytes_down += tries.bytes_down;
+
+        if (last - first == 1)
+        {
+            /* Not a batch, so not an array */
+            EXPECT(strcmp(reply, single[first]) == 0);
+            first = last;
+            continue;
+        }
+        const char *r = reply;
+        EXPECT(*r++ == '[');
+        for (i = first; i < last; i++)
+        {
+            const size_t len = strlen(single[i]);
+            EXPECT(strncmp(r, single[i], len) == 0);
+            r += len;
+            EXPECT(*r++ == ((i + 1 < last) ? ',' : ']'));
+        }
+        first = last;
+    }
+
+    printf("full housekeeping poll, %u commands, %u baud:\n",
+           (unsigned int)HK_CNT, LINK_BAUD);
+    printf("  one per frame : %2u round trips, %4u B up, %4u B down, "
+           "%.3f s on the line\n",
+           one.round_trips, one.bytes_up, one.bytes_down, link_seconds(&one));
+    printf("  batched       : %2u round trips, %4u B up, %4u B down, "
+           "%.3f s on the line\n",
+           many.round_trips, many.bytes_up, many.bytes_down,
+           link_seconds(&many));
+    EXPECT(many.round_trips * 4 <= one.round_trips);
+    EXPECT(many.bytes_up + many.bytes_down < one.bytes_up + one.bytes_down);
+
+    /* Per command status: a command that does not parse keeps its place */
+    EXPECT(json_parse((uint8_t *)"[{\"fwVersion\":\"read\"},"
+                                 "{\"rw_speed\":\"bogus\"},"
+                                 "{\"mode\":\"warp\"}]") == JSON_PARSE_ok);
+    EXPECT(strncmp(reply, "[{\"fwVersion\":", 14) == 0);
+    EXPECT(strstr(reply, "},{\"error\":\"command\",\"cmd\":\"rw_speed\"},"
+                         "{\"error\":\"unknown mode\"}]") != NULL);
+
+    /* A single command still replies on its own, later keys are ignored */
+    EXPECT(json_parse((uint8_t *)"{\"mode\":\"read\",\"bogus\":1}") ==
+           JSON_PARSE_ok);
+    EXPECT(reply[0] == '{');
+    EXPECT(json_parse((uint8_t *)"{\"bogus\":1}") == JSON_PARSE_unsupported);
+
+    printf("PASS\n");
+    return 0;
+}
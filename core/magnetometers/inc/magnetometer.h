@@ -7,10 +7,188 @@ extern "C"
 /* clang-format on */
 #endif /* Start C linkage */
 
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "attitude_types.h"
+#include "json_writer.h"
+
+/** @todo characterise the decay of the torquer field at the magnetometer */
+#define MAGTOM_COIL_SETTLE_MS (10)
+
 void MAGTOM_init(void);
-int  MAGTOM_measurement_to_string(char *buf, int buflen);
+int  MAGTOM_measurement_to_json(JW_t *w);
 void MAGTOM_reset(void);
 
+/**
+ * @brief Measure the geomagnetic field in the body frame
+ *
+ * @note Turns the magnetorquers off for MAGTOM_COIL_SETTLE_MS before the
+ * measurement and restores their voltages afterwards.
+ *
+ * @param b field in tesla
+ * @return 0 on success, 1 if the ADC conversion failed
+ */
+int MAGTOM_get_field_T(vec3_t *b);
+
+
+/**
+ * @brief Measure the geomagnetic field in the body frame right away.
+ *
+ * @note For callers that have already turned the magnetorquers off for at
+ * least MAGTOM_COIL_SETTLE_MS (see the magnetic quiet window of the ADCS
+ * mode scheduler).
+ *
+ * @param b field in tesla
+ * @return 0 on success, 1 if the ADC conversion failed
+ */
+int MAGTOM_capture_field_T(vec3_t *b);
+
+
+/* Samples needed before a calibration can be solved */
+#define MAGTOM_CAL_MIN_SAMPLES (100u)
+
+/* Largest ratio between the axes of the raw field ellipsoid. Anything more
+ * eccentric is a bad fit rather than a soft iron distortion */
+#define MAGTOM_CAL_MAX_AXIS_RATIO (2.0f)
+
+/* Largest rms misfit of the samples to the ellipsoid, as a fraction of the
+ * squared field magnitude (about twice the relative radius error) */
+#define MAGTOM_CAL_MAX_RESIDUAL (0.05f)
+
+/* Every axis has to see a field span of at least this fraction of the field
+ * magnitude during the tumble */
+#define MAGTOM_CAL_MIN_SPAN (1.0f)
+
+/**
+ * @brief Hard and soft iron correction applied to every measurement:
+ *
+ *  b = soft_iron * (b_raw - offset_T)
+ *
+ * soft_iron is symmetric and scaled to preserve the volume of the raw field
+ * ellipsoid so the corrected field magnitude is the geometric mean of its
+ * axes.
+ */
+typedef struct
+{
+    vec3_t offset_T;        /* hard iron offset */
+    float  soft_iron[3][3]; /* row major */
+} MAGTOM_calibration_t;
+
+typedef enum
+{
+    MAGTOM_CAL_RESULT_none = 0,        /* not solved since boot */
+    MAGTOM_CAL_RESULT_ok,              /* applied and saved */
+    MAGTOM_CAL_RESULT_too_few_samples, /* keep tumbling */
+    MAGTOM_CAL_RESULT_singular,        /* samples do not fix a quadric */
+    MAGTOM_CAL_RESULT_not_ellipsoid,   /* not a sane ellipsoid */
+    MAGTOM_CAL_RESULT_coverage,        /* an axis saw too little field */
+    MAGTOM_CAL_RESULT_poor_fit,        /* samples far from the ellipsoid */
+    MAGTOM_CAL_RESULT_nv_write,        /* applied but not saved */
+} MAGTOM_CAL_RESULT_t;
+
+typedef struct
+{
+    bool                collecting;
+    uint32_t            samples;
+    MAGTOM_CAL_RESULT_t result;   /* of the last solve */
+    float               rms;      /* see MAGTOM_CAL_MAX_RESIDUAL */
+    float               radius_T; /* field magnitude of the last solve */
+} MAGTOM_cal_status_t;
+
+
+/**
+ * @brief Clear the accumulator and start feeding it every measurement.
+ *
+ * @note The accumulator is a fixed size sum of the least squares normal
+ * equations of an ellipsoid fit so samples are not stored and the tumble can
+ * last as long as needed. The current calibration stays applied until a
+ * solve succeeds.
+ */
+void MAGTOM_cal_start(void);
+
+
+/**
+ * @brief Stop collecting and discard the accumulated samples
+ */
+void MAGTOM_cal_abort(void);
+
+
+/**
+ * @brief Add an uncorrected measurement to the accumulator. Ignored unless
+ * collecting.
+ *
+ * @param b_raw field in tesla before the calibration is applied
+ */
+void MAGTOM_cal_add_sample(const vec3_t *b_raw);
+
+
+/**
+ * @brief Fit an ellipsoid to the accumulated samples.
+ *
+ * On success the new calibration is applied, written to non volatile memory
+ * and collection stops. On failure the current calibration is kept and
+ * collection continues so the tumble can be extended.
+ *
+ * @return MAGTOM_CAL_RESULT_ok on success
+ */
+MAGTOM_CAL_RESULT_t MAGTOM_cal_solve(void);
+
+
+/**
+ * @brief Apply the calibration to an uncorrected measurement in place
+ */
+void MAGTOM_cal_correct(vec3_t *b);
+
+
+/**
+ * @brief Replace the calibration and save it
+ *
+ * @return 0 on success, 1 if the calibration is not finite or could not be
+ * saved
+ */
+int MAGTOM_cal_set(const MAGTOM_calibration_t *cal);
+
+
+void MAGTOM_cal_get(MAGTOM_calibration_t *cal);
+
+
+/**
+ * @brief Go back to the identity calibration and erase the saved one
+ *
+ * @return 0 on success, 1 if the saved calibration could not be erased
+ */
+int MAGTOM_cal_reset(void);
+
+
+/**
+ * @brief Load the saved calibration (called by MAGTOM_init)
+ *
+ * @return 0 if a valid calibration was loaded, 1 if the identity calibration
+ * is used instead
+ */
+int MAGTOM_cal_load(void);
+
+
+void MAGTOM_cal_get_status(MAGTOM_cal_status_t *status);
+
+
+/**
+ * @brief Write the calibration state and hard iron offset (microtesla) as a
+ * json object
+ *
+ * @return 0 on success, 1 if w is full
+ */
+int MAGTOM_cal_to_json(JW_t *w);
+
+
+/**
+ * @brief Write the soft iron matrix as a json object
+ *
+ * @return 0 on success, 1 if w is full
+ */
+int MAGTOM_cal_matrix_to_json(JW_t *w);
+
 
 #ifdef __cplusplus
 /* clang-format off */
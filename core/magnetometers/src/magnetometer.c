@@ -14,7 +14,6 @@
  * @todo IMPLEMENT RESET FUNCTION
  */
 
-#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
@@ -24,22 +23,23 @@
 
 #include "magnetometer.h"
 #include "magnetorquers.h"
+#include "timebase.h"
+#include "parameters.h"
 
-#if defined(TARGET_MCU)
-#include <msp430.h>
-
-#include "spi.h"
-#include "ads7841e.h"
-#endif /* #if defined(TARGET_MCU) */
+#include "hal.h"
+#include "hal_ads7841.h"
 
 
-/** @todo DON'T FORGET THIS */
-#warning FIGURE OUT WHICH CHANNELS CORRESPOND TO WHICH FACES
-#warning FIGURE OUT WHICH CHANNELS CORRESPOND TO WHICH FACES
-#warning FIGURE OUT WHICH CHANNELS CORRESPOND TO WHICH FACES
-#define MAGTOM_ADS7841_X_FACE_CHANNEL (ADS7841_CHANNEL_SGL_1)
-#define MAGTOM_ADS7841_Y_FACE_CHANNEL (ADS7841_CHANNEL_SGL_2)
-#define MAGTOM_ADS7841_Z_FACE_CHANNEL (ADS7841_CHANNEL_SGL_3)
+/* Channel of each face and the count to field conversion come from the
+ * parameter store (mag_ch_*, mag_zero_cnt, mag_t_cnt). The channels are
+ * ADS7841_CHANNEL_t numbers, see hal_ads7841.h */
+#define MAGTOM_ADS7841_X_FACE_CHANNEL ((uint8_t)PARAM_get_int(PARAM_mag_ch_x))
+#define MAGTOM_ADS7841_Y_FACE_CHANNEL ((uint8_t)PARAM_get_int(PARAM_mag_ch_y))
+#define MAGTOM_ADS7841_Z_FACE_CHANNEL ((uint8_t)PARAM_get_int(PARAM_mag_ch_z))
+#define MAGTOM_ZERO_FIELD_COUNTS (PARAM_get_float(PARAM_mag_zero_cnt))
+#define MAGTOM_TESLA_PER_COUNT (PARAM_get_float(PARAM_mag_t_cnt))
+#define MAGTOM_CONVERSION_FAILED ((float)(HAL_ADS7841_CONV_FAILED))
+#define MAGTOM_UT_PER_T (1.0e6f)
 
 typedef struct
 {
@@ -48,86 +48,99 @@ typedef struct
     float z_BMAG;
 } MAGTOM_measurement_t;
 
-static void MAGTOM_enable_ADS7841(void);
-static void MAGTOM_disable_ADS7841(void);
 static void MAGTOM_init_phy(void);
 
 static MAGTOM_measurement_t MAGTOM_get_measurement(void);
+static MAGTOM_measurement_t MAGTOM_sample(void);
+static int MAGTOM_to_field_T(const MAGTOM_measurement_t *meas, vec3_t *b);
 
 
-static bool phy_initialized = false;
+static const HAL_GPIO_t MAGTOM_cs = {HAL_PORT_2, HAL_PIN(7)};
+static bool             phy_initialized = false;
+static TIMEBASE_timer_t coil_settle_timer;
 
 
 void MAGTOM_init(void)
 {
     MAGTOM_init_phy();
     phy_initialized = true;
+    MAGTOM_cal_load();
 }
 
 
 void MAGTOM_reset(void)
 {
-#if defined(TARGET_MCU)
     /* Issue reset command to IMU */
 
 /** @todo RESET THE MAGNETOMETER */
+#if defined(TARGET_MCU)
 #warning NOT IMPLEMENTED YET
-#else
-    printf("Called %s\n", __func__);
 #endif /* #if defined(TARGET_MCU) */
 }
 
 
-int MAGTOM_measurement_to_string(char *buf, int buflen)
+int MAGTOM_measurement_to_json(JW_t *w)
 {
-    CONFIG_ASSERT(NULL != buf);
-    MAGTOM_measurement_t meas            = MAGTOM_get_measurement();
-    int                  required_length = 0;
-    required_length = snprintf(buf, buflen, "[ %.4f, %.4f, %.4f ]", meas.x_BMAG,
-                               meas.y_BMAG, meas.z_BMAG);
-    return (required_length < buflen) ? 0 : 1;
+    CONFIG_ASSERT(NULL != w);
+    vec3_t b;
+    if (MAGTOM_get_field_T(&b))
+    {
+        return 1;
+    }
+
+    /* Calibrated field in microtesla */
+    JW_array_begin(w);
+    JW_float(w, b.x * MAGTOM_UT_PER_T, 3);
+    JW_float(w, b.y * MAGTOM_UT_PER_T, 3);
+    JW_float(w, b.z * MAGTOM_UT_PER_T, 3);
+    JW_array_end(w);
+    return JW_error(w);
 }
 
 
-static void MAGTOM_enable_ADS7841(void)
+int MAGTOM_get_field_T(vec3_t *b)
 {
-#if defined(TARGET_MCU)
-
-    P2OUT &= ~BIT7;
-
-#else
-    printf("Called %s\n", __func__);
-#endif /* #if defined(TARGET_MCU) */
+    CONFIG_ASSERT(NULL != b);
+    MAGTOM_measurement_t meas = MAGTOM_get_measurement();
+    return MAGTOM_to_field_T(&meas, b);
 }
 
 
-static void MAGTOM_disable_ADS7841(void)
+int MAGTOM_capture_field_T(vec3_t *b)
 {
-#if defined(TARGET_MCU)
-
-    P2OUT |= BIT7;
-
-#else
-    printf("Called %s\n", __func__);
-#endif /* #if defined(TARGET_MCU) */
+    CONFIG_ASSERT(NULL != b);
+    MAGTOM_measurement_t meas = MAGTOM_sample();
+    return MAGTOM_to_field_T(&meas, b);
 }
 
 
 static MAGTOM_measurement_t MAGTOM_get_measurement(void)
 {
-    MAGTOM_measurement_t data = {0};
-
-    /* Disable magnetorquers before measurement */
+    /* Turn the magnetorquers off and let the coils de-energize. The CPU
+     * sleeps until the settle timer expires instead of spinning */
     int MQTR_x_mv = MQTR_get_coil_voltage_mv(MQTR_x);
     int MQTR_y_mv = MQTR_get_coil_voltage_mv(MQTR_y);
     int MQTR_z_mv = MQTR_get_coil_voltage_mv(MQTR_z);
+    MQTR_set_coil_voltage_mv(MQTR_x, 0);
+    MQTR_set_coil_voltage_mv(MQTR_y, 0);
+    MQTR_set_coil_voltage_mv(MQTR_z, 0);
+
+    TIMEBASE_timer_start(&coil_settle_timer, MAGTOM_COIL_SETTLE_MS, NULL, NULL);
+    TIMEBASE_timer_wait(&coil_settle_timer);
+
+    MAGTOM_measurement_t data = MAGTOM_sample();
+
+    /* Re-enable magneqtorquers */
+    MQTR_set_coil_voltage_mv(MQTR_x, MQTR_x_mv);
+    MQTR_set_coil_voltage_mv(MQTR_y, MQTR_y_mv);
+    MQTR_set_coil_voltage_mv(MQTR_z, MQTR_z_mv);
+    return data;
+}
 
-    /** @todo This is a hacky delay to allow coils to de-energize.
-     * In future firmware revs this can be replaced by a timer expiration
-     * + callback */
-    volatile uint16_t blocking_delay = 0;
-    while (++blocking_delay < UINT16_MAX)
-        ;
+
+static MAGTOM_measurement_t MAGTOM_sample(void)
+{
+    MAGTOM_measurement_t data = {0};
 
     /* Prevent caller API error (normally they have to call init first) */
     if (!phy_initialized)
@@ -135,45 +148,44 @@ static MAGTOM_measurement_t MAGTOM_get_measurement(void)
         MAGTOM_init_phy();
     }
 
-#if defined(TARGET_MCU)
-
     MAGTOM_reset();
 
-    ADS7841_driver_init(MAGTOM_enable_ADS7841, MAGTOM_disable_ADS7841,
-                        ADS7841_PWRMODE_stayOn, ADS7841_BITRES_12);
-
-    /*
-     * Measure the conversion value (singled ended mode) from channel 2 on the
-     * ADS7841 chip that is selected using functions MAGTOM_enable_ADS7841 and
-     * MAGTOM_disable_ADS7841
-     */
-    data.x_BMAG = ADS7841_measure_channel(MAGTOM_ADS7841_X_FACE_CHANNEL);
-    data.y_BMAG = ADS7841_measure_channel(MAGTOM_ADS7841_Y_FACE_CHANNEL);
-    data.z_BMAG = ADS7841_measure_channel(MAGTOM_ADS7841_Z_FACE_CHANNEL);
+    /* Single ended conversions of the three axes in one chip select */
+    const uint8_t channels[] = {
+        MAGTOM_ADS7841_X_FACE_CHANNEL,
+        MAGTOM_ADS7841_Y_FACE_CHANNEL,
+        MAGTOM_ADS7841_Z_FACE_CHANNEL,
+    };
+    uint16_t counts[sizeof(channels)];
+    HAL_ADS7841_measure(&MAGTOM_cs, channels, counts, sizeof(channels));
+    data.x_BMAG = counts[0];
+    data.y_BMAG = counts[1];
+    data.z_BMAG = counts[2];
+    return data;
+}
 
-    ADS7841_driver_deinit();
 
-    /* Re-enable magneqtorquers */
-    MQTR_set_coil_voltage_mv(MQTR_x, MQTR_x_mv);
-    MQTR_set_coil_voltage_mv(MQTR_y, MQTR_y_mv);
-    MQTR_set_coil_voltage_mv(MQTR_z, MQTR_z_mv);
-
-#else
-    printf("Called %s\n", __func__);
-#endif /* #if defined(TARGET_MCU) */
-    return data;
+static int MAGTOM_to_field_T(const MAGTOM_measurement_t *meas, vec3_t *b)
+{
+    if (meas->x_BMAG >= MAGTOM_CONVERSION_FAILED ||
+        meas->y_BMAG >= MAGTOM_CONVERSION_FAILED ||
+        meas->z_BMAG >= MAGTOM_CONVERSION_FAILED)
+    {
+        return 1;
+    }
+    b->x = (meas->x_BMAG - MAGTOM_ZERO_FIELD_COUNTS) * MAGTOM_TESLA_PER_COUNT;
+    b->y = (meas->y_BMAG - MAGTOM_ZERO_FIELD_COUNTS) * MAGTOM_TESLA_PER_COUNT;
+    b->z = (meas->z_BMAG - MAGTOM_ZERO_FIELD_COUNTS) * MAGTOM_TESLA_PER_COUNT;
+
+    /* The calibration is fitted to the uncorrected field */
+    MAGTOM_cal_add_sample(b);
+    MAGTOM_cal_correct(b);
+    return 0;
 }
 
 
 static void MAGTOM_init_phy(void)
 {
-#if defined(TARGET_MCU)
-
     /* De-select ADS7841 for the magnetometer */
-    P2DIR |= BIT7;
-    P2OUT |= BIT7;
-
-#else
-    printf("Called %s\n", __func__);
-#endif /* #if defined(TARGET_MCU) */
-}
\ No newline at end of file
+    HAL_ADS7841_init_cs(&MAGTOM_cs);
+}
@@ -0,0 +1,588 @@
+/**
+ * @file magtom_calibration.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Online hard and soft iron calibration of the magnetometer by
+ * streaming least squares ellipsoid fitting
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ * @note While the spacecraft tumbles in a constant field the raw
+ * measurements lie on an ellipsoid. Each sample x contributes one row
+ *
+ *  phi = [x^2, y^2, z^2, 2xy, 2xz, 2yz, 2x, 2y, 2z],  phi . p = 1
+ *
+ * of an overdetermined system. Only the normal equations sum(phi phi^T) and
+ * sum(phi) are kept (45 + 9 sums), so memory does not grow with the length
+ * of the tumble. Solving them gives the quadric
+ *
+ *  x^T M x + 2 v^T x = 1
+ *
+ * whose centre o = -M^-1 v is the hard iron offset. With Q = M / k,
+ * k = 1 + o^T M o, the ellipsoid is (x - o)^T Q (x - o) = 1 and Q^1/2 maps
+ * it onto the unit sphere.
+ *
+ * Samples are scaled to roughly unit magnitude before they are accumulated
+ * to keep the single precision sums well conditioned.
+ *
+ * The calibration is kept in the parameter store (mag_off_*, mag_w*).
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+
+#include "targets.h"
+#include "config_assert.h"
+
+#include "magnetometer.h"
+#include "parameters.h"
+
+#define MAGTOM_CAL_SCALE_T (50.0e-6f) /* typical LEO field magnitude */
+#define MAGTOM_CAL_UT_PER_T (1.0e6f)
+
+#define MAGTOM_CAL_N (9) /* quadric parameters */
+#define MAGTOM_CAL_ATA_CNT ((MAGTOM_CAL_N) * ((MAGTOM_CAL_N) + 1) / 2)
+
+/* Smallest Cholesky pivot relative to its diagonal before the normal
+ * equations are treated as singular */
+#define MAGTOM_CAL_PIVOT_MIN (1.0e-6f)
+
+#define MAGTOM_CAL_JACOBI_SWEEPS (10)
+
+
+typedef struct
+{
+    float    ata[MAGTOM_CAL_ATA_CNT]; /* upper triangle, row major */
+    float    atb[MAGTOM_CAL_N];
+    uint32_t n;
+    float    min[3];
+    float    max[3];
+} magtom_cal_accumulator;
+
+
+static const char *const magtom_cal_result_names[] = {
+    [MAGTOM_CAL_RESULT_none]            = "none",
+    [MAGTOM_CAL_RESULT_ok]              = "ok",
+    [MAGTOM_CAL_RESULT_too_few_samples] = "few",
+    [MAGTOM_CAL_RESULT_singular]        = "singular",
+    [MAGTOM_CAL_RESULT_not_ellipsoid]   = "shape",
+    [MAGTOM_CAL_RESULT_coverage]        = "coverage",
+    [MAGTOM_CAL_RESULT_poor_fit]        = "fit",
+    [MAGTOM_CAL_RESULT_nv_write]        = "nv",
+};
+
+static const PARAM_t magtom_cal_offset_params[3] = {
+    PARAM_mag_off_x, PARAM_mag_off_y, PARAM_mag_off_z};
+
+static const PARAM_t magtom_cal_soft_iron_params[3][3] = {
+    {PARAM_mag_w00, PARAM_mag_w01, PARAM_mag_w02},
+    {PARAM_mag_w10, PARAM_mag_w11, PARAM_mag_w12},
+    {PARAM_mag_w20, PARAM_mag_w21, PARAM_mag_w22},
+};
+
+static const MAGTOM_calibration_t magtom_cal_identity = {
+    .offset_T  = {0.0f, 0.0f, 0.0f},
+    .soft_iron = {{1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}},
+};
+
+static MAGTOM_calibration_t magtom_cal = {
+    .offset_T  = {0.0f, 0.0f, 0.0f},
+    .soft_iron = {{1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}},
+};
+static magtom_cal_accumulator magtom_acc;
+static MAGTOM_cal_status_t    magtom_cal_status;
+
+
+static unsigned int MAGTOM_cal_ata_idx(unsigned int i, unsigned int j);
+static bool         MAGTOM_cal_cholesky_solve(float p[MAGTOM_CAL_N]);
+static void         MAGTOM_cal_eigen(float a[3][3], float v[3][3]);
+static int          MAGTOM_cal_to_params(const MAGTOM_calibration_t *cal);
+
+
+void MAGTOM_cal_start(void)
+{
+    memset(&magtom_acc, 0, sizeof(magtom_acc));
+    magtom_cal_status.collecting = true;
+    magtom_cal_status.samples    = 0;
+}
+
+
+void MAGTOM_cal_abort(void)
+{
+    memset(&magtom_acc, 0, sizeof(magtom_acc));
+    magtom_cal_status.collecting = false;
+    magtom_cal_status.samples    = 0;
+}
+
+
+void MAGTOM_cal_add_sample(const vec3_t *b_raw)
+{
+    CONFIG_ASSERT(NULL != b_raw);
+    if (!magtom_cal_status.collecting)
+    {
+        return;
+    }
+
+    const float x = b_raw->x / MAGTOM_CAL_SCALE_T;
+    const float y = b_raw->y / MAGTOM_CAL_SCALE_T;
+    const float z = b_raw->z / MAGTOM_CAL_SCALE_T;
+    const float phi[MAGTOM_CAL_N] = {
+        x * x, y * y, z * z, 2.0f * x * y, 2.0f * x * z,
+        2.0f * y * z, 2.0f * x, 2.0f * y, 2.0f * z,
+    };
+
+    unsigned int i, j, k = 0;
+    for (i = 0; i < MAGTOM_CAL_N; i++)
+    {
+        for (j = i; j < MAGTOM_CAL_N; j++)
+        {
+            magtom_acc.ata[k++] += phi[i] * phi[j];
+        }
+        magtom_acc.atb[i] += phi[i];
+    }
+
+    const float xyz[3] = {x, y, z};
+    for (i = 0; i < 3; i++)
+    {
+        if (magtom_acc.n == 0 || xyz[i] < magtom_acc.min[i])
+        {
+            magtom_acc.min[i] = xyz[i];
+        }
+        if (magtom_acc.n == 0 || xyz[i] > magtom_acc.max[i])
+        {
+            magtom_acc.max[i] = xyz[i];
+        }
+    }
+    magtom_acc.n++;
+    magtom_cal_status.samples = magtom_acc.n;
+}
+
+
+MAGTOM_CAL_RESULT_t MAGTOM_cal_solve(void)
+{
+    MAGTOM_CAL_RESULT_t result = MAGTOM_CAL_RESULT_ok;
+    float               p[MAGTOM_CAL_N];
+    float               m[3][3], minv[3][3], q[3][3], v[3][3];
+    float               o[3], lambda[3];
+    float               k = 1.0f, radius = 0.0f;
+    unsigned int        i, j, l;
+
+    if (magtom_acc.n < MAGTOM_CAL_MIN_SAMPLES)
+    {
+        result = MAGTOM_CAL_RESULT_too_few_samples;
+    }
+    else if (!MAGTOM_cal_cholesky_solve(p))
+    {
+        result = MAGTOM_CAL_RESULT_singular;
+    }
+    else
+    {
+        m[0][0] = p[0];
+        m[1][1] = p[1];
+        m[2][2] = p[2];
+        m[0][1] = m[1][0] = p[3];
+        m[0][2] = m[2][0] = p[4];
+        m[1][2] = m[2][1] = p[5];
+
+        /* Centre of the quadric */
+        minv[0][0] = m[1][1] * m[2][2] - m[1][2] * m[2][1];
+        minv[0][1] = m[0][2] * m[2][1] - m[0][1] * m[2][2];
+        minv[0][2] = m[0][1] * m[1][2] - m[0][2] * m[1][1];
+        minv[1][1] = m[0][0] * m[2][2] - m[0][2] * m[2][0];
+        minv[1][2] = m[0][2] * m[1][0] - m[0][0] * m[1][2];
+        minv[2][2] = m[0][0] * m[1][1] - m[0][1] * m[1][0];
+        minv[1][0] = minv[0][1];
+        minv[2][0] = minv[0][2];
+        minv[2][1] = minv[1][2];
+        const float det =
+            m[0][0] * minv[0][0] + m[0][1] * minv[1][0] + m[0][2] * minv[2][0];
+        if (!(det > 0.0f))
+        {
+            result = MAGTOM_CAL_RESULT_not_ellipsoid;
+        }
+        else
+        {
+            for (i = 0; i < 3; i++)
+            {
+                o[i] = -(minv[i][0] * p[6] + minv[i][1] * p[7] +
+                         minv[i][2] * p[8]) /
+                       det;
+            }
+            for (i = 0; i < 3; i++)
+            {
+                for (j = 0; j < 3; j++)
+                {
+                    k += o[i] * m[i][j] * o[j];
+                }
+            }
+            if (!(k > 0.0f))
+            {
+                result = MAGTOM_CAL_RESULT_not_ellipsoid;
+            }
+        }
+    }
+
+    if (result == MAGTOM_CAL_RESULT_ok)
+    {
+        for (i = 0; i < 3; i++)
+        {
+            for (j = 0; j < 3; j++)
+            {
+                q[i][j] = m[i][j] / k;
+            }
+        }
+        MAGTOM_cal_eigen(q, v);
+        float lmin = q[0][0], lmax = q[0][0];
+        for (i = 0; i < 3; i++)
+        {
+            lambda[i] = q[i][i];
+            lmin      = (lambda[i] < lmin) ? lambda[i] : lmin;
+            lmax      = (lambda[i] > lmax) ? lambda[i] : lmax;
+        }
+        if (!(lmin > 0.0f) || lmax > lmin * MAGTOM_CAL_MAX_AXIS_RATIO *
+                                         MAGTOM_CAL_MAX_AXIS_RATIO)
+        {
+            result = MAGTOM_CAL_RESULT_not_ellipsoid;
+        }
+        else
+        {
+            /* Geometric mean of the semi axes */
+            radius = 1.0f / sqrtf(cbrtf(lambda[0] * lambda[1] * lambda[2]));
+            for (i = 0; i < 3; i++)
+            {
+                if (magtom_acc.max[i] - magtom_acc.min[i] <
+                    MAGTOM_CAL_MIN_SPAN * radius)
+                {
+                    result = MAGTOM_CAL_RESULT_coverage;
+                }
+            }
+        }
+    }
+
+    if (result == MAGTOM_CAL_RESULT_ok)
+    {
+        /* Sum of squared residuals from the normal equations:
+         * sum (1 - phi.p)^2 = n - 2 p.atb + p^T ata p */
+        float rss = (float)magtom_acc.n;
+        for (i = 0; i < MAGTOM_CAL_N; i++)
+        {
+            rss -= 2.0f * p[i] * magtom_acc.atb[i];
+            for (j = 0; j < MAGTOM_CAL_N; j++)
+            {
+                rss += p[i] * magtom_acc.ata[MAGTOM_cal_ata_idx(i, j)] * p[j];
+            }
+        }
+        if (rss < 0.0f)
+        {
+            rss = 0.0f; /* rounding */
+        }
+        magtom_cal_status.rms = sqrtf(rss / magtom_acc.n) / k;
+        if (magtom_cal_status.rms > MAGTOM_CAL_MAX_RESIDUAL)
+        {
+            result = MAGTOM_CAL_RESULT_poor_fit;
+        }
+    }
+
+    if (result == MAGTOM_CAL_RESULT_ok)
+    {
+        MAGTOM_calibration_t cal;
+        for (i = 0; i < 3; i++)
+        {
+            for (j = 0; j < 3; j++)
+            {
+                float w = 0.0f;
+                for (l = 0; l < 3; l++)
+                {
+                    w += v[i][l] * sqrtf(lambda[l]) * v[j][l];
+                }
+                cal.soft_iron[i][j] = w * radius;
+            }
+        }
+        cal.offset_T.x = o[0] * MAGTOM_CAL_SCALE_T;
+        cal.offset_T.y = o[1] * MAGTOM_CAL_SCALE_T;
+        cal.offset_T.z = o[2] * MAGTOM_CAL_SCALE_T;
+
+        magtom_cal_status.radius_T   = radius * MAGTOM_CAL_SCALE_T;
+        magtom_cal_status.collecting = false;
+        if (MAGTOM_cal_to_params(&cal))
+        {
+            /* Fit is outside the bounds of the parameter store */
+            MAGTOM_cal_to_params(&magtom_cal);
+            result = MAGTOM_CAL_RESULT_not_ellipsoid;
+        }
+        else
+        {
+            magtom_cal = cal;
+            if (PARAM_commit())
+            {
+                result = MAGTOM_CAL_RESULT_nv_write;
+            }
+        }
+    }
+
+    magtom_cal_status.result = result;
+    return result;
+}
+
+
+void MAGTOM_cal_correct(vec3_t *b)
+{
+    CONFIG_ASSERT(NULL != b);
+    const float x = b->x - magtom_cal.offset_T.x;
+    const float y = b->y - magtom_cal.offset_T.y;
+    const float z = b->z - magtom_cal.offset_T.z;
+    const float(*w)[3] = magtom_cal.soft_iron;
+    b->x = w[0][0] * x + w[0][1] * y + w[0][2] * z;
+    b->y = w[1][0] * x + w[1][1] * y + w[1][2] * z;
+    b->z = w[2][0] * x + w[2][1] * y + w[2][2] * z;
+}
+
+
+int MAGTOM_cal_set(const MAGTOM_calibration_t *cal)
+{
+    CONFIG_ASSERT(NULL != cal);
+    if (MAGTOM_cal_to_params(cal))
+    {
+        MAGTOM_cal_to_params(&magtom_cal); /* known to be in bounds */
+        return 1;
+    }
+    magtom_cal = *cal;
+    return PARAM_commit();
+}
+
+
+void MAGTOM_cal_get(MAGTOM_calibration_t *cal)
+{
+    CONFIG_ASSERT(NULL != cal);
+    *cal = magtom_cal;
+}
+
+
+int MAGTOM_cal_reset(void)
+{
+    magtom_cal = magtom_cal_identity;
+    MAGTOM_cal_to_params(&magtom_cal);
+    return PARAM_commit();
+}
+
+
+int MAGTOM_cal_load(void)
+{
+    PARAM_status_t params;
+    unsigned int   i, j;
+    magtom_cal.offset_T.x = PARAM_get_float(PARAM_mag_off_x);
+    magtom_cal.offset_T.y = PARAM_get_float(PARAM_mag_off_y);
+    magtom_cal.offset_T.z = PARAM_get_float(PARAM_mag_off_z);
+    for (i = 0; i < 3; i++)
+    {
+        for (j = 0; j < 3; j++)
+        {
+            magtom_cal.soft_iron[i][j] =
+                PARAM_get_float(magtom_cal_soft_iron_params[i][j]);
+        }
+    }
+    PARAM_get_status(&params);
+    return params.loaded ? 0 : 1;
+}
+
+
+void MAGTOM_cal_get_status(MAGTOM_cal_status_t *status)
+{
+    CONFIG_ASSERT(NULL != status);
+    *status = magtom_cal_status;
+}
+
+
+int MAGTOM_cal_to_json(JW_t *w)
+{
+    CONFIG_ASSERT(NULL != w);
+    JW_object_begin(w);
+    JW_key(w, "st");
+    JW_str(w, magtom_cal_status.collecting ? "collect" : "idle");
+    JW_key(w, "n");
+    JW_uint(w, magtom_cal_status.samples);
+    JW_key(w, "last");
+    JW_str(w, magtom_cal_result_names[magtom_cal_status.result]);
+    JW_key(w, "off");
+    JW_array_begin(w);
+    JW_float(w, magtom_cal.offset_T.x * MAGTOM_CAL_UT_PER_T, 2);
+    JW_float(w, magtom_cal.offset_T.y * MAGTOM_CAL_UT_PER_T, 2);
+    JW_float(w, magtom_cal.offset_T.z * MAGTOM_CAL_UT_PER_T, 2);
+    JW_array_end(w);
+    JW_key(w, "B");
+    JW_float(w, magtom_cal_status.radius_T * MAGTOM_CAL_UT_PER_T, 2);
+    JW_key(w, "rms");
+    JW_float(w, magtom_cal_status.rms, 4);
+    JW_object_end(w);
+    return JW_error(w);
+}
+
+
+int MAGTOM_cal_matrix_to_json(JW_t *w)
+{
+    CONFIG_ASSERT(NULL != w);
+    unsigned int i, j;
+    JW_object_begin(w);
+    JW_key(w, "W");
+    JW_array_begin(w);
+    for (i = 0; i < 3; i++)
+    {
+        for (j = 0; j < 3; j++)
+        {
+            JW_float(w, magtom_cal.soft_iron[i][j], 4);
+        }
+    }
+    JW_array_end(w);
+    JW_object_end(w);
+    return JW_error(w);
+}
+
+
+/* Index of element (i, j) of the symmetric normal matrix in the packed
+ * upper triangle */
+static unsigned int MAGTOM_cal_ata_idx(unsigned int i, unsigned int j)
+{
+    if (i > j)
+    {
+        unsigned int tmp = i;
+        i                = j;
+        j                = tmp;
+    }
+    return i * MAGTOM_CAL_N - i * (i - 1) / 2 + (j - i);
+}
+
+
+/* Solve ata p = atb. The factor is kept in packed lower triangle form */
+static bool MAGTOM_cal_cholesky_solve(float p[MAGTOM_CAL_N])
+{
+    float        l[MAGTOM_CAL_ATA_CNT];
+    unsigned int i, j, k;
+#define L(r, c) l[(r) * ((r) + 1) / 2 + (c)]
+
+    for (i = 0; i < MAGTOM_CAL_N; i++)
+    {
+        for (j = 0; j <= i; j++)
+        {
+            const float a = magtom_acc.ata[MAGTOM_cal_ata_idx(i, j)];
+            float       s = a;
+            for (k = 0; k < j; k++)
+            {
+                s -= L(i, k) * L(j, k);
+            }
+            if (i == j)
+            {
+                if (!(s > MAGTOM_CAL_PIVOT_MIN * a))
+                {
+                    return false;
+                }
+                L(i, i) = sqrtf(s);
+            }
+            else
+            {
+                L(i, j) = s / L(j, j);
+            }
+        }
+    }
+
+    for (i = 0; i < MAGTOM_CAL_N; i++)
+    {
+        float s = magtom_acc.atb[i];
+        for (k = 0; k < i; k++)
+        {
+            s -= L(i, k) * p[k];
+        }
+        p[i] = s / L(i, i);
+    }
+    for (i = MAGTOM_CAL_N; i-- > 0;)
+    {
+        float s = p[i];
+        for (k = i + 1; k < MAGTOM_CAL_N; k++)
+        {
+            s -= L(k, i) * p[k];
+        }
+        p[i] = s / L(i, i);
+    }
+#undef L
+    return true;
+}
+
+
+/* Cyclic Jacobi eigen decomposition of a symmetric 3x3 matrix. On return the
+ * diagonal of a holds the eigenvalues and the columns of v the eigenvectors */
+static void MAGTOM_cal_eigen(float a[3][3], float v[3][3])
+{
+    unsigned int sweep, p, q, r;
+    memset(v, 0, sizeof(float[3][3]));
+    v[0][0] = v[1][1] = v[2][2] = 1.0f;
+
+    for (sweep = 0; sweep < MAGTOM_CAL_JACOBI_SWEEPS; sweep++)
+    {
+        const float off = fabsf(a[0][1]) + fabsf(a[0][2]) + fabsf(a[1][2]);
+        const float diag = fabsf(a[0][0]) + fabsf(a[1][1]) + fabsf(a[2][2]);
+        if (off <= 1.0e-9f * diag)
+        {
+            break;
+        }
+        for (p = 0; p < 2; p++)
+        {
+            for (q = p + 1; q < 3; q++)
+            {
+                if (a[p][q] == 0.0f)
+                {
+                    continue;
+                }
+                const float theta = (a[q][q] - a[p][p]) / (2.0f * a[p][q]);
+                const float t     = ((theta >= 0.0f) ? 1.0f : -1.0f) /
+                                (fabsf(theta) + sqrtf(theta * theta + 1.0f));
+                const float c = 1.0f / sqrtf(t * t + 1.0f);
+                const float s = t * c;
+
+                for (r = 0; r < 3; r++)
+                {
+                    const float arp = a[r][p];
+                    const float arq = a[r][q];
+                    a[r][p]         = c * arp - s * arq;
+                    a[r][q]         = s * arp + c * arq;
+                }
+                for (r = 0; r < 3; r++)
+                {
+                    const float apr = a[p][r];
+                    const float aqr = a[q][r];
+                    a[p][r]         = c * apr - s * aqr;
+                    a[q][r]         = s * apr + c * aqr;
+                }
+                for (r = 0; r < 3; r++)
+                {
+                    const float vrp = v[r][p];
+                    const float vrq = v[r][q];
+                    v[r][p]         = c * vrp - s * vrq;
+                    v[r][q]         = s * vrp + c * vrq;
+                }
+            }
+        }
+    }
+}
+
+
+/* Write a calibration to the parameter cache, all or nothing */
+static int MAGTOM_cal_to_params(const MAGTOM_calibration_t *cal)
+{
+    const float offset[3] = {cal->offset_T.x, cal->offset_T.y,
+                             cal->offset_T.z};
+    int          err       = 0;
+    unsigned int i, j;
+    for (i = 0; i < 3; i++)
+    {
+        err |= PARAM_set_float(magtom_cal_offset_params[i], offset[i]);
+        for (j = 0; j < 3; j++)
+        {
+            err |= PARAM_set_float(magtom_cal_soft_iron_params[i][j],
+                                   cal->soft_iron[i][j]);
+        }
+    }
+    return err;
+}
+
@@ -0,0 +1,309 @@
+/**
+ * @file ellipsoid_calibration.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Recover injected hard and soft iron distortions from synthetic
+ * tumble data with the streaming ellipsoid fit
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ */
+#if defined(TARGET_MCU)
+#error NATIVE TESTS CANNOT BE RUN ON A BARE METAL MICROCONTROLLER
+#endif /* #if defined(TARGET_MCU) */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "magnetometer.h"
+#include "flash_emulator.h"
+#include "parameters.h"
+#include "test_expect.h"
+
+#define FIELD_T (45.0e-6)
+#define NOISE_T (0.1e-6)
+#define TUMBLE_SAMPLES (2000)
+
+/* Injected distortion: raw = A b + offset */
+static const double soft_iron_A[3][3] = {
+    {1.10, 0.05, -0.02},
+    {0.05, 0.92, 0.03},
+    {-0.02, 0.03, 1.04},
+};
+static const double hard_iron_T[3] = {12.0e-6, -7.0e-6, 20.0e-6};
+
+
+static double gaussian(void)
+{
+    double u1 = (rand() + 1.0) / ((double)RAND_MAX + 2.0);
+    double u2 = (rand() + 1.0) / ((double)RAND_MAX + 2.0);
+    return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+
+/* Direction of the field in the body frame during the tumble */
+static void random_direction(double d[3], double max_angle_from_x)
+{
+    double n;
+    do
+    {
+        d[0] = gaussian();
+        d[1] = gaussian();
+        d[2] = gaussian();
+        n    = sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+        d[0] /= n;
+        d[1] /= n;
+        d[2] /= n;
+    } while (acos(d[0]) > max_angle_from_x);
+}
+
+
+static vec3_t distort(const double d[3])
+{
+    double raw[3];
+    int    i;
+    for (i = 0; i < 3; i++)
+    {
+        raw[i] = hard_iron_T[i] + NOISE_T * gaussian();
+        raw[i] += FIELD_T * (soft_iron_A[i][0] * d[0] +
+                             soft_iron_A[i][1] * d[1] +
+                             soft_iron_A[i][2] * d[2]);
+    }
+    vec3_t b = {(float)raw[0], (float)raw[1], (float)raw[2]};
+    return b;
+}
+
+
+static void feed_tumble(unsigned int n, double max_angle_from_x)
+{
+    double d[3];
+    while (n-- > 0)
+    {
+        random_direction(d, max_angle_from_x);
+        vec3_t raw = distort(d);
+        MAGTOM_cal_add_sample(&raw);
+    }
+}
+
+
+static float magnitude(vec3_t b)
+{
+    return sqrtf(b.x * b.x + b.y * b.y + b.z * b.z);
+}
+
+
+static int cal_equal(const MAGTOM_calibration_t *a,
+                     const MAGTOM_calibration_t *b)
+{
+    return memcmp(a, b, sizeof(*a)) == 0;
+}
+
+
+int main(void)
+{
+    MAGTOM_calibration_t cal, saved, identity;
+    MAGTOM_cal_status_t  status;
+    char                 buf[100];
+    unsigned int         i, j, k;
+
+    srand(4242);
+    FLASH_EMU_init();
+
+    /* Blank flash: identity calibration */
+    EXPECT(PARAM_init() == 1);
+    EXPECT(MAGTOM_cal_load() == 1);
+    MAGTOM_cal_get(&identity);
+    vec3_t b = {1.0e-6f, -2.0e-6f, 3.0e-6f};
+    MAGTOM_cal_correct(&b);
+    EXPECT(b.x == 1.0e-6f && b.y == -2.0e-6f && b.z == 3.0e-6f);
+
+    /* Samples are ignored until a calibration is started */
+    feed_tumble(10, M_PI);
+    MAGTOM_cal_get_status(&status);
+    EXPECT(!status.collecting && status.samples == 0);
+
+    MAGTOM_cal_start();
+    feed_tumble(MAGTOM_CAL_MIN_SAMPLES - 1, M_PI);
+    EXPECT(MAGTOM_cal_solve() == MAGTOM_CAL_RESULT_too_few_samples);
+    MAGTOM_cal_get_status(&status);
+    EXPECT(status.collecting); /* keeps collecting after a failed solve */
+
+    /* Full tumble recovers the injected distortion */
+    feed_tumble(TUMBLE_SAMPLES, M_PI);
+    EXPECT(MAGTOM_cal_solve() == MAGTOM_CAL_RESULT_ok);
+    MAGTOM_cal_get_status(&status);
+    EXPECT(!status.collecting);
+    EXPECT(status.samples == TUMBLE_SAMPLES + MAGTOM_CAL_MIN_SAMPLES - 1);
+    EXPECT(status.rms < 0.01f);
+    MAGTOM_cal_get(&cal);
+    printf("offset [%.3f, %.3f, %.3f] uT, B %.3f uT, rms %.5f\n",
+           cal.offset_T.x * 1e6, cal.offset_T.y * 1e6, cal.offset_T.z * 1e6,
+           status.radius_T * 1e6, status.rms);
+    EXPECT(fabs(cal.offset_T.x - hard_iron_T[0]) < 0.2e-6);
+    EXPECT(fabs(cal.offset_T.y - hard_iron_T[1]) < 0.2e-6);
+    EXPECT(fabs(cal.offset_T.z - hard_iron_T[2]) < 0.2e-6);
+
+    /* W A is the volume preserving scale of the distortion */
+    const double det_A =
+        soft_iron_A[0][0] * (soft_iron_A[1][1] * soft_iron_A[2][2] -
+                             soft_iron_A[1][2] * soft_iron_A[2][1]) -
+        soft_iron_A[0][1] * (soft_iron_A[1][0] * soft_iron_A[2][2] -
+                             soft_iron_A[1][2] * soft_iron_A[2][0]) +
+        soft_iron_A[0][2] * (soft_iron_A[1][0] * soft_iron_A[2][1] -
+                             soft_iron_A[1][1] * soft_iron_A[2][0]);
+    const double scale = cbrt(det_A);
+    for (i = 0; i < 3; i++)
+    {
+        for (j = 0; j < 3; j++)
+        {
+            double wa = 0.0;
+            for (k = 0; k < 3; k++)
+            {
+                wa += cal.soft_iron[i][k] * soft_iron_A[k][j];
+            }
+            EXPECT(fabs(wa - ((i == j) ? scale : 0.0)) < 5e-3);
+        }
+    }
+    EXPECT(fabs(status.radius_T - FIELD_T * scale) < 0.1e-6);
+
+    /* Corrected field has a constant magnitude whatever the attitude */
+    float bmin = 1.0f, bmax = 0.0f;
+    for (i = 0; i < 500; i++)
+    {
+        double d[3];
+        random_direction(d, M_PI);
+        vec3_t raw = distort(d);
+        MAGTOM_cal_correct(&raw);
+        float m = magnitude(raw);
+        bmin    = (m < bmin) ? m : bmin;
+        bmax    = (m > bmax) ? m : bmax;
+    }
+    EXPECT(bmax - bmin < 1.0e-6f);
+    EXPECT(fabsf(0.5f * (bmax + bmin) - (float)(FIELD_T * scale)) < 0.2e-6f);
+
+    /* The solved calibration was committed to the parameter store and
+     * survives a reset */
+    EXPECT(FLASH_EMU_erase_count(FLASH_INFO_B) +
+               FLASH_EMU_erase_count(FLASH_INFO_C) ==
+           1);
+    saved = cal;
+    EXPECT(PARAM_init() == 0);
+    EXPECT(MAGTOM_cal_load() == 0);
+    MAGTOM_cal_get(&cal);
+    EXPECT(cal_equal(&cal, &saved));
+
+    /* Reset goes back to the identity and commits it */
+    EXPECT(MAGTOM_cal_reset() == 0);
+    MAGTOM_cal_get(&cal);
+    EXPECT(cal_equal(&cal, &identity));
+    EXPECT(PARAM_init() == 0);
+    EXPECT(MAGTOM_cal_load() == 0);
+    MAGTOM_cal_get(&cal);
+    EXPECT(cal_equal(&cal, &identity));
+
+    /* Commanded calibrations are saved too */
+    FLASH_EMU_init();
+    EXPECT(MAGTOM_cal_set(&saved) == 0);
+    EXPECT(FLASH_EMU_erase_count(FLASH_INFO_B) == 1);
+    EXPECT(PARAM_init() == 0);
+    EXPECT(MAGTOM_cal_load() == 0);
+    MAGTOM_cal_get(&cal);
+    EXPECT(cal_equal(&cal, &saved));
+
+    /* Without a valid parameter record the calibration is the identity */
+    FLASH_EMU_init();
+    EXPECT(PARAM_init() == 1);
+    EXPECT(MAGTOM_cal_load() == 1);
+    MAGTOM_cal_get(&cal);
+    EXPECT(cal_equal(&cal, &identity));
+
+    /* Non finite or out of bounds calibrations are rejected */
+    cal                 = saved;
+    cal.soft_iron[1][2] = NAN;
+    EXPECT(MAGTOM_cal_set(&cal) == 1);
+    cal            = saved;
+    cal.offset_T.z = 5.0e-3f;
+    EXPECT(MAGTOM_cal_set(&cal) == 1);
+    MAGTOM_cal_get(&cal);
+    EXPECT(cal_equal(&cal, &identity));
+    EXPECT(PARAM_get_float(PARAM_mag_w12) == 0.0f);
+    EXPECT(PARAM_get_float(PARAM_mag_off_x) == 0.0f);
+    EXPECT(MAGTOM_cal_set(&saved) == 0);
+
+    /* Degenerate tumbles are rejected and leave the calibration alone */
+    MAGTOM_cal_start();
+    feed_tumble(TUMBLE_SAMPLES, M_PI / 6.0); /* 30 degree cone */
+    MAGTOM_CAL_RESULT_t result = MAGTOM_cal_solve();
+    EXPECT(result != MAGTOM_CAL_RESULT_ok);
+    printf("cone tumble : %d\n", (int)result);
+
+    MAGTOM_cal_start();
+    for (i = 0; i < TUMBLE_SAMPLES; i++)
+    {
+        /* Spin about the body z axis only */
+        const double angle = 2.0 * M_PI * i / TUMBLE_SAMPLES;
+        const double d[3]  = {cos(angle), sin(angle), 0.0};
+        vec3_t       raw   = distort(d);
+        MAGTOM_cal_add_sample(&raw);
+    }
+    result = MAGTOM_cal_solve();
+    EXPECT(result != MAGTOM_CAL_RESULT_ok);
+    printf("planar tumble : %d\n", (int)result);
+
+    MAGTOM_cal_start();
+    for (i = 0; i < TUMBLE_SAMPLES; i++)
+    {
+        /* Uncorrelated noise is not an ellipsoid */
+        vec3_t raw = {(float)(FIELD_T * gaussian()),
+                      (float)(FIELD_T * gaussian()),
+                      (float)(FIELD_T * gaussian())};
+        MAGTOM_cal_add_sample(&raw);
+    }
+    result = MAGTOM_cal_solve();
+    EXPECT(result != MAGTOM_CAL_RESULT_ok);
+    printf("noise : %d\n", (int)result);
+
+    MAGTOM_cal_abort();
+    MAGTOM_cal_get_status(&status);
+    EXPECT(!status.collecting && status.samples == 0);
+    MAGTOM_cal_get(&cal);
+    EXPECT(cal_equal(&cal, &saved));
+
+    /* Sampling path: the measurement is fed to the accumulator uncorrected
+     * and returned corrected */
+    MAGTOM_init();
+    MAGTOM_cal_get(&cal);
+    EXPECT(cal_equal(&cal, &saved));
+    vec3_t raw_field;
+    EXPECT(MAGTOM_cal_reset() == 0);
+    EXPECT(MAGTOM_capture_field_T(&raw_field) == 0);
+    cal          = identity;
+    cal.offset_T = raw_field;
+    EXPECT(MAGTOM_cal_set(&cal) == 0);
+    MAGTOM_cal_start();
+    EXPECT(MAGTOM_capture_field_T(&b) == 0);
+    EXPECT(b.x == 0.0f && b.y == 0.0f && b.z == 0.0f);
+    MAGTOM_cal_get_status(&status);
+    EXPECT(status.samples == 1);
+    JW_t jw;
+    JW_init(&jw, buf, sizeof(buf));
+    EXPECT(MAGTOM_measurement_to_json(&jw) == 0);
+    EXPECT(JW_finish(&jw) == 0);
+    printf("%s\n", buf);
+    EXPECT(strcmp(buf, "[0.000,0.000,0.000]") == 0);
+
+    JW_init(&jw, buf, sizeof(buf));
+    EXPECT(MAGTOM_cal_to_json(&jw) == 0);
+    EXPECT(JW_finish(&jw) == 0);
+    printf("%s\n", buf);
+    EXPECT(MAGTOM_cal_set(&saved) == 0);
+    JW_init(&jw, buf, sizeof(buf));
+    EXPECT(MAGTOM_cal_matrix_to_json(&jw) == 0);
+    EXPECT(JW_finish(&jw) == 0);
+    printf("%s\n", buf);
+    return 0;
+}
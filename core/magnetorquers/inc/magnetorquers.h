@@ -10,6 +10,8 @@ extern "C"
 
 #include <stdint.h>
 
+#include "json_writer.h"
+
 
 typedef enum
 {
@@ -53,7 +55,12 @@ int MQTR_get_current_ma(MQTR_t mqtr);
 
 
 
-int MQTR_config_to_str(char *buf, int buflen);
+/**
+ * @brief Write the coil voltage setpoints in mV as a json array
+ *
+ * @return int 0 on success, 1 if w is full
+ */
+int MQTR_config_to_json(JW_t *w);
 
 
 #ifdef __cplusplus
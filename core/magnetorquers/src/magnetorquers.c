@@ -11,30 +11,45 @@
 #include <stdlib.h>
 #include <limits.h>
 #include <string.h>
-#include <stdio.h>
-
-#if defined(TARGET_MCU)
-#include <msp430.h>
-#include "ads7841e.h"
-#include "timer_a.h"
-#include "pwm.h"
-#define MQTR_PWM_TIMER_COUNT_MODE MC__UP
-#endif /* #if defined(TARGET_MCU) */
-
-#define SMCLK_FREQ (1000000u)
 
 #include "magnetorquers.h"
 #include "targets.h"
+#include "parameters.h"
+#include "pwm.h"
+#include "hal.h"
+#include "hal_ads7841.h"
+
+/** @note PINOUT:
+ * P1.2 : X coil F (TA0.1)    P1.3 : X coil R (TA0.2)
+ * P2.0 : Y coil F (TA1.1)    P2.1 : Y coil R (TA1.2)
+ * P1.4 : Z coil F (TA0.3)    P1.5 : Z coil R (TA0.4)
+ * P5.1 : CS of the current sense ADS7841 (active low)
+ */
+#define MQTR_P1_PWM_PINS (HAL_PIN(2) | HAL_PIN(3) | HAL_PIN(4) | HAL_PIN(5))
+#define MQTR_P2_PWM_PINS (HAL_PIN(0) | HAL_PIN(1))
+
+/* The current sense conversion factor, the ADS7841 channel of each coil and
+ * the PWM frequency are parameters (mqtr_ma_mv, mqtr_ch_*, mqtr_pwm_hz) so
+ * they can be calibrated against the hardware without a firmware update */
+#define MQTR_CURRENT_SEN_CHANNEL_X ((uint8_t)PARAM_get_int(PARAM_mqtr_ch_x))
+#define MQTR_CURRENT_SEN_CHANNEL_Y ((uint8_t)PARAM_get_int(PARAM_mqtr_ch_y))
+#define MQTR_CURRENT_SEN_CHANNEL_Z ((uint8_t)PARAM_get_int(PARAM_mqtr_ch_z))
+
+/* Outputs driving a positive and a negative voltage across each coil */
+typedef struct
+{
+    HAL_TIMER_t tmr;
+    uint8_t     pos_ccr;
+    uint8_t     neg_ccr;
+} MQTR_pwm_t;
+
+static const MQTR_pwm_t MQTR_pwm[] = {
+    [MQTR_x] = {HAL_TIMER_A0, 2, 1},
+    [MQTR_y] = {HAL_TIMER_A1, 1, 2},
+    [MQTR_z] = {HAL_TIMER_A0, 3, 4},
+};
 
-/** @todo DON'T FORGET THIS */
-#warning TODO: THIS NEEDS TO BE UPDATED BASED ON THE HARDWARE CONVERSION FACTOR IN CURRENT SENSING CIRCUITRY
-#define MQTR_CURRENT_SENSE_MA_PER_MV (0.5f)
-
-/** @todo DON'T FORGET THIS */
-#warning TODO: THESE NEED TO BE UPDATED BASED ON THE HARDWARE MAPPINGS
-#define MQTR_CURRENT_SEN_CHANNEL_X ADS7841_CHANNEL_SGL_1
-#define MQTR_CURRENT_SEN_CHANNEL_Y ADS7841_CHANNEL_SGL_2
-#define MQTR_CURRENT_SEN_CHANNEL_Z ADS7841_CHANNEL_SGL_3
+static const HAL_GPIO_t MQTR_current_sense_cs = {HAL_PORT_5, HAL_PIN(1)};
 
 static int mqtr_voltage_mv[] = {
     [MQTR_x] = 0,
@@ -42,22 +57,18 @@ static int mqtr_voltage_mv[] = {
     [MQTR_z] = 0,
 };
 
-static uint16_t MQTR_PWM_API_timer_period_reg_val(uint16_t freq);
-static void     MQTR_PWM_API_init_phy(void);
-static void     MQTR_PWM_API_timer_init(uint16_t freq);
-static void     MQTR_PWM_API_set_x_duty_cycle(float ds_percent);
-static void     MQTR_PWM_API_set_y_duty_cycle(float ds_percent);
-static void     MQTR_PWM_API_set_z_duty_cycle(float ds_percent);
-static void     MQTR_PWM_API_init(void);
+static void MQTR_PWM_API_init_phy(void);
+static void MQTR_PWM_API_timer_init(uint16_t freq);
+static void MQTR_PWM_API_set_duty_cycle(MQTR_t mqtr, float pct_ds);
+static void MQTR_PWM_API_init(void);
 
 static void MQTR_PWM_API_set_coil_voltage_mv(MQTR_t mqtr, int16_t voltage_mv);
-static void MQTR_current_sense_ads7841_cs_init(void);
-static void MQTR_current_sense_ads7841_cs_deinit(void);
 static int  MQTR_current_sense_adc_mv_to_ma(int mv);
 
 
 void MQTR_init(void)
 {
+    HAL_ADS7841_init_cs(&MQTR_current_sense_cs);
     MQTR_PWM_API_init();
     MQTR_PWM_API_set_coil_voltage_mv(MQTR_x, 0);
     MQTR_PWM_API_set_coil_voltage_mv(MQTR_y, 0);
@@ -108,13 +119,15 @@ int MQTR_get_coil_voltage_mv(MQTR_t mqtr)
 }
 
 
-int MQTR_config_to_str(char *buf, int buflen)
+int MQTR_config_to_json(JW_t *w)
 {
-    CONFIG_ASSERT(NULL != buf);
-    int required_len =
-        snprintf(buf, buflen, "[ %d, %d, %d ]", mqtr_voltage_mv[MQTR_x],
-                 mqtr_voltage_mv[MQTR_y], mqtr_voltage_mv[MQTR_z]);
-    return (required_len < buflen) ? 0 : 1;
+    CONFIG_ASSERT(NULL != w);
+    JW_array_begin(w);
+    JW_int(w, mqtr_voltage_mv[MQTR_x]);
+    JW_int(w, mqtr_voltage_mv[MQTR_y]);
+    JW_int(w, mqtr_voltage_mv[MQTR_z]);
+    JW_array_end(w);
+    return JW_error(w);
 }
 
 
@@ -123,25 +136,24 @@ int MQTR_get_current_ma(MQTR_t mqtr)
     int      current_ma = 0;
     uint16_t adc_val    = 0;
 
-#if defined(TARGET_MCU)
-    ADS7841_driver_init(MQTR_current_sense_ads7841_cs_init,
-                        MQTR_current_sense_ads7841_cs_deinit,
-                        ADS7841_PWRMODE_stayOn, ADS7841_BITRES_12);
     switch (mqtr)
     {
         case MQTR_x:
         {
-            adc_val = ADS7841_measure_channel(MQTR_CURRENT_SEN_CHANNEL_X);
+            adc_val = HAL_ADS7841_measure_channel(&MQTR_current_sense_cs,
+                                                  MQTR_CURRENT_SEN_CHANNEL_X);
         }
         break;
         case MQTR_y:
         {
-            adc_val = ADS7841_measure_channel(MQTR_CURRENT_SEN_CHANNEL_Y);
+            adc_val = HAL_ADS7841_measure_channel(&MQTR_current_sense_cs,
+                                                  MQTR_CURRENT_SEN_CHANNEL_Y);
         }
         break;
         case MQTR_z:
         {
-            adc_val = ADS7841_measure_channel(MQTR_CURRENT_SEN_CHANNEL_Z);
+            adc_val = HAL_ADS7841_measure_channel(&MQTR_current_sense_cs,
+                                                  MQTR_CURRENT_SEN_CHANNEL_Z);
         }
         break;
         default:
@@ -149,17 +161,10 @@ int MQTR_get_current_ma(MQTR_t mqtr)
         }
         break;
     }
-    current_ma = MQTR_current_sense_adc_mv_to_ma(adc_val);
-    ADS7841_driver_deinit();
-
-
-#else
-
-    printf("Called %s with arg %d. Returning %d\n", __func__, mqtr, current_ma);
-
-#endif /* #if defined(TARGET_MCU) */
-
-
+    if (adc_val != HAL_ADS7841_CONV_FAILED)
+    {
+        current_ma = MQTR_current_sense_adc_mv_to_ma(adc_val);
+    }
     return current_ma;
 }
 
@@ -168,8 +173,8 @@ int MQTR_get_current_ma(MQTR_t mqtr)
 /******************************************************************************
  *
  *
- *       START OF THE TARGET-SPECIFIC REGISTER LEVEL STUFF. IF THIS
- *       SECTION GETS TOO BIG IT SHOULD BE MOVED INTO THE DRIVER LAYER
+ *       START OF THE PWM AND CURRENT SENSE HARDWARE, DRIVEN THROUGH
+ *       THE HAL SO THE SAME CODE RUNS ON THE TARGET AND NATIVELY
  *
  *
  ******************************************************************************/
@@ -179,14 +184,12 @@ int MQTR_get_current_ma(MQTR_t mqtr)
 static void MQTR_PWM_API_init(void)
 {
     MQTR_PWM_API_init_phy();
-    MQTR_PWM_API_timer_init(1000);
+    MQTR_PWM_API_timer_init((uint16_t)PARAM_get_int(PARAM_mqtr_pwm_hz));
 }
 
 
 static void MQTR_PWM_API_set_coil_voltage_mv(MQTR_t mqtr, int16_t voltage_mv)
 {
-#if defined(TARGET_MCU)
-
     if (voltage_mv < -PWM_VMAX_MV_float)
     {
         voltage_mv = -PWM_VMAX_MV_float;
@@ -198,378 +201,61 @@ static void MQTR_PWM_API_set_coil_voltage_mv(MQTR_t mqtr, int16_t voltage_mv)
 
     float duty_cycle;
     duty_cycle = (voltage_mv * PWM_MAX_DUTY_CYCLE_float) / PWM_VMAX_MV_float;
-    switch (mqtr)
-    {
-        case MQTR_x:
-        {
-            MQTR_PWM_API_set_x_duty_cycle(duty_cycle);
-        }
-        break;
-        case MQTR_y:
-        {
-            MQTR_PWM_API_set_y_duty_cycle(duty_cycle);
-        }
-        break;
-        case MQTR_z:
-        {
-            MQTR_PWM_API_set_z_duty_cycle(duty_cycle);
-        }
-        break;
-        default:
-        {
-            CONFIG_ASSERT(0);
-        }
-        break;
-    }
-
-#else
-
-    printf("Called %s with arg %d\n", __func__, voltage_mv);
-
-#endif /* #if defined(TARGET_MCU) */
+    MQTR_PWM_API_set_duty_cycle(mqtr, duty_cycle);
 }
 
 
 static void MQTR_PWM_API_init_phy(void)
 {
-#if defined(TARGET_MCU)
-
-    /* Configure X coil F pwm pin */
-    P1DIR |= BIT2; /* P1.2 in output direction */
-    P1SEL |= BIT2; /* P1.2 will be used for its peripheral function */
-
-    /* Configure X coil R pwm pin */
-    P1DIR |= BIT3; /* P1.3 in output direction */
-    P1SEL |= BIT3; /* P1.3 will be used for its peripheral function */
-
-    /* Configure Y coil R pwm pin */
-    P2DIR |= BIT0; /* P2.0 in output direction */
-    P2SEL |= BIT0; /* P2.0 will be used for its peripheral function */
-
-    /* Configure Y coil R pwm pin */
-    P2DIR |= BIT1; /* P2.1 in output direction */
-    P2SEL |= BIT1; /* P2.1 will be used for its peripheral function */
-
-    /* Configure Z coil F pwm pin */
-    P1DIR |= BIT4; /* P1.4 in output direction */
-    P1SEL |= BIT4; /* P1.4 will be used for its peripheral function */
-
-    /* Configure Z coil R pwm pin */
-    P1DIR |= BIT5; /* P1.5 in output direction */
-    P1SEL |= BIT5; /* P1.5 will be used for its peripheral function */
-
-#else
-
-    printf("Called %s\n", __func__);
-
-#endif /* #if defined(TARGET_MCU) */
+    HAL->gpio->output(HAL_PORT_1, MQTR_P1_PWM_PINS);
+    HAL->gpio->peripheral(HAL_PORT_1, MQTR_P1_PWM_PINS);
+    HAL->gpio->output(HAL_PORT_2, MQTR_P2_PWM_PINS);
+    HAL->gpio->peripheral(HAL_PORT_2, MQTR_P2_PWM_PINS);
 }
 
 
 static void MQTR_PWM_API_timer_init(uint16_t pwm_freq)
 {
-#if defined(TARGET_MCU)
-
-    TA0CTL &= ~(MC0 | MC1); /* Stop timer A0 */
-
-    /* Set Timer A0 clock source to smclk */
-    TA0CTL &= ~(TASSEL0 | TASSEL1);
-    TA0CTL |= TASSEL__SMCLK;
-
-    TA0CCR0 = MQTR_PWM_API_timer_period_reg_val(pwm_freq);
-
-/* Config for mqtr X face F pin (pin 1.2) */
-#warning THIS SEEMS NOT WORK ON THIS SPECIFIC PIN
-    TA0CCR1 = 0;
-    TA0CCTL1 &= ~(OUTMOD0 | OUTMOD1 | OUTMOD2);
-    TA0CCTL1 |= OUTMOD_TOG_SET;
-    TA0CCTL1 &= ~(CAP);
-
-    /* Config for mqtr X face R pin (pin 1.3) */
-    TA0CCR2 = 0;
-    TA0CCTL2 &= ~(OUTMOD0 | OUTMOD1 | OUTMOD2);
-    TA0CCTL2 |= OUTMOD_TOG_SET;
-    TA0CCTL2 &= ~(CAP);
-
-    /* Config for mqtr Z face F pin (pin 1.4) */
-    TA0CCR3 = 0;
-    TA0CCTL3 &= ~(OUTMOD0 | OUTMOD1 | OUTMOD2);
-    TA0CCTL3 |= OUTMOD_TOG_SET;
-    TA0CCTL3 &= ~(CAP);
-
-    /* Config for mqtr Z face R pin (pin 1.5) */
-    TA0CCR4 = 0;
-    TA0CCTL4 &= ~(OUTMOD0 | OUTMOD1 | OUTMOD2);
-    TA0CCTL4 |= OUTMOD_TOG_SET;
-    TA0CCTL4 &= ~(CAP);
-
-    /* Set timer A0 count mode */
-    TA0CTL &= ~(MC0 | MC1);
-    TA0CTL |= MQTR_PWM_TIMER_COUNT_MODE;
-
-    /* Stop timer A1 */
-    TA1CTL &= ~(MC0 | MC1);
-
-    TA1CCR0 = MQTR_PWM_API_timer_period_reg_val(pwm_freq);
+    const uint16_t period = HAL_TIMER_period_for_hz(pwm_freq);
 
-    /* Set Timer A1 clock source to smclk */
-    TA1CTL &= ~(TASSEL0 | TASSEL1);
-    TA1CTL |= TASSEL__SMCLK;
+    /* X and Z coils on timer A0, Y coil on timer A1 */
+    HAL->timer->start(HAL_TIMER_A0, HAL_TIMER_MODE_stop, period);
+    HAL->timer->start(HAL_TIMER_A1, HAL_TIMER_MODE_stop, period);
 
-    /* Config for mqtr Y face F pin (pin 2.0) */
-    TA1CCR1 = 0;
-    TA1CCTL1 &= ~(OUTMOD0 | OUTMOD1 | OUTMOD2);
-    TA1CCTL1 |= OUTMOD_TOG_SET;
-
-    /* Config for mqtr Y face R pin (pin 2.1)*/
-    TA1CCR2 = 0;
-    TA1CCTL2 &= ~(OUTMOD0 | OUTMOD1 | OUTMOD2);
-    TA1CCTL2 |= OUTMOD_TOG_SET;
-
-    /* Set Timer A1 count mode */
-    TA1CTL &= ~(MC0 | MC1);
-    TA1CTL |= MQTR_PWM_TIMER_COUNT_MODE;
-
-#else
-
-    printf("Called %s\n", __func__);
-
-#endif /* #if defined(TARGET_MCU) */
-}
-
-
-static void MQTR_PWM_API_set_x_duty_cycle(float pct_ds)
-{
-#if defined(TARGET_MCU)
-
-    uint16_t max_count;
-    switch (TA0CTL & (MC0 | MC1))
+    /** @todo THE X COIL F OUTPUT (P1.2) SEEMED NOT TO WORK ON THE BENCH */
+    MQTR_t mqtr;
+    for (mqtr = MQTR_x; mqtr <= MQTR_z; mqtr++)
     {
-        case MC__CONTINOUS:
-        {
-            max_count = UINT16_MAX;
-        }
-        break;
-        case MC__UP:
-        {
-            max_count = TA0CCR0;
-        }
-        break;
-        case MC__UPDOWN:
-        {
-            max_count = 2 * TA0CCR0;
-        }
-        break;
-        case MC__STOP:
-        {
-            max_count = 0;
-        }
-        break;
-        default:
-        {
-            CONFIG_ASSERT(0);
-        }
-        break;
+        HAL->timer->pwm_channel(MQTR_pwm[mqtr].tmr, MQTR_pwm[mqtr].pos_ccr);
+        HAL->timer->pwm_channel(MQTR_pwm[mqtr].tmr, MQTR_pwm[mqtr].neg_ccr);
     }
 
-    if (pct_ds == PWM_MIN_DUTY_CYCLE_float)
-    {
-        TA0CCR1 = (uint16_t)PWM_MIN_DUTY_CYCLE_float;
-        TA0CCR2 = (uint16_t)PWM_MIN_DUTY_CYCLE_float;
-    }
-    else if (pct_ds < 0)
-    {
-        if (pct_ds < -1 * PWM_MAX_DUTY_CYCLE_float)
-        {
-            pct_ds = -1 * PWM_MAX_DUTY_CYCLE_float;
-        }
-        TA0CCR2 = (uint16_t)PWM_MIN_DUTY_CYCLE_float;
-        TA0CCR1 =
-            (uint16_t)((pct_ds / (-1 * PWM_MAX_DUTY_CYCLE_float)) * max_count);
-    }
-    else
-    {
-        if (pct_ds > PWM_MAX_DUTY_CYCLE_float)
-        {
-            pct_ds = PWM_MAX_DUTY_CYCLE_float;
-        }
-
-        TA0CCR1 = (uint16_t)PWM_MIN_DUTY_CYCLE_float;
-        TA0CCR2 = (uint16_t)((pct_ds / (PWM_MAX_DUTY_CYCLE_float)) * max_count);
-    }
-
-#else
-
-    printf("called %s with argument %f\n", __func__, pct_ds);
-
-#endif /* #if defined(TARGET_MCU) */
-}
-
-
-static void MQTR_PWM_API_set_y_duty_cycle(float pct_ds)
-{
-#if defined(TARGET_MCU)
-
-    uint16_t max_count;
-    switch (TA1CTL & (MC0 | MC1))
-    {
-        case MC__CONTINOUS:
-        {
-            max_count = UINT16_MAX;
-        }
-        break;
-        case MC__UP:
-        {
-            max_count = TA0CCR0;
-        }
-        break;
-        case MC__UPDOWN:
-        {
-            max_count = 2 * TA0CCR0;
-        }
-        break;
-        case MC__STOP:
-        {
-            max_count = 0;
-        }
-        break;
-        default:
-        {
-            CONFIG_ASSERT(0);
-        }
-        break;
-    }
-
-    if (pct_ds == PWM_MIN_DUTY_CYCLE_float)
-    {
-        TA1CCR1 = (uint16_t)PWM_MIN_DUTY_CYCLE_float;
-        TA1CCR2 = (uint16_t)PWM_MIN_DUTY_CYCLE_float;
-    }
-    if (pct_ds < 0.0f)
-    {
-        if (pct_ds < -1 * PWM_MAX_DUTY_CYCLE_float)
-        {
-            pct_ds = -1 * PWM_MAX_DUTY_CYCLE_float;
-        }
-        TA1CCR1 = (uint16_t)PWM_MIN_DUTY_CYCLE_float;
-        TA1CCR2 =
-            (uint16_t)((pct_ds / (-1 * PWM_MAX_DUTY_CYCLE_float)) * max_count);
-    }
-    else
-    {
-        if (pct_ds > PWM_MAX_DUTY_CYCLE_float)
-        {
-            pct_ds = PWM_MAX_DUTY_CYCLE_float;
-        }
-        TA1CCR2 = (uint16_t)PWM_MIN_DUTY_CYCLE_float;
-        TA1CCR1 = (uint16_t)((pct_ds / PWM_MAX_DUTY_CYCLE_float) * max_count);
-    }
-
-#else
-
-    printf("called %s with argument %f\n", __func__, pct_ds);
-
-#endif /* #if defined(TARGET_MCU) */
+    HAL->timer->start(HAL_TIMER_A0, HAL_TIMER_MODE_up, period);
+    HAL->timer->start(HAL_TIMER_A1, HAL_TIMER_MODE_up, period);
 }
 
 
-static void MQTR_PWM_API_set_z_duty_cycle(float pct_ds)
+static void MQTR_PWM_API_set_duty_cycle(MQTR_t mqtr, float pct_ds)
 {
-#if defined(TARGET_MCU)
-    uint16_t max_count;
-    switch (TA0CTL & (MC0 | MC1))
-    {
-        case MC__CONTINOUS:
-        {
-            max_count = UINT16_MAX;
-        }
-        break;
-        case MC__UP:
-        {
-            max_count = TA0CCR0;
-        }
-        break;
-        case MC__UPDOWN:
-        {
-            max_count = 2 * TA0CCR0;
-        }
-        break;
-        case MC__STOP:
-        {
-            max_count = 0;
-        }
-        break;
-        default:
-        {
-            CONFIG_ASSERT(0);
-        }
-        break;
-    }
+    CONFIG_ASSERT(mqtr <= MQTR_z);
+    const MQTR_pwm_t *pwm = &MQTR_pwm[mqtr];
 
-    if (pct_ds == PWM_MIN_DUTY_CYCLE_float)
-    {
-        TA0CCR3 = (uint16_t)PWM_MIN_DUTY_CYCLE_float;
-        TA0CCR4 = (uint16_t)PWM_MIN_DUTY_CYCLE_float;
-    }
+    /* The sign picks the direction of the current through the coil, the
+     * other side of the bridge is held low */
     if (pct_ds < 0.0f)
     {
-        if (pct_ds < -1 * PWM_MAX_DUTY_CYCLE_float)
-        {
-            pct_ds = -1 * PWM_MAX_DUTY_CYCLE_float;
-        }
-        TA0CCR3 = (uint16_t)PWM_MIN_DUTY_CYCLE_float;
-        TA0CCR4 =
-            (uint16_t)((pct_ds / (-1 * PWM_MAX_DUTY_CYCLE_float)) * max_count);
+        HAL_TIMER_set_duty(pwm->tmr, pwm->pos_ccr, 0.0f);
+        HAL_TIMER_set_duty(pwm->tmr, pwm->neg_ccr, -pct_ds);
     }
     else
     {
-        if (pct_ds > PWM_MAX_DUTY_CYCLE_float)
-        {
-            pct_ds = PWM_MAX_DUTY_CYCLE_float;
-        }
-
-        TA0CCR4 = (uint16_t)PWM_MIN_DUTY_CYCLE_float;
-        TA0CCR3 = (uint16_t)((pct_ds / PWM_MAX_DUTY_CYCLE_float) * max_count);
+        HAL_TIMER_set_duty(pwm->tmr, pwm->neg_ccr, 0.0f);
+        HAL_TIMER_set_duty(pwm->tmr, pwm->pos_ccr, pct_ds);
     }
-
-#else
-
-    printf("called %s with argument %f\n", __func__, pct_ds);
-#endif /* #if defined(TARGET_MCU) */
-}
-
-
-static uint16_t MQTR_PWM_API_timer_period_reg_val(uint16_t freq)
-{
-    uint16_t period_reg_val = 0;
-    period_reg_val          = SMCLK_FREQ / freq;
-    return period_reg_val;
-}
-
-
-static void MQTR_current_sense_ads7841_cs_init(void)
-{
-#if defined(TARGET_MCU)
-
-    P5DIR |= BIT1;
-    P5OUT &= ~BIT1; /* ADS7841 is active low */
-
-#endif /* #if defined(TARGET_MCU) */
-}
-
-
-static void MQTR_current_sense_ads7841_cs_deinit(void)
-{
-#if defined(TARGET_MCU)
-
-    P5DIR |= BIT1;
-    P5OUT |= BIT1; /* ADS7841 is active low */
-
-#endif /* #if defined(TARGET_MCU) */
 }
 
 
 static int MQTR_current_sense_adc_mv_to_ma(int mv)
 {
-    return mv * MQTR_CURRENT_SENSE_MA_PER_MV;
+    return mv * PARAM_get_float(PARAM_mqtr_ma_mv);
 }
@@ -10,19 +10,28 @@
 #include "magnetometer.h"
 #include "reaction_wheels.h"
 #include "imu.h"
+#include "systick.h"
+#include "timebase.h"
+#include "adcs_modes.h"
+#include "isr_monitor.h"
 #else
 #include <errno.h>
+
+/* Longest sleep of the native main loop between frames */
+#define NATIVE_IDLE_WAIT_MS (100u)
 #endif /* #if defined(TARGET_MCU) */
 
 #include "obc_interface.h"
 #include "jsons.h"
+#include "parameters.h"
+#include "telemetry.h"
+#include "tlm_stream.h"
+#include "profiling.h"
 
 
 static void pulldown_unused_floating_pins(void);
 
 
-static uint8_t msg[128];
-
 int main(void)
 {
 
@@ -34,55 +43,45 @@ int main(void)
 #endif /* #if defined(DEBUG) */
 
     OBC_IF_config(OBC_IF_PHY_CFG_UART);
+    SYSTICK_init(); /* I2C transaction timeouts during IMU_init need it */
+    TIMEBASE_init(); /* sensor init delays */
+    PROF_init();     /* once SYSTICK runs */
+    PARAM_init();    /* calibration and channel maps used by the inits */
+    TLM_init();
+    TLM_stream_init();
     IMU_init();
     MAGTOM_init();
     RW_init();
     MQTR_init();
+    MODE_init();
     pulldown_unused_floating_pins();
+    ISR_MON_init();
     enable_interrupts();
 
 #else
     OBC_IF_config(OBC_IF_PHY_CFG_EMULATED);
+    PROF_init();
+    PARAM_init();
+    TLM_init();
+    TLM_stream_init();
 #endif /* #if defined(TARGET_MCU) */
 
 
     for (;;)
     {
-        if (OBC_IF_dataRxFlag_read() == OBC_IF_DATA_RX_FLAG_SET)
+        /* One received command and one telemetry frame per iteration */
+        json_service();
+
+#if defined(TARGET_MCU)
+        MODE_run(SYSTICK_get_us());
+#else
+        /* Nothing samples telemetry natively, so there is no work until the
+         * OBC sends a frame unless a download is still going out */
+        if (!TLM_download_active())
         {
-            /* get command json string from OBC interface */
-            OCB_IF_get_command_string(msg, sizeof(msg));
-
-            /* Parse command json string */
-            JSON_PARSE_t status = json_parse(msg);
-            switch (status)
-            {
-                case JSON_PARSE_format_err:
-                {
-                    OBC_IF_printf(
-                        "{\"error\" : \"json format\",    \"received\":\"%s\"}",
-                        msg);
-                }
-                break;
-                case JSON_PARSE_unsupported:
-                {
-                    OBC_IF_printf("{\"error\" : \"json unsupported\",    "
-                                  "\"received\":\"%s\"}",
-                                  msg);
-                }
-                break;
-                case JSON_PARSE_ok:
-                {
-                    /* Do nothing */
-                }
-                break;
-                default:
-                {
-                }
-                break;
-            }
-            OBC_IF_dataRxFlag_write(OBC_IF_DATA_RX_FLAG_CLR);
+            OBC_IF_rx_wait(NATIVE_IDLE_WAIT_MS);
         }
+#endif /* #if defined(TARGET_MCU) */
 
 #if defined(TARGET_MCU) && !defined(DEBUG)
         watchdog_kick();
@@ -97,3 +96,4 @@ static void pulldown_unused_floating_pins(void)
     /** @todo ON FINAL BOARD MAKE SURE ALL FLOATING PINS ARE PULLED DOWN
      * INTERNALLY TO PREVENT CHARGE BUILDUP IN ORBIT */
 }
+
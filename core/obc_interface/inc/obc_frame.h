@@ -0,0 +1,105 @@
+/**
+ * @file obc_frame.h
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief COBS framing with a CRC for the OBC link
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ * @note On the wire a frame is the COBS encoding of the payload followed by
+ * its CRC-16/CCITT-FALSE (most significant byte first), then a 0x00
+ * delimiter. COBS leaves no 0x00 inside the frame, so the payload may hold
+ * any byte and the receiver finds the next frame after any error by waiting
+ * for the next delimiter.
+ */
+#ifndef __OBC_FRAME_H__
+#define __OBC_FRAME_H__
+#ifdef __cplusplus
+/* clang-format off */
+extern "C"
+{
+/* clang-format on */
+#endif /* Start C linkage */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define OBC_FRAME_DELIM (0x00u)
+#define OBC_FRAME_CRC_SIZE (2u)
+
+/* COBS code bytes a payload of up to n bytes needs at most, one every 254
+ * bytes of payload and CRC */
+#define OBC_FRAME_HEAD(n) (((n) + OBC_FRAME_CRC_SIZE) / 254u + 1u)
+
+/* Bytes on the wire for a payload of up to n bytes: code bytes, payload, CRC
+ * and delimiter */
+#define OBC_FRAME_WIRE_LEN(n)                                                  \
+    (OBC_FRAME_HEAD(n) + (n) + OBC_FRAME_CRC_SIZE + 1u)
+
+typedef enum
+{
+    OBC_FRAME_RX_busy,     /* inside a frame, or between frames */
+    OBC_FRAME_RX_done,     /* a frame with a good CRC, len holds its size */
+    OBC_FRAME_RX_bad,      /* CRC mismatch or cut short */
+    OBC_FRAME_RX_too_long, /* more payload than the buffer holds */
+} OBC_FRAME_RX_t;
+
+typedef struct
+{
+    uint8_t *buf;
+    uint16_t cap;    /* payload and CRC bytes buf holds */
+    uint16_t len;    /* bytes decoded so far */
+    uint8_t  left;   /* bytes to the next code byte, 0 at a code byte */
+    bool     zero;   /* the block before the next code byte ends in 0x00 */
+    bool     active; /* a byte other than a delimiter came since the last */
+    bool     overrun;
+} OBC_FRAME_rx_t;
+
+
+/**
+ * @brief Start decoding a frame into buf
+ *
+ * @param cap size of buf. It holds the CRC as well so a payload of up to
+ * cap - OBC_FRAME_CRC_SIZE bytes is received. A NULL buf with cap 0
+ * discards the frame.
+ */
+void OBC_FRAME_rx_init(OBC_FRAME_rx_t *rx, uint8_t *buf, uint16_t cap);
+
+
+/**
+ * @brief Decode one received byte. Cheap enough for the receive interrupt.
+ *
+ * @return OBC_FRAME_RX_busy until a delimiter ends a frame, then the result
+ * for that frame. The decoder is ready for the next frame in the same
+ * buffer after that, or rx_init can move it to another one.
+ */
+OBC_FRAME_RX_t OBC_FRAME_rx_byte(OBC_FRAME_rx_t *rx, uint8_t byte);
+
+
+/**
+ * @brief Encode a payload into a frame in place
+ *
+ * @param frame buffer of OBC_FRAME_WIRE_LEN(n) bytes for payloads of up to n
+ * bytes
+ * @param head where the payload starts in frame, at least OBC_FRAME_HEAD(len)
+ * @param len payload length
+ * @return uint16_t bytes of the frame, from the start of frame
+ *
+ * @note The frame is sent with a single write so a driver that drops a
+ * transmission while it is busy never splits it.
+ */
+uint16_t OBC_FRAME_encode(uint8_t *frame, uint16_t head, uint16_t len);
+
+
+/**
+ * @brief CRC-16/CCITT-FALSE of len bytes
+ */
+uint16_t OBC_FRAME_crc(const uint8_t *data, uint16_t len);
+
+#ifdef __cplusplus
+/* clang-format off */
+}
+/* clang-format on */
+#endif /* End C linkage */
+#endif /* __OBC_FRAME_H__ */
@@ -18,22 +18,36 @@ typedef enum
 #include <limits.h>
 #include <stdbool.h>
 
+#include "json_writer.h"
+
 #if !defined(TARGET_MCU)
 #include <pthread.h>
 #endif /* #if !defined(TARGET_MCU) */
 
 
-#ifndef OBC_MSG_DELIM
-
-#define OBC_MSG_DELIM ((char)'!') /* for now we can just use ! */
-
-#endif /* ifndef OBC_MSG_DELIM */
+/* Bytes of one reply payload, before framing */
+#ifndef OBC_TX_BUFFER_SIZE
+#define OBC_TX_BUFFER_SIZE 500
+#endif /* ifndef OBC_TX_BUFFER_SIZE */
 
+/* Received frames waiting for OCB_IF_get_command_string. A power of two so
+ * the free running queue indexes wrap with it */
+#ifndef OBC_RX_FRAME_CNT
+#define OBC_RX_FRAME_CNT 4
+#endif /* ifndef OBC_RX_FRAME_CNT */
 
-#define OBC_IF_DATA_RX_FLAG_SET true
-#define OBC_IF_DATA_RX_FLAG_CLR false
+/* Payload bytes of the longest frame received */
+#ifndef OBC_RX_FRAME_LEN
+#define OBC_RX_FRAME_LEN 255
+#endif /* ifndef OBC_RX_FRAME_LEN */
 
-#define OBC_TX_BUFFER_SIZE 500
+typedef struct
+{
+    uint32_t frames;   /* queued for the main loop */
+    uint32_t bad;      /* CRC mismatch or cut short */
+    uint32_t too_long; /* more than OBC_RX_FRAME_LEN bytes of payload */
+    uint32_t dropped;  /* arrived while the queue was full */
+} OBC_IF_rx_stats_t;
 
 /**
  * @brief Configure the OBC Communication interface
@@ -49,10 +63,10 @@ int OBC_IF_config(OBC_IF_PHY_CFG_t config_mode);
 void OBC_IF_clear_config(void);
 
 /**
- * @brief Transmit bytes to OBC
+ * @brief Transmit bytes to OBC as one frame
  * @param buf buffer to transmit
- * @param buflen max lenght of buffer to transmit
- * @return int number of bytes transmitted successfully
+ * @param buflen max lenght of buffer to transmit, up to OBC_TX_BUFFER_SIZE
+ * @return int what the driver transmit function returned
  */
 int OBC_IF_tx(uint8_t *buf, uint_least16_t buflen);
 
@@ -66,42 +80,82 @@ int OBC_IF_tx(uint8_t *buf, uint_least16_t buflen);
  * @param byte byte to receive
  */
 void OBC_IF_receive_byte(uint8_t byte);
+
+
+/**
+ * @brief Configure the interface without a phy, the frames to send go to
+ * tx. For the simulator, which feeds frames with OBC_IF_receive_byte
+ *
+ * @return int 0 on success
+ */
+int OBC_IF_config_native(int (*tx)(uint8_t *buf, uint16_t buflen));
+
+
+/**
+ * @brief Block until a received frame is waiting, so the native main loop
+ * sleeps while idle instead of polling
+ *
+ * @param timeout_ms longest wait
+ * @return int 0 if a frame is waiting, 1 if the wait timed out
+ */
+int OBC_IF_rx_wait(uint32_t timeout_ms);
 #endif /* #if defined(TARGET_MCU) */
 
 /**
- * @brief
+ * @brief Number of received frames waiting to be taken
  *
- * @param buf
- * @param buflen
- * @return int
+ * @return uint8_t frames in the receive queue
+ */
+uint8_t OBC_IF_rx_frame_cnt(void);
+
+
+/**
+ * @brief Take the oldest received frame out of the receive queue
+ *
+ * @param buf receives the frame payload followed by a '\0'
+ * @param buflen size of buf
+ * @return int 0 on success, 1 if no frame was waiting or it did not fit in
+ * buf. A frame that did not fit is dropped.
  */
 int OCB_IF_get_command_string(uint8_t *buf, uint_least16_t buflen);
 
 
 /**
- * @brief thread-safe read for OBC_IF data received flag
+ * @brief Counters of the frames received since OBC_IF_config
+ *
+ * @param stats the counters
+ */
+void OBC_IF_get_rx_stats(OBC_IF_rx_stats_t *stats);
+
+
+/**
+ * @brief Start a reply in the transmit buffer. The reply is written in place
+ * with the JW_ functions and transmitted with OBC_IF_reply_send.
  *
- * @return true if flag is true
- * @return false if flag is false
+ * @return JW_t* writer over the transmit buffer
  */
-bool OBC_IF_dataRxFlag_read(void);
+JW_t *OBC_IF_reply_begin(void);
+
 
 /**
- * @brief thread-safe write to OBC data received flag
+ * @brief Transmit the reply started with OBC_IF_reply_begin
+ *
+ * @param w the writer OBC_IF_reply_begin returned
+ * @return int number of bytes transmitted
  *
- * @param data_state the state to set the data received flag
+ * @note A reply that did not fit in the transmit buffer or is not complete
+ * json is replaced by {"error":"reply"} rather than sent truncated.
  */
-void OBC_IF_dataRxFlag_write(bool data_state);
+int OBC_IF_reply_send(JW_t *w);
 
 
 /**
- * @brief Printf wrapper for OBC_IF_tx to make life easier
+ * @brief Transmit {"error":"<what>"}
  *
- * @param fmt printf style format string
- * @param ... __VA_ARGS__
+ * @param what short description of the error
  * @return int number of bytes transmitted
  */
-int OBC_IF_printf(const char *restrict fmt, ...);
+int OBC_IF_reply_error(const char *what);
 
 
 #ifdef __cplusplus
@@ -0,0 +1,169 @@
+/**
+ * @file obc_frame.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief COBS framing with a CRC for the OBC link
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ * @note COBS splits the frame into blocks of up to 254 bytes without 0x00.
+ * Each block is preceded by a code byte, one more than its length. A code
+ * below 0xFF means the block was followed by a 0x00 in the payload, except
+ * for the last one. The CRC is encoded with the payload so a 0x00 in the CRC
+ * is handled like any other.
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "targets.h"
+#include "config_assert.h"
+#include "obc_frame.h"
+
+/* Longest block of a COBS frame */
+#define OBC_FRAME_BLOCK_MAX (254u)
+
+static void OBC_FRAME_put(OBC_FRAME_rx_t *rx, uint8_t byte);
+
+
+void OBC_FRAME_rx_init(OBC_FRAME_rx_t *rx, uint8_t *buf, uint16_t cap)
+{
+    CONFIG_ASSERT(NULL != rx);
+    CONFIG_ASSERT(NULL != buf || cap == 0);
+    rx->buf     = buf;
+    rx->cap     = cap;
+    rx->len     = 0;
+    rx->left    = 0;
+    rx->zero    = false;
+    rx->active  = false;
+    rx->overrun = false;
+}
+
+
+OBC_FRAME_RX_t OBC_FRAME_rx_byte(OBC_FRAME_rx_t *rx, uint8_t byte)
+{
+    if (byte != OBC_FRAME_DELIM)
+    {
+        if (!rx->active)
+        {
+            rx->active  = true;
+            rx->len     = 0;
+            rx->left    = 0;
+            rx->zero    = false;
+            rx->overrun = false;
+        }
+
+        if (rx->left == 0)
+        {
+            /* Code byte. The 0x00 ending the block before it is only part
+             * of the payload when another block follows */
+            if (rx->zero)
+            {
+                OBC_FRAME_put(rx, 0x00u);
+            }
+            rx->left = byte - 1u;
+            rx->zero = (byte != OBC_FRAME_BLOCK_MAX + 1u);
+        }
+        else
+        {
+            OBC_FRAME_put(rx, byte);
+            rx->left--;
+        }
+        return OBC_FRAME_RX_busy;
+    }
+
+    if (!rx->active)
+    {
+        return OBC_FRAME_RX_busy; /* back to back delimiters */
+    }
+    rx->active = false;
+
+    if (rx->overrun)
+    {
+        return OBC_FRAME_RX_too_long;
+    }
+    if (rx->left != 0 || rx->len < OBC_FRAME_CRC_SIZE)
+    {
+        return OBC_FRAME_RX_bad;
+    }
+
+    rx->len -= OBC_FRAME_CRC_SIZE;
+    const uint16_t crc = (uint16_t)((rx->buf[rx->len] << 8) |
+                                    rx->buf[rx->len + 1u]);
+    if (crc != OBC_FRAME_crc(rx->buf, rx->len))
+    {
+        return OBC_FRAME_RX_bad;
+    }
+    return OBC_FRAME_RX_done;
+}
+
+
+uint16_t OBC_FRAME_encode(uint8_t *frame, uint16_t head, uint16_t len)
+{
+    CONFIG_ASSERT(NULL != frame);
+    CONFIG_ASSERT(head >= OBC_FRAME_HEAD(len));
+
+    /* Every code byte written so far is one of the head bytes, so the write
+     * never passes the byte read next */
+    uint8_t       *in  = &frame[head];
+    const uint16_t crc = OBC_FRAME_crc(in, len);
+    in[len]            = (uint8_t)(crc >> 8);
+    in[len + 1u]       = (uint8_t)(crc & 0xFFu);
+
+    const uint16_t n        = len + OBC_FRAME_CRC_SIZE;
+    uint16_t       out      = 1;
+    uint16_t       code_pos = 0;
+    uint8_t        code     = 1;
+    uint16_t       i;
+    for (i = 0; i < n; i++)
+    {
+        const uint8_t byte = in[i];
+        if (byte != 0x00u)
+        {
+            frame[out++] = byte;
+            code++;
+        }
+        /* A full block at the very end needs no empty block after it */
+        if (byte == 0x00u ||
+            (code == OBC_FRAME_BLOCK_MAX + 1u && i + 1u < n))
+        {
+            frame[code_pos] = code;
+            code_pos        = out++;
+            code            = 1;
+        }
+    }
+    frame[code_pos] = code;
+    frame[out++]    = OBC_FRAME_DELIM;
+    return out;
+}
+
+
+/* CRC-16/CCITT-FALSE */
+uint16_t OBC_FRAME_crc(const uint8_t *data, uint16_t len)
+{
+    uint16_t     crc = 0xFFFFu;
+    unsigned int bit;
+    while (len-- > 0)
+    {
+        crc ^= (uint16_t)(*data++) << 8;
+        for (bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x8000u) ? (uint16_t)((crc << 1) ^ 0x1021u)
+                                  : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+
+static void OBC_FRAME_put(OBC_FRAME_rx_t *rx, uint8_t byte)
+{
+    if (rx->len >= rx->cap)
+    {
+        rx->overrun = true;
+        return;
+    }
+    rx->buf[rx->len++] = byte;
+}
+
@@ -9,28 +9,56 @@
  * @copyright Copyright (c) 2020 DSS - LORIS project
  *
  */
-#include <stdio.h> /* snprintf */
 #include <string.h>
 #include <stdint.h>
 #include <limits.h>
 #include <stdbool.h>
-#include <stdarg.h>
 #include "targets.h"
 
 #include "obc_interface.h"
-#include "bufferlib.h"
+#include "obc_frame.h"
 #include "injection_api.h"
+#include "json_writer.h"
+#include "replay.h"
+#include "profiling.h"
 
 #if !defined(TARGET_MCU)
 #include "obc_emulator.h"
+#include <stdatomic.h>
 #include <pthread.h>
-static pthread_mutex_t OBC_IF_rxflag_lock;
+#include <time.h>
+#include <errno.h>
+
+/* The emulator receives on its own thread */
+typedef _Atomic uint8_t  obc_rxq_index_t;
+typedef _Atomic uint32_t obc_rxq_count_t;
+
+#define OBC_RXQ_STATS_LOCK()
+#define OBC_RXQ_STATS_UNLOCK()
 #else
+#include <msp430.h>
 #include "uart.h"
 #include "spi.h"
+
+/* Byte wide accesses are atomic, the receive interrupt is the producer */
+typedef volatile uint8_t obc_rxq_index_t;
+typedef uint32_t         obc_rxq_count_t;
+
+/* Stops the compiler moving slot accesses across an index access */
+#define OBC_RXQ_BARRIER() __asm__ __volatile__("" ::: "memory")
+
+#define OBC_RXQ_STATS_LOCK()                                                   \
+    uint16_t obc_rxq_irq_state = __get_interrupt_state();                      \
+    __disable_interrupt()
+#define OBC_RXQ_STATS_UNLOCK() __set_interrupt_state(obc_rxq_irq_state)
 #endif /* !defined(TARGET_MCU) */
 
-#define OBC_INTERFACE_BUFFER_SIZE 500
+/* Code bytes in front of the reply payload so it is framed in place */
+#define OBC_TX_HEAD OBC_FRAME_HEAD(OBC_TX_BUFFER_SIZE)
+
+_Static_assert((OBC_RX_FRAME_CNT & (OBC_RX_FRAME_CNT - 1)) == 0 &&
+                   OBC_RX_FRAME_CNT <= 128,
+               "OBC_RX_FRAME_CNT must be a power of two up to 128");
 
 typedef struct
 {
@@ -46,14 +74,53 @@ typedef struct
  * @param byte byte to receive from driver
  */
 static void OBC_IF_receive_byte_internal(uint8_t byte);
+static void OBC_IF_receive_frame_byte(uint8_t byte);
 
 static int OBC_IF_config_internal(rx_injector_func init, deinit_func deinit,
                                   transmit_func tx);
 
-static OBC_IF_fops   ops           = {NULL};
-static volatile bool OBC_IF_rxflag = false;
-static buffer_handle obc_buf_handle;
-static uint8_t       obcTxBuf[OBC_INTERFACE_BUFFER_SIZE];
+static void     OBC_IF_rxq_reset(void);
+static uint8_t  OBC_IF_rxq_acquire(obc_rxq_index_t *idx);
+static void     OBC_IF_rxq_release(obc_rxq_index_t *idx, uint8_t val);
+static void     OBC_IF_rxq_count(obc_rxq_count_t *cnt);
+static uint32_t OBC_IF_rxq_counted(obc_rxq_count_t *cnt);
+
+#if !defined(TARGET_MCU)
+static void OBC_IF_rx_wait_init(void);
+#endif /* #if !defined(TARGET_MCU) */
+
+static OBC_IF_fops ops = {NULL};
+static uint8_t     obcTxBuf[OBC_FRAME_WIRE_LEN(OBC_TX_BUFFER_SIZE)];
+static JW_t        obc_reply;
+
+/* Received frames, a single producer single consumer ring. The receive
+ * interrupt fills the slot at head and then publishes it by moving head. The
+ * main loop empties the slot at tail and then frees it by moving tail. Each
+ * side acquires the other's index before touching a slot and releases its
+ * own after, so neither sees a slot the other is still using */
+static uint8_t obc_rx_frames[OBC_RX_FRAME_CNT]
+                            [OBC_RX_FRAME_LEN + OBC_FRAME_CRC_SIZE];
+static uint16_t        obc_rx_len[OBC_RX_FRAME_CNT];
+static obc_rxq_index_t obc_rx_head;
+static obc_rxq_index_t obc_rx_tail;
+static OBC_FRAME_rx_t  obc_rx;
+
+#if !defined(TARGET_MCU)
+/* Only for OBC_IF_rx_wait, the queue itself takes no lock. The condition
+ * times out on the monotonic clock, set by OBC_IF_rx_wait_init */
+static pthread_mutex_t obc_rx_wait_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  obc_rx_wait_cond;
+static pthread_once_t  obc_rx_wait_once = PTHREAD_ONCE_INIT;
+#endif /* #if !defined(TARGET_MCU) */
+
+/* Counted by the receive interrupt only */
+static struct
+{
+    obc_rxq_count_t frames;
+    obc_rxq_count_t bad;
+    obc_rxq_count_t too_long;
+    obc_rxq_count_t dropped;
+} obc_rx_stats;
 
 int OBC_IF_config(OBC_IF_PHY_CFG_t cfg_mode)
 {
@@ -99,12 +166,6 @@ void OBC_IF_clear_config(void)
         ops.deinit();
         ops.deinit = NULL;
     }
-
-    obc_buf_handle.delete(obc_buf_handle.this);
-
-#if !defined(TARGET_MCU)
-    pthread_mutex_destroy(&OBC_IF_rxflag_lock);
-#endif /* !defined(TARGET_MCU) */
 }
 
 
@@ -113,125 +174,206 @@ void OBC_IF_receive_byte(uint8_t byte)
 {
     OBC_IF_receive_byte_internal(byte);
 }
-#endif /* #if defined(TARGET_MCU) */
 
-int OCB_IF_get_command_string(uint8_t *buf, uint_least16_t buflen)
+
+int OBC_IF_config_native(int (*tx)(uint8_t *buf, uint16_t buflen))
 {
-    CONFIG_ASSERT(buf != NULL);
-    int           status      = 0;
-    bool          found_delim = false;
-    uint_fast16_t i           = 0;
-    do
+    CONFIG_ASSERT(tx != NULL);
+    return OBC_IF_config_internal(NULL, NULL, tx);
+}
+
+
+int OBC_IF_rx_wait(uint32_t timeout_ms)
+{
+    struct timespec deadline;
+    int             rc = 0;
+    pthread_once(&obc_rx_wait_once, OBC_IF_rx_wait_init);
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += timeout_ms / 1000u;
+    deadline.tv_nsec += (long)(timeout_ms % 1000u) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L)
     {
-        int tmp = obc_buf_handle.read_next(obc_buf_handle.this);
-        if (tmp != BUFFERLIB_READ_FAILURE)
-        {
-            buf[i] = (char)tmp;
-            if (buf[i] == OBC_MSG_DELIM)
-            {
-                buf[i]      = '\0';
-                found_delim = true;
-            }
-        }
-        else
-        {
-            break;
-        }
-    } while (!found_delim && ++i < buflen);
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
 
-    if (!found_delim)
+    /* A frame published after the check is signalled under the same lock,
+     * so the wait cannot miss it */
+    pthread_mutex_lock(&obc_rx_wait_mutex);
+    while (OBC_IF_rx_frame_cnt() == 0 && rc != ETIMEDOUT)
     {
-        status = 1;
+        rc = pthread_cond_timedwait(&obc_rx_wait_cond, &obc_rx_wait_mutex,
+                                    &deadline);
     }
-    return status;
+    pthread_mutex_unlock(&obc_rx_wait_mutex);
+    return (OBC_IF_rx_frame_cnt() > 0) ? 0 : 1;
 }
 
 
-__EMULATABLE int OBC_IF_tx(uint8_t *buf, uint_least16_t buflen)
+/* A wall clock step would move the deadline of a wait in progress */
+static void OBC_IF_rx_wait_init(void)
 {
-    CONFIG_ASSERT(ops.tx != NULL);
-    return ops.tx(buf, buflen);
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&obc_rx_wait_cond, &attr);
+    pthread_condattr_destroy(&attr);
 }
+#endif /* #if defined(TARGET_MCU) */
 
 
-bool OBC_IF_dataRxFlag_read(void)
+uint8_t OBC_IF_rx_frame_cnt(void)
 {
-    bool flag_state;
+    return (uint8_t)(OBC_IF_rxq_acquire(&obc_rx_head) - obc_rx_tail);
+}
 
-#if !defined(TARGET_MCU)
-    pthread_mutex_lock(&OBC_IF_rxflag_lock);
-#endif /* #if defined(TARGET_MCU) */
 
-    flag_state = OBC_IF_rxflag;
+int OCB_IF_get_command_string(uint8_t *buf, uint_least16_t buflen)
+{
+    CONFIG_ASSERT(buf != NULL);
+    int           status = 1;
+    const uint8_t tail   = obc_rx_tail;
+    if (OBC_IF_rxq_acquire(&obc_rx_head) != tail)
+    {
+        const uint8_t  slot = tail % OBC_RX_FRAME_CNT;
+        const uint16_t len  = obc_rx_len[slot];
+        if (len < buflen)
+        {
+            memcpy(buf, obc_rx_frames[slot], len);
+            buf[len] = '\0';
+            status   = 0;
+            REPLAY_record(REPLAY_REC_obc_rx, buf, len);
+        }
+        OBC_IF_rxq_release(&obc_rx_tail, (uint8_t)(tail + 1u));
+    }
+    return status;
+}
 
-#if !defined(TARGET_MCU)
-    pthread_mutex_unlock(&OBC_IF_rxflag_lock);
-#endif /* #if defined(TARGET_MCU) */
 
-    return flag_state;
+void OBC_IF_get_rx_stats(OBC_IF_rx_stats_t *stats)
+{
+    CONFIG_ASSERT(stats != NULL);
+    OBC_RXQ_STATS_LOCK();
+    stats->frames   = OBC_IF_rxq_counted(&obc_rx_stats.frames);
+    stats->bad      = OBC_IF_rxq_counted(&obc_rx_stats.bad);
+    stats->too_long = OBC_IF_rxq_counted(&obc_rx_stats.too_long);
+    stats->dropped  = OBC_IF_rxq_counted(&obc_rx_stats.dropped);
+    OBC_RXQ_STATS_UNLOCK();
 }
 
-void OBC_IF_dataRxFlag_write(bool data_state)
+
+__EMULATABLE int OBC_IF_tx(uint8_t *buf, uint_least16_t buflen)
 {
-#if !defined(TARGET_MCU)
-    pthread_mutex_lock(&OBC_IF_rxflag_lock);
-#endif /* #if defined(TARGET_MCU) */
+    CONFIG_ASSERT(ops.tx != NULL);
+    CONFIG_ASSERT(buf != NULL);
+    CONFIG_ASSERT(buflen <= OBC_TX_BUFFER_SIZE);
+
+    /* Replies are written in place already */
+    uint8_t *payload = &obcTxBuf[OBC_TX_HEAD];
+    if (buf != payload)
+    {
+        memmove(payload, buf, buflen);
+    }
+    REPLAY_output(REPLAY_REC_obc_tx, payload, buflen);
+    const uint16_t frame_len = OBC_FRAME_encode(obcTxBuf, OBC_TX_HEAD, buflen);
+    return ops.tx(obcTxBuf, frame_len);
+}
 
-    OBC_IF_rxflag = data_state;
 
-#if !defined(TARGET_MCU)
-    pthread_mutex_unlock(&OBC_IF_rxflag_lock);
-#endif /* #if defined(TARGET_MCU) */
+JW_t *OBC_IF_reply_begin(void)
+{
+    /* after the room for the code bytes that frame it */
+    JW_init(&obc_reply, (char *)&obcTxBuf[OBC_TX_HEAD], OBC_TX_BUFFER_SIZE);
+    return &obc_reply;
 }
 
 
-/** @todo THIS FUNCTION IS SO GODDAMN UGLY BUT AT LEAST ITS WORKING - Carl */
-int OBC_IF_printf(const char *restrict fmt, ...)
+int OBC_IF_reply_send(JW_t *w)
 {
-    CONFIG_ASSERT(fmt != NULL);
-    int     bytes_transmitted = 0;
-    va_list args;
-    va_start(args, fmt);
+    CONFIG_ASSERT(w == &obc_reply);
+    if (JW_finish(w))
+    {
+        OBC_IF_reply_begin();
+        JW_object_begin(w);
+        JW_key(w, "error");
+        JW_str(w, "reply");
+        JW_object_end(w);
+        JW_finish(w);
+    }
 
-#if defined(TARGET_MCU)
-    char *fmt_str = (char *)fmt;
-#else
-    /** @note why the fuck do I even have to add this. I shouldn't have to add
-     * it. In fact, according to POSIX spec for termios I shouldn't even have
-     * to WORRY about it...
-     *
-     * The entire reason this is here is so that the god damn newline gets
-     * appended to the format string because aparently, POSIX shells can't
-     * fucking detect EOL signals consistently...
-     *
-     * I've spend HOURS finding the problem and then fixing it.
-     *
-     * IF YOU TOUCH THIS PART I WILL ROLL OVER IN MY GRAVE...
-     *
-     * - Carl
-     */
-    char fmt_str[250] = {'\0'};
-    CONFIG_ASSERT(strnlen(fmt, sizeof(fmt_str)) <= sizeof(fmt_str));
-    strcpy(fmt_str, fmt);
-    strcat(fmt_str, "\n");
-#endif /* #if defined(TARGET_MCU) */
+    /* The frame delimiter ends the reply, the emulator prints the newline a
+     * terminal needs after it */
+    return OBC_IF_tx((uint8_t *)w->buf, w->len);
+}
 
-    memset(obcTxBuf, 0, sizeof(obcTxBuf));
-    vsnprintf((char *)obcTxBuf, sizeof(obcTxBuf), fmt_str, args);
-    size_t msg_len = strnlen((char *)obcTxBuf, sizeof(obcTxBuf));
 
-    bytes_transmitted = OBC_IF_tx(obcTxBuf, msg_len);
-    va_end(args);
-    return bytes_transmitted;
+int OBC_IF_reply_error(const char *what)
+{
+    CONFIG_ASSERT(what != NULL);
+    JW_t *w = OBC_IF_reply_begin();
+    JW_object_begin(w);
+    JW_key(w, "error");
+    JW_str(w, what);
+    JW_object_end(w);
+    return OBC_IF_reply_send(w);
 }
 
 
 static void OBC_IF_receive_byte_internal(uint8_t byte)
 {
-    obc_buf_handle.write_next(obc_buf_handle.this, byte);
-    if (byte == OBC_MSG_DELIM)
+    PROF_BEGIN(PROF_obc_rx_isr);
+    OBC_IF_receive_frame_byte(byte);
+    PROF_END(PROF_obc_rx_isr);
+}
+
+
+static void OBC_IF_receive_frame_byte(uint8_t byte)
+{
+    const uint8_t head = obc_rx_head;
+    if (!obc_rx.active && byte != OBC_FRAME_DELIM)
+    {
+        /* A frame starts, it goes to the free slot at head if there is one */
+        if ((uint8_t)(head - OBC_IF_rxq_acquire(&obc_rx_tail)) <
+            OBC_RX_FRAME_CNT)
+        {
+            OBC_FRAME_rx_init(&obc_rx, obc_rx_frames[head % OBC_RX_FRAME_CNT],
+                              sizeof(obc_rx_frames[0]));
+        }
+        else
+        {
+            OBC_FRAME_rx_init(&obc_rx, NULL, 0);
+        }
+    }
+
+    const OBC_FRAME_RX_t result = OBC_FRAME_rx_byte(&obc_rx, byte);
+    if (result == OBC_FRAME_RX_busy)
+    {
+        return;
+    }
+
+    if (obc_rx.buf == NULL)
+    {
+        OBC_IF_rxq_count(&obc_rx_stats.dropped);
+    }
+    else if (result == OBC_FRAME_RX_done)
+    {
+        obc_rx_len[head % OBC_RX_FRAME_CNT] = obc_rx.len;
+        OBC_IF_rxq_release(&obc_rx_head, (uint8_t)(head + 1u));
+        OBC_IF_rxq_count(&obc_rx_stats.frames);
+#if !defined(TARGET_MCU)
+        pthread_once(&obc_rx_wait_once, OBC_IF_rx_wait_init);
+        pthread_mutex_lock(&obc_rx_wait_mutex);
+        pthread_cond_signal(&obc_rx_wait_cond);
+        pthread_mutex_unlock(&obc_rx_wait_mutex);
+#endif /* #if !defined(TARGET_MCU) */
+    }
+    else if (result == OBC_FRAME_RX_too_long)
+    {
+        OBC_IF_rxq_count(&obc_rx_stats.too_long);
+    }
+    else
     {
-        OBC_IF_dataRxFlag_write(OBC_IF_DATA_RX_FLAG_SET);
+        OBC_IF_rxq_count(&obc_rx_stats.bad);
     }
 }
 
@@ -244,11 +386,7 @@ static int OBC_IF_config_internal(rx_injector_func init, deinit_func deinit,
     ops.deinit = deinit;
     ops.tx     = tx;
 
-    obc_buf_handle = bufferlib_ringbuf_new(OBC_INTERFACE_BUFFER_SIZE);
-
-#if !defined(TARGET_MCU)
-    pthread_mutex_init(&OBC_IF_rxflag_lock, NULL);
-#endif /* !defined(TARGET_MCU) */
+    OBC_IF_rxq_reset();
 
     if (ops.init != NULL)
     {
@@ -262,4 +400,58 @@ static int OBC_IF_config_internal(rx_injector_func init, deinit_func deinit,
     }
 
     return status;
-}
\ No newline at end of file
+}
+
+
+static void OBC_IF_rxq_reset(void)
+{
+    obc_rx_head = 0;
+    obc_rx_tail = 0;
+    memset((void *)&obc_rx_stats, 0, sizeof(obc_rx_stats));
+    OBC_FRAME_rx_init(&obc_rx, NULL, 0);
+}
+
+
+/* Read the other side's index, slot accesses after it stay after it */
+static uint8_t OBC_IF_rxq_acquire(obc_rxq_index_t *idx)
+{
+#if defined(TARGET_MCU)
+    const uint8_t val = *idx;
+    OBC_RXQ_BARRIER();
+    return val;
+#else
+    return atomic_load_explicit(idx, memory_order_acquire);
+#endif /* #if defined(TARGET_MCU) */
+}
+
+
+/* Move our own index, slot accesses before it stay before it */
+static void OBC_IF_rxq_release(obc_rxq_index_t *idx, uint8_t val)
+{
+#if defined(TARGET_MCU)
+    OBC_RXQ_BARRIER();
+    *idx = val;
+#else
+    atomic_store_explicit(idx, val, memory_order_release);
+#endif /* #if defined(TARGET_MCU) */
+}
+
+
+static void OBC_IF_rxq_count(obc_rxq_count_t *cnt)
+{
+#if defined(TARGET_MCU)
+    (*cnt)++;
+#else
+    atomic_fetch_add_explicit(cnt, 1u, memory_order_relaxed);
+#endif /* #if defined(TARGET_MCU) */
+}
+
+
+static uint32_t OBC_IF_rxq_counted(obc_rxq_count_t *cnt)
+{
+#if defined(TARGET_MCU)
+    return *cnt;
+#else
+    return atomic_load_explicit(cnt, memory_order_relaxed);
+#endif /* #if defined(TARGET_MCU) */
+}
@@ -0,0 +1,323 @@
+/**
+ * @file frame_burst.test.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief OBC link framing: random payloads round trip, corrupted frames are
+ * rejected, the decoder never writes past its buffer, and frames sent back
+ * to back queue up until the main loop takes them
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ */
+#if defined(TARGET_MCU)
+#error NATIVE TESTS CANNOT BE RUN ON A BARE METAL MICROCONTROLLER
+#endif /* #if defined(TARGET_MCU) */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "obc_interface.h"
+#include "obc_frame.h"
+#include "test_expect.h"
+
+#define FUZZ_ROUNDS (20000u)
+#define FUZZ_LEN_MAX (600u)
+#define GUARD_LEN (16u)
+#define GUARD_BYTE (0xA5u)
+#define BURST_FRAMES (5000u)
+#define SEQ_LEN (8u)
+
+typedef struct
+{
+    uint8_t  bytes[OBC_FRAME_WIRE_LEN(FUZZ_LEN_MAX)];
+    uint16_t len;
+} wire_frame;
+
+static uint8_t payload[FUZZ_LEN_MAX];
+static uint8_t decoded[FUZZ_LEN_MAX + OBC_FRAME_CRC_SIZE + GUARD_LEN];
+
+
+/* Random payload with the bytes the old framing choked on, and long runs
+ * without a zero so the 254 byte blocks are hit */
+static uint16_t random_payload(uint8_t *buf)
+{
+    static const uint8_t special[] = {0x00, '!', 0xFF, 0x01, '\n'};
+    const unsigned int   kind      = rand() % 4;
+    uint16_t             len       = (uint16_t)(rand() % (FUZZ_LEN_MAX + 1));
+    uint16_t             i;
+    if (kind == 0)
+    {
+        len = (uint16_t)(250 + rand() % 12); /* around one full block */
+    }
+    for (i = 0; i < len; i++)
+    {
+        if (kind == 1 && rand() % 4 == 0)
+        {
+            buf[i] = special[rand() % sizeof(special)];
+        }
+        else if (kind <= 1)
+        {
+            buf[i] = (uint8_t)(1 + rand() % 255);
+        }
+        else
+        {
+            buf[i] = (uint8_t)rand();
+        }
+    }
+    return len;
+}
+
+
+static void encode(wire_frame *f, const uint8_t *data, uint16_t len)
+{
+    const uint16_t head = OBC_FRAME_HEAD(FUZZ_LEN_MAX);
+    memcpy(&f->bytes[head], data, len);
+    f->len = OBC_FRAME_encode(f->bytes, head, len);
+}
+
+
+/* Decode a whole frame into a buffer of cap bytes followed by a guard */
+static OBC_FRAME_RX_t decode(const wire_frame *f, uint16_t cap,
+                             OBC_FRAME_rx_t *rx)
+{
+    OBC_FRAME_RX_t result = OBC_FRAME_RX_busy;
+    uint16_t       i;
+    memset(decoded, GUARD_BYTE, sizeof(decoded));
+    OBC_FRAME_rx_init(rx, decoded, cap);
+    for (i = 0; i < f->len; i++)
+    {
+        OBC_FRAME_RX_t r = OBC_FRAME_rx_byte(rx, f->bytes[i]);
+        if (r != OBC_FRAME_RX_busy)
+        {
+            result = r;
+        }
+    }
+    return result;
+}
+
+
+static int guard_intact(uint16_t cap)
+{
+    uint16_t i;
+    for (i = cap; i < cap + GUARD_LEN; i++)
+    {
+        if (decoded[i] != GUARD_BYTE)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+
+static void send_frame(const wire_frame *f)
+{
+    uint16_t i;
+    for (i = 0; i < f->len; i++)
+    {
+        OBC_IF_receive_byte(f->bytes[i]);
+    }
+}
+
+
+/* Binary on purpose, the old delimiter and zeros included */
+static void sequence_msg(uint8_t msg[SEQ_LEN], unsigned int n)
+{
+    msg[0] = '!';
+    msg[1] = 0x00;
+    msg[2] = (uint8_t)(n >> 24);
+    msg[3] = (uint8_t)(n >> 16);
+    msg[4] = (uint8_t)(n >> 8);
+    msg[5] = (uint8_t)n;
+    msg[6] = 0x00;
+    msg[7] = '!';
+}
+
+
+static void sequence_frame(wire_frame *f, unsigned int n)
+{
+    uint8_t msg[SEQ_LEN];
+    sequence_msg(msg, n);
+    encode(f, msg, sizeof(msg));
+}
+
+
+/* The OBC side: a burst as long as the queue, back to back, then it waits
+ * for the replies before the next one */
+static void *burst_producer(void *args)
+{
+    wire_frame  *f = malloc(sizeof(*f));
+    unsigned int n;
+    (void)args;
+    for (n = 0; n < BURST_FRAMES; n++)
+    {
+        sequence_frame(f, n);
+        send_frame(f);
+        if ((n + 1u) % OBC_RX_FRAME_CNT == 0)
+        {
+            while (OBC_IF_rx_frame_cnt() > 0)
+            {
+                sched_yield();
+            }
+        }
+    }
+    free(f);
+    return NULL;
+}
+
+
+int main(void)
+{
+    static wire_frame f;
+    OBC_FRAME_rx_t    rx;
+    OBC_IF_rx_stats_t stats;
+    uint8_t           cmd[OBC_RX_FRAME_LEN + 1];
+    uint8_t           seq[SEQ_LEN];
+    unsigned int      round;
+    unsigned int      accepted_bad = 0;
+
+    srand(38);
+
+    /* Round trip: any payload, the encoded frame holds no zero but its
+     * delimiter and is never longer than OBC_FRAME_WIRE_LEN */
+    for (round = 0; round < FUZZ_ROUNDS; round++)
+    {
+        const uint16_t len = random_payload(payload);
+        encode(&f, payload, len);
+        EXPECT(f.len <= OBC_FRAME_WIRE_LEN(len));
+        EXPECT(memchr(f.bytes, OBC_FRAME_DELIM, f.len - 1u) == NULL);
+        EXPECT(f.bytes[f.len - 1u] == OBC_FRAME_DELIM);
+
+        EXPECT(decode(&f, len + OBC_FRAME_CRC_SIZE, &rx) == OBC_FRAME_RX_done);
+        EXPECT(rx.len == len);
+        EXPECT(memcmp(decoded, payload, len) == 0);
+        EXPECT(guard_intact(len + OBC_FRAME_CRC_SIZE));
+
+        /* One byte short */
+        EXPECT(decode(&f, len + 1u, &rx) == OBC_FRAME_RX_too_long);
+        EXPECT(guard_intact(len + 1u));
+
+        /* Corrupt a byte. A new zero splits the frame, neither piece may
+         * pass for a good frame */
+        const uint16_t at  = (uint16_t)(rand() % (f.len - 1u));
+        const uint8_t  was = f.bytes[at];
+        f.bytes[at] ^= (uint8_t)(1u << (rand() % 8));
+        if (decode(&f, len + OBC_FRAME_CRC_SIZE, &rx) == OBC_FRAME_RX_done)
+        {
+            accepted_bad++;
+        }
+        EXPECT(guard_intact(len + OBC_FRAME_CRC_SIZE));
+        f.bytes[at] = was;
+    }
+    printf("fuzz : %u frames round trip, %u of %u corrupted frames "
+           "accepted\n",
+           FUZZ_ROUNDS, accepted_bad, FUZZ_ROUNDS);
+    EXPECT(accepted_bad == 0);
+
+    /* Line noise into a small buffer */
+    memset(decoded, GUARD_BYTE, sizeof(decoded));
+    OBC_FRAME_rx_init(&rx, decoded, 32);
+    for (round = 0; round < 100000u; round++)
+    {
+        (void)OBC_FRAME_rx_byte(&rx, (uint8_t)rand());
+        EXPECT(rx.len <= 32);
+    }
+    EXPECT(guard_intact(32));
+
+    /* Keep the emulator thread off the terminal */
+    EXPECT(freopen("/dev/null", "r", stdin) != NULL);
+    EXPECT(OBC_IF_config(OBC_IF_PHY_CFG_EMULATED) == 0);
+    EXPECT(OBC_IF_rx_frame_cnt() == 0);
+    EXPECT(OCB_IF_get_command_string(cmd, sizeof(cmd)) == 1);
+
+    /* Back to back before the main loop runs: the queue fills, the rest are
+     * counted as dropped, and noise between frames costs nothing */
+    for (round = 0; round < OBC_RX_FRAME_CNT + 2u; round++)
+    {
+        sequence_frame(&f, round);
+        send_frame(&f);
+        OBC_IF_receive_byte(OBC_FRAME_DELIM);
+    }
+    EXPECT(OBC_IF_rx_frame_cnt() == OBC_RX_FRAME_CNT);
+    OBC_IF_get_rx_stats(&stats);
+    EXPECT(stats.frames == OBC_RX_FRAME_CNT);
+    EXPECT(stats.dropped == 2 && stats.bad == 0 && stats.too_long == 0);
+    for (round = 0; round < OBC_RX_FRAME_CNT; round++)
+    {
+        sequence_msg(seq, round);
+        EXPECT(OCB_IF_get_command_string(cmd, sizeof(cmd)) == 0);
+        EXPECT(memcmp(cmd, seq, SEQ_LEN) == 0 && cmd[SEQ_LEN] == '\0');
+    }
+    EXPECT(OBC_IF_rx_frame_cnt() == 0);
+
+    /* Too long, corrupted and cut short frames are counted, the next good
+     * one still gets through */
+    memset(payload, 'x', OBC_RX_FRAME_LEN + 1u);
+    encode(&f, payload, OBC_RX_FRAME_LEN + 1u);
+    send_frame(&f);
+    encode(&f, (const uint8_t *)"{\"mode\":\"read\"}", 15);
+    f.bytes[4] ^= 0x20u;
+    send_frame(&f);
+    f.bytes[4] ^= 0x20u;
+    f.bytes[f.len - 3u] = OBC_FRAME_DELIM; /* cut inside its CRC */
+    send_frame(&f);
+    encode(&f, (const uint8_t *)"{\"mode\":\"read\"}", 15);
+    send_frame(&f);
+    OBC_IF_get_rx_stats(&stats);
+    EXPECT(stats.too_long == 1 && stats.bad == 3);
+    EXPECT(OBC_IF_rx_frame_cnt() == 1);
+    EXPECT(OCB_IF_get_command_string(cmd, 15) == 1); /* no room, dropped */
+    EXPECT(OBC_IF_rx_frame_cnt() == 0);
+
+    encode(&f, (const uint8_t *)"{\"mode\":\"read\"}", 15);
+    send_frame(&f);
+    EXPECT(OCB_IF_get_command_string(cmd, 16) == 0);
+    EXPECT(strcmp((const char *)cmd, "{\"mode\":\"read\"}") == 0);
+
+    /* Bursts from the receive thread against the main loop: every frame
+     * arrives once and in order */
+    OBC_IF_rx_stats_t before;
+    OBC_IF_get_rx_stats(&before);
+    pthread_t producer;
+    EXPECT(pthread_create(&producer, NULL, burst_producer, NULL) == 0);
+    unsigned int received = 0;
+    long         last     = -1;
+    int          done     = 0;
+    while (!done)
+    {
+        OBC_IF_get_rx_stats(&stats);
+        done = (stats.frames + stats.dropped - before.frames -
+                    before.dropped ==
+                BURST_FRAMES);
+        while (OBC_IF_rx_frame_cnt() > 0)
+        {
+            EXPECT(OCB_IF_get_command_string(cmd, sizeof(cmd)) == 0);
+            const long n = ((long)cmd[2] << 24) | ((long)cmd[3] << 16) |
+                           ((long)cmd[4] << 8) | (long)cmd[5];
+            EXPECT(n > last && n < (long)BURST_FRAMES);
+            sequence_msg(seq, (unsigned int)n);
+            EXPECT(memcmp(cmd, seq, SEQ_LEN) == 0);
+            last = n;
+            received++;
+        }
+    }
+    EXPECT(pthread_join(producer, NULL) == 0);
+    EXPECT(OBC_IF_rx_frame_cnt() == 0);
+    OBC_IF_get_rx_stats(&stats);
+    printf("burst : %u frames in bursts of %u, %u taken, %lu dropped\n",
+           BURST_FRAMES, (unsigned int)OBC_RX_FRAME_CNT, received,
+           (unsigned long)(stats.dropped - before.dropped));
+    EXPECT(received == BURST_FRAMES);
+    EXPECT(stats.frames - before.frames == BURST_FRAMES);
+    EXPECT(stats.dropped == before.dropped && stats.bad == before.bad &&
+           stats.too_long == before.too_long);
+
+    OBC_IF_clear_config();
+    printf("PASS\n");
+    return 0;
+}
@@ -0,0 +1,231 @@
+/**
+ * @file pty_link.test.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief The OBC link served on a pseudo terminal: a client on the slave
+ * exchanges frames with the interface as over the board's uart, at the byte
+ * rate of the configured baud both ways
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ */
+#if defined(TARGET_MCU)
+#error NATIVE TESTS CANNOT BE RUN ON A BARE METAL MICROCONTROLLER
+#endif /* #if defined(TARGET_MCU) */
+
+#define _GNU_SOURCE /* cfmakeraw */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <termios.h>
+
+#include "obc_interface.h"
+#include "obc_frame.h"
+#include "obc_emulator.h"
+#include "pty_emulator.h"
+#include "uart_emulator.h"
+#include "test_expect.h"
+
+#define CMD_LEN (40u)
+#define REPLY_LEN (300u)
+#define READ_TIMEOUT_MS (5000)
+
+/* Never faster than the line. Slower by the host scheduling, a lot slower
+ * under valgrind */
+#define LINE_SLACK_MIN (0.98)
+#define LINE_SLACK_MAX (4.0)
+#define LINE_SLACK_MS (50.0)
+
+static const uint32_t bauds[] = {9600u, 115200u};
+
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1.0e3 + (double)ts.tv_nsec / 1.0e6;
+}
+
+
+static double wire_ms(uint32_t bytes, uint32_t baud)
+{
+    return (double)bytes * UART_EMU_BITS_PER_BYTE * 1.0e3 / (double)baud;
+}
+
+
+static bool on_time(double ms, uint32_t bytes, uint32_t baud)
+{
+    const double model = wire_ms(bytes, baud);
+    printf("%6lu baud : %4lu bytes in %7.1f ms, line %7.1f ms\n",
+           (unsigned long)baud, (unsigned long)bytes, ms, model);
+    return ms >= model * LINE_SLACK_MIN &&
+           ms <= model * LINE_SLACK_MAX + LINE_SLACK_MS;
+}
+
+
+static int client_open(void)
+{
+    struct termios tio;
+    const int      fd = open(PTY_EMU_get_name(), O_RDWR | O_NOCTTY);
+    if (fd >= 0 && tcgetattr(fd, &tio) == 0)
+    {
+        cfmakeraw(&tio);
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+    return fd;
+}
+
+
+/* Read one frame from the client side into payload, 0 on success */
+static int client_read_frame(int fd, uint8_t *payload, uint16_t cap,
+                             uint16_t *len)
+{
+    OBC_FRAME_rx_t rx;
+    struct pollfd  pfd = {.fd = fd, .events = POLLIN};
+    uint8_t        byte;
+    OBC_FRAME_rx_init(&rx, payload, cap);
+    while (poll(&pfd, 1, READ_TIMEOUT_MS) == 1 && read(fd, &byte, 1) == 1)
+    {
+        switch (OBC_FRAME_rx_byte(&rx, byte))
+        {
+            case OBC_FRAME_RX_done:
+            {
+                *len = rx.len;
+                return 0;
+            }
+            break;
+            case OBC_FRAME_RX_busy:
+            {
+            }
+            break;
+            default:
+            {
+                return 1;
+            }
+            break;
+        }
+    }
+    return 1;
+}
+
+
+static int run_link(uint32_t baud)
+{
+    char env[16];
+    snprintf(env, sizeof(env), "%lu", (unsigned long)baud);
+    setenv(OBC_EMU_BAUD_ENV, env, 1);
+    setenv(OBC_EMU_PTY_ENV, "", 1);
+    EXPECT(OBC_IF_config(OBC_IF_PHY_CFG_EMULATED) == 0);
+    const int client = client_open();
+    EXPECT(client >= 0);
+
+    /* The OBC sends a burst of commands, as many as the queue holds. They
+     * come in at the line rate however fast the client wrote them */
+    uint8_t  burst[OBC_RX_FRAME_CNT * OBC_FRAME_WIRE_LEN(CMD_LEN)];
+    uint16_t burst_len = 0;
+    uint32_t n;
+    for (n = 0; n < OBC_RX_FRAME_CNT; n++)
+    {
+        uint8_t *f    = &burst[burst_len];
+        uint16_t head = OBC_FRAME_HEAD(CMD_LEN);
+        snprintf((char *)&f[head], CMD_LEN + 1,
+                 "{\"seq\":%lu,\"pad\":\"%*s\"}", (unsigned long)n,
+                 (int)(CMD_LEN - 18u), "");
+        burst_len += OBC_FRAME_encode(f, head, CMD_LEN);
+    }
+
+    double start = now_ms();
+    EXPECT(write(client, burst, burst_len) == burst_len);
+    while (OBC_IF_rx_frame_cnt() < OBC_RX_FRAME_CNT)
+    {
+        EXPECT(now_ms() - start < READ_TIMEOUT_MS);
+        usleep(100);
+    }
+    EXPECT(on_time(now_ms() - start, burst_len, baud));
+
+    uint8_t cmd[OBC_RX_FRAME_LEN + 1];
+    for (n = 0; n < OBC_RX_FRAME_CNT; n++)
+    {
+        char seq[16];
+        snprintf(seq, sizeof(seq), "{\"seq\":%lu,", (unsigned long)n);
+        EXPECT(OCB_IF_get_command_string(cmd, sizeof(cmd)) == 0);
+        EXPECT(strlen((const char *)cmd) == CMD_LEN);
+        EXPECT(strncmp((const char *)cmd, seq, strlen(seq)) == 0);
+    }
+
+    /* A reply blocks the sender until the line has shifted it out, and the
+     * client gets the frame as it is on the wire */
+    uint8_t reply[REPLY_LEN];
+    for (n = 0; n < REPLY_LEN; n++)
+    {
+        reply[n] = (uint8_t)n; /* zeroes included, the framing handles them */
+    }
+    start = now_ms();
+    EXPECT(OBC_IF_tx(reply, sizeof(reply)) > 0);
+    EXPECT(on_time(now_ms() - start, OBC_FRAME_WIRE_LEN(REPLY_LEN), baud));
+
+    uint8_t  got[REPLY_LEN + OBC_FRAME_CRC_SIZE];
+    uint16_t got_len;
+    EXPECT(client_read_frame(client, got, sizeof(got), &got_len) == 0);
+    EXPECT(got_len == REPLY_LEN);
+    EXPECT(memcmp(got, reply, REPLY_LEN) == 0);
+
+    PTY_EMU_stats_t stats;
+    PTY_EMU_get_stats(&stats);
+    EXPECT(stats.rx_bytes == burst_len);
+    EXPECT(stats.tx_bytes == OBC_FRAME_WIRE_LEN(REPLY_LEN));
+    EXPECT(stats.tx_lost == 0);
+
+    close(client);
+    OBC_IF_clear_config();
+    PTY_EMU_close();
+    return 0;
+}
+
+
+int main(void)
+{
+    uint32_t i;
+    for (i = 0; i < sizeof(bauds) / sizeof(*bauds); i++)
+    {
+        EXPECT(run_link(bauds[i]) == 0);
+    }
+
+    /* Clients find the slave through the link, it goes with the pair */
+    char link[64];
+    char target[64];
+    snprintf(link, sizeof(link), "/tmp/adcs_pty_link_%ld", (long)getpid());
+    setenv(OBC_EMU_PTY_ENV, link, 1);
+    setenv(OBC_EMU_BAUD_ENV, "0", 1);
+    EXPECT(OBC_IF_config(OBC_IF_PHY_CFG_EMULATED) == 0);
+    const ssize_t len = readlink(link, target, sizeof(target) - 1);
+    EXPECT(len > 0);
+    target[len] = '\0';
+    EXPECT(strcmp(target, PTY_EMU_get_name()) == 0);
+
+    /* Nobody reads, the reply is lost rather than blocking the firmware */
+    static uint8_t reply[OBC_TX_BUFFER_SIZE];
+    memset(reply, 'x', sizeof(reply));
+    for (i = 0; i < 64; i++)
+    {
+        EXPECT(OBC_IF_tx(reply, sizeof(reply)) > 0);
+    }
+    PTY_EMU_stats_t stats;
+    PTY_EMU_get_stats(&stats);
+    EXPECT(stats.tx_lost > 0);
+
+    OBC_IF_clear_config();
+    PTY_EMU_close();
+    EXPECT(access(link, F_OK) != 0);
+
+    printf("PASS\n");
+    return 0;
+}
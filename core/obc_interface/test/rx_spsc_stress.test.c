@@ -0,0 +1,238 @@
+/**
+ * @file rx_spsc_stress.test.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Receive queue under load: a producer thread in place of the uart
+ * interrupt against the main loop, lock free and with every index access
+ * behind a mutex as it was before, compared by throughput and by latency
+ * from the delimiter to the main loop taking the frame, and what an empty
+ * poll of the queue costs the main loop
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ */
+#if defined(TARGET_MCU)
+#error NATIVE TESTS CANNOT BE RUN ON A BARE METAL MICROCONTROLLER
+#endif /* #if defined(TARGET_MCU) */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+#include "obc_interface.h"
+#include "obc_frame.h"
+#include "test_expect.h"
+
+#define STRESS_FRAMES (100000u)
+#define POLLS (2000000u)
+#define CMD_LEN (24u) /* a short command, {"rw_speed":"read"} and so on */
+
+typedef struct
+{
+    uint8_t  bytes[OBC_FRAME_WIRE_LEN(CMD_LEN)];
+    uint16_t len;
+} wire_frame;
+
+typedef struct
+{
+    const char *name;
+    double      frames_per_s;
+    double      lat_p50_us;
+    double      lat_p99_us;
+    double      lat_max_us;
+} run_result;
+
+static bool            use_mutex;
+static pthread_mutex_t rxq_mutex = PTHREAD_MUTEX_INITIALIZER;
+static uint64_t        sent_ns[STRESS_FRAMES];
+static double          latency_us[STRESS_FRAMES];
+
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+
+/* Where the queue indexes are touched, the mutex version locks */
+static void lock(void)
+{
+    if (use_mutex)
+    {
+        pthread_mutex_lock(&rxq_mutex);
+    }
+}
+
+
+static void unlock(void)
+{
+    if (use_mutex)
+    {
+        pthread_mutex_unlock(&rxq_mutex);
+    }
+}
+
+
+static uint8_t frame_cnt(void)
+{
+    lock();
+    const uint8_t cnt = OBC_IF_rx_frame_cnt();
+    unlock();
+    return cnt;
+}
+
+
+static void make_frame(wire_frame *f, uint32_t n)
+{
+    const uint16_t head = OBC_FRAME_HEAD(CMD_LEN);
+    snprintf((char *)&f->bytes[head], CMD_LEN + 1, "{\"seq\":%10lu,\"x\":1}",
+             (unsigned long)n);
+    f->len = OBC_FRAME_encode(f->bytes, head, CMD_LEN);
+}
+
+
+static void *producer(void *args)
+{
+    wire_frame f;
+    uint32_t   n;
+    uint16_t   i;
+    (void)args;
+    for (n = 0; n < STRESS_FRAMES; n++)
+    {
+        make_frame(&f, n);
+
+        /* The OBC waits for room rather than overrun the queue */
+        while (frame_cnt() == OBC_RX_FRAME_CNT)
+        {
+            sched_yield();
+        }
+
+        lock(); /* frame start picks a slot */
+        OBC_IF_receive_byte(f.bytes[0]);
+        unlock();
+        for (i = 1; i + 1u < f.len; i++)
+        {
+            OBC_IF_receive_byte(f.bytes[i]);
+        }
+        sent_ns[n] = now_ns();
+        lock(); /* the delimiter publishes the frame */
+        OBC_IF_receive_byte(f.bytes[f.len - 1u]);
+        unlock();
+    }
+    return NULL;
+}
+
+
+static int cmp_double(const void *a, const void *b)
+{
+    const double x = *(const double *)a;
+    const double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+
+static int run(const char *name, bool mutex, run_result *res)
+{
+    uint8_t   cmd[OBC_RX_FRAME_LEN + 1];
+    uint32_t  received = 0;
+    pthread_t thread;
+
+    use_mutex = mutex;
+    const uint64_t start = now_ns();
+    EXPECT(pthread_create(&thread, NULL, producer, NULL) == 0);
+    while (received < STRESS_FRAMES)
+    {
+        if (frame_cnt() == 0)
+        {
+            sched_yield();
+            continue;
+        }
+        lock();
+        const int status = OCB_IF_get_command_string(cmd, sizeof(cmd));
+        unlock();
+        const uint64_t taken = now_ns();
+
+        unsigned long n;
+        EXPECT(status == 0);
+        EXPECT(sscanf((const char *)cmd, "{\"seq\":%lu,", &n) == 1);
+        EXPECT(n == received);
+        latency_us[received] = (double)(taken - sent_ns[n]) / 1000.0;
+        received++;
+    }
+    const uint64_t end = now_ns();
+    EXPECT(pthread_join(thread, NULL) == 0);
+
+    qsort(latency_us, STRESS_FRAMES, sizeof(*latency_us), cmp_double);
+    res->name         = name;
+    res->frames_per_s = STRESS_FRAMES / ((double)(end - start) / 1.0e9);
+    res->lat_p50_us   = latency_us[STRESS_FRAMES / 2];
+    res->lat_p99_us   = latency_us[STRESS_FRAMES * 99 / 100];
+    res->lat_max_us   = latency_us[STRESS_FRAMES - 1];
+    return 0;
+}
+
+
+/* ns per main loop poll of an empty queue */
+static double poll_ns(bool mutex)
+{
+    volatile uint8_t cnt = 0;
+    uint32_t         i;
+    use_mutex            = mutex;
+    const uint64_t start = now_ns();
+    for (i = 0; i < POLLS; i++)
+    {
+        cnt += frame_cnt();
+    }
+    return (double)(now_ns() - start) / POLLS;
+}
+
+
+int main(void)
+{
+    OBC_IF_rx_stats_t before;
+    OBC_IF_rx_stats_t after;
+    run_result        res[2];
+    unsigned int      i;
+
+    /* Keep the emulator thread off the terminal */
+    EXPECT(freopen("/dev/null", "r", stdin) != NULL);
+    EXPECT(OBC_IF_config(OBC_IF_PHY_CFG_EMULATED) == 0);
+
+    OBC_IF_get_rx_stats(&before);
+    EXPECT(run("mutex", true, &res[0]) == 0);
+    EXPECT(run("lock free", false, &res[1]) == 0);
+    OBC_IF_get_rx_stats(&after);
+
+    /* Every frame arrived once, in order, none lost or damaged */
+    EXPECT(after.frames - before.frames == 2 * STRESS_FRAMES);
+    EXPECT(after.dropped == before.dropped && after.bad == before.bad &&
+           after.too_long == before.too_long);
+    EXPECT(OBC_IF_rx_frame_cnt() == 0);
+
+    printf("%u frames of %u bytes, queue of %u:\n", STRESS_FRAMES, CMD_LEN,
+           (unsigned int)OBC_RX_FRAME_CNT);
+    for (i = 0; i < 2; i++)
+    {
+        printf("  %-9s : %9.0f frames/s, latency p50 %7.2f us, "
+               "p99 %8.2f us, max %9.2f us\n",
+               res[i].name, res[i].frames_per_s, res[i].lat_p50_us,
+               res[i].lat_p99_us, res[i].lat_max_us);
+    }
+
+    const double poll_mutex     = poll_ns(true);
+    const double poll_lock_free = poll_ns(false);
+    printf("  empty poll : %.2f ns with the mutex, %.2f ns lock free\n",
+           poll_mutex, poll_lock_free);
+
+    OBC_IF_clear_config();
+    printf("PASS\n");
+    return 0;
+}
@@ -0,0 +1,182 @@
+/**
+ * @file rx_wait.test.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief The native main loop sleeping in OBC_IF_rx_wait: CPU it takes while
+ * idle against polling the queue, how long a frame waits before the loop
+ * wakes, and the timeout
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ */
+#if defined(TARGET_MCU)
+#error NATIVE TESTS CANNOT BE RUN ON A BARE METAL MICROCONTROLLER
+#endif /* #if defined(TARGET_MCU) */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "obc_interface.h"
+#include "obc_frame.h"
+#include "test_expect.h"
+
+#define IDLE_MS (500u)
+#define WAIT_MS (100u)  /* the main loop's NATIVE_IDLE_WAIT_MS */
+#define WAKES (200u)
+#define GAP_US (2000u)  /* between frames, so the loop is asleep each time */
+#define CMD_LEN (24u)
+
+static uint64_t sent_ns[WAKES];
+static double   latency_us[WAKES];
+
+
+static uint64_t clock_ns(clockid_t clock)
+{
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+
+static uint64_t now_ns(void)
+{
+    return clock_ns(CLOCK_MONOTONIC);
+}
+
+
+static void sleep_us(uint32_t us)
+{
+    struct timespec ts = {.tv_sec = 0, .tv_nsec = (long)us * 1000L};
+    nanosleep(&ts, NULL);
+}
+
+
+static void *producer(void *args)
+{
+    uint8_t        f[OBC_FRAME_WIRE_LEN(CMD_LEN)];
+    const uint16_t head = OBC_FRAME_HEAD(CMD_LEN);
+    uint32_t       n;
+    uint16_t       i;
+    (void)args;
+    for (n = 0; n < WAKES; n++)
+    {
+        sleep_us(GAP_US);
+        snprintf((char *)&f[head], CMD_LEN + 1, "{\"seq\":%10lu,\"x\":1}",
+                 (unsigned long)n);
+        const uint16_t len = OBC_FRAME_encode(f, head, CMD_LEN);
+        for (i = 0; i + 1u < len; i++)
+        {
+            OBC_IF_receive_byte(f[i]);
+        }
+        sent_ns[n] = now_ns();
+        OBC_IF_receive_byte(f[len - 1u]); /* the delimiter publishes it */
+    }
+    return NULL;
+}
+
+
+static int cmp_double(const void *a, const void *b)
+{
+    const double x = *(const double *)a;
+    const double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+
+/* Percent of one CPU the loop takes over IDLE_MS with no frame coming */
+static double idle_cpu(bool poll)
+{
+    volatile uint32_t spins = 0;
+    const uint64_t    cpu   = clock_ns(CLOCK_PROCESS_CPUTIME_ID);
+    const uint64_t    start = now_ns();
+    while (now_ns() - start < IDLE_MS * 1000000ull)
+    {
+        if (poll)
+        {
+            spins += (OBC_IF_rx_frame_cnt() == 0);
+        }
+        else
+        {
+            (void)OBC_IF_rx_wait(WAIT_MS);
+        }
+    }
+    return 100.0 * (double)(clock_ns(CLOCK_PROCESS_CPUTIME_ID) - cpu) /
+           (double)(now_ns() - start);
+}
+
+
+int main(void)
+{
+    uint8_t   cmd[OBC_RX_FRAME_LEN + 1];
+    pthread_t thread;
+    uint32_t  n;
+
+    /* Keep the emulator thread off the terminal */
+    EXPECT(freopen("/dev/null", "r", stdin) != NULL);
+    EXPECT(OBC_IF_config(OBC_IF_PHY_CFG_EMULATED) == 0);
+
+    /* Nothing comes, the wait runs out */
+    uint64_t start = now_ns();
+    EXPECT(OBC_IF_rx_wait(50) == 1);
+    const double timeout_ms = (double)(now_ns() - start) / 1.0e6;
+    EXPECT(timeout_ms >= 49.0 && timeout_ms < 500.0);
+
+    /* A frame already waiting returns at once */
+    uint8_t        f[OBC_FRAME_WIRE_LEN(CMD_LEN)];
+    const uint16_t head = OBC_FRAME_HEAD(CMD_LEN);
+    memcpy(&f[head], "{\"x\":1}", 7);
+    const uint16_t flen = OBC_FRAME_encode(f, head, 7);
+    uint16_t       i;
+    for (i = 0; i < flen; i++)
+    {
+        OBC_IF_receive_byte(f[i]);
+    }
+    start = now_ns();
+    EXPECT(OBC_IF_rx_wait(1000) == 0);
+    EXPECT(now_ns() - start < 50000000ull);
+    EXPECT(OCB_IF_get_command_string(cmd, sizeof(cmd)) == 0);
+    EXPECT(strcmp((const char *)cmd, "{\"x\":1}") == 0);
+
+    const double cpu_poll = idle_cpu(true);
+    const double cpu_wait = idle_cpu(false);
+    EXPECT(cpu_wait < 5.0);
+
+    /* Each frame wakes the sleeping loop */
+    EXPECT(pthread_create(&thread, NULL, producer, NULL) == 0);
+    for (n = 0; n < WAKES; n++)
+    {
+        EXPECT(OBC_IF_rx_wait(1000) == 0);
+        const uint64_t woke = now_ns();
+        EXPECT(OCB_IF_get_command_string(cmd, sizeof(cmd)) == 0);
+
+        unsigned long seq;
+        EXPECT(sscanf((const char *)cmd, "{\"seq\":%lu,", &seq) == 1);
+        EXPECT(seq == n);
+        latency_us[n] = (double)(woke - sent_ns[n]) / 1000.0;
+    }
+    EXPECT(pthread_join(thread, NULL) == 0);
+    EXPECT(OBC_IF_rx_frame_cnt() == 0);
+
+    qsort(latency_us, WAKES, sizeof(*latency_us), cmp_double);
+    const double p50 = latency_us[WAKES / 2];
+    const double p99 = latency_us[WAKES * 99 / 100];
+    const double max = latency_us[WAKES - 1];
+    EXPECT(p99 < 50000.0);
+
+    printf("timeout of 50 ms took %.2f ms\n", timeout_ms);
+    printf("idle CPU : %.1f %% polling, %.2f %% waiting\n", cpu_poll,
+           cpu_wait);
+    printf("wake up after the delimiter over %u frames : p50 %.2f us, "
+           "p99 %.2f us, max %.2f us\n",
+           WAKES, p50, p99, max);
+
+    OBC_IF_clear_config();
+    printf("PASS\n");
+    return 0;
+}
@@ -0,0 +1,191 @@
+/**
+ * @file parameters.h
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Persistent configuration and calibration parameters kept in
+ * information memory
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ * @note Parameters are read from an in-RAM cache that always holds a valid
+ * value (the compile time default until PARAM_init loads the saved
+ * values), so reading one costs the same as reading a global variable.
+ * PARAM_set only changes the cache; PARAM_commit makes the cache
+ * persistent.
+ *
+ * The store alternates between two information memory segments. A commit
+ * erases and programs the segment that does not hold the current record,
+ * so a reset or power loss during the commit leaves the previous record
+ * intact.
+ */
+#ifndef __PARAMETERS_H__
+#define __PARAMETERS_H__
+#ifdef __cplusplus
+/* clang-format off */
+extern "C"
+{
+/* clang-format on */
+#endif /* Start C linkage */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "json_writer.h"
+
+/**
+ * @brief Parameter table: X(name, type, default, min, max)
+ *
+ * type is f (float) or i (integer). Parameters are stored in table order
+ * so new parameters must be appended at the end: records written by older
+ * firmware then still load, the new parameters take their defaults.
+ *
+ * ADS7841 channels are ADS7841_CHANNEL_t values (1 == ADS7841_CHANNEL_SGL_1)
+ */
+/* clang-format off */
+#define PARAM_TABLE(X)                                                         \
+    X(mqtr_pwm_hz,  i, 1000,    20,       20000)                               \
+    X(mqtr_ma_mv,   f, 0.5f,    0.001f,   100.0f)                              \
+    X(mqtr_ch_x,    i, 1,       0,        7)                                   \
+    X(mqtr_ch_y,    i, 2,       0,        7)                                   \
+    X(mqtr_ch_z,    i, 3,       0,        7)                                   \
+    X(rw_ma_mv,     f, 0.5f,    0.001f,   100.0f)                              \
+    X(rw_rph_mv,    f, 1.0f,    0.001f,   1000.0f)                             \
+    X(rw_ch_x,      i, 1,       0,        7)                                   \
+    X(rw_ch_y,      i, 2,       0,        7)                                   \
+    X(rw_ch_z,      i, 3,       0,        7)                                   \
+    X(mag_ch_x,     i, 1,       0,        7)                                   \
+    X(mag_ch_y,     i, 2,       0,        7)                                   \
+    X(mag_ch_z,     i, 3,       0,        7)                                   \
+    X(mag_t_cnt,    f, 1.0e-7f, 1.0e-10f, 1.0e-4f)                             \
+    X(mag_zero_cnt, f, 2048.0f, 0.0f,     4095.0f)                             \
+    X(mag_off_x,    f, 0.0f,    -1.0e-3f, 1.0e-3f)                             \
+    X(mag_off_y,    f, 0.0f,    -1.0e-3f, 1.0e-3f)                             \
+    X(mag_off_z,    f, 0.0f,    -1.0e-3f, 1.0e-3f)                             \
+    X(mag_w00,      f, 1.0f,    -4.0f,    4.0f)                                \
+    X(mag_w01,      f, 0.0f,    -4.0f,    4.0f)                                \
+    X(mag_w02,      f, 0.0f,    -4.0f,    4.0f)                                \
+    X(mag_w10,      f, 0.0f,    -4.0f,    4.0f)                                \
+    X(mag_w11,      f, 1.0f,    -4.0f,    4.0f)                                \
+    X(mag_w12,      f, 0.0f,    -4.0f,    4.0f)                                \
+    X(mag_w20,      f, 0.0f,    -4.0f,    4.0f)                                \
+    X(mag_w21,      f, 0.0f,    -4.0f,    4.0f)                                \
+    X(mag_w22,      f, 1.0f,    -4.0f,    4.0f)                                \
+    X(tlm_period_ms, i, 20000,  0,        60000)
+/* clang-format on */
+
+#define PARAM_ENUM(name, type, def, min, max) PARAM_##name,
+typedef enum
+{
+    PARAM_TABLE(PARAM_ENUM)
+    PARAM_CNT,
+} PARAM_t;
+#undef PARAM_ENUM
+
+typedef union
+{
+    float   f;
+    int32_t i;
+} PARAM_value_t;
+
+typedef struct
+{
+    bool     loaded;    /* cache was loaded from a valid record */
+    bool     dirty;     /* cache differs from the saved record */
+    int      slot;      /* segment of the current record, -1 if none */
+    uint16_t seq;       /* sequence number of the current record */
+    uint16_t rejected;  /* saved values that failed the bounds check */
+    uint32_t commits;   /* since boot */
+} PARAM_status_t;
+
+
+/* The cache. Use the accessors below */
+extern PARAM_value_t PARAM_cache[PARAM_CNT];
+
+#define PARAM_get_float(p) (PARAM_cache[(p)].f)
+#define PARAM_get_int(p) (PARAM_cache[(p)].i)
+
+
+/**
+ * @brief Load the newest valid record into the cache.
+ *
+ * @note Parameters missing from the record, or whose saved value is out of
+ * bounds, keep their defaults.
+ *
+ * @return 0 if a record was loaded, 1 if every parameter is at its default
+ */
+int PARAM_init(void);
+
+
+/**
+ * @brief Change a parameter in the cache.
+ *
+ * @note Modules that only read a parameter when they initialise (e.g. the
+ * magnetorquer PWM frequency) pick the new value up on their next init.
+ *
+ * @return 0 on success, 1 if the value is out of bounds
+ */
+int PARAM_set_float(PARAM_t p, float value);
+int PARAM_set_int(PARAM_t p, int32_t value);
+
+
+/**
+ * @brief Set every parameter back to its default in the cache
+ */
+void PARAM_defaults(void);
+
+
+/**
+ * @brief Write the cache to the spare segment. It becomes the current
+ * record once it has been programmed and verified.
+ *
+ * @return 0 on success, 1 if the flash could not be erased or programmed
+ * (the previous record is still current)
+ */
+int PARAM_commit(void);
+
+
+void PARAM_get_status(PARAM_status_t *status);
+
+
+/**
+ * @brief Look a parameter up by name
+ *
+ * @return the parameter, PARAM_CNT if there is none with that name
+ */
+PARAM_t PARAM_from_string(const char *name);
+
+
+const char *PARAM_to_string(PARAM_t p);
+
+
+/**
+ * @brief Set a parameter from its text representation
+ *
+ * @return 0 on success, 1 if the text is not a number of the parameter's
+ * type or is out of bounds
+ */
+int PARAM_set_from_string(PARAM_t p, const char *value);
+
+
+/**
+ * @brief Write {"<name>":<value>}
+ *
+ * @return 0 on success, 1 if p is invalid or w is full
+ */
+int PARAM_to_json(PARAM_t p, JW_t *w);
+
+
+/**
+ * @brief Write the store status as a json object
+ *
+ * @return 0 on success, 1 if w is full
+ */
+int PARAM_status_to_json(JW_t *w);
+
+#ifdef __cplusplus
+/* clang-format off */
+}
+/* clang-format on */
+#endif /* End C linkage */
+#endif /* __PARAMETERS_H__ */
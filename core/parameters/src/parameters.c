@@ -0,0 +1,417 @@
+/**
+ * @file parameters.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Persistent configuration and calibration parameters kept in
+ * information memory
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ * @note Record layout (little endian) in an information memory segment:
+ *
+ *  0   magic
+ *  2   format version
+ *  4   sequence number, incremented by every commit
+ *  6   number of parameters n
+ *  8   n parameter values, 4 bytes each, in table order
+ *  8+4n CRC-16 over every byte before it
+ *
+ * A commit programs everything but the magic first and the magic last, so
+ * a record is only ever recognised once it is complete. The CRC catches a
+ * segment that was left half erased or half programmed by a reset.
+ */
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+
+#include "targets.h"
+#include "config_assert.h"
+#include "parameters.h"
+#include "params_nv.h"
+
+#define PARAM_MAGIC (0x5041u) /* "PA" */
+#define PARAM_FORMAT_VERSION (1u)
+
+#define PARAM_HDR_MAGIC (0u)
+#define PARAM_HDR_VERSION (2u)
+#define PARAM_HDR_SEQ (4u)
+#define PARAM_HDR_COUNT (6u)
+#define PARAM_HDR_SIZE (8u)
+#define PARAM_VALUE_SIZE (sizeof(PARAM_value_t))
+#define PARAM_CRC_SIZE (2u)
+#define PARAM_RECORD_SIZE(n)                                                   \
+    ((PARAM_HDR_SIZE) + (n) * (PARAM_VALUE_SIZE) + (PARAM_CRC_SIZE))
+
+#define PARAM_SLOT_CNT (2)
+#define PARAM_NO_SLOT (-1)
+
+_Static_assert(PARAM_RECORD_SIZE(PARAM_CNT) <= FLASH_INFO_SEGMENT_SIZE,
+               "parameter table does not fit in an information segment");
+_Static_assert(sizeof(PARAM_value_t) == 4, "parameters are stored as 4 bytes");
+
+typedef enum
+{
+    PARAM_TYPE_f,
+    PARAM_TYPE_i,
+} PARAM_TYPE_t;
+
+typedef struct
+{
+    const char   *name;
+    PARAM_TYPE_t  type;
+    PARAM_value_t def;
+    PARAM_value_t min;
+    PARAM_value_t max;
+} param_desc;
+
+
+#define PARAM_DESC(name, type, def, min, max)                                  \
+    [PARAM_##name] = {#name, PARAM_TYPE_##type, {.type = (def)},               \
+                      {.type = (min)}, {.type = (max)}},
+static const param_desc param_table[PARAM_CNT] = {PARAM_TABLE(PARAM_DESC)};
+#undef PARAM_DESC
+
+#define PARAM_DEFAULT(name, type, def, min, max)                               \
+    [PARAM_##name] = {.type = (def)},
+PARAM_value_t PARAM_cache[PARAM_CNT] = {PARAM_TABLE(PARAM_DEFAULT)};
+#undef PARAM_DEFAULT
+
+/* Slot A and slot B of the store */
+static const FLASH_INFO_t param_slots[PARAM_SLOT_CNT] = {FLASH_INFO_B,
+                                                         FLASH_INFO_C};
+
+static PARAM_status_t param_status = {.slot = PARAM_NO_SLOT};
+static uint8_t        param_record[FLASH_INFO_SEGMENT_SIZE];
+
+
+static bool     PARAM_in_bounds(PARAM_t p, PARAM_value_t v);
+static bool     PARAM_record_valid(const uint8_t *rec, uint16_t *seq,
+                                   uint16_t *count);
+static uint16_t PARAM_rd16(const uint8_t *buf);
+static void     PARAM_wr16(uint8_t *buf, uint16_t val);
+static uint16_t PARAM_crc(const uint8_t *data, size_t len);
+
+
+int PARAM_init(void)
+{
+    uint16_t     seq[PARAM_SLOT_CNT], count[PARAM_SLOT_CNT];
+    bool         valid[PARAM_SLOT_CNT];
+    int          slot = PARAM_NO_SLOT;
+    unsigned int i;
+
+    PARAM_defaults();
+    memset(&param_status, 0, sizeof(param_status));
+    param_status.slot = PARAM_NO_SLOT;
+
+    for (i = 0; i < PARAM_SLOT_CNT; i++)
+    {
+        valid[i] = PARAM_record_valid(PARAMS_NV_data(param_slots[i]), &seq[i],
+                                      &count[i]);
+        if (valid[i] && (slot == PARAM_NO_SLOT ||
+                         (int16_t)(seq[i] - seq[slot]) > 0))
+        {
+            slot = (int)i;
+        }
+    }
+    if (slot == PARAM_NO_SLOT)
+    {
+        return 1;
+    }
+
+    /* Records from older firmware hold fewer parameters */
+    const uint8_t *rec = PARAMS_NV_data(param_slots[slot]);
+    const uint16_t n   = (count[slot] < PARAM_CNT) ? count[slot] : PARAM_CNT;
+    for (i = 0; i < n; i++)
+    {
+        PARAM_value_t v;
+        memcpy(&v, &rec[PARAM_HDR_SIZE + i * PARAM_VALUE_SIZE], sizeof(v));
+        if (PARAM_in_bounds((PARAM_t)i, v))
+        {
+            PARAM_cache[i] = v;
+        }
+        else
+        {
+            param_status.rejected++;
+        }
+    }
+
+    param_status.loaded = true;
+    param_status.slot   = slot;
+    param_status.seq    = seq[slot];
+    param_status.dirty  = (param_status.rejected > 0 || n < PARAM_CNT);
+    return 0;
+}
+
+
+int PARAM_set_float(PARAM_t p, float value)
+{
+    if (p >= PARAM_CNT || param_table[p].type != PARAM_TYPE_f)
+    {
+        return 1;
+    }
+    PARAM_value_t v = {.f = value};
+    if (!PARAM_in_bounds(p, v))
+    {
+        return 1;
+    }
+    if (PARAM_cache[p].f != value)
+    {
+        PARAM_cache[p]     = v;
+        param_status.dirty = true;
+    }
+    return 0;
+}
+
+
+int PARAM_set_int(PARAM_t p, int32_t value)
+{
+    if (p >= PARAM_CNT || param_table[p].type != PARAM_TYPE_i)
+    {
+        return 1;
+    }
+    PARAM_value_t v = {.i = value};
+    if (!PARAM_in_bounds(p, v))
+    {
+        return 1;
+    }
+    if (PARAM_cache[p].i != value)
+    {
+        PARAM_cache[p]     = v;
+        param_status.dirty = true;
+    }
+    return 0;
+}
+
+
+void PARAM_defaults(void)
+{
+    unsigned int i;
+    for (i = 0; i < PARAM_CNT; i++)
+    {
+        PARAM_cache[i] = param_table[i].def;
+    }
+    param_status.dirty = true;
+}
+
+
+int PARAM_commit(void)
+{
+    const int next = (param_status.slot == 0) ? 1 : 0;
+    const FLASH_INFO_t seg  = param_slots[next];
+    const uint16_t     seq  = param_status.seq + 1;
+    const uint16_t     size = PARAM_RECORD_SIZE(PARAM_CNT);
+
+    memset(param_record, 0xFF, sizeof(param_record));
+    PARAM_wr16(&param_record[PARAM_HDR_MAGIC], PARAM_MAGIC);
+    PARAM_wr16(&param_record[PARAM_HDR_VERSION], PARAM_FORMAT_VERSION);
+    PARAM_wr16(&param_record[PARAM_HDR_SEQ], seq);
+    PARAM_wr16(&param_record[PARAM_HDR_COUNT], PARAM_CNT);
+    memcpy(&param_record[PARAM_HDR_SIZE], PARAM_cache, sizeof(PARAM_cache));
+    PARAM_wr16(&param_record[size - PARAM_CRC_SIZE],
+               PARAM_crc(param_record, size - PARAM_CRC_SIZE));
+
+    /* The magic goes in last */
+    if (PARAMS_NV_erase(seg) ||
+        PARAMS_NV_write(seg, PARAM_HDR_VERSION,
+                        &param_record[PARAM_HDR_VERSION],
+                        size - PARAM_HDR_VERSION) ||
+        PARAMS_NV_write(seg, PARAM_HDR_MAGIC, &param_record[PARAM_HDR_MAGIC],
+                        PARAM_HDR_VERSION - PARAM_HDR_MAGIC))
+    {
+        return 1;
+    }
+
+    uint16_t rd_seq, rd_count;
+    if (!PARAM_record_valid(PARAMS_NV_data(seg), &rd_seq, &rd_count) ||
+        memcmp(PARAMS_NV_data(seg), param_record, size) != 0)
+    {
+        return 1;
+    }
+
+    param_status.loaded = true;
+    param_status.slot   = next;
+    param_status.seq    = seq;
+    param_status.dirty  = false;
+    param_status.commits++;
+    return 0;
+}
+
+
+void PARAM_get_status(PARAM_status_t *status)
+{
+    CONFIG_ASSERT(NULL != status);
+    *status = param_status;
+}
+
+
+PARAM_t PARAM_from_string(const char *name)
+{
+    CONFIG_ASSERT(NULL != name);
+    unsigned int i;
+    for (i = 0; i < PARAM_CNT; i++)
+    {
+        if (strcmp(name, param_table[i].name) == 0)
+        {
+            break;
+        }
+    }
+    return (PARAM_t)i;
+}
+
+
+const char *PARAM_to_string(PARAM_t p)
+{
+    if (p >= PARAM_CNT)
+    {
+        return "unknown";
+    }
+    return param_table[p].name;
+}
+
+
+int PARAM_set_from_string(PARAM_t p, const char *value)
+{
+    CONFIG_ASSERT(NULL != value);
+    if (p >= PARAM_CNT || *value == '\0')
+    {
+        return 1;
+    }
+
+    char *endptr = NULL;
+    if (param_table[p].type == PARAM_TYPE_f)
+    {
+        float f = strtof(value, &endptr);
+        return (*endptr == '\0') ? PARAM_set_float(p, f) : 1;
+    }
+    else
+    {
+        long i = strtol(value, &endptr, 10);
+        if (*endptr != '\0' || i < param_table[p].min.i ||
+            i > param_table[p].max.i)
+        {
+            return 1;
+        }
+        return PARAM_set_int(p, (int32_t)i);
+    }
+}
+
+
+int PARAM_to_json(PARAM_t p, JW_t *w)
+{
+    CONFIG_ASSERT(NULL != w);
+    if (p >= PARAM_CNT)
+    {
+        return 1;
+    }
+
+    JW_object_begin(w);
+    JW_key(w, param_table[p].name);
+    if (param_table[p].type == PARAM_TYPE_f)
+    {
+        JW_real(w, PARAM_cache[p].f, 7);
+    }
+    else
+    {
+        JW_int(w, PARAM_cache[p].i);
+    }
+    JW_object_end(w);
+    return JW_error(w);
+}
+
+
+int PARAM_status_to_json(JW_t *w)
+{
+    CONFIG_ASSERT(NULL != w);
+    static const char *const slot_names[] = {"A", "B"};
+    JW_object_begin(w);
+    JW_key(w, "cnt");
+    JW_uint(w, PARAM_CNT);
+    JW_key(w, "loaded");
+    JW_uint(w, param_status.loaded);
+    JW_key(w, "dirty");
+    JW_uint(w, param_status.dirty);
+    JW_key(w, "slot");
+    JW_str(w, (param_status.slot == PARAM_NO_SLOT)
+                  ? "-"
+                  : slot_names[param_status.slot]);
+    JW_key(w, "seq");
+    JW_uint(w, param_status.seq);
+    JW_key(w, "rej");
+    JW_uint(w, param_status.rejected);
+    JW_key(w, "commits");
+    JW_uint(w, param_status.commits);
+    JW_object_end(w);
+    return JW_error(w);
+}
+
+
+static bool PARAM_in_bounds(PARAM_t p, PARAM_value_t v)
+{
+    const param_desc *desc = &param_table[p];
+    if (desc->type == PARAM_TYPE_f)
+    {
+        return isfinite(v.f) && v.f >= desc->min.f && v.f <= desc->max.f;
+    }
+    return v.i >= desc->min.i && v.i <= desc->max.i;
+}
+
+
+static bool PARAM_record_valid(const uint8_t *rec, uint16_t *seq,
+                               uint16_t *count)
+{
+    if (NULL == rec || PARAM_rd16(&rec[PARAM_HDR_MAGIC]) != PARAM_MAGIC ||
+        PARAM_rd16(&rec[PARAM_HDR_VERSION]) != PARAM_FORMAT_VERSION)
+    {
+        return false;
+    }
+
+    const uint16_t n = PARAM_rd16(&rec[PARAM_HDR_COUNT]);
+    if (n == 0 || PARAM_RECORD_SIZE(n) > FLASH_INFO_SEGMENT_SIZE)
+    {
+        return false;
+    }
+
+    const uint16_t crc_offset = PARAM_RECORD_SIZE(n) - PARAM_CRC_SIZE;
+    if (PARAM_rd16(&rec[crc_offset]) != PARAM_crc(rec, crc_offset))
+    {
+        return false;
+    }
+    *seq   = PARAM_rd16(&rec[PARAM_HDR_SEQ]);
+    *count = n;
+    return true;
+}
+
+
+static uint16_t PARAM_rd16(const uint8_t *buf)
+{
+    return (uint16_t)(buf[0] | ((uint16_t)buf[1] << 8));
+}
+
+
+static void PARAM_wr16(uint8_t *buf, uint16_t val)
+{
+    buf[0] = (uint8_t)(val & 0xFFu);
+    buf[1] = (uint8_t)(val >> 8);
+}
+
+
+/* CRC-16/CCITT-FALSE */
+static uint16_t PARAM_crc(const uint8_t *data, size_t len)
+{
+    uint16_t     crc = 0xFFFFu;
+    unsigned int bit;
+    while (len-- > 0)
+    {
+        crc ^= (uint16_t)(*data++) << 8;
+        for (bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x8000u) ? (uint16_t)((crc << 1) ^ 0x1021u)
+                                  : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
@@ -0,0 +1,50 @@
+/**
+ * @file params_nv.h
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Private header selecting the information memory that backs the
+ * parameter store
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ * @note The flash controller on the target, the emulated information
+ * memory when running natively.
+ */
+#ifndef __PARAMS_NV_H__
+#define __PARAMS_NV_H__
+#ifdef __cplusplus
+/* clang-format off */
+extern "C"
+{
+/* clang-format on */
+#endif /* Start C linkage */
+
+#include "flash_types.h"
+
+#if defined(TARGET_MCU)
+
+#include "flash.h"
+
+#define PARAMS_NV_data(seg) FLASH_info_segment((seg))
+#define PARAMS_NV_erase(seg) FLASH_info_erase((seg))
+#define PARAMS_NV_write(seg, offset, data, len)                                \
+    FLASH_info_write((seg), (offset), (data), (len))
+
+#else
+
+#include "flash_emulator.h"
+
+#define PARAMS_NV_data(seg) FLASH_EMU_info_segment((seg))
+#define PARAMS_NV_erase(seg) FLASH_EMU_info_erase((seg))
+#define PARAMS_NV_write(seg, offset, data, len)                                \
+    FLASH_EMU_info_write((seg), (offset), (data), (len))
+
+#endif /* #if defined(TARGET_MCU) */
+
+#ifdef __cplusplus
+/* clang-format off */
+}
+/* clang-format on */
+#endif /* End C linkage */
+#endif /* __PARAMS_NV_H__ */
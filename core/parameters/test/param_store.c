@@ -0,0 +1,337 @@
+/**
+ * @file param_store.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Parameter store tests: defaults, A/B commits, reboots through a
+ * file backed flash image, power loss during a commit and flash wear
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ */
+#if defined(TARGET_MCU)
+#error NATIVE TESTS CANNOT BE RUN ON A BARE METAL MICROCONTROLLER
+#endif /* #if defined(TARGET_MCU) */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "parameters.h"
+#include "flash_emulator.h"
+#include "test_expect.h"
+
+#define SLOT_A (FLASH_INFO_B)
+#define SLOT_B (FLASH_INFO_C)
+#define IMAGE_PATH "param_store_flash.bin"
+
+/* Layout from parameters.c, used to hand build records */
+#define RECORD_MAGIC (0x5041u)
+#define RECORD_VERSION (1u)
+#define RECORD_SIZE(n) (8u + 4u * (n) + 2u)
+
+
+static uint16_t crc16(const uint8_t *data, size_t len)
+{
+    uint16_t     crc = 0xFFFFu;
+    unsigned int bit;
+    while (len-- > 0)
+    {
+        crc ^= (uint16_t)(*data++) << 8;
+        for (bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x8000u) ? (uint16_t)((crc << 1) ^ 0x1021u)
+                                  : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+
+static void put16(uint8_t *buf, uint16_t val)
+{
+    buf[0] = (uint8_t)(val & 0xFFu);
+    buf[1] = (uint8_t)(val >> 8);
+}
+
+
+/* Program a record holding the first n parameters of values into seg */
+static int write_record(FLASH_INFO_t seg, uint16_t version, uint16_t seq,
+                        const PARAM_value_t *values, uint16_t n)
+{
+    uint8_t rec[FLASH_INFO_SEGMENT_SIZE];
+    put16(&rec[0], RECORD_MAGIC);
+    put16(&rec[2], version);
+    put16(&rec[4], seq);
+    put16(&rec[6], n);
+    memcpy(&rec[8], values, 4u * n);
+    put16(&rec[8 + 4u * n], crc16(rec, 8 + 4u * n));
+    if (FLASH_EMU_info_erase(seg))
+    {
+        return 1;
+    }
+    return FLASH_EMU_info_write(seg, 0, rec, RECORD_SIZE(n));
+}
+
+
+/* Commit with the power failing after budget byte operations, then reboot
+ * and check that either the old or the new value was loaded */
+static int power_loss_commit(uint32_t budget, int *committed)
+{
+    PARAM_status_t status;
+    FLASH_EMU_init();
+    PARAM_init();
+    if (PARAM_set_float(PARAM_rw_ma_mv, 1.0f) || PARAM_commit() ||
+        PARAM_set_float(PARAM_rw_ma_mv, 2.0f) || PARAM_commit())
+    {
+        return 1;
+    }
+
+    PARAM_set_float(PARAM_rw_ma_mv, 3.0f);
+    PARAM_set_int(PARAM_mqtr_pwm_hz, 500);
+    FLASH_EMU_power_loss_after(budget);
+    *committed = (PARAM_commit() == 0);
+    if (*committed == FLASH_EMU_power_lost())
+    {
+        return 1; /* must fail exactly when the power was lost */
+    }
+    FLASH_EMU_power_restore();
+
+    if (PARAM_init() != 0)
+    {
+        return 1;
+    }
+    PARAM_get_status(&status);
+    if (*committed)
+    {
+        return !(PARAM_get_float(PARAM_rw_ma_mv) == 3.0f &&
+                 PARAM_get_int(PARAM_mqtr_pwm_hz) == 500 && status.seq == 3);
+    }
+    return !(PARAM_get_float(PARAM_rw_ma_mv) == 2.0f &&
+             PARAM_get_int(PARAM_mqtr_pwm_hz) == 1000 && status.seq == 2);
+}
+
+
+int main(void)
+{
+    PARAM_status_t status;
+    PARAM_value_t  defaults[PARAM_CNT];
+    char           buf[100];
+    unsigned int   i;
+    uint32_t       budget;
+
+    memcpy(defaults, PARAM_cache, sizeof(defaults));
+    FLASH_EMU_init();
+
+    /* Blank flash: defaults, nothing loaded */
+    EXPECT(PARAM_init() == 1);
+    PARAM_get_status(&status);
+    EXPECT(!status.loaded && !status.dirty && status.slot == -1);
+    EXPECT(memcmp(defaults, PARAM_cache, sizeof(defaults)) == 0);
+    EXPECT(PARAM_get_int(PARAM_mqtr_pwm_hz) == 1000);
+    EXPECT(PARAM_get_float(PARAM_mag_w11) == 1.0f);
+
+    /* Type and bounds checks leave the cache alone */
+    EXPECT(PARAM_set_float(PARAM_mqtr_pwm_hz, 1.0f) == 1);
+    EXPECT(PARAM_set_int(PARAM_rw_ma_mv, 1) == 1);
+    EXPECT(PARAM_set_int(PARAM_mqtr_pwm_hz, 19) == 1);
+    EXPECT(PARAM_set_int(PARAM_mqtr_pwm_hz, 20001) == 1);
+    EXPECT(PARAM_set_float(PARAM_rw_ma_mv, NAN) == 1);
+    EXPECT(PARAM_set_float(PARAM_rw_ma_mv, INFINITY) == 1);
+    EXPECT(PARAM_set_float(PARAM_rw_ma_mv, 0.0f) == 1);
+    EXPECT(PARAM_set_int(PARAM_CNT, 1) == 1);
+    PARAM_get_status(&status);
+    EXPECT(!status.dirty);
+    EXPECT(memcmp(defaults, PARAM_cache, sizeof(defaults)) == 0);
+
+    /* Names and text values */
+    EXPECT(PARAM_from_string("rw_rph_mv") == PARAM_rw_rph_mv);
+    EXPECT(PARAM_from_string("rw_rph") == PARAM_CNT);
+    EXPECT(strcmp(PARAM_to_string(PARAM_mag_ch_z), "mag_ch_z") == 0);
+    EXPECT(PARAM_set_from_string(PARAM_rw_rph_mv, "2.5") == 0);
+    EXPECT(PARAM_get_float(PARAM_rw_rph_mv) == 2.5f);
+    EXPECT(PARAM_set_from_string(PARAM_rw_ch_x, "4") == 0);
+    EXPECT(PARAM_get_int(PARAM_rw_ch_x) == 4);
+    EXPECT(PARAM_set_from_string(PARAM_rw_ch_x, "4.5") == 1);
+    EXPECT(PARAM_set_from_string(PARAM_rw_ch_x, "8") == 1);
+    EXPECT(PARAM_set_from_string(PARAM_rw_ch_x, "99999999999999") == 1);
+    EXPECT(PARAM_set_from_string(PARAM_rw_rph_mv, "fast") == 1);
+    EXPECT(PARAM_set_from_string(PARAM_rw_rph_mv, "") == 1);
+    EXPECT(PARAM_get_int(PARAM_rw_ch_x) == 4);
+    PARAM_get_status(&status);
+    EXPECT(status.dirty);
+
+    /* Commits alternate between the slots and survive a reboot */
+    EXPECT(PARAM_commit() == 0);
+    PARAM_get_status(&status);
+    EXPECT(status.slot == 0 && status.seq == 1 && !status.dirty);
+    EXPECT(FLASH_EMU_erase_count(SLOT_A) == 1);
+    EXPECT(FLASH_EMU_erase_count(SLOT_B) == 0);
+    EXPECT(PARAM_set_int(PARAM_mqtr_pwm_hz, 250) == 0);
+    EXPECT(PARAM_commit() == 0);
+    PARAM_get_status(&status);
+    EXPECT(status.slot == 1 && status.seq == 2 && status.commits == 2);
+    EXPECT(FLASH_EMU_erase_count(SLOT_B) == 1);
+
+    PARAM_defaults();
+    EXPECT(PARAM_init() == 0);
+    PARAM_get_status(&status);
+    EXPECT(status.loaded && !status.dirty && status.slot == 1);
+    EXPECT(status.seq == 2 && status.rejected == 0);
+    EXPECT(PARAM_get_int(PARAM_mqtr_pwm_hz) == 250);
+    EXPECT(PARAM_get_int(PARAM_rw_ch_x) == 4);
+    EXPECT(PARAM_get_float(PARAM_rw_rph_mv) == 2.5f);
+
+    /* A corrupted newest record falls back to the older one */
+    const uint8_t zero = 0;
+    EXPECT(FLASH_EMU_info_write(SLOT_B, 20, &zero, 1) == 0);
+    EXPECT(PARAM_init() == 0);
+    PARAM_get_status(&status);
+    EXPECT(status.slot == 0 && status.seq == 1);
+    EXPECT(PARAM_get_int(PARAM_mqtr_pwm_hz) == 1000);
+    EXPECT(PARAM_commit() == 0); /* overwrites the corrupted slot */
+    PARAM_get_status(&status);
+    EXPECT(status.slot == 1 && status.seq == 2);
+
+    /* Sequence numbers compare across the 16 bit wrap */
+    EXPECT(write_record(SLOT_A, RECORD_VERSION, 0xFFFFu, defaults, PARAM_CNT) ==
+           0);
+    EXPECT(write_record(SLOT_B, RECORD_VERSION, 0x0000u, PARAM_cache,
+                        PARAM_CNT) == 0);
+    EXPECT(PARAM_init() == 0);
+    PARAM_get_status(&status);
+    EXPECT(status.slot == 1 && status.seq == 0);
+    EXPECT(PARAM_get_int(PARAM_rw_ch_x) == 4);
+
+    /* Records from older firmware hold a prefix of the table */
+    PARAM_value_t values[PARAM_CNT];
+    memcpy(values, defaults, sizeof(values));
+    values[PARAM_mqtr_pwm_hz].i = 400;
+    values[PARAM_rw_rph_mv].f   = 7.0f;
+    values[PARAM_mag_t_cnt].f   = 2.0e-7f; /* beyond the old record */
+    FLASH_EMU_init();
+    EXPECT(write_record(SLOT_B, RECORD_VERSION, 7, values, PARAM_rw_ch_x) ==
+           0);
+    EXPECT(PARAM_init() == 0);
+    PARAM_get_status(&status);
+    EXPECT(status.loaded && status.dirty && status.rejected == 0);
+    EXPECT(PARAM_get_int(PARAM_mqtr_pwm_hz) == 400);
+    EXPECT(PARAM_get_float(PARAM_rw_rph_mv) == 7.0f);
+    EXPECT(PARAM_get_float(PARAM_mag_t_cnt) == defaults[PARAM_mag_t_cnt].f);
+
+    /* Out of bounds values keep their defaults */
+    values[PARAM_mqtr_ch_y].i = 12;
+    EXPECT(write_record(SLOT_B, RECORD_VERSION, 8, values, PARAM_CNT) == 0);
+    EXPECT(PARAM_init() == 0);
+    PARAM_get_status(&status);
+    EXPECT(status.rejected == 1 && status.dirty);
+    EXPECT(PARAM_get_int(PARAM_mqtr_ch_y) == defaults[PARAM_mqtr_ch_y].i);
+    EXPECT(PARAM_get_float(PARAM_mag_t_cnt) == 2.0e-7f);
+
+    /* Records of another format version are ignored */
+    values[PARAM_mqtr_ch_y] = defaults[PARAM_mqtr_ch_y];
+    EXPECT(write_record(SLOT_B, RECORD_VERSION + 1, 9, values, PARAM_CNT) ==
+           0);
+    EXPECT(PARAM_init() == 1);
+    EXPECT(memcmp(defaults, PARAM_cache, sizeof(defaults)) == 0);
+
+    /* Reboot through a file backed image */
+    remove(IMAGE_PATH);
+    FLASH_EMU_init();
+    EXPECT(FLASH_EMU_attach_file(IMAGE_PATH) == 0);
+    EXPECT(PARAM_init() == 1);
+    EXPECT(PARAM_set_float(PARAM_mag_off_y, -2.0e-5f) == 0);
+    EXPECT(PARAM_commit() == 0);
+    EXPECT(PARAM_set_int(PARAM_mag_ch_x, 6) == 0);
+    EXPECT(PARAM_commit() == 0);
+    FLASH_EMU_detach_file();
+    FLASH_EMU_init(); /* power cycle: RAM image is blank */
+    EXPECT(PARAM_init() == 1);
+    EXPECT(FLASH_EMU_attach_file(IMAGE_PATH) == 0);
+    EXPECT(PARAM_init() == 0);
+    PARAM_get_status(&status);
+    EXPECT(status.seq == 2 && status.slot == 1);
+    EXPECT(PARAM_get_float(PARAM_mag_off_y) == -2.0e-5f);
+    EXPECT(PARAM_get_int(PARAM_mag_ch_x) == 6);
+    FLASH_EMU_detach_file();
+    EXPECT(remove(IMAGE_PATH) == 0);
+
+    /* Power loss at every byte of a commit: one erase of the spare slot
+     * plus the record */
+    int committed = 0, old_cnt = 0, new_cnt = 0;
+    for (budget = 0;
+         budget <= FLASH_INFO_SEGMENT_SIZE + RECORD_SIZE(PARAM_CNT) + 1;
+         budget++)
+    {
+        if (power_loss_commit(budget, &committed))
+        {
+            printf("power loss after %lu byte operations\n",
+                   (unsigned long)budget);
+            EXPECT(0);
+        }
+        committed ? new_cnt++ : old_cnt++;
+    }
+    printf("power loss sweep : %d old, %d new\n", old_cnt, new_cnt);
+    EXPECT(old_cnt == FLASH_INFO_SEGMENT_SIZE + RECORD_SIZE(PARAM_CNT));
+    EXPECT(new_cnt == 2);
+
+    /* A failed commit can be retried without a reboot */
+    FLASH_EMU_init();
+    PARAM_init();
+    EXPECT(PARAM_set_int(PARAM_rw_ch_z, 5) == 0);
+    FLASH_EMU_power_loss_after(FLASH_INFO_SEGMENT_SIZE / 2);
+    EXPECT(PARAM_commit() == 1);
+    FLASH_EMU_power_restore();
+    PARAM_get_status(&status);
+    EXPECT(status.dirty && !status.loaded);
+    EXPECT(PARAM_commit() == 0);
+    EXPECT(PARAM_init() == 0);
+    EXPECT(PARAM_get_int(PARAM_rw_ch_z) == 5);
+
+    /* Wear is spread evenly over both slots */
+    FLASH_EMU_init();
+    PARAM_init();
+    for (i = 0; i < 1000; i++)
+    {
+        EXPECT(PARAM_set_float(PARAM_rw_ma_mv, 1.0f + (float)(i % 7)) == 0);
+        EXPECT(PARAM_commit() == 0);
+    }
+    EXPECT(FLASH_EMU_erase_count(SLOT_A) == 500);
+    EXPECT(FLASH_EMU_erase_count(SLOT_B) == 500);
+    EXPECT(FLASH_EMU_erase_count(FLASH_INFO_D) == 0);
+
+    /* A worn out segment fails the commit but the last record survives */
+    while (PARAM_commit() == 0)
+    {
+    }
+    PARAM_get_status(&status);
+    printf("worn out after %lu commits\n", (unsigned long)status.commits);
+    EXPECT(status.commits == 2 * FLASH_EMU_ENDURANCE_CYCLES);
+    EXPECT(FLASH_EMU_erase_count(SLOT_A) == FLASH_EMU_ENDURANCE_CYCLES);
+    const float last = PARAM_get_float(PARAM_rw_ma_mv);
+    EXPECT(PARAM_init() == 0);
+    EXPECT(PARAM_get_float(PARAM_rw_ma_mv) == last);
+
+    /* Replies fit in the OBC buffers */
+    JW_t jw;
+    for (i = 0; i < PARAM_CNT; i++)
+    {
+        JW_init(&jw, buf, sizeof(buf));
+        EXPECT(PARAM_to_json((PARAM_t)i, &jw) == 0);
+        EXPECT(JW_finish(&jw) == 0);
+    }
+    EXPECT(PARAM_set_float(PARAM_mag_t_cnt, 1.2345678e-10f) == 0);
+    JW_init(&jw, buf, sizeof(buf));
+    EXPECT(PARAM_to_json(PARAM_mag_t_cnt, &jw) == 0);
+    EXPECT(JW_finish(&jw) == 0);
+    printf("%s\n", buf);
+    EXPECT(strcmp(buf, "{\"mag_t_cnt\":1.234568e-10}") == 0);
+    EXPECT(PARAM_to_json(PARAM_CNT, &jw) == 1);
+    JW_init(&jw, buf, sizeof(buf));
+    EXPECT(PARAM_status_to_json(&jw) == 0);
+    EXPECT(JW_finish(&jw) == 0);
+    printf("%s\n", buf);
+    return 0;
+}
@@ -0,0 +1,143 @@
+/**
+ * @file profiling.h
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Execution time probes accumulating min / max / mean / count per
+ * probe, read back by the OBC with {"prof":"read"}
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ * @note The probes are only built in with ADCS_PROFILING defined (cmake
+ * -DPROFILING=ON). Without it PROF_BEGIN and PROF_END expand to nothing and
+ * the table does not exist.
+ *
+ * A probe takes the free running timer on entry and exit of its scope. On
+ * the target that is the SYSTICK cycle count (SMCLK), natively the monotonic
+ * clock in nanoseconds. PROF_init measures what an empty probe costs, the
+ * call to PROF_record included, and every duration is recorded without it.
+ * A probe that encloses other probes includes what recording them costs.
+ *
+ * Durations are 32 bit ticks, a scope must not run longer than 2^32 ticks
+ * (65 minutes on the target, 4 seconds natively).
+ *
+ * With ADCS_ISS_MARKERS defined instead (cmake -DISS_MARKERS=ON) the probes
+ * are calls to PROF_mark_begin and PROF_mark_end for a build that runs under
+ * an instruction set simulator. iss_bench.py breaks on them and counts the
+ * simulated cycles between the two marks of a probe, there is no table.
+ */
+#ifndef __PROFILING_H__
+#define __PROFILING_H__
+#ifdef __cplusplus
+/* clang-format off */
+extern "C"
+{
+/* clang-format on */
+#endif /* Start C linkage */
+
+#include <stdint.h>
+
+#include "json_writer.h"
+
+typedef enum
+{
+    PROF_json_parse,  /* one command frame */
+    PROF_ads7841,     /* conversions of one chip select */
+    PROF_obc_rx_isr,  /* one byte from the OBC uart */
+    PROF_tick_isr,    /* millisecond tick and the timers it fires */
+    PROF_mode_run,    /* one pass of the mode scheduler */
+    PROF_imu_acquire, /* IMU burst read pacing */
+    PROF_control,     /* one attitude control step */
+    PROF_cnt,         /* must be last */
+} PROF_PROBE_t;
+
+typedef struct
+{
+    uint32_t n;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+} PROF_stats_t;
+
+#if defined(ADCS_ISS_MARKERS)
+
+#define PROF_BEGIN(probe) PROF_mark_begin(probe)
+#define PROF_END(probe) PROF_mark_end(probe)
+
+/* PROF_init marks it back to back, the cycles a pair of marks costs */
+#define PROF_MARK_OVERHEAD (0xFFFFu)
+
+/**
+ * @brief Marks the simulator harness breaks on. The id is a PROF_PROBE_t in
+ * the firmware, the micro benchmarks number their own.
+ */
+void PROF_mark_begin(uint16_t id);
+void PROF_mark_end(uint16_t id);
+
+#elif defined(ADCS_PROFILING)
+
+/**
+ * @brief Time the rest of the enclosing block up to PROF_END of the same
+ * probe. Declares a variable, at most one PROF_BEGIN of a probe per block.
+ */
+#define PROF_BEGIN(probe) const uint32_t prof_start_##probe = PROF_now()
+#define PROF_END(probe) PROF_record((probe), prof_start_##probe)
+
+/**
+ * @brief Read the free running timer, in PROF_hz ticks
+ */
+uint32_t PROF_now(void);
+
+/**
+ * @brief Count the ticks from start to now against probe
+ */
+void PROF_record(PROF_PROBE_t probe, uint32_t start);
+
+/**
+ * @brief Take a copy of the counters of probe
+ */
+void PROF_get_stats(PROF_PROBE_t probe, PROF_stats_t *stats);
+
+/**
+ * @brief Ticks per second of the timer the probes take
+ */
+uint32_t PROF_hz(void);
+
+/**
+ * @brief Ticks taken by the probe itself, removed from every duration
+ */
+uint32_t PROF_overhead(void);
+
+#else
+
+#define PROF_BEGIN(probe)
+#define PROF_END(probe)
+
+#endif /* #if defined(ADCS_ISS_MARKERS) */
+
+/**
+ * @brief Clear the table and measure the probe overhead. Natively usable
+ * anytime, on the target only once SYSTICK runs.
+ */
+void PROF_init(void);
+
+/**
+ * @brief Clear the counters of every probe
+ */
+void PROF_reset(void);
+
+/**
+ * @brief Write the table as
+ * {"hz":1100000,"oh":30,"probes":{"json_parse":[n,min,max,mean],...}}
+ * in ticks, or the string "off" if the probes are not built in
+ *
+ * @return int 0 on success, 1 if the writer overflowed
+ */
+int PROF_to_json(JW_t *w);
+
+#ifdef __cplusplus
+/* clang-format off */
+}
+/* clang-format on */
+#endif /* End C linkage */
+#endif /* __PROFILING_H__ */
@@ -0,0 +1,245 @@
+/**
+ * @file profiling.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Execution time probes and their table
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ * @note Probes record from the uart and tick interrupts as well as from the
+ * main loop. On the target the table is updated and read with interrupts
+ * masked. Natively the OBC bytes come in on the emulator thread, a read can
+ * see a half updated entry of that probe.
+ *
+ * The marks of the simulator build are kept out of line and store different
+ * variables, so the compiler neither drops nor merges them.
+ */
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "targets.h"
+#include "config_assert.h"
+#include "json_writer.h"
+#include "profiling.h"
+
+#if defined(ADCS_ISS_MARKERS)
+
+/* The last marks, for a look with the debugger */
+static volatile uint16_t prof_mark_open;
+static volatile uint16_t prof_mark_closed;
+
+
+void PROF_init(void)
+{
+    PROF_mark_begin(PROF_MARK_OVERHEAD);
+    PROF_mark_end(PROF_MARK_OVERHEAD);
+}
+
+
+void PROF_reset(void)
+{
+}
+
+
+__attribute__((noinline)) void PROF_mark_begin(uint16_t id)
+{
+    prof_mark_open = id;
+}
+
+
+__attribute__((noinline)) void PROF_mark_end(uint16_t id)
+{
+    prof_mark_closed = id;
+}
+
+
+int PROF_to_json(JW_t *w)
+{
+    CONFIG_ASSERT(NULL != w);
+    JW_str(w, "off");
+    return JW_error(w);
+}
+
+#elif defined(ADCS_PROFILING)
+
+#if defined(TARGET_MCU)
+#include <msp430.h>
+
+#include "clocks.h"
+#include "systick.h"
+
+#define PROF_HZ (SMCLK_FREQ)
+
+#define PROF_LOCK()                                                            \
+    uint16_t prof_irq_state = __get_interrupt_state();                         \
+    __disable_interrupt()
+#define PROF_UNLOCK() __set_interrupt_state(prof_irq_state)
+
+#else
+#include <time.h>
+
+#define PROF_HZ (1000000000ul)
+
+#define PROF_LOCK()
+#define PROF_UNLOCK()
+
+#endif /* #if defined(TARGET_MCU) */
+
+/* Empty probes timed to find the probe overhead */
+#define PROF_CALIBRATION_PAIRS (16u)
+
+static const char *const prof_names[PROF_cnt] = {
+    [PROF_json_parse]  = "json_parse",
+    [PROF_ads7841]     = "ads7841",
+    [PROF_obc_rx_isr]  = "obc_rx_isr",
+    [PROF_tick_isr]    = "tick_isr",
+    [PROF_mode_run]    = "mode_run",
+    [PROF_imu_acquire] = "imu_acquire",
+    [PROF_control]     = "control",
+};
+
+static PROF_stats_t prof_table[PROF_cnt];
+static uint32_t     prof_overhead;
+
+
+void PROF_init(void)
+{
+    uint8_t i;
+
+    /* The cheapest of a few empty probes, an interrupt may land in any one.
+     * They go through PROF_record like any other, so the call is part of
+     * the overhead. Any probe does, a real scope is never shorter */
+    prof_overhead = 0;
+    PROF_reset();
+    for (i = 0; i < PROF_CALIBRATION_PAIRS; i++)
+    {
+        PROF_BEGIN(PROF_control);
+        PROF_END(PROF_control);
+    }
+    prof_overhead = prof_table[PROF_control].min;
+    PROF_reset();
+}
+
+
+void PROF_reset(void)
+{
+    PROF_PROBE_t probe;
+    PROF_LOCK();
+    for (probe = 0; probe < PROF_cnt; probe++)
+    {
+        memset(&prof_table[probe], 0, sizeof(prof_table[probe]));
+        prof_table[probe].min = UINT32_MAX;
+    }
+    PROF_UNLOCK();
+}
+
+
+uint32_t PROF_now(void)
+{
+#if defined(TARGET_MCU)
+    return (uint32_t)SYSTICK_get_cycles();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * PROF_HZ + (uint64_t)ts.tv_nsec);
+#endif /* #if defined(TARGET_MCU) */
+}
+
+
+void PROF_record(PROF_PROBE_t probe, uint32_t start)
+{
+    uint32_t ticks = PROF_now() - start;
+    ticks          = (ticks > prof_overhead) ? ticks - prof_overhead : 0;
+
+    CONFIG_ASSERT(probe < PROF_cnt);
+    PROF_stats_t *entry = &prof_table[probe];
+    PROF_LOCK();
+    entry->n++;
+    entry->sum += ticks;
+    if (ticks < entry->min)
+    {
+        entry->min = ticks;
+    }
+    if (ticks > entry->max)
+    {
+        entry->max = ticks;
+    }
+    PROF_UNLOCK();
+}
+
+
+void PROF_get_stats(PROF_PROBE_t probe, PROF_stats_t *stats)
+{
+    CONFIG_ASSERT(probe < PROF_cnt);
+    CONFIG_ASSERT(NULL != stats);
+    PROF_LOCK();
+    *stats = prof_table[probe];
+    PROF_UNLOCK();
+}
+
+
+uint32_t PROF_hz(void)
+{
+    return PROF_HZ;
+}
+
+
+uint32_t PROF_overhead(void)
+{
+    return prof_overhead;
+}
+
+
+int PROF_to_json(JW_t *w)
+{
+    CONFIG_ASSERT(NULL != w);
+    JW_object_begin(w);
+    JW_key(w, "hz");
+    JW_uint(w, PROF_HZ);
+    JW_key(w, "oh");
+    JW_uint(w, prof_overhead);
+    JW_key(w, "probes");
+    JW_object_begin(w);
+
+    PROF_PROBE_t probe;
+    for (probe = 0; probe < PROF_cnt; probe++)
+    {
+        PROF_stats_t s;
+        PROF_get_stats(probe, &s);
+        JW_key(w, prof_names[probe]);
+        JW_array_begin(w);
+        JW_uint(w, s.n);
+        JW_uint(w, (s.n > 0) ? s.min : 0);
+        JW_uint(w, s.max);
+        JW_uint(w, (s.n > 0) ? (uint32_t)(s.sum / s.n) : 0);
+        JW_array_end(w);
+    }
+
+    JW_object_end(w);
+    JW_object_end(w);
+    return JW_error(w);
+}
+
+#else
+
+
+void PROF_init(void)
+{
+}
+
+
+void PROF_reset(void)
+{
+}
+
+
+int PROF_to_json(JW_t *w)
+{
+    CONFIG_ASSERT(NULL != w);
+    JW_str(w, "off");
+    return JW_error(w);
+}
+
+#endif /* #if defined(ADCS_ISS_MARKERS) */
@@ -0,0 +1,139 @@
+/**
+ * @file probe_table.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Test the execution time probes: durations land in the table of
+ * their probe without the probe overhead, and the table reads back as json
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ */
+#if defined(TARGET_MCU)
+#error NATIVE TESTS CANNOT BE RUN ON A BARE METAL MICROCONTROLLER
+#endif /* #if defined(TARGET_MCU) */
+
+#if !defined(ADCS_PROFILING)
+#error THE PROBES ARE TESTED BUILT IN
+#endif /* #if !defined(ADCS_PROFILING) */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "profiling.h"
+#include "json_writer.h"
+#include "test_expect.h"
+
+#define NS_PER_MS (1000000ul)
+#define SLEEPS (5u)
+
+/* What an empty scope may still take once the overhead is removed: the
+ * calibration keeps the cheapest of a few probes, not of these */
+#define EMPTY_MAX_NS (1000ul)
+
+/* Sleeping never wakes early. Late by the host scheduling, a lot later
+ * under valgrind */
+#define LATE_MAX_NS (50ul * NS_PER_MS)
+
+
+static void sleep_ms(uint32_t ms)
+{
+    const struct timespec ts = {
+        .tv_sec  = 0,
+        .tv_nsec = (long)(ms * NS_PER_MS),
+    };
+    nanosleep(&ts, NULL);
+}
+
+
+/* Probes in a scope with an early exit, only the path that ends the probe
+ * counts */
+static int timed(uint32_t ms)
+{
+    PROF_BEGIN(PROF_control);
+    if (ms == 0)
+    {
+        return 1;
+    }
+    sleep_ms(ms);
+    PROF_END(PROF_control);
+    return 0;
+}
+
+
+int main(void)
+{
+    PROF_stats_t s;
+
+    PROF_init();
+    EXPECT(PROF_hz() == 1000000000ul);
+    EXPECT(PROF_overhead() < NS_PER_MS);
+    for (int p = 0; p < PROF_cnt; p++)
+    {
+        PROF_get_stats((PROF_PROBE_t)p, &s);
+        EXPECT(s.n == 0);
+        EXPECT(s.max == 0);
+    }
+
+    /* An empty scope costs next to nothing once the overhead is removed */
+    for (int i = 0; i < 100; i++)
+    {
+        PROF_BEGIN(PROF_tick_isr);
+        PROF_END(PROF_tick_isr);
+    }
+    PROF_get_stats(PROF_tick_isr, &s);
+    EXPECT(s.n == 100);
+    EXPECT(s.min <= EMPTY_MAX_NS);
+    EXPECT(s.max < NS_PER_MS);
+
+    /* Durations of 1 to SLEEPS ms */
+    for (uint32_t ms = 1; ms <= SLEEPS; ms++)
+    {
+        EXPECT(timed(ms) == 0);
+    }
+    EXPECT(timed(0) == 1);
+    PROF_get_stats(PROF_control, &s);
+    EXPECT(s.n == SLEEPS);
+    EXPECT(s.min >= 1u * NS_PER_MS);
+    EXPECT(s.min <= 1u * NS_PER_MS + LATE_MAX_NS);
+    EXPECT(s.max >= SLEEPS * NS_PER_MS);
+    EXPECT(s.max <= SLEEPS * NS_PER_MS + LATE_MAX_NS);
+    const uint64_t sum_ms = SLEEPS * (SLEEPS + 1u) / 2u;
+    EXPECT(s.sum >= sum_ms * NS_PER_MS);
+    EXPECT(s.sum <= sum_ms * NS_PER_MS + SLEEPS * LATE_MAX_NS);
+
+    /* The other probes are untouched */
+    PROF_get_stats(PROF_json_parse, &s);
+    EXPECT(s.n == 0);
+
+    /* {"hz":..,"oh":..,"probes":{"json_parse":[n,min,max,mean],...}} */
+    char buf[512];
+    JW_t w;
+    JW_init(&w, buf, sizeof(buf));
+    EXPECT(PROF_to_json(&w) == 0);
+    EXPECT(JW_finish(&w) == 0);
+    printf("%s\n", buf);
+    EXPECT(strncmp(buf, "{\"hz\":1000000000,\"oh\":", 22) == 0);
+    EXPECT(strstr(buf, "\"json_parse\":[0,0,0,0]") != NULL);
+    EXPECT(strstr(buf, "\"tick_isr\":[100,") != NULL);
+    EXPECT(strstr(buf, "\"control\":[5,") != NULL);
+
+    /* The table does not fit, the writer says so */
+    JW_init(&w, buf, 32);
+    EXPECT(PROF_to_json(&w) != 0);
+
+    PROF_reset();
+    PROF_get_stats(PROF_control, &s);
+    EXPECT(s.n == 0);
+    EXPECT(s.sum == 0);
+    JW_init(&w, buf, sizeof(buf));
+    EXPECT(PROF_to_json(&w) == 0);
+    EXPECT(JW_finish(&w) == 0);
+    EXPECT(strstr(buf, "\"control\":[0,0,0,0]") != NULL);
+
+    printf("PASS\n");
+    return 0;
+}
@@ -10,6 +10,7 @@ extern "C"
 #include <stdint.h>
 #include "pwm.h"
 #include "rotational_directions.h"
+#include "json_writer.h"
 
 #define NUM_REACTION_WHEELS ((unsigned int)(3))
 
@@ -22,12 +23,33 @@ typedef enum
 
 void RW_init(void);
 
-void RW_set_speed_rph(REAC_WHEEL_t rw, int rph); /* rph == radians per hour */
-
-int RW_config_to_string(char *buf, int buflen);
+/* rph == radians per hour */
+void RW_set_speed_rph(REAC_WHEEL_t rw, int32_t rph);
+
+/**
+ * @brief Speed timed by the OUTFG tachometer between its last two edges,
+ * signed with the direction of the last speed command
+ *
+ * @return int 0 on success, 1 if fewer than two edges came since the previous
+ * call (stopped, or too slow to time at the caller's rate) and rph is 0
+ */
+int RW_get_speed_rph(REAC_WHEEL_t rw, int32_t *rph);
+
+/**
+ * @brief Write the wheel voltage setpoints in mV as a json array
+ *
+ * @return int 0 on success, 1 if w is full
+ */
+int RW_config_to_json(JW_t *w);
 
 int RW_measure_current_ma(REAC_WHEEL_t wheel);
 
+/**
+ * @brief Direction of the last speed command, anticlockwise for a positive
+ * speed. The pwm output carries only the magnitude of the command
+ */
+ROT_DIR_t RW_get_direction(REAC_WHEEL_t rw);
+
 
 #ifdef __cplusplus
 /* clang-format off */
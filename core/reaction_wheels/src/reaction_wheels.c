@@ -12,51 +12,99 @@
 #include <limits.h>
 #include <assert.h>
 #include <string.h>
-#include <stdio.h>
 
 #include "targets.h"
 #include "reaction_wheels.h"
+#include "parameters.h"
+#include "hal.h"
+#include "hal_ads7841.h"
+#include "replay.h"
 
 #if defined(TARGET_MCU)
-#include "ads7841e.h"
 #include <msp430.h>
-#include "timer_a.h"
-#include "pwm.h"
+
+/* The tachometer edges are timed in the TB0 interrupt */
+#define RW_TACH_LOCK()                                                         \
+    uint16_t rw_irq_state = __get_interrupt_state();                           \
+    __disable_interrupt()
+#define RW_TACH_UNLOCK() __set_interrupt_state(rw_irq_state)
+
 #else
+
+/* The simulated edges are given in the caller's context */
+#define RW_TACH_LOCK()
+#define RW_TACH_UNLOCK()
+
 #endif /* #if defined(TARGET_MCU) */
 
-#define TIMER_CM_MSK (((CM0) | (CM1)))
-#define TIMER_CM_NO_CAPT ((TIMER_CM_MSK) & (CM_0))
-#define TIMER_CM_CAP_RISE ((TIMER_CM_MSK) & (CM_1))
-#define TIMER_CM_CAP_FALL ((TIMER_CM_MSK) & (CM_2))
-#define TIMER_CM_CAP_EDGE ((TIMER_CM_MSK) & (CM_3))
+/** @note PINOUT:
+ * P3.5 : RW_X_SPEED_CTRL (TB0.5)    P3.6 : RW_X_OUTFG (TB0.6)
+ * P2.4 : RW_Y_SPEED_CTRL (TA2.1)    P5.7 : RW_Y_OUTFG (TB0.1)
+ * P2.5 : RW_Z_SPEED_CTRL (TA2.2)    P7.4 : RW_Z_OUTFG (TB0.2)
+ * P5.0 : CS of the current sense ADS7841 (active low)
+ */
+
+/* Current measurement channels, calibrated through the parameter store
+ * (rw_ch_*) along with the conversion factors rw_ma_mv and rw_rph_mv */
+#define REAC_WHEEL_ADS7841_CHANNEL_x ((uint8_t)PARAM_get_int(PARAM_rw_ch_x))
+#define REAC_WHEEL_ADS7841_CHANNEL_y ((uint8_t)PARAM_get_int(PARAM_rw_ch_y))
+#define REAC_WHEEL_ADS7841_CHANNEL_z ((uint8_t)PARAM_get_int(PARAM_rw_ch_z))
+
+/** @todo UPDATE WITH THE WHEEL DRIVER DATASHEET. BOTH EDGES OF OUTFG ARE
+ * CAPTURED SO THIS IS TWICE THE OUTFG PULSES PER REVOLUTION */
+#define RW_OUTFG_EDGES_PER_REV (6u)
+#define RW_RPH_PER_REV_PER_S (2.0f * 3.14159265f * 3600.0f)
+
 
-/* Current measurement channels */
-/** @todo DON'T FORGET THIS */
-#warning FIGURE OUT WHICH CHANNELS CORRESPOND TO WHICH REACTION WHEEL FACES
-#warning FIGURE OUT WHICH CHANNELS CORRESPOND TO WHICH REACTION WHEEL FACES
-#warning FIGURE OUT WHICH CHANNELS CORRESPOND TO WHICH REACTION WHEEL FACES
-#define REAC_WHEEL_ADS7841_CHANNEL_x ADS7841_CHANNEL_SGL_1
-#define REAC_WHEEL_ADS7841_CHANNEL_y ADS7841_CHANNEL_SGL_2
-#define REAC_WHEEL_ADS7841_CHANNEL_z ADS7841_CHANNEL_SGL_3
+typedef struct
+{
+    HAL_TIMER_t pwm_tmr;
+    uint8_t     pwm_ccr;
+    HAL_GPIO_t  pwm_pin;
+    uint8_t     outfg_ccr; /* on timer B0 */
+    HAL_GPIO_t  outfg_pin;
+} RW_hw_t;
+
+static const RW_hw_t RW_hw[] = {
+    [REAC_WHEEL_x] = {HAL_TIMER_B0, 5, {HAL_PORT_3, HAL_PIN(5)},
+                      6, {HAL_PORT_3, HAL_PIN(6)}},
+    [REAC_WHEEL_y] = {HAL_TIMER_A2, 1, {HAL_PORT_2, HAL_PIN(4)},
+                      1, {HAL_PORT_5, HAL_PIN(7)}},
+    [REAC_WHEEL_z] = {HAL_TIMER_A2, 2, {HAL_PORT_2, HAL_PIN(5)},
+                      2, {HAL_PORT_7, HAL_PIN(4)}},
+};
 
+typedef struct
+{
+    uint32_t last_counts;
+    uint32_t period_counts; /* between the last two edges */
+    uint8_t  edges;         /* since the last read, saturates */
+} RW_tach_t;
 
-/** @todo DON'T FORGET THIS */
-#warning THIS CONSTANT NEEDS TO BE UPDATED BASED ON EMPIRICAL MEASUREMENTS OF THE CIRCUITRY
-#define REACWHEEL_CURRENT_SENSE_MA_PER_MV (0.5f)
+/* Replay input of RW_get_speed_rph */
+typedef struct
+{
+    int32_t rph;
+    uint8_t rw;
+    uint8_t measured;
+} RW_speed_rec_t;
 
+static const HAL_GPIO_t RW_current_sense_cs = {HAL_PORT_5, HAL_PIN(0)};
 
-#warning RW_RPH_PER_PWM_MV NEEDS TO BE UPDATED TO CORRECT CONVERSION FACTOR
-/** @todo THIS NEEDS TO BE UPDATED TO THE CORRECT CONVERSION FACTOR */
-#define RW_RPH_PER_PWM_MV (1.0f)
+static volatile RW_tach_t rw_tach[NUM_REACTION_WHEELS];
 
+static ROT_DIR_t rw_direction[] = {
+    [REAC_WHEEL_x] = ROT_DIR_anticlock,
+    [REAC_WHEEL_y] = ROT_DIR_anticlock,
+    [REAC_WHEEL_z] = ROT_DIR_anticlock,
+};
 
-static int rw_speed_rph[] = {
+static int32_t rw_speed_rph[] = {
     [REAC_WHEEL_x] = 0,
     [REAC_WHEEL_y] = 0,
     [REAC_WHEEL_z] = 0,
 };
-static int RW_rph_to_mv(int rph);
+static int RW_rph_to_mv(int32_t rph);
 
 static int RW_current_sense_mv_to_ma(int mv);
 
@@ -65,17 +113,12 @@ static void RW_TIMER_API_init_phy(void);
 static void RW_TIMER_API_timer_init(void);
 
 static void RW_TIMER_API_set_duty_cycle(REAC_WHEEL_t rw, float pct_ds);
-
-static int RW_TIMER_API_measure_x_current_ma(void);
-static int RW_TIMER_API_measure_y_current_ma(void);
-static int RW_TIMER_API_measure_z_current_ma(void);
-
-static void RW_ADS7841_CURRENT_MEASUREMENT_PHY_init(void);
-static void RW_ADS7841_CURRENT_MEASUREMENT_PHY_deinit(void);
+static void RW_TIMER_API_outfg_capture(uint8_t ccr, uint32_t counts);
 
 
 void RW_init(void)
 {
+    HAL_ADS7841_init_cs(&RW_current_sense_cs);
     RW_TIMER_API_init();
     RW_TIMER_API_set_duty_cycle(REAC_WHEEL_x, 0.0f);
     RW_TIMER_API_set_duty_cycle(REAC_WHEEL_y, 0.0f);
@@ -83,7 +126,7 @@ void RW_init(void)
 }
 
 
-void RW_set_speed_rph(REAC_WHEEL_t rw, int rph)
+void RW_set_speed_rph(REAC_WHEEL_t rw, int32_t rph)
 {
     switch (rw)
     {
@@ -93,7 +136,8 @@ void RW_set_speed_rph(REAC_WHEEL_t rw, int rph)
         {
             rw_speed_rph[rw] = rph;
             int   voltage_mv = RW_rph_to_mv(rw_speed_rph[rw]);
-            float duty_cycle = voltage_mv / (float)PWM_VMAX_MV_float;
+            float duty_cycle =
+                (voltage_mv * PWM_MAX_DUTY_CYCLE_float) / PWM_VMAX_MV_float;
             RW_TIMER_API_set_duty_cycle(rw, duty_cycle);
         }
         break;
@@ -106,35 +150,83 @@ void RW_set_speed_rph(REAC_WHEEL_t rw, int rph)
 }
 
 
-int RW_config_to_string(char *buf, int buflen)
+int RW_config_to_json(JW_t *w)
 {
-    CONFIG_ASSERT(NULL != buf);
-    int x_mv    = RW_rph_to_mv(rw_speed_rph[REAC_WHEEL_x]);
-    int y_mv    = RW_rph_to_mv(rw_speed_rph[REAC_WHEEL_y]);
-    int z_mv    = RW_rph_to_mv(rw_speed_rph[REAC_WHEEL_z]);
-    int req_len = snprintf(buf, buflen, "[ %d, %d, %d ]", x_mv, y_mv, z_mv);
-    return (req_len < buflen) ? 0 : 1;
+    CONFIG_ASSERT(NULL != w);
+    JW_array_begin(w);
+    JW_int(w, RW_rph_to_mv(rw_speed_rph[REAC_WHEEL_x]));
+    JW_int(w, RW_rph_to_mv(rw_speed_rph[REAC_WHEEL_y]));
+    JW_int(w, RW_rph_to_mv(rw_speed_rph[REAC_WHEEL_z]));
+    JW_array_end(w);
+    return JW_error(w);
+}
+
+
+ROT_DIR_t RW_get_direction(REAC_WHEEL_t rw)
+{
+    CONFIG_ASSERT(rw < NUM_REACTION_WHEELS);
+    return rw_direction[rw];
+}
+
+
+int RW_get_speed_rph(REAC_WHEEL_t rw, int32_t *rph)
+{
+    CONFIG_ASSERT(rw < NUM_REACTION_WHEELS);
+    CONFIG_ASSERT(NULL != rph);
+
+    RW_TACH_LOCK();
+    const uint8_t  edges  = rw_tach[rw].edges;
+    const uint32_t period = rw_tach[rw].period_counts;
+    rw_tach[rw].edges     = 0;
+    RW_TACH_UNLOCK();
+
+    /* The period of a lone edge reaches back past the previous read */
+    RW_speed_rec_t meas;
+    memset(&meas, 0, sizeof(meas));
+    meas.rw = (uint8_t)rw;
+    if (edges >= 2 && period != 0)
+    {
+        float speed = (float)HAL->timer->clock_hz() * RW_RPH_PER_REV_PER_S /
+                      ((float)RW_OUTFG_EDGES_PER_REV * (float)period);
+        if (speed > (float)INT32_MAX)
+        {
+            speed = (float)INT32_MAX;
+        }
+        meas.rph      = (int32_t)speed;
+        meas.measured = 1;
+        if (rw_direction[rw] == ROT_DIR_clock)
+        {
+            meas.rph = -meas.rph;
+        }
+    }
+    REPLAY_input(REPLAY_REC_wheel, &meas, sizeof(meas));
+    *rph = meas.rph;
+    return meas.measured ? 0 : 1;
 }
 
 
 int RW_measure_current_ma(REAC_WHEEL_t wheel)
 {
-#if defined(TARGET_MCU)
+    int      current_ma = 0;
+    uint16_t adc_val    = HAL_ADS7841_CONV_FAILED;
     switch (wheel)
     {
         case REAC_WHEEL_x:
         {
-            return RW_TIMER_API_measure_x_current_ma();
+            adc_val = HAL_ADS7841_measure_channel(&RW_current_sense_cs,
+                                                  REAC_WHEEL_ADS7841_CHANNEL_x);
         }
         break;
         case REAC_WHEEL_y:
         {
-            return RW_TIMER_API_measure_y_current_ma();
+            adc_val = HAL_ADS7841_measure_channel(&RW_current_sense_cs,
+                                                  REAC_WHEEL_ADS7841_CHANNEL_y);
         }
         break;
         case REAC_WHEEL_z:
         {
-            return RW_TIMER_API_measure_z_current_ma();
+            adc_val = HAL_ADS7841_measure_channel(&RW_current_sense_cs,
+                                                  REAC_WHEEL_ADS7841_CHANNEL_z);
         }
         break;
         default:
@@ -143,27 +235,25 @@ int RW_measure_current_ma(REAC_WHEEL_t wheel)
         }
         break;
     }
-
-#else
-
-    printf("Called %s with arg %d\n", __func__, wheel);
-    return 0;
-
-#endif /* #if defined(TARGET_MCU) */
+    if (adc_val != HAL_ADS7841_CONV_FAILED)
+    {
+        current_ma = RW_current_sense_mv_to_ma(adc_val);
+    }
+    return current_ma;
 }
 
 
-static int RW_rph_to_mv(int rph)
+static int RW_rph_to_mv(int32_t rph)
 {
-    return (int)(rph / ((float)RW_RPH_PER_PWM_MV));
+    return (int)(rph / (PARAM_get_float(PARAM_rw_rph_mv)));
 }
 
 /******************************************************************************/
 /******************************************************************************
  *
  *
- *       START OF THE TARGET-SPECIFIC REGISTER LEVEL STUFF. IF THIS
- *       SECTION GETS TOO BIG IT SHOULD BE MOVED INTO THE DRIVER LAYER
+ *       START OF THE PWM, SPEED FEEDBACK AND CURRENT SENSE HARDWARE,
+ *       DRIVEN THROUGH THE HAL
  *
  *
  ******************************************************************************/
@@ -179,239 +269,81 @@ static void RW_TIMER_API_init(void)
 
 static void RW_TIMER_API_init_phy(void)
 {
-#if defined(TARGET_MCU)
-
-    /* P3.5 is RW_X_SPEED_CTRL == TB0.5 */
-    P3DIR |= BIT5;
-    P3SEL |= BIT5;
-
-    /* PIN 2.4 is RW_Y_SPEED_CTRL == TA2.1 */
-    P2DIR |= BIT4;
-    P2SEL |= BIT4;
-
-    /* PIN 2.5 is RW_Z_SPEED_CTRL == TA2.2*/
-    P2DIR |= BIT5;
-    P2SEL |= BIT5;
-
-    /* Pin 3.6 is RW_X_OUTFG == TB0.6 */
-    P3DIR &= ~BIT6;
-    P3DIR |= BIT6;
-
-    /* Pin 5.7 is RW_Y_OUTFG == TB0.1 */
-    P5DIR &= ~BIT7;
-    P5SEL |= BIT7;
-
-    /* Pin 7.4 is RW_Z_OUTFG == TB0.2 */
-    P7DIR &= ~BIT4;
-    P7SEL |= BIT4;
-#else
-
-    printf("Called %s\n", __func__);
-
-#endif /* #if defined(TARGET_MCU) */
+    REAC_WHEEL_t rw;
+    for (rw = REAC_WHEEL_x; rw <= REAC_WHEEL_z; rw++)
+    {
+        const RW_hw_t *hw = &RW_hw[rw];
+        HAL->gpio->output(hw->pwm_pin.port, hw->pwm_pin.pins);
+        HAL->gpio->peripheral(hw->pwm_pin.port, hw->pwm_pin.pins);
+        HAL->gpio->input(hw->outfg_pin.port, hw->outfg_pin.pins);
+        HAL->gpio->peripheral(hw->outfg_pin.port, hw->outfg_pin.pins);
+    }
 }
 
 
 static void RW_TIMER_API_timer_init(void)
 {
-#if defined(TARGET_MCU)
-
-    /**********************/
-    /* Configure timer A2 */
-    /**********************/
-
-    TA2CTL &= ~(MC0 | MC1); /* Stop timer A2 */
-
-    /* Confgigure RW_Y pwm on pin 2.4 (TA.2.1) */
-    TA2CCR1 = 0;
-    TA2CCTL1 &= ~OUTMOD_MSK;
-    TA2CCTL1 |= OUTMOD_TOG_SET;
-
-    /* Confgigure RW_Z pwm on pin 2.5 (TA.2.2) */
-    TA2CCR2 = 0;
-    TA2CCTL2 &= ~OUTMOD_MSK;
-    TA2CCTL2 |= OUTMOD_TOG_SET;
-
-    /* Set Timer A2 clock source to smclk */
-    TA2CTL &= ~(TASSEL0 | TASSEL1);
-    TA2CTL |= TASSEL__SMCLK;
-
-    /* Set timer A2 count mode */
-    TA2CTL &= ~(MC0 | MC1);
-    TA2CTL |= MC__CONTINOUS;
-
-    /**********************/
-    /* Configure timer B0 */
-    /**********************/
+    /* Y and Z on timer A2, X and the OUTFG captures on timer B0. B0 is the
+     * SYSTICK counter, it is never stopped: the channels are set up while it
+     * runs and starting it again keeps its count */
+    HAL->timer->start(HAL_TIMER_A2, HAL_TIMER_MODE_stop, 0);
 
-    TB0CTL &= ~(MC0 | MC1); /* Stop timer B0 */
-
-    /* Source Timer B0 from SMCLK */
-    TB0CTL &= ~(TBSSEL0 | TBSSEL1);
-    TB0CTL |= TBSSEL__SMCLK;
-
-    /* RW_X pwm on pin 3.5 (TB0.5 == pin 3.5) */
-    TB0CCR5 = 0;
-    TB0CCTL5 &= ~OUTMOD_MSK;
-    TB0CCTL5 |= OUTMOD_TOG_SET;
-
-    /* Configure Y_OUTFG capture on pin 7.4 (TB0.2 == P7.4) */
-    TB0CCR1 &= ~TIMER_CM_MSK;
-    TB0CCR1 |= TIMER_CM_CAP_EDGE;
-
-    /* Set Timer B0 count mode */
-    TB0CTL |= MC__CONTINOUS;
-
-#else
+    REAC_WHEEL_t rw;
+    for (rw = REAC_WHEEL_x; rw <= REAC_WHEEL_z; rw++)
+    {
+        HAL->timer->pwm_channel(RW_hw[rw].pwm_tmr, RW_hw[rw].pwm_ccr);
+        HAL->timer->capture_channel(HAL_TIMER_B0, RW_hw[rw].outfg_ccr);
+    }
 
-    printf("Called %s\n", __func__);
+    memset((void *)rw_tach, 0, sizeof(rw_tach));
+    HAL->timer->on_capture(HAL_TIMER_B0, RW_TIMER_API_outfg_capture);
 
-#endif /* #if defined(TARGET_MCU) */
+    HAL->timer->start(HAL_TIMER_A2, HAL_TIMER_MODE_continuous, 0);
+    HAL->timer->start(HAL_TIMER_B0, HAL_TIMER_MODE_continuous, 0);
 }
 
 
 static void RW_TIMER_API_set_duty_cycle(REAC_WHEEL_t rw, float pct_ds)
 {
-#if defined(TARGET_MCU)
+    CONFIG_ASSERT(rw < NUM_REACTION_WHEELS);
 
-    switch (rw)
+    /** @todo THE PINOUT HAS NO DIRECTION LINE TO THE WHEEL DRIVERS. THE PWM
+     * CARRIES THE MAGNITUDE AND THE DIRECTION IS ONLY KEPT IN rw_direction
+     * UNTIL THE DRIVER INTERFACE IS KNOWN */
+    if (pct_ds < 0.0f)
     {
-        case REAC_WHEEL_x:
-        {
-            if (pct_ds > PWM_MAX_DUTY_CYCLE_float)
-            {
-                pct_ds = PWM_MAX_DUTY_CYCLE_float;
-            }
+        rw_direction[rw] = ROT_DIR_clock;
+        pct_ds           = -pct_ds;
+    }
+    else
+    {
+        rw_direction[rw] = ROT_DIR_anticlock;
+    }
+    HAL_TIMER_set_duty(RW_hw[rw].pwm_tmr, RW_hw[rw].pwm_ccr, pct_ds);
+}
 
-            TB0CCR5 =
-                (uint16_t)((pct_ds / (PWM_MAX_DUTY_CYCLE_float)) * UINT16_MAX);
-        }
-        break;
-        case REAC_WHEEL_y:
-        {
-            if (pct_ds > PWM_MAX_DUTY_CYCLE_float)
-            {
-                pct_ds = PWM_MAX_DUTY_CYCLE_float;
-            }
 
-            TA0CCR1 =
-                (uint16_t)((pct_ds / (PWM_MAX_DUTY_CYCLE_float)) * UINT16_MAX);
-        }
-        break;
-        case REAC_WHEEL_z:
+/* Runs in the TB0 interrupt on the target */
+static void RW_TIMER_API_outfg_capture(uint8_t ccr, uint32_t counts)
+{
+    REAC_WHEEL_t rw;
+    for (rw = REAC_WHEEL_x; rw <= REAC_WHEEL_z; rw++)
+    {
+        if (RW_hw[rw].outfg_ccr == ccr)
         {
-            if (pct_ds > PWM_MAX_DUTY_CYCLE_float)
+            volatile RW_tach_t *tach = &rw_tach[rw];
+            tach->period_counts      = counts - tach->last_counts;
+            tach->last_counts        = counts;
+            if (tach->edges < UINT8_MAX)
             {
-                pct_ds = PWM_MAX_DUTY_CYCLE_float;
+                tach->edges++;
             }
-
-            TA0CCR2 =
-                (uint16_t)((pct_ds / (PWM_MAX_DUTY_CYCLE_float)) * UINT16_MAX);
-        }
-        break;
-        default:
-        {
-            CONFIG_ASSERT(0);
         }
-        break;
     }
-
-#else
-
-    printf("Called %s with arg %f\n", __func__, pct_ds);
-
-#endif /* #if defined(TARGET_MCU) */
-}
-
-
-static int RW_TIMER_API_measure_x_current_ma(void)
-{
-    int current_ma = 0;
-#if defined(TARGET_MCU)
-
-    ADS7841_driver_init(RW_ADS7841_CURRENT_MEASUREMENT_PHY_init,
-                        RW_ADS7841_CURRENT_MEASUREMENT_PHY_deinit,
-                        ADS7841_PWRMODE_stayOn, ADS7841_BITRES_12);
-
-    uint16_t adc_val = ADS7841_measure_channel(REAC_WHEEL_ADS7841_CHANNEL_x);
-    current_ma       = RW_current_sense_mv_to_ma(adc_val);
-
-    ADS7841_driver_deinit();
-
-#endif /* #if defined(TARGET_MCU) */
-    return current_ma;
-}
-
-
-static int RW_TIMER_API_measure_y_current_ma(void)
-{
-    int current_ma = 0;
-
-#if defined(TARGET_MCU)
-
-    ADS7841_driver_init(RW_ADS7841_CURRENT_MEASUREMENT_PHY_init,
-                        RW_ADS7841_CURRENT_MEASUREMENT_PHY_deinit,
-                        ADS7841_PWRMODE_stayOn, ADS7841_BITRES_12);
-
-    uint16_t adc_val = ADS7841_measure_channel(REAC_WHEEL_ADS7841_CHANNEL_y);
-    current_ma       = RW_current_sense_mv_to_ma(adc_val);
-
-    ADS7841_driver_deinit();
-
-#endif /* #if defined(TARGET_MCU) */
-
-    return current_ma;
-}
-
-
-static int RW_TIMER_API_measure_z_current_ma(void)
-{
-    int current_ma = 0;
-
-#if defined(TARGET_MCU)
-
-    ADS7841_driver_init(RW_ADS7841_CURRENT_MEASUREMENT_PHY_init,
-                        RW_ADS7841_CURRENT_MEASUREMENT_PHY_deinit,
-                        ADS7841_PWRMODE_stayOn, ADS7841_BITRES_12);
-
-    uint16_t adc_val = ADS7841_measure_channel(REAC_WHEEL_ADS7841_CHANNEL_z);
-    current_ma       = RW_current_sense_mv_to_ma(adc_val);
-
-    ADS7841_driver_deinit();
-
-#endif /* #if defined(TARGET_MCU) */
-
-    return current_ma;
-}
-
-
-static void RW_ADS7841_CURRENT_MEASUREMENT_PHY_init(void)
-{
-
-#if defined(TARGET_MCU)
-
-    /* P5.0 */
-    P5DIR |= BIT0;
-    P5OUT ^= ~BIT0; /* ADS7841 chip select is active low */
-
-#endif /* #if defined(TARGET_MCU) */
-}
-
-
-static void RW_ADS7841_CURRENT_MEASUREMENT_PHY_deinit(void)
-{
-
-#if defined(TARGET_MCU)
-
-    /* P5.0 */
-    P5DIR |= BIT0;
-    P5DIR |= BIT0;
-
-#endif /* #if defined(TARGET_MCU) */
 }
 
 
 static int RW_current_sense_mv_to_ma(int mv)
 {
-    return mv * REACWHEEL_CURRENT_SENSE_MA_PER_MV;
+    return mv * PARAM_get_float(PARAM_rw_ma_mv);
 }
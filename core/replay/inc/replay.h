@@ -0,0 +1,193 @@
+/**
+ * @file replay.h
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Record the inputs and outputs of a session into a compact binary
+ * trace and play the inputs back, checking the outputs against the trace
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ * @note The modules call the hooks at the points where the outside world
+ * comes in (command frames, IMU samples, ADS7841 conversions, wheel speeds)
+ * and goes out (replies, pwm compares). Every record is stamped with the
+ * TIMEBASE tick it happened on, so the trace also holds the ticks.
+ *
+ * While playing, an input hook takes the next recorded input of its kind
+ * instead of what the hardware returned. Conversions and wheel speeds are
+ * served in the order they were recorded. Frames and IMU samples arrive on
+ * their own, so they are served once the tick they were recorded on comes.
+ * An output hook compares the output with the next recorded output of its
+ * kind and counts a divergence if the bytes or the tick differ.
+ *
+ * Trace layout: REPLAY_TRACE_HEADER_LEN header bytes, then records of
+ *  - one byte : the REPLAY_REC_t, REPLAY_FLAG_DELTA if the payload is coded
+ *    against the previous payload of that kind
+ *  - varint   : ticks since the previous record
+ *  - varint   : payload length
+ *  - payload  : as is, or with REPLAY_FLAG_DELTA a bitmap of the bytes that
+ *    changed (one bit per byte, LSB first) followed by those bytes.
+ * Varints are 7 bits per byte, least significant first. Payloads are the
+ * bytes of the firmware structures, the MSP430 and the hosts the replay runs
+ * on are all little endian.
+ *
+ * Recording and playback are for the native build: the SIL, adcs_replay and
+ * the benches. The board has no spare link to carry a trace, so on the
+ * target the hooks compile to nothing and cost the ISRs and the main loop
+ * no time.
+ */
+#ifndef __REPLAY_H__
+#define __REPLAY_H__
+#ifdef __cplusplus
+/* clang-format off */
+extern "C"
+{
+/* clang-format on */
+#endif /* Start C linkage */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define REPLAY_TRACE_MAGIC "ADCSRPL"
+#define REPLAY_TRACE_VERSION (1u)
+#define REPLAY_TRACE_HEADER_LEN (8u) /* magic without its nul, version */
+
+#define REPLAY_FLAG_DELTA (0x80u)
+
+/* Payloads up to this long are coded against the previous one of their
+ * kind. Longer ones (frames and replies) are always stored as is */
+#define REPLAY_DELTA_LEN_MAX (32u)
+
+/* Longest payload of a record, a reply */
+#define REPLAY_PAYLOAD_LEN_MAX (512u)
+
+typedef enum
+{
+    REPLAY_REC_end,       /* end of the session, no payload */
+    REPLAY_REC_obc_rx,    /* input : command frame payload, when dequeued */
+    REPLAY_REC_imu,       /* input : IMU_sample_t, when popped */
+    REPLAY_REC_adc,       /* input : counts of one ADS7841 chip select */
+    REPLAY_REC_reference, /* input : attitude reference of the simulator */
+    REPLAY_REC_obc_tx,    /* output : reply payload before framing */
+    REPLAY_REC_pwm,       /* output : timer, ccr, 16 bit compare */
+    REPLAY_REC_wheel,     /* input : tachometer speed of a wheel, when read */
+    REPLAY_REC_cnt,       /* must be last */
+} REPLAY_REC_t;
+
+typedef enum
+{
+    REPLAY_MODE_off,
+    REPLAY_MODE_record,
+    REPLAY_MODE_play,
+} REPLAY_MODE_t;
+
+#if defined(TARGET_MCU)
+
+#define REPLAY_get_mode() (REPLAY_MODE_off)
+#define REPLAY_record(rec, data, len) ((void)(data))
+#define REPLAY_input(rec, data, len) ((void)(data))
+#define REPLAY_input_due(rec, data, len) ((void)(data), (void)(len), 1)
+#define REPLAY_output(rec, data, len) ((void)(data))
+
+#else
+
+typedef struct
+{
+    uint32_t     records;        /* written, or taken from the trace */
+    uint32_t     bytes;          /* written, header included */
+    uint32_t     inputs;         /* served from the trace */
+    uint32_t     inputs_missing; /* asked for past the last one recorded */
+    uint32_t     outputs;        /* same bytes on the same tick */
+    uint32_t     diverged;       /* outputs that differ, are extra or are
+                                    missing */
+    uint32_t     first_diverged_ms;
+    REPLAY_REC_t first_diverged_rec;
+} REPLAY_stats_t;
+
+/**
+ * @brief Receives the trace as it is written
+ */
+typedef void (*REPLAY_sink_func)(const uint8_t *buf, uint16_t len,
+                                 void *ctx);
+
+
+/**
+ * @brief Write the trace header to sink and record from the current tick
+ */
+void REPLAY_record_start(REPLAY_sink_func sink, void *ctx);
+
+/**
+ * @brief Play a trace from the current tick
+ *
+ * @param trace must stay valid until REPLAY_stop
+ * @return int 0 on success, 1 if trace is not a complete trace
+ */
+int REPLAY_play_start(const uint8_t *trace, uint32_t len);
+
+/**
+ * @brief End the session. A recording gets its end record. Outputs of a
+ * playback that were recorded but never produced count as diverged
+ */
+void REPLAY_stop(void);
+
+REPLAY_MODE_t REPLAY_get_mode(void);
+
+/**
+ * @brief Check if a playback reached the tick its recording ended on
+ */
+bool REPLAY_play_done(void);
+
+/**
+ * @brief Ticks from the start to the end of the trace being played
+ */
+uint32_t REPLAY_play_duration_ms(void);
+
+void REPLAY_get_stats(REPLAY_stats_t *stats);
+
+/**
+ * @brief Record an input or an output as is, nothing unless recording
+ */
+void REPLAY_record(REPLAY_REC_t rec, const void *data, uint16_t len);
+
+/**
+ * @brief Hook of an input that is read when the firmware asks for it. A
+ * recording records data, a playback overwrites it with the next recorded
+ * input of its kind
+ */
+void REPLAY_input(REPLAY_REC_t rec, void *data, uint16_t len);
+
+/**
+ * @brief Take the next recorded input of its kind if it is due
+ *
+ * @param len size of data, set to the payload length
+ * @return int 0 if data holds an input recorded on or before this tick,
+ * 1 if there is none or not playing
+ */
+int REPLAY_input_due(REPLAY_REC_t rec, void *data, uint16_t *len);
+
+/**
+ * @brief Hook of an output. A recording records it, a playback compares it
+ * with the next recorded output of its kind
+ */
+void REPLAY_output(REPLAY_REC_t rec, const void *data, uint16_t len);
+
+/**
+ * @brief Sink writing to a FILE *, given as ctx
+ */
+void REPLAY_file_sink(const uint8_t *buf, uint16_t len, void *ctx);
+
+/**
+ * @brief Read a whole trace file
+ *
+ * @return uint8_t* to free, NULL if the file cannot be read
+ */
+uint8_t *REPLAY_file_load(const char *path, uint32_t *len);
+
+#endif /* #if defined(TARGET_MCU) */
+
+#ifdef __cplusplus
+/* clang-format off */
+}
+/* clang-format on */
+#endif /* End C linkage */
+#endif /* __REPLAY_H__ */
@@ -0,0 +1,528 @@
+/**
+ * @file replay.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Record and play back the inputs and outputs of a session
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ * @note The trace is played in place. Each kind of record has its own
+ * cursor that walks the whole trace (keeping the tick of the records it
+ * passes) and stops on its own kind, so inputs of one kind are served in
+ * order whatever order the firmware asks for the kinds in.
+ */
+#if !defined(TARGET_MCU)
+
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "targets.h"
+#include "timebase.h"
+#include "replay.h"
+
+#define REPLAY_REC_MSK (0x7Fu)
+#define REPLAY_VARINT_LEN_MAX (5u)
+#define REPLAY_VARINT_MORE (0x80u)
+#define REPLAY_MASK_LEN(len) (((len) + 7u) / 8u)
+
+typedef struct
+{
+    uint8_t buf[REPLAY_DELTA_LEN_MAX];
+    uint8_t len;
+} REPLAY_last_t;
+
+/* Where the search for the next record of one kind starts */
+typedef struct
+{
+    uint32_t      pos;
+    uint32_t      t_ms; /* tick of the record before pos */
+    REPLAY_last_t last;
+} REPLAY_cursor_t;
+
+typedef struct
+{
+    REPLAY_REC_t rec;
+    bool         delta;
+    uint32_t     t_ms;
+    uint16_t     len;  /* of the payload */
+    uint32_t     data; /* offset of the coded payload */
+    uint32_t     next; /* offset of the next record */
+} REPLAY_hdr_t;
+
+static const bool replay_is_output[REPLAY_REC_cnt] = {
+    [REPLAY_REC_obc_tx] = true,
+    [REPLAY_REC_pwm]    = true,
+};
+
+static volatile REPLAY_MODE_t replay_mode = REPLAY_MODE_off;
+static REPLAY_stats_t         replay_stats;
+
+static REPLAY_sink_func replay_sink;
+static void *           replay_sink_ctx;
+static uint32_t         replay_last_ms;
+static REPLAY_last_t    replay_last[REPLAY_REC_cnt];
+
+static const uint8_t * replay_trace;
+static uint32_t        replay_trace_len;
+static uint32_t        replay_start_ms;
+static uint32_t        replay_end_ms;
+static REPLAY_cursor_t replay_cursor[REPLAY_REC_cnt];
+
+
+static uint8_t  REPLAY_varint_put(uint8_t *buf, uint32_t val);
+static int      REPLAY_varint_get(uint32_t *pos, uint32_t *val);
+static void     REPLAY_write(REPLAY_REC_t rec, const uint8_t *data,
+                             uint16_t len);
+static int      REPLAY_parse(uint32_t pos, uint32_t t_ms, REPLAY_hdr_t *hdr);
+static int      REPLAY_peek(REPLAY_REC_t rec, REPLAY_hdr_t *hdr);
+static void     REPLAY_take(const REPLAY_hdr_t *hdr, uint8_t *out);
+static uint32_t REPLAY_now_ms(void);
+static void     REPLAY_diverged(REPLAY_REC_t rec, uint32_t t_ms);
+
+
+void REPLAY_record_start(REPLAY_sink_func sink, void *ctx)
+{
+    CONFIG_ASSERT(NULL != sink);
+    uint8_t hdr[REPLAY_TRACE_HEADER_LEN];
+    memcpy(hdr, REPLAY_TRACE_MAGIC, REPLAY_TRACE_HEADER_LEN - 1);
+    hdr[REPLAY_TRACE_HEADER_LEN - 1] = REPLAY_TRACE_VERSION;
+
+    memset(&replay_stats, 0, sizeof(replay_stats));
+    memset(replay_last, 0, sizeof(replay_last));
+    replay_sink     = sink;
+    replay_sink_ctx = ctx;
+    replay_last_ms  = TIMEBASE_get_ms();
+    replay_sink(hdr, sizeof(hdr), replay_sink_ctx);
+    replay_stats.bytes = sizeof(hdr);
+    replay_mode        = REPLAY_MODE_record;
+}
+
+
+int REPLAY_play_start(const uint8_t *trace, uint32_t len)
+{
+    CONFIG_ASSERT(NULL != trace);
+    if (len < REPLAY_TRACE_HEADER_LEN ||
+        memcmp(trace, REPLAY_TRACE_MAGIC, REPLAY_TRACE_HEADER_LEN - 1) != 0 ||
+        trace[REPLAY_TRACE_HEADER_LEN - 1] != REPLAY_TRACE_VERSION)
+    {
+        return 1;
+    }
+
+    REPLAY_stop();
+    replay_trace     = trace;
+    replay_trace_len = len;
+
+    /* The whole trace has to parse and end with its end record. A delta
+     * payload needs a payload of the same length before it */
+    uint8_t      last_len[REPLAY_REC_cnt] = {0};
+    REPLAY_hdr_t hdr;
+    uint32_t     pos  = REPLAY_TRACE_HEADER_LEN;
+    uint32_t     t_ms = 0;
+    do
+    {
+        if (REPLAY_parse(pos, t_ms, &hdr) ||
+            (hdr.delta && last_len[hdr.rec] != hdr.len))
+        {
+            return 1;
+        }
+        if (hdr.len <= REPLAY_DELTA_LEN_MAX)
+        {
+            last_len[hdr.rec] = (uint8_t)hdr.len;
+        }
+        pos  = hdr.next;
+        t_ms = hdr.t_ms;
+    } while (hdr.rec != REPLAY_REC_end);
+    if (pos != len)
+    {
+        return 1;
+    }
+
+    memset(&replay_stats, 0, sizeof(replay_stats));
+    memset(replay_cursor, 0, sizeof(replay_cursor));
+    REPLAY_REC_t rec;
+    for (rec = REPLAY_REC_end; rec < REPLAY_REC_cnt; rec++)
+    {
+        replay_cursor[rec].pos = REPLAY_TRACE_HEADER_LEN;
+    }
+    replay_end_ms   = t_ms;
+    replay_start_ms = TIMEBASE_get_ms();
+    replay_mode     = REPLAY_MODE_play;
+    return 0;
+}
+
+
+void REPLAY_stop(void)
+{
+    switch (replay_mode)
+    {
+        case REPLAY_MODE_record:
+        {
+            REPLAY_write(REPLAY_REC_end, NULL, 0);
+        }
+        break;
+        case REPLAY_MODE_play:
+        {
+            REPLAY_REC_t rec;
+            REPLAY_hdr_t hdr;
+            for (rec = REPLAY_REC_end; rec < REPLAY_REC_cnt; rec++)
+            {
+                while (replay_is_output[rec] && REPLAY_peek(rec, &hdr) == 0)
+                {
+                    REPLAY_diverged(rec, hdr.t_ms);
+                    REPLAY_take(&hdr, NULL);
+                }
+            }
+        }
+        break;
+        default:
+        {
+        }
+        break;
+    }
+    replay_mode = REPLAY_MODE_off;
+}
+
+
+REPLAY_MODE_t REPLAY_get_mode(void)
+{
+    return replay_mode;
+}
+
+
+bool REPLAY_play_done(void)
+{
+    return replay_mode != REPLAY_MODE_play || REPLAY_now_ms() >= replay_end_ms;
+}
+
+
+uint32_t REPLAY_play_duration_ms(void)
+{
+    return replay_end_ms;
+}
+
+
+void REPLAY_get_stats(REPLAY_stats_t *stats)
+{
+    CONFIG_ASSERT(NULL != stats);
+    *stats = replay_stats;
+}
+
+
+void REPLAY_record(REPLAY_REC_t rec, const void *data, uint16_t len)
+{
+    if (replay_mode == REPLAY_MODE_record)
+    {
+        REPLAY_write(rec, (const uint8_t *)data, len);
+    }
+}
+
+
+void REPLAY_input(REPLAY_REC_t rec, void *data, uint16_t len)
+{
+    if (replay_mode == REPLAY_MODE_record)
+    {
+        REPLAY_write(rec, (const uint8_t *)data, len);
+    }
+    else if (replay_mode == REPLAY_MODE_play)
+    {
+        REPLAY_hdr_t hdr;
+        if (REPLAY_peek(rec, &hdr) == 0 && hdr.len == len)
+        {
+            REPLAY_take(&hdr, (uint8_t *)data);
+            replay_stats.inputs++;
+        }
+        else
+        {
+            replay_stats.inputs_missing++;
+        }
+    }
+}
+
+
+int REPLAY_input_due(REPLAY_REC_t rec, void *data, uint16_t *len)
+{
+    CONFIG_ASSERT(NULL != len);
+    REPLAY_hdr_t hdr;
+    if (replay_mode != REPLAY_MODE_play || REPLAY_peek(rec, &hdr) ||
+        hdr.t_ms > REPLAY_now_ms())
+    {
+        return 1;
+    }
+    if (hdr.len > *len)
+    {
+        REPLAY_take(&hdr, NULL);
+        replay_stats.inputs_missing++;
+        return 1;
+    }
+    REPLAY_take(&hdr, (uint8_t *)data);
+    replay_stats.inputs++;
+    *len = hdr.len;
+    return 0;
+}
+
+
+void REPLAY_output(REPLAY_REC_t rec, const void *data, uint16_t len)
+{
+    if (replay_mode == REPLAY_MODE_record)
+    {
+        REPLAY_write(rec, (const uint8_t *)data, len);
+    }
+    else if (replay_mode == REPLAY_MODE_play)
+    {
+        const uint32_t now_ms = REPLAY_now_ms();
+        REPLAY_hdr_t   hdr;
+        if (REPLAY_peek(rec, &hdr))
+        {
+            REPLAY_diverged(rec, now_ms); /* more than recorded */
+        }
+        else
+        {
+            /* Long payloads are never delta coded, compare them in place */
+            uint8_t        small[REPLAY_DELTA_LEN_MAX];
+            const uint8_t *recorded = &replay_trace[hdr.data];
+            if (hdr.len <= REPLAY_DELTA_LEN_MAX)
+            {
+                REPLAY_take(&hdr, small);
+                recorded = small;
+            }
+            else
+            {
+                REPLAY_take(&hdr, NULL);
+            }
+
+            if (hdr.len == len && hdr.t_ms == now_ms &&
+                memcmp(recorded, data, len) == 0)
+            {
+                replay_stats.outputs++;
+            }
+            else
+            {
+                REPLAY_diverged(rec, now_ms);
+            }
+        }
+    }
+}
+
+
+static uint8_t REPLAY_varint_put(uint8_t *buf, uint32_t val)
+{
+    uint8_t n = 0;
+    while (val >= REPLAY_VARINT_MORE)
+    {
+        buf[n++] = (uint8_t)(val | REPLAY_VARINT_MORE);
+        val >>= 7;
+    }
+    buf[n++] = (uint8_t)val;
+    return n;
+}
+
+
+static int REPLAY_varint_get(uint32_t *pos, uint32_t *val)
+{
+    uint8_t shift = 0;
+    uint8_t byte;
+    *val = 0;
+    do
+    {
+        if (*pos >= replay_trace_len || shift >= 7 * REPLAY_VARINT_LEN_MAX)
+        {
+            return 1;
+        }
+        byte = replay_trace[(*pos)++];
+        *val |= (uint32_t)(byte & ~REPLAY_VARINT_MORE) << shift;
+        shift += 7;
+    } while (byte & REPLAY_VARINT_MORE);
+    return 0;
+}
+
+
+static void REPLAY_write(REPLAY_REC_t rec, const uint8_t *data, uint16_t len)
+{
+    CONFIG_ASSERT(rec < REPLAY_REC_cnt);
+    CONFIG_ASSERT(len <= REPLAY_PAYLOAD_LEN_MAX);
+    uint8_t head[1 + 2 * REPLAY_VARINT_LEN_MAX +
+                 REPLAY_MASK_LEN(REPLAY_DELTA_LEN_MAX)];
+    uint8_t changed[REPLAY_DELTA_LEN_MAX];
+
+    const uint32_t now_ms = TIMEBASE_get_ms();
+    uint8_t        n      = 0;
+    head[n++]             = (uint8_t)rec;
+    n += REPLAY_varint_put(&head[n], now_ms - replay_last_ms);
+    n += REPLAY_varint_put(&head[n], len);
+    replay_last_ms = now_ms;
+
+    const uint8_t *out     = data;
+    uint16_t       out_len = len;
+    REPLAY_last_t *last    = &replay_last[rec];
+    if (len <= REPLAY_DELTA_LEN_MAX)
+    {
+        /* Only the bytes that changed since the last one of this kind, if
+         * that is shorter */
+        const uint8_t mask_len = REPLAY_MASK_LEN(len);
+        if (len > 0 && last->len == len)
+        {
+            uint8_t *mask = &head[n];
+            uint8_t  cnt  = 0;
+            uint8_t  i;
+            memset(mask, 0, mask_len);
+            for (i = 0; i < len; i++)
+            {
+                if (data[i] != last->buf[i])
+                {
+                    mask[i / 8u] |= (uint8_t)(1u << (i % 8u));
+                    changed[cnt++] = data[i];
+                }
+            }
+            if (mask_len + cnt < len)
+            {
+                head[0] |= REPLAY_FLAG_DELTA;
+                n += mask_len;
+                out     = changed;
+                out_len = cnt;
+            }
+        }
+        memcpy(last->buf, data, len);
+        last->len = (uint8_t)len;
+    }
+
+    replay_sink(head, n, replay_sink_ctx);
+    if (out_len > 0)
+    {
+        replay_sink(out, out_len, replay_sink_ctx);
+    }
+    replay_stats.records++;
+    replay_stats.bytes += n + out_len;
+}
+
+
+static int REPLAY_parse(uint32_t pos, uint32_t t_ms, REPLAY_hdr_t *hdr)
+{
+    uint32_t dt_ms;
+    uint32_t len;
+    if (pos >= replay_trace_len)
+    {
+        return 1;
+    }
+    const uint8_t type = replay_trace[pos++];
+    hdr->rec           = (REPLAY_REC_t)(type & REPLAY_REC_MSK);
+    hdr->delta         = (type & REPLAY_FLAG_DELTA) != 0;
+    if (hdr->rec >= REPLAY_REC_cnt || REPLAY_varint_get(&pos, &dt_ms) ||
+        REPLAY_varint_get(&pos, &len) || len > REPLAY_PAYLOAD_LEN_MAX ||
+        (hdr->delta && len > REPLAY_DELTA_LEN_MAX))
+    {
+        return 1;
+    }
+    hdr->t_ms = t_ms + dt_ms;
+    hdr->len  = (uint16_t)len;
+    hdr->data = pos;
+
+    uint32_t coded = len;
+    if (hdr->delta)
+    {
+        const uint8_t mask_len = REPLAY_MASK_LEN(len);
+        uint8_t       i;
+        if (pos + mask_len > replay_trace_len)
+        {
+            return 1;
+        }
+        coded = mask_len;
+        for (i = 0; i < len; i++)
+        {
+            coded += (replay_trace[pos + i / 8u] >> (i % 8u)) & 1u;
+        }
+    }
+    if (pos + coded > replay_trace_len)
+    {
+        return 1;
+    }
+    hdr->next = pos + coded;
+    return 0;
+}
+
+
+/* The next record of rec, or 1 once only the end record is left */
+static int REPLAY_peek(REPLAY_REC_t rec, REPLAY_hdr_t *hdr)
+{
+    REPLAY_cursor_t *c    = &replay_cursor[rec];
+    uint32_t         pos  = c->pos;
+    uint32_t         t_ms = c->t_ms;
+    int              status = 1;
+    while (REPLAY_parse(pos, t_ms, hdr) == 0 && hdr->rec != REPLAY_REC_end)
+    {
+        if (hdr->rec == rec)
+        {
+            status = 0;
+            break;
+        }
+        pos  = hdr->next;
+        t_ms = hdr->t_ms;
+    }
+
+    /* The records of other kinds are not looked at again */
+    c->pos  = pos;
+    c->t_ms = t_ms;
+    return status;
+}
+
+
+/* Move past the record REPLAY_peek found, decoding its payload to out */
+static void REPLAY_take(const REPLAY_hdr_t *hdr, uint8_t *out)
+{
+    REPLAY_cursor_t *c   = &replay_cursor[hdr->rec];
+    const uint8_t *  src = &replay_trace[hdr->data];
+    c->pos               = hdr->next;
+    c->t_ms              = hdr->t_ms;
+    replay_stats.records++;
+
+    if (hdr->len > REPLAY_DELTA_LEN_MAX)
+    {
+        if (NULL != out)
+        {
+            memcpy(out, src, hdr->len);
+        }
+        return;
+    }
+
+    /* Short payloads are decoded even when not wanted, the next one of the
+     * kind may be coded against this one */
+    const uint8_t *mask = src;
+    uint8_t        i;
+    if (hdr->delta)
+    {
+        src += REPLAY_MASK_LEN(hdr->len);
+    }
+    for (i = 0; i < hdr->len; i++)
+    {
+        if (!hdr->delta || ((mask[i / 8u] >> (i % 8u)) & 1u))
+        {
+            c->last.buf[i] = *src++;
+        }
+    }
+    c->last.len = (uint8_t)hdr->len;
+    if (NULL != out)
+    {
+        memcpy(out, c->last.buf, hdr->len);
+    }
+}
+
+
+static uint32_t REPLAY_now_ms(void)
+{
+    return TIMEBASE_get_ms() - replay_start_ms;
+}
+
+
+static void REPLAY_diverged(REPLAY_REC_t rec, uint32_t t_ms)
+{
+    if (replay_stats.diverged == 0)
+    {
+        replay_stats.first_diverged_ms  = t_ms;
+        replay_stats.first_diverged_rec = rec;
+    }
+    replay_stats.diverged++;
+}
+
+#endif /* #if !defined(TARGET_MCU) */
@@ -0,0 +1,58 @@
+/**
+ * @file replay_file.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Trace files for the native build
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ */
+#if !defined(TARGET_MCU)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "targets.h"
+#include "replay.h"
+
+
+void REPLAY_file_sink(const uint8_t *buf, uint16_t len, void *ctx)
+{
+    CONFIG_ASSERT(NULL != ctx);
+    (void)fwrite(buf, 1, len, (FILE *)ctx);
+}
+
+
+uint8_t *REPLAY_file_load(const char *path, uint32_t *len)
+{
+    CONFIG_ASSERT(NULL != path);
+    CONFIG_ASSERT(NULL != len);
+    uint8_t *trace = NULL;
+    FILE *   f     = fopen(path, "rb");
+    if (NULL == f)
+    {
+        return NULL;
+    }
+
+    if (fseek(f, 0, SEEK_END) == 0)
+    {
+        const long size = ftell(f);
+        if (size > 0 && fseek(f, 0, SEEK_SET) == 0)
+        {
+            trace = malloc((size_t)size);
+            if (NULL != trace &&
+                fread(trace, 1, (size_t)size, f) != (size_t)size)
+            {
+                free(trace);
+                trace = NULL;
+            }
+            *len = (uint32_t)size;
+        }
+    }
+    fclose(f);
+    return trace;
+}
+
+#endif /* #if !defined(TARGET_MCU) */
@@ -0,0 +1,123 @@
+/**
+ * @file sil.h
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Software in the loop simulator: the core modules of the firmware
+ * run against a model of the spacecraft through the emulated hardware
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ * @note Every step the plant writes the BNO055, ADS7841 (magnetometer, sun
+ * sensors and current sense) emulators, the firmware runs one millisecond of
+ * its main loop and the plant reads back the PWM duty cycles of the
+ * magnetorquers and reaction wheels as dipoles and wheel speed commands.
+ * The simulation is deterministic for a given seed.
+ *
+ * Command frames go through the OBC interface and are handled as in the
+ * main loop of main.c. A session can be recorded, and a recorded session
+ * played back: the plant stands still and the firmware gets the recorded
+ * frames, sensor samples and reference instead (see replay.h).
+ */
+#ifndef __SIL_H__
+#define __SIL_H__
+#ifdef __cplusplus
+/* clang-format off */
+extern "C"
+{
+/* clang-format on */
+#endif /* Start C linkage */
+#if !defined(TARGET_MCU)
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "attitude_types.h"
+#include "replay.h"
+
+/* Firmware main loop period, one TIMEBASE tick */
+#define SIL_STEP_US (1000u)
+
+typedef struct
+{
+    uint32_t seed;         /* sensor noise, 0 is replaced by a fixed seed */
+    float    time_accel;   /* simulated / wall time, 0 runs unpaced */
+    vec3_t   rate0_radps;  /* body rate after deployment */
+    bool     sensor_noise; /* false for noiseless sensors */
+
+    REPLAY_sink_func record;     /* records the session, NULL for none */
+    void *           record_ctx;
+    const uint8_t *  replay;     /* trace to play back, NULL for none */
+    uint32_t         replay_len;
+} SIL_config_t;
+
+/* clang-format off */
+#define SIL_CONFIG_DEFAULT                                                     \
+    {                                                                          \
+        .seed = 1u, .time_accel = 0.0f,                                        \
+        .rate0_radps = {0.035f, -0.026f, 0.017f}, .sensor_noise = true,        \
+    }
+/* clang-format on */
+
+typedef struct
+{
+    double t_s;
+    quat_t q_body;        /* true attitude, body to inertial */
+    vec3_t rate_radps;    /* true body rate */
+    vec3_t wheel_radps;   /* true wheel speeds */
+    vec3_t dipole_Am2;    /* coil dipole decoded from the PWM outputs */
+    vec3_t bfield_T;      /* true field in the body frame */
+    bool   eclipse;
+    float  nadir_err_deg; /* angle between body z and nadir */
+} SIL_state_t;
+
+
+/**
+ * @brief Reset the plant and the emulated hardware and boot the firmware
+ * in the same order as main.c
+ *
+ * @return int 0 on success, 1 if the trace to replay is not a trace
+ */
+int SIL_init(const SIL_config_t *config);
+
+/**
+ * @brief End the recording or the playback of the session
+ */
+void SIL_stop(void);
+
+/**
+ * @brief Advance the plant and the firmware by SIL_STEP_US, paced to the
+ * time acceleration of the configuration
+ */
+void SIL_step(void);
+
+/**
+ * @brief Step for duration_ms of simulated time
+ */
+void SIL_run(uint32_t duration_ms);
+
+void SIL_get_state(SIL_state_t *state);
+
+/**
+ * @brief Send a command frame, as the OBC would. It is handled on the next
+ * step
+ *
+ * @return int 0 on success, 1 if cmd is longer than a frame
+ */
+int SIL_obc_send(const char *cmd);
+
+/**
+ * @brief Simulated time, the timestamp MODE_run is given
+ */
+uint32_t SIL_now_us(void);
+
+#else
+#error THE SIMULATOR IS INTENDED FOR TESTING ON NATIVE PLATFORMS
+#endif /* !#if defined(TARGET_MCU) */
+
+#ifdef __cplusplus
+/* clang-format off */
+}
+/* clang-format on */
+#endif /* End C linkage */
+#endif /* __SIL_H__ */
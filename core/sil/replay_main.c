@@ -0,0 +1,87 @@
+/**
+ * @file replay_main.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Command line front end playing back a recorded session
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ * @note usage: adcs_replay trace [speed]
+ * A speed of 0 (the default) plays back as fast as the host allows, 1 in
+ * real time. Exits with 1 if the firmware did not reproduce the recording:
+ * an output differs, or it asked for an input that was not recorded.
+ */
+#if defined(TARGET_MCU)
+#error THE SIMULATOR IS INTENDED FOR TESTING ON NATIVE PLATFORMS
+#endif /* #if defined(TARGET_MCU) */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "sil.h"
+#include "replay.h"
+
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        printf("usage: %s trace [speed]\n", argv[0]);
+        return 1;
+    }
+
+    SIL_config_t config = SIL_CONFIG_DEFAULT;
+    config.replay       = REPLAY_file_load(argv[1], &config.replay_len);
+    if (argc > 2)
+    {
+        config.time_accel = strtof(argv[2], NULL);
+    }
+    if (NULL == config.replay)
+    {
+        printf("cannot read %s\n", argv[1]);
+        return 1;
+    }
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    int status = SIL_init(&config);
+    if (status)
+    {
+        printf("%s is not a trace\n", argv[1]);
+    }
+    else
+    {
+        while (!REPLAY_play_done())
+        {
+            SIL_step();
+        }
+        SIL_stop();
+
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        const double wall_s = (end.tv_sec - start.tv_sec) +
+                              (end.tv_nsec - start.tv_nsec) / 1.0e9;
+        const double sim_s  = REPLAY_play_duration_ms() / 1000.0;
+
+        REPLAY_stats_t stats;
+        REPLAY_get_stats(&stats);
+        printf("%.1f s played back in %.2f s, %.0fx real time\n"
+               "%u inputs, %u missing, %u outputs reproduced, %u diverged\n",
+               sim_s, wall_s, sim_s / wall_s, stats.inputs,
+               stats.inputs_missing, stats.outputs, stats.diverged);
+        if (stats.diverged > 0)
+        {
+            status = 1;
+            printf("first divergence : record %u at %u ms\n",
+                   (unsigned int)stats.first_diverged_rec,
+                   stats.first_diverged_ms);
+        }
+        status |= (stats.inputs_missing > 0);
+    }
+
+    free((void *)config.replay);
+    return status;
+}
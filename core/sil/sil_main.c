@@ -0,0 +1,104 @@
+/**
+ * @file sil_main.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Command line front end of the software in the loop simulator
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ * @note usage: adcs_sil [duration_s] [time_accel] [seed] [trace]
+ * A time_accel of 0 (the default) runs as fast as the host allows. The
+ * session is recorded to the trace file if one is given, adcs_replay plays
+ * it back.
+ */
+#if defined(TARGET_MCU)
+#error THE SIMULATOR IS INTENDED FOR TESTING ON NATIVE PLATFORMS
+#endif /* #if defined(TARGET_MCU) */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include <math.h>
+
+#include "sil.h"
+#include "adcs_modes.h"
+#include "replay.h"
+
+#define SIL_MAIN_DEFAULT_DURATION_S (3000u)
+#define SIL_MAIN_REPORT_MS (10000u)
+
+
+int main(int argc, char **argv)
+{
+    SIL_config_t config     = SIL_CONFIG_DEFAULT;
+    uint32_t     duration_s = SIL_MAIN_DEFAULT_DURATION_S;
+    if (argc > 1)
+    {
+        duration_s = (uint32_t)strtoul(argv[1], NULL, 0);
+    }
+    if (argc > 2)
+    {
+        config.time_accel = strtof(argv[2], NULL);
+    }
+    if (argc > 3)
+    {
+        config.seed = (uint32_t)strtoul(argv[3], NULL, 0);
+    }
+    FILE *trace = NULL;
+    if (argc > 4)
+    {
+        trace = fopen(argv[4], "wb");
+        if (NULL == trace)
+        {
+            printf("cannot write %s\n", argv[4]);
+            return 1;
+        }
+        config.record     = REPLAY_file_sink;
+        config.record_ctx = trace;
+    }
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    SIL_init(&config);
+    SIL_obc_send("{\"mode\":\"detumble\"}"); /* after deployment */
+
+    ADCS_MODE_t mode = MODE_get();
+    uint32_t    t_ms;
+    for (t_ms = 0; t_ms < duration_s * 1000u; t_ms += SIL_MAIN_REPORT_MS)
+    {
+        SIL_run(SIL_MAIN_REPORT_MS);
+
+        SIL_state_t s;
+        SIL_get_state(&s);
+        if (MODE_get() != mode)
+        {
+            printf("t = %7.1f s : %s -> %s\n", s.t_s, MODE_to_string(mode),
+                   MODE_to_string(MODE_get()));
+            mode = MODE_get();
+        }
+        printf("t = %7.1f s %-9s |w| = %.5f rad/s nadir = %6.1f deg "
+               "wheels = [%6.2f %6.2f %6.2f] rad/s%s\n",
+               s.t_s, MODE_to_string(mode),
+               sqrt(s.rate_radps.x * s.rate_radps.x +
+                    s.rate_radps.y * s.rate_radps.y +
+                    s.rate_radps.z * s.rate_radps.z),
+               s.nadir_err_deg, s.wheel_radps.x, s.wheel_radps.y,
+               s.wheel_radps.z, s.eclipse ? " eclipse" : "");
+    }
+
+    SIL_stop();
+    if (NULL != trace)
+    {
+        fclose(trace);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    const double wall_s = (end.tv_sec - start.tv_sec) +
+                          (end.tv_nsec - start.tv_nsec) / 1.0e9;
+    printf("%u s simulated in %.2f s, %.0fx real time\n", duration_s, wall_s,
+           duration_s / wall_s);
+    return 0;
+}
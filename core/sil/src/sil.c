@@ -0,0 +1,666 @@
+/**
+ * @file sil.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Software in the loop simulator
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ * @note The firmware has no guidance, the simulator gives the attitude
+ * controller the nadir reference of the plant's orbit every step. The
+ * actuators are read from the timers of the native HAL through the pinout of
+ * the board and the wheel speeds go back as OUTFG edges on the TB0 captures.
+ * The wheel pwm carries only the speed magnitude and there is no direction
+ * line, so the direction is taken from RW_get_direction.
+ *
+ * A playback runs the same steps without the plant. The reference the
+ * simulator gives the controller is recorded as an input like the sensors.
+ */
+#if defined(TARGET_MCU)
+#error THE SIMULATOR IS INTENDED FOR TESTING ON NATIVE PLATFORMS
+#endif /* #if defined(TARGET_MCU) */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <errno.h>
+
+#include "targets.h"
+#include "pwm.h"
+#include "sil.h"
+#include "sil_plant.h"
+
+#include "adcs_modes.h"
+#include "attitude_control.h"
+#include "imu.h"
+#include "magnetometer.h"
+#include "magnetorquers.h"
+#include "reaction_wheels.h"
+#include "parameters.h"
+#include "telemetry.h"
+#include "tlm_stream.h"
+#include "timebase.h"
+#include "obc_interface.h"
+#include "obc_frame.h"
+#include "jsons.h"
+#include "replay.h"
+#include "profiling.h"
+
+#include "i2c_emulator.h"
+#include "bno055_emulator.h"
+#include "ads7841_emulator.h"
+#include "flash_emulator.h"
+#include "hal.h"
+#include "hal_native.h"
+
+#define SIL_PI (3.14159265358979)
+#define SIL_DEFAULT_SEED (0x2545F491u)
+
+/* Coils, 5 % weaker than the controller assumes. The current follows the
+ * drive with the L/R time constant and leaks into the magnetometer */
+#define SIL_COIL_DIPOLE_MAX_AM2 (0.19)
+#define SIL_COIL_TAU_S (0.002)
+#define SIL_COIL_RESISTANCE_OHM (30.0)
+#define SIL_COIL_CROSSTALK_T_PER_AM2 (5.0e-5)
+
+/* Wheel drivers regulate to a speed proportional to their voltage, full
+ * scale at the full supply. Motor current is idle plus torque over the
+ * torque constant */
+#define SIL_WHEEL_SPEED_MAX_RADPS (628.0)
+#define SIL_WHEEL_RPH_PER_RADPS (3600.0)
+#define SIL_WHEEL_INERTIA_KGM2 (1.1e-5)
+#define SIL_WHEEL_KT_NM_PER_A (2.0e-3)
+#define SIL_WHEEL_IDLE_MA (20.0)
+#define SIL_WHEEL_OUTFG_EDGES_PER_REV (6.0) /* see reaction_wheels.c */
+
+/* Sensor models */
+#define SIL_SUN_FULL_SCALE_COUNTS (3000.0)
+#define SIL_SUN_NOISE_COUNTS (3.0)
+#define SIL_MAG_NOISE_T (2.0e-7)
+#define SIL_CURRENT_NOISE_COUNTS (1.0)
+#define SIL_IMU_ANGLE_NOISE_RAD (2.0e-3)
+#define SIL_IMU_GYRO_NOISE_DPS (0.1)
+#define SIL_IMU_MAG_NOISE_UT (0.5)
+#define SIL_IMU_ACCEL_NOISE_MPS2 (0.05)
+
+/* BNO055 output scaling */
+#define SIL_BNO055_QUAT_LSB (16384.0)
+#define SIL_BNO055_GYRO_LSB_PER_DPS (16.0)
+#define SIL_BNO055_MAG_LSB_PER_UT (16.0)
+#define SIL_BNO055_ACCEL_LSB_PER_MPS2 (100.0)
+
+#define SIL_STEP_S ((SIL_STEP_US) / 1.0e6)
+#define SIL_NS_PER_S (1000000000LL)
+#define SIL_PACE_SLACK_NS (1000000LL) /* sleep once at least 1 ms ahead */
+
+/* Pinout of the actuators, see magnetorquers.c and reaction_wheels.c */
+typedef struct
+{
+    HAL_TIMER_t tmr;
+    uint8_t     pos_ccr;
+    uint8_t     neg_ccr;
+} SIL_coil_pwm_t;
+
+typedef struct
+{
+    HAL_TIMER_t tmr;
+    uint8_t     ccr;
+} SIL_wheel_pwm_t;
+
+static const SIL_coil_pwm_t SIL_coil_pwm[] = {
+    {HAL_TIMER_A0, 2, 1},
+    {HAL_TIMER_A1, 1, 2},
+    {HAL_TIMER_A0, 3, 4},
+};
+
+static const SIL_wheel_pwm_t SIL_wheel_pwm[] = {
+    {HAL_TIMER_B0, 5},
+    {HAL_TIMER_A2, 1},
+    {HAL_TIMER_A2, 2},
+};
+
+/* OUTFG capture channels of TB0 */
+static const uint8_t SIL_wheel_outfg_ccr[] = {6, 1, 2};
+
+static SIL_config_t    sil_config;
+static SIL_plant_t     sil_plant;
+static SIL_vec_t       sil_coil_Am2;
+static SIL_vec_t       sil_wheel_cmd_radps;
+static SIL_vec_t       sil_wheel_acc_radps2;
+static double          sil_wheel_edges[NUM_REACTION_WHEELS]; /* fraction */
+static uint64_t        sil_steps;
+static uint32_t        sil_rng;
+static struct timespec sil_wall_start;
+static bool            sil_replaying;
+
+
+static double   SIL_uniform(void);
+static double   SIL_gauss(double sigma);
+static int16_t  SIL_sat_i16(double v);
+static uint16_t SIL_counts(double v);
+static double   SIL_coil_duty(unsigned int axis);
+static double   SIL_wheel_duty(REAC_WHEEL_t rw);
+static void     SIL_read_actuators(void);
+static void     SIL_write_imu(void);
+static void     SIL_write_magtom(void);
+static void     SIL_write_sun(void);
+static void     SIL_write_current_sense(void);
+static void     SIL_write_tachometers(void);
+static void     SIL_write_sensors(void);
+static void     SIL_set_reference(void);
+static void     SIL_pace(void);
+static int      SIL_obc_tx(uint8_t *buf, uint16_t len);
+static void     SIL_obc_feed(const uint8_t *payload, uint16_t len);
+static void     SIL_obc_service(void);
+
+
+int SIL_init(const SIL_config_t *config)
+{
+    CONFIG_ASSERT(NULL != config);
+    sil_config    = *config;
+    sil_replaying = false;
+    sil_rng       = (0 != config->seed) ? config->seed : SIL_DEFAULT_SEED;
+    sil_steps     = 0;
+    memset(&sil_coil_Am2, 0, sizeof(sil_coil_Am2));
+    memset(&sil_wheel_cmd_radps, 0, sizeof(sil_wheel_cmd_radps));
+    memset(&sil_wheel_acc_radps2, 0, sizeof(sil_wheel_acc_radps2));
+    memset(sil_wheel_edges, 0, sizeof(sil_wheel_edges));
+
+    /* A fresh board, the parameters and the log start erased */
+    FLASH_EMU_init();
+    I2C_EMU_init();
+    BNO055_EMU_attach(IMU_I2C_ADDR);
+    ADS7841_EMU_init();
+    HAL_NATIVE_reset();
+    HAL_NATIVE_set_clock(SIL_now_us);
+
+    SIL_plant_init(&sil_plant,
+                   SIL_vec_make(config->rate0_radps.x, config->rate0_radps.y,
+                                config->rate0_radps.z));
+    SIL_write_sensors();
+
+    /* Same order as main.c, the session starts with the first tick */
+    OBC_IF_config_native(SIL_obc_tx);
+    TIMEBASE_init();
+    PROF_init();
+    if (NULL != config->replay)
+    {
+        if (REPLAY_play_start(config->replay, config->replay_len))
+        {
+            return 1;
+        }
+        sil_replaying = true;
+    }
+    else if (NULL != config->record)
+    {
+        REPLAY_record_start(config->record, config->record_ctx);
+    }
+    PARAM_init();
+    TLM_init();
+    TLM_stream_init();
+    IMU_init();
+    MAGTOM_init();
+    RW_init();
+    MQTR_init();
+    MODE_init();
+
+    /* Calibrate the speed scale to the simulated drivers, the default is
+     * far below what the controller commands */
+    PARAM_set_float(PARAM_rw_rph_mv,
+                    (float)(SIL_WHEEL_SPEED_MAX_RADPS *
+                            SIL_WHEEL_RPH_PER_RADPS / PWM_VMAX_MV_float));
+
+    /* Let the scheduler pick up the boot profile */
+    SIL_set_reference();
+    MODE_run(SIL_now_us());
+    clock_gettime(CLOCK_MONOTONIC, &sil_wall_start);
+    return 0;
+}
+
+
+void SIL_stop(void)
+{
+    REPLAY_stop();
+    sil_replaying = false;
+}
+
+
+void SIL_step(void)
+{
+    if (!sil_replaying)
+    {
+        const SIL_vec_t wheel_before = sil_plant.wheel_radps;
+        SIL_read_actuators();
+        SIL_plant_step(&sil_plant, sil_coil_Am2, sil_wheel_cmd_radps,
+                       SIL_STEP_S);
+        sil_wheel_acc_radps2.x = (sil_plant.wheel_radps.x - wheel_before.x) /
+                                 SIL_STEP_S;
+        sil_wheel_acc_radps2.y = (sil_plant.wheel_radps.y - wheel_before.y) /
+                                 SIL_STEP_S;
+        sil_wheel_acc_radps2.z = (sil_plant.wheel_radps.z - wheel_before.z) /
+                                 SIL_STEP_S;
+        SIL_write_sensors();
+        SIL_write_tachometers();
+    }
+    sil_steps++;
+    if (0 == sil_steps % ATTCTRL_LOOP_PERIOD_MS)
+    {
+        /* The control loop reads it once a period */
+        SIL_set_reference();
+    }
+
+    /* One tick of the firmware main loop. Bus transfers move the I2C clock
+     * on their own, never move it back */
+    const uint32_t now_us = SIL_now_us();
+    if ((int32_t)(now_us - I2C_EMU_get_time_us()) > 0)
+    {
+        I2C_EMU_set_time_us(now_us);
+    }
+    TIMEBASE_tick();
+    SIL_obc_service();
+    MODE_run(now_us);
+
+    SIL_pace();
+}
+
+
+void SIL_run(uint32_t duration_ms)
+{
+    uint64_t steps = (uint64_t)duration_ms * 1000u / SIL_STEP_US;
+    while (steps-- > 0)
+    {
+        SIL_step();
+    }
+}
+
+
+void SIL_get_state(SIL_state_t *state)
+{
+    CONFIG_ASSERT(NULL != state);
+    state->t_s           = sil_plant.t_s;
+    state->q_body.w      = (float)sil_plant.q.w;
+    state->q_body.x      = (float)sil_plant.q.x;
+    state->q_body.y      = (float)sil_plant.q.y;
+    state->q_body.z      = (float)sil_plant.q.z;
+    state->rate_radps.x  = (float)sil_plant.w_radps.x;
+    state->rate_radps.y  = (float)sil_plant.w_radps.y;
+    state->rate_radps.z  = (float)sil_plant.w_radps.z;
+    state->wheel_radps.x = (float)sil_plant.wheel_radps.x;
+    state->wheel_radps.y = (float)sil_plant.wheel_radps.y;
+    state->wheel_radps.z = (float)sil_plant.wheel_radps.z;
+    state->dipole_Am2.x  = (float)sil_coil_Am2.x;
+    state->dipole_Am2.y  = (float)sil_coil_Am2.y;
+    state->dipole_Am2.z  = (float)sil_coil_Am2.z;
+    state->bfield_T.x    = (float)sil_plant.b_body_T.x;
+    state->bfield_T.y    = (float)sil_plant.b_body_T.y;
+    state->bfield_T.z    = (float)sil_plant.b_body_T.z;
+    state->eclipse       = sil_plant.eclipse;
+    state->nadir_err_deg = (float)SIL_plant_nadir_error_deg(&sil_plant);
+}
+
+
+uint32_t SIL_now_us(void)
+{
+    return (uint32_t)(sil_steps * SIL_STEP_US);
+}
+
+
+int SIL_obc_send(const char *cmd)
+{
+    CONFIG_ASSERT(NULL != cmd);
+    const size_t len = strlen(cmd);
+    if (len > OBC_RX_FRAME_LEN)
+    {
+        return 1;
+    }
+    SIL_obc_feed((const uint8_t *)cmd, (uint16_t)len);
+    return 0;
+}
+
+
+/* xorshift32, the firmware never draws from it */
+static double SIL_uniform(void)
+{
+    sil_rng ^= sil_rng << 13;
+    sil_rng ^= sil_rng >> 17;
+    sil_rng ^= sil_rng << 5;
+    return (sil_rng + 1.0) / 4294967297.0;
+}
+
+
+static double SIL_gauss(double sigma)
+{
+    if (!sil_config.sensor_noise)
+    {
+        return 0.0;
+    }
+    const double u1 = SIL_uniform();
+    const double u2 = SIL_uniform();
+    return sigma * sqrt(-2.0 * log(u1)) * cos(2.0 * SIL_PI * u2);
+}
+
+
+static int16_t SIL_sat_i16(double v)
+{
+    if (v > INT16_MAX)
+    {
+        return INT16_MAX;
+    }
+    if (v < INT16_MIN)
+    {
+        return INT16_MIN;
+    }
+    return (int16_t)lround(v);
+}
+
+
+static uint16_t SIL_counts(double v)
+{
+    if (v < 0.0)
+    {
+        return 0;
+    }
+    if (v > ADS7841_EMU_COUNTS_MAX)
+    {
+        return ADS7841_EMU_COUNTS_MAX;
+    }
+    return (uint16_t)lround(v);
+}
+
+
+/* Signed duty of the H bridge of a coil as a fraction of the full drive */
+static double SIL_coil_duty(unsigned int axis)
+{
+    const SIL_coil_pwm_t *pwm = &SIL_coil_pwm[axis];
+    return (HAL_NATIVE_get_duty(pwm->tmr, pwm->pos_ccr) -
+            HAL_NATIVE_get_duty(pwm->tmr, pwm->neg_ccr)) /
+           PWM_MAX_DUTY_CYCLE_float;
+}
+
+
+static double SIL_wheel_duty(REAC_WHEEL_t rw)
+{
+    const SIL_wheel_pwm_t *pwm = &SIL_wheel_pwm[rw];
+    const double duty = HAL_NATIVE_get_duty(pwm->tmr, pwm->ccr) /
+                        PWM_MAX_DUTY_CYCLE_float;
+    return (RW_get_direction(rw) == ROT_DIR_anticlock) ? duty : -duty;
+}
+
+
+static void SIL_read_actuators(void)
+{
+    const double k = 1.0 - exp(-SIL_STEP_S / SIL_COIL_TAU_S);
+    sil_coil_Am2.x +=
+        (SIL_coil_duty(0) * SIL_COIL_DIPOLE_MAX_AM2 - sil_coil_Am2.x) * k;
+    sil_coil_Am2.y +=
+        (SIL_coil_duty(1) * SIL_COIL_DIPOLE_MAX_AM2 - sil_coil_Am2.y) * k;
+    sil_coil_Am2.z +=
+        (SIL_coil_duty(2) * SIL_COIL_DIPOLE_MAX_AM2 - sil_coil_Am2.z) * k;
+
+    sil_wheel_cmd_radps.x =
+        SIL_wheel_duty(REAC_WHEEL_x) * SIL_WHEEL_SPEED_MAX_RADPS;
+    sil_wheel_cmd_radps.y =
+        SIL_wheel_duty(REAC_WHEEL_y) * SIL_WHEEL_SPEED_MAX_RADPS;
+    sil_wheel_cmd_radps.z =
+        SIL_wheel_duty(REAC_WHEEL_z) * SIL_WHEEL_SPEED_MAX_RADPS;
+}
+
+
+static void SIL_write_imu(void)
+{
+    /* Fused attitude with a small random rotation */
+    const double ex = SIL_gauss(SIL_IMU_ANGLE_NOISE_RAD) / 2.0;
+    const double ey = SIL_gauss(SIL_IMU_ANGLE_NOISE_RAD) / 2.0;
+    const double ez = SIL_gauss(SIL_IMU_ANGLE_NOISE_RAD) / 2.0;
+    const SIL_quat_t q = sil_plant.q;
+    SIL_quat_t       m;
+    m.w = q.w - q.x * ex - q.y * ey - q.z * ez;
+    m.x = q.x + q.w * ex + q.y * ez - q.z * ey;
+    m.y = q.y + q.w * ey - q.x * ez + q.z * ex;
+    m.z = q.z + q.w * ez + q.x * ey - q.y * ex;
+    const double n = sqrt(m.w * m.w + m.x * m.x + m.y * m.y + m.z * m.z);
+    BNO055_EMU_set_quaternion(SIL_sat_i16(m.w / n * SIL_BNO055_QUAT_LSB),
+                              SIL_sat_i16(m.x / n * SIL_BNO055_QUAT_LSB),
+                              SIL_sat_i16(m.y / n * SIL_BNO055_QUAT_LSB),
+                              SIL_sat_i16(m.z / n * SIL_BNO055_QUAT_LSB));
+
+    const double dps = 180.0 / SIL_PI;
+    BNO055_EMU_set_gyro(
+        SIL_sat_i16((sil_plant.w_radps.x * dps +
+                     SIL_gauss(SIL_IMU_GYRO_NOISE_DPS)) *
+                    SIL_BNO055_GYRO_LSB_PER_DPS),
+        SIL_sat_i16((sil_plant.w_radps.y * dps +
+                     SIL_gauss(SIL_IMU_GYRO_NOISE_DPS)) *
+                    SIL_BNO055_GYRO_LSB_PER_DPS),
+        SIL_sat_i16((sil_plant.w_radps.z * dps +
+                     SIL_gauss(SIL_IMU_GYRO_NOISE_DPS)) *
+                    SIL_BNO055_GYRO_LSB_PER_DPS));
+
+    BNO055_EMU_set_mag(
+        SIL_sat_i16((sil_plant.b_body_T.x * 1.0e6 +
+                     SIL_gauss(SIL_IMU_MAG_NOISE_UT)) *
+                    SIL_BNO055_MAG_LSB_PER_UT),
+        SIL_sat_i16((sil_plant.b_body_T.y * 1.0e6 +
+                     SIL_gauss(SIL_IMU_MAG_NOISE_UT)) *
+                    SIL_BNO055_MAG_LSB_PER_UT),
+        SIL_sat_i16((sil_plant.b_body_T.z * 1.0e6 +
+                     SIL_gauss(SIL_IMU_MAG_NOISE_UT)) *
+                    SIL_BNO055_MAG_LSB_PER_UT));
+
+    /* Free fall */
+    BNO055_EMU_set_accel(
+        SIL_sat_i16(SIL_gauss(SIL_IMU_ACCEL_NOISE_MPS2) *
+                    SIL_BNO055_ACCEL_LSB_PER_MPS2),
+        SIL_sat_i16(SIL_gauss(SIL_IMU_ACCEL_NOISE_MPS2) *
+                    SIL_BNO055_ACCEL_LSB_PER_MPS2),
+        SIL_sat_i16(SIL_gauss(SIL_IMU_ACCEL_NOISE_MPS2) *
+                    SIL_BNO055_ACCEL_LSB_PER_MPS2));
+}
+
+
+/* Inverse of the count to field conversion of the magnetometer module, with
+ * the field of the coils on top */
+static void SIL_write_magtom(void)
+{
+    const double t_cnt  = PARAM_get_float(PARAM_mag_t_cnt);
+    const double zero   = PARAM_get_float(PARAM_mag_zero_cnt);
+    const double b[3]   = {
+        sil_plant.b_body_T.x + sil_coil_Am2.x * SIL_COIL_CROSSTALK_T_PER_AM2,
+        sil_plant.b_body_T.y + sil_coil_Am2.y * SIL_COIL_CROSSTALK_T_PER_AM2,
+        sil_plant.b_body_T.z + sil_coil_Am2.z * SIL_COIL_CROSSTALK_T_PER_AM2,
+    };
+    const PARAM_t ch[3] = {PARAM_mag_ch_x, PARAM_mag_ch_y, PARAM_mag_ch_z};
+    unsigned int  axis;
+    for (axis = 0; axis < 3; axis++)
+    {
+        const double counts = zero + (b[axis] + SIL_gauss(SIL_MAG_NOISE_T)) /
+                                         t_cnt;
+        ADS7841_EMU_set_channel(ADS7841_EMU_DEV_magtom,
+                                (uint8_t)PARAM_get_int(ch[axis]),
+                                SIL_counts(counts));
+    }
+}
+
+
+/* Three photodiodes per face, cosine response */
+static void SIL_write_sun(void)
+{
+    const double cosines[ADS7841_EMU_DEV_sun_z_neg -
+                         ADS7841_EMU_DEV_sun_x_pos + 1] = {
+        sil_plant.sun_body.x, -sil_plant.sun_body.x, sil_plant.sun_body.y,
+        -sil_plant.sun_body.y, sil_plant.sun_body.z, -sil_plant.sun_body.z,
+    };
+    unsigned int face;
+    uint8_t      ch;
+    for (face = 0; face < sizeof(cosines) / sizeof(cosines[0]); face++)
+    {
+        double lit = 0.0;
+        if (!sil_plant.eclipse && cosines[face] > 0.0)
+        {
+            lit = cosines[face] * SIL_SUN_FULL_SCALE_COUNTS;
+        }
+        for (ch = 1; ch <= 3; ch++)
+        {
+            ADS7841_EMU_set_channel(
+                (ADS7841_EMU_DEV_t)(ADS7841_EMU_DEV_sun_x_pos + face), ch,
+                SIL_counts(lit + SIL_gauss(SIL_SUN_NOISE_COUNTS)));
+        }
+    }
+}
+
+
+/* Current sense counts are millivolts, the inverse of the ma_mv factors */
+static void SIL_write_current_sense(void)
+{
+    const double  coil_ma_per_Am2 = PWM_VMAX_MV_float /
+                                   SIL_COIL_RESISTANCE_OHM /
+                                   SIL_COIL_DIPOLE_MAX_AM2;
+    const double  coil[3]         = {sil_coil_Am2.x, sil_coil_Am2.y,
+                                     sil_coil_Am2.z};
+    const double  acc[3]          = {sil_wheel_acc_radps2.x,
+                                     sil_wheel_acc_radps2.y,
+                                     sil_wheel_acc_radps2.z};
+    const PARAM_t mqtr_ch[3]      = {PARAM_mqtr_ch_x, PARAM_mqtr_ch_y,
+                                     PARAM_mqtr_ch_z};
+    const PARAM_t rw_ch[3] = {PARAM_rw_ch_x, PARAM_rw_ch_y, PARAM_rw_ch_z};
+    unsigned int  axis;
+    for (axis = 0; axis < 3; axis++)
+    {
+        const double coil_ma = fabs(coil[axis]) * coil_ma_per_Am2;
+        ADS7841_EMU_set_channel(
+            ADS7841_EMU_DEV_mqtr, (uint8_t)PARAM_get_int(mqtr_ch[axis]),
+            SIL_counts(coil_ma / PARAM_get_float(PARAM_mqtr_ma_mv) +
+                       SIL_gauss(SIL_CURRENT_NOISE_COUNTS)));
+
+        const double rw_ma = SIL_WHEEL_IDLE_MA +
+                             fabs(acc[axis]) * SIL_WHEEL_INERTIA_KGM2 /
+                                 SIL_WHEEL_KT_NM_PER_A * 1000.0;
+        ADS7841_EMU_set_channel(
+            ADS7841_EMU_DEV_rw, (uint8_t)PARAM_get_int(rw_ch[axis]),
+            SIL_counts(rw_ma / PARAM_get_float(PARAM_rw_ma_mv) +
+                       SIL_gauss(SIL_CURRENT_NOISE_COUNTS)));
+    }
+}
+
+
+/* Edges of the step, timed at the end of step speed */
+static void SIL_write_tachometers(void)
+{
+    const double w[] = {sil_plant.wheel_radps.x, sil_plant.wheel_radps.y,
+                        sil_plant.wheel_radps.z};
+    const double t_end_s = (double)(sil_steps + 1u) * SIL_STEP_S;
+
+    unsigned int rw;
+    for (rw = 0; rw < NUM_REACTION_WHEELS; rw++)
+    {
+        const double edges_per_s =
+            fabs(w[rw]) * SIL_WHEEL_OUTFG_EDGES_PER_REV / (2.0 * SIL_PI);
+        sil_wheel_edges[rw] += edges_per_s * SIL_STEP_S;
+        while (sil_wheel_edges[rw] >= 1.0)
+        {
+            sil_wheel_edges[rw] -= 1.0;
+            const double t_s = t_end_s - sil_wheel_edges[rw] / edges_per_s;
+            const uint64_t counts = (uint64_t)(t_s * HAL_NATIVE_SMCLK_HZ);
+            HAL_NATIVE_capture_edge(HAL_TIMER_B0, SIL_wheel_outfg_ccr[rw],
+                                    (uint32_t)counts);
+        }
+    }
+}
+
+
+static void SIL_write_sensors(void)
+{
+    SIL_write_imu();
+    SIL_write_magtom();
+    SIL_write_sun();
+    SIL_write_current_sense();
+}
+
+
+/* Stands in for the guidance the firmware does not have yet */
+static void SIL_set_reference(void)
+{
+    SIL_quat_t q;
+    double     w0;
+    SIL_plant_nadir(&sil_plant, &q, &w0);
+    struct
+    {
+        quat_t q;
+        vec3_t rate;
+    } ref = {
+        .q    = {(float)q.w, (float)q.x, (float)q.y, (float)q.z},
+        .rate = {0.0f, (float)-w0, 0.0f},
+    };
+    REPLAY_input(REPLAY_REC_reference, &ref, sizeof(ref));
+    ATTCTRL_set_reference(ref.q, ref.rate);
+}
+
+
+/* Sleep only once the simulation is a millisecond ahead of the wall clock
+ * so fast accelerations do not pay a system call per step */
+static void SIL_pace(void)
+{
+    if (sil_config.time_accel <= 0.0f)
+    {
+        return;
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    const long long sim_ns =
+        (long long)(sil_plant.t_s / sil_config.time_accel * SIL_NS_PER_S);
+    const long long wall_ns =
+        (now.tv_sec - sil_wall_start.tv_sec) * SIL_NS_PER_S +
+        (now.tv_nsec - sil_wall_start.tv_nsec);
+    const long long ahead_ns = sim_ns - wall_ns;
+    if (ahead_ns >= SIL_PACE_SLACK_NS)
+    {
+        struct timespec delay;
+        delay.tv_sec  = ahead_ns / SIL_NS_PER_S;
+        delay.tv_nsec = ahead_ns % SIL_NS_PER_S;
+        while (nanosleep(&delay, &delay) != 0 && errno == EINTR)
+        {
+        }
+    }
+}
+
+
+/* Nothing listens on the link, the replies are recorded or compared by the
+ * hook in OBC_IF_tx */
+static int SIL_obc_tx(uint8_t *buf, uint16_t len)
+{
+    (void)buf;
+    return len;
+}
+
+
+/* Frame the payload and receive it a byte at a time, as the uart would */
+static void SIL_obc_feed(const uint8_t *payload, uint16_t len)
+{
+    uint8_t        frame[OBC_FRAME_WIRE_LEN(OBC_RX_FRAME_LEN)];
+    const uint16_t head = OBC_FRAME_HEAD(OBC_RX_FRAME_LEN);
+    memcpy(&frame[head], payload, len);
+    const uint16_t frame_len = OBC_FRAME_encode(frame, head, len);
+    uint16_t       i;
+    for (i = 0; i < frame_len; i++)
+    {
+        OBC_IF_receive_byte(frame[i]);
+    }
+}
+
+
+/* The main loop of main.c, played back frames arrive first */
+static void SIL_obc_service(void)
+{
+    uint8_t  payload[OBC_RX_FRAME_LEN];
+    uint16_t len = sizeof(payload);
+    while (REPLAY_input_due(REPLAY_REC_obc_rx, payload, &len) == 0)
+    {
+        SIL_obc_feed(payload, len);
+        len = sizeof(payload);
+    }
+    json_service();
+}
@@ -0,0 +1,361 @@
+/**
+ * @file sil_plant.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Spacecraft and environment model of the software in the loop
+ * simulator
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ * @note A rigid body with 3 orthogonal reaction wheels in a circular 400 km
+ * orbit. Torques are the coil dipole and a residual dipole in a tilted
+ * dipole geomagnetic field, gravity gradient and the wheel reactions. The
+ * sun is fixed along inertial +x and the earth shadow is a cylinder.
+ */
+#include <stddef.h>
+#include <stdbool.h>
+#include <math.h>
+
+#include "targets.h"
+#include "sil_plant.h"
+
+#define SIL_PI (3.14159265358979)
+
+#define SIL_EARTH_RADIUS_M (6371.0e3)
+#define SIL_EARTH_MU (3.986004418e14)
+#define SIL_EARTH_B0_T (3.12e-5)
+#define SIL_EARTH_DIPOLE_TILT_RAD (11.0 * SIL_PI / 180.0)
+#define SIL_ORBIT_ALTITUDE_M (400.0e3)
+#define SIL_ORBIT_INCLINATION_RAD (51.6 * SIL_PI / 180.0)
+
+/* Mass properties, deliberately different from the controller's model */
+#define SIL_INERTIA_X (0.0215)
+#define SIL_INERTIA_Y (0.0198)
+#define SIL_INERTIA_Z (0.0064)
+#define SIL_RESIDUAL_DIPOLE_AM2 (2.0e-3)
+
+/* Wheels follow their speed command with a first order lag, limited by the
+ * motor torque */
+#define SIL_WHEEL_INERTIA_KGM2 (1.1e-5)
+#define SIL_WHEEL_TAU_S (0.2)
+#define SIL_WHEEL_TORQUE_MAX_NM (2.0e-4)
+
+/* Longest integration step, longer steps are split */
+#define SIL_SUBSTEP_MAX_S (0.01)
+
+static SIL_vec_t  SIL_vec_add(SIL_vec_t a, SIL_vec_t b);
+static SIL_vec_t  SIL_vec_scale(SIL_vec_t a, double k);
+static double     SIL_vec_dot(SIL_vec_t a, SIL_vec_t b);
+static SIL_vec_t  SIL_vec_cross(SIL_vec_t a, SIL_vec_t b);
+static SIL_vec_t  SIL_vec_unit(SIL_vec_t a);
+static SIL_quat_t SIL_quat_mul(SIL_quat_t a, SIL_quat_t b);
+static SIL_vec_t  SIL_quat_rotate(SIL_quat_t q, SIL_vec_t v);
+static SIL_vec_t  SIL_quat_rotate_inv(SIL_quat_t q, SIL_vec_t v);
+static SIL_quat_t SIL_quat_integrate(SIL_quat_t q, SIL_vec_t w, double dt);
+static SIL_quat_t SIL_quat_from_axes(SIL_vec_t x, SIL_vec_t y, SIL_vec_t z);
+static double     SIL_orbit_rate(void);
+static void       SIL_plant_environment(SIL_plant_t *p);
+static SIL_vec_t  SIL_plant_wheel_accel(const SIL_plant_t *p,
+                                        SIL_vec_t wheel_cmd_radps);
+static double     SIL_wheel_accel(double speed, double cmd);
+
+
+void SIL_plant_init(SIL_plant_t *p, SIL_vec_t w0_radps)
+{
+    CONFIG_ASSERT(NULL != p);
+    const SIL_quat_t q0 = {0.8, 0.4, -0.3, 0.3387};
+    const double     n  = sqrt(q0.w * q0.w + q0.x * q0.x + q0.y * q0.y +
+                          q0.z * q0.z);
+    p->t_s         = 0.0;
+    p->q.w         = q0.w / n;
+    p->q.x         = q0.x / n;
+    p->q.y         = q0.y / n;
+    p->q.z         = q0.z / n;
+    p->w_radps     = w0_radps;
+    p->wheel_radps = SIL_vec_make(0.0, 0.0, 0.0);
+    SIL_plant_environment(p);
+}
+
+
+void SIL_plant_step(SIL_plant_t *p, SIL_vec_t dipole_Am2,
+                    SIL_vec_t wheel_cmd_radps, double dt_s)
+{
+    CONFIG_ASSERT(NULL != p);
+    const double J[3]  = {SIL_INERTIA_X, SIL_INERTIA_Y, SIL_INERTIA_Z};
+    const double w0    = SIL_orbit_rate();
+    const int    steps = (int)ceil(dt_s / SIL_SUBSTEP_MAX_S);
+    const double h     = dt_s / steps;
+    int          s;
+
+    dipole_Am2 = SIL_vec_add(dipole_Am2,
+                             SIL_vec_make(SIL_RESIDUAL_DIPOLE_AM2, 0.0, 0.0));
+    for (s = 0; s < steps; s++)
+    {
+        const SIL_vec_t w = p->w_radps;
+
+        /* Gravity gradient and magnetic torques */
+        const SIL_vec_t r_body = SIL_quat_rotate_inv(p->q, SIL_vec_unit(p->r_m));
+        const SIL_vec_t Jr     = SIL_vec_make(J[0] * r_body.x, J[1] * r_body.y,
+                                          J[2] * r_body.z);
+        const SIL_vec_t tau_gg =
+            SIL_vec_scale(SIL_vec_cross(r_body, Jr), 3.0 * w0 * w0);
+        const SIL_vec_t tau_m = SIL_vec_cross(dipole_Am2, p->b_body_T);
+
+        /* The wheels take their acceleration torque from the body */
+        const SIL_vec_t wheel_acc = SIL_plant_wheel_accel(p, wheel_cmd_radps);
+        const SIL_vec_t hw =
+            SIL_vec_scale(p->wheel_radps, SIL_WHEEL_INERTIA_KGM2);
+        const SIL_vec_t hw_dot =
+            SIL_vec_scale(wheel_acc, SIL_WHEEL_INERTIA_KGM2);
+        const SIL_vec_t H =
+            SIL_vec_add(SIL_vec_make(J[0] * w.x, J[1] * w.y, J[2] * w.z), hw);
+        const SIL_vec_t rhs = SIL_vec_add(
+            SIL_vec_add(tau_gg, tau_m),
+            SIL_vec_scale(SIL_vec_add(SIL_vec_cross(w, H), hw_dot), -1.0));
+
+        p->w_radps = SIL_vec_add(w, SIL_vec_make(rhs.x / J[0] * h,
+                                                 rhs.y / J[1] * h,
+                                                 rhs.z / J[2] * h));
+        p->wheel_radps = SIL_vec_add(p->wheel_radps, SIL_vec_scale(wheel_acc, h));
+        p->q           = SIL_quat_integrate(p->q, w, h);
+        p->t_s += h;
+        SIL_plant_environment(p);
+    }
+}
+
+
+void SIL_plant_nadir(const SIL_plant_t *p, SIL_quat_t *q_ref,
+                     double *orbit_rate_radps)
+{
+    CONFIG_ASSERT(NULL != p);
+    CONFIG_ASSERT(NULL != q_ref);
+    CONFIG_ASSERT(NULL != orbit_rate_radps);
+    const SIL_vec_t z = SIL_vec_unit(SIL_vec_scale(p->r_m, -1.0));
+    const SIL_vec_t y = SIL_vec_unit(SIL_vec_cross(z, p->v_mps));
+    const SIL_vec_t x = SIL_vec_cross(y, z);
+    *q_ref            = SIL_quat_from_axes(x, y, z);
+    *orbit_rate_radps = SIL_orbit_rate();
+}
+
+
+double SIL_plant_nadir_error_deg(const SIL_plant_t *p)
+{
+    CONFIG_ASSERT(NULL != p);
+    const SIL_vec_t z_body =
+        SIL_quat_rotate(p->q, SIL_vec_make(0.0, 0.0, 1.0));
+    const SIL_vec_t z_nadir = SIL_vec_unit(SIL_vec_scale(p->r_m, -1.0));
+    double          c       = SIL_vec_dot(z_body, z_nadir);
+    c = (c > 1.0) ? 1.0 : ((c < -1.0) ? -1.0 : c);
+    return acos(c) * 180.0 / SIL_PI;
+}
+
+
+SIL_vec_t SIL_vec_make(double x, double y, double z)
+{
+    SIL_vec_t v = {x, y, z};
+    return v;
+}
+
+
+double SIL_vec_norm(SIL_vec_t a)
+{
+    return sqrt(SIL_vec_dot(a, a));
+}
+
+
+static SIL_vec_t SIL_vec_add(SIL_vec_t a, SIL_vec_t b)
+{
+    return SIL_vec_make(a.x + b.x, a.y + b.y, a.z + b.z);
+}
+
+
+static SIL_vec_t SIL_vec_scale(SIL_vec_t a, double k)
+{
+    return SIL_vec_make(a.x * k, a.y * k, a.z * k);
+}
+
+
+static double SIL_vec_dot(SIL_vec_t a, SIL_vec_t b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+
+static SIL_vec_t SIL_vec_cross(SIL_vec_t a, SIL_vec_t b)
+{
+    return SIL_vec_make(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z,
+                        a.x * b.y - a.y * b.x);
+}
+
+
+static SIL_vec_t SIL_vec_unit(SIL_vec_t a)
+{
+    return SIL_vec_scale(a, 1.0 / SIL_vec_norm(a));
+}
+
+
+static SIL_quat_t SIL_quat_mul(SIL_quat_t a, SIL_quat_t b)
+{
+    SIL_quat_t r = {
+        a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z,
+        a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+        a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+        a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+    };
+    return r;
+}
+
+
+static SIL_vec_t SIL_quat_rotate(SIL_quat_t q, SIL_vec_t v)
+{
+    const SIL_quat_t p  = {0.0, v.x, v.y, v.z};
+    const SIL_quat_t qc = {q.w, -q.x, -q.y, -q.z};
+    const SIL_quat_t r  = SIL_quat_mul(SIL_quat_mul(q, p), qc);
+    return SIL_vec_make(r.x, r.y, r.z);
+}
+
+
+static SIL_vec_t SIL_quat_rotate_inv(SIL_quat_t q, SIL_vec_t v)
+{
+    const SIL_quat_t qc = {q.w, -q.x, -q.y, -q.z};
+    return SIL_quat_rotate(qc, v);
+}
+
+
+/* Exact exponential map for a constant rate over dt */
+static SIL_quat_t SIL_quat_integrate(SIL_quat_t q, SIL_vec_t w, double dt)
+{
+    const double n = SIL_vec_norm(w);
+    SIL_quat_t   dq;
+    if (n * dt < 1e-12)
+    {
+        dq.w = 1.0;
+        dq.x = 0.5 * w.x * dt;
+        dq.y = 0.5 * w.y * dt;
+        dq.z = 0.5 * w.z * dt;
+    }
+    else
+    {
+        const double s = sin(0.5 * n * dt) / n;
+        dq.w           = cos(0.5 * n * dt);
+        dq.x           = w.x * s;
+        dq.y           = w.y * s;
+        dq.z           = w.z * s;
+    }
+    SIL_quat_t   r   = SIL_quat_mul(q, dq);
+    const double mag = sqrt(r.w * r.w + r.x * r.x + r.y * r.y + r.z * r.z);
+    r.w /= mag;
+    r.x /= mag;
+    r.y /= mag;
+    r.z /= mag;
+    return r;
+}
+
+
+/* Quaternion of the rotation matrix with the given axes as columns */
+static SIL_quat_t SIL_quat_from_axes(SIL_vec_t x, SIL_vec_t y, SIL_vec_t z)
+{
+    SIL_quat_t   q;
+    const double tr = x.x + y.y + z.z;
+    if (tr > 0.0)
+    {
+        const double s = 2.0 * sqrt(tr + 1.0);
+        q.w            = 0.25 * s;
+        q.x            = (y.z - z.y) / s;
+        q.y            = (z.x - x.z) / s;
+        q.z            = (x.y - y.x) / s;
+    }
+    else if (x.x > y.y && x.x > z.z)
+    {
+        const double s = 2.0 * sqrt(1.0 + x.x - y.y - z.z);
+        q.w            = (y.z - z.y) / s;
+        q.x            = 0.25 * s;
+        q.y            = (y.x + x.y) / s;
+        q.z            = (z.x + x.z) / s;
+    }
+    else if (y.y > z.z)
+    {
+        const double s = 2.0 * sqrt(1.0 + y.y - x.x - z.z);
+        q.w            = (z.x - x.z) / s;
+        q.x            = (y.x + x.y) / s;
+        q.y            = 0.25 * s;
+        q.z            = (z.y + y.z) / s;
+    }
+    else
+    {
+        const double s = 2.0 * sqrt(1.0 + z.z - x.x - y.y);
+        q.w            = (x.y - y.x) / s;
+        q.x            = (z.x + x.z) / s;
+        q.y            = (z.y + y.z) / s;
+        q.z            = 0.25 * s;
+    }
+    return q;
+}
+
+
+static double SIL_orbit_rate(void)
+{
+    const double rn = SIL_EARTH_RADIUS_M + SIL_ORBIT_ALTITUDE_M;
+    return sqrt(SIL_EARTH_MU / (rn * rn * rn));
+}
+
+
+/* Position, field and sun at p->t_s */
+static void SIL_plant_environment(SIL_plant_t *p)
+{
+    /* Circular orbit, ascending node on the inertial x axis (towards the
+     * sun) so the eclipse is as long as it can be */
+    const double rn   = SIL_EARTH_RADIUS_M + SIL_ORBIT_ALTITUDE_M;
+    const double rate = SIL_orbit_rate();
+    const double u    = rate * p->t_s + 0.5 * SIL_PI;
+    const double ci   = cos(SIL_ORBIT_INCLINATION_RAD);
+    const double si   = sin(SIL_ORBIT_INCLINATION_RAD);
+    p->r_m = SIL_vec_make(rn * cos(u), rn * sin(u) * ci, rn * sin(u) * si);
+    p->v_mps = SIL_vec_make(-rn * rate * sin(u), rn * rate * cos(u) * ci,
+                            rn * rate * cos(u) * si);
+
+    /* Tilted dipole */
+    const SIL_vec_t m_hat = SIL_vec_make(sin(SIL_EARTH_DIPOLE_TILT_RAD), 0.0,
+                                         -cos(SIL_EARTH_DIPOLE_TILT_RAD));
+    const SIL_vec_t r_hat = SIL_vec_unit(p->r_m);
+    const double    k     = SIL_EARTH_B0_T * pow(SIL_EARTH_RADIUS_M / rn, 3.0);
+    const SIL_vec_t b     = SIL_vec_scale(
+        SIL_vec_add(SIL_vec_scale(r_hat, 3.0 * SIL_vec_dot(m_hat, r_hat)),
+                    SIL_vec_scale(m_hat, -1.0)),
+        k);
+    p->b_body_T = SIL_quat_rotate_inv(p->q, b);
+
+    /* Cylindrical shadow behind the earth */
+    const SIL_vec_t sun   = SIL_vec_make(1.0, 0.0, 0.0);
+    const double    along = SIL_vec_dot(p->r_m, sun);
+    const SIL_vec_t perp  = SIL_vec_add(p->r_m, SIL_vec_scale(sun, -along));
+    p->eclipse            = (along < 0.0) && (SIL_vec_dot(perp, perp) <
+                                   SIL_EARTH_RADIUS_M * SIL_EARTH_RADIUS_M);
+    p->sun_body = SIL_quat_rotate_inv(p->q, sun);
+}
+
+
+static SIL_vec_t SIL_plant_wheel_accel(const SIL_plant_t *p,
+                                       SIL_vec_t wheel_cmd_radps)
+{
+    return SIL_vec_make(SIL_wheel_accel(p->wheel_radps.x, wheel_cmd_radps.x),
+                        SIL_wheel_accel(p->wheel_radps.y, wheel_cmd_radps.y),
+                        SIL_wheel_accel(p->wheel_radps.z, wheel_cmd_radps.z));
+}
+
+
+static double SIL_wheel_accel(double speed, double cmd)
+{
+    const double acc_max = SIL_WHEEL_TORQUE_MAX_NM / SIL_WHEEL_INERTIA_KGM2;
+    double       acc     = (cmd - speed) / SIL_WHEEL_TAU_S;
+    if (acc > acc_max)
+    {
+        acc = acc_max;
+    }
+    else if (acc < -acc_max)
+    {
+        acc = -acc_max;
+    }
+    return acc;
+}
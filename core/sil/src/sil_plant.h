@@ -0,0 +1,93 @@
+/**
+ * @file sil_plant.h
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Private header of the spacecraft and environment model of the
+ * software in the loop simulator
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ * @note Double precision throughout, the flight code stays in float. The
+ * attitude quaternion rotates body vectors into the inertial frame, the same
+ * convention as attitude_types.h.
+ */
+#ifndef __SIL_PLANT_H__
+#define __SIL_PLANT_H__
+#ifdef __cplusplus
+/* clang-format off */
+extern "C"
+{
+/* clang-format on */
+#endif /* Start C linkage */
+
+#include <stdbool.h>
+
+typedef struct
+{
+    double x;
+    double y;
+    double z;
+} SIL_vec_t;
+
+typedef struct
+{
+    double w;
+    double x;
+    double y;
+    double z;
+} SIL_quat_t;
+
+typedef struct
+{
+    double     t_s;
+    SIL_quat_t q;           /* body to inertial */
+    SIL_vec_t  w_radps;     /* body rate */
+    SIL_vec_t  wheel_radps; /* wheel speeds relative to the body */
+    SIL_vec_t  r_m;         /* inertial position */
+    SIL_vec_t  v_mps;       /* inertial velocity */
+    SIL_vec_t  b_body_T;    /* geomagnetic field in the body frame */
+    SIL_vec_t  sun_body;    /* unit vector to the sun in the body frame */
+    bool       eclipse;
+} SIL_plant_t;
+
+
+/**
+ * @brief Start the orbit at the ascending node with the given body rate and
+ * the wheels at rest
+ */
+void SIL_plant_init(SIL_plant_t *p, SIL_vec_t w0_radps);
+
+/**
+ * @brief Advance the plant by dt_s
+ *
+ * @param dipole_Am2 magnetic dipole of the coils, held over dt_s
+ * @param wheel_cmd_radps speed the wheel drivers regulate to
+ */
+void SIL_plant_step(SIL_plant_t *p, SIL_vec_t dipole_Am2,
+                    SIL_vec_t wheel_cmd_radps, double dt_s);
+
+/**
+ * @brief Nadir pointing reference at the current position: body z towards
+ * the earth, x along the velocity
+ *
+ * @param q_ref reference to inertial
+ * @param orbit_rate_radps orbital rate, the reference turns about -y at it
+ */
+void SIL_plant_nadir(const SIL_plant_t *p, SIL_quat_t *q_ref,
+                     double *orbit_rate_radps);
+
+/**
+ * @brief Angle between the body z axis and nadir in degrees
+ */
+double SIL_plant_nadir_error_deg(const SIL_plant_t *p);
+
+SIL_vec_t SIL_vec_make(double x, double y, double z);
+double    SIL_vec_norm(SIL_vec_t a);
+
+#ifdef __cplusplus
+/* clang-format off */
+}
+/* clang-format on */
+#endif /* End C linkage */
+#endif /* __SIL_PLANT_H__ */
@@ -0,0 +1,255 @@
+/**
+ * @file replay_golden.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Test the record and replay of sessions: a recorded session plays
+ * back bit exact at any speed, a firmware that behaves differently is caught
+ * and the checked in golden sessions still play back
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ * @note A change that is meant to alter the replies or the pwm outputs of
+ * the scripted session breaks the golden trace. Run the test with --update
+ * to record it again and commit the new trace with the change.
+ */
+#if defined(TARGET_MCU)
+#error NATIVE TESTS CANNOT BE RUN ON A BARE METAL MICROCONTROLLER
+#endif /* #if defined(TARGET_MCU) */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "sil.h"
+#include "replay.h"
+#include "test_expect.h"
+
+#if !defined(SIL_GOLDEN_DIR)
+#define SIL_GOLDEN_DIR "golden"
+#endif /* #if !defined(SIL_GOLDEN_DIR) */
+
+#define GOLDEN_SESSION SIL_GOLDEN_DIR "/obc_session.rpl"
+
+#define SESSION_MS (4000u)
+#define TRACE_LEN_MAX (64u * 1024u)
+#define PACED_ACCEL (100.0f)
+
+typedef struct
+{
+    uint8_t  buf[TRACE_LEN_MAX];
+    uint32_t len;
+} trace_t;
+
+static const struct
+{
+    uint32_t    ms;
+    const char *cmd;
+} script[] = {
+    {100u, "{\"mode\":\"detumble\"}"},
+    {300u, "{\"imu\":\"read\"}"},
+    {500u, "{\"param\":\"get\",\"name\":\"rw_ma_mv\"}"},
+    {700u, "{\"tlm\":\"sub\",\"id\":0,\"ch\":\"q,rate\",\"ms\":200}"},
+    {2500u, "{\"tlm\":\"unsub\",\"id\":0}"},
+    {3000u, "{\"nope\":1}"},
+};
+
+static trace_t recorded;
+static trace_t replayed;
+
+
+static void trace_sink(const uint8_t *buf, uint16_t len, void *ctx)
+{
+    trace_t *trace = (trace_t *)ctx;
+    if (trace->len + len <= sizeof(trace->buf))
+    {
+        memcpy(&trace->buf[trace->len], buf, len);
+    }
+    trace->len += len;
+}
+
+
+static void record_session(trace_t *trace)
+{
+    SIL_config_t config = SIL_CONFIG_DEFAULT;
+    config.record       = trace_sink;
+    config.record_ctx   = trace;
+    trace->len          = 0;
+    SIL_init(&config);
+
+    uint32_t cmd = 0;
+    for (uint32_t ms = 0; ms < SESSION_MS; ms++)
+    {
+        if (cmd < sizeof(script) / sizeof(*script) && script[cmd].ms == ms)
+        {
+            SIL_obc_send(script[cmd].cmd);
+            cmd++;
+        }
+        SIL_step();
+    }
+    SIL_stop();
+}
+
+
+/* Play trace back, sending extra to the firmware halfway through if not
+ * NULL. Returns 1 if the trace was rejected */
+static int play(const uint8_t *trace, uint32_t len, float accel,
+                const char *extra, REPLAY_stats_t *stats)
+{
+    SIL_config_t config = SIL_CONFIG_DEFAULT;
+    config.replay       = trace;
+    config.replay_len   = len;
+    config.time_accel   = accel;
+    if (SIL_init(&config))
+    {
+        return 1;
+    }
+
+    const uint32_t halfway = REPLAY_play_duration_ms() / 2;
+    for (uint32_t ms = 0; !REPLAY_play_done(); ms++)
+    {
+        if (NULL != extra && ms == halfway)
+        {
+            SIL_obc_send(extra);
+        }
+        SIL_step();
+    }
+    SIL_stop();
+    REPLAY_get_stats(stats);
+    return 0;
+}
+
+
+static uint32_t varint_get(const uint8_t *buf, uint32_t *pos)
+{
+    uint32_t val   = 0;
+    uint8_t  shift = 0;
+    uint8_t  byte;
+    do
+    {
+        byte = buf[(*pos)++];
+        val |= (uint32_t)(byte & 0x7Fu) << shift;
+        shift += 7;
+    } while (byte & 0x80u);
+    return val;
+}
+
+
+/* Position of the record after the one at pos, len is its payload length
+ * as stored */
+static uint32_t record_next(const uint8_t *buf, uint32_t pos, uint16_t *len)
+{
+    const uint8_t type = buf[pos++];
+    (void)varint_get(buf, &pos);
+    *len = (uint16_t)varint_get(buf, &pos);
+    if (type & REPLAY_FLAG_DELTA)
+    {
+        const uint16_t bitmap_len = (uint16_t)((*len + 7u) / 8u);
+        uint16_t       changed    = 0;
+        for (uint16_t i = 0; i < *len; i++)
+        {
+            changed += (buf[pos + i / 8u] >> (i % 8u)) & 1u;
+        }
+        *len = (uint16_t)(bitmap_len + changed);
+    }
+    return pos + *len;
+}
+
+
+static int update_golden(void)
+{
+    FILE *f = fopen(GOLDEN_SESSION, "wb");
+    if (NULL == f)
+    {
+        printf("cannot write %s\n", GOLDEN_SESSION);
+        return 1;
+    }
+    fwrite(recorded.buf, 1, recorded.len, f);
+    fclose(f);
+    printf("%s : %u bytes\n", GOLDEN_SESSION, recorded.len);
+    return 0;
+}
+
+
+int main(int argc, char **argv)
+{
+    REPLAY_stats_t stats;
+
+    record_session(&recorded);
+    EXPECT(recorded.len > REPLAY_TRACE_HEADER_LEN);
+    EXPECT(recorded.len <= sizeof(recorded.buf));
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--update") == 0)
+        {
+            return update_golden();
+        }
+    }
+
+    /* Recording is deterministic */
+    record_session(&replayed);
+    EXPECT(replayed.len == recorded.len);
+    EXPECT(memcmp(replayed.buf, recorded.buf, recorded.len) == 0);
+
+    /* Every output comes back on the same tick, as fast as the host goes
+     * and paced */
+    EXPECT(play(recorded.buf, recorded.len, 0.0f, NULL, &stats) == 0);
+    EXPECT(REPLAY_play_duration_ms() == SESSION_MS);
+    EXPECT(stats.outputs > 0);
+    EXPECT(stats.inputs > 0);
+    EXPECT(stats.diverged == 0);
+    EXPECT(stats.inputs_missing == 0);
+
+    REPLAY_stats_t paced;
+    EXPECT(play(recorded.buf, recorded.len, PACED_ACCEL, NULL, &paced) == 0);
+    EXPECT(memcmp(&paced, &stats, sizeof(stats)) == 0);
+
+    /* A command the session never had turns the torquers off on the tick
+     * of the step that takes it, then sends a reply nobody recorded */
+    EXPECT(play(recorded.buf, recorded.len, 0.0f, "{\"mode\":\"idle\"}",
+                &stats) == 0);
+    EXPECT(stats.diverged > 0);
+    EXPECT(stats.first_diverged_rec == REPLAY_REC_pwm);
+    EXPECT(stats.first_diverged_ms == SESSION_MS / 2 + 1u);
+
+    /* So does an input that differs. The first frame is stored as is, turn
+     * its closing brace into a format error */
+    memcpy(replayed.buf, recorded.buf, recorded.len);
+    uint32_t pos = REPLAY_TRACE_HEADER_LEN;
+    uint16_t len;
+    while (replayed.buf[pos] != REPLAY_REC_obc_rx)
+    {
+        pos = record_next(replayed.buf, pos, &len);
+        EXPECT(pos < recorded.len);
+    }
+    pos = record_next(replayed.buf, pos, &len);
+    EXPECT(replayed.buf[pos - 1u] == '}');
+    replayed.buf[pos - 1u] = ' ';
+    EXPECT(play(replayed.buf, recorded.len, 0.0f, NULL, &stats) == 0);
+    EXPECT(stats.diverged > 0);
+
+    /* Traces that are cut short or are not traces are refused */
+    EXPECT(play(recorded.buf, recorded.len - 1u, 0.0f, NULL, &stats) == 1);
+    memcpy(replayed.buf, recorded.buf, recorded.len);
+    replayed.buf[0] = 'X';
+    EXPECT(play(replayed.buf, recorded.len, 0.0f, NULL, &stats) == 1);
+    EXPECT(REPLAY_get_mode() == REPLAY_MODE_off);
+
+    /* The golden session still plays back. Failing here and nowhere else
+     * means the firmware no longer behaves the way it did when it was
+     * recorded */
+    uint32_t golden_len;
+    uint8_t *golden = REPLAY_file_load(GOLDEN_SESSION, &golden_len);
+    EXPECT(NULL != golden);
+    const int rejected = play(golden, golden_len, 0.0f, NULL, &stats);
+    free(golden);
+    EXPECT(!rejected);
+    EXPECT(stats.diverged == 0);
+    EXPECT(stats.inputs_missing == 0);
+
+    printf("PASS\n");
+    return 0;
+}
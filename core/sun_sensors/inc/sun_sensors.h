@@ -7,6 +7,10 @@ extern "C"
 /* clang-format on */
 #endif /* Start C linkage */
 
+#include <stdbool.h>
+
+#include "json_writer.h"
+
 typedef enum
 {
     SUNSEN_FACE_x_pos,
@@ -19,7 +23,21 @@ typedef enum
 
 int SUNSEN_get_z_pos_temp(void);
 int SUNSEN_get_z_neg_temp(void);
-int SUNSEN_face_lux_to_string(char *buf, int len, SUNSEN_FACE_t face);
+
+/**
+ * @brief Write the three channels of a face in lux as a json array
+ *
+ * @return int 0 on success, 1 if w is full
+ */
+int SUNSEN_face_lux_to_json(JW_t *w, SUNSEN_FACE_t face);
+
+/**
+ * @brief Check if the sun is visible from any face of the satellite
+ *
+ * @return true if at least one sun sensor channel is above the illumination
+ * threshold (false during eclipse)
+ */
+bool SUNSEN_sun_visible(void);
 
 
 #ifdef __cplusplus
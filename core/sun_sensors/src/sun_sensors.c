@@ -16,25 +16,28 @@
  * P8.1 : CS_SUN_Y-
  * P8.2 : CS_SUN_Z-
  *
- *
- * @todo DIRECT CALLS TO REGISTER LEVEL SHOULD BE ABSTRACTED INTO DRIVER LAYER
+ * (CS is active low, one ADS7841 per face)
  */
 
 #include <stdlib.h>
 #include <string.h>
-#include <stdio.h>
 #include <stdint.h>
 
 #include "attributes.h"
 #include "config_assert.h"
 #include "sun_sensors.h"
+#include "hal.h"
+#include "hal_ads7841.h"
 
-#if defined(TARGET_MCU)
-#include <msp430.h>
-#include "spi.h"
-#include "ads7841e.h"
-#else
-#endif /* #if defined(TARGET_MCU) */
+/* Photodiode and temperature inputs of each face converter */
+#define SUNSEN_ADS7841_TEMP_CHANNEL (0u)
+#define SUNSEN_ADS7841_LUX_1_CHANNEL (1u)
+#define SUNSEN_ADS7841_LUX_2_CHANNEL (2u)
+#define SUNSEN_ADS7841_LUX_3_CHANNEL (3u)
+
+/* A face is lit when any of its photodiodes reads more lux than this, set
+ * between the earth albedo and the direct sun levels */
+#define SUNSEN_ILLUMINATED_THRESHOLD (200.0f)
 
 
 typedef struct
@@ -44,278 +47,116 @@ typedef struct
     float lux_3;
 } SUNSEN_measurement_t;
 
-static void SUNSEN_enable_ADS7841_x_plus(void);
-static void SUNSEN_enable_ADS7841_x_minus(void);
-static void SUNSEN_enable_ADS7841_y_plus(void);
-static void SUNSEN_enable_ADS7841_y_minus(void);
-static void SUNSEN_enable_ADS7841_z_plus(void);
-static void SUNSEN_enable_ADS7841_z_minus(void);
-
-static void SUNSEN_disable_ADS7841_x_plus(void);
-static void SUNSEN_disable_ADS7841_x_minus(void);
-static void SUNSEN_disable_ADS7841_y_plus(void);
-static void SUNSEN_disable_ADS7841_y_minus(void);
-static void SUNSEN_disable_ADS7841_z_plus(void);
-static void SUNSEN_disable_ADS7841_z_minus(void);
-
-
-static void                 SUNSEN_init_phy(void);
 static SUNSEN_measurement_t SUNSEN_get_face_lux(SUNSEN_FACE_t face);
+static int                  SUNSEN_get_face_temp(SUNSEN_FACE_t face);
 static int                  SUNSEN_adcs_to_temp_deg_c(uint16_t adc_val);
+static void                 SUNSEN_init_phy(void);
 
 
-static void (*SUNSEN_enable_functions[])(void) = {
-    [SUNSEN_FACE_x_pos] = SUNSEN_enable_ADS7841_x_plus,
-    [SUNSEN_FACE_x_neg] = SUNSEN_enable_ADS7841_x_minus,
-    [SUNSEN_FACE_y_pos] = SUNSEN_enable_ADS7841_y_plus,
-    [SUNSEN_FACE_y_neg] = SUNSEN_enable_ADS7841_y_minus,
-    [SUNSEN_FACE_z_pos] = SUNSEN_enable_ADS7841_z_plus,
-    [SUNSEN_FACE_z_neg] = SUNSEN_enable_ADS7841_z_minus,
-};
-
-static void (*SUNSEN_disable_functions[])(void) = {
-    [SUNSEN_FACE_x_pos] = SUNSEN_disable_ADS7841_x_plus,
-    [SUNSEN_FACE_x_neg] = SUNSEN_disable_ADS7841_x_minus,
-    [SUNSEN_FACE_y_pos] = SUNSEN_disable_ADS7841_y_plus,
-    [SUNSEN_FACE_y_neg] = SUNSEN_disable_ADS7841_y_minus,
-    [SUNSEN_FACE_z_pos] = SUNSEN_disable_ADS7841_z_plus,
-    [SUNSEN_FACE_z_neg] = SUNSEN_disable_ADS7841_z_minus,
+static const HAL_GPIO_t SUNSEN_cs[] = {
+    [SUNSEN_FACE_x_pos] = {HAL_PORT_4, HAL_PIN(3)},
+    [SUNSEN_FACE_x_neg] = {HAL_PORT_8, HAL_PIN(0)},
+    [SUNSEN_FACE_y_pos] = {HAL_PORT_4, HAL_PIN(2)},
+    [SUNSEN_FACE_y_neg] = {HAL_PORT_8, HAL_PIN(1)},
+    [SUNSEN_FACE_z_pos] = {HAL_PORT_4, HAL_PIN(1)},
+    [SUNSEN_FACE_z_neg] = {HAL_PORT_8, HAL_PIN(2)},
 };
 
 
-int SUNSEN_face_lux_to_string(char *buf, int len, SUNSEN_FACE_t face)
+int SUNSEN_face_lux_to_json(JW_t *w, SUNSEN_FACE_t face)
 {
-    CONFIG_ASSERT(NULL != buf);
+    CONFIG_ASSERT(NULL != w);
     SUNSEN_measurement_t m = SUNSEN_get_face_lux(face);
-    int                  req; /* required length to fill message buffer */
-    req = snprintf(buf, len, "[ %.3f, %.3f, %.3f ]", m.lux_1, m.lux_2, m.lux_3);
-    return (req < len) ? 0 : 1;
-}
-
-
-int SUNSEN_get_z_pos_temp(void)
-{
-    int adc_val = 0;
-#if defined(TARGET_MCU)
-    ADS7841_driver_init(SUNSEN_enable_functions[SUNSEN_FACE_z_pos],
-                        SUNSEN_disable_functions[SUNSEN_FACE_z_pos],
-                        ADS7841_PWRMODE_stayOn, ADS7841_BITRES_12);
-    adc_val = ADS7841_measure_channel(ADS7841_CHANNEL_SGL_0);
-
-    ADS7841_driver_deinit();
-#else
-    printf("called %s\n", __func__);
-#endif /* #if defined(TARGET_MCU) */
-    return SUNSEN_adcs_to_temp_deg_c(adc_val);
-}
-
-
-int SUNSEN_get_z_neg_temp(void)
-{
-    int adc_val = 0;
-#if defined(TARGET_MCU)
-    ADS7841_driver_init(SUNSEN_enable_functions[SUNSEN_FACE_z_neg],
-                        SUNSEN_disable_functions[SUNSEN_FACE_z_neg],
-                        ADS7841_PWRMODE_stayOn, ADS7841_BITRES_12);
-    adc_val = ADS7841_measure_channel(ADS7841_CHANNEL_SGL_0);
-    ADS7841_driver_deinit();
-#else
-    printf("called %s\n", __func__);
-#endif /* #if defined(TARGET_MCU) */
-    return SUNSEN_adcs_to_temp_deg_c(adc_val);
-}
-
-
-static void SUNSEN_enable_ADS7841_x_plus(void)
-{
-#if defined(TARGET_MCU)
-    P4OUT &= ~BIT3;
-#else
-    printf("called %s\n", __func__);
-#endif /* #if defined(TARGET_MCU) */
-}
-
-
-static void SUNSEN_enable_ADS7841_x_minus(void)
-{
-#if defined(TARGET_MCU)
-    P8OUT &= ~BIT0;
-#else
-    printf("called %s\n", __func__);
-#endif /* #if defined(TARGET_MCU) */
+    JW_array_begin(w);
+    JW_float(w, m.lux_1, 3);
+    JW_float(w, m.lux_2, 3);
+    JW_float(w, m.lux_3, 3);
+    JW_array_end(w);
+    return JW_error(w);
 }
 
 
-static void SUNSEN_enable_ADS7841_y_plus(void)
+bool SUNSEN_sun_visible(void)
 {
-#if defined(TARGET_MCU)
-    P4OUT &= ~BIT2;
-#else
-    printf("called %s\n", __func__);
-#endif /* #if defined(TARGET_MCU) */
+    SUNSEN_FACE_t face;
+    for (face = SUNSEN_FACE_x_pos; face <= SUNSEN_FACE_z_neg; face++)
+    {
+        SUNSEN_measurement_t m = SUNSEN_get_face_lux(face);
+        if (m.lux_1 > SUNSEN_ILLUMINATED_THRESHOLD ||
+            m.lux_2 > SUNSEN_ILLUMINATED_THRESHOLD ||
+            m.lux_3 > SUNSEN_ILLUMINATED_THRESHOLD)
+        {
+            return true;
+        }
+    }
+    return false;
 }
 
 
-static void SUNSEN_enable_ADS7841_y_minus(void)
-{
-#if defined(TARGET_MCU)
-    P8OUT &= ~BIT1;
-#else
-    printf("called %s\n", __func__);
-#endif /* #if defined(TARGET_MCU) */
-}
-
-
-static void SUNSEN_enable_ADS7841_z_plus(void)
-{
-#if defined(TARGET_MCU)
-    P4OUT &= ~BIT1;
-#else
-    printf("called %s\n", __func__);
-#endif /* #if defined(TARGET_MCU) */
-}
-
-
-static void SUNSEN_enable_ADS7841_z_minus(void)
-{
-#if defined(TARGET_MCU)
-    P8OUT &= ~BIT2;
-#else
-    printf("called %s\n", __func__);
-#endif /* #if defined(TARGET_MCU) */
-}
-
-
-static void SUNSEN_disable_ADS7841_x_plus(void)
-{
-#if defined(TARGET_MCU)
-    P4OUT |= BIT3;
-#else
-    printf("called %s\n", __func__);
-#endif /* #if defined(TARGET_MCU) */
-}
-
-
-static void SUNSEN_disable_ADS7841_x_minus(void)
-{
-#if defined(TARGET_MCU)
-    P8OUT |= BIT0;
-#else
-    printf("called %s\n", __func__);
-#endif /* #if defined(TARGET_MCU) */
-}
-
-
-static void SUNSEN_disable_ADS7841_y_plus(void)
-{
-#if defined(TARGET_MCU)
-    P4OUT |= BIT2;
-#else
-    printf("called %s\n", __func__);
-#endif /* #if defined(TARGET_MCU) */
-}
-
-
-static void SUNSEN_disable_ADS7841_y_minus(void)
-{
-#if defined(TARGET_MCU)
-    P8OUT |= BIT1;
-#else
-    printf("called %s\n", __func__);
-#endif /* #if defined(TARGET_MCU) */
-}
-
-
-static void SUNSEN_disable_ADS7841_z_plus(void)
+int SUNSEN_get_z_pos_temp(void)
 {
-#if defined(TARGET_MCU)
-    P4OUT |= BIT1;
-#else
-    printf("called %s\n", __func__);
-#endif /* #if defined(TARGET_MCU) */
+    return SUNSEN_get_face_temp(SUNSEN_FACE_z_pos);
 }
 
 
-static void SUNSEN_disable_ADS7841_z_minus(void)
+int SUNSEN_get_z_neg_temp(void)
 {
-#if defined(TARGET_MCU)
-    P8OUT |= BIT2;
-#else
-    printf("called %s\n", __func__);
-#endif /* #if defined(TARGET_MCU) */
+    return SUNSEN_get_face_temp(SUNSEN_FACE_z_neg);
 }
 
 
 static SUNSEN_measurement_t SUNSEN_get_face_lux(SUNSEN_FACE_t face)
 {
+    static const uint8_t channels[] = {
+        SUNSEN_ADS7841_LUX_1_CHANNEL,
+        SUNSEN_ADS7841_LUX_2_CHANNEL,
+        SUNSEN_ADS7841_LUX_3_CHANNEL,
+    };
+    uint16_t             counts[sizeof(channels)];
     SUNSEN_measurement_t measurement;
     memset(&measurement, 0, sizeof(measurement));
 
+    CONFIG_ASSERT(face <= SUNSEN_FACE_z_neg);
     SUNSEN_init_phy();
-#if defined(TARGET_MCU)
-    ADS7841_driver_init(SUNSEN_enable_functions[face],
-                        SUNSEN_disable_functions[face], ADS7841_PWRMODE_stayOn,
-                        ADS7841_BITRES_12);
-    measurement.lux_1 = ADS7841_measure_channel(ADS7841_CHANNEL_SGL_1);
-    measurement.lux_2 = ADS7841_measure_channel(ADS7841_CHANNEL_SGL_2);
-    measurement.lux_3 = ADS7841_measure_channel(ADS7841_CHANNEL_SGL_3);
-    ADS7841_driver_deinit();
-#else
-    printf("Called %s\n", __func__);
-#endif /* #if defined(TARGET_MCU) */
+    if (HAL_ADS7841_measure(&SUNSEN_cs[face], channels, counts,
+                            sizeof(channels)) == 0)
+    {
+        measurement.lux_1 = counts[0];
+        measurement.lux_2 = counts[1];
+        measurement.lux_3 = counts[2];
+    }
     return measurement;
 }
 
 
+static int SUNSEN_get_face_temp(SUNSEN_FACE_t face)
+{
+    CONFIG_ASSERT(face <= SUNSEN_FACE_z_neg);
+    SUNSEN_init_phy();
+    return SUNSEN_adcs_to_temp_deg_c(HAL_ADS7841_measure_channel(
+        &SUNSEN_cs[face], SUNSEN_ADS7841_TEMP_CHANNEL));
+}
+
+
 static int SUNSEN_adcs_to_temp_deg_c(uint16_t adc_val)
 {
     int deg_c = 50;
-#if defined(TARGET_MCU)
 
     /** @todo IMPLEMENT THIS FUNCTION */
+#if defined(TARGET_MCU)
 #warning NOT IMPLEMENTED YET
-
-#else
-    printf("called %s with retval == %d\n", __func__, deg_c);
 #endif /* #if defined(TARGET_MCU) */
+    (void)adc_val;
     return deg_c;
 }
 
 
 static void SUNSEN_init_phy(void)
 {
-#if defined(TARGET_MCU)
-
-    /** @note
-     * CLOCK SELECT PINOUTS
-     * P4.3 : CS_SUN_X+
-     * P4.2 : CS_SUN_Y+
-     * P4.1 : CS_SUN_Z+
-     *
-     * P8.0 : CS_SUN_X-
-     * P8.1 : CS_SUN_Y-
-     * P8.2 : CS_SUN_Z-
-     *
-     * (Levels initialized to high because CS is active low)
-     */
-    P4DIR |= BIT3; /* X+ */
-    P4OUT |= BIT3;
-
-    P4DIR |= BIT2; /* Y+ */
-    P4OUT |= BIT2;
-
-    P4DIR |= BIT1; /* Z+ */
-    P4OUT |= BIT1;
-
-    P8DIR |= BIT0; /* X- */
-    P8OUT |= BIT0;
-
-    P8DIR |= BIT1; /* Y- */
-    P8OUT |= BIT1;
-
-    P8DIR |= BIT2; /* Z- */
-    P8OUT |= BIT2;
-#else
-    printf("called %s\n", __func__);
-#endif /* #if defined(TARGET_MCU) */
-}
\ No newline at end of file
+    /* Levels initialized high because CS is active low */
+    SUNSEN_FACE_t face;
+    for (face = SUNSEN_FACE_x_pos; face <= SUNSEN_FACE_z_neg; face++)
+    {
+        HAL_ADS7841_init_cs(&SUNSEN_cs[face]);
+    }
+}
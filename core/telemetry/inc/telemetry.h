@@ -0,0 +1,166 @@
+/**
+ * @file telemetry.h
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Delta encoded telemetry log in a circular flash region
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ * @note The log region is a ring of FLASH_LOG_SEGMENT_CNT pages (one flash
+ * segment each). Every page starts with a header and a key record holding
+ * absolute values, the records after it only hold what changed since the
+ * previous record, so each page decodes on its own and the oldest page can
+ * be erased without losing the ones after it.
+ *
+ * Records are staged in RAM and programmed TLM_BATCH_SIZE bytes at a time.
+ * A page is erased once, just before it is reused.
+ */
+#ifndef __TELEMETRY_H__
+#define __TELEMETRY_H__
+#ifdef __cplusplus
+/* clang-format off */
+extern "C"
+{
+/* clang-format on */
+#endif /* Start C linkage */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "attitude_types.h"
+#include "flash_types.h"
+#include "json_writer.h"
+
+#define TLM_PAGE_SIZE (FLASH_LOG_SEGMENT_SIZE)
+#define TLM_PAGE_CNT (FLASH_LOG_SEGMENT_CNT)
+#define TLM_BATCH_SIZE (64u)
+
+/* Payload bytes per download frame */
+#define TLM_FRAME_DATA_SIZE (64u)
+
+typedef struct
+{
+    uint32_t t_ms;
+    uint8_t  mode;
+    quat_t   q_body;
+    vec3_t   rate_radps;
+    vec3_t   wheel_radps;   /* wheel speed setpoints */
+    int16_t  coil_ma[3];    /* measured magnetorquer currents */
+    uint16_t jitter_us;     /* worst control loop lateness so far */
+    uint16_t overruns;      /* control loop overruns since the last record */
+    uint16_t isr_over;      /* vectors over their budget, streamed only */
+    uint16_t isr_pct;       /* worst ISR response in % of its budget */
+} TLM_record_t;
+
+typedef struct
+{
+    uint32_t seq;        /* sequence number of the page being written */
+    uint16_t page;       /* index of the page being written */
+    uint16_t pages_used; /* pages holding a valid header */
+    uint32_t records;    /* logged since boot */
+    uint32_t bytes;      /* encoded bytes logged since boot */
+    uint32_t erases;     /* pages erased since boot */
+    uint32_t errors;     /* failed erases and writes since boot */
+} TLM_status_t;
+
+typedef void (*TLM_decode_cb)(const TLM_record_t *rec, void *ctx);
+
+
+/**
+ * @brief Find the newest page of the log. Logging resumes on the page after
+ * it so nothing that survived the reset is erased early.
+ */
+void TLM_init(void);
+
+
+/**
+ * @brief Append a record to the log
+ *
+ * @note Values are quantised before they are encoded: quaternion to 1/32767,
+ * rates to 0.1 mrad/s and wheel speeds to 0.1 rad/s, saturated to 16 bits.
+ *
+ * @return 0 on success, 1 if a page could not be erased or programmed
+ */
+int TLM_log(const TLM_record_t *rec);
+
+
+/**
+ * @brief Program the records staged in RAM
+ *
+ * @return 0 on success, 1 if the flash could not be programmed
+ */
+int TLM_flush(void);
+
+
+/**
+ * @brief Erase the whole log
+ */
+int TLM_erase(void);
+
+
+void TLM_get_status(TLM_status_t *status);
+
+
+/**
+ * @brief Decode the records of one page, oldest first
+ *
+ * @note Decoding stops at the first erased byte or at the first record
+ * that fails its check (e.g. one cut short by a reset).
+ *
+ * @return number of records decoded, -1 if the page has no valid header
+ */
+int TLM_decode_page(const uint8_t *page, size_t len, TLM_decode_cb cb,
+                    void *ctx);
+
+
+/**
+ * @brief Read only view of a page of the log region
+ */
+const uint8_t *TLM_page(uint16_t page);
+
+
+/**
+ * @brief Start a bulk download of the log, oldest page first
+ *
+ * @note Staged records are programmed first so they are part of the
+ * download. The pages are sent in the order they had at the start, logging
+ * may go on during the download.
+ */
+void TLM_download_start(void);
+
+
+bool TLM_download_active(void);
+
+
+/**
+ * @brief Write the next download frame as a json object into buf
+ *
+ * Frames are
+ *  {"tlm":{"f":<frame>,"seq":<page seq>,"off":<offset>,"d":"<hex>"}}
+ * with up to TLM_FRAME_DATA_SIZE bytes of a page each, followed by
+ *  {"tlm":{"end":<frames>,"bytes":<bytes>,"skip":<pages>}}
+ * The erased tail of a page is not sent. A page the log reuses before it is
+ * sent is skipped, or cut short if it was being sent, and counted in skip.
+ * The records of the pages opened since the start are not sent.
+ *
+ * @return 0 if a frame was written, 1 once the download is complete or if
+ * w is full (the frame is kept for the next call)
+ */
+int TLM_download_next(JW_t *w);
+
+
+/**
+ * @brief Write the log status as a json object
+ *
+ * @return 0 on success, 1 if w is full
+ */
+int TLM_status_to_json(JW_t *w);
+
+#ifdef __cplusplus
+/* clang-format off */
+}
+/* clang-format on */
+#endif /* End C linkage */
+#endif /* __TELEMETRY_H__ */
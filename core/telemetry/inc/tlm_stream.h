@@ -0,0 +1,160 @@
+/**
+ * @file tlm_stream.h
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Periodic unsolicited telemetry frames for OBC subscriptions
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ * @note The OBC subscribes to a set of channels at a period and the ADCS
+ * pushes a frame every period without being asked. A subscription is only
+ * accepted if every subscription together fits in TLM_STREAM_BUDGET_PCT of
+ * the link, the rest is left for command responses.
+ *
+ * Frames are
+ *  {"s":<id>,"n":<frame>,"d":"<hex>"}
+ * where d packs the subscribed channels in TLM_CH_t order, little endian:
+ *
+ *  time   u32 t_ms
+ *  mode   u8
+ *  q      4 x i16 w,x,y,z      1/32767
+ *  rate   3 x i16 rad/s        1e-4 rad/s
+ *  wheel  3 x i16 rad/s        0.1 rad/s
+ *  coil   3 x i16 mA
+ *  timing u16 jitter_us, u16 overruns since the previous frame
+ *  isr    u16 vectors over budget (mask), u16 worst response % of budget
+ *
+ * n counts the frames of the subscription (mod 65536) so the OBC can tell
+ * when frames were lost.
+ */
+#ifndef __TLM_STREAM_H__
+#define __TLM_STREAM_H__
+#ifdef __cplusplus
+/* clang-format off */
+extern "C"
+{
+/* clang-format on */
+#endif /* Start C linkage */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "telemetry.h"
+#include "json_writer.h"
+
+/* 9600 baud 8N1 (uart.c) */
+#define TLM_STREAM_LINK_BYTES_PER_S (960u)
+#define TLM_STREAM_BUDGET_PCT (75u)
+#define TLM_STREAM_SUB_CNT (4u)
+
+/* Fastest subscription, one frame per control loop iteration */
+#define TLM_STREAM_PERIOD_MIN_MS (100u)
+
+typedef enum
+{
+    TLM_CH_time,
+    TLM_CH_mode,
+    TLM_CH_q,
+    TLM_CH_rate,
+    TLM_CH_wheel,
+    TLM_CH_coil,
+    TLM_CH_timing,
+    TLM_CH_isr,
+    TLM_CH_cnt,
+} TLM_CH_t;
+
+#define TLM_CH_MASK(ch) ((uint16_t)(1u << (ch)))
+#define TLM_CH_ALL ((uint16_t)((1u << TLM_CH_cnt) - 1u))
+
+typedef struct
+{
+    uint16_t channels;  /* TLM_CH_MASK set, 0 if the slot is free */
+    uint16_t period_ms;
+    uint16_t frame_len; /* bytes on the wire per frame */
+    uint16_t load_bps;  /* bytes per second on the wire */
+} TLM_stream_sub_t;
+
+typedef struct
+{
+    uint16_t load_bps; /* sum over the subscriptions */
+    uint16_t cap_bps;  /* budget the load must fit in */
+    uint32_t frames;   /* sent since boot */
+    uint32_t dropped;  /* replaced before they could be sent */
+} TLM_stream_status_t;
+
+
+/**
+ * @brief Cancel every subscription and clear the statistics
+ */
+void TLM_stream_init(void);
+
+
+/**
+ * @brief Subscribe slot id to channels every period_ms. Replaces what the
+ * slot held. channels == 0 cancels the subscription.
+ *
+ * @return 0 on success, 1 if the arguments are invalid or the link budget
+ * would be exceeded (the slot is left unchanged)
+ */
+int TLM_stream_subscribe(uint8_t id, uint16_t channels, uint16_t period_ms);
+
+
+void TLM_stream_get_sub(uint8_t id, TLM_stream_sub_t *sub);
+
+
+void TLM_stream_get_status(TLM_stream_status_t *status);
+
+
+/**
+ * @brief Bytes on the wire for one frame carrying channels
+ */
+uint16_t TLM_stream_frame_len(uint16_t channels);
+
+
+/**
+ * @brief true if a subscription wants a sample at now_us. The caller then
+ * builds a record and passes it to TLM_stream_sample.
+ */
+bool TLM_stream_due(uint32_t now_us);
+
+
+/**
+ * @brief Pack a frame for every subscription due at now_us
+ *
+ * @note A frame that has not been sent by the time its subscription packs
+ * the next one is dropped and counted.
+ */
+void TLM_stream_sample(const TLM_record_t *rec, uint32_t now_us);
+
+
+/**
+ * @brief Write the oldest packed frame as a json object
+ *
+ * @return 0 if a frame was written, 1 if there is none or w is full (the
+ * frame is kept for the next call)
+ */
+int TLM_stream_next(JW_t *w);
+
+
+/**
+ * @brief Parse a comma separated list of channel names ("q,rate,wheel")
+ *
+ * @return 0 on success, 1 if a name is unknown
+ */
+int TLM_stream_channels_from_string(const char *str, uint16_t *channels);
+
+
+/**
+ * @brief Write the stream status as a json object
+ *
+ * @return 0 on success, 1 if w is full
+ */
+int TLM_stream_status_to_json(JW_t *w);
+
+#ifdef __cplusplus
+/* clang-format off */
+}
+/* clang-format on */
+#endif /* End C linkage */
+#endif /* __TLM_STREAM_H__ */
@@ -0,0 +1,685 @@
+/**
+ * @file telemetry.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Delta encoded telemetry log in a circular flash region
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ * @note Page layout (little endian):
+ *
+ *  0   magic "TL"
+ *  2   format version
+ *  3   reserved (left erased)
+ *  4   page sequence number, incremented for every page opened
+ *  8   records until the first erased byte
+ *
+ * Each record holds 16 quantised fields (see tlm_field) and ends with a
+ * CRC-8 of its bytes:
+ *
+ *  key   : 'K', varint t_ms, 16 zigzag varints of the field values
+ *  delta : 'D', varint dt_ms, 16 bit mask of the fields that changed,
+ *          zigzag varints of the changes of those fields
+ *
+ * Varints are little endian base 128. Zigzag maps small signed changes to
+ * small unsigned numbers so a field that drifts slowly costs one byte.
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "targets.h"
+#include "config_assert.h"
+#include "telemetry.h"
+#include "tlm_nv.h"
+#include "tlm_quant.h"
+
+#define TLM_MAGIC (0x4C54u) /* "TL" */
+#define TLM_FORMAT_VERSION (1u)
+
+#define TLM_HDR_MAGIC (0u)
+#define TLM_HDR_VERSION (2u)
+#define TLM_HDR_SEQ (4u)
+#define TLM_HDR_SIZE (8u)
+
+#define TLM_TAG_KEY (0x4Bu)   /* 'K' */
+#define TLM_TAG_DELTA (0x44u) /* 'D' */
+
+#define TLM_VARINT_MAX (5u)
+#define TLM_KEY_MAX (1u + TLM_VARINT_MAX + TLM_FIELD_CNT * 3u + 1u)
+#define TLM_RECORD_MAX (TLM_KEY_MAX + 2u) /* a delta also holds its mask */
+
+typedef enum
+{
+    TLM_FIELD_mode,
+    TLM_FIELD_qw,
+    TLM_FIELD_qx,
+    TLM_FIELD_qy,
+    TLM_FIELD_qz,
+    TLM_FIELD_rate_x,
+    TLM_FIELD_rate_y,
+    TLM_FIELD_rate_z,
+    TLM_FIELD_wheel_x,
+    TLM_FIELD_wheel_y,
+    TLM_FIELD_wheel_z,
+    TLM_FIELD_coil_x,
+    TLM_FIELD_coil_y,
+    TLM_FIELD_coil_z,
+    TLM_FIELD_jitter,
+    TLM_FIELD_overruns,
+    TLM_FIELD_CNT,
+} tlm_field;
+
+_Static_assert(TLM_FIELD_CNT == 16, "delta mask is 16 bits");
+_Static_assert(TLM_HDR_SIZE + TLM_KEY_MAX <= TLM_BATCH_SIZE,
+               "a new page must fit in one batch");
+
+typedef struct
+{
+    bool     active;
+    uint16_t first;    /* oldest page when the download started */
+    uint32_t last_seq; /* sequence number of the newest page then */
+    uint16_t k;        /* pages visited, oldest first */
+    uint16_t off;      /* next byte of the page to send */
+    uint16_t used;     /* bytes of the page that hold valid records */
+    uint32_t seq;      /* sequence number of the page being sent */
+    uint32_t frames;
+    uint32_t bytes;
+    uint16_t skipped; /* pages reused by the log before they were sent */
+} tlm_download;
+
+typedef struct
+{
+    bool     open; /* a page is being written */
+    uint16_t flash_off;
+    uint16_t batch_len;
+    uint8_t  batch[TLM_BATCH_SIZE];
+    int32_t  prev[TLM_FIELD_CNT];
+    uint32_t prev_t_ms;
+} tlm_writer;
+
+
+static TLM_status_t tlm_status;
+static tlm_writer   tlm_wr;
+static tlm_download tlm_dl;
+
+
+static void     TLM_quantise(const TLM_record_t *rec, int32_t v[TLM_FIELD_CNT]);
+static void     TLM_dequantise(const int32_t v[TLM_FIELD_CNT], uint32_t t_ms,
+                               TLM_record_t *rec);
+static int      TLM_open_page(void);
+static size_t   TLM_encode(const int32_t v[TLM_FIELD_CNT], uint32_t t_ms,
+                           bool key, uint8_t *out);
+static int      TLM_walk_page(const uint8_t *page, size_t len,
+                              TLM_decode_cb cb, void *ctx, size_t *used);
+static bool     TLM_page_header(const uint8_t *page, uint32_t *seq);
+static size_t   TLM_put_varint(uint8_t *out, uint32_t val);
+static bool     TLM_get_varint(const uint8_t *in, size_t len, size_t *pos,
+                               uint32_t *val);
+static uint8_t  TLM_crc8(const uint8_t *data, size_t len);
+static uint32_t TLM_zigzag(int32_t val);
+static int32_t  TLM_unzigzag(uint32_t val);
+
+
+void TLM_init(void)
+{
+    uint32_t seq, newest = 0;
+    uint16_t i;
+    bool     found = false;
+
+    memset(&tlm_status, 0, sizeof(tlm_status));
+    memset(&tlm_wr, 0, sizeof(tlm_wr));
+    memset(&tlm_dl, 0, sizeof(tlm_dl));
+    tlm_status.page = TLM_PAGE_CNT - 1; /* the first page opened is 0 */
+
+    for (i = 0; i < TLM_PAGE_CNT; i++)
+    {
+        if (TLM_page_header(TLM_NV_data(i), &seq))
+        {
+            tlm_status.pages_used++;
+            if (!found || seq > newest)
+            {
+                found           = true;
+                newest          = seq;
+                tlm_status.page = i;
+            }
+        }
+    }
+    tlm_status.seq = newest;
+}
+
+
+int TLM_log(const TLM_record_t *rec)
+{
+    CONFIG_ASSERT(NULL != rec);
+    int32_t v[TLM_FIELD_CNT];
+    uint8_t buf[TLM_RECORD_MAX];
+    size_t  len = 0;
+
+    TLM_quantise(rec, v);
+    if (tlm_wr.open)
+    {
+        len = TLM_encode(v, rec->t_ms, false, buf);
+        if (tlm_wr.flash_off + tlm_wr.batch_len + len > TLM_PAGE_SIZE)
+        {
+            TLM_flush();
+            tlm_wr.open = false; /* page full, start the next one */
+        }
+    }
+    if (!tlm_wr.open)
+    {
+        if (TLM_open_page())
+        {
+            return 1;
+        }
+        len = TLM_encode(v, rec->t_ms, true, buf);
+    }
+    if (tlm_wr.batch_len + len > TLM_BATCH_SIZE && TLM_flush())
+    {
+        return 1;
+    }
+
+    memcpy(&tlm_wr.batch[tlm_wr.batch_len], buf, len);
+    tlm_wr.batch_len += (uint16_t)len;
+    memcpy(tlm_wr.prev, v, sizeof(tlm_wr.prev));
+    tlm_wr.prev_t_ms = rec->t_ms;
+    tlm_status.records++;
+    tlm_status.bytes += len;
+    return 0;
+}
+
+
+int TLM_flush(void)
+{
+    if (tlm_wr.batch_len == 0)
+    {
+        return 0;
+    }
+
+    int err = TLM_NV_write(tlm_status.page, tlm_wr.flash_off, tlm_wr.batch,
+                           tlm_wr.batch_len);
+    tlm_wr.flash_off += tlm_wr.batch_len;
+    tlm_wr.batch_len = 0;
+    if (err)
+    {
+        /* The page ends at the damaged record, carry on in a new page */
+        tlm_status.errors++;
+        tlm_wr.open = false;
+        return 1;
+    }
+    return 0;
+}
+
+
+int TLM_erase(void)
+{
+    int      err = 0;
+    uint16_t i;
+    for (i = 0; i < TLM_PAGE_CNT; i++)
+    {
+        if (TLM_NV_erase(i))
+        {
+            tlm_status.errors++;
+            err = 1;
+        }
+        tlm_status.erases++;
+    }
+    memset(&tlm_wr, 0, sizeof(tlm_wr));
+    memset(&tlm_dl, 0, sizeof(tlm_dl));
+    tlm_status.page       = TLM_PAGE_CNT - 1;
+    tlm_status.pages_used = 0;
+    return err;
+}
+
+
+void TLM_get_status(TLM_status_t *status)
+{
+    CONFIG_ASSERT(NULL != status);
+    *status = tlm_status;
+}
+
+
+int TLM_decode_page(const uint8_t *page, size_t len, TLM_decode_cb cb,
+                    void *ctx)
+{
+    size_t used;
+    return TLM_walk_page(page, len, cb, ctx, &used);
+}
+
+
+const uint8_t *TLM_page(uint16_t page)
+{
+    return TLM_NV_data(page);
+}
+
+
+void TLM_download_start(void)
+{
+    TLM_flush();
+    memset(&tlm_dl, 0, sizeof(tlm_dl));
+    tlm_dl.first    = (uint16_t)((tlm_status.page + 1u) % TLM_PAGE_CNT);
+    tlm_dl.last_seq = tlm_status.seq;
+    tlm_dl.active   = true;
+}
+
+
+bool TLM_download_active(void)
+{
+    return tlm_dl.active;
+}
+
+
+int TLM_download_next(JW_t *w)
+{
+    CONFIG_ASSERT(NULL != w);
+    if (!tlm_dl.active)
+    {
+        return 1;
+    }
+
+    while (tlm_dl.k < TLM_PAGE_CNT)
+    {
+        /* Oldest page first, the page being written last, in the order they
+         * had when the download started. Logging carries on meanwhile, a
+         * page opened since then no longer holds what was to be sent */
+        const uint16_t page =
+            (uint16_t)((tlm_dl.first + tlm_dl.k) % TLM_PAGE_CNT);
+        const uint8_t *data  = TLM_NV_data(page);
+        uint32_t       seq   = 0;
+        bool           valid = TLM_page_header(data, &seq);
+        if (tlm_wr.open && page == tlm_status.page)
+        {
+            valid = true; /* its header may still be staged */
+            seq   = tlm_status.seq;
+        }
+        if (tlm_dl.off == 0 && valid && seq <= tlm_dl.last_seq)
+        {
+            size_t used = 0;
+            TLM_walk_page(data, TLM_PAGE_SIZE, NULL, NULL, &used);
+            tlm_dl.used = (uint16_t)used;
+            tlm_dl.seq  = seq;
+        }
+        else if (tlm_dl.off == 0 || !valid || seq != tlm_dl.seq)
+        {
+            if (valid || tlm_dl.off != 0)
+            {
+                tlm_dl.skipped++;
+            }
+            tlm_dl.used = 0;
+        }
+        if (tlm_dl.off >= tlm_dl.used)
+        {
+            tlm_dl.k++;
+            tlm_dl.off = 0;
+            continue;
+        }
+
+        uint16_t n = tlm_dl.used - tlm_dl.off;
+        n          = (n > TLM_FRAME_DATA_SIZE) ? TLM_FRAME_DATA_SIZE : n;
+        JW_object_begin(w);
+        JW_key(w, "tlm");
+        JW_object_begin(w);
+        JW_key(w, "f");
+        JW_uint(w, tlm_dl.frames);
+        JW_key(w, "seq");
+        JW_uint(w, seq);
+        JW_key(w, "off");
+        JW_uint(w, tlm_dl.off);
+        JW_key(w, "d");
+        JW_hex(w, &data[tlm_dl.off], n);
+        JW_object_end(w);
+        JW_object_end(w);
+        if (JW_error(w))
+        {
+            return 1;
+        }
+        tlm_dl.off += n;
+        tlm_dl.frames++;
+        tlm_dl.bytes += n;
+        return 0;
+    }
+
+    JW_object_begin(w);
+    JW_key(w, "tlm");
+    JW_object_begin(w);
+    JW_key(w, "end");
+    JW_uint(w, tlm_dl.frames);
+    JW_key(w, "bytes");
+    JW_uint(w, tlm_dl.bytes);
+    JW_key(w, "skip");
+    JW_uint(w, tlm_dl.skipped);
+    JW_object_end(w);
+    JW_object_end(w);
+    tlm_dl.active = false;
+    return JW_error(w);
+}
+
+
+int TLM_status_to_json(JW_t *w)
+{
+    CONFIG_ASSERT(NULL != w);
+    JW_object_begin(w);
+    JW_key(w, "seq");
+    JW_uint(w, tlm_status.seq);
+    JW_key(w, "pg");
+    JW_uint(w, tlm_status.page);
+    JW_key(w, "used");
+    JW_uint(w, tlm_status.pages_used);
+    JW_key(w, "recs");
+    JW_uint(w, tlm_status.records);
+    JW_key(w, "bytes");
+    JW_uint(w, tlm_status.bytes);
+    JW_key(w, "erases");
+    JW_uint(w, tlm_status.erases);
+    JW_key(w, "err");
+    JW_uint(w, tlm_status.errors);
+    JW_object_end(w);
+    return JW_error(w);
+}
+
+
+static void TLM_quantise(const TLM_record_t *rec, int32_t v[TLM_FIELD_CNT])
+{
+    v[TLM_FIELD_mode]     = rec->mode;
+    v[TLM_FIELD_qw]       = TLM_sat16(rec->q_body.w * TLM_Q_SCALE);
+    v[TLM_FIELD_qx]       = TLM_sat16(rec->q_body.x * TLM_Q_SCALE);
+    v[TLM_FIELD_qy]       = TLM_sat16(rec->q_body.y * TLM_Q_SCALE);
+    v[TLM_FIELD_qz]       = TLM_sat16(rec->q_body.z * TLM_Q_SCALE);
+    v[TLM_FIELD_rate_x]   = TLM_sat16(rec->rate_radps.x * TLM_RATE_SCALE);
+    v[TLM_FIELD_rate_y]   = TLM_sat16(rec->rate_radps.y * TLM_RATE_SCALE);
+    v[TLM_FIELD_rate_z]   = TLM_sat16(rec->rate_radps.z * TLM_RATE_SCALE);
+    v[TLM_FIELD_wheel_x]  = TLM_sat16(rec->wheel_radps.x * TLM_WHEEL_SCALE);
+    v[TLM_FIELD_wheel_y]  = TLM_sat16(rec->wheel_radps.y * TLM_WHEEL_SCALE);
+    v[TLM_FIELD_wheel_z]  = TLM_sat16(rec->wheel_radps.z * TLM_WHEEL_SCALE);
+    v[TLM_FIELD_coil_x]   = rec->coil_ma[0];
+    v[TLM_FIELD_coil_y]   = rec->coil_ma[1];
+    v[TLM_FIELD_coil_z]   = rec->coil_ma[2];
+    v[TLM_FIELD_jitter]   = rec->jitter_us;
+    v[TLM_FIELD_overruns] = rec->overruns;
+}
+
+
+static void TLM_dequantise(const int32_t v[TLM_FIELD_CNT], uint32_t t_ms,
+                           TLM_record_t *rec)
+{
+    rec->t_ms          = t_ms;
+    rec->mode          = (uint8_t)v[TLM_FIELD_mode];
+    rec->q_body.w      = v[TLM_FIELD_qw] / TLM_Q_SCALE;
+    rec->q_body.x      = v[TLM_FIELD_qx] / TLM_Q_SCALE;
+    rec->q_body.y      = v[TLM_FIELD_qy] / TLM_Q_SCALE;
+    rec->q_body.z      = v[TLM_FIELD_qz] / TLM_Q_SCALE;
+    rec->rate_radps.x  = v[TLM_FIELD_rate_x] / TLM_RATE_SCALE;
+    rec->rate_radps.y  = v[TLM_FIELD_rate_y] / TLM_RATE_SCALE;
+    rec->rate_radps.z  = v[TLM_FIELD_rate_z] / TLM_RATE_SCALE;
+    rec->wheel_radps.x = v[TLM_FIELD_wheel_x] / TLM_WHEEL_SCALE;
+    rec->wheel_radps.y = v[TLM_FIELD_wheel_y] / TLM_WHEEL_SCALE;
+    rec->wheel_radps.z = v[TLM_FIELD_wheel_z] / TLM_WHEEL_SCALE;
+    rec->coil_ma[0]    = (int16_t)v[TLM_FIELD_coil_x];
+    rec->coil_ma[1]    = (int16_t)v[TLM_FIELD_coil_y];
+    rec->coil_ma[2]    = (int16_t)v[TLM_FIELD_coil_z];
+    rec->jitter_us     = (uint16_t)v[TLM_FIELD_jitter];
+    rec->overruns      = (uint16_t)v[TLM_FIELD_overruns];
+}
+
+
+/* Erase the oldest page and stage its header */
+static int TLM_open_page(void)
+{
+    const uint16_t next = (uint16_t)((tlm_status.page + 1u) % TLM_PAGE_CNT);
+    uint32_t       seq;
+    const bool     reused = TLM_page_header(TLM_NV_data(next), &seq);
+
+    tlm_status.erases++;
+    if (TLM_NV_erase(next))
+    {
+        tlm_status.errors++;
+        return 1;
+    }
+    if (!reused)
+    {
+        tlm_status.pages_used++;
+    }
+    tlm_status.page = next;
+    tlm_status.seq++;
+
+    memset(tlm_wr.batch, FLASH_ERASED_BYTE, TLM_HDR_SIZE);
+    tlm_wr.batch[TLM_HDR_MAGIC]     = (uint8_t)(TLM_MAGIC & 0xFFu);
+    tlm_wr.batch[TLM_HDR_MAGIC + 1] = (uint8_t)(TLM_MAGIC >> 8);
+    tlm_wr.batch[TLM_HDR_VERSION]   = TLM_FORMAT_VERSION;
+    tlm_wr.batch[TLM_HDR_SEQ]       = (uint8_t)(tlm_status.seq);
+    tlm_wr.batch[TLM_HDR_SEQ + 1]   = (uint8_t)(tlm_status.seq >> 8);
+    tlm_wr.batch[TLM_HDR_SEQ + 2]   = (uint8_t)(tlm_status.seq >> 16);
+    tlm_wr.batch[TLM_HDR_SEQ + 3]   = (uint8_t)(tlm_status.seq >> 24);
+    tlm_wr.batch_len                = TLM_HDR_SIZE;
+    tlm_wr.flash_off                = 0;
+    tlm_wr.open                     = true;
+    return 0;
+}
+
+
+static size_t TLM_encode(const int32_t v[TLM_FIELD_CNT], uint32_t t_ms,
+                         bool key, uint8_t *out)
+{
+    size_t       len = 0;
+    unsigned int i;
+    if (key)
+    {
+        out[len++] = TLM_TAG_KEY;
+        len += TLM_put_varint(&out[len], t_ms);
+        for (i = 0; i < TLM_FIELD_CNT; i++)
+        {
+            len += TLM_put_varint(&out[len], TLM_zigzag(v[i]));
+        }
+    }
+    else
+    {
+        uint16_t mask = 0;
+        out[len++]    = TLM_TAG_DELTA;
+        len += TLM_put_varint(&out[len], t_ms - tlm_wr.prev_t_ms);
+        const size_t mask_pos = len;
+        len += 2;
+        for (i = 0; i < TLM_FIELD_CNT; i++)
+        {
+            if (v[i] != tlm_wr.prev[i])
+            {
+                mask |= (uint16_t)(1u << i);
+                len += TLM_put_varint(&out[len],
+                                      TLM_zigzag(v[i] - tlm_wr.prev[i]));
+            }
+        }
+        out[mask_pos]     = (uint8_t)(mask & 0xFFu);
+        out[mask_pos + 1] = (uint8_t)(mask >> 8);
+    }
+    out[len] = TLM_crc8(out, len);
+    return len + 1;
+}
+
+
+static int TLM_walk_page(const uint8_t *page, size_t len, TLM_decode_cb cb,
+                         void *ctx, size_t *used)
+{
+    int32_t      v[TLM_FIELD_CNT] = {0};
+    uint32_t     t_ms             = 0;
+    uint32_t     seq, val;
+    size_t       pos = TLM_HDR_SIZE;
+    bool         key_seen = false;
+    int          cnt      = 0;
+    unsigned int i;
+    TLM_record_t rec;
+
+    *used = 0;
+    if (NULL == page || len < TLM_HDR_SIZE || !TLM_page_header(page, &seq))
+    {
+        return -1;
+    }
+    *used = TLM_HDR_SIZE;
+
+    while (pos < len)
+    {
+        const size_t  start = pos;
+        const uint8_t tag   = page[pos++];
+        int32_t       nv[TLM_FIELD_CNT];
+        uint32_t      nt;
+        if (tag == TLM_TAG_KEY)
+        {
+            if (!TLM_get_varint(page, len, &pos, &nt))
+            {
+                break;
+            }
+            for (i = 0; i < TLM_FIELD_CNT; i++)
+            {
+                if (!TLM_get_varint(page, len, &pos, &val))
+                {
+                    break;
+                }
+                nv[i] = TLM_unzigzag(val);
+            }
+            if (i < TLM_FIELD_CNT)
+            {
+                break;
+            }
+        }
+        else if (tag == TLM_TAG_DELTA && key_seen)
+        {
+            if (!TLM_get_varint(page, len, &pos, &val) || pos + 2 > len)
+            {
+                break;
+            }
+            nt                  = t_ms + val;
+            const uint16_t mask = (uint16_t)(page[pos] | (page[pos + 1] << 8));
+            pos += 2;
+            memcpy(nv, v, sizeof(nv));
+            for (i = 0; i < TLM_FIELD_CNT; i++)
+            {
+                if (mask & (1u << i))
+                {
+                    if (!TLM_get_varint(page, len, &pos, &val))
+                    {
+                        break;
+                    }
+                    nv[i] += TLM_unzigzag(val);
+                }
+            }
+            if (i < TLM_FIELD_CNT)
+            {
+                break;
+            }
+        }
+        else
+        {
+            break; /* erased, or not a record */
+        }
+
+        if (pos >= len || page[pos] != TLM_crc8(&page[start], pos - start))
+        {
+            break;
+        }
+        pos++;
+
+        key_seen = true;
+        t_ms     = nt;
+        memcpy(v, nv, sizeof(v));
+        *used = pos;
+        cnt++;
+        if (NULL != cb)
+        {
+            TLM_dequantise(v, t_ms, &rec);
+            cb(&rec, ctx);
+        }
+    }
+    return cnt;
+}
+
+
+static bool TLM_page_header(const uint8_t *page, uint32_t *seq)
+{
+    if (NULL == page ||
+        (page[TLM_HDR_MAGIC] | (page[TLM_HDR_MAGIC + 1] << 8)) != TLM_MAGIC ||
+        page[TLM_HDR_VERSION] != TLM_FORMAT_VERSION)
+    {
+        return false;
+    }
+    *seq = (uint32_t)page[TLM_HDR_SEQ] |
+           ((uint32_t)page[TLM_HDR_SEQ + 1] << 8) |
+           ((uint32_t)page[TLM_HDR_SEQ + 2] << 16) |
+           ((uint32_t)page[TLM_HDR_SEQ + 3] << 24);
+    return true;
+}
+
+
+static size_t TLM_put_varint(uint8_t *out, uint32_t val)
+{
+    size_t len = 0;
+    while (val >= 0x80u)
+    {
+        out[len++] = (uint8_t)(val | 0x80u);
+        val >>= 7;
+    }
+    out[len++] = (uint8_t)val;
+    return len;
+}
+
+
+static bool TLM_get_varint(const uint8_t *in, size_t len, size_t *pos,
+                           uint32_t *val)
+{
+    uint32_t     result = 0;
+    unsigned int i;
+    for (i = 0; i < TLM_VARINT_MAX && *pos < len; i++)
+    {
+        const uint8_t byte = in[(*pos)++];
+        result |= (uint32_t)(byte & 0x7Fu) << (7 * i);
+        if (!(byte & 0x80u))
+        {
+            *val = result;
+            return true;
+        }
+    }
+    return false; /* truncated, or runs into erased flash */
+}
+
+
+/* CRC-8, polynomial 0x07 */
+static uint8_t TLM_crc8(const uint8_t *data, size_t len)
+{
+    uint8_t      crc = 0;
+    unsigned int bit;
+    while (len-- > 0)
+    {
+        crc ^= *data++;
+        for (bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x80u) ? (uint8_t)((crc << 1) ^ 0x07u)
+                                : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+
+static uint32_t TLM_zigzag(int32_t val)
+{
+    return ((uint32_t)val << 1) ^ (uint32_t)(val >> 31);
+}
+
+
+static int32_t TLM_unzigzag(uint32_t val)
+{
+    return (int32_t)(val >> 1) ^ -(int32_t)(val & 1u);
+}
+
+
+int16_t TLM_sat16(float val)
+{
+    if (!(val > INT16_MIN)) /* also catches NaN */
+    {
+        return (val > 0.0f) ? INT16_MAX : INT16_MIN;
+    }
+    if (val >= INT16_MAX)
+    {
+        return INT16_MAX;
+    }
+    return (int16_t)((val >= 0.0f) ? (val + 0.5f) : (val - 0.5f));
+}
@@ -0,0 +1,50 @@
+/**
+ * @file tlm_nv.h
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Private header selecting the flash region that backs the telemetry
+ * log
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ * @note The flash controller on the target, the emulated (optionally file
+ * backed) log region when running natively.
+ */
+#ifndef __TLM_NV_H__
+#define __TLM_NV_H__
+#ifdef __cplusplus
+/* clang-format off */
+extern "C"
+{
+/* clang-format on */
+#endif /* Start C linkage */
+
+#include "flash_types.h"
+
+#if defined(TARGET_MCU)
+
+#include "flash.h"
+
+#define TLM_NV_data(page) FLASH_log_segment((page))
+#define TLM_NV_erase(page) FLASH_log_erase((page))
+#define TLM_NV_write(page, offset, data, len)                                  \
+    FLASH_log_write((page), (offset), (data), (len))
+
+#else
+
+#include "flash_emulator.h"
+
+#define TLM_NV_data(page) FLASH_EMU_log_segment((page))
+#define TLM_NV_erase(page) FLASH_EMU_log_erase((page))
+#define TLM_NV_write(page, offset, data, len)                                  \
+    FLASH_EMU_log_write((page), (offset), (data), (len))
+
+#endif /* #if defined(TARGET_MCU) */
+
+#ifdef __cplusplus
+/* clang-format off */
+}
+/* clang-format on */
+#endif /* End C linkage */
+#endif /* __TLM_NV_H__ */
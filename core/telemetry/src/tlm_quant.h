@@ -0,0 +1,39 @@
+/**
+ * @file tlm_quant.h
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Private header with the fixed point scaling shared by the log
+ * records and the stream frames
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ */
+#ifndef __TLM_QUANT_H__
+#define __TLM_QUANT_H__
+#ifdef __cplusplus
+/* clang-format off */
+extern "C"
+{
+/* clang-format on */
+#endif /* Start C linkage */
+
+#include <stdint.h>
+
+#define TLM_Q_SCALE (32767.0f)
+#define TLM_RATE_SCALE (1.0e4f)  /* 0.1 mrad/s */
+#define TLM_WHEEL_SCALE (10.0f) /* 0.1 rad/s */
+
+
+/**
+ * @brief Round to the nearest integer, saturated to 16 bits. NaN saturates
+ * low.
+ */
+int16_t TLM_sat16(float val);
+
+#ifdef __cplusplus
+/* clang-format off */
+}
+/* clang-format on */
+#endif /* End C linkage */
+#endif /* __TLM_QUANT_H__ */
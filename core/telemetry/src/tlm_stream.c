@@ -0,0 +1,404 @@
+/**
+ * @file tlm_stream.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Periodic unsolicited telemetry frames for OBC subscriptions
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ * @note Frames are packed when their subscription is due and sent from the
+ * main loop one at a time, oldest first, so packing never waits on the
+ * uart.
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "targets.h"
+#include "config_assert.h"
+#include "tlm_stream.h"
+#include "tlm_quant.h"
+
+#define TLM_STREAM_US_PER_MS (1000u)
+
+/* Bytes the OBC link adds to a frame shorter than 254 bytes: a COBS code
+ * byte, the CRC and the delimiter */
+#define TLM_STREAM_LINK_FRAMING (4u)
+
+/* Frame without its data, frame counter at its widest, framed for the link */
+#define TLM_STREAM_FRAME_OVERHEAD                                              \
+    ((uint16_t)(sizeof("{\"s\":0,\"n\":65535,\"d\":\"\"}") - 1u +           \
+                TLM_STREAM_LINK_FRAMING))
+
+/* Every channel subscribed */
+#define TLM_STREAM_DATA_MAX (4u + 1u + 8u + 6u + 6u + 6u + 4u + 4u)
+
+typedef struct
+{
+    TLM_stream_sub_t sub;
+    bool             started;
+    uint32_t         last_us;
+    uint16_t         overruns; /* since the previous frame */
+    uint16_t         n;        /* frame number of the next frame */
+    bool             pending;  /* a packed frame waits to be sent */
+    uint32_t         packed;   /* order the pending frames were packed in */
+    uint8_t          len;
+    uint8_t          data[TLM_STREAM_DATA_MAX];
+} tlm_stream_slot;
+
+
+static const struct
+{
+    const char *name;
+    uint8_t     len;
+} tlm_channels[TLM_CH_cnt] = {
+    [TLM_CH_time]   = {"time", 4},
+    [TLM_CH_mode]   = {"mode", 1},
+    [TLM_CH_q]      = {"q", 8},
+    [TLM_CH_rate]   = {"rate", 6},
+    [TLM_CH_wheel]  = {"wheel", 6},
+    [TLM_CH_coil]   = {"coil", 6},
+    [TLM_CH_timing] = {"timing", 4},
+    [TLM_CH_isr]    = {"isr", 4},
+};
+
+_Static_assert(TLM_STREAM_SUB_CNT == 4, "status json lists 4 slots");
+
+static tlm_stream_slot     tlm_slots[TLM_STREAM_SUB_CNT];
+static TLM_stream_status_t tlm_stream_status;
+static uint32_t            tlm_packed;
+
+
+static bool     TLM_stream_slot_due(tlm_stream_slot *slot, uint32_t now);
+static void     TLM_stream_pack(tlm_stream_slot *slot, const TLM_record_t *rec);
+static uint8_t *TLM_stream_put16(uint8_t *out, uint16_t val);
+static uint16_t TLM_stream_load(uint16_t frame_len, uint16_t period_ms);
+
+
+void TLM_stream_init(void)
+{
+    memset(tlm_slots, 0, sizeof(tlm_slots));
+    memset(&tlm_stream_status, 0, sizeof(tlm_stream_status));
+    tlm_stream_status.cap_bps =
+        (uint16_t)(TLM_STREAM_LINK_BYTES_PER_S * TLM_STREAM_BUDGET_PCT / 100u);
+    tlm_packed = 0;
+}
+
+
+int TLM_stream_subscribe(uint8_t id, uint16_t channels, uint16_t period_ms)
+{
+    if (id >= TLM_STREAM_SUB_CNT || (channels & ~TLM_CH_ALL))
+    {
+        return 1;
+    }
+
+    tlm_stream_slot *slot = &tlm_slots[id];
+    if (channels == 0)
+    {
+        tlm_stream_status.load_bps -= slot->sub.load_bps;
+        memset(slot, 0, sizeof(*slot));
+        return 0;
+    }
+    if (period_ms < TLM_STREAM_PERIOD_MIN_MS)
+    {
+        return 1;
+    }
+
+    const uint16_t frame_len = TLM_stream_frame_len(channels);
+    const uint16_t load      = TLM_stream_load(frame_len, period_ms);
+    const uint32_t total =
+        (uint32_t)tlm_stream_status.load_bps - slot->sub.load_bps + load;
+    if (total > tlm_stream_status.cap_bps)
+    {
+        return 1;
+    }
+
+    memset(slot, 0, sizeof(*slot));
+    slot->sub.channels  = channels;
+    slot->sub.period_ms = period_ms;
+    slot->sub.frame_len = frame_len;
+    slot->sub.load_bps  = load;
+
+    tlm_stream_status.load_bps = (uint16_t)total;
+    return 0;
+}
+
+
+void TLM_stream_get_sub(uint8_t id, TLM_stream_sub_t *sub)
+{
+    CONFIG_ASSERT(NULL != sub);
+    CONFIG_ASSERT(id < TLM_STREAM_SUB_CNT);
+    *sub = tlm_slots[id].sub;
+}
+
+
+void TLM_stream_get_status(TLM_stream_status_t *status)
+{
+    CONFIG_ASSERT(NULL != status);
+    *status = tlm_stream_status;
+}
+
+
+uint16_t TLM_stream_frame_len(uint16_t channels)
+{
+    uint16_t     len = 0;
+    unsigned int ch;
+    for (ch = 0; ch < TLM_CH_cnt; ch++)
+    {
+        if (channels & TLM_CH_MASK(ch))
+        {
+            len += tlm_channels[ch].len;
+        }
+    }
+    return TLM_STREAM_FRAME_OVERHEAD + 2u * len;
+}
+
+
+bool TLM_stream_due(uint32_t now_us)
+{
+    unsigned int i;
+    for (i = 0; i < TLM_STREAM_SUB_CNT; i++)
+    {
+        const tlm_stream_slot *slot = &tlm_slots[i];
+        if (slot->sub.channels == 0)
+        {
+            continue;
+        }
+        if (!slot->started ||
+            now_us - slot->last_us >=
+                (uint32_t)slot->sub.period_ms * TLM_STREAM_US_PER_MS)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+void TLM_stream_sample(const TLM_record_t *rec, uint32_t now_us)
+{
+    CONFIG_ASSERT(NULL != rec);
+    unsigned int i;
+    for (i = 0; i < TLM_STREAM_SUB_CNT; i++)
+    {
+        tlm_stream_slot *slot = &tlm_slots[i];
+        if (slot->sub.channels == 0)
+        {
+            continue;
+        }
+
+        const uint32_t overruns = (uint32_t)slot->overruns + rec->overruns;
+        slot->overruns = (overruns > UINT16_MAX) ? UINT16_MAX : overruns;
+        if (TLM_stream_slot_due(slot, now_us))
+        {
+            if (slot->pending)
+            {
+                tlm_stream_status.dropped++;
+                slot->n++; /* leave a gap the OBC can see */
+            }
+            TLM_stream_pack(slot, rec);
+        }
+    }
+}
+
+
+int TLM_stream_next(JW_t *w)
+{
+    CONFIG_ASSERT(NULL != w);
+    tlm_stream_slot *oldest = NULL;
+    unsigned int     i;
+
+    for (i = 0; i < TLM_STREAM_SUB_CNT; i++)
+    {
+        tlm_stream_slot *slot = &tlm_slots[i];
+        if (slot->pending &&
+            (NULL == oldest || (int32_t)(slot->packed - oldest->packed) < 0))
+        {
+            oldest = slot;
+        }
+    }
+    if (NULL == oldest)
+    {
+        return 1;
+    }
+
+    JW_object_begin(w);
+    JW_key(w, "s");
+    JW_uint(w, (uint32_t)(oldest - tlm_slots));
+    JW_key(w, "n");
+    JW_uint(w, oldest->n);
+    JW_key(w, "d");
+    JW_hex(w, oldest->data, oldest->len);
+    JW_object_end(w);
+    if (JW_error(w))
+    {
+        return 1;
+    }
+    oldest->n++;
+    oldest->pending = false;
+    tlm_stream_status.frames++;
+    return 0;
+}
+
+
+int TLM_stream_channels_from_string(const char *str, uint16_t *channels)
+{
+    CONFIG_ASSERT(NULL != str);
+    CONFIG_ASSERT(NULL != channels);
+    uint16_t mask = 0;
+    while (*str != '\0')
+    {
+        const char  *end = strchr(str, ',');
+        const size_t len = (NULL != end) ? (size_t)(end - str) : strlen(str);
+        unsigned int ch;
+        for (ch = 0; ch < TLM_CH_cnt; ch++)
+        {
+            if (strlen(tlm_channels[ch].name) == len &&
+                strncmp(tlm_channels[ch].name, str, len) == 0)
+            {
+                mask |= TLM_CH_MASK(ch);
+                break;
+            }
+        }
+        if (ch == TLM_CH_cnt)
+        {
+            return 1;
+        }
+        str += len + ((NULL != end) ? 1 : 0);
+    }
+    *channels = mask;
+    return 0;
+}
+
+
+int TLM_stream_status_to_json(JW_t *w)
+{
+    CONFIG_ASSERT(NULL != w);
+    unsigned int i;
+    JW_object_begin(w);
+    JW_key(w, "subs");
+    JW_array_begin(w);
+    for (i = 0; i < TLM_STREAM_SUB_CNT; i++)
+    {
+        JW_uint(w, tlm_slots[i].sub.period_ms);
+    }
+    JW_array_end(w);
+    JW_key(w, "load");
+    JW_uint(w, tlm_stream_status.load_bps);
+    JW_key(w, "cap");
+    JW_uint(w, tlm_stream_status.cap_bps);
+    JW_key(w, "sent");
+    JW_uint(w, tlm_stream_status.frames);
+    JW_key(w, "drop");
+    JW_uint(w, tlm_stream_status.dropped);
+    JW_object_end(w);
+    return JW_error(w);
+}
+
+
+static bool TLM_stream_slot_due(tlm_stream_slot *slot, uint32_t now)
+{
+    const uint32_t period_us =
+        (uint32_t)slot->sub.period_ms * TLM_STREAM_US_PER_MS;
+    if (!slot->started)
+    {
+        slot->started = true;
+        slot->last_us = now;
+        return true;
+    }
+
+    const uint32_t elapsed_us = now - slot->last_us;
+    if (elapsed_us < period_us)
+    {
+        return false;
+    }
+    if (elapsed_us >= 2 * period_us)
+    {
+        slot->last_us = now; /* fell behind, re-phase */
+    }
+    else
+    {
+        slot->last_us += period_us;
+    }
+    return true;
+}
+
+
+static void TLM_stream_pack(tlm_stream_slot *slot, const TLM_record_t *rec)
+{
+    const uint16_t ch  = slot->sub.channels;
+    uint8_t       *out = slot->data;
+
+    if (ch & TLM_CH_MASK(TLM_CH_time))
+    {
+        out = TLM_stream_put16(out, (uint16_t)(rec->t_ms & 0xFFFFu));
+        out = TLM_stream_put16(out, (uint16_t)(rec->t_ms >> 16));
+    }
+    if (ch & TLM_CH_MASK(TLM_CH_mode))
+    {
+        *out++ = rec->mode;
+    }
+    if (ch & TLM_CH_MASK(TLM_CH_q))
+    {
+        out = TLM_stream_put16(out, TLM_sat16(rec->q_body.w * TLM_Q_SCALE));
+        out = TLM_stream_put16(out, TLM_sat16(rec->q_body.x * TLM_Q_SCALE));
+        out = TLM_stream_put16(out, TLM_sat16(rec->q_body.y * TLM_Q_SCALE));
+        out = TLM_stream_put16(out, TLM_sat16(rec->q_body.z * TLM_Q_SCALE));
+    }
+    if (ch & TLM_CH_MASK(TLM_CH_rate))
+    {
+        out = TLM_stream_put16(
+            out, TLM_sat16(rec->rate_radps.x * TLM_RATE_SCALE));
+        out = TLM_stream_put16(
+            out, TLM_sat16(rec->rate_radps.y * TLM_RATE_SCALE));
+        out = TLM_stream_put16(
+            out, TLM_sat16(rec->rate_radps.z * TLM_RATE_SCALE));
+    }
+    if (ch & TLM_CH_MASK(TLM_CH_wheel))
+    {
+        out = TLM_stream_put16(
+            out, TLM_sat16(rec->wheel_radps.x * TLM_WHEEL_SCALE));
+        out = TLM_stream_put16(
+            out, TLM_sat16(rec->wheel_radps.y * TLM_WHEEL_SCALE));
+        out = TLM_stream_put16(
+            out, TLM_sat16(rec->wheel_radps.z * TLM_WHEEL_SCALE));
+    }
+    if (ch & TLM_CH_MASK(TLM_CH_coil))
+    {
+        out = TLM_stream_put16(out, (uint16_t)rec->coil_ma[0]);
+        out = TLM_stream_put16(out, (uint16_t)rec->coil_ma[1]);
+        out = TLM_stream_put16(out, (uint16_t)rec->coil_ma[2]);
+    }
+    if (ch & TLM_CH_MASK(TLM_CH_timing))
+    {
+        out = TLM_stream_put16(out, rec->jitter_us);
+        out = TLM_stream_put16(out, slot->overruns);
+    }
+    if (ch & TLM_CH_MASK(TLM_CH_isr))
+    {
+        out = TLM_stream_put16(out, rec->isr_over);
+        out = TLM_stream_put16(out, rec->isr_pct);
+    }
+
+    slot->len      = (uint8_t)(out - slot->data);
+    slot->overruns = 0;
+    slot->pending  = true;
+    slot->packed   = tlm_packed++;
+}
+
+
+static uint8_t *TLM_stream_put16(uint8_t *out, uint16_t val)
+{
+    out[0] = (uint8_t)(val & 0xFFu);
+    out[1] = (uint8_t)(val >> 8);
+    return &out[2];
+}
+
+
+/* Bytes per second on the wire, rounded up */
+static uint16_t TLM_stream_load(uint16_t frame_len, uint16_t period_ms)
+{
+    return (uint16_t)(((uint32_t)frame_len * 1000u + period_ms - 1u) /
+                      period_ms);
+}
@@ -0,0 +1,140 @@
+/**
+ * @file tlm_bench.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Telemetry log benchmark: encode and program throughput and record
+ * density over a simulated nadir pointing orbit
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ * @note The throughput is host time through the flash emulator, it only
+ * shows the cost of the encoder relative to the records it produces. The
+ * density is what matters on orbit: it sets how much history fits in the
+ * log region at a given logging period.
+ */
+#if defined(TARGET_MCU)
+#error NATIVE TESTS CANNOT BE RUN ON A BARE METAL MICROCONTROLLER
+#endif /* #if defined(TARGET_MCU) */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+
+#include "telemetry.h"
+#include "parameters.h"
+#include "flash_emulator.h"
+#include "test_expect.h"
+
+#define ORBIT_PERIOD_S (5400.0f)
+#define ORBIT_RATE_RADPS (2.0f * 3.14159265f / ORBIT_PERIOD_S)
+#define BENCH_ORBITS (20u)
+
+/* Worst acceptable average record size in bytes. A key record on its own
+ * is about 40 bytes, so this only holds if the deltas do their job. */
+#define BENCH_MAX_BYTES_PER_RECORD (24.0)
+
+
+static uint32_t lcg_state = 12345u;
+
+
+/* Small deterministic sensor noise in [-1, 1] */
+static float noise(void)
+{
+    lcg_state = lcg_state * 1664525u + 1013904223u;
+    return ((float)(lcg_state >> 8) / (float)(1u << 23)) - 1.0f;
+}
+
+
+/* Nadir pointing: the body turns once per orbit about its pitch axis */
+static void orbit_record(uint32_t t_ms, TLM_record_t *rec)
+{
+    const float theta = 0.5f * ORBIT_RATE_RADPS * (t_ms / 1000.0f);
+    rec->t_ms          = t_ms;
+    rec->mode          = 3;
+    rec->q_body.w      = cosf(theta);
+    rec->q_body.x      = 0.001f * noise();
+    rec->q_body.y      = sinf(theta);
+    rec->q_body.z      = 0.001f * noise();
+    rec->rate_radps.x  = 2.0e-4f * noise();
+    rec->rate_radps.y  = ORBIT_RATE_RADPS + 2.0e-4f * noise();
+    rec->rate_radps.z  = 2.0e-4f * noise();
+    rec->wheel_radps.x = 0.5f * noise();
+    rec->wheel_radps.y = 150.0f + 5.0f * sinf(2.0f * theta);
+    rec->wheel_radps.z = 0.5f * noise();
+    rec->coil_ma[0]    = (int16_t)(20.0f * sinf(2.0f * theta));
+    rec->coil_ma[1]    = (int16_t)(20.0f * cosf(2.0f * theta));
+    rec->coil_ma[2]    = 0;
+    rec->jitter_us     = 120;
+    rec->overruns      = 0;
+}
+
+
+static double seconds(const struct timespec *a, const struct timespec *b)
+{
+    return (b->tv_sec - a->tv_sec) + (b->tv_nsec - a->tv_nsec) * 1.0e-9;
+}
+
+
+int main(void)
+{
+    const uint32_t  period_ms = (uint32_t)PARAM_get_int(PARAM_tlm_period_ms);
+    const uint32_t  per_orbit = (uint32_t)(ORBIT_PERIOD_S * 1000u) / period_ms;
+    TLM_record_t    rec;
+    TLM_status_t    status;
+    struct timespec start, end;
+    uint32_t        k;
+
+    FLASH_EMU_init();
+    TLM_init();
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (k = 0; k < BENCH_ORBITS * per_orbit; k++)
+    {
+        orbit_record(k * period_ms, &rec);
+        EXPECT(TLM_log(&rec) == 0);
+    }
+    EXPECT(TLM_flush() == 0);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    TLM_get_status(&status);
+    EXPECT(status.records == k && status.errors == 0);
+
+    const double elapsed       = seconds(&start, &end);
+    const double bytes_per_rec = (double)status.bytes / status.records;
+
+    /* Density of what is actually in flash, headers and page tails included */
+    uint32_t records_in_log = 0;
+    uint16_t i;
+    for (i = 0; i < TLM_PAGE_CNT; i++)
+    {
+        const int cnt = TLM_decode_page(TLM_page(i), TLM_PAGE_SIZE, NULL, NULL);
+        EXPECT(cnt > 0);
+        records_in_log += (uint32_t)cnt;
+    }
+    const double flash_per_rec =
+        (double)(TLM_PAGE_CNT * TLM_PAGE_SIZE) / records_in_log;
+    const double history_orbits =
+        (double)(records_in_log - records_in_log / TLM_PAGE_CNT) / per_orbit;
+
+    printf("records          : %lu over %u orbits\n",
+           (unsigned long)status.records, BENCH_ORBITS);
+    printf("throughput       : %.0f records/s, %.2f MB/s encoded\n",
+           status.records / elapsed, status.bytes / elapsed / 1.0e6);
+    printf("encoded size     : %.2f bytes/record\n", bytes_per_rec);
+    printf("flash footprint  : %.2f bytes/record (%lu in %u bytes)\n",
+           flash_per_rec, (unsigned long)records_in_log,
+           TLM_PAGE_CNT * TLM_PAGE_SIZE);
+    printf("history          : %.2f orbits at %lu ms (oldest page erased)\n",
+           history_orbits, (unsigned long)period_ms);
+    printf("page erases      : %lu (%.1f per orbit)\n",
+           (unsigned long)status.erases, (double)status.erases / BENCH_ORBITS);
+
+    EXPECT(bytes_per_rec < BENCH_MAX_BYTES_PER_RECORD);
+    EXPECT(flash_per_rec < BENCH_MAX_BYTES_PER_RECORD);
+    EXPECT(history_orbits > 1.0); /* the default period keeps a full orbit */
+
+    printf("PASS\n");
+    return 0;
+}
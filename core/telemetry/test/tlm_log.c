@@ -0,0 +1,535 @@
+/**
+ * @file tlm_log.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Telemetry log tests: encode/decode round trip, ring wrap and wear,
+ * reboots through a file backed log, power loss while programming and the
+ * bulk download, also while logging goes on
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ */
+#if defined(TARGET_MCU)
+#error NATIVE TESTS CANNOT BE RUN ON A BARE METAL MICROCONTROLLER
+#endif /* #if defined(TARGET_MCU) */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "telemetry.h"
+#include "flash_emulator.h"
+#include "test_expect.h"
+
+#define IMAGE_PATH "tlm_log_flash.bin"
+#define MAX_RECORDS (256)
+
+typedef struct
+{
+    TLM_record_t rec[MAX_RECORDS];
+    int          cnt;
+} record_list;
+
+
+static void collect(const TLM_record_t *rec, void *ctx)
+{
+    record_list *list = (record_list *)ctx;
+    if (list->cnt < MAX_RECORDS)
+    {
+        list->rec[list->cnt] = *rec;
+    }
+    list->cnt++;
+}
+
+
+/* Record k of a slowly tumbling spacecraft */
+static void make_record(int k, TLM_record_t *rec)
+{
+    const float a = 0.01f * k;
+    memset(rec, 0, sizeof(*rec));
+    rec->t_ms          = 10000u * (uint32_t)k;
+    rec->mode          = (uint8_t)(k / 50);
+    rec->q_body.w      = cosf(a);
+    rec->q_body.x      = sinf(a);
+    rec->q_body.y      = 0.0f;
+    rec->q_body.z      = 0.0f;
+    rec->rate_radps.x  = 0.001f;
+    rec->rate_radps.y  = -0.0005f * (k % 3);
+    rec->rate_radps.z  = 0.0f;
+    rec->wheel_radps.x = 100.0f + 0.1f * k;
+    rec->wheel_radps.y = -50.0f;
+    rec->wheel_radps.z = 0.0f;
+    rec->coil_ma[0]    = (int16_t)(k % 7);
+    rec->coil_ma[1]    = -12;
+    rec->coil_ma[2]    = 0;
+    rec->jitter_us     = (uint16_t)(20 + k / 10);
+    rec->overruns      = (uint16_t)(k % 100 == 0);
+}
+
+
+static bool close_to(const TLM_record_t *a, const TLM_record_t *b)
+{
+    const float q = 1.0f / 32767.0f, r = 1.0e-4f, w = 0.1f;
+    return a->t_ms == b->t_ms && a->mode == b->mode &&
+           fabsf(a->q_body.w - b->q_body.w) <= q &&
+           fabsf(a->q_body.x - b->q_body.x) <= q &&
+           fabsf(a->q_body.y - b->q_body.y) <= q &&
+           fabsf(a->q_body.z - b->q_body.z) <= q &&
+           fabsf(a->rate_radps.x - b->rate_radps.x) <= r &&
+           fabsf(a->rate_radps.y - b->rate_radps.y) <= r &&
+           fabsf(a->rate_radps.z - b->rate_radps.z) <= r &&
+           fabsf(a->wheel_radps.x - b->wheel_radps.x) <= w &&
+           fabsf(a->wheel_radps.y - b->wheel_radps.y) <= w &&
+           fabsf(a->wheel_radps.z - b->wheel_radps.z) <= w &&
+           a->coil_ma[0] == b->coil_ma[0] && a->coil_ma[1] == b->coil_ma[1] &&
+           a->coil_ma[2] == b->coil_ma[2] && a->jitter_us == b->jitter_us &&
+           a->overruns == b->overruns;
+}
+
+
+static int hex_nibble(char c)
+{
+    if (c >= '0' && c <= '9')
+    {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f')
+    {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+
+/* The next download frame into buf, as the main loop writes it into the tx
+ * buffer */
+static int download_next(char *buf, uint16_t buflen)
+{
+    JW_t jw;
+    JW_init(&jw, buf, buflen);
+    return TLM_download_next(&jw) || JW_finish(&jw);
+}
+
+
+/* Fill a few pages, pull the whole log through the download frames and
+ * check that it reassembles to the flash contents, oldest page first */
+static int download_test(void)
+{
+    static uint8_t image[TLM_PAGE_CNT][TLM_PAGE_SIZE];
+    uint32_t       image_seq[TLM_PAGE_CNT];
+    uint16_t       image_len[TLM_PAGE_CNT];
+    unsigned int   pages = 0;
+    unsigned long  frames = 0, bytes = 0, end_frames, end_bytes, end_skip;
+    char           frame[200];
+    TLM_record_t   rec;
+    TLM_status_t   status;
+    int            k;
+
+    FLASH_EMU_init();
+    TLM_init();
+    for (k = 0; k < 2000; k++)
+    {
+        make_record(k, &rec);
+        EXPECT(TLM_log(&rec) == 0);
+    }
+    TLM_get_status(&status);
+    EXPECT(status.pages_used == TLM_PAGE_CNT); /* wrapped at least once */
+
+    TLM_download_start();
+    EXPECT(TLM_download_active());
+    for (;;)
+    {
+        unsigned long f, seq, off;
+        int           n;
+        EXPECT(download_next(frame, sizeof(frame)) == 0);
+        if (sscanf(frame, "{\"tlm\":{\"end\":%lu,\"bytes\":%lu,\"skip\":%lu}}",
+                   &end_frames, &end_bytes, &end_skip) == 3)
+        {
+            break;
+        }
+        EXPECT(sscanf(frame, "{\"tlm\":{\"f\":%lu,\"seq\":%lu,\"off\":%lu,%n",
+                      &f, &seq, &off, &n) == 3);
+        EXPECT(f == frames);
+        EXPECT(strncmp(&frame[n], "\"d\":\"", 5) == 0);
+        if (off == 0)
+        {
+            EXPECT(pages < TLM_PAGE_CNT);
+            EXPECT(pages == 0 || seq == image_seq[pages - 1] + 1);
+            image_seq[pages] = (uint32_t)seq;
+            image_len[pages] = 0;
+            pages++;
+        }
+        EXPECT(pages > 0 && seq == image_seq[pages - 1]);
+        EXPECT(off == image_len[pages - 1]);
+
+        const char *hex = &frame[n + 5];
+        while (*hex != '"')
+        {
+            const int hi = hex_nibble(hex[0]), lo = hex_nibble(hex[1]);
+            EXPECT(hi >= 0 && lo >= 0);
+            EXPECT(image_len[pages - 1] < TLM_PAGE_SIZE);
+            image[pages - 1][image_len[pages - 1]++] = (uint8_t)(hi << 4 | lo);
+            hex += 2;
+            bytes++;
+        }
+        EXPECT(strcmp(hex, "\"}}") == 0);
+        frames++;
+    }
+    EXPECT(!TLM_download_active());
+    EXPECT(download_next(frame, sizeof(frame)) == 1);
+    EXPECT(end_frames == frames && end_bytes == bytes);
+    EXPECT(end_skip == 0);
+    EXPECT(pages == TLM_PAGE_CNT);
+    EXPECT(image_seq[pages - 1] == status.seq);
+
+    /* Every page matches flash and decodes from the downloaded bytes alone */
+    unsigned int i;
+    int          total = 0;
+    for (i = 0; i < pages; i++)
+    {
+        const uint16_t page = (uint16_t)((status.page + 1u + i) % TLM_PAGE_CNT);
+        EXPECT(memcmp(image[i], TLM_page(page), image_len[i]) == 0);
+        const int cnt = TLM_decode_page(image[i], image_len[i], NULL, NULL);
+        EXPECT(cnt > 0);
+        EXPECT(TLM_decode_page(TLM_page(page), TLM_PAGE_SIZE, NULL, NULL) ==
+               cnt);
+        total += cnt;
+    }
+    printf("download : %u pages, %lu frames, %lu bytes, %d records\n", pages,
+           frames, bytes, total);
+
+    /* A buffer too small for a frame is refused without losing the frame */
+    TLM_download_start();
+    EXPECT(download_next(frame, 40) == 1);
+    EXPECT(TLM_download_active());
+    EXPECT(download_next(frame, sizeof(frame)) == 0);
+    EXPECT(strstr(frame, "\"f\":0,") != NULL);
+    return 0;
+}
+
+
+/* The mode task keeps logging while the frames go out. Every page that is
+ * sent was in the log at the start, goes out in order and decodes to the
+ * records that were logged, the pages reused meanwhile are counted as
+ * skipped */
+static int download_while_logging_test(void)
+{
+    static uint8_t     image[TLM_PAGE_SIZE];
+    static record_list list;
+    uint16_t           image_len = 0;
+    unsigned long      page_seq = 0, pages = 0, records = 0, frames = 0;
+    unsigned long      end_frames, end_bytes, end_skip;
+    char               frame[200];
+    TLM_record_t       rec;
+    TLM_status_t       status;
+    int                k, i;
+
+    FLASH_EMU_init();
+    TLM_init();
+    for (k = 0; k < 2000; k++)
+    {
+        make_record(k, &rec);
+        EXPECT(TLM_log(&rec) == 0);
+    }
+    TLM_get_status(&status);
+    const uint32_t last_seq = status.seq;
+
+    TLM_download_start();
+    for (;;)
+    {
+        unsigned long f, seq, off;
+        int           n;
+        EXPECT(download_next(frame, sizeof(frame)) == 0);
+        const bool end =
+            sscanf(frame, "{\"tlm\":{\"end\":%lu,\"bytes\":%lu,\"skip\":%lu}}",
+                   &end_frames, &end_bytes, &end_skip) == 3;
+        if (!end)
+        {
+            EXPECT(sscanf(frame,
+                          "{\"tlm\":{\"f\":%lu,\"seq\":%lu,\"off\":%lu,%n", &f,
+                          &seq, &off, &n) == 3);
+            EXPECT(f == frames);
+            frames++;
+        }
+
+        /* A page is over once the next one starts, it may have been cut
+         * short when the log reused it */
+        if ((end || off == 0) && image_len > 0)
+        {
+            list.cnt      = 0;
+            const int cnt = TLM_decode_page(image, image_len, collect, &list);
+            EXPECT(cnt >= 0 && cnt <= MAX_RECORDS);
+            for (i = 0; i < cnt; i++)
+            {
+                TLM_record_t want;
+                make_record((int)(list.rec[i].t_ms / 10000u), &want);
+                EXPECT(close_to(&list.rec[i], &want));
+            }
+            records += (unsigned long)cnt;
+            pages++;
+            image_len = 0;
+        }
+        if (end)
+        {
+            break;
+        }
+        if (off == 0)
+        {
+            EXPECT(seq > page_seq && seq <= last_seq);
+            page_seq = seq;
+        }
+        EXPECT(seq == page_seq && off == image_len);
+        const char *hex = &frame[n + 5];
+        while (*hex != '"')
+        {
+            EXPECT(image_len < TLM_PAGE_SIZE);
+            image[image_len++] =
+                (uint8_t)(hex_nibble(hex[0]) << 4 | hex_nibble(hex[1]));
+            hex += 2;
+        }
+
+        /* More bytes logged than sent for every frame, the log overtakes
+         * the download and reuses the oldest pages before they go */
+        for (i = 0; i < 6; i++, k++)
+        {
+            make_record(k, &rec);
+            EXPECT(TLM_log(&rec) == 0);
+        }
+    }
+    EXPECT(!TLM_download_active());
+    EXPECT(end_frames == frames);
+    EXPECT(end_skip > 0);
+    /* Each page went whole, was skipped, or both if it was cut short */
+    EXPECT(pages > 0 && pages + end_skip >= TLM_PAGE_CNT);
+    printf("download while logging : %lu pages sent, %lu skipped, %lu "
+           "records, %d logged meanwhile\n",
+           pages, end_skip, records, k - 2000);
+
+    /* The page being sent is reused: the rest of it is not sent */
+    TLM_download_start();
+    EXPECT(download_next(frame, sizeof(frame)) == 0);
+    EXPECT(strstr(frame, "\"off\":0,") != NULL);
+    const unsigned long first_seq = strtoul(strstr(frame, "\"seq\":") + 6,
+                                            NULL, 10);
+    TLM_get_status(&status);
+    const uint32_t seq_at_start = status.seq;
+    while (status.seq == seq_at_start)
+    {
+        make_record(k++, &rec);
+        EXPECT(TLM_log(&rec) == 0);
+        TLM_get_status(&status);
+    }
+    EXPECT(download_next(frame, sizeof(frame)) == 0);
+    EXPECT(strstr(frame, "\"off\":0,") != NULL);
+    EXPECT(strtoul(strstr(frame, "\"seq\":") + 6, NULL, 10) ==
+           first_seq + 1);
+    do
+    {
+        EXPECT(download_next(frame, sizeof(frame)) == 0);
+    } while (strstr(frame, "\"end\"") == NULL);
+    EXPECT(sscanf(frame, "{\"tlm\":{\"end\":%lu,\"bytes\":%lu,\"skip\":%lu}}",
+                  &end_frames, &end_bytes, &end_skip) == 3);
+    EXPECT(end_skip == 1);
+    return 0;
+}
+
+
+int main(void)
+{
+    static record_list list;
+    TLM_record_t       rec;
+    TLM_status_t       status;
+    char               buf[100];
+    int                k;
+
+    /* Blank flash: nothing to resume from */
+    FLASH_EMU_init();
+    TLM_init();
+    TLM_get_status(&status);
+    EXPECT(status.pages_used == 0 && status.records == 0);
+    EXPECT(TLM_decode_page(TLM_page(0), TLM_PAGE_SIZE, NULL, NULL) == -1);
+
+    /* Round trip within one quantisation step */
+    for (k = 0; k < 20; k++)
+    {
+        make_record(k, &rec);
+        EXPECT(TLM_log(&rec) == 0);
+    }
+    EXPECT(FLASH_EMU_log_erase_count(0) == 1);
+    EXPECT(TLM_flush() == 0);
+    memset(&list, 0, sizeof(list));
+    EXPECT(TLM_decode_page(TLM_page(0), TLM_PAGE_SIZE, collect, &list) == 20);
+    for (k = 0; k < 20; k++)
+    {
+        make_record(k, &rec);
+        EXPECT(close_to(&rec, &list.rec[k]));
+    }
+    TLM_get_status(&status);
+    EXPECT(status.records == 20 && status.seq == 1 && status.page == 0);
+    printf("round trip : %lu bytes for 20 records\n",
+           (unsigned long)status.bytes);
+
+    /* Out of range values saturate instead of wrapping */
+    make_record(20, &rec);
+    rec.rate_radps.x  = 10.0f;
+    rec.rate_radps.y  = -10.0f;
+    rec.wheel_radps.z = NAN;
+    EXPECT(TLM_log(&rec) == 0);
+    EXPECT(TLM_flush() == 0);
+    memset(&list, 0, sizeof(list));
+    EXPECT(TLM_decode_page(TLM_page(0), TLM_PAGE_SIZE, collect, &list) == 21);
+    EXPECT(fabsf(list.rec[20].rate_radps.x - 3.2767f) < 1.0e-4f);
+    EXPECT(fabsf(list.rec[20].rate_radps.y + 3.2768f) < 1.0e-4f);
+    EXPECT(list.rec[20].wheel_radps.z < -3000.0f);
+
+    /* Go round the ring three times: every page is erased once per use and
+     * the page being written is always the newest */
+    FLASH_EMU_init();
+    TLM_init();
+    uint32_t seq = 0;
+    for (k = 0; seq < 3 * TLM_PAGE_CNT; k++)
+    {
+        make_record(k, &rec);
+        EXPECT(TLM_log(&rec) == 0);
+        TLM_get_status(&status);
+        EXPECT(status.seq == seq || status.seq == seq + 1);
+        seq = status.seq;
+        EXPECT(status.page == (seq - 1) % TLM_PAGE_CNT);
+    }
+    uint16_t i;
+    uint32_t erases = 0;
+    for (i = 0; i < TLM_PAGE_CNT; i++)
+    {
+        const uint32_t cnt = FLASH_EMU_log_erase_count(i);
+        EXPECT(cnt == 3u);
+        erases += cnt;
+    }
+    EXPECT(status.erases == erases && erases == seq);
+    EXPECT(status.pages_used == TLM_PAGE_CNT && status.errors == 0);
+    printf("wrap : %d records in %lu pages, %lu bytes\n", k,
+           (unsigned long)seq, (unsigned long)status.bytes);
+
+    /* Reboot: resume on the page after the newest, keep the rest */
+    EXPECT(TLM_flush() == 0);
+    const uint16_t newest = status.page;
+    TLM_init();
+    TLM_get_status(&status);
+    EXPECT(status.seq == seq && status.page == newest);
+    EXPECT(status.pages_used == TLM_PAGE_CNT && status.records == 0);
+    make_record(k, &rec);
+    EXPECT(TLM_log(&rec) == 0);
+    TLM_get_status(&status);
+    EXPECT(status.seq == seq + 1);
+    EXPECT(status.page == (newest + 1) % TLM_PAGE_CNT);
+    EXPECT(TLM_decode_page(TLM_page(newest), TLM_PAGE_SIZE, NULL, NULL) > 0);
+
+    /* Power cycle through a memory mapped log file */
+    remove(IMAGE_PATH);
+    FLASH_EMU_init();
+    EXPECT(FLASH_EMU_log_map_file(IMAGE_PATH) == 0);
+    TLM_init();
+    for (k = 0; k < 100; k++)
+    {
+        make_record(k, &rec);
+        EXPECT(TLM_log(&rec) == 0);
+    }
+    EXPECT(TLM_flush() == 0);
+    TLM_get_status(&status);
+    seq = status.seq;
+    FLASH_EMU_log_unmap_file();
+    FLASH_EMU_init(); /* power cycle: RAM image is blank */
+    EXPECT(TLM_decode_page(TLM_page(0), TLM_PAGE_SIZE, NULL, NULL) == -1);
+    EXPECT(FLASH_EMU_log_map_file(IMAGE_PATH) == 0);
+    TLM_init();
+    TLM_get_status(&status);
+    EXPECT(status.seq == seq);
+    int total = 0;
+    for (i = 0; i < TLM_PAGE_CNT; i++)
+    {
+        const int cnt = TLM_decode_page(TLM_page(i), TLM_PAGE_SIZE, NULL, NULL);
+        total += (cnt > 0) ? cnt : 0;
+    }
+    EXPECT(total == 100);
+    FLASH_EMU_log_unmap_file();
+    remove(IMAGE_PATH);
+
+    /* Power lost while a batch is programmed: the records before the cut
+     * still decode, the decoder stops at the torn record */
+    uint32_t budget;
+    for (budget = 1; budget < 3 * TLM_BATCH_SIZE; budget += 7)
+    {
+        FLASH_EMU_init();
+        TLM_init();
+        for (k = 0; k < 10; k++)
+        {
+            make_record(k, &rec);
+            EXPECT(TLM_log(&rec) == 0);
+        }
+        EXPECT(TLM_flush() == 0);
+        FLASH_EMU_power_loss_after(budget);
+        int logged = 10;
+        for (k = 10; k < 100 && !FLASH_EMU_power_lost(); k++)
+        {
+            make_record(k, &rec);
+            if (TLM_log(&rec) == 0)
+            {
+                logged++;
+            }
+        }
+        TLM_flush();
+        FLASH_EMU_power_restore();
+
+        memset(&list, 0, sizeof(list));
+        const int cnt =
+            TLM_decode_page(TLM_page(0), TLM_PAGE_SIZE, collect, &list);
+        EXPECT(cnt >= 10 && cnt <= logged);
+        for (k = 0; k < cnt; k++)
+        {
+            make_record(k, &rec);
+            EXPECT(close_to(&rec, &list.rec[k]));
+        }
+        TLM_get_status(&status);
+        EXPECT(status.errors > 0);
+
+        /* After the reset logging carries on in a fresh page */
+        TLM_init();
+        make_record(100, &rec);
+        EXPECT(TLM_log(&rec) == 0);
+        EXPECT(TLM_flush() == 0);
+        TLM_get_status(&status);
+        EXPECT(status.page != 0);
+        EXPECT(TLM_decode_page(TLM_page(0), TLM_PAGE_SIZE, NULL, NULL) == cnt);
+    }
+
+    /* Erase clears the region and counts the erases */
+    EXPECT(TLM_erase() == 0);
+    TLM_get_status(&status);
+    EXPECT(status.pages_used == 0);
+    for (i = 0; i < TLM_PAGE_CNT; i++)
+    {
+        EXPECT(TLM_decode_page(TLM_page(i), TLM_PAGE_SIZE, NULL, NULL) == -1);
+    }
+
+    if (download_test())
+    {
+        return 1;
+    }
+    if (download_while_logging_test())
+    {
+        return 1;
+    }
+
+    JW_t jw;
+    JW_init(&jw, buf, sizeof(buf));
+    EXPECT(TLM_status_to_json(&jw) == 0);
+    EXPECT(JW_finish(&jw) == 0);
+    EXPECT(strncmp(buf, "{\"seq\":", 7) == 0);
+    JW_init(&jw, buf, 10);
+    EXPECT(TLM_status_to_json(&jw) == 1);
+
+    printf("PASS\n");
+    return 0;
+}
@@ -0,0 +1,258 @@
+/**
+ * @file tlm_stream_rate.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Telemetry subscription tests: bandwidth accounting, frame packing
+ * and the sustained frame rate over the emulated uart
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ */
+#if defined(TARGET_MCU)
+#error NATIVE TESTS CANNOT BE RUN ON A BARE METAL MICROCONTROLLER
+#endif /* #if defined(TARGET_MCU) */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "tlm_stream.h"
+#include "uart_emulator.h"
+#include "test_expect.h"
+
+#define SIM_SECONDS (60u)
+#define SIM_STEP_US (1000u) /* one main loop iteration */
+
+/* Subscribed every 200, 300 and 2000 ms: 5 + 3.33 + 0.5 = 8.83 frames/s */
+#define SUBSCRIBED_FPS (1000.0 / 200 + 1000.0 / 300 + 1000.0 / 2000)
+
+#define CH(name) TLM_CH_MASK(TLM_CH_##name)
+
+typedef struct
+{
+    uint32_t frames;
+    uint32_t gaps; /* frames the OBC saw missing from the frame counter */
+    uint16_t next_n;
+    uint16_t max_len;
+} sub_rx;
+
+
+/* The next frame into buf, as the main loop writes it into the tx buffer */
+static int stream_next(char *buf, uint16_t buflen)
+{
+    JW_t jw;
+    JW_init(&jw, buf, buflen);
+    return TLM_stream_next(&jw) || JW_finish(&jw);
+}
+
+
+static void make_record(uint32_t t_ms, TLM_record_t *rec)
+{
+    memset(rec, 0, sizeof(*rec));
+    rec->t_ms         = t_ms;
+    rec->mode         = 2;
+    rec->q_body.w     = 0.5f;
+    rec->q_body.x     = -0.5f;
+    rec->q_body.y     = 0.5f;
+    rec->q_body.z     = -0.5f;
+    rec->rate_radps.y = 0.0012f;
+    rec->overruns     = 1;
+}
+
+
+/* Run the main loop against a uart at baud, return the frames the OBC
+ * received per subscription */
+static int run_link(uint32_t baud, sub_rx rx[TLM_STREAM_SUB_CNT])
+{
+    char         frame[200];
+    TLM_record_t rec;
+    uint32_t     now_us;
+
+    UART_EMU_init(baud);
+    memset(rx, 0, TLM_STREAM_SUB_CNT * sizeof(*rx));
+    for (now_us = 0; now_us < SIM_SECONDS * 1000000u; now_us += SIM_STEP_US)
+    {
+        if (TLM_stream_due(now_us))
+        {
+            make_record(now_us / 1000u, &rec);
+            TLM_stream_sample(&rec, now_us);
+        }
+        if (UART_EMU_busy(now_us) || stream_next(frame, sizeof(frame)))
+        {
+            continue;
+        }
+
+        /* Framed on the link: a code byte, the CRC and the delimiter */
+        const uint16_t len = (uint16_t)(strlen(frame) + 4u);
+        EXPECT(UART_EMU_tx(now_us, (const uint8_t *)frame, len) == 0);
+
+        unsigned int id, n;
+        EXPECT(sscanf(frame, "{\"s\":%u,\"n\":%u,", &id, &n) == 2);
+        EXPECT(id < TLM_STREAM_SUB_CNT);
+        rx[id].gaps += (uint16_t)(n - rx[id].next_n);
+        rx[id].next_n = (uint16_t)(n + 1u);
+        rx[id].frames++;
+        rx[id].max_len = (len > rx[id].max_len) ? len : rx[id].max_len;
+    }
+    return 0;
+}
+
+
+int main(void)
+{
+    TLM_stream_status_t status;
+    TLM_stream_sub_t    sub;
+    sub_rx              rx[TLM_STREAM_SUB_CNT];
+    UART_EMU_stats_t    uart;
+    uint16_t            mask;
+    char                buf[200];
+    unsigned int        i;
+
+    TLM_stream_init();
+    TLM_stream_get_status(&status);
+    EXPECT(status.load_bps == 0);
+    EXPECT(status.cap_bps ==
+           TLM_STREAM_LINK_BYTES_PER_S * TLM_STREAM_BUDGET_PCT / 100u);
+    EXPECT(!TLM_stream_due(0));
+    EXPECT(stream_next(buf, sizeof(buf)) == 1);
+
+    /* Channel names */
+    EXPECT(TLM_stream_channels_from_string("q,rate,timing", &mask) == 0);
+    EXPECT(mask == (CH(q) | CH(rate) | CH(timing)));
+    EXPECT(TLM_stream_channels_from_string("q,rat", &mask) == 1);
+    EXPECT(TLM_stream_channels_from_string("q,,rate", &mask) == 1);
+    EXPECT(TLM_stream_channels_from_string("time,mode,q,rate,wheel,coil,"
+                                           "timing,isr",
+                                           &mask) == 0);
+    EXPECT(mask == TLM_CH_ALL);
+
+    /* Bandwidth accounting */
+    EXPECT(TLM_stream_frame_len(CH(q)) == TLM_stream_frame_len(0) + 16u);
+    EXPECT(TLM_stream_subscribe(0, TLM_CH_ALL, 100) == 1); /* over the link */
+    EXPECT(TLM_stream_subscribe(0, CH(q), 50) == 1);       /* too fast */
+    EXPECT(TLM_stream_subscribe(TLM_STREAM_SUB_CNT, CH(q), 1000) == 1);
+    EXPECT(TLM_stream_subscribe(0, 0x8000u, 1000) == 1);
+    EXPECT(TLM_stream_subscribe(0, TLM_CH_ALL, 200) == 0);
+    EXPECT(TLM_stream_subscribe(1, CH(q) | CH(rate), 100) == 1);
+    EXPECT(TLM_stream_subscribe(1, CH(q) | CH(rate), 300) == 0);
+    TLM_stream_get_status(&status);
+    EXPECT(status.load_bps <= status.cap_bps);
+    const uint16_t spare = status.cap_bps - status.load_bps;
+    TLM_stream_get_sub(1, &sub);
+    EXPECT(sub.frame_len == TLM_stream_frame_len(CH(q) | CH(rate)));
+    EXPECT(sub.load_bps == (sub.frame_len * 1000u + 299u) / 300u);
+    printf("budget : %u of %u B/s used, %u spare\n", status.load_bps,
+           status.cap_bps, spare);
+
+    /* The slowest subscription that still fits, then one too many */
+    const uint16_t time_len = TLM_stream_frame_len(CH(time));
+    const uint16_t fit_ms = (uint16_t)((time_len * 1000u + spare - 1) / spare);
+    EXPECT(TLM_stream_subscribe(2, CH(time), fit_ms - 1) == 1);
+    EXPECT(TLM_stream_subscribe(2, CH(time), fit_ms) == 0);
+    EXPECT(TLM_stream_subscribe(3, CH(mode), 60000) == 1);
+
+    /* Replacing a subscription only accounts for the difference */
+    EXPECT(TLM_stream_subscribe(0, TLM_CH_ALL, 200) == 0);
+    EXPECT(TLM_stream_subscribe(3, 0, 0) == 0);
+    EXPECT(TLM_stream_subscribe(2, 0, 0) == 0);
+    EXPECT(TLM_stream_subscribe(2, CH(time), fit_ms) == 0);
+    TLM_stream_get_status(&status);
+    EXPECT(status.load_bps <= status.cap_bps);
+
+    /* Frame packing */
+    TLM_record_t rec;
+    make_record(0x12345678u, &rec);
+    EXPECT(TLM_stream_due(0));
+    TLM_stream_sample(&rec, 0);
+    EXPECT(stream_next(buf, 20) == 1); /* too small, kept */
+    EXPECT(stream_next(buf, sizeof(buf)) == 0);
+    EXPECT(strcmp(buf, "{\"s\":0,\"n\":0,\"d\":\"78563412"
+                       "02"
+                       "004000c0004000c0"
+                       "00000c000000"
+                       "000000000000"
+                       "000000000000"
+                       "00000100"
+                       "00000000\"}") == 0);
+    EXPECT(strlen(buf) + 4u == TLM_stream_frame_len(TLM_CH_ALL) - 4u);
+    EXPECT(stream_next(buf, sizeof(buf)) == 0); /* subscription 1 */
+    EXPECT(strcmp(buf, "{\"s\":1,\"n\":0,\"d\":\"004000c0004000c0"
+                       "00000c000000\"}") == 0);
+    EXPECT(stream_next(buf, sizeof(buf)) == 0); /* subscription 2 */
+    EXPECT(stream_next(buf, sizeof(buf)) == 1);
+    EXPECT(!TLM_stream_due(1000));
+
+    /* Sustained rate over a 9600 baud link: every frame arrives, at the
+     * subscribed rate, and the line stays inside the budget. The ISR health
+     * goes with the slow housekeeping */
+    TLM_stream_init();
+    EXPECT(TLM_stream_subscribe(0, TLM_CH_ALL & ~CH(isr), 200) == 0);
+    EXPECT(TLM_stream_subscribe(1, CH(q) | CH(rate), 300) == 0);
+    EXPECT(TLM_stream_subscribe(2, CH(time) | CH(timing) | CH(isr), 2000) ==
+           0);
+    if (run_link(UART_EMU_BAUD, rx))
+    {
+        return 1;
+    }
+    UART_EMU_get_stats(&uart);
+    TLM_stream_get_status(&status);
+    const uint16_t period_ms[] = {200, 300, 2000};
+    uint32_t       frames      = 0;
+    for (i = 0; i < 3; i++)
+    {
+        const uint32_t expected = SIM_SECONDS * 1000u / period_ms[i];
+        TLM_stream_get_sub((uint8_t)i, &sub);
+        EXPECT(rx[i].frames >= expected - 1 && rx[i].frames <= expected);
+        EXPECT(rx[i].gaps == 0);
+        EXPECT(rx[i].max_len <= sub.frame_len);
+        frames += rx[i].frames;
+    }
+    const double fps  = (double)frames / SIM_SECONDS;
+    const double util = uart.busy_us / (SIM_SECONDS * 1.0e6);
+    printf("9600 baud : %.2f frames/s sustained, %.1f%% line use, %lu B/s, "
+           "%lu dropped\n",
+           fps, 100.0 * util, (unsigned long)(uart.bytes / SIM_SECONDS),
+           (unsigned long)status.dropped);
+    EXPECT(status.dropped == 0 && uart.dropped == 0);
+    EXPECT(status.frames == frames);
+    EXPECT(fps > 0.99 * SUBSCRIBED_FPS);
+    EXPECT(util <= TLM_STREAM_BUDGET_PCT / 100.0);
+    EXPECT(uart.bytes / SIM_SECONDS <= status.load_bps);
+
+    /* The same subscriptions over a link half as fast fall behind: frames
+     * are dropped, counted, and the OBC sees the gaps */
+    TLM_stream_init();
+    EXPECT(TLM_stream_subscribe(0, TLM_CH_ALL & ~CH(isr), 200) == 0);
+    EXPECT(TLM_stream_subscribe(1, CH(q) | CH(rate), 300) == 0);
+    EXPECT(TLM_stream_subscribe(2, CH(time) | CH(timing) | CH(isr), 2000) ==
+           0);
+    if (run_link(UART_EMU_BAUD / 2, rx))
+    {
+        return 1;
+    }
+    TLM_stream_get_status(&status);
+    uint32_t gaps = 0;
+    frames        = 0;
+    for (i = 0; i < 3; i++)
+    {
+        gaps += rx[i].gaps;
+        frames += rx[i].frames;
+    }
+    printf("4800 baud : %.2f frames/s sustained, %lu dropped\n",
+           (double)frames / SIM_SECONDS, (unsigned long)status.dropped);
+    EXPECT(status.dropped > 0);
+    EXPECT(gaps + 3 >= status.dropped && gaps <= status.dropped);
+
+    JW_t jw;
+    JW_init(&jw, buf, 100);
+    EXPECT(TLM_stream_status_to_json(&jw) == 0);
+    EXPECT(JW_finish(&jw) == 0);
+    EXPECT(strncmp(buf, "{\"subs\":[200,300,2000,0],", 25) == 0);
+    JW_init(&jw, buf, 20);
+    EXPECT(TLM_stream_status_to_json(&jw) == 1);
+
+    printf("PASS\n");
+    return 0;
+}
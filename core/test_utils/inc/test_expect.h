@@ -0,0 +1,48 @@
+/**
+ * @file test_expect.h
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief The check of the native tests
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ * @note A test is a mainline, EXPECT prints the first condition that does
+ * not hold and returns 1 from the function it is in.
+ */
+#if defined(__TEST_EXPECT_H__)
+#error PLEASE FIX YOUR INCLUDE TREE. TEST_EXPECT CAN ONLY BE INCLUDED ONCE PER TRANSLATION UNIT
+#endif /* #if defined(__TEST_EXPECT_H__) */
+
+
+#ifndef __TEST_EXPECT_H__
+#define __TEST_EXPECT_H__
+#ifdef __cplusplus
+/* clang-format off */
+extern "C"
+{
+/* clang-format on */
+#endif /* Start C linkage */
+
+#if defined(TARGET_MCU)
+#error NATIVE TESTS CANNOT BE RUN ON A BARE METAL MICROCONTROLLER
+#endif /* #if defined(TARGET_MCU) */
+
+#include <stdio.h>
+
+#define EXPECT(cond)                                                           \
+    do                                                                         \
+    {                                                                          \
+        if (!(cond))                                                           \
+        {                                                                      \
+            printf("FAIL %s:%d : %s\n", __FILE__, __LINE__, #cond);            \
+            return 1;                                                          \
+        }                                                                      \
+    } while (0)
+
+#ifdef __cplusplus
+/* clang-format off */
+}
+/* clang-format on */
+#endif /* End C linkage */
+#endif /* __TEST_EXPECT_H__ */
@@ -0,0 +1,131 @@
+/**
+ * @file timebase.h
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Millisecond time base with one-shot software timers
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ * @note On the target the tick comes from a TIMER_B0 compare interrupt and
+ * expired timer callbacks run in that interrupt. Natively there is no
+ * hardware tick: the clock is simulated and only advances when
+ * TIMEBASE_tick is called or when code waits on the time base, so waits
+ * are instantaneous and deterministic in native builds and tests.
+ */
+#ifndef __TIMEBASE_H__
+#define __TIMEBASE_H__
+#ifdef __cplusplus
+/* clang-format off */
+extern "C"
+{
+/* clang-format on */
+#endif /* Start C linkage */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Longest delay that can be compared with wrapping tick arithmetic */
+#define TIMEBASE_DELAY_MS_MAX (0x7FFFFFFFu)
+
+typedef void (*TIMEBASE_callback_func)(void *ctx);
+
+/**
+ * @brief One-shot software timer. Owned by the caller, must stay valid
+ * while it is armed. Do not touch the fields directly.
+ */
+typedef struct TIMEBASE_timer_s
+{
+    uint32_t                 expiry_ms;
+    TIMEBASE_callback_func   callback;
+    void *                   ctx;
+    struct TIMEBASE_timer_s *next;
+    volatile bool            armed;
+} TIMEBASE_timer_t;
+
+
+/**
+ * @brief Reset the tick count, disarm every timer and start the tick source
+ */
+void TIMEBASE_init(void);
+
+
+/**
+ * @brief Monotonic millisecond tick count since TIMEBASE_init.
+ *
+ * @note Wraps every 49 days so compare ticks with unsigned subtraction.
+ */
+uint32_t TIMEBASE_get_ms(void);
+
+
+/**
+ * @brief Advance the time base by one millisecond and run the callbacks of
+ * the timers that expire on this tick, in expiry order.
+ *
+ * @note Called from the tick interrupt on the target. Natively this is the
+ * simulated clock.
+ */
+void TIMEBASE_tick(void);
+
+
+/**
+ * @brief Arm a one-shot timer. Re-arming an armed timer restarts it.
+ *
+ * The timer expires on the delay_ms'th tick from now. Because the current
+ * tick period is already partly elapsed the real delay is between
+ * delay_ms - 1 and delay_ms milliseconds. A delay of 0 expires on the next
+ * tick.
+ *
+ * @param tmr timer to arm
+ * @param delay_ms ticks until expiry, at most TIMEBASE_DELAY_MS_MAX
+ * @param callback called (from interrupt context on the target) when the
+ * timer expires. May be NULL. May re-arm the timer.
+ * @param ctx passed to callback
+ * @return 0 on success, 1 if the delay is out of range
+ */
+int TIMEBASE_timer_start(TIMEBASE_timer_t *tmr, uint32_t delay_ms,
+                         TIMEBASE_callback_func callback, void *ctx);
+
+
+/**
+ * @brief Disarm a timer without running its callback
+ */
+void TIMEBASE_timer_cancel(TIMEBASE_timer_t *tmr);
+
+
+/**
+ * @brief Check if a timer is still waiting to expire
+ */
+bool TIMEBASE_timer_armed(const TIMEBASE_timer_t *tmr);
+
+
+/**
+ * @brief Sleep until an armed timer expires (or is cancelled).
+ *
+ * @note The CPU sleeps in LPM0 between ticks on the target. With interrupts
+ * masked the tick is serviced by polling instead.
+ */
+void TIMEBASE_timer_wait(TIMEBASE_timer_t *tmr);
+
+
+/**
+ * @brief Sleep for at least delay_ms milliseconds
+ */
+void TIMEBASE_delay_ms(uint32_t delay_ms);
+
+
+/**
+ * @brief Non-blocking timeout check
+ *
+ * @param start_ms tick count when the operation started
+ * @param timeout_ms allowed duration
+ * @return true once more than timeout_ms ticks have passed since start_ms
+ */
+bool TIMEBASE_timed_out(uint32_t start_ms, uint32_t timeout_ms);
+
+#ifdef __cplusplus
+/* clang-format off */
+}
+/* clang-format on */
+#endif /* End C linkage */
+#endif /* __TIMEBASE_H__ */
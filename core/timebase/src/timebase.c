@@ -0,0 +1,229 @@
+/**
+ * @file timebase.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Millisecond time base with one-shot software timers
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ * @note Armed timers are kept in a singly linked list sorted by expiry so a
+ * tick only has to look at the head of the list. Timers with the same
+ * expiry fire in the order they were armed.
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "targets.h"
+#include "config_assert.h"
+#include "timebase.h"
+#include "profiling.h"
+
+#if defined(TARGET_MCU)
+#include <msp430.h>
+
+#include "systick.h"
+
+/* Timer callbacks run in the tick interrupt */
+#define TIMEBASE_LOCK()                                                        \
+    uint16_t timebase_irq_state = __get_interrupt_state();                     \
+    __disable_interrupt()
+#define TIMEBASE_UNLOCK() __set_interrupt_state(timebase_irq_state)
+
+#else
+
+/* The simulated tick runs in the caller's context */
+#define TIMEBASE_LOCK()
+#define TIMEBASE_UNLOCK()
+
+#endif /* #if defined(TARGET_MCU) */
+
+
+static volatile uint32_t  timebase_ms;
+static TIMEBASE_timer_t * timebase_timers; /* sorted by expiry */
+
+
+static void TIMEBASE_unlink(TIMEBASE_timer_t *tmr);
+static void TIMEBASE_wait_for_tick(const TIMEBASE_timer_t *tmr);
+
+
+void TIMEBASE_init(void)
+{
+    TIMEBASE_LOCK();
+    while (NULL != timebase_timers)
+    {
+        timebase_timers->armed = false;
+        timebase_timers        = timebase_timers->next;
+    }
+    timebase_ms = 0;
+    TIMEBASE_UNLOCK();
+
+#if defined(TARGET_MCU)
+    SYSTICK_start_ms_tick(TIMEBASE_tick);
+#endif /* #if defined(TARGET_MCU) */
+}
+
+
+uint32_t TIMEBASE_get_ms(void)
+{
+    uint32_t ms;
+    TIMEBASE_LOCK(); /* 32 bit read is not atomic on a 16 bit core */
+    ms = timebase_ms;
+    TIMEBASE_UNLOCK();
+    return ms;
+}
+
+
+void TIMEBASE_tick(void)
+{
+    PROF_BEGIN(PROF_tick_isr);
+    timebase_ms++;
+    while (NULL != timebase_timers &&
+           (int32_t)(timebase_ms - timebase_timers->expiry_ms) >= 0)
+    {
+        TIMEBASE_timer_t *tmr = timebase_timers;
+        timebase_timers       = tmr->next;
+        tmr->next             = NULL;
+        tmr->armed            = false;
+        if (NULL != tmr->callback)
+        {
+            tmr->callback(tmr->ctx);
+        }
+    }
+    PROF_END(PROF_tick_isr);
+}
+
+
+int TIMEBASE_timer_start(TIMEBASE_timer_t *tmr, uint32_t delay_ms,
+                         TIMEBASE_callback_func callback, void *ctx)
+{
+    CONFIG_ASSERT(NULL != tmr);
+    if (delay_ms > TIMEBASE_DELAY_MS_MAX)
+    {
+        return 1;
+    }
+    if (delay_ms == 0)
+    {
+        delay_ms = 1;
+    }
+
+    TIMEBASE_LOCK();
+    if (tmr->armed)
+    {
+        TIMEBASE_unlink(tmr);
+    }
+
+    tmr->expiry_ms = timebase_ms + delay_ms;
+    tmr->callback  = callback;
+    tmr->ctx       = ctx;
+    tmr->armed     = true;
+
+    TIMEBASE_timer_t **link = &timebase_timers;
+    while (NULL != *link &&
+           (int32_t)((*link)->expiry_ms - tmr->expiry_ms) <= 0)
+    {
+        link = &(*link)->next;
+    }
+    tmr->next = *link;
+    *link     = tmr;
+    TIMEBASE_UNLOCK();
+    return 0;
+}
+
+
+void TIMEBASE_timer_cancel(TIMEBASE_timer_t *tmr)
+{
+    CONFIG_ASSERT(NULL != tmr);
+    TIMEBASE_LOCK();
+    if (tmr->armed)
+    {
+        TIMEBASE_unlink(tmr);
+        tmr->armed = false;
+    }
+    TIMEBASE_UNLOCK();
+}
+
+
+bool TIMEBASE_timer_armed(const TIMEBASE_timer_t *tmr)
+{
+    CONFIG_ASSERT(NULL != tmr);
+    return tmr->armed;
+}
+
+
+void TIMEBASE_timer_wait(TIMEBASE_timer_t *tmr)
+{
+    CONFIG_ASSERT(NULL != tmr);
+    while (tmr->armed)
+    {
+        TIMEBASE_wait_for_tick(tmr);
+    }
+}
+
+
+void TIMEBASE_delay_ms(uint32_t delay_ms)
+{
+    if (delay_ms == 0)
+    {
+        return;
+    }
+    if (delay_ms >= TIMEBASE_DELAY_MS_MAX)
+    {
+        delay_ms = TIMEBASE_DELAY_MS_MAX - 1;
+    }
+
+    /* One extra tick because the current tick period is partly elapsed */
+    TIMEBASE_timer_t tmr = {0};
+    TIMEBASE_timer_start(&tmr, delay_ms + 1, NULL, NULL);
+    TIMEBASE_timer_wait(&tmr);
+}
+
+
+bool TIMEBASE_timed_out(uint32_t start_ms, uint32_t timeout_ms)
+{
+    return (TIMEBASE_get_ms() - start_ms) > timeout_ms;
+}
+
+
+/* Caller holds the lock and tmr is armed */
+static void TIMEBASE_unlink(TIMEBASE_timer_t *tmr)
+{
+    TIMEBASE_timer_t **link = &timebase_timers;
+    while (NULL != *link && *link != tmr)
+    {
+        link = &(*link)->next;
+    }
+    if (NULL != *link)
+    {
+        *link = tmr->next;
+    }
+    tmr->next = NULL;
+}
+
+
+static void TIMEBASE_wait_for_tick(const TIMEBASE_timer_t *tmr)
+{
+#if defined(TARGET_MCU)
+    uint16_t state = __get_interrupt_state();
+    if (state & GIE)
+    {
+        /* Enabling interrupts and entering LPM0 is a single instruction so a
+         * tick that lands after the check still wakes the CPU */
+        __disable_interrupt();
+        if (tmr->armed)
+        {
+            __bis_SR_register(LPM0_bits | GIE);
+        }
+        __set_interrupt_state(state);
+    }
+    else
+    {
+        SYSTICK_service();
+    }
+#else
+    (void)tmr;
+    TIMEBASE_tick();
+#endif /* #if defined(TARGET_MCU) */
+}
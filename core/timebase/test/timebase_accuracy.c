@@ -0,0 +1,213 @@
+/**
+ * @file timebase_accuracy.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Test the expiry accuracy and ordering of the software timers
+ * against the simulated tick
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ */
+#if defined(TARGET_MCU)
+#error NATIVE TESTS CANNOT BE RUN ON A BARE METAL MICROCONTROLLER
+#endif /* #if defined(TARGET_MCU) */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "timebase.h"
+#include "test_expect.h"
+
+#define TIMER_CNT (64)
+#define PERIODIC_MS (7)
+#define PERIODIC_RUN_MS (100000u)
+#define US_PER_MS (1000u)
+
+typedef struct
+{
+    TIMEBASE_timer_t tmr;
+    uint32_t         expected_ms;
+    uint32_t         fired_ms;
+    unsigned int     fire_cnt;
+    unsigned int     order;
+} test_timer;
+
+static unsigned int fire_order;
+static uint32_t     sim_us; /* real time of the simulated hardware clock */
+
+
+static void record_fire(void *ctx)
+{
+    test_timer *t = (test_timer *)ctx;
+    t->fired_ms   = TIMEBASE_get_ms();
+    t->order      = fire_order++;
+    t->fire_cnt++;
+}
+
+
+static void record_fire_us(void *ctx)
+{
+    *(uint32_t *)ctx = sim_us;
+}
+
+
+static void rearm(void *ctx)
+{
+    test_timer *t = (test_timer *)ctx;
+    t->fire_cnt++;
+    t->fired_ms = TIMEBASE_get_ms();
+    TIMEBASE_timer_start(&t->tmr, PERIODIC_MS, rearm, t);
+}
+
+
+static void run_ticks(uint32_t ticks)
+{
+    while (ticks-- > 0)
+    {
+        TIMEBASE_tick();
+    }
+}
+
+
+int main(void)
+{
+    static test_timer timers[TIMER_CNT];
+    unsigned int      i;
+
+    TIMEBASE_init();
+    EXPECT(TIMEBASE_get_ms() == 0);
+
+    /* Timers armed at different ticks fire exactly on their expiry tick */
+    srand(1234);
+    memset(timers, 0, sizeof(timers));
+    for (i = 0; i < TIMER_CNT; i++)
+    {
+        uint32_t delay_ms     = (uint32_t)(rand() % 50);
+        uint32_t now          = TIMEBASE_get_ms();
+        timers[i].expected_ms = now + (delay_ms == 0 ? 1 : delay_ms);
+        EXPECT(TIMEBASE_timer_start(&timers[i].tmr, delay_ms, record_fire,
+                                    &timers[i]) == 0);
+        EXPECT(TIMEBASE_timer_armed(&timers[i].tmr));
+        if (i % 4 == 3)
+        {
+            TIMEBASE_tick();
+        }
+    }
+    run_ticks(100);
+    for (i = 0; i < TIMER_CNT; i++)
+    {
+        EXPECT(!TIMEBASE_timer_armed(&timers[i].tmr));
+        EXPECT(timers[i].fire_cnt == 1);
+        EXPECT(timers[i].fired_ms == timers[i].expected_ms);
+    }
+
+    /* Expiry order, timers with the same expiry fire in arming order */
+    unsigned int j;
+    for (i = 0; i < TIMER_CNT; i++)
+    {
+        for (j = 0; j < TIMER_CNT; j++)
+        {
+            if (timers[i].expected_ms < timers[j].expected_ms ||
+                (timers[i].expected_ms == timers[j].expected_ms && i < j))
+            {
+                EXPECT(timers[i].order < timers[j].order);
+            }
+        }
+    }
+
+    /* Cancel and restart */
+    memset(timers, 0, sizeof(timers));
+    uint32_t start = TIMEBASE_get_ms();
+    for (i = 0; i < 3; i++)
+    {
+        TIMEBASE_timer_start(&timers[i].tmr, 10, record_fire, &timers[i]);
+    }
+    TIMEBASE_timer_cancel(&timers[1].tmr);
+    TIMEBASE_timer_cancel(&timers[1].tmr); /* cancelling twice is harmless */
+    run_ticks(5);
+    TIMEBASE_timer_start(&timers[0].tmr, 10, record_fire, &timers[0]);
+    run_ticks(20);
+    EXPECT(timers[1].fire_cnt == 0);
+    EXPECT(timers[2].fire_cnt == 1 && timers[2].fired_ms == start + 10);
+    EXPECT(timers[0].fire_cnt == 1 && timers[0].fired_ms == start + 15);
+
+    /* A timer re-armed from its own callback does not drift */
+    memset(timers, 0, sizeof(timers));
+    start = TIMEBASE_get_ms();
+    TIMEBASE_timer_start(&timers[0].tmr, PERIODIC_MS, rearm, &timers[0]);
+    run_ticks(PERIODIC_RUN_MS);
+    EXPECT(timers[0].fire_cnt == PERIODIC_RUN_MS / PERIODIC_MS);
+    EXPECT(timers[0].fired_ms ==
+           start + (PERIODIC_RUN_MS / PERIODIC_MS) * PERIODIC_MS);
+    TIMEBASE_timer_cancel(&timers[0].tmr);
+    run_ticks(2 * PERIODIC_MS);
+    EXPECT(timers[0].fire_cnt == PERIODIC_RUN_MS / PERIODIC_MS);
+
+    /* Real delay of a timer armed part way through a tick period is between
+     * delay - 1 and delay milliseconds */
+    uint32_t delay_ms;
+    for (delay_ms = 1; delay_ms < 20; delay_ms++)
+    {
+        uint32_t phase_us;
+        for (phase_us = 0; phase_us < US_PER_MS; phase_us += 125)
+        {
+            TIMEBASE_timer_t tmr      = {0};
+            uint32_t         fired_us = 0;
+            uint32_t         start_us = sim_us + phase_us;
+            TIMEBASE_timer_start(&tmr, delay_ms, record_fire_us, &fired_us);
+            sim_us = start_us;
+            while (TIMEBASE_timer_armed(&tmr))
+            {
+                sim_us = (sim_us / US_PER_MS + 1) * US_PER_MS;
+                TIMEBASE_tick();
+            }
+            uint32_t elapsed_us = fired_us - start_us;
+            EXPECT(elapsed_us > (delay_ms - 1) * US_PER_MS);
+            EXPECT(elapsed_us <= delay_ms * US_PER_MS);
+        }
+    }
+
+    /* Blocking delays advance the simulated clock by at least the delay */
+    for (delay_ms = 0; delay_ms < 100; delay_ms += 9)
+    {
+        start = TIMEBASE_get_ms();
+        TIMEBASE_delay_ms(delay_ms);
+        uint32_t elapsed = TIMEBASE_get_ms() - start;
+        EXPECT(delay_ms == 0 ? elapsed == 0 : elapsed == delay_ms + 1);
+    }
+
+    /* Waiting on a timer returns on its expiry tick */
+    memset(timers, 0, sizeof(timers));
+    start = TIMEBASE_get_ms();
+    TIMEBASE_timer_start(&timers[0].tmr, 25, record_fire, &timers[0]);
+    TIMEBASE_timer_wait(&timers[0].tmr);
+    EXPECT(TIMEBASE_get_ms() == start + 25 && timers[0].fire_cnt == 1);
+    TIMEBASE_timer_wait(&timers[0].tmr); /* already expired */
+    EXPECT(TIMEBASE_get_ms() == start + 25);
+
+    /* Non-blocking timeout */
+    start = TIMEBASE_get_ms();
+    EXPECT(!TIMEBASE_timed_out(start, 3));
+    run_ticks(3);
+    EXPECT(!TIMEBASE_timed_out(start, 3));
+    TIMEBASE_tick();
+    EXPECT(TIMEBASE_timed_out(start, 3));
+
+    /* Out of range delay */
+    TIMEBASE_timer_t tmr = {0};
+    EXPECT(TIMEBASE_timer_start(&tmr, TIMEBASE_DELAY_MS_MAX + 1, NULL, NULL));
+    EXPECT(!TIMEBASE_timer_armed(&tmr));
+
+    /* Init disarms everything */
+    TIMEBASE_timer_start(&timers[0].tmr, 5, record_fire, &timers[0]);
+    TIMEBASE_init();
+    EXPECT(TIMEBASE_get_ms() == 0 && !TIMEBASE_timer_armed(&timers[0].tmr));
+    run_ticks(10);
+    EXPECT(timers[0].fire_cnt == 1);
+
+    printf("timebase ok\n");
+    return 0;
+}
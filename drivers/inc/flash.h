@@ -0,0 +1,79 @@
+#ifndef __FLASH_H__
+#define __FLASH_H__
+#ifdef __cplusplus
+/* clang-format off */
+extern "C"
+{
+/* clang-format on */
+#endif /* Start C linkage */
+
+#include <stdint.h>
+
+#include "flash_types.h"
+
+/**
+ * @brief Read only view of an information memory segment
+ *
+ * @return address of the first byte of the segment, NULL if seg is invalid
+ */
+const uint8_t *FLASH_info_segment(FLASH_INFO_t seg);
+
+
+/**
+ * @brief Erase an information memory segment (every byte reads 0xFF)
+ *
+ * @note Blocks for up to 32 ms with interrupts disabled. The watchdog is
+ * held for the duration of the erase.
+ *
+ * @return 0 on success, 1 if seg is invalid or locked
+ */
+int FLASH_info_erase(FLASH_INFO_t seg);
+
+
+/**
+ * @brief Program bytes into an erased area of an information memory segment
+ *
+ * @param seg segment to program
+ * @param offset byte offset of the first byte in the segment
+ * @param data bytes to program
+ * @param len number of bytes. offset + len must not exceed the segment
+ * @return 0 on success, 1 if the arguments are out of range or the
+ * programmed bytes do not read back
+ */
+int FLASH_info_write(FLASH_INFO_t seg, uint16_t offset, const void *data,
+                     uint16_t len);
+
+
+/**
+ * @brief Read only view of a segment of the telemetry log region
+ *
+ * @return address of the first byte of the segment, NULL if seg is invalid
+ */
+const uint8_t *FLASH_log_segment(uint16_t seg);
+
+
+/**
+ * @brief Erase a segment of the telemetry log region
+ *
+ * @note Same timing as FLASH_info_erase
+ *
+ * @return 0 on success, 1 if seg is invalid
+ */
+int FLASH_log_erase(uint16_t seg);
+
+
+/**
+ * @brief Program bytes into an erased area of a telemetry log segment
+ *
+ * @return 0 on success, 1 if the arguments are out of range or the
+ * programmed bytes do not read back
+ */
+int FLASH_log_write(uint16_t seg, uint16_t offset, const void *data,
+                    uint16_t len);
+
+#ifdef __cplusplus
+/* clang-format off */
+}
+/* clang-format on */
+#endif /* End C linkage */
+#endif /* __FLASH_H__ */
@@ -9,14 +9,75 @@ extern "C"
 
 #include <stdint.h>
 
+#include "i2c_types.h"
+
 void I2C0_init(void);
 int I2C0_write_bytes(uint8_t dev_addr, uint8_t *bytes, uint16_t byte_count);
 int  I2C0_read_bytes(uint8_t *caller_buf, uint16_t caller_buflen);
 
 
+/**
+ * @brief Configure UCB1 as a 7 bit addressed I2C master
+ */
 void I2C1_init(void);
-int I2C1_write_bytes(uint8_t dev_addr, uint8_t *bytes, uint16_t byte_count);
-int  I2C1_read_bytes(uint8_t *caller_buf, uint16_t caller_buflen);
+
+/**
+ * @brief Start a transaction without blocking. Completion is reported through
+ * the transaction callback (from interrupt context) and I2C1_poll.
+ *
+ * @param xfer transaction to start. Must stay valid until it completes
+ * @return 0 if the transaction was started, 1 if the bus is busy or the
+ * transaction is invalid
+ */
+int I2C1_submit(I2C_transaction_t *xfer);
+
+/**
+ * @brief Get the status of the most recent transaction.
+ *
+ * @note Aborts the transaction with I2C_STATUS_timeout if it has run longer
+ * than its timeout, so this must be called periodically while a transaction
+ * is pending.
+ */
+I2C_STATUS_t I2C1_poll(void);
+
+/**
+ * @brief Perform a transaction and block until it completes or times out.
+ *
+ * @note Safe to call before interrupts are globally enabled.
+ */
+I2C_STATUS_t I2C1_transfer(I2C_transaction_t *xfer);
+
+/**
+ * @brief Blocking write of byte_count bytes to dev_addr
+ *
+ * @return number of bytes written or -1 on error
+ */
+int I2C1_write_bytes(uint8_t dev_addr, const uint8_t *bytes, uint16_t byte_count);
+
+/**
+ * @brief Blocking read of caller_buflen bytes from dev_addr
+ *
+ * @return number of bytes read or -1 on error
+ */
+int I2C1_read_bytes(uint8_t dev_addr, uint8_t *caller_buf, uint16_t caller_buflen);
+
+typedef struct
+{
+    uint32_t stt_waits;      /* single byte reads that waited on the start */
+    uint32_t stt_timeouts;   /* waits that ran out, the stop was set anyway */
+    uint32_t stt_cycles_max; /* longest wait in SMCLK cycles */
+} I2C1_stats_t;
+
+/**
+ * @brief Take a copy of the counters of the single byte read waits
+ *
+ * @note A single byte read polls UCTXSTT until its address is sent, up to
+ * I2C1_STT_WAIT_SCL_PERIODS bus clock periods, possibly in the USCI_B1
+ * interrupt after the register address of a combined transaction.
+ */
+void I2C1_get_stats(I2C1_stats_t *stats);
+
+void I2C1_reset_stats(void);
 
 
 #ifdef __cplusplus
@@ -0,0 +1,73 @@
+#ifndef __SYSTICK_H__
+#define __SYSTICK_H__
+#ifdef __cplusplus
+/* clang-format off */
+extern "C"
+{
+/* clang-format on */
+#endif /* Start C linkage */
+
+#include <stdint.h>
+
+/**
+ * @brief Start the free running system timestamp on TIMER_B0.
+ *
+ * @note TIMER_B0 runs in continuous mode from SMCLK and is shared with the
+ * reaction wheel PWM and tachometer captures. This only enables the overflow
+ * interrupt and never changes the counter configuration if it is already
+ * running.
+ */
+void SYSTICK_init(void);
+
+
+/**
+ * @brief Read the number of SMCLK cycles since SYSTICK_init
+ */
+uint64_t SYSTICK_get_cycles(void);
+
+
+/**
+ * @brief Read the number of microseconds since SYSTICK_init
+ *
+ * @return timestamp in microseconds. Wraps every 71 minutes so compare
+ * timestamps with unsigned subtraction.
+ */
+uint32_t SYSTICK_get_us(void);
+
+
+/**
+ * @brief Call tick once every millisecond from the TIMER_B0 interrupt.
+ *
+ * @param tick called in interrupt context. The CPU is woken from LPM0 after
+ * every tick so code sleeping on a deadline can re-check it.
+ *
+ * @note Uses capture compare channel 3. The compare register is advanced by
+ * a whole number of SMCLK cycles each tick so the period does not drift.
+ */
+void SYSTICK_start_ms_tick(void (*tick)(void));
+
+
+/**
+ * @brief Service pending TIMER_B0 overflow and millisecond tick flags by hand.
+ *
+ * @note For code that has to wait with interrupts masked (e.g. during init
+ * before the global interrupt enable). Does nothing if no flag is pending.
+ */
+void SYSTICK_service(void);
+
+
+/**
+ * @brief Call capture from the TIMER_B0 interrupt for every edge captured by
+ * a channel with its interrupt enabled (the reaction wheel tachometers).
+ * @param capture called in interrupt context with the channel and the
+ * captured count extended with the overflow count, NULL to stop the calls.
+ * @note Channel 3 is the millisecond tick and is never given to capture.
+ */
+void SYSTICK_on_capture(void (*capture)(uint8_t ccr, uint32_t counts));
+
+#ifdef __cplusplus
+/* clang-format off */
+}
+/* clang-format on */
+#endif /* End C linkage */
+#endif /* __SYSTICK_H__ */
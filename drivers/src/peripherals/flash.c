@@ -0,0 +1,169 @@
+/**
+ * @file flash.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Information memory and telemetry log erase and program routines for
+ * the msp430f5529 flash controller
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ * @note See section 7.3 of slau208q. The routines execute from main flash:
+ * the CPU is held by the flash controller until each erase or byte program
+ * completes, so BUSY is only polled for form.
+ *
+ * The telemetry log region is reserved by an erased, segment aligned const
+ * array so the linker places it in main flash next to the code without a
+ * custom linker script. It is only ever read through FLASH_log_segment
+ * from other translation units, so the compiler cannot fold the reads into
+ * the 0xFF initialiser.
+ */
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#if !defined(TARGET_MCU)
+#error DRIVER COMPILATION SHOULD ONLY OCCUR ON CROSSCOMPILED TARGETS
+#endif /* !defined(TARGET_MCU) */
+
+#include <msp430.h>
+
+#include "targets.h"
+#include "flash.h"
+
+#define FLASH_INFO_BASE_ADDR (0x1800u)
+
+#define FLASH_LOCK()                                                           \
+    uint16_t flash_irq_state = __get_interrupt_state();                        \
+    __disable_interrupt();                                                     \
+    uint16_t flash_wdt_state = WDTCTL & 0x00FFu;                               \
+    WDTCTL                   = WDTPW | WDTHOLD | flash_wdt_state;              \
+    FCTL3                    = FWKEY
+#define FLASH_UNLOCK()                                                         \
+    FCTL1  = FWKEY;                                                            \
+    FCTL3  = FWKEY | LOCK;                                                     \
+    WDTCTL = WDTPW | WDTCNTCL | flash_wdt_state;                               \
+    __set_interrupt_state(flash_irq_state)
+
+
+/* clang-format off */
+static const uint8_t flash_log[FLASH_LOG_SEGMENT_CNT][FLASH_LOG_SEGMENT_SIZE]
+    __attribute__((used, aligned(FLASH_LOG_SEGMENT_SIZE))) = {
+    [0 ... FLASH_LOG_SEGMENT_CNT - 1] = {
+        [0 ... FLASH_LOG_SEGMENT_SIZE - 1] = FLASH_ERASED_BYTE
+    }
+};
+/* clang-format on */
+
+
+static uint8_t *FLASH_info_addr(FLASH_INFO_t seg);
+static int      FLASH_erase_segment(uint8_t *addr);
+static int      FLASH_program(uint8_t *addr, const uint8_t *src, uint16_t len);
+
+
+const uint8_t *FLASH_info_segment(FLASH_INFO_t seg)
+{
+    return FLASH_info_addr(seg);
+}
+
+
+int FLASH_info_erase(FLASH_INFO_t seg)
+{
+    uint8_t *addr = FLASH_info_addr(seg);
+    if (NULL == addr || seg == FLASH_INFO_A)
+    {
+        return 1;
+    }
+
+    return FLASH_erase_segment(addr);
+}
+
+
+int FLASH_info_write(FLASH_INFO_t seg, uint16_t offset, const void *data,
+                     uint16_t len)
+{
+    uint8_t *addr = FLASH_info_addr(seg);
+    if (NULL == addr || seg == FLASH_INFO_A || NULL == data ||
+        offset > FLASH_INFO_SEGMENT_SIZE ||
+        len > FLASH_INFO_SEGMENT_SIZE - offset)
+    {
+        return 1;
+    }
+
+    return FLASH_program(&addr[offset], (const uint8_t *)data, len);
+}
+
+
+const uint8_t *FLASH_log_segment(uint16_t seg)
+{
+    if (seg >= FLASH_LOG_SEGMENT_CNT)
+    {
+        return NULL;
+    }
+    return flash_log[seg];
+}
+
+
+int FLASH_log_erase(uint16_t seg)
+{
+    if (seg >= FLASH_LOG_SEGMENT_CNT)
+    {
+        return 1;
+    }
+    return FLASH_erase_segment((uint8_t *)flash_log[seg]);
+}
+
+
+int FLASH_log_write(uint16_t seg, uint16_t offset, const void *data,
+                    uint16_t len)
+{
+    if (seg >= FLASH_LOG_SEGMENT_CNT || NULL == data ||
+        offset > FLASH_LOG_SEGMENT_SIZE ||
+        len > FLASH_LOG_SEGMENT_SIZE - offset)
+    {
+        return 1;
+    }
+    return FLASH_program((uint8_t *)&flash_log[seg][offset],
+                         (const uint8_t *)data, len);
+}
+
+
+static uint8_t *FLASH_info_addr(FLASH_INFO_t seg)
+{
+    if (seg >= FLASH_INFO_CNT)
+    {
+        return NULL;
+    }
+    return (uint8_t *)(uintptr_t)(FLASH_INFO_BASE_ADDR +
+                                  seg * FLASH_INFO_SEGMENT_SIZE);
+}
+
+
+static int FLASH_erase_segment(uint8_t *addr)
+{
+    FLASH_LOCK();
+    FCTL1 = FWKEY | ERASE;
+    *addr = 0; /* dummy write starts the segment erase */
+    while (FCTL3 & BUSY)
+    {
+    }
+    FLASH_UNLOCK();
+    return 0;
+}
+
+
+static int FLASH_program(uint8_t *addr, const uint8_t *src, uint16_t len)
+{
+    uint16_t i;
+    FLASH_LOCK();
+    FCTL1 = FWKEY | WRT;
+    for (i = 0; i < len; i++)
+    {
+        addr[i] = src[i];
+        while (FCTL3 & BUSY)
+        {
+        }
+    }
+    FLASH_UNLOCK();
+    return (memcmp(addr, src, len) == 0) ? 0 : 1;
+}
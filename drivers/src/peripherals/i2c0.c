@@ -21,6 +21,7 @@
 #include <msp430.h>
 
 #include "i2c.h"
+#include "isr_monitor.h"
 
 static volatile uint8_t  I2C0_i2c_txbuf[32];
 static volatile uint8_t *I2C0_i2c_txbuf_ptr;
@@ -130,6 +131,7 @@ static void I2C0_PHY_init(void)
 
 __interrupt_vec(USCI_B0_VECTOR) void USCI_I2C_ISR(void)
 {
+    ISR_MON_enter_unknown_latency(ISR_MON_usci_b0, ISR_MON_NOW());
     switch (__even_in_range(UCB0IV, 12))
     {
         case 0:
@@ -167,4 +169,5 @@ __interrupt_vec(USCI_B0_VECTOR) void USCI_I2C_ISR(void)
         default:
             break;
     }
+    ISR_MON_exit(ISR_MON_usci_b0, ISR_MON_NOW());
 }
\ No newline at end of file
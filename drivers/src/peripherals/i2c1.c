@@ -2,11 +2,15 @@
  * @file i2c.c
  * @author Carl Mattatall (cmattatall2@gmail.com)
  * @brief Source module to implement an i2c driver using UCB1 for msp430f5529
- * @version 0.1
- * @date 2021-02-22
+ * @version 0.2
+ * @date 2026-10-19
  *
  * @copyright Copyright (c) 2021 Carl Mattatall
  *
+ * @note Transactions are driven by the USCI_B1 interrupt. A transaction
+ * writes its tx bytes, then (if it has any rx bytes) issues a repeated start
+ * and reads them back before the stop condition. See section 38.3.4.2 of
+ * slau208q for the master transmitter/receiver sequences.
  */
 #if !defined(TARGET_MCU)
 #error DRIVER COMPILATION SHOULD ONLY OCCUR ON CROSSCOMPILED TARGETS
@@ -14,154 +18,369 @@
 
 #include <string.h>
 #include <stdlib.h>
+#include <stdbool.h>
 
 #include <msp430.h>
 
 #include "i2c.h"
+#include "clocks.h"
+#include "systick.h"
+#include "isr_monitor.h"
 
-static volatile uint8_t  I2C1_i2c_txbuf[32];
-static volatile uint8_t *I2C1_i2c_txbuf_ptr;
-static volatile uint16_t I2C1_i2c_txcnt;
+#define I2C1_SCL_FREQ (100000u)
+#define I2C1_CLK_PRESCALER ((SMCLK_FREQ) / (I2C1_SCL_FREQ))
 
-static volatile uint8_t  I2C1_i2c_rxbuf[32];
-static volatile uint8_t *I2C1_i2c_rxbuf_inptr;
-static volatile uint8_t *I2C1_i2c_rxbuf_outptr;
+/* Upper bound on busy waiting for the address byte of a single byte read:
+ * start, 7 address bits, R/W and the acknowledge take 10 bus clock periods,
+ * twice that allows for a slave stretching the clock */
+#define I2C1_STT_WAIT_SCL_PERIODS (20u)
+#define I2C1_STT_WAIT_CYCLES_MAX                                               \
+    ((uint32_t)I2C1_STT_WAIT_SCL_PERIODS * (I2C1_CLK_PRESCALER))
+
+static I2C_transaction_t *volatile I2C1_xfer;
+static volatile I2C_STATUS_t       I2C1_status = I2C_STATUS_ok;
+static volatile uint16_t           I2C1_txidx;
+static volatile uint16_t           I2C1_rxidx;
+static uint32_t                    I2C1_start_us;
+static I2C1_stats_t                I2C1_stats;
 
 static void I2C1_PHY_init(void);
+static void I2C1_configure(void);
+static bool I2C1_xfer_is_valid(const I2C_transaction_t *xfer);
+static void I2C1_start_read(void);
+static void I2C1_complete(I2C_STATUS_t status);
+static void I2C1_service(void);
 
 
 void I2C1_init(void)
 {
     I2C1_PHY_init();
+    I2C1_configure();
+    I2C1_xfer   = NULL;
+    I2C1_status = I2C_STATUS_ok;
+    I2C1_reset_stats();
+}
 
-    UCB1CTL1 |= UCSWRST; /* unlock peripheral to modify config */
 
-    /** @todo IMPLEMENT REGISTER LEVEL CONFIGURATION STUFF*/
-#warning TODO: IMPLEMENT REGISTER LEVEL CONFIGURATION FOR I2C1
+void I2C1_get_stats(I2C1_stats_t *stats)
+{
+    uint16_t state = __get_interrupt_state();
+    __disable_interrupt();
+    *stats = I2C1_stats;
+    __set_interrupt_state(state);
+}
 
-    UCB1CTL1 &= ~UCSWRST;
+
+void I2C1_reset_stats(void)
+{
+    uint16_t state = __get_interrupt_state();
+    __disable_interrupt();
+    memset(&I2C1_stats, 0, sizeof(I2C1_stats));
+    __set_interrupt_state(state);
 }
 
-int I2C1_write_bytes(uint8_t dev_addr, uint8_t *bytes, uint16_t byte_count)
+
+int I2C1_submit(I2C_transaction_t *xfer)
 {
-    int retval = 0;
-    if (bytes != NULL)
+    if (!I2C1_xfer_is_valid(xfer))
+    {
+        return 1;
+    }
+
+    /* Previous stop still pending or another master owns the bus */
+    if (I2C1_status == I2C_STATUS_busy || (UCB1CTL1 & UCTXSTP) ||
+        (UCB1STAT & UCBBUSY))
+    {
+        return 1;
+    }
+
+    if (xfer->timeout_us == 0)
+    {
+        xfer->timeout_us = I2C_TIMEOUT_US_DEFAULT;
+    }
+
+    I2C1_xfer     = xfer;
+    I2C1_txidx    = 0;
+    I2C1_rxidx    = 0;
+    I2C1_status   = I2C_STATUS_busy;
+    I2C1_start_us = SYSTICK_get_us();
+
+    UCB1I2CSA = xfer->dev_addr;
+    UCB1IFG &= ~(UCTXIFG | UCRXIFG | UCNACKIFG | UCALIFG);
+    if (xfer->txlen > 0)
+    {
+        UCB1CTL1 |= UCTR | UCTXSTT;
+    }
+    else
     {
-        /* First byte in transmit buffer is device address */
-        I2C1_i2c_txbuf_ptr  = I2C1_i2c_txbuf;
-        *I2C1_i2c_txbuf_ptr = dev_addr;
-        I2C1_i2c_txbuf_ptr++;
+        I2C1_start_read();
+    }
+    return 0;
+}
 
-        /* Rest of data comes next */
-        unsigned int bcnt = sizeof(dev_addr) + byte_count;
 
-        /* subtract 1 bc first byte is dev address */
-        if (bcnt > sizeof(I2C1_i2c_txbuf))
+I2C_STATUS_t I2C1_poll(void)
+{
+    if (I2C1_status == I2C_STATUS_busy)
+    {
+        /* Before interrupts are enabled (during init) the flags are serviced
+         * by polling */
+        if (!(__get_SR_register() & GIE))
         {
-            retval = -1;
+            I2C1_service();
         }
-        else
+
+        uint16_t state = __get_interrupt_state();
+        __disable_interrupt();
+        if (I2C1_status == I2C_STATUS_busy)
         {
-            strncpy((char *)I2C1_i2c_txbuf_ptr, (char *)bytes, bcnt);
+            if (SYSTICK_get_us() - I2C1_start_us > I2C1_xfer->timeout_us)
+            {
+                /* Software reset releases the bus and clears UCB1IE */
+                I2C1_configure();
+                I2C1_complete(I2C_STATUS_timeout);
+            }
+        }
+        __set_interrupt_state(state);
+    }
+    return I2C1_status;
+}
+
+
+I2C_STATUS_t I2C1_transfer(I2C_transaction_t *xfer)
+{
+    if (!I2C1_xfer_is_valid(xfer))
+    {
+        return I2C_STATUS_invalid;
+    }
 
-            I2C1_i2c_txcnt = bcnt;
+    if (I2C1_submit(xfer))
+    {
+        return I2C_STATUS_busy;
+    }
 
-            /** @todo IMPLEMENT THE STUFF THAT ACTUALLY TRANSMITS, CALLER DATA
-             * IS JUST LOADED RIGHT NOW*/
-#warning TODO: NOT FULLY IMPLEMENTED YET
+    I2C_STATUS_t status;
+    do
+    {
+        status = I2C1_poll();
+    } while (status == I2C_STATUS_busy);
+    return status;
+}
 
 
-            retval = bcnt;
-        }
+int I2C1_write_bytes(uint8_t dev_addr, const uint8_t *bytes, uint16_t byte_count)
+{
+    I2C_transaction_t xfer;
+    memset(&xfer, 0, sizeof(xfer));
+    xfer.dev_addr = dev_addr;
+    xfer.tx       = bytes;
+    xfer.txlen    = byte_count;
+    if (I2C1_transfer(&xfer) != I2C_STATUS_ok)
+    {
+        return -1;
     }
-    else
+    return byte_count;
+}
+
+
+int I2C1_read_bytes(uint8_t dev_addr, uint8_t *caller_buf, uint16_t caller_buflen)
+{
+    I2C_transaction_t xfer;
+    memset(&xfer, 0, sizeof(xfer));
+    xfer.dev_addr = dev_addr;
+    xfer.rx       = caller_buf;
+    xfer.rxlen    = caller_buflen;
+    if (I2C1_transfer(&xfer) != I2C_STATUS_ok)
     {
-        retval = 0;
+        return -1;
     }
-    return retval;
+    return caller_buflen;
+}
+
+
+static void I2C1_PHY_init(void)
+{
+    P4SEL |= BIT2; /* P4.2 == scl */
+    P4SEL |= BIT1; /* P4.1 == sda */
 }
 
 
-int I2C1_read_bytes(uint8_t *caller_buf, uint16_t caller_buflen)
+static void I2C1_configure(void)
 {
-    if (caller_buf == NULL)
+    UCB1CTL1 |= UCSWRST; /* unlock peripheral to modify config */
+
+    UCB1CTL0 = UCMST | UCMODE_3 | UCSYNC; /* 7 bit addr, single master, I2C */
+    UCB1CTL1 = UCSSEL__SMCLK | UCSWRST;
+    UCB1BR0  = (uint8_t)(I2C1_CLK_PRESCALER & 0xFF);
+    UCB1BR1  = (uint8_t)((I2C1_CLK_PRESCALER >> 8) & 0xFF);
+
+    UCB1CTL1 &= ~UCSWRST;
+
+    /* Interrupt enables are cleared by UCSWRST so they must come last */
+    UCB1IE |= UCNACKIE | UCALIE | UCRXIE | UCTXIE;
+}
+
+
+static bool I2C1_xfer_is_valid(const I2C_transaction_t *xfer)
+{
+    if (xfer == NULL)
     {
-        return 0;
+        return false;
     }
-    else
+    if (xfer->txlen == 0 && xfer->rxlen == 0)
     {
-        unsigned int bcnt = 0;
-        while (I2C1_i2c_rxbuf_outptr != I2C1_i2c_rxbuf_inptr)
-        {
-            caller_buf[bcnt] = *I2C1_i2c_rxbuf_outptr;
-            I2C1_i2c_rxbuf_outptr++;
-            if (I2C1_i2c_rxbuf_outptr > I2C1_i2c_rxbuf + sizeof(I2C1_i2c_rxbuf))
-            {
-                I2C1_i2c_rxbuf_outptr = I2C1_i2c_rxbuf_outptr;
-            }
-            ++bcnt;
+        return false;
+    }
+    if ((xfer->txlen > 0 && xfer->tx == NULL) ||
+        (xfer->rxlen > 0 && xfer->rx == NULL))
+    {
+        return false;
+    }
+    return true;
+}
 
-            /* Data overrun condition */
-            if (bcnt > sizeof(I2C1_i2c_rxbuf))
-            {
-                bcnt = -1;
-                break;
-            }
 
-            if (bcnt == caller_buflen)
-            {
-                break;
-            }
+static void I2C1_start_read(void)
+{
+    UCB1CTL1 &= ~UCTR;
+    UCB1CTL1 |= UCTXSTT; /* (repeated) start in receiver mode */
+
+    /* For a single byte the stop has to be requested as soon as the address
+     * has been sent, otherwise a second byte is clocked in. There is no
+     * interrupt for that in master mode, UCTXSTT is polled as slau208q
+     * 38.3.4.2.2 describes, for a bounded number of bus clock periods */
+    if (I2C1_xfer->rxlen == 1)
+    {
+        const uint64_t start  = SYSTICK_get_cycles();
+        uint32_t       cycles = 0;
+        while ((UCB1CTL1 & UCTXSTT) && cycles < I2C1_STT_WAIT_CYCLES_MAX)
+        {
+            cycles = (uint32_t)(SYSTICK_get_cycles() - start);
+        }
+        UCB1CTL1 |= UCTXSTP;
+
+        I2C1_stats.stt_waits++;
+        if (cycles >= I2C1_STT_WAIT_CYCLES_MAX)
+        {
+            I2C1_stats.stt_timeouts++;
+        }
+        if (cycles > I2C1_stats.stt_cycles_max)
+        {
+            I2C1_stats.stt_cycles_max = cycles;
         }
-        return bcnt;
     }
 }
 
 
-static void I2C1_PHY_init(void)
+static void I2C1_complete(I2C_STATUS_t status)
 {
-    P4SEL |= BIT2; /* P4.2 == scl */
-    P4SEL |= BIT1; /* P4.1 == sda */
+    I2C_transaction_t *xfer = I2C1_xfer;
+    I2C1_xfer               = NULL;
+    I2C1_status             = status;
+    if (xfer != NULL && xfer->callback != NULL)
+    {
+        xfer->callback(status, xfer->ctx);
+    }
 }
 
 
-__interrupt_vec(USCI_B1_VECTOR) void USCI_I2C_ISR(void)
+static void I2C1_service(void)
 {
     switch (__even_in_range(UCB1IV, 12))
     {
-        case 0:
-            break; // Vector  0: No interrupts
-        case 2:
-            break; // Vector  2: ALIFG
-        case 4:
-            break; // Vector  4: NACKIFG
-        case 6:
-            break; // Vector  6: STTIFG
-        case 8:
-            break; // Vector  8: STPIFG
-        case 10:
+        case 0: /* Vector  0: No interrupts */
         {
-/** @todo IMPLEMENT THIS STUFF */
-#warning RECEIVE ISR HANDLING NOT IMPLEMENTED FOR I2C1
         }
-        break;   // Vector 10: RXIFG
-        case 12: // Vector 12: TXIFG
+        break;
+        case 2: /* Vector  2: ALIFG */
         {
-            if (I2C1_i2c_txcnt)
+            /* Losing arbitration drops us into slave mode */
+            UCB1CTL0 |= UCMST;
+            if (I2C1_xfer != NULL)
             {
-                UCB1TXBUF = *I2C1_i2c_txbuf_ptr;
-                I2C1_i2c_txbuf_ptr++; /* advance data ptr */
-                I2C1_i2c_txcnt--;     // Decrement TX byte counter
+                I2C1_complete(I2C_STATUS_arbitration_lost);
+            }
+        }
+        break;
+        case 4: /* Vector  4: NACKIFG */
+        {
+            UCB1CTL1 |= UCTXSTP;
+            UCB1IFG &= ~UCTXIFG;
+            if (I2C1_xfer != NULL)
+            {
+                I2C1_complete(I2C_STATUS_nack);
+            }
+        }
+        break;
+        case 6: /* Vector  6: STTIFG (slave only) */
+        {
+        }
+        break;
+        case 8: /* Vector  8: STPIFG (slave only) */
+        {
+        }
+        break;
+        case 10: /* Vector 10: RXIFG */
+        {
+            if (I2C1_xfer == NULL)
+            {
+                (void)UCB1RXBUF; /* discard, clears the flag */
+                break;
+            }
+
+            I2C1_xfer->rx[I2C1_rxidx] = UCB1RXBUF;
+            I2C1_rxidx++;
+
+            /* Request the stop while the last byte is being clocked in */
+            if (I2C1_rxidx == I2C1_xfer->rxlen - 1)
+            {
+                UCB1CTL1 |= UCTXSTP;
+            }
+            else if (I2C1_rxidx >= I2C1_xfer->rxlen)
+            {
+                I2C1_complete(I2C_STATUS_ok);
+            }
+        }
+        break;
+        case 12: /* Vector 12: TXIFG */
+        {
+            if (I2C1_xfer == NULL)
+            {
+                UCB1IFG &= ~UCTXIFG;
+                break;
+            }
+
+            if (I2C1_txidx < I2C1_xfer->txlen)
+            {
+                UCB1TXBUF = I2C1_xfer->tx[I2C1_txidx];
+                I2C1_txidx++;
+            }
+            else if (I2C1_xfer->rxlen > 0)
+            {
+                UCB1IFG &= ~UCTXIFG;
+                I2C1_start_read();
             }
             else
             {
-                UCB1CTL1 |= UCTXSTP; // I2C stop condition
-                UCB1IFG &= ~UCTXIFG; // Clear USCI_B0 TX int flag
-                __no_operation();    /* NOP to fix silicon errata with ISR */
+                UCB1CTL1 |= UCTXSTP; /* I2C stop condition */
+                UCB1IFG &= ~UCTXIFG;
+                I2C1_complete(I2C_STATUS_ok);
             }
         }
         break;
         default:
-            break;
+        {
+        }
+        break;
     }
 }
+
+
+/* Named distinctly from the UCB0 handler in i2c0.c so both can link */
+__interrupt_vec(USCI_B1_VECTOR) void USCI_B1_I2C_ISR(void)
+{
+    ISR_MON_enter_unknown_latency(ISR_MON_imu_i2c, ISR_MON_NOW());
+    I2C1_service();
+    ISR_MON_exit(ISR_MON_imu_i2c, ISR_MON_NOW());
+    __no_operation(); /* NOP to fix silicon errata with ISR */
+}
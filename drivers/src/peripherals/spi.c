@@ -21,6 +21,7 @@
 
 #include <msp430.h>
 #include "spi.h"
+#include "isr_monitor.h"
 
 #define UCB0IVNOP (0x00)
 #define UCB0IVRX (0x02)
@@ -186,6 +187,7 @@ int SPI0_transmit(const uint8_t *bytes, uint16_t len)
 
 __interrupt_vec(USCI_B0_VECTOR) void USCI_B0_VECTOR_ISR(void)
 {
+    ISR_MON_enter_unknown_latency(ISR_MON_usci_b0, ISR_MON_NOW());
     if ((UCB0IV & UCB0IVRX) == UCB0IVRX)
     {
         /* always read reg to prevent overrun error */
@@ -195,6 +197,7 @@ __interrupt_vec(USCI_B0_VECTOR) void USCI_B0_VECTOR_ISR(void)
             SPI0_rx_callback(received_byte);
         }
     }
+    ISR_MON_exit(ISR_MON_usci_b0, ISR_MON_NOW());
 }
 
 
@@ -0,0 +1,198 @@
+/**
+ * @file systick.c
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Free running system timestamp built on the TIMER_B0 counter
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ * @note The 16 bit TB0R counter is extended in software by counting
+ * overflows (TBIFG) so the timestamp never wraps in the lifetime of the
+ * mission.
+ */
+#include <stdint.h>
+#include <stddef.h>
+
+#if !defined(TARGET_MCU)
+#error DRIVER COMPILATION SHOULD ONLY OCCUR ON CROSSCOMPILED TARGETS
+#endif /* !defined(TARGET_MCU) */
+
+#include <msp430.h>
+
+#include "targets.h"
+#include "systick.h"
+#include "clocks.h"
+#include "isr_monitor.h"
+
+#define TB0IV_NONE (0x00)     /* See table 18-7 of slau208q */
+#define TB0IV_CCR3 (0x06)     /* See table 18-7 of slau208q */
+#define TB0IV_OVERFLOW (0x0E) /* See table 18-7 of slau208q */
+
+#define SYSTICK_CYCLES_PER_MS ((uint16_t)((SMCLK_FREQ) / 1000u))
+
+#if ((SMCLK_FREQ) % 1000u) != 0
+#warning SMCLK IS NOT A WHOLE NUMBER OF kHz, THE MILLISECOND TICK WILL DRIFT
+#endif /* SMCLK_FREQ is not a multiple of 1 kHz */
+
+static volatile uint32_t systick_overflows;
+static void (*systick_ms_tick)(void);
+static void (*systick_capture)(uint8_t ccr, uint32_t counts);
+
+static void SYSTICK_ms_tick_handler(void);
+
+
+void SYSTICK_init(void)
+{
+    if ((TB0CTL & (MC0 | MC1)) == MC__STOP)
+    {
+        TB0CTL &= ~(TBSSEL0 | TBSSEL1);
+        TB0CTL |= TBSSEL__SMCLK;
+        TB0CTL |= MC__CONTINOUS;
+    }
+    systick_overflows = 0;
+    TB0CTL &= ~TBIFG;
+    TB0CTL |= TBIE;
+}
+
+
+uint64_t SYSTICK_get_cycles(void)
+{
+    uint16_t state = __get_interrupt_state();
+    __disable_interrupt();
+
+    uint32_t hi = systick_overflows;
+    uint16_t lo = TB0R;
+
+    /* Overflow happened after interrupts were masked but before (or while)
+     * the counter was read. The ISR has not counted it yet */
+    if ((TB0CTL & TBIFG) && lo < 0x8000u)
+    {
+        hi++;
+    }
+
+    __set_interrupt_state(state);
+    return ((uint64_t)hi << 16) | lo;
+}
+
+
+uint32_t SYSTICK_get_us(void)
+{
+    return (uint32_t)((SYSTICK_get_cycles() * 1000000u) / SMCLK_FREQ);
+}
+
+
+void SYSTICK_start_ms_tick(void (*tick)(void))
+{
+    uint16_t state = __get_interrupt_state();
+    __disable_interrupt();
+
+    systick_ms_tick = tick;
+    TB0CCTL3        = 0; /* compare mode, no output */
+    TB0CCR3         = TB0R + SYSTICK_CYCLES_PER_MS;
+    TB0CCTL3 |= CCIE;
+
+    __set_interrupt_state(state);
+}
+
+
+void SYSTICK_service(void)
+{
+    uint16_t state = __get_interrupt_state();
+    __disable_interrupt();
+
+    if (TB0CTL & TBIFG)
+    {
+        TB0CTL &= ~TBIFG;
+        systick_overflows++;
+    }
+
+    if ((TB0CCTL3 & CCIE) && (TB0CCTL3 & CCIFG))
+    {
+        TB0CCTL3 &= ~CCIFG;
+        SYSTICK_ms_tick_handler();
+    }
+
+    __set_interrupt_state(state);
+}
+
+
+void SYSTICK_on_capture(void (*capture)(uint8_t ccr, uint32_t counts))
+{
+    uint16_t state = __get_interrupt_state();
+    __disable_interrupt();
+    systick_capture = capture;
+    __set_interrupt_state(state);
+}
+
+
+static void SYSTICK_ms_tick_handler(void)
+{
+    /* If the tick was serviced more than a period late the next compare value
+     * is already behind the counter and would only match after TB0R wraps.
+     * Deliver the missed ticks now instead */
+    do
+    {
+        TB0CCR3 += SYSTICK_CYCLES_PER_MS;
+        if (NULL != systick_ms_tick)
+        {
+            systick_ms_tick();
+        }
+    } while ((int16_t)(TB0CCR3 - TB0R) < 0);
+}
+
+
+__interrupt_vec(TIMER0_B1_VECTOR) void TIMER0_B1_ISR(void)
+{
+    const uint16_t entry = ISR_MON_NOW();
+    const uint16_t iv    = TB0IV;
+
+    /* Requested when the counter matched the compare, captured the edge or
+     * wrapped to 0. TB0IV is twice the channel number */
+    if (iv == TB0IV_NONE)
+    {
+        ISR_MON_enter_unknown_latency(ISR_MON_systick, entry);
+    }
+    else
+    {
+        ISR_MON_enter(ISR_MON_systick, entry,
+                      (iv == TB0IV_OVERFLOW) ? 0u : (&TB0CCR0)[iv >> 1]);
+    }
+    switch (iv)
+    {
+        case TB0IV_CCR3:
+        {
+            SYSTICK_ms_tick_handler();
+            __bic_SR_register_on_exit(LPM0_bits); /* wake sleepers */
+        }
+        break;
+        case TB0IV_OVERFLOW:
+        {
+            systick_overflows++;
+        }
+        break;
+        case TB0IV_NONE:
+        {
+        }
+        break;
+        default: /* capture channels, TB0IV is twice the channel number */
+        {
+            const uint8_t  ccr    = (uint8_t)(iv >> 1);
+            const uint16_t counts = (&TB0CCR0)[ccr]; /* CCRn are contiguous */
+            uint32_t       hi     = systick_overflows;
+
+            /* Overflow is the lowest priority flag, it is still pending if
+             * the counter wrapped between the edge and now */
+            if ((TB0CTL & TBIFG) && counts < 0x8000u)
+            {
+                hi++;
+            }
+            if (NULL != systick_capture)
+            {
+                systick_capture(ccr, (hi << 16) | counts);
+            }
+        }
+        break;
+    }
+    ISR_MON_exit(ISR_MON_systick, ISR_MON_NOW());
+}
@@ -25,6 +25,7 @@
 #include <msp430.h>
 
 #include "uart.h"
+#include "isr_monitor.h"
 
 static receive_func uart_rx_cb;
 
@@ -97,6 +98,7 @@ int uart_transmit(uint8_t *msg, uint_least16_t msglen)
 
 __interrupt_vec(USCI_A0_VECTOR) void USCI_A0_ISR(void)
 {
+    ISR_MON_enter_unknown_latency(ISR_MON_obc_uart, ISR_MON_NOW());
 
     /* See table 39-19 */
     switch (UCA0IV)
@@ -119,4 +121,6 @@ __interrupt_vec(USCI_A0_VECTOR) void USCI_A0_ISR(void)
         }
         break;
     }
+
+    ISR_MON_exit(ISR_MON_obc_uart, ISR_MON_NOW());
 }
\ No newline at end of file
@@ -0,0 +1,483 @@
+#!/usr/bin/python3
+################################################################################
+# @brief Cycles of the target build counted by the mspdebug simulator
+# @author: Carl Mattatall (cmattatall2@gmail.com)
+#
+# Runs the cross compiled executables built with -DISS_MARKERS=ON under
+# mspdebug's sim driver in embedded mode, one simulator per executable:
+#   adcs_iss_bench   the micro benchmarks, until ISS_bench_done
+#   adcs_executable  the firmware, fed with the OBC frames of the config
+#
+# The probes of those builds are calls to PROF_mark_begin / PROF_mark_end
+# with the id of the probe in R12. The script breaks on both and takes the
+# difference of the cycle counts of the simio tracer, less the cycles of an
+# empty pair (the PROF_MARK_OVERHEAD pair of PROF_init). The names of the ids
+# come from the enum of the config, in the order of the enum.
+#
+# The simulator has no peripherals, only memory. What would wait on one
+# forever is listed in the stubs of the config: the script returns from them
+# straight away, with the value of the config in R12. A run that does not
+# stop within the timeout is interrupted and the function it is stuck in is
+# reported, it is the one to add to the stubs.
+#
+# A received byte is the uart interrupt the hardware would raise: the byte
+# goes to UCA0RXBUF, the vector to UCA0IV, PC and SR are pushed and the run
+# goes through USCI_A0_ISR until its RETI is back at the idle breakpoint at
+# the top of the main loop. Once the whole frame is in, the cycles up to the
+# next idle stop are those of the frame.
+#
+# The report is JSON with sorted keys so it can be diffed between builds. The
+# script exits with 1 when a run does not complete.
+################################################################################
+import os
+import re
+import sys
+import json
+import time
+import queue
+import signal
+import argparse
+import threading
+import subprocess
+
+REGS_RE = re.compile(r"\(\s*(PC|SP|SR|R\d+):\s*([0-9a-fA-F]+)\)")
+MD_RE = re.compile(r"^\s*([0-9a-fA-F]+):((?:\s+[0-9a-fA-F]{2}(?=\s))+)")
+ENUM_RE = r"typedef\s+enum\s*\{([^}]*)\}\s*%s\s*;"
+
+# What mspdebug ends the output of every command with in embedded mode
+READY = "\\ready"
+
+SR_SCG0 = 0x0040
+
+# Seconds mspdebug gets to come back after it has been interrupted
+INTERRUPT_GRACE_S = 5
+
+
+class SimulatorError(Exception):
+    pass
+
+
+class SimulatorTimeout(SimulatorError):
+    pass
+
+
+def checkPythonVersion():
+    if sys.version_info.major < 3:
+        raise Exception(os.path.basename(__file__) + " must be executed using Python 3")
+
+
+def obc_crc(data):
+    # CRC-16/CCITT-FALSE, as OBC_Simulator/bus_pirate_improved.py
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if (crc & 0x8000) else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def obc_frame(payload):
+    # COBS encoding of the payload and its CRC (MSB first), then a 0x00
+    crc = obc_crc(payload)
+    data = bytes(payload) + bytes([crc >> 8, crc & 0xFF])
+    frame = bytearray()
+    block = bytearray()
+    for i, byte in enumerate(data):
+        if byte == 0:
+            frame += bytes([len(block) + 1]) + block
+            block = bytearray()
+            continue
+        block.append(byte)
+        if len(block) == 254 and i + 1 < len(data):
+            frame += bytes([255]) + block
+            block = bytearray()
+    frame += bytes([len(block) + 1]) + block
+    frame.append(0)
+    return bytes(frame)
+
+
+def run(command):
+    return subprocess.run(command, stdout=subprocess.PIPE, universal_newlines=True, check=True).stdout
+
+
+def elf_symbols(nm_tool, elf):
+    symbols = []
+    for line in run([nm_tool, "-n", elf]).splitlines():
+        fields = line.split()
+        if len(fields) == 3:
+            symbols.append((int(fields[0], 16), fields[1], fields[2]))
+    return symbols
+
+
+def function_at(symbols, addr):
+    best = None
+    for value, kind, name in symbols:
+        if kind in "Tt" and value <= addr and (best is None or value >= best[0]):
+            best = (value, name)
+    if best is None:
+        return "0x%05x" % (addr)
+    return "%s+0x%x" % (best[1], addr - best[0])
+
+
+def marker_names(path, enum, prefix):
+    with open(path) as f:
+        text = f.read()
+    text = re.sub(r"/\*.*?\*/", "", text, flags=re.DOTALL)
+    text = re.sub(r"//[^\n]*", "", text)
+    m = re.search(ENUM_RE % (re.escape(enum)), text)
+    if m is None:
+        return None
+    names = {}
+    value = 0
+    for item in m.group(1).split(","):
+        name, _, expr = item.partition("=")
+        name = name.strip()
+        if not name:
+            continue
+        if expr.strip():
+            value = int(expr.strip(), 0)
+        names[value] = name[len(prefix):] if name.startswith(prefix) else name
+        value += 1
+    return names
+
+
+def address(value):
+    return value if isinstance(value, int) else int(value, 0)
+
+
+class Simulator:
+    def __init__(self, command, timeout):
+        self.timeout = timeout
+        self.lines = queue.Queue()
+        self.proc = subprocess.Popen(command, stdin=subprocess.PIPE, stdout=subprocess.PIPE,
+                                     stderr=subprocess.STDOUT, universal_newlines=True, bufsize=1)
+        reader = threading.Thread(target=self.reader)
+        reader.daemon = True
+        reader.start()
+        self.wait()
+
+    def reader(self):
+        for line in self.proc.stdout:
+            self.lines.put(line.rstrip("\r\n"))
+        self.lines.put(None)
+
+    def wait(self):
+        # Output up to the next ready, interrupted after the timeout
+        out = []
+        deadline = time.monotonic() + self.timeout
+        interrupted = False
+        while True:
+            try:
+                line = self.lines.get(timeout=max(deadline - time.monotonic(), 0.01))
+            except queue.Empty:
+                if interrupted:
+                    raise SimulatorError("mspdebug does not answer")
+                self.proc.send_signal(signal.SIGINT)
+                interrupted = True
+                deadline = time.monotonic() + INTERRUPT_GRACE_S
+                continue
+            if line is None:
+                raise SimulatorError("mspdebug exited:\n" + "\n".join(out))
+            if line == READY:
+                break
+            if line.startswith("\\"):
+                continue  # busy and the other shell messages
+            out.append(line[1:] if line.startswith(":") else line)
+        if interrupted:
+            raise SimulatorTimeout("\n".join(out))
+        return out
+
+    def command(self, cmd):
+        self.proc.stdin.write(cmd + "\n")
+        self.proc.stdin.flush()
+        return self.wait()
+
+    def close(self):
+        try:
+            self.proc.stdin.close()
+            self.proc.wait(timeout=INTERRUPT_GRACE_S)
+        except (OSError, subprocess.TimeoutExpired):
+            self.proc.kill()
+
+    def regs(self):
+        regs = {}
+        for line in self.command("regs"):
+            for name, value in REGS_RE.findall(line):
+                regs[name] = int(value, 16)
+        if "PC" not in regs or "SP" not in regs:
+            raise SimulatorError("no registers in the output of regs")
+        return regs
+
+    def set(self, reg, value):
+        self.command("set %s 0x%x" % (reg, value))
+
+    def write(self, addr, data):
+        self.command("mw 0x%x %s" % (addr, " ".join("0x%02x" % (b) for b in data)))
+
+    def read(self, addr, length):
+        data = []
+        for line in self.command("md 0x%x %d" % (addr, length)):
+            m = MD_RE.match(line)
+            if m:
+                data += [int(b, 16) for b in m.group(2).split()]
+        if len(data) < length:
+            raise SimulatorError("cannot read %d bytes at 0x%x" % (length, addr))
+        return data[:length]
+
+
+class Bench:
+    def __init__(self, sim, symbols, spec, config, names):
+        self.sim = sim
+        self.symbols = symbols
+        self.config = config
+        self.names = names
+        self.id_reg = config.get("id_register", "R12")
+        self.ret_reg = config.get("return_register", "R12")
+        self.call_bytes = config.get("call_bytes", 2)
+        self.max_stops = config.get("max_stops", 1000000)
+        self.cycles_re = re.compile(config.get("cycles_regex", r"(?i)cycles?\D*?(\d+)"))
+        self.tracer = config.get("tracer", "iss_tr")
+        self.by_name = dict((name, value) for value, kind, name in symbols)
+        self.breaks = {}
+        self.stubs = {}
+        self.open = {}
+        self.samples = {}
+        self.stops = 0
+        self.warnings = []
+
+        self.breakpoint(config.get("mark_begin", "PROF_mark_begin"), "begin")
+        self.breakpoint(config.get("mark_end", "PROF_mark_end"), "end")
+        for name, value in sorted(spec.get("stubs", {}).items()):
+            if name in self.by_name:
+                self.breakpoint(name, "stub")
+                self.stubs[self.by_name[name]] = value
+            else:
+                self.warnings.append("stub %s is not in the executable" % (name))
+        if "stop" in spec:
+            self.breakpoint(spec["stop"], "stop")
+        if "uart" in spec:
+            self.breakpoint(spec["uart"]["idle"], "idle")
+
+    def symbol(self, name):
+        if name in self.by_name:
+            return self.by_name[name]
+        registers = self.config.get("registers", {})
+        if name in registers:
+            return address(registers[name])
+        raise SimulatorError("%s is neither a symbol nor in the registers of the config" % (name))
+
+    def breakpoint(self, name, kind):
+        addr = self.symbol(name)
+        self.breaks[addr] = kind
+        self.sim.command("setbreak 0x%x" % (addr))
+
+    def cycles(self):
+        out = "\n".join(self.sim.command("simio info " + self.tracer))
+        m = self.cycles_re.search(out)
+        if m is None:
+            raise SimulatorError("no cycle count in the output of the tracer:\n" + out)
+        return int(m.group(1))
+
+    def advance(self):
+        # Runs to the next idle or stop breakpoint, the marks and stubs on the
+        # way are dealt with here
+        while True:
+            if self.stops >= self.max_stops:
+                raise SimulatorError("over %d stops" % (self.max_stops))
+            regs = self.sim.regs()
+            if regs["PC"] in self.breaks:
+                self.sim.command("step")
+            try:
+                self.sim.command("run")
+            except SimulatorTimeout:
+                pc = self.sim.regs()["PC"]
+                raise SimulatorError("no stop in %ds, stuck in %s, add it to the stubs"
+                                     % (self.sim.timeout, function_at(self.symbols, pc)))
+            self.stops += 1
+            regs = self.sim.regs()
+            pc = regs["PC"]
+            kind = self.breaks.get(pc)
+            if kind is None:
+                raise SimulatorError("stopped in %s, not at a breakpoint" % (function_at(self.symbols, pc)))
+            if kind == "begin":
+                self.open.setdefault(regs[self.id_reg], []).append(self.cycles())
+            elif kind == "end":
+                self.close_mark(regs[self.id_reg])
+            elif kind == "stub":
+                self.ret(regs, self.stubs[pc])
+            else:
+                return kind
+
+    def close_mark(self, mark):
+        begins = self.open.get(mark)
+        if not begins:
+            self.warnings.append("end of %s without a begin" % (self.names.get(mark, mark)))
+            return
+        self.samples.setdefault(mark, []).append(self.cycles() - begins.pop())
+
+    def ret(self, regs, value):
+        sp = regs["SP"]
+        data = self.sim.read(sp, self.call_bytes)
+        pc = data[0] | (data[1] << 8)
+        if self.call_bytes == 4:
+            pc |= (data[2] & 0x0F) << 16
+        self.sim.set("PC", pc)
+        self.sim.set("SP", sp + self.call_bytes)
+        if value is not None:
+            self.sim.set(self.ret_reg, value & 0xFFFF)
+
+    def interrupt(self, uart, byte):
+        # Interrupt entry of the CPUX: PC, then SR with PC[19:16] on top
+        self.sim.write(self.symbol(uart.get("rxbuf", "UCA0RXBUF")), [byte])
+        iv = uart.get("rx_iv", 2)
+        self.sim.write(self.symbol(uart.get("iv", "UCA0IV")), [iv & 0xFF, iv >> 8])
+        regs = self.sim.regs()
+        pc, sp, sr = regs["PC"], regs["SP"], regs.get("SR", 0)
+        sp -= 2
+        self.sim.write(sp, [pc & 0xFF, (pc >> 8) & 0xFF])
+        sp -= 2
+        sr_word = ((pc >> 4) & 0xF000) | (sr & 0x0FFF)
+        self.sim.write(sp, [sr_word & 0xFF, sr_word >> 8])
+        self.sim.set("SP", sp)
+        self.sim.set("SR", sr & SR_SCG0)
+        self.sim.set("PC", self.symbol(uart.get("isr", "USCI_A0_ISR")))
+
+    def feed(self, uart, payload):
+        for byte in obc_frame(payload):
+            self.interrupt(uart, byte)
+            if self.advance() != "idle":
+                raise SimulatorError("the uart interrupt did not return to the main loop")
+        start = self.cycles()
+        kind = self.advance()
+        return kind, self.cycles() - start
+
+
+def statistics(samples, overhead, mclk_hz):
+    cycles = [max(s - overhead, 0) for s in samples]
+    mean = float(sum(cycles)) / len(cycles)
+    return {
+        "n": len(cycles),
+        "min": min(cycles),
+        "max": max(cycles),
+        "mean": round(mean, 1),
+        "mean_us": round(mean * 1.0e6 / mclk_hz, 2),
+    }
+
+
+def bench_elf(name, elf, spec, config, args):
+    names = {}
+    markers = spec.get("markers")
+    if markers is not None:
+        path = os.path.join(args.source_dir, markers["file"])
+        names = marker_names(path, markers["enum"], markers.get("prefix", ""))
+        if names is None:
+            raise SimulatorError("no enum %s in %s" % (markers["enum"], path))
+
+    command = [args.mspdebug] + config.get("mspdebug_args", ["--embedded", "sim"])
+    sim = Simulator(command, config.get("timeout_s", 60))
+    try:
+        sim.command("prog " + elf)
+        sim.command("simio add tracer " + config.get("tracer", "iss_tr"))
+        bench = Bench(sim, elf_symbols(args.nm, elf), spec, config, names)
+        for register, data in sorted(spec.get("memory", {}).items()):
+            sim.write(bench.symbol(register), data)
+
+        frames = {}
+        fed = 0
+        kind = bench.advance()
+        uart = spec.get("uart")
+        if uart is not None:
+            payloads = [p.encode("ascii") for p in uart.get("frames", [])] * uart.get("repeat", 1)
+            for payload in payloads:
+                if kind != "idle":
+                    break
+                kind, cycles = bench.feed(uart, payload)
+                frames.setdefault(payload.decode("ascii"), []).append(cycles)
+                fed += 1
+        total = bench.cycles()
+    finally:
+        sim.close()
+
+    if uart is not None and fed < len(payloads):
+        bench.warnings.append("stopped after %d of the %d frames" % (fed, len(payloads)))
+    overhead_id = config.get("overhead_id", 0xFFFF)
+    overhead = min(bench.samples.pop(overhead_id, [0]))
+    mclk_hz = config.get("mclk_hz", 1000000)
+    report = {
+        "elf": os.path.basename(elf),
+        "cycles": total,
+        "stops": bench.stops,
+        "overhead": overhead,
+        "markers": dict((names.get(mark, str(mark)), statistics(samples, overhead, mclk_hz))
+                        for mark, samples in bench.samples.items()),
+        "unclosed": sorted(names.get(mark, str(mark)) for mark, begins in bench.open.items()
+                           if begins and mark != overhead_id),
+        "warnings": bench.warnings,
+    }
+    if uart is not None:
+        report["frames"] = dict((payload, statistics(cycles, 0, mclk_hz))
+                                for payload, cycles in frames.items())
+    return report
+
+
+def main():
+    checkPythonVersion()
+
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--elf", action="append", dest="elfs", required=True, help="name=path of an executable, the name picks its run in the config.")
+    parser.add_argument("--config", action="store", dest="config", required=True, help="Simulator, stubs, memory presets and the frames to feed.")
+    parser.add_argument("--output", action="store", dest="output", required=True, help="Where to write the JSON report.")
+    parser.add_argument("--nm", action="store", dest="nm", default="msp430-elf-nm", help="nm utility of the toolchain.")
+    parser.add_argument("--mspdebug", action="store", dest="mspdebug", default="mspdebug", help="mspdebug executable.")
+    parser.add_argument("--source-dir", action="store", dest="source_dir", default=os.path.dirname(os.path.abspath(__file__)), help="Root of the sources the marker enums are read from.")
+    args = parser.parse_args()
+
+    with open(args.config) as f:
+        config = json.load(f)
+
+    runs = {}
+    errors = []
+    for item in args.elfs:
+        name, _, elf = item.partition("=")
+        spec = config.get("runs", {}).get(name)
+        if spec is None:
+            errors.append("no run %s in %s" % (name, args.config))
+            continue
+        try:
+            runs[name] = bench_elf(name, elf, spec, config, args)
+        except (SimulatorError, OSError, subprocess.CalledProcessError) as e:
+            errors.append("%s: %s" % (name, e))
+
+    report = {
+        "mclk_hz": config.get("mclk_hz", 1000000),
+        "runs": runs,
+        "pass": not errors,
+        "errors": errors,
+    }
+    with open(args.output, "w") as f:
+        json.dump(report, f, indent=2, sort_keys=True)
+        f.write("\n")
+
+    for name, result in sorted(runs.items()):
+        print("%s: %d cycles, %d stops, %d cycles of mark overhead taken off"
+              % (name, result["cycles"], result["stops"], result["overhead"]))
+        print("    %-28s %5s %9s %9s %11s %11s" % ("marker", "n", "min", "max", "mean", "mean us"))
+        for marker, s in sorted(result["markers"].items()):
+            print("    %-28s %5d %9d %9d %11.1f %11.2f"
+                  % (marker, s["n"], s["min"], s["max"], s["mean"], s["mean_us"]))
+        for payload, s in sorted(result.get("frames", {}).items()):
+            print("    %-28s %5d %9d %9d %11.1f %11.2f"
+                  % (payload, s["n"], s["min"], s["max"], s["mean"], s["mean_us"]))
+        for marker in result["unclosed"]:
+            print("warning: %s: %s begins without an end" % (name, marker))
+        for warning in result["warnings"]:
+            print("warning: %s: %s" % (name, warning))
+    for error in errors:
+        print("error: " + error)
+    print("report written to %s" % (args.output))
+    exit(1 if errors else 0)
+
+
+if __name__ == "__main__":
+    main()
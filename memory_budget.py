@@ -0,0 +1,417 @@
+#!/usr/bin/python3
+################################################################################
+# @brief Worst case stack depth and RAM headroom of the ADCS firmware
+# @author: Carl Mattatall (cmattatall2@gmail.com)
+#
+# Reads what gcc leaves next to the objects when the build is configured with
+# -DMEMORY_BUDGET=ON:
+#   *.su             frame size of each function (-fstack-usage)
+#   *r.expand        the calls each function makes (-fdump-rtl-expand)
+#   *i.cgraph        the functions whose address is taken (-fdump-ipa-cgraph)
+# and, for the linked executable, the section sizes (size -A) and the largest
+# RAM symbols (nm -S).
+#
+# The worst stack of a task is its frame plus the deepest chain of calls
+# below it, each call also pushing its return address. The main loop is the
+# only task, every ISR can come on top of it (on top of each other when
+# nesting is allowed in the config). An indirect call reaches whatever the
+# config lists for its caller, otherwise any function whose address is taken.
+# Library functions have no .su, their stack comes from estimates in the
+# config.
+#
+# The report is JSON with sorted keys so it can be diffed between builds. The
+# script exits with 1 when the RAM or stack headroom is under the minimum of
+# the config.
+################################################################################
+import os
+import re
+import sys
+import json
+import fnmatch
+import argparse
+import subprocess
+
+SU_SUFFIX = ".su"
+EXPAND_RE = re.compile(r"\.\d+r\.expand$")
+CGRAPH_RE = re.compile(r"\.\d+i\.cgraph$")
+
+FUNCTION_RE = re.compile(r"^;; Function \S+ \((\S+?),")
+DIRECT_CALL_RE = re.compile(r"\(call \(mem:\w+ \(symbol_ref:\w+ \(\"([^\"]+)\"\)")
+INDIRECT_CALL_RE = re.compile(r"\(call \(mem:\w+ \((?!symbol_ref)")
+FUNCTION_REF_RE = re.compile(r"\(symbol_ref:\w+ \(\"([^\"]+)\"\)[^<]*<function_decl")
+CGRAPH_NODE_RE = re.compile(r"^\S+/\d+ \((\S+)\)")
+RAM_REGION_RE = re.compile(
+    r"^\s*RAM\s*(?:\([^)]*\))?\s*:\s*ORIGIN\s*=\s*(0x[0-9a-fA-F]+)\s*,"
+    r"\s*LENGTH\s*=\s*(0x[0-9a-fA-F]+)", re.MULTILINE)
+
+# msp430f5529 RAM when the linker script can't be read
+RAM_ORIGIN_DEFAULT = 0x2400
+RAM_LENGTH_DEFAULT = 0x2000
+
+
+class Function:
+    def __init__(self, unit, name, frame, qualifier, location):
+        self.unit = unit
+        self.name = name
+        self.frame = frame
+        self.qualifier = qualifier
+        self.location = location
+        self.calls = []
+        self.indirect = 0
+
+
+def checkPythonVersion():
+    if sys.version_info.major < 3:
+        raise Exception(os.path.basename(__file__) + " must be executed using Python 3")
+
+
+def find_dumps(build_dir, exclude):
+    su, expand, cgraph = [], [], []
+    for root, dirs, files in os.walk(build_dir):
+        for f in files:
+            path = os.path.join(root, f)
+            if matches(path, exclude):
+                continue
+            if f.endswith(SU_SUFFIX):
+                su.append(path)
+            elif EXPAND_RE.search(f):
+                expand.append(path)
+            elif CGRAPH_RE.search(f):
+                cgraph.append(path)
+    return sorted(su), sorted(expand), sorted(cgraph)
+
+
+def unit_of(dump, units):
+    # The dumps of an object start with the name of its .su file, less the
+    # suffix. gcc versions differ in what they append after it.
+    best = None
+    for unit in units:
+        if dump.startswith(unit) and (best is None or len(unit) > len(best)):
+            best = unit
+    return best
+
+
+def parse_su(path, functions):
+    unit = path[:-len(SU_SUFFIX)]
+    with open(path) as f:
+        for line in f:
+            fields = line.rstrip("\n").split("\t")
+            if len(fields) != 3:
+                continue
+            location, name = fields[0].rsplit(":", 1)
+            functions[(unit, name)] = Function(unit, name, int(fields[1]), fields[2], location)
+    return unit
+
+
+def parse_expand(path, unit, functions, address_taken):
+    current = None
+    with open(path) as f:
+        for line in f:
+            m = FUNCTION_RE.match(line)
+            if m:
+                current = functions.get((unit, m.group(1)))
+                continue
+            if current is None:
+                continue
+            m = DIRECT_CALL_RE.search(line)
+            if m:
+                current.calls.append(m.group(1))
+            elif INDIRECT_CALL_RE.search(line):
+                current.indirect += 1
+            else:
+                for ref in FUNCTION_REF_RE.findall(line):
+                    address_taken.add(ref)
+
+
+def parse_cgraph(path, address_taken):
+    node = None
+    with open(path) as f:
+        for line in f:
+            m = CGRAPH_NODE_RE.match(line)
+            if m:
+                node = m.group(1)
+            elif node is not None and line.strip() == "Address is taken.":
+                address_taken.add(node)
+
+
+def matches(name, patterns):
+    return any(fnmatch.fnmatchcase(name, p) for p in patterns)
+
+
+def external_bytes(name, config):
+    for pattern, size in sorted(config.get("external", {}).items(), key=lambda i: -len(i[0])):
+        if fnmatch.fnmatchcase(name, pattern):
+            return size
+    return config.get("external_default", 0)
+
+
+class CallGraph:
+    def __init__(self, functions, address_taken, config):
+        self.functions = functions
+        self.config = config
+        self.call_bytes = config.get("call_bytes", 2)
+        self.by_name = {}
+        for fn in functions.values():
+            self.by_name.setdefault(fn.name, []).append(fn)
+        self.address_taken = sorted(n for n in address_taken if n in self.by_name)
+        self.worst = {}
+        self.next = {}
+        self.active = set()
+        self.recursive = set()
+        self.externals = {}
+        self.indirect = {}
+
+    def resolve(self, caller, name):
+        local = self.functions.get((caller.unit, name))
+        if local is not None:
+            return [local]
+        return self.by_name.get(name, [])
+
+    def indirect_targets(self, caller):
+        # The caller by name, else the longest pattern that matches it
+        indirect = self.config.get("indirect", {})
+        patterns = indirect.get(caller.name)
+        if patterns is None:
+            keys = sorted((k for k in indirect if fnmatch.fnmatchcase(caller.name, k)), key=len)
+            if keys:
+                patterns = indirect[keys[-1]]
+        if patterns is None:
+            names = self.address_taken
+        else:
+            names = sorted(n for n in self.by_name if matches(n, patterns))
+        self.indirect[caller.name] = {"assumed": patterns is None, "sites": caller.indirect,
+                                      "targets": names}
+        return names
+
+    def depth(self, fn):
+        key = (fn.unit, fn.name)
+        if key in self.worst:
+            return self.worst[key]
+        if key in self.active:
+            return None  # back edge, reported as recursion
+
+        self.active.add(key)
+        callees = list(fn.calls)
+        if fn.indirect:
+            callees += self.indirect_targets(fn)
+
+        deepest, via = 0, None
+        for name in sorted(set(callees)):
+            targets = self.resolve(fn, name)
+            if not targets:
+                below = external_bytes(name, self.config)
+                self.externals[name] = below
+                if self.call_bytes + below > deepest:
+                    deepest, via = self.call_bytes + below, name
+                continue
+            for target in targets:
+                below = self.depth(target)
+                if below is None:
+                    self.recursive.add("%s -> %s" % (fn.name, target.name))
+                    continue
+                if self.call_bytes + below > deepest:
+                    deepest, via = self.call_bytes + below, target
+        self.active.discard(key)
+
+        self.worst[key] = fn.frame + deepest
+        self.next[key] = via
+        return self.worst[key]
+
+    def path(self, fn):
+        chain = [fn.name]
+        via = self.next.get((fn.unit, fn.name))
+        while via is not None:
+            if isinstance(via, str):
+                chain.append(via)
+                break
+            chain.append(via.name)
+            via = self.next.get((via.unit, via.name))
+        return chain
+
+    def reached(self, roots):
+        seen = set()
+        stack = list(roots)
+        while stack:
+            fn = stack.pop()
+            key = (fn.unit, fn.name)
+            if key in seen:
+                continue
+            seen.add(key)
+            names = list(fn.calls)
+            if fn.indirect:
+                names += self.indirect_targets(fn)
+            for name in names:
+                stack.extend(self.resolve(fn, name))
+        return seen
+
+
+def run(command):
+    return subprocess.run(command, stdout=subprocess.PIPE, universal_newlines=True, check=True).stdout
+
+
+def ram_region(ldscript):
+    if ldscript and os.path.exists(ldscript):
+        with open(ldscript) as f:
+            m = RAM_REGION_RE.search(f.read())
+        if m:
+            return int(m.group(1), 16), int(m.group(2), 16)
+    return RAM_ORIGIN_DEFAULT, RAM_LENGTH_DEFAULT
+
+
+def ram_sections(size_tool, elf, origin, length):
+    sections = {}
+    for line in run([size_tool, "-A", "-d", elf]).splitlines():
+        fields = line.split()
+        if len(fields) != 3 or not fields[1].isdigit() or not fields[2].isdigit():
+            continue
+        name, size, addr = fields[0], int(fields[1]), int(fields[2])
+        if size and origin <= addr < origin + length and not name.startswith(".stack"):
+            sections[name] = size
+    return sections
+
+
+def elf_symbols(nm_tool, elf):
+    symbols = []
+    for line in run([nm_tool, "-S", "--size-sort", "-t", "d", elf]).splitlines():
+        fields = line.split()
+        if len(fields) == 4:
+            symbols.append((int(fields[0]), int(fields[1]), fields[2], fields[3]))
+    return symbols
+
+
+def main():
+    checkPythonVersion()
+
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--build-dir", action="store", dest="bdir", required=True, help="Build tree holding the .su and dump files.")
+    parser.add_argument("--elf", action="store", dest="elf", required=True, help="The linked executable.")
+    parser.add_argument("--config", action="store", dest="config", required=True, help="Indirect calls, ISRs, library stack and the minimum headroom.")
+    parser.add_argument("--output", action="store", dest="output", required=True, help="Where to write the JSON report.")
+    parser.add_argument("--size", action="store", dest="size", default=None, help="size utility of the toolchain, leave out for a stack only report.")
+    parser.add_argument("--nm", action="store", dest="nm", default=None, help="nm utility of the toolchain.")
+    parser.add_argument("--ldscript", action="store", dest="ldscript", default=None, help="Linker script with the RAM region.")
+    args = parser.parse_args()
+
+    with open(args.config) as f:
+        config = json.load(f)
+
+    # Tests and the other executables of the tree have their own main
+    su, expand, cgraph = find_dumps(args.bdir, config.get("exclude", []))
+    if not su or not expand:
+        print("No stack usage or rtl dumps under %s, configure with -DMEMORY_BUDGET=ON" % (args.bdir))
+        exit(1)
+
+    functions = {}
+    address_taken = set()
+    units = [parse_su(path, functions) for path in su]
+    for path in expand:
+        unit = unit_of(path, units)
+        if unit is not None:
+            parse_expand(path, unit, functions, address_taken)
+    for path in cgraph:
+        parse_cgraph(path, address_taken)
+
+    graph = CallGraph(functions, address_taken, config)
+    linked = None
+    top = config.get("top", 10)
+    if args.nm:
+        symbols = elf_symbols(args.nm, args.elf)
+        linked = set(s[3] for s in symbols if s[2] in "Tt")
+
+    # Tasks and ISRs
+    isr_patterns = config.get("isr", ["*_ISR"])
+    roots = [fn for fn in functions.values() if fn.name == "main"]
+    isrs = [fn for fn in functions.values() if matches(fn.name, isr_patterns) and (linked is None or fn.name in linked)]
+    report_tasks = {}
+    for fn in sorted(roots, key=lambda f: f.name):
+        report_tasks[fn.name] = {"worst": graph.depth(fn), "path": graph.path(fn)}
+    report_isrs = {}
+    isr_entry = config.get("isr_entry_bytes", 4)
+    for fn in sorted(isrs, key=lambda f: f.name):
+        report_isrs[fn.name] = {"worst": isr_entry + graph.depth(fn), "path": graph.path(fn)}
+
+    task_worst = max([t["worst"] for t in report_tasks.values()] + [0])
+    isr_worsts = [i["worst"] for i in report_isrs.values()]
+    if config.get("isr_nesting", False):
+        isr_worst = sum(isr_worsts)
+    else:
+        isr_worst = max(isr_worsts + [0])
+
+    stack = {
+        "call_bytes": graph.call_bytes,
+        "isr_entry_bytes": isr_entry,
+        "isr_nesting": config.get("isr_nesting", False),
+        "tasks": report_tasks,
+        "isr": report_isrs,
+        "worst": task_worst + isr_worst,
+        "frames": [{"name": fn.name, "frame": fn.frame, "at": fn.location}
+                   for fn in sorted(functions.values(), key=lambda f: (-f.frame, f.name))[:top]],
+        "unbounded": sorted(fn.name for fn in functions.values() if fn.qualifier.startswith("dynamic") and "bounded" not in fn.qualifier),
+        "recursive": sorted(graph.recursive),
+        "indirect": graph.indirect,
+        "external": graph.externals,
+    }
+    if linked is not None:
+        reached = graph.reached(roots + isrs)
+        stack["unreached"] = sorted(fn.name for key, fn in functions.items()
+                                    if fn.name in linked and key not in reached)
+
+    errors = []
+    if not roots:
+        errors.append("no main in the stack usage of %s" % (args.bdir))
+    report = {"elf": os.path.basename(args.elf), "stack": stack}
+    if args.size:
+        origin, length = ram_region(args.ldscript)
+        sections = ram_sections(args.size, args.elf, origin, length)
+        static = sum(sections.values())
+        ram = {
+            "origin": origin,
+            "length": length,
+            "sections": sections,
+            "static": static,
+            "headroom": length - static,
+            "headroom_min": config.get("ram_headroom_min", 0),
+        }
+        if args.nm:
+            in_ram = [s for s in symbols if origin <= s[0] < origin + length]
+            ram["symbols"] = [{"name": s[3], "size": s[1]}
+                              for s in sorted(in_ram, key=lambda s: (-s[1], s[3]))[:top]]
+        report["ram"] = ram
+        stack["headroom"] = ram["headroom"] - stack["worst"]
+        stack["headroom_min"] = config.get("stack_headroom_min", 0)
+
+        if ram["headroom"] < ram["headroom_min"]:
+            errors.append("RAM headroom %d B is under %d B" % (ram["headroom"], ram["headroom_min"]))
+        if stack["headroom"] < stack["headroom_min"]:
+            errors.append("stack headroom %d B is under %d B" % (stack["headroom"], stack["headroom_min"]))
+    report["pass"] = not errors
+    report["errors"] = errors
+
+    with open(args.output, "w") as f:
+        json.dump(report, f, indent=2, sort_keys=True)
+        f.write("\n")
+
+    for name, task in sorted(report_tasks.items()):
+        print("task %-24s %5d B  %s" % (name, task["worst"], " > ".join(task["path"])))
+    for name, isr in sorted(report_isrs.items()):
+        print("isr  %-24s %5d B  %s" % (name, isr["worst"], " > ".join(isr["path"])))
+    print("worst case stack %d B" % (stack["worst"]))
+    if "ram" in report:
+        print("RAM %d B: %d B static, %d B headroom, %d B left under the worst case stack"
+              % (length, static, report["ram"]["headroom"], stack["headroom"]))
+    for name in stack["unbounded"]:
+        print("warning: %s has a dynamic stack frame" % (name))
+    for edge in stack["recursive"]:
+        print("warning: recursion %s is counted once" % (edge))
+    for name, site in sorted(graph.indirect.items()):
+        if site["assumed"]:
+            print("warning: indirect call in %s assumed to reach any of %d address taken functions"
+                  % (name, len(site["targets"])))
+    for error in errors:
+        print("error: " + error)
+    print("report written to %s" % (args.output))
+    exit(1 if errors else 0)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,44 @@
+/**
+ * @file attitude_types.h
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Vector and quaternion types shared between the sensor, actuator and
+ * attitude control modules
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ * @note Quaternions are scalar-first (w, x, y, z). A quaternion describing
+ * the attitude of the spacecraft rotates vectors from the BODY frame into the
+ * REFERENCE frame.
+ */
+#ifndef __ATTITUDE_TYPES_H__
+#define __ATTITUDE_TYPES_H__
+#ifdef __cplusplus
+/* clang-format off */
+extern "C"
+{
+/* clang-format on */
+#endif /* Start C linkage */
+
+typedef struct
+{
+    float x;
+    float y;
+    float z;
+} vec3_t;
+
+typedef struct
+{
+    float w;
+    float x;
+    float y;
+    float z;
+} quat_t;
+
+#ifdef __cplusplus
+/* clang-format off */
+}
+/* clang-format on */
+#endif /* End C linkage */
+#endif /* __ATTITUDE_TYPES_H__ */
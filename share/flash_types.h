@@ -0,0 +1,50 @@
+/**
+ * @file flash_types.h
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief Information memory layout shared between the target flash driver
+ * and the native flash emulator
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ * @note The MSP430F5529 has four 128 byte information memory segments
+ * (slas590n section 6.11). Erasing a segment sets every byte to 0xFF and
+ * programming can only clear bits, so a byte can only be rewritten after
+ * the whole segment has been erased.
+ *
+ * Main flash is erased in 512 byte segments. FLASH_LOG_SEGMENT_CNT of them
+ * are reserved for the telemetry log.
+ */
+#ifndef __FLASH_TYPES_H__
+#define __FLASH_TYPES_H__
+#ifdef __cplusplus
+/* clang-format off */
+extern "C"
+{
+/* clang-format on */
+#endif /* Start C linkage */
+
+#include <stdint.h>
+
+#define FLASH_INFO_SEGMENT_SIZE (128u)
+#define FLASH_ERASED_BYTE (0xFFu)
+
+typedef enum
+{
+    FLASH_INFO_D = 0, /* 0x1800 */
+    FLASH_INFO_C,     /* 0x1880 */
+    FLASH_INFO_B,     /* 0x1900 */
+    FLASH_INFO_A,     /* 0x1980, protected by LOCKA. Not used */
+    FLASH_INFO_CNT,
+} FLASH_INFO_t;
+
+#define FLASH_LOG_SEGMENT_SIZE (512u)
+#define FLASH_LOG_SEGMENT_CNT (16u)
+
+#ifdef __cplusplus
+/* clang-format off */
+}
+/* clang-format on */
+#endif /* End C linkage */
+#endif /* __FLASH_TYPES_H__ */
@@ -0,0 +1,65 @@
+/**
+ * @file i2c_types.h
+ * @author Carl Mattatall (cmattatall2@gmail.com)
+ * @brief I2C transaction types shared between the target I2C drivers and the
+ * native I2C bus emulator
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026 DSS - LORIS project
+ *
+ */
+#ifndef __I2C_TYPES_H__
+#define __I2C_TYPES_H__
+#ifdef __cplusplus
+/* clang-format off */
+extern "C"
+{
+/* clang-format on */
+#endif /* Start C linkage */
+
+#include <stdint.h>
+
+/* Default time allowed for a complete transaction before it is aborted */
+#define I2C_TIMEOUT_US_DEFAULT (10000u)
+
+typedef enum
+{
+    I2C_STATUS_ok = 0,
+    I2C_STATUS_busy,             /* transaction in progress or bus in use */
+    I2C_STATUS_nack,             /* address or data byte not acknowledged */
+    I2C_STATUS_arbitration_lost, /* another master won the bus */
+    I2C_STATUS_timeout,          /* transaction aborted after timeout_us */
+    I2C_STATUS_invalid,          /* malformed transaction */
+} I2C_STATUS_t;
+
+typedef void (*I2C_callback_func)(I2C_STATUS_t status, void *ctx);
+
+/**
+ * @brief A single I2C master transaction.
+ *
+ * The tx bytes are written first. If rxlen is non zero, rxlen bytes are then
+ * read back after a repeated start (write-then-read). Either phase may be
+ * empty but not both.
+ *
+ * @note The transaction and its buffers must remain valid until it
+ * completes.
+ */
+typedef struct
+{
+    uint8_t           dev_addr; /* 7 bit slave address */
+    const uint8_t *   tx;
+    uint16_t          txlen;
+    uint8_t *         rx;
+    uint16_t          rxlen;
+    uint32_t          timeout_us;
+    I2C_callback_func callback; /* optional, called once on completion */
+    void *            ctx;      /* passed back to callback */
+} I2C_transaction_t;
+
+#ifdef __cplusplus
+/* clang-format off */
+}
+/* clang-format on */
+#endif /* End C linkage */
+#endif /* __I2C_TYPES_H__ */